@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * @file    audio_adapter.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_adapter.c file (block-size adapter).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_ADAPTER_H
+#define __AUDIO_ADAPTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  How the consumer is scheduled
+  */
+typedef enum
+{
+  ADAPTER_MODE_POLL    = 0U,  /*!< Consumer takes a block whenever one is ready,
+                                   e.g. an FFT frame gathered in the audio
+                                   callback. No prefill.                       */
+  ADAPTER_MODE_CLOCKED        /*!< Consumer takes a block every OutSize sample
+                                   periods at any phase to the producer, e.g.
+                                   USB packets into the I2S DMA. Prefilled so it
+                                   never starves.                              */
+} ADAPTER_ModeTypeDef;
+
+/**
+  * @brief  Block-size adapter handle structure
+  * @note   Single producer, single consumer: the producer only writes the
+  *         Write fields, the consumer only the Read fields, so each side may
+  *         run in its own interrupt. The buffer size is a multiple of both
+  *         block sizes and the start positions are aligned, so every span is
+  *         contiguous and both sides work in place, without copies.
+  */
+typedef struct
+{
+  float   *pBuffer;
+  uint32_t Size;              /*!< Buffer size in frames                        */
+  uint32_t Channels;          /*!< Interleaved samples per frame                */
+  uint32_t InSize;            /*!< Producer block, frames                       */
+  uint32_t OutSize;           /*!< Consumer block, frames                       */
+  uint32_t Latency;           /*!< Worst-case delay added, frames               */
+  uint32_t WritePos;          /*!< Producer side                                */
+  volatile uint32_t Written;
+  uint32_t ReadPos;           /*!< Consumer side                                */
+  volatile uint32_t Consumed;
+} ADAPTER_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint32_t ADAPTER_GetBufferSize(ADAPTER_ModeTypeDef Mode, uint32_t InSize, uint32_t OutSize);
+AUDIO_StatusTypeDef ADAPTER_Init(ADAPTER_HandleTypeDef *hadapter, float *pBuffer, uint32_t Size,
+                                 uint32_t Channels, uint32_t InSize, uint32_t OutSize,
+                                 ADAPTER_ModeTypeDef Mode);
+float       *ADAPTER_GetWriteSpan(ADAPTER_HandleTypeDef *hadapter);
+void         ADAPTER_CommitWrite(ADAPTER_HandleTypeDef *hadapter);
+const float *ADAPTER_GetReadSpan(ADAPTER_HandleTypeDef *hadapter);
+void         ADAPTER_CommitRead(ADAPTER_HandleTypeDef *hadapter);
+uint32_t     ADAPTER_GetLatency(const ADAPTER_HandleTypeDef *hadapter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_ADAPTER_H */
@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    audio_adpcm.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_adpcm.c file (IMA ADPCM block codec).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_ADPCM_H
+#define __AUDIO_ADPCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+/** @brief Size of the header opening each block: predictor (2), step index (1), reserved (1) */
+#define ADPCM_HEADER_SIZE         4U
+
+/* Exported macro ------------------------------------------------------------*/
+/** @brief Encoded size in bytes of a block of n samples (n even) */
+#define ADPCM_BLOCK_SIZE(n)       (ADPCM_HEADER_SIZE + ((n) / 2U))
+
+/* Exported functions prototypes ---------------------------------------------*/
+void ADPCM_EncodeBlock(const int16_t *pSrc, uint8_t *pDst, uint32_t Samples);
+void ADPCM_DecodeBlock(const uint8_t *pSrc, int16_t *pDst, uint32_t Samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_ADPCM_H */
@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * @file    audio_agc.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_agc.c file (speech automatic gain control).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_AGC_H
+#define __AUDIO_AGC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_vad.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  AGC tuning
+  * @note   Levels are block RMS in dBFS, gains in dB.
+  */
+typedef struct
+{
+  float    TargetDb;          /*!< Speech level the AGC aims for                   */
+  float    MinGainDb;         /*!< Total (analog + digital) gain range             */
+  float    MaxGainDb;
+  float    AttackMs;          /*!< Speech level tracker, rising level              */
+  float    DecayMs;           /*!< Speech level tracker, falling level             */
+  float    SlewDbPerSec;      /*!< Largest gain change rate                        */
+  float    NoiseGuardDb;      /*!< Noise floor is never lifted above this level    */
+  float    PeakDb;            /*!< Output peak limit                               */
+  /* Optional codec analog gain, leave SetAnalogGain NULL for digital only */
+  AUDIO_StatusTypeDef (*SetAnalogGain)(void *Context, float GainDb);
+  void    *Context;
+  float    AnalogMinDb;
+  float    AnalogMaxDb;
+  float    AnalogStepDb;      /*!< Codec PGA step                                  */
+} AGC_ConfigTypeDef;
+
+/**
+  * @brief  AGC handle structure
+  * @note   AGC_Process() runs in the audio context and does all the level
+  *         work once per block. AGC_Service() runs in the background and
+  *         moves the codec gain; the audio side reads AnalogDb to measure
+  *         levels at the microphone and to compensate digitally.
+  */
+typedef struct
+{
+  AGC_ConfigTypeDef Config;
+  VAD_HandleTypeDef Vad;
+  float    AttackCoeff;       /*!< Per-block one-pole coefficients                 */
+  float    DecayCoeff;
+  float    SlewDbPerBlock;
+  float    SpeechDb;          /*!< Tracked speech level at the microphone          */
+  float    GainDb;            /*!< Smoothed total gain                             */
+  float    Gain;              /*!< Linear digital gain reached at the last block   */
+  volatile float AnalogDb;    /*!< Gain currently applied by the codec             */
+} AGC_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef AGC_Init(AGC_HandleTypeDef *hagc, const AGC_ConfigTypeDef *pConfig);
+void    AGC_Process(AGC_HandleTypeDef *hagc, const float *pIn, float *pOut, uint32_t Frames);
+void    AGC_Service(AGC_HandleTypeDef *hagc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_AGC_H */
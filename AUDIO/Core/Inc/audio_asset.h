@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    audio_asset.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_asset.c file (compressed asset store in flash).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_ASSET_H
+#define __AUDIO_ASSET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Chunk compression scheme
+  */
+typedef enum
+{
+  ASSET_CODEC_LZ4 = 0U,             /*!< Generic: tables, weights, text              */
+  ASSET_CODEC_RICE16                /*!< 16-bit PCM: sample deltas, Rice coded       */
+} ASSET_CodecTypeDef;
+
+/**
+  * @brief  One asset, as emitted by Tools/asset_pack.py
+  * @note   The asset is cut into chunks of ChunkSize bytes (the last one may
+  *         be shorter), each compressed on its own. A chunk whose stored
+  *         length equals its decoded length is stored raw.
+  */
+typedef struct
+{
+  const char    *Name;
+  const uint8_t *pData;             /*!< Compressed chunks, back to back             */
+  const uint32_t *pChunks;          /*!< NumChunks + 1 offsets into pData            */
+  uint32_t Size;                    /*!< Decoded size in bytes                       */
+  uint32_t ChunkSize;
+  uint32_t NumChunks;
+  uint32_t Codec;                   /*!< ASSET_CodecTypeDef                          */
+} ASSET_EntryTypeDef;
+
+/**
+  * @brief  Flash-resident asset index, entries sorted by name
+  */
+typedef struct
+{
+  const ASSET_EntryTypeDef *pEntries;
+  uint32_t NumEntries;
+} ASSET_StoreTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+const ASSET_EntryTypeDef *ASSET_Find(const ASSET_StoreTypeDef *pStore, const char *pName);
+uint32_t ASSET_GetChunkSize(const ASSET_EntryTypeDef *pEntry, uint32_t Chunk);
+uint32_t ASSET_DecodeChunk(const ASSET_EntryTypeDef *pEntry, uint32_t Chunk, uint8_t *pDst);
+AUDIO_StatusTypeDef ASSET_Load(const ASSET_EntryTypeDef *pEntry, uint8_t *pDst, uint32_t DstSize);
+int32_t  ASSET_Lz4Decode(const uint8_t *pSrc, uint32_t SrcLen, uint8_t *pDst, uint32_t DstLen);
+int32_t  ASSET_Rice16Decode(const uint8_t *pSrc, uint32_t SrcLen, int16_t *pDst, uint32_t Samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_ASSET_H */
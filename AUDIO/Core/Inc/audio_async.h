@@ -0,0 +1,201 @@
+/**
+  ******************************************************************************
+  * @file    audio_async.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_async.c file (background coroutines for I/O sequences).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_ASYNC_H
+#define __AUDIO_ASYNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define ASYNC_MAX_TASKS           8U
+#define ASYNC_FRAME_SIZE          128U    /*!< Bytes of locals per task         */
+#define ASYNC_QUEUE_SIZE          32U     /*!< Events per queue, power of two   */
+#define ASYNC_FOREVER             0xFFFFFFFFU
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Task function return values
+  */
+typedef enum
+{
+  ASYNC_WAITING = 0x00U,
+  ASYNC_DONE    = 0x01U
+} ASYNC_StateTypeDef;
+
+/**
+  * @brief  Event counter posted by an interrupt (DMA complete, EXTI...)
+  * @note   A post is never lost: it stays pending until a task takes it,
+  *         even if it arrives before the task starts waiting. One interrupt
+  *         priority may post to a given signal. So a post the source makes
+  *         after a wait timed out satisfies the next wait: a task giving up
+  *         on a transfer stops the source, then calls ASYNC_Clear().
+  */
+typedef struct
+{
+  volatile uint32_t Posted;   /*!< Written by the interrupt only               */
+  uint32_t Taken;             /*!< Written by the run loop only                */
+} ASYNC_SignalTypeDef;
+
+/**
+  * @brief  Queue event
+  */
+typedef struct
+{
+  uint32_t Id;
+  int32_t  Value;
+} ASYNC_EventTypeDef;
+
+/**
+  * @brief  Single-producer single-consumer event queue
+  * @note   Push from one context (an interrupt or the background), pop from
+  *         the background. A full queue drops the new event and counts it.
+  */
+typedef struct
+{
+  ASYNC_EventTypeDef Events[ASYNC_QUEUE_SIZE];
+  volatile uint32_t Head;     /*!< Written by the producer                     */
+  volatile uint32_t Tail;     /*!< Written by the consumer                     */
+  uint32_t Dropped;
+} ASYNC_QueueTypeDef;
+
+typedef struct ASYNC_TaskTypeDef ASYNC_TaskTypeDef;
+
+/**
+  * @brief  Task body
+  * @param  pTask the task, for the ASYNC_ macros
+  * @param  pFrame the task locals, ASYNC_FRAME_SIZE bytes kept across waits
+  * @retval ASYNC_WAITING, or ASYNC_DONE when finished
+  */
+typedef ASYNC_StateTypeDef (*ASYNC_FuncTypeDef)(ASYNC_TaskTypeDef *pTask, void *pFrame);
+
+/**
+  * @brief  Task slot
+  * @note   Tasks are stackless: a body returns at every wait and resumes at
+  *         the same point on the next call. Locals kept across a wait must
+  *         live in the frame, not on the C stack, and a wait may only appear
+  *         in the body itself, not in a function it calls (spawn a child
+  *         task and await its Done signal instead).
+  */
+struct ASYNC_TaskTypeDef
+{
+  ASYNC_FuncTypeDef Func;     /*!< NULL when the slot is free                  */
+  uint32_t Line;              /*!< Resume point, 0 at start                    */
+  uint32_t Wait;              /*!< What the task waits for, ASYNC_WAIT_x       */
+  ASYNC_SignalTypeDef *pSignal;
+  ASYNC_QueueTypeDef  *pQueue;
+  uint32_t Now;               /*!< Tick of the current resume                  */
+  uint32_t Start;             /*!< Tick the current wait began                 */
+  uint32_t Timeout;           /*!< Wait limit in ticks, or ASYNC_FOREVER       */
+  AUDIO_StatusTypeDef Result; /*!< AUDIO_OK or AUDIO_TIMEOUT after a wait      */
+  ASYNC_EventTypeDef Event;   /*!< Event taken by the last queue wait          */
+  ASYNC_SignalTypeDef *pDone; /*!< Posted when the task finishes, or NULL      */
+  uint64_t Frame[ASYNC_FRAME_SIZE / 8U];
+};
+
+/**
+  * @brief  Run loop handle structure
+  */
+typedef struct
+{
+  ASYNC_TaskTypeDef Tasks[ASYNC_MAX_TASKS];
+} ASYNC_HandleTypeDef;
+
+/* Exported macro ------------------------------------------------------------*/
+/* Wait kinds, for ASYNC_TaskTypeDef.Wait */
+#define ASYNC_WAIT_NONE           0U
+#define ASYNC_WAIT_SIGNAL         1U
+#define ASYNC_WAIT_QUEUE          2U
+#define ASYNC_WAIT_TIME           3U
+#define ASYNC_WAIT_COND           4U
+
+/** @brief Opens a task body */
+#define ASYNC_BEGIN(pTask)        switch ((pTask)->Line) { case 0U:
+
+/** @brief Closes a task body: the task finishes */
+#define ASYNC_END(pTask)          default: break; } (pTask)->Line = 0U; return ASYNC_DONE
+
+/* Suspends the body until the run loop finds the wait over */
+#define ASYNC_SUSPEND_(pTask)     (pTask)->Line = (uint32_t)__LINE__; return ASYNC_WAITING; \
+                                  case __LINE__:
+
+/** @brief Lets the other tasks run, resumes on the next ASYNC_Run */
+#define ASYNC_YIELD(pTask) \
+  do { ASYNC_Wait((pTask), ASYNC_WAIT_NONE, 0U); ASYNC_SUSPEND_(pTask); } while (0)
+
+/** @brief Waits TimeoutMs */
+#define ASYNC_SLEEP(pTask, TimeoutMs) \
+  do { ASYNC_Wait((pTask), ASYNC_WAIT_TIME, (TimeoutMs)); ASYNC_SUSPEND_(pTask); } while (0)
+
+/** @brief Waits for a post to pSig; Result is AUDIO_OK or AUDIO_TIMEOUT */
+#define ASYNC_AWAIT_SIGNAL(pTask, pSig, TimeoutMs) \
+  do { (pTask)->pSignal = (pSig); ASYNC_Wait((pTask), ASYNC_WAIT_SIGNAL, (TimeoutMs)); \
+       ASYNC_SUSPEND_(pTask); } while (0)
+
+/** @brief Waits for an event of pQ, copied to Event; Result as above */
+#define ASYNC_AWAIT_EVENT(pTask, pQ, TimeoutMs) \
+  do { (pTask)->pQueue = (pQ); ASYNC_Wait((pTask), ASYNC_WAIT_QUEUE, (TimeoutMs)); \
+       ASYNC_SUSPEND_(pTask); } while (0)
+
+/**
+  * @brief  Evaluates Cond on every ASYNC_Run until it holds, for peripherals
+  *         that only offer a status flag; Result is AUDIO_OK or AUDIO_TIMEOUT.
+  */
+#define ASYNC_AWAIT_COND(pTask, Cond, TimeoutMs) \
+  do { ASYNC_Wait((pTask), ASYNC_WAIT_COND, (TimeoutMs)); ASYNC_SUSPEND_(pTask); \
+       if (Cond) { (pTask)->Result = AUDIO_OK; } \
+       else if ((pTask)->Result == AUDIO_OK) { return ASYNC_WAITING; } } while (0)
+
+/* Exported functions prototypes ---------------------------------------------*/
+void     ASYNC_Init(ASYNC_HandleTypeDef *hasync);
+AUDIO_StatusTypeDef ASYNC_Spawn(ASYNC_HandleTypeDef *hasync, ASYNC_FuncTypeDef Func,
+                                const void *pInit, uint32_t Size, ASYNC_SignalTypeDef *pDone);
+uint32_t ASYNC_Run(ASYNC_HandleTypeDef *hasync, uint32_t Now);
+void     ASYNC_Wait(ASYNC_TaskTypeDef *pTask, uint32_t Wait, uint32_t TimeoutMs);
+uint8_t  ASYNC_Push(ASYNC_QueueTypeDef *pQueue, uint32_t Id, int32_t Value);
+uint8_t  ASYNC_Pop(ASYNC_QueueTypeDef *pQueue, ASYNC_EventTypeDef *pEvent);
+
+/**
+  * @brief  Posts a signal, from its interrupt.
+  * @param  pSignal pointer to the signal
+  * @retval None
+  */
+static inline void ASYNC_Post(ASYNC_SignalTypeDef *pSignal)
+{
+  pSignal->Posted++;
+}
+
+/**
+  * @brief  Drops the posts pending on a signal, from the run loop.
+  * @note   Only once the source can no longer post for what was abandoned
+  *         (transfer stopped, its flags cleared), or a post may land after.
+  * @param  pSignal pointer to the signal
+  * @retval None
+  */
+static inline void ASYNC_Clear(ASYNC_SignalTypeDef *pSignal)
+{
+  pSignal->Taken = pSignal->Posted;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_ASYNC_H */
@@ -0,0 +1,62 @@
+/**
+  ******************************************************************************
+  * @file    audio_bench.h
+  * @brief   This file contains the kernel registry read by the host benchmark
+  *          runner (AUDIO/Tools/kernel_bench.py).
+  *
+  *          The registry is built only when AUDIO_KERNEL_BENCH is defined to 1
+  *          (project define). The runner loads the ELF into an emulator, finds
+  *          BenchKernels by symbol and calls each Setup, then each Run under a
+  *          Cortex-M4 cycle model; nothing here runs on the board.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_BENCH_H
+#define __AUDIO_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#ifndef AUDIO_KERNEL_BENCH
+#define AUDIO_KERNEL_BENCH        0
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  One registered kernel, 16 bytes
+  * @note   Keep in sync with AUDIO/Tools/kernel_bench.py. Setup prepares
+  *         inputs and state and is not timed; Run is timed and must be
+  *         repeatable, as the runner calls it more than once.
+  */
+typedef struct
+{
+  const char *Name;
+  void     (*Setup)(void);
+  void     (*Run)(void);
+  uint32_t Frames;            /*!< Frames (or calls) per Run, for cycles/frame  */
+} BENCH_KernelTypeDef;
+
+/* Exported variables --------------------------------------------------------*/
+#if (AUDIO_KERNEL_BENCH != 0)
+extern const BENCH_KernelTypeDef BenchKernels[];
+extern const uint32_t BenchKernelCount;
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_BENCH_H */
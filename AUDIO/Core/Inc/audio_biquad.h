@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    audio_biquad.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_biquad.c file (second-order IIR sections).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_BIQUAD_H
+#define __AUDIO_BIQUAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Coefficients of one section, normalized so that a0 = 1:
+  *         y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+  */
+typedef struct
+{
+  float b0;
+  float b1;
+  float b2;
+  float a1;
+  float a2;
+} BIQUAD_CoeffsTypeDef;
+
+/**
+  * @brief  State of one transposed direct form II section
+  */
+typedef struct
+{
+  float s1;
+  float s2;
+} BIQUAD_StateTypeDef;
+
+/**
+  * @brief  Cascade of sections filtering one signal
+  */
+typedef struct
+{
+  const BIQUAD_CoeffsTypeDef *pCoeffs;  /*!< NumStages coefficient sets, may live in flash */
+  BIQUAD_StateTypeDef *pState;          /*!< NumStages states                             */
+  uint32_t NumStages;
+} BIQUAD_CascadeTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void BIQUAD_CascadeInit(BIQUAD_CascadeTypeDef *hcascade, const BIQUAD_CoeffsTypeDef *pCoeffs,
+                        BIQUAD_StateTypeDef *pState, uint32_t NumStages);
+void BIQUAD_CascadeReset(BIQUAD_CascadeTypeDef *hcascade);
+void BIQUAD_CascadeProcess(BIQUAD_CascadeTypeDef *hcascade, const float *pIn, float *pOut,
+                           uint32_t Frames);
+void BIQUAD_Process(const BIQUAD_CoeffsTypeDef *pCoeffs, BIQUAD_StateTypeDef *pState,
+                    const float *pIn, float *pOut, uint32_t Frames);
+void BIQUAD_ProcessPair(const BIQUAD_CoeffsTypeDef *pCoeffsA, BIQUAD_StateTypeDef *pStateA,
+                        const float *pInA, float *pOutA,
+                        const BIQUAD_CoeffsTypeDef *pCoeffsB, BIQUAD_StateTypeDef *pStateB,
+                        const float *pInB, float *pOutB, uint32_t Frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_BIQUAD_H */
@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    audio_ctrl.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_ctrl.c file (control-rate node scheduler).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_CTRL_H
+#define __AUDIO_CTRL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define CTRL_MAX_NODES            32U
+#define CTRL_MAX_DIVIDER          32U     /*!< Slowest rate, 1.5 Hz updates at 48 kHz / 64 */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Control node update function
+  * @param  Context node owner data
+  * @param  Dt time between two updates of this node, seconds
+  * @retval New node value
+  */
+typedef float (*CTRL_TickTypeDef)(void *Context, float Dt);
+
+/**
+  * @brief  Control-rate node (envelope, LFO, meter, detector...)
+  * @note   The node updates once every Divider blocks. Its output is
+  *         interpolated back to audio rate: a value returned at block b is
+  *         reached exactly on the last sample of block b + Divider - 1, so
+  *         every node has one update period of latency and no step.
+  */
+typedef struct
+{
+  CTRL_TickTypeDef Tick;
+  void    *Context;
+  uint8_t  Divider;           /*!< Blocks per update, power of two             */
+  uint8_t  Phase;             /*!< Block slot within the divider, scheduler set */
+  uint8_t  Remaining;         /*!< Blocks left on the current ramp             */
+  uint16_t Cost;              /*!< Relative update cost, for load balancing    */
+  float    Target;            /*!< Last value returned by Tick                 */
+  float    Current;           /*!< Output at the start of the current block    */
+  float    Step;              /*!< Output increment per sample                 */
+} CTRL_NodeTypeDef;
+
+/**
+  * @brief  Control scheduler handle structure
+  * @note   Nodes run in the order they were added, so a node may read the
+  *         outputs of the nodes added before it (a subgraph feeding itself
+  *         in one pass). Phases are chosen when nodes are added so the
+  *         updates of slow nodes spread over the blocks instead of all
+  *         landing on the same one.
+  */
+typedef struct
+{
+  CTRL_NodeTypeDef *pNodes[CTRL_MAX_NODES];
+  uint32_t NumNodes;
+  uint32_t Block;             /*!< Blocks since init, modulo CTRL_MAX_DIVIDER  */
+  uint32_t Load[CTRL_MAX_DIVIDER];  /*!< Scheduled cost of each block slot     */
+} CTRL_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void     CTRL_Init(CTRL_HandleTypeDef *hctrl);
+AUDIO_StatusTypeDef CTRL_AddNode(CTRL_HandleTypeDef *hctrl, CTRL_NodeTypeDef *pNode,
+                                 CTRL_TickTypeDef Tick, void *Context,
+                                 uint32_t Divider, uint32_t Cost, float Initial);
+void     CTRL_Process(CTRL_HandleTypeDef *hctrl);
+void     CTRL_Render(const CTRL_NodeTypeDef *pNode, float *pOut, uint32_t Frames);
+uint32_t CTRL_GetPeakLoad(const CTRL_HandleTypeDef *hctrl);
+
+/**
+  * @brief  Node output at the start of the current block, for consumers
+  *         that only need one value per block.
+  * @param  pNode pointer to the node
+  * @retval Node output
+  */
+static inline float CTRL_GetValue(const CTRL_NodeTypeDef *pNode)
+{
+  return pNode->Current;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_CTRL_H */
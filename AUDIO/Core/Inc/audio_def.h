@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    audio_def.h
+  * @brief   Common definitions shared by the audio modules.
+  *          The audio modules only depend on this header and the C library,
+  *          so they build unchanged for the target and for a host build.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_DEF_H
+#define __AUDIO_DEF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Audio module status structures definition
+  */
+typedef enum
+{
+  AUDIO_OK       = 0x00U,
+  AUDIO_ERROR    = 0x01U,
+  AUDIO_BUSY     = 0x02U,
+  AUDIO_TIMEOUT  = 0x03U
+} AUDIO_StatusTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/** @brief Audio path sample rate in Hz */
+#define AUDIO_SAMPLE_RATE         48000U
+
+/** @brief Number of frames processed per audio block */
+#define AUDIO_BLOCK_SIZE          64U
+
+/* Exported macro ------------------------------------------------------------*/
+#define AUDIO_MIN(a, b)           (((a) < (b)) ? (a) : (b))
+#define AUDIO_MAX(a, b)           (((a) > (b)) ? (a) : (b))
+#define AUDIO_CLAMP(x, lo, hi)    AUDIO_MIN(AUDIO_MAX((x), (lo)), (hi))
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Critical section against interrupts, for the few instructions where
+  *         a background check and store must not be split by the audio
+  *         interrupt. Nests: restore what AUDIO_EnterCritical() returned.
+  * @note   A host tool built with AUDIO_HOST_IRQ supplies both functions, and
+  *         can deliver a simulated interrupt that arrived in between when the
+  *         section ends, as the NVIC would. Other host builds have no
+  *         interrupts and compile them out.
+  */
+#if defined(AUDIO_HOST_IRQ)
+uint32_t AUDIO_EnterCritical(void);
+void     AUDIO_ExitCritical(uint32_t State);
+#elif defined(__arm__)
+static inline uint32_t AUDIO_EnterCritical(void)
+{
+  uint32_t primask;
+
+  __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) : : "memory");
+  return primask;
+}
+
+static inline void AUDIO_ExitCritical(uint32_t State)
+{
+  __asm volatile ("msr primask, %0" : : "r" (State) : "memory");
+}
+#else
+static inline uint32_t AUDIO_EnterCritical(void)
+{
+  return 0U;
+}
+
+static inline void AUDIO_ExitCritical(uint32_t State)
+{
+  (void)State;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_DEF_H */
@@ -0,0 +1,228 @@
+/**
+  ******************************************************************************
+  * @file    audio_design.h
+  * @brief   Compile-time filter design.
+  *
+  *          The macros below expand to constant expressions built from GCC's
+  *          math builtins, which the compiler evaluates in double precision
+  *          while compiling, even at -O0. Used in the initializer of a const
+  *          object they produce finished coefficient tables in flash: no
+  *          design code, no libm and no RAM copy in the image.
+  *
+  *          Biquads are designed in two steps: a design macro yields the raw
+  *          (b0, b1, b2, a0, a1, a2) tuple, an emitter normalizes it:
+  *
+  *            static const BIQUAD_CoeffsTypeDef Eq[2] =
+  *            {
+  *              DESIGN_BIQUAD(DESIGN_RBJ_PEAKING(48000, 250, 1.0, -3.0)),
+  *              DESIGN_BIQUAD(DESIGN_RBJ_HIGHSHELF(48000, 8000, 0.707, 2.0)),
+  *            };
+  *
+  *          FIR tables are built tap by tap with a repeat macro:
+  *
+  *            static const float Hb[31] = { DESIGN_REPEAT_31(DESIGN_FIR_HALFBAND, 31) };
+  *            static const int16_t Lp[63] =
+  *              { DESIGN_REPEAT_63(DESIGN_AS_Q15, DESIGN_FIR_LOWPASS, 63, 48000, 4000) };
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_DESIGN_H
+#define __AUDIO_DESIGN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define DESIGN_PI                 3.14159265358979323846
+
+/* Exported macro ------------------------------------------------------------*/
+/* Common terms ---------------------------------------------------------------*/
+#define DESIGN_W0(fs, f0)         (2.0 * DESIGN_PI * (double)(f0) / (double)(fs))
+#define DESIGN_COS(fs, f0)        __builtin_cos(DESIGN_W0(fs, f0))
+#define DESIGN_ALPHA(fs, f0, q)   (__builtin_sin(DESIGN_W0(fs, f0)) / (2.0 * (double)(q)))
+/** Shelf / peak amplitude from the gain in dB */
+#define DESIGN_A(db)              __builtin_pow(10.0, (double)(db) / 40.0)
+/** Bilinear prewarped frequency of first-order sections */
+#define DESIGN_K(fs, f0)          __builtin_tan(DESIGN_PI * (double)(f0) / (double)(fs))
+
+/* RBJ cookbook biquads, as (b0, b1, b2, a0, a1, a2) tuples -------------------*/
+#define DESIGN_RBJ_LOWPASS(fs, f0, q)                                                         \
+  ((1.0 - DESIGN_COS(fs, f0)) / 2.0, 1.0 - DESIGN_COS(fs, f0), (1.0 - DESIGN_COS(fs, f0)) / 2.0, \
+   1.0 + DESIGN_ALPHA(fs, f0, q), -2.0 * DESIGN_COS(fs, f0), 1.0 - DESIGN_ALPHA(fs, f0, q))
+
+#define DESIGN_RBJ_HIGHPASS(fs, f0, q)                                                          \
+  ((1.0 + DESIGN_COS(fs, f0)) / 2.0, -(1.0 + DESIGN_COS(fs, f0)), (1.0 + DESIGN_COS(fs, f0)) / 2.0, \
+   1.0 + DESIGN_ALPHA(fs, f0, q), -2.0 * DESIGN_COS(fs, f0), 1.0 - DESIGN_ALPHA(fs, f0, q))
+
+/** Band-pass, 0 dB peak gain */
+#define DESIGN_RBJ_BANDPASS(fs, f0, q)                                                        \
+  (DESIGN_ALPHA(fs, f0, q), 0.0, -DESIGN_ALPHA(fs, f0, q),                                    \
+   1.0 + DESIGN_ALPHA(fs, f0, q), -2.0 * DESIGN_COS(fs, f0), 1.0 - DESIGN_ALPHA(fs, f0, q))
+
+#define DESIGN_RBJ_NOTCH(fs, f0, q)                                                           \
+  (1.0, -2.0 * DESIGN_COS(fs, f0), 1.0,                                                       \
+   1.0 + DESIGN_ALPHA(fs, f0, q), -2.0 * DESIGN_COS(fs, f0), 1.0 - DESIGN_ALPHA(fs, f0, q))
+
+#define DESIGN_RBJ_ALLPASS(fs, f0, q)                                                         \
+  (1.0 - DESIGN_ALPHA(fs, f0, q), -2.0 * DESIGN_COS(fs, f0), 1.0 + DESIGN_ALPHA(fs, f0, q),   \
+   1.0 + DESIGN_ALPHA(fs, f0, q), -2.0 * DESIGN_COS(fs, f0), 1.0 - DESIGN_ALPHA(fs, f0, q))
+
+#define DESIGN_RBJ_PEAKING(fs, f0, q, db)                                                     \
+  (1.0 + DESIGN_ALPHA(fs, f0, q) * DESIGN_A(db), -2.0 * DESIGN_COS(fs, f0),                   \
+   1.0 - DESIGN_ALPHA(fs, f0, q) * DESIGN_A(db),                                              \
+   1.0 + DESIGN_ALPHA(fs, f0, q) / DESIGN_A(db), -2.0 * DESIGN_COS(fs, f0),                   \
+   1.0 - DESIGN_ALPHA(fs, f0, q) / DESIGN_A(db))
+
+/** Shelf terms: 2 sqrt(A) alpha */
+#define DESIGN_SHELF(fs, f0, q, db) (2.0 * __builtin_sqrt(DESIGN_A(db)) * DESIGN_ALPHA(fs, f0, q))
+
+#define DESIGN_RBJ_LOWSHELF(fs, f0, q, db)                                                              \
+  (DESIGN_A(db) * ((DESIGN_A(db) + 1.0) - (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) + DESIGN_SHELF(fs, f0, q, db)), \
+   2.0 * DESIGN_A(db) * ((DESIGN_A(db) - 1.0) - (DESIGN_A(db) + 1.0) * DESIGN_COS(fs, f0)),                      \
+   DESIGN_A(db) * ((DESIGN_A(db) + 1.0) - (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) - DESIGN_SHELF(fs, f0, q, db)), \
+   (DESIGN_A(db) + 1.0) + (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) + DESIGN_SHELF(fs, f0, q, db),                \
+   -2.0 * ((DESIGN_A(db) - 1.0) + (DESIGN_A(db) + 1.0) * DESIGN_COS(fs, f0)),                                     \
+   (DESIGN_A(db) + 1.0) + (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) - DESIGN_SHELF(fs, f0, q, db))
+
+#define DESIGN_RBJ_HIGHSHELF(fs, f0, q, db)                                                             \
+  (DESIGN_A(db) * ((DESIGN_A(db) + 1.0) + (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) + DESIGN_SHELF(fs, f0, q, db)), \
+   -2.0 * DESIGN_A(db) * ((DESIGN_A(db) - 1.0) + (DESIGN_A(db) + 1.0) * DESIGN_COS(fs, f0)),                     \
+   DESIGN_A(db) * ((DESIGN_A(db) + 1.0) + (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) - DESIGN_SHELF(fs, f0, q, db)), \
+   (DESIGN_A(db) + 1.0) - (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) + DESIGN_SHELF(fs, f0, q, db),                \
+   2.0 * ((DESIGN_A(db) - 1.0) - (DESIGN_A(db) + 1.0) * DESIGN_COS(fs, f0)),                                      \
+   (DESIGN_A(db) + 1.0) - (DESIGN_A(db) - 1.0) * DESIGN_COS(fs, f0) - DESIGN_SHELF(fs, f0, q, db))
+
+/* Butterworth and Linkwitz-Riley cascades ------------------------------------*/
+/** Number of sections of an order n Butterworth filter */
+#define DESIGN_BUTTERWORTH_SECTIONS(n)  (((n) + 1) / 2)
+/** Number of sections of an order n (2, 4 or 8) Linkwitz-Riley filter */
+#define DESIGN_LINKWITZ_SECTIONS(n)     (2 * DESIGN_BUTTERWORTH_SECTIONS((n) / 2))
+
+/** Pole pair quality factor of section k */
+#define DESIGN_BUTTERWORTH_Q(n, k)      (0.5 / __builtin_sin(DESIGN_PI * (2.0 * (k) + 1.0) / (2.0 * (n))))
+/** Non-zero for the real-pole section closing an odd order */
+#define DESIGN_FIRST_ORDER(n, k)        ((((n) % 2) != 0) && ((k) == (n) / 2))
+
+/** Section k (0 .. DESIGN_BUTTERWORTH_SECTIONS(n) - 1) of an order n low-pass */
+#define DESIGN_BUTTERWORTH_LOWPASS(fs, f0, n, k)                                              \
+  DESIGN_SELECT(DESIGN_FIRST_ORDER(n, k),                                                     \
+                (DESIGN_K(fs, f0), DESIGN_K(fs, f0), 0.0, DESIGN_K(fs, f0) + 1.0, DESIGN_K(fs, f0) - 1.0, 0.0), \
+                DESIGN_RBJ_LOWPASS(fs, f0, DESIGN_BUTTERWORTH_Q(n, k)))
+
+/** Section k (0 .. DESIGN_BUTTERWORTH_SECTIONS(n) - 1) of an order n high-pass */
+#define DESIGN_BUTTERWORTH_HIGHPASS(fs, f0, n, k)                                             \
+  DESIGN_SELECT(DESIGN_FIRST_ORDER(n, k),                                                     \
+                (1.0, -1.0, 0.0, DESIGN_K(fs, f0) + 1.0, DESIGN_K(fs, f0) - 1.0, 0.0),        \
+                DESIGN_RBJ_HIGHPASS(fs, f0, DESIGN_BUTTERWORTH_Q(n, k)))
+
+/** Section k of an order n Linkwitz-Riley crossover: the order n/2 Butterworth
+    filter twice. At order 2 (and 6) the high-pass output is phase inverted. */
+#define DESIGN_LINKWITZ_LOWPASS(fs, f0, n, k)                                                 \
+  DESIGN_BUTTERWORTH_LOWPASS(fs, f0, (n) / 2, (k) % DESIGN_BUTTERWORTH_SECTIONS((n) / 2))
+#define DESIGN_LINKWITZ_HIGHPASS(fs, f0, n, k)                                                \
+  DESIGN_BUTTERWORTH_HIGHPASS(fs, f0, (n) / 2, (k) % DESIGN_BUTTERWORTH_SECTIONS((n) / 2))
+
+/** Picks one of two design tuples, element by element */
+#define DESIGN_SELECT(c, t, f)          DESIGN_SELECT_(c, DESIGN_EXPAND t, DESIGN_EXPAND f)
+#define DESIGN_SELECT_(...)             DESIGN_SELECT__(__VA_ARGS__)
+#define DESIGN_SELECT__(c, t0, t1, t2, t3, t4, t5, f0, f1, f2, f3, f4, f5)                     \
+  ((c) ? (t0) : (f0), (c) ? (t1) : (f1), (c) ? (t2) : (f2),                                   \
+   (c) ? (t3) : (f3), (c) ? (t4) : (f4), (c) ? (t5) : (f5))
+#define DESIGN_EXPAND(...)              __VA_ARGS__
+
+/* Biquad emitters ------------------------------------------------------------*/
+/** BIQUAD_CoeffsTypeDef initializer from a design tuple */
+#define DESIGN_BIQUAD(t)                DESIGN_BIQUAD_ t
+#define DESIGN_BIQUAD_(b0, b1, b2, a0, a1, a2)                                                \
+  { (float)((b0) / (a0)), (float)((b1) / (a0)), (float)((b2) / (a0)),                         \
+    (float)((a1) / (a0)), (float)((a2) / (a0)) }
+
+/** Five Q31 values b0, b1, b2, a1, a2, scaled down by 2^shift so they fit */
+#define DESIGN_BIQUAD_Q31(t, shift)     DESIGN_BIQUAD_Q31_(shift, DESIGN_EXPAND t)
+#define DESIGN_BIQUAD_Q31_(...)         DESIGN_BIQUAD_Q31__(__VA_ARGS__)
+#define DESIGN_BIQUAD_Q31__(s, b0, b1, b2, a0, a1, a2)                                        \
+  DESIGN_Q31((b0) / (a0) / (double)(1 << (s))), DESIGN_Q31((b1) / (a0) / (double)(1 << (s))), \
+  DESIGN_Q31((b2) / (a0) / (double)(1 << (s))), DESIGN_Q31((a1) / (a0) / (double)(1 << (s))), \
+  DESIGN_Q31((a2) / (a0) / (double)(1 << (s)))
+
+/* Fixed-point conversion, rounded and saturated ------------------------------*/
+#define DESIGN_Q15(x)                                                                         \
+  ((int16_t)(((double)(x) >= 32767.0 / 32768.0) ? 32767 :                                     \
+             ((double)(x) <= -1.0) ? -32768 :                                                 \
+             (int32_t)__builtin_floor((double)(x) * 32768.0 + 0.5)))
+#define DESIGN_Q31(x)                                                                         \
+  ((int32_t)(((double)(x) >= 2147483647.0 / 2147483648.0) ? 2147483647 :                     \
+             ((double)(x) <= -1.0) ? (-2147483647 - 1) :                                      \
+             (int32_t)__builtin_floor((double)(x) * 2147483648.0 + 0.5)))
+
+/* FIR taps -------------------------------------------------------------------*/
+/** Blackman window, tap n of a taps-long filter */
+#define DESIGN_BLACKMAN(n, taps)                                                              \
+  (0.42 - 0.5 * __builtin_cos(2.0 * DESIGN_PI * (double)(n) / ((double)(taps) - 1.0))         \
+        + 0.08 * __builtin_cos(4.0 * DESIGN_PI * (double)(n) / ((double)(taps) - 1.0)))
+
+/** sin(pi x) / (pi x) */
+#define DESIGN_SINC(x)                                                                        \
+  (((double)(x) == 0.0) ? 1.0 : __builtin_sin(DESIGN_PI * (double)(x)) / (DESIGN_PI * (double)(x)))
+
+/** Tap n of a Blackman windowed-sinc low-pass, cutoff fc (-6 dB), odd taps */
+#define DESIGN_FIR_LOWPASS(n, taps, fs, fc)                                                   \
+  (2.0 * (double)(fc) / (double)(fs) *                                                        \
+   DESIGN_SINC(2.0 * (double)(fc) / (double)(fs) * ((double)(n) - ((double)(taps) - 1.0) / 2.0)) * \
+   DESIGN_BLACKMAN(n, taps))
+
+/** Tap n of a half-band low-pass (taps = 4m - 1): every other tap is exactly
+    zero and the center tap exactly 0.5, as the decimator structures expect */
+#define DESIGN_FIR_HALFBAND(n, taps)                                                          \
+  ((2 * (n) == (taps) - 1) ? 0.5 :                                                            \
+   ((((taps) - 1) / 2 - (n)) % 2 == 0) ? 0.0 :                                                \
+   0.5 * DESIGN_SINC(((double)(n) - ((double)(taps) - 1.0) / 2.0) / 2.0) * DESIGN_BLACKMAN(n, taps))
+
+/** Wraps any tap macro m(n, ...) into a Q15 / Q31 tap macro */
+#define DESIGN_AS_Q15(n, m, ...)        DESIGN_Q15(m(n, __VA_ARGS__))
+#define DESIGN_AS_Q31(n, m, ...)        DESIGN_Q31(m(n, __VA_ARGS__))
+
+/* Table repetition: m(n, ...) for n = 0 .. N-1 --------------------------------*/
+#define DESIGN_REP_1(m, b, ...)         m((b), __VA_ARGS__)
+#define DESIGN_REP_2(m, b, ...)         DESIGN_REP_1(m, b, __VA_ARGS__), DESIGN_REP_1(m, (b) + 1, __VA_ARGS__)
+#define DESIGN_REP_4(m, b, ...)         DESIGN_REP_2(m, b, __VA_ARGS__), DESIGN_REP_2(m, (b) + 2, __VA_ARGS__)
+#define DESIGN_REP_8(m, b, ...)         DESIGN_REP_4(m, b, __VA_ARGS__), DESIGN_REP_4(m, (b) + 4, __VA_ARGS__)
+#define DESIGN_REP_16(m, b, ...)        DESIGN_REP_8(m, b, __VA_ARGS__), DESIGN_REP_8(m, (b) + 8, __VA_ARGS__)
+#define DESIGN_REP_32(m, b, ...)        DESIGN_REP_16(m, b, __VA_ARGS__), DESIGN_REP_16(m, (b) + 16, __VA_ARGS__)
+#define DESIGN_REP_64(m, b, ...)        DESIGN_REP_32(m, b, __VA_ARGS__), DESIGN_REP_32(m, (b) + 32, __VA_ARGS__)
+
+#define DESIGN_REPEAT_7(m, ...)   DESIGN_REP_4(m, 0, __VA_ARGS__), DESIGN_REP_2(m, 4, __VA_ARGS__), \
+                                  DESIGN_REP_1(m, 6, __VA_ARGS__)
+#define DESIGN_REPEAT_8(m, ...)   DESIGN_REP_8(m, 0, __VA_ARGS__)
+#define DESIGN_REPEAT_15(m, ...)  DESIGN_REP_8(m, 0, __VA_ARGS__), DESIGN_REPEAT_7_AT(m, 8, __VA_ARGS__)
+#define DESIGN_REPEAT_16(m, ...)  DESIGN_REP_16(m, 0, __VA_ARGS__)
+#define DESIGN_REPEAT_31(m, ...)  DESIGN_REP_16(m, 0, __VA_ARGS__), DESIGN_REPEAT_15_AT(m, 16, __VA_ARGS__)
+#define DESIGN_REPEAT_32(m, ...)  DESIGN_REP_32(m, 0, __VA_ARGS__)
+#define DESIGN_REPEAT_63(m, ...)  DESIGN_REP_32(m, 0, __VA_ARGS__), DESIGN_REPEAT_31_AT(m, 32, __VA_ARGS__)
+#define DESIGN_REPEAT_64(m, ...)  DESIGN_REP_64(m, 0, __VA_ARGS__)
+#define DESIGN_REPEAT_127(m, ...) DESIGN_REP_64(m, 0, __VA_ARGS__), DESIGN_REPEAT_63_AT(m, 64, __VA_ARGS__)
+#define DESIGN_REPEAT_128(m, ...) DESIGN_REP_64(m, 0, __VA_ARGS__), DESIGN_REP_64(m, 64, __VA_ARGS__)
+
+#define DESIGN_REPEAT_7_AT(m, b, ...)   DESIGN_REP_4(m, b, __VA_ARGS__), DESIGN_REP_2(m, (b) + 4, __VA_ARGS__), \
+                                        DESIGN_REP_1(m, (b) + 6, __VA_ARGS__)
+#define DESIGN_REPEAT_15_AT(m, b, ...)  DESIGN_REP_8(m, b, __VA_ARGS__), DESIGN_REPEAT_7_AT(m, (b) + 8, __VA_ARGS__)
+#define DESIGN_REPEAT_31_AT(m, b, ...)  DESIGN_REP_16(m, b, __VA_ARGS__), DESIGN_REPEAT_15_AT(m, (b) + 16, __VA_ARGS__)
+#define DESIGN_REPEAT_63_AT(m, b, ...)  DESIGN_REP_32(m, b, __VA_ARGS__), DESIGN_REPEAT_31_AT(m, (b) + 32, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_DESIGN_H */
@@ -0,0 +1,139 @@
+/**
+  ******************************************************************************
+  * @file    audio_disk.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_disk.c file (SD card I/O scheduler).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_DISK_H
+#define __AUDIO_DISK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define DISK_SECTOR_SIZE          512U
+#define DISK_MAX_SECTORS          32U     /*!< Largest coalesced transfer, 16 KB */
+#define DISK_MAX_MERGE            32U     /*!< Requests served by one transfer   */
+#define DISK_NO_DEADLINE          0xFFFFFFFFU
+#define DISK_DEFAULT_MARGIN_US    2000U
+#define DISK_DEFAULT_MAX_HOLD_US  250000U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Card driver and clock
+  * @note   Transfer starts a multi-block DMA transfer and returns; the driver
+  *         calls DISK_TransferComplete() when it is over, from its interrupt.
+  *         pBuffer is 4-byte aligned. Now is a free-running microsecond
+  *         count (DWT cycle counter / 100, or a 32-bit timer at 1 MHz).
+  */
+typedef struct
+{
+  AUDIO_StatusTypeDef (*Transfer)(void *Context, uint8_t Write, uint32_t Lba, uint32_t Count,
+                                  uint8_t *pBuffer);
+  uint32_t (*Now)(void *Context);
+  void    *Context;
+  uint32_t MarginUs;          /*!< Read deadline slack kept clear of writes,
+                                   0 for the default                          */
+  uint32_t MaxHoldUs;         /*!< Longest a write without a deadline waits
+                                   behind reads, 0 for the default            */
+  uint8_t  NoThrottle;        /*!< Writes compete on deadline alone          */
+} DISK_ConfigTypeDef;
+
+typedef struct DISK_RequestTypeDef DISK_RequestTypeDef;
+
+/**
+  * @brief  One read or write, owned by the caller until done
+  * @note   Set the first fields and submit. DeadlineUs counts from the
+  *         submission; requests without one are served in order, after
+  *         those with one, and writes without one yield to any read at
+  *         risk, for MaxHoldUs at most. Done, if set, runs from DISK_Poll().
+  */
+struct DISK_RequestTypeDef
+{
+  uint32_t Lba;
+  uint32_t Count;             /*!< Sectors, up to DISK_MAX_SECTORS              */
+  uint8_t *pBuffer;
+  uint8_t  Write;
+  uint32_t DeadlineUs;        /*!< Or DISK_NO_DEADLINE                          */
+  void   (*Done)(void *Context, DISK_RequestTypeDef *pRequest);
+  void    *Context;
+  /* Set by the scheduler */
+  volatile AUDIO_StatusTypeDef Status;  /*!< AUDIO_BUSY until done             */
+  uint32_t Due;               /*!< Absolute deadline, microseconds, or the end
+                                   of the hold of a write without one          */
+  uint32_t Seq;               /*!< Submission order                            */
+  uint32_t Late;              /*!< Microseconds past the deadline when done    */
+  DISK_RequestTypeDef *pNext;
+};
+
+/**
+  * @brief  Per direction counters
+  */
+typedef struct
+{
+  uint32_t Requests;
+  uint32_t Transfers;         /*!< Requests - Transfers were coalesced         */
+  uint32_t Sectors;
+  uint32_t Missed;            /*!< Done after their deadline                   */
+  uint32_t WorstLate;         /*!< Microseconds                                */
+  uint32_t Errors;
+} DISK_StatsTypeDef;
+
+/**
+  * @brief  I/O scheduler handle structure
+  */
+typedef struct
+{
+  DISK_ConfigTypeDef Config;
+  DISK_RequestTypeDef *pQueue[2];   /*!< Reads, writes: by deadline, then order */
+  DISK_RequestTypeDef *pFlight[DISK_MAX_MERGE];
+  uint32_t NumFlight;
+  uint32_t Lba;                     /*!< Transfer in flight                     */
+  uint32_t Count;
+  uint8_t  Write;
+  uint8_t  Bounced;                 /*!< Through Bounce, not the request buffer */
+  volatile uint8_t Busy;
+  volatile uint8_t Done;
+  volatile AUDIO_StatusTypeDef Result;
+  uint32_t Started;
+  uint32_t Seq;
+  uint32_t Expect;                  /*!< Read due by then, from DISK_Expect()   */
+  uint8_t  Expecting;
+  uint8_t  Holding;                 /*!< A write is being held back             */
+  uint32_t ForcedAt;                /*!< Last write let through after its hold  */
+  uint32_t ReadCostUs;              /*!< Running average of read times          */
+  uint32_t WriteCostUs;             /*!< Peak of write times, decaying with time */
+  uint32_t CostAt;                  /*!< WriteCostUs decayed up to then         */
+  uint32_t Bounce[(DISK_MAX_SECTORS * DISK_SECTOR_SIZE) / 4U];
+  DISK_StatsTypeDef Stats[2];
+  uint32_t Throttled;               /*!< Times writes were held for a read      */
+  uint32_t Forced;                  /*!< Writes let through after MaxHoldUs     */
+} DISK_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef DISK_Init(DISK_HandleTypeDef *hdisk, const DISK_ConfigTypeDef *pConfig);
+AUDIO_StatusTypeDef DISK_Submit(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest);
+void     DISK_Expect(DISK_HandleTypeDef *hdisk, uint32_t SlackUs);
+void     DISK_Poll(DISK_HandleTypeDef *hdisk);
+void     DISK_TransferComplete(DISK_HandleTypeDef *hdisk, AUDIO_StatusTypeDef Status);
+uint8_t  DISK_IsIdle(const DISK_HandleTypeDef *hdisk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_DISK_H */
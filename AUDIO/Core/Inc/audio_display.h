@@ -0,0 +1,149 @@
+/**
+  ******************************************************************************
+  * @file    audio_display.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_display.c file (tiled framebuffer, meters and scope).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_DISPLAY_H
+#define __AUDIO_DISPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define DISPLAY_WIDTH             320U    /*!< Panel pixels, landscape          */
+#define DISPLAY_HEIGHT            240U
+#define DISPLAY_TILE              16U     /*!< Dirty tracking granularity       */
+#define DISPLAY_TILES_X           (DISPLAY_WIDTH / DISPLAY_TILE)    /*!< <= 32  */
+#define DISPLAY_TILES_Y           (DISPLAY_HEIGHT / DISPLAY_TILE)
+#define DISPLAY_STRIDE            (DISPLAY_WIDTH / 2U)  /*!< Bytes per row, 4 bpp */
+#define DISPLAY_SCOPE_POINTS      256U    /*!< Widest scope, in columns         */
+#define DISPLAY_METER_FLOOR_DB    (-60.0f)
+
+/**
+  * @brief  Palette indexes of the default palette
+  */
+#define DISPLAY_BLACK             0U
+#define DISPLAY_DARK_GREY         1U
+#define DISPLAY_GREY              2U
+#define DISPLAY_WHITE             3U
+#define DISPLAY_GREEN             4U
+#define DISPLAY_DARK_GREEN        5U
+#define DISPLAY_YELLOW            6U
+#define DISPLAY_DARK_YELLOW       7U
+#define DISPLAY_RED               8U
+#define DISPLAY_DARK_RED          9U
+#define DISPLAY_CYAN              10U
+#define DISPLAY_BLUE              11U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Pixel rectangle
+  */
+typedef struct
+{
+  uint16_t X;
+  uint16_t Y;
+  uint16_t W;
+  uint16_t H;
+} DISPLAY_RectTypeDef;
+
+/**
+  * @brief  Framebuffer handle structure
+  * @note   Pixels are 4-bit palette indexes, two per byte with the even
+  *         column in the low nibble: 38 KB where RGB565 would take 150 KB.
+  *         Every drawing call marks the tiles it touches; the flush walks the
+  *         dirty tiles as rectangles and expands only those to RGB565.
+  */
+typedef struct
+{
+  uint8_t  Pixels[DISPLAY_HEIGHT * DISPLAY_STRIDE];
+  uint32_t Dirty[DISPLAY_TILES_Y];  /*!< Bit x set when tile (x, row) changed   */
+  uint16_t Palette[16];             /*!< RGB565, in the order the panel expects */
+} DISPLAY_HandleTypeDef;
+
+/**
+  * @brief  Vertical level meter
+  * @note   The audio interrupt feeds Peak[Side]; the background flips Side
+  *         before it reads the other slot, so no peak is lost or torn: the
+  *         interrupt always completes before the background resumes.
+  */
+typedef struct
+{
+  DISPLAY_RectTypeDef Area;
+  volatile float   Peak[2];         /*!< Linear peak since the last frame       */
+  volatile uint8_t Side;            /*!< Slot the audio interrupt writes        */
+  float    FallDb;                  /*!< Bar fall per frame, dB                 */
+  uint16_t HoldFrames;              /*!< Peak marker hold before it falls       */
+  /* Drawn state */
+  float    LevelDb;
+  float    HoldDb;
+  uint16_t HoldCount;
+  uint16_t Bar;                     /*!< Lit rows                               */
+  uint16_t Mark;                    /*!< Peak marker row from the bottom, 0 none */
+} DISPLAY_MeterTypeDef;
+
+/**
+  * @brief  Oscilloscope
+  * @note   The audio interrupt triggers on a rising zero crossing (or
+  *         after four screens without one, so silence still draws a line),
+  *         then keeps one sample in Decimate until the width is captured and
+  *         sets Ready. The background draws the capture and clears Ready,
+  *         which re-arms.
+  */
+typedef struct
+{
+  DISPLAY_RectTypeDef Area;         /*!< Width is the number of points          */
+  uint32_t Decimate;
+  volatile uint8_t Ready;
+  uint8_t  Armed;
+  uint16_t Count;
+  uint32_t Skip;
+  uint32_t Waited;                  /*!< Samples since armed, for auto trigger  */
+  float    Last;
+  float    Capture[DISPLAY_SCOPE_POINTS];
+  /* Drawn trace, one vertical segment per column, rows from the top */
+  uint8_t  Lo[DISPLAY_SCOPE_POINTS];
+  uint8_t  Hi[DISPLAY_SCOPE_POINTS];
+  uint8_t  Drawn;
+} DISPLAY_ScopeTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void     DISPLAY_Init(DISPLAY_HandleTypeDef *hdisp, uint8_t Background);
+void     DISPLAY_Fill(DISPLAY_HandleTypeDef *hdisp, uint32_t X, uint32_t Y, uint32_t W,
+                      uint32_t H, uint8_t Color);
+void     DISPLAY_Mark(DISPLAY_HandleTypeDef *hdisp, uint32_t X, uint32_t Y, uint32_t W, uint32_t H);
+void     DISPLAY_MarkAll(DISPLAY_HandleTypeDef *hdisp);
+uint8_t  DISPLAY_NextRegion(DISPLAY_HandleTypeDef *hdisp, DISPLAY_RectTypeDef *pRect);
+void     DISPLAY_Pack(const DISPLAY_HandleTypeDef *hdisp, const DISPLAY_RectTypeDef *pRect,
+                      uint32_t Row, uint32_t Rows, uint16_t *pOut);
+
+AUDIO_StatusTypeDef DISPLAY_MeterInit(DISPLAY_HandleTypeDef *hdisp, DISPLAY_MeterTypeDef *pMeter,
+                                      const DISPLAY_RectTypeDef *pArea);
+void     DISPLAY_MeterFeed(DISPLAY_MeterTypeDef *pMeter, const float *pSamples, uint32_t Size);
+void     DISPLAY_MeterDraw(DISPLAY_HandleTypeDef *hdisp, DISPLAY_MeterTypeDef *pMeter);
+
+AUDIO_StatusTypeDef DISPLAY_ScopeInit(DISPLAY_HandleTypeDef *hdisp, DISPLAY_ScopeTypeDef *pScope,
+                                      const DISPLAY_RectTypeDef *pArea, uint32_t Decimate);
+void     DISPLAY_ScopeFeed(DISPLAY_ScopeTypeDef *pScope, const float *pSamples, uint32_t Size);
+void     DISPLAY_ScopeDraw(DISPLAY_HandleTypeDef *hdisp, DISPLAY_ScopeTypeDef *pScope);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_DISPLAY_H */
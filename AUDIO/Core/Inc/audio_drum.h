@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    audio_drum.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_drum.c file (sequenced drum machine engine).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_DRUM_H
+#define __AUDIO_DRUM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_seq.h"
+#include "audio_voice.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Drum machine handle structure: one monophonic voice per track
+  */
+typedef struct
+{
+  SEQ_HandleTypeDef   Seq;                             /*!< Transport and pattern playback */
+  VOICE_HandleTypeDef Voices[SEQ_MAX_TRACKS];          /*!< One choke-group voice per track */
+  const VOICE_SourceTypeDef *Samples[SEQ_MAX_TRACKS];  /*!< Sample assigned to each track   */
+  SEQ_EventTypeDef    Events[SEQ_MAX_EVENTS];          /*!< Scratch for the current block   */
+  uint32_t            NextService;                     /*!< Round-robin prefetch cursor     */
+} DRUM_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void DRUM_Init(DRUM_HandleTypeDef *hdrum, const SEQ_PatternTypeDef *pPattern);
+void DRUM_SetSample(DRUM_HandleTypeDef *hdrum, uint32_t Track, const VOICE_SourceTypeDef *pSource);
+void DRUM_Process(DRUM_HandleTypeDef *hdrum, float *pLeft, float *pRight, uint32_t Frames);
+void DRUM_Service(DRUM_HandleTypeDef *hdrum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_DRUM_H */
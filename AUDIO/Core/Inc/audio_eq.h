@@ -0,0 +1,102 @@
+/**
+  ******************************************************************************
+  * @file    audio_eq.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_eq.c file (live parametric equalizer).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_EQ_H
+#define __AUDIO_EQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_biquad.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define EQ_MAX_BANDS              10U
+#define EQ_RAMP_BLOCKS            8U      /*!< Coefficient glide, 10.7 ms at 48 kHz */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Band filter shapes
+  */
+typedef enum
+{
+  EQ_PEAKING   = 0U,
+  EQ_LOWSHELF,
+  EQ_HIGHSHELF,
+  EQ_LOWPASS,
+  EQ_HIGHPASS,
+  EQ_BANDPASS,                /*!< 0 dB at the center frequency                  */
+  EQ_NOTCH
+} EQ_TypeDef;
+
+/**
+  * @brief  Analog to digital mapping
+  */
+typedef enum
+{
+  EQ_DESIGN_RBJ     = 0U,     /*!< Bilinear (RBJ cookbook), cheapest             */
+  EQ_DESIGN_MATCHED           /*!< Matched poles and magnitude, no cramping near
+                                   Nyquist (after Vicanek)                       */
+} EQ_DesignTypeDef;
+
+/**
+  * @brief  User parameters of one band
+  */
+typedef struct
+{
+  EQ_TypeDef Type;
+  float    Freq;              /*!< Center or corner frequency, Hz                */
+  float    Q;
+  float    GainDb;            /*!< Peaking and shelves only                      */
+} EQ_BandTypeDef;
+
+/**
+  * @brief  Equalizer handle structure
+  * @note   EQ_SetBand() runs in the control context: it stores the parameters
+  *         and flags the band. EQ_Process() runs in the audio context and
+  *         redesigns all flagged bands in one batch at the start of the
+  *         block, then glides each section from its current coefficients to
+  *         the new ones over EQ_RAMP_BLOCKS blocks. Linear interpolation of
+  *         two stable sections stays stable (the stability triangle is
+  *         convex).
+  */
+typedef struct
+{
+  EQ_DesignTypeDef Design;
+  uint32_t NumBands;
+  /* Control side */
+  EQ_BandTypeDef Bands[EQ_MAX_BANDS];
+  volatile uint32_t Pending;  /*!< One bit per band edited since the last block  */
+  /* Audio side */
+  BIQUAD_CoeffsTypeDef Coeffs[EQ_MAX_BANDS];  /*!< Coefficients in use           */
+  BIQUAD_CoeffsTypeDef Target[EQ_MAX_BANDS];
+  BIQUAD_CoeffsTypeDef Step[EQ_MAX_BANDS];    /*!< Per-block glide increment     */
+  uint8_t  Ramp[EQ_MAX_BANDS];                /*!< Glide blocks left             */
+  BIQUAD_StateTypeDef State[EQ_MAX_BANDS];
+} EQ_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef EQ_Init(EQ_HandleTypeDef *heq, EQ_DesignTypeDef Design, uint32_t NumBands);
+AUDIO_StatusTypeDef EQ_SetBand(EQ_HandleTypeDef *heq, uint32_t Band, const EQ_BandTypeDef *pBand);
+void EQ_Process(EQ_HandleTypeDef *heq, const float *pIn, float *pOut, uint32_t Frames);
+void EQ_Design(const EQ_BandTypeDef *pBand, EQ_DesignTypeDef Design, BIQUAD_CoeffsTypeDef *pCoeffs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_EQ_H */
@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file    audio_fastmath.h
+  * @brief   Fast approximations of transcendental functions for control-rate
+  *          and coefficient computations (not for audio-rate signal paths
+  *          needing full single precision).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_FASTMATH_H
+#define __AUDIO_FASTMATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define FASTMATH_LOG2_10          3.32192809f
+#define FASTMATH_DB_TO_LOG2       (FASTMATH_LOG2_10 / 20.0f)   /*!< dB (amplitude) to log2 */
+#define FASTMATH_LOG2_TO_DB       (20.0f / FASTMATH_LOG2_10)
+#define FASTMATH_LOG2_E           1.44269504f
+#define FASTMATH_2_OVER_PI        0.636619772f
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Base-2 logarithm, absolute error below 2e-5 (about 0.0001 dB).
+  * @param  x positive argument; 0 and denormals return about -126
+  * @retval log2(x)
+  */
+static inline float FASTMATH_Log2(float x)
+{
+  union { float f; uint32_t i; } v = { x };
+  float e = (float)(int32_t)((v.i >> 23) & 0xFFU) - 127.0f;
+  float m;
+
+  /* Mantissa in [1, 2), polynomial fit of log2 on that interval */
+  v.i = (v.i & 0x007FFFFFU) | 0x3F800000U;
+  m = v.f;
+  return e + ((((0.0439286278f * m - 0.409475586f) * m + 1.61017755f) * m - 3.52021884f) * m
+              + 5.06975632f) * m - 2.79415368f;
+}
+
+/**
+  * @brief  Base-2 exponential, relative error below 4e-6.
+  * @param  x argument, clamped to [-126, 127]
+  * @retval 2^x
+  */
+static inline float FASTMATH_Exp2(float x)
+{
+  union { float f; uint32_t i; } v;
+  float fi;
+  float f;
+  int32_t i;
+
+  x = AUDIO_CLAMP(x, -126.0f, 127.0f);
+  i = (int32_t)x;
+  i -= (x < (float)i) ? 1 : 0;
+  fi = (float)i;
+  f = x - fi;
+
+  /* 2^f on [0, 1), then the integer part goes straight into the exponent */
+  v.f = (((0.0136839829f * f + 0.0517177355f) * f + 0.241621323f) * f + 0.692969551f) * f + 1.0000036f;
+  v.i += (uint32_t)i << 23;
+  return v.f;
+}
+
+/**
+  * @brief  Converts a power ratio to decibels.
+  * @param  x power ratio
+  * @retval 10*log10(x)
+  */
+static inline float FASTMATH_PowerToDb(float x)
+{
+  return FASTMATH_Log2(x) * (0.5f * FASTMATH_LOG2_TO_DB);
+}
+
+/**
+  * @brief  Converts decibels to a linear amplitude gain.
+  * @param  db gain in dB
+  * @retval 10^(db/20)
+  */
+static inline float FASTMATH_DbToGain(float db)
+{
+  return FASTMATH_Exp2(db * FASTMATH_DB_TO_LOG2);
+}
+
+/**
+  * @brief  Natural exponential, relative error below 1e-5.
+  * @param  x argument, clamped to about [-87, 88]
+  * @retval e^x
+  */
+static inline float FASTMATH_Exp(float x)
+{
+  return FASTMATH_Exp2(x * FASTMATH_LOG2_E);
+}
+
+/**
+  * @brief  Sine and cosine of one angle, absolute error below 1e-7.
+  * @note   Meant for angles within a few turns: the quadrant reduction uses
+  *         a two-term pi/2, good to about 1e-7 up to |x| = 100.
+  * @param  x angle in radians
+  * @param  pSin receives sin(x)
+  * @param  pCos receives cos(x)
+  * @retval None
+  */
+static inline void FASTMATH_SinCos(float x, float *pSin, float *pCos)
+{
+  float q = x * FASTMATH_2_OVER_PI;
+  int32_t n = (int32_t)(q + ((q >= 0.0f) ? 0.5f : -0.5f));
+  float r = (x - (float)n * 1.5703125f) - (float)n * 4.83826794897e-4f;
+  float r2 = r * r;
+  float s;
+  float c;
+
+  /* Polynomials on [-pi/4, pi/4], then the quadrant swaps and signs them */
+  s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+  c = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f
+                                    + r2 * 2.443315711809948e-5f));
+  switch ((uint32_t)n & 3U)
+  {
+    case 0U:  *pSin = s;  *pCos = c;  break;
+    case 1U:  *pSin = c;  *pCos = -s; break;
+    case 2U:  *pSin = -s; *pCos = -c; break;
+    default:  *pSin = -c; *pCos = s;  break;
+  }
+}
+
+/**
+  * @brief  Tangent, through FASTMATH_SinCos().
+  * @param  x angle in radians, away from odd multiples of pi/2
+  * @retval tan(x)
+  */
+static inline float FASTMATH_Tan(float x)
+{
+  float s;
+  float c;
+
+  FASTMATH_SinCos(x, &s, &c);
+  return s / c;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_FASTMATH_H */
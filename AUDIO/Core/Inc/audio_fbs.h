@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file    audio_fbs.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_fbs.c file (adaptive feedback suppressor).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_FBS_H
+#define __AUDIO_FBS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_biquad.h"
+#include "audio_fft.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define FBS_FFT_SIZE              1024U   /*!< Analysis frame, 21 ms at 48 kHz    */
+#define FBS_HOP                   512U    /*!< New samples between analyses       */
+#define FBS_RING_SIZE             (2U * FBS_FFT_SIZE)
+#define FBS_MAX_NOTCHES           8U
+#define FBS_NOTCH_Q               30.0f   /*!< About 1/20 octave wide             */
+#define FBS_MAX_DEPTH_DB          (-18.0f)
+#define FBS_STEP_DB               (-3.0f) /*!< Depth added per confirmed howl     */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Detector and release tuning
+  */
+typedef struct
+{
+  float    PaprDb;            /*!< Peak-to-average ratio flagging a howl candidate  */
+  uint8_t  Persistence;       /*!< Consecutive frames a candidate must persist     */
+  float    HoldSeconds;       /*!< Time a notch stays fully deep after last hit    */
+  float    ReleaseDbPerSec;   /*!< Slow release rate once the hold has expired     */
+  float    MinHz;             /*!< Detection band                                  */
+  float    MaxHz;
+} FBS_ConfigTypeDef;
+
+/**
+  * @brief  One notch filter, owned by the background analysis
+  */
+typedef struct
+{
+  uint8_t  Active;
+  float    Freq;
+  float    DepthDb;           /*!< Current cut, negative                          */
+  uint32_t Hold;              /*!< Analysis frames left before release starts     */
+} FBS_NotchTypeDef;
+
+/**
+  * @brief  Feedback suppressor handle structure
+  * @note   FBS_Process() runs in the audio context and only reads the active
+  *         coefficient bank. FBS_Analyze() runs in the background, writes the
+  *         inactive bank and publishes it by flipping ActiveBank.
+  */
+typedef struct
+{
+  FBS_ConfigTypeDef Config;
+  FFT_HandleTypeDef Fft;
+  /* Audio side */
+  BIQUAD_CoeffsTypeDef Bank[2][FBS_MAX_NOTCHES];
+  volatile uint8_t  BankCount[2];
+  volatile uint8_t  ActiveBank;
+  BIQUAD_StateTypeDef State[FBS_MAX_NOTCHES];
+  float    Ring[FBS_RING_SIZE];
+  volatile uint32_t Written;  /*!< Total samples pushed into Ring                 */
+  /* Background side */
+  uint32_t Analyzed;          /*!< Value of Written at the last analysis         */
+  FBS_NotchTypeDef Notches[FBS_MAX_NOTCHES];
+  uint8_t  Persist[FBS_FFT_SIZE / 2U];
+  float    Window[FBS_FFT_SIZE];
+  float    Frame[FBS_FFT_SIZE];
+} FBS_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef FBS_Init(FBS_HandleTypeDef *hfbs, const FBS_ConfigTypeDef *pConfig);
+void     FBS_Process(FBS_HandleTypeDef *hfbs, const float *pIn, float *pOut, uint32_t Frames);
+uint32_t FBS_Analyze(FBS_HandleTypeDef *hfbs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_FBS_H */
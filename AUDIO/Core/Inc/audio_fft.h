@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    audio_fft.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_fft.c file (radix-2 FFT kernels).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_FFT_H
+#define __AUDIO_FFT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+/** @brief Largest real transform length supported */
+#define FFT_MAX_SIZE              1024U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  FFT instance: tables for one transform length
+  */
+typedef struct
+{
+  uint32_t Size;                        /*!< Real transform length N, power of two       */
+  float    Twiddle[FFT_MAX_SIZE];       /*!< cos, sin of 2*pi*k/N for k < N/2            */
+  uint16_t BitRev[FFT_MAX_SIZE / 2U];   /*!< Bit reversal permutation for N/2 points     */
+} FFT_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef FFT_Init(FFT_HandleTypeDef *hfft, uint32_t Size);
+void FFT_Complex(const FFT_HandleTypeDef *hfft, float *pData);
+void FFT_Real(const FFT_HandleTypeDef *hfft, float *pData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_FFT_H */
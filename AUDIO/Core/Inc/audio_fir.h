@@ -0,0 +1,60 @@
+/**
+  ******************************************************************************
+  * @file    audio_fir.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_fir.c file (block FIR filter engine).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_FIR_H
+#define __AUDIO_FIR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported macro ------------------------------------------------------------*/
+/** @brief Number of state words needed by a filter of t taps processing
+  *        n frames per pass */
+#define FIR_STATE_SIZE(t, n)      ((t) + (n) - 1U)
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  FIR filter handle structure
+  * @note   Coefficients are stored in natural order h[0] .. h[NumTaps-1] and
+  *         may be swapped between blocks (e.g. for interpolated responses),
+  *         over one block with FIR_CrossfadeAccumulate() to avoid a click.
+  */
+typedef struct
+{
+  const float *pCoeffs;     /*!< NumTaps coefficients                          */
+  float    *pState;         /*!< FIR_STATE_SIZE(NumTaps, MaxFrames) words      */
+  uint16_t NumTaps;
+  uint16_t MaxFrames;       /*!< Frames per pass, longer blocks are split      */
+} FIR_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void FIR_Init(FIR_HandleTypeDef *hfir, const float *pCoeffs, float *pState,
+              uint16_t NumTaps, uint16_t MaxFrames);
+void FIR_Reset(FIR_HandleTypeDef *hfir);
+void FIR_Process(FIR_HandleTypeDef *hfir, const float *pIn, float *pOut, uint32_t Frames);
+void FIR_ProcessAccumulate(FIR_HandleTypeDef *hfir, const float *pIn, float *pOut, uint32_t Frames);
+void FIR_CrossfadeAccumulate(FIR_HandleTypeDef *hfir, const float *pFrom, const float *pIn,
+                             float *pOut, uint32_t Frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_FIR_H */
@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file    audio_g711.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_g711.c file (G.711 mu-law / A-law codec).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_G711_H
+#define __AUDIO_G711_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define G711_SAMPLE_RATE          8000U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Companding law
+  */
+typedef enum
+{
+  G711_ULAW = 0U,             /*!< North America, Japan                        */
+  G711_ALAW                   /*!< Europe, rest of the world                   */
+} G711_LawTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint8_t G711_EncodeSample(G711_LawTypeDef Law, int16_t Sample);
+int16_t G711_DecodeSample(G711_LawTypeDef Law, uint8_t Code);
+void    G711_Encode(G711_LawTypeDef Law, const float *pIn, uint8_t *pOut, uint32_t Samples);
+void    G711_Decode(G711_LawTypeDef Law, const uint8_t *pIn, float *pOut, uint32_t Samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_G711_H */
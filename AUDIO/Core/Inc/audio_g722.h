@@ -0,0 +1,83 @@
+/**
+  ******************************************************************************
+  * @file    audio_g722.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_g722.c file (G.722 sub-band ADPCM codec).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_G722_H
+#define __AUDIO_G722_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_fir.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define G722_SAMPLE_RATE          16000U
+#define G722_QMF_TAPS             12U     /*!< Per polyphase branch (24 in total) */
+#define G722_MAX_FRAMES           320U    /*!< 20 ms at 16 kHz, larger calls are split */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Bit rate, i.e. number of low band bits kept per code word
+  */
+typedef enum
+{
+  G722_MODE_64K = 8U,
+  G722_MODE_56K = 7U,
+  G722_MODE_48K = 6U
+} G722_ModeTypeDef;
+
+/**
+  * @brief  ADPCM state of one sub-band (pole-zero predictor and scale factor)
+  */
+typedef struct
+{
+  int32_t  s;                 /*!< Signal estimate                             */
+  int32_t  sp;                /*!< Pole section contribution                   */
+  int32_t  sz;                /*!< Zero section contribution                   */
+  int32_t  r[3];              /*!< Reconstructed signal history                */
+  int32_t  a[3];              /*!< Pole coefficients                           */
+  int32_t  p[3];              /*!< Partial reconstruction history              */
+  int32_t  d[7];              /*!< Quantized difference history                */
+  int32_t  b[7];              /*!< Zero coefficients                           */
+  int32_t  nb;                /*!< Log scale factor                            */
+  int32_t  det;               /*!< Scale factor                                */
+} G722_BandTypeDef;
+
+/**
+  * @brief  G.722 handle structure
+  * @note   One handle is either an encoder or a decoder, never both: each
+  *         direction needs its own predictor and QMF history.
+  */
+typedef struct
+{
+  G722_BandTypeDef  Band[2];  /*!< Low and high sub-band                       */
+  FIR_HandleTypeDef Qmf[2];   /*!< QMF polyphase branches                      */
+  float    QmfState[2][FIR_STATE_SIZE(G722_QMF_TAPS, G722_MAX_FRAMES / 2U)];
+  float    Branch[2][G722_MAX_FRAMES / 2U];
+  uint8_t  Bits;
+} G722_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void G722_Init(G722_HandleTypeDef *hg722, G722_ModeTypeDef Mode);
+void G722_Encode(G722_HandleTypeDef *hg722, const float *pIn, uint8_t *pOut, uint32_t Frames);
+void G722_Decode(G722_HandleTypeDef *hg722, const uint8_t *pIn, float *pOut, uint32_t Codes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_G722_H */
@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    audio_irq.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_irq.c file (interrupt priority map, FPU context policy
+  *          and interrupt latency benchmark).
+  *
+  *          The benchmark is built only when AUDIO_IRQ_BENCH is defined to 1
+  *          (project define). It then owns the CAN2 RX1 and SCE vectors,
+  *          which this board does not use, as software-triggered interrupts.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_IRQ_H
+#define __AUDIO_IRQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+#include "audio_trace.h"
+
+/* Exported constants --------------------------------------------------------*/
+#ifndef AUDIO_IRQ_BENCH
+#define AUDIO_IRQ_BENCH           0
+#endif
+
+/** @defgroup IRQ_Priorities Preemption priorities, NVIC_PRIORITYGROUP_4
+  * @brief    On the Cortex-M4, entry takes 12 cycles (plus flash wait states)
+  *           at every level, tail-chaining 6 and a preemption one full entry;
+  *           IRQ_Benchmark() measures the figures of this board. Priority
+  *           therefore only decides who waits: the audio DMA is the one hard
+  *           deadline (one block, 1.33 ms) and preempts everything, control
+  *           inputs come next, bulk transfers after them, and deferred work
+  *           runs last. Level 0 is left free so that critical sections can
+  *           mask everything but the audio path with
+  *           __set_BASEPRI(IRQ_PRIO_CAPTURE << (8U - __NVIC_PRIO_BITS)).
+  *           A handler that uses the FPU pays the lazy context push (17 more
+  *           words) once per preemption of FPU code: keep floating point
+  *           handlers from nesting under each other where possible.
+  * @{
+  */
+#define IRQ_PRIO_AUDIO            1U      /*!< I2S / SAI DMA half and complete  */
+#define IRQ_PRIO_CAPTURE          2U      /*!< ADC control surface DMA, encoders */
+#define IRQ_PRIO_CLOCK            3U      /*!< Clock sync timestamps            */
+#define IRQ_PRIO_USB              5U      /*!< USB device                       */
+#define IRQ_PRIO_SD               7U      /*!< SDIO and its DMA                 */
+#define IRQ_PRIO_DISPLAY          9U      /*!< Display SPI DMA                  */
+#define IRQ_PRIO_SVCALL           14U
+#define IRQ_PRIO_TICK             15U     /*!< Matches TICK_INT_PRIORITY        */
+#define IRQ_PRIO_PENDSV           15U     /*!< Deferred work, always last       */
+/**
+  * @}
+  */
+
+#define IRQ_LEVELS                16U     /*!< Preemption levels, group 4       */
+#define IRQ_BENCH_RUNS            64U     /*!< Samples per measurement          */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  One measurement, in core cycles, measurement overhead removed
+  */
+typedef struct
+{
+  uint32_t Min;
+  uint32_t Max;
+} IRQ_StatTypeDef;
+
+/**
+  * @brief  Benchmark report
+  */
+typedef struct
+{
+  uint32_t CoreClock;                     /*!< Hz                               */
+  uint32_t Overhead;                      /*!< Cycles of one DWT read, removed  */
+  IRQ_StatTypeDef Entry[IRQ_LEVELS];      /*!< Trigger to handler, by priority  */
+  IRQ_StatTypeDef Preempt[IRQ_LEVELS - 1U]; /*!< Trigger from a level 15 handler */
+  IRQ_StatTypeDef TailChain[IRQ_LEVELS];  /*!< Handler exit to next handler     */
+  IRQ_StatTypeDef EntryFpLazy;            /*!< Entry over FPU code, lazy stacking */
+  IRQ_StatTypeDef EntryFpEager;           /*!< Entry over FPU code, full stacking */
+  IRQ_StatTypeDef LazyPush;               /*!< Deferred push, first FPU instruction */
+} IRQ_ReportTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void IRQ_ConfigureFpu(void);
+void IRQ_ConfigurePriorities(void);
+#if (AUDIO_IRQ_BENCH != 0)
+void IRQ_Benchmark(IRQ_ReportTypeDef *pReport);
+void IRQ_WriteReport(const IRQ_ReportTypeDef *pReport, TRACE_WriteTypeDef Write, void *Context);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_IRQ_H */
@@ -0,0 +1,89 @@
+/**
+  ******************************************************************************
+  * @file    audio_knob.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_knob.c file (DMA-scanned potentiometer surface).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_KNOB_H
+#define __AUDIO_KNOB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_async.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define KNOB_MAX                  16U     /*!< ADC1 regular sequence length     */
+#define KNOB_SCAN_RATE            8000U   /*!< Scans per second, TIM3 trigger   */
+#define KNOB_OVERSAMPLE           8U      /*!< Scans averaged per DMA half, 1 ms */
+#define KNOB_FULL_SCALE           65535U  /*!< Reported value range, 0..this    */
+#define KNOB_DEFAULT_DEADBAND     192U    /*!< About 0.3 %, 12 ADC codes        */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  One potentiometer
+  */
+typedef struct
+{
+  uint8_t  Channel;           /*!< ADC1 input 0..15 (PA0-7, PB0-1, PC0-5)      */
+  uint16_t ParamId;           /*!< Event Id pushed to the parameter queue      */
+  uint16_t Deadband;          /*!< Change needed to report, 0 for the default  */
+} KNOB_ConfigTypeDef;
+
+/**
+  * @brief  Filter state of one potentiometer
+  */
+typedef struct
+{
+  uint32_t Smooth;            /*!< Smoothed value, 16.8 fixed point            */
+  uint16_t Reported;          /*!< Last value pushed                           */
+  uint16_t Deadband;
+  uint16_t ParamId;
+  uint8_t  Channel;
+  uint8_t  Pending;           /*!< Report even without a move (start, retry)   */
+} KNOB_StateTypeDef;
+
+/**
+  * @brief  Control surface handle structure
+  * @note   The DMA writes Scan as two halves of KNOB_OVERSAMPLE scans each;
+  *         each half is averaged, smoothed and compared against the value
+  *         last reported while the DMA fills the other one.
+  */
+typedef struct
+{
+  KNOB_StateTypeDef Knobs[KNOB_MAX];
+  uint32_t NumKnobs;
+  uint32_t SmoothShift;       /*!< One-pole smoothing, 0 off, 1 = 1 ms lag ... */
+  ASYNC_QueueTypeDef *pQueue; /*!< Parameter queue, this is its only producer  */
+  uint32_t Overruns;          /*!< Scans lost to a late DMA or a full queue    */
+  uint8_t  Primed;            /*!< Set by the first half, which seeds Smooth   */
+  volatile uint8_t Restart;   /*!< Scan stopped on an error, see KNOB_Poll()   */
+  uint16_t Scan[2U * KNOB_OVERSAMPLE * KNOB_MAX];
+} KNOB_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef KNOB_Init(KNOB_HandleTypeDef *hknob, const KNOB_ConfigTypeDef *pConfig,
+                              uint32_t NumKnobs, ASYNC_QueueTypeDef *pQueue);
+void     KNOB_Start(KNOB_HandleTypeDef *hknob);
+void     KNOB_Stop(void);
+void     KNOB_Poll(KNOB_HandleTypeDef *hknob);
+void     KNOB_Process(KNOB_HandleTypeDef *hknob, const uint16_t *pScan);
+void     KNOB_DmaIRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_KNOB_H */
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    audio_lcd.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_lcd.c file (SPI panel link with DMA region flush).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_LCD_H
+#define __AUDIO_LCD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_async.h"
+#include "audio_display.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LCD_CHUNK_PIXELS          1024U   /*!< Per DMA transfer, two buffers    */
+#define LCD_DEFAULT_FRAME_MS      33U     /*!< 30 frames per second             */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Panel link configuration
+  * @note   SPI1 on PA5 (SCK) and PA7 (MOSI), so knob channels 5 and 7 are
+  *         not available with the display. Reset, data/command and chip
+  *         select are PD12, PD13 and PD14. The command set is the MIPI DCS
+  *         subset shared by the ILI9341 and ST7789 controllers.
+  */
+typedef struct
+{
+  uint32_t FrameMs;           /*!< Frame period cap, 0 for the default         */
+  uint8_t  Prescaler;         /*!< SPI clock = 100 MHz >> (Prescaler + 1)      */
+  uint8_t  Madctl;            /*!< Memory access control, panel orientation    */
+  uint8_t  Invert;            /*!< Display inversion on (most ST7789 panels)   */
+  /* Draws the frame (meters, scope...) into the framebuffer, background */
+  void   (*Render)(void *Context);
+  void    *Context;
+} LCD_ConfigTypeDef;
+
+/**
+  * @brief  Panel link handle structure
+  */
+typedef struct
+{
+  LCD_ConfigTypeDef Config;
+  DISPLAY_HandleTypeDef *hdisp;
+  ASYNC_SignalTypeDef DmaDone;      /*!< Posted by the DMA interrupt            */
+  uint16_t Chunk[2][LCD_CHUNK_PIXELS];
+  uint32_t Frames;
+  uint32_t Regions;                 /*!< Rectangles sent                        */
+  uint32_t Pixels;                  /*!< Pixels sent, full frames included      */
+  uint32_t Late;                    /*!< Frames that overran the period         */
+  uint32_t Errors;                  /*!< DMA transfer errors                    */
+} LCD_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef LCD_Init(LCD_HandleTypeDef *hlcd, const LCD_ConfigTypeDef *pConfig,
+                             DISPLAY_HandleTypeDef *hdisp);
+AUDIO_StatusTypeDef LCD_Start(LCD_HandleTypeDef *hlcd, ASYNC_HandleTypeDef *hasync);
+void     LCD_DmaIRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_LCD_H */
@@ -0,0 +1,148 @@
+/**
+  ******************************************************************************
+  * @file    audio_library.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_library.c file (SD sample library index).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_LIBRARY_H
+#define __AUDIO_LIBRARY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LIBRARY_MAGIC             0x58444953U   /*!< "SIDX"                     */
+#define LIBRARY_VERSION           2U
+#define LIBRARY_SECTOR_SIZE       512U
+#define LIBRARY_NO_LOOP           0xFFFFFFFFU
+#define LIBRARY_HASH_ID           0x80000000U   /*!< Set on name-hashed Ids     */
+#define LIBRARY_MAX_DEPTH         8U      /*!< Directory levels walked          */
+#define LIBRARY_PATH_MAX          128U
+
+/**
+  * @brief  Sample encodings
+  */
+#define LIBRARY_FORMAT_PCM16      1U
+#define LIBRARY_FORMAT_PCM24      2U
+#define LIBRARY_FORMAT_FLOAT32    3U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Index file header, little endian, followed by NumRuns runs, then
+  *         NumEntries entries sorted by Id
+  */
+typedef struct
+{
+  uint32_t Magic;
+  uint16_t Version;
+  uint16_t EntrySize;         /*!< sizeof(LIBRARY_EntryTypeDef)                */
+  uint32_t NumEntries;
+  uint32_t NumRuns;
+  uint32_t VolumeId;          /*!< FAT volume serial: a new card, a new index  */
+  uint32_t DirCrc;            /*!< CRC-32 of the directory entries walked      */
+  uint32_t DataLba;           /*!< Card sector of cluster 2                    */
+  uint32_t ClusterSectors;
+  uint32_t Crc;               /*!< CRC-32 of the runs and entries              */
+} LIBRARY_HeaderTypeDef;
+
+/**
+  * @brief  One sample file
+  * @note   Id is the decimal prefix of the file name ("0042 Kick.wav" is 42),
+  *         or LIBRARY_HashName() of its path when it has none.
+  */
+typedef struct
+{
+  uint32_t Id;
+  uint32_t FirstRun;          /*!< Index of the first run of the file          */
+  uint32_t DataOffset;        /*!< File offset of the first sample, bytes      */
+  uint32_t Frames;
+  uint32_t LoopStart;         /*!< Frame, LIBRARY_NO_LOOP without a loop       */
+  uint32_t LoopEnd;           /*!< Frame after the last one of the loop        */
+  uint16_t NumRuns;
+  uint8_t  Channels;
+  uint8_t  Format;            /*!< LIBRARY_FORMAT_x                            */
+  uint32_t Rate;
+} LIBRARY_EntryTypeDef;
+
+/**
+  * @brief  Contiguous clusters of a file
+  */
+typedef struct
+{
+  uint32_t Cluster;
+  uint32_t Count;
+} LIBRARY_RunTypeDef;
+
+/**
+  * @brief  Loaded index, pointing into the index image in RAM
+  */
+typedef struct
+{
+  const LIBRARY_HeaderTypeDef *pHeader;
+  const LIBRARY_EntryTypeDef  *pEntries;
+  const LIBRARY_RunTypeDef    *pRuns;
+} LIBRARY_HandleTypeDef;
+
+/**
+  * @brief  Index builder: a FAT16/FAT32 walk through a sector reader
+  * @note   Read fetches one LIBRARY_SECTOR_SIZE sector at a card LBA. The
+  *         builder keeps its buffers here, so the walk needs no large stack.
+  */
+typedef struct
+{
+  AUDIO_StatusTypeDef (*Read)(void *Context, uint32_t Lba, uint8_t *pDst);
+  void    *Context;
+  /* Scratch, set up by LIBRARY_Build() */
+  uint32_t VolumeLba;
+  uint32_t FatLba;
+  uint32_t DataLba;
+  uint32_t RootLba;           /*!< FAT16 fixed root, 0 on FAT32                */
+  uint32_t RootSectors;
+  uint32_t RootCluster;
+  uint32_t ClusterSectors;
+  uint32_t Clusters;
+  uint8_t  Fat32;
+  uint32_t CachedFat;         /*!< Sector in FatCache, 0 for none              */
+  uint8_t  FatCache[LIBRARY_SECTOR_SIZE];
+  uint8_t  Sector[LIBRARY_SECTOR_SIZE];
+  char     Path[LIBRARY_PATH_MAX];
+  char     Name[LIBRARY_PATH_MAX];
+  uint8_t *pOut;
+  uint32_t OutSize;
+  uint32_t NumEntries;        /*!< Growing down from the end of pOut           */
+  uint32_t NumRuns;           /*!< Growing up from the header                  */
+  uint32_t DirCrc;            /*!< Of the directory entries walked so far      */
+  uint8_t  Scanning;          /*!< Directories only, for LIBRARY_Check()       */
+  uint32_t Skipped;           /*!< WAV files that could not be indexed         */
+  uint32_t Duplicates;        /*!< Files dropped for an Id already taken       */
+} LIBRARY_BuilderTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef LIBRARY_Load(LIBRARY_HandleTypeDef *hlib, const void *pImage, uint32_t Size);
+const LIBRARY_EntryTypeDef *LIBRARY_Find(const LIBRARY_HandleTypeDef *hlib, uint32_t Id);
+uint32_t LIBRARY_Locate(const LIBRARY_HandleTypeDef *hlib, const LIBRARY_EntryTypeDef *pEntry,
+                        uint32_t Offset, uint32_t *pLba);
+uint32_t LIBRARY_HashName(const char *pPath);
+AUDIO_StatusTypeDef LIBRARY_Build(LIBRARY_BuilderTypeDef *pBuilder, uint8_t *pOut, uint32_t OutSize,
+                                  uint32_t *pSize);
+AUDIO_StatusTypeDef LIBRARY_Check(LIBRARY_BuilderTypeDef *pBuilder, const LIBRARY_HandleTypeDef *hlib);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_LIBRARY_H */
@@ -0,0 +1,150 @@
+/**
+  ******************************************************************************
+  * @file    audio_looper.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_looper.c file (multi-track looper).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_LOOPER_H
+#define __AUDIO_LOOPER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+#include "audio_adpcm.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LOOPER_MAX_TRACKS         4U      /*!< Tracks per looper                             */
+#define LOOPER_BLOCK_FRAMES       256U    /*!< Storage granularity, also the undo granularity */
+#define LOOPER_XFADE_FRAMES       128U    /*!< Loop point crossfade, <= LOOPER_BLOCK_FRAMES  */
+#define LOOPER_MAX_UNDO_BLOCKS    512U    /*!< Upper bound of the undo scratch pool          */
+
+#define LOOPER_RAW_BLOCK_BYTES    (LOOPER_BLOCK_FRAMES * sizeof(int16_t))
+#define LOOPER_ADPCM_BLOCK_BYTES  ADPCM_BLOCK_SIZE(LOOPER_BLOCK_FRAMES)
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Loop storage format
+  */
+typedef enum
+{
+  LOOPER_FORMAT_RAW16 = 0x00U,  /*!< 16-bit PCM, 512 bytes per block           */
+  LOOPER_FORMAT_ADPCM = 0x01U   /*!< IMA ADPCM, 132 bytes per block (~3.9x)    */
+} LOOPER_FormatTypeDef;
+
+/**
+  * @brief  Track state
+  */
+typedef enum
+{
+  LOOPER_STATE_EMPTY     = 0x00U,
+  LOOPER_STATE_RECORDING = 0x01U,
+  LOOPER_STATE_PLAYING   = 0x02U,
+  LOOPER_STATE_OVERDUB   = 0x03U,   /*!< Input is added to the loop            */
+  LOOPER_STATE_REPLACE   = 0x04U,   /*!< Input replaces the loop               */
+  LOOPER_STATE_MULTIPLY  = 0x05U,   /*!< Loop grows by whole base lengths      */
+  LOOPER_STATE_STOPPED   = 0x06U
+} LOOPER_StateTypeDef;
+
+/**
+  * @brief  Actions requested by the user, executed on the next quantum boundary
+  */
+typedef enum
+{
+  LOOPER_ACTION_NONE     = 0x00U,
+  LOOPER_ACTION_RECORD   = 0x01U,   /*!< Start recording, or close the loop    */
+  LOOPER_ACTION_OVERDUB  = 0x02U,   /*!< Toggle overdub                        */
+  LOOPER_ACTION_REPLACE  = 0x03U,   /*!< Toggle replace                        */
+  LOOPER_ACTION_MULTIPLY = 0x04U,   /*!< Toggle multiply                       */
+  LOOPER_ACTION_PLAY     = 0x05U,   /*!< Restart playback from the loop start  */
+  LOOPER_ACTION_STOP     = 0x06U,
+  LOOPER_ACTION_UNDO     = 0x07U,   /*!< Revert the last pass of this track    */
+  LOOPER_ACTION_CLEAR    = 0x08U
+} LOOPER_ActionTypeDef;
+
+/**
+  * @brief  Memory layout, fixed at initialization
+  * @note   The undo scratch pool is taken from the internal region first,
+  *         the remaining blocks of both regions are split evenly across
+  *         the tracks. LOOPER_GetMaxLength() gives the resulting limit.
+  */
+typedef struct
+{
+  uint8_t  NumTracks;               /*!< 1 .. LOOPER_MAX_TRACKS                */
+  LOOPER_FormatTypeDef Format;
+  uint8_t  *pInternal;              /*!< Internal SRAM region                  */
+  uint32_t InternalSize;            /*!< Size in bytes                         */
+  uint8_t  *pExternal;              /*!< Optional external RAM, or NULL        */
+  uint32_t ExternalSize;            /*!< Size in bytes                         */
+  uint32_t UndoBlocks;              /*!< Scratch blocks, <= LOOPER_MAX_UNDO_BLOCKS */
+} LOOPER_ConfigTypeDef;
+
+/**
+  * @brief  Track structure
+  */
+typedef struct
+{
+  LOOPER_StateTypeDef  State;
+  LOOPER_ActionTypeDef Pending;     /*!< Action waiting for the quantum boundary  */
+  uint8_t  Closing;                 /*!< Multiply finishing its last cycle         */
+  uint8_t  BaseSaved;               /*!< Multiply base held by the undo pool       */
+  uint32_t Length;                  /*!< Loop length in frames                     */
+  uint32_t BaseLength;              /*!< Length before the multiply pass           */
+  uint32_t Position;                /*!< Play/record head in frames                */
+  float    Level;                   /*!< Playback gain                             */
+  int32_t  ReadBlock;               /*!< Block decoded in ReadCache, -1 if none,
+                                         -2 - block for its undo copy              */
+  int32_t  WriteBlock;              /*!< Block held in WriteCache, -1 if none      */
+  uint8_t  WriteDirty;
+  int16_t  ReadCache[LOOPER_BLOCK_FRAMES];
+  int16_t  WriteCache[LOOPER_BLOCK_FRAMES];
+  int16_t  Tail[LOOPER_XFADE_FRAMES];  /*!< Input captured past the loop end   */
+  uint32_t TailCount;
+} LOOPER_TrackTypeDef;
+
+/**
+  * @brief  Looper handle structure
+  */
+typedef struct
+{
+  LOOPER_ConfigTypeDef Config;
+  LOOPER_TrackTypeDef  Tracks[LOOPER_MAX_TRACKS];
+  uint32_t BlockBytes;              /*!< Encoded size of one storage block        */
+  uint32_t BlocksPerTrack;
+  uint32_t InternalBlocks;          /*!< Track blocks living in internal RAM      */
+  uint8_t  *pTrackInternal;         /*!< First track block in internal RAM        */
+  uint8_t  *pScratch;               /*!< Undo scratch pool                        */
+  uint32_t Quantum;                 /*!< Action grid in frames, 0 for immediate   */
+  uint32_t Frame;                   /*!< Running frame counter                    */
+  /* One level of undo, shared by all tracks */
+  uint8_t  UndoValid;
+  uint8_t  UndoTrack;
+  uint32_t UndoLength;              /*!< Track length before the pass             */
+  uint32_t UndoCount;               /*!< Blocks saved in the scratch pool         */
+  uint16_t UndoMap[LOOPER_MAX_UNDO_BLOCKS]; /*!< Track block of each scratch slot */
+} LOOPER_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef LOOPER_Init(LOOPER_HandleTypeDef *hlooper, const LOOPER_ConfigTypeDef *pConfig);
+uint32_t LOOPER_GetMaxLength(const LOOPER_ConfigTypeDef *pConfig);
+void     LOOPER_SetQuantum(LOOPER_HandleTypeDef *hlooper, uint32_t Frames);
+void     LOOPER_Request(LOOPER_HandleTypeDef *hlooper, uint32_t Track, LOOPER_ActionTypeDef Action);
+void     LOOPER_Process(LOOPER_HandleTypeDef *hlooper, const float *pIn, float *pOut, uint32_t Frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_LOOPER_H */
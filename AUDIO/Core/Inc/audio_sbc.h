@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    audio_sbc.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_sbc.c file (Bluetooth SBC encoder).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_SBC_H
+#define __AUDIO_SBC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define SBC_MAX_SUBBANDS          8U
+#define SBC_MAX_BLOCKS            16U
+#define SBC_MAX_CHANNELS          2U
+#define SBC_MAX_BITPOOL           250U    /*!< A2DP limit                         */
+/** @brief Largest frame: 8 subbands, 16 blocks, joint stereo at bitpool 250 */
+#define SBC_MAX_FRAME_SIZE        513U
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  SBC_FREQ_16000 = 0U,
+  SBC_FREQ_32000,
+  SBC_FREQ_44100,
+  SBC_FREQ_48000
+} SBC_FrequencyTypeDef;
+
+typedef enum
+{
+  SBC_MODE_MONO = 0U,
+  SBC_MODE_DUAL_CHANNEL,
+  SBC_MODE_STEREO,
+  SBC_MODE_JOINT_STEREO
+} SBC_ModeTypeDef;
+
+typedef enum
+{
+  SBC_ALLOC_LOUDNESS = 0U,
+  SBC_ALLOC_SNR
+} SBC_AllocationTypeDef;
+
+/**
+  * @brief  Stream parameters, as negotiated over A2DP
+  */
+typedef struct
+{
+  SBC_FrequencyTypeDef  Frequency;
+  SBC_ModeTypeDef       Mode;
+  SBC_AllocationTypeDef Allocation;
+  uint8_t  Blocks;            /*!< 4, 8, 12 or 16                               */
+  uint8_t  Subbands;          /*!< 4 or 8                                       */
+  uint8_t  Bitpool;           /*!< 2 .. SBC_MAX_BITPOOL, and 16 x Subbands per channel */
+} SBC_ConfigTypeDef;
+
+/**
+  * @brief  SBC encoder handle structure
+  */
+typedef struct
+{
+  SBC_ConfigTypeDef Config;
+  uint8_t  Channels;
+  uint8_t  Header;            /*!< Second header byte                           */
+  uint16_t FrameSize;         /*!< Encoded frame length in bytes                */
+  /* Analysis filter bank */
+  float    History[SBC_MAX_CHANNELS][2U * 10U * SBC_MAX_SUBBANDS];
+  uint16_t Position[SBC_MAX_CHANNELS];
+  float    Matrix[SBC_MAX_SUBBANDS][2U * SBC_MAX_SUBBANDS];
+  /* Per frame */
+  float    Samples[SBC_MAX_BLOCKS][SBC_MAX_CHANNELS][SBC_MAX_SUBBANDS];
+  uint8_t  ScaleFactor[SBC_MAX_CHANNELS][SBC_MAX_SUBBANDS];
+  uint8_t  Bits[SBC_MAX_CHANNELS][SBC_MAX_SUBBANDS];
+} SBC_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef SBC_Init(SBC_HandleTypeDef *hsbc, const SBC_ConfigTypeDef *pConfig);
+uint32_t SBC_GetFrameSamples(const SBC_HandleTypeDef *hsbc);
+uint32_t SBC_GetFrameSize(const SBC_HandleTypeDef *hsbc);
+uint32_t SBC_Encode(SBC_HandleTypeDef *hsbc, const float *pLeft, const float *pRight, uint8_t *pOut);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_SBC_H */
@@ -0,0 +1,140 @@
+/**
+  ******************************************************************************
+  * @file    audio_seq.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_seq.c file (sample-accurate step sequencer).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_SEQ_H
+#define __AUDIO_SEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define SEQ_MAX_TRACKS            8U      /*!< Tracks per pattern                     */
+#define SEQ_MAX_STEPS             64U     /*!< Steps per track                        */
+#define SEQ_MAX_LOCKS             4U      /*!< Parameter locks per step               */
+#define SEQ_MAX_EVENTS            (SEQ_MAX_TRACKS * 4U) /*!< Events per block         */
+#define SEQ_STEPS_PER_BEAT        4U      /*!< Sixteenth-note grid                    */
+#define SEQ_MIDI_PPQN             24U     /*!< MIDI clock ticks per quarter note      */
+
+/** @defgroup SEQ_Param Lockable track parameters
+  * @{
+  */
+#define SEQ_PARAM_LEVEL           0U      /*!< Q15 gain, 0 .. 32767                   */
+#define SEQ_PARAM_PAN             1U      /*!< Q15 pan, -32768 (L) .. 32767 (R)       */
+#define SEQ_PARAM_PITCH           2U      /*!< Transposition in cents                 */
+#define SEQ_PARAM_DECAY           3U      /*!< Decay time in ms, 0 for none           */
+#define SEQ_PARAM_START           4U      /*!< Start offset in 1/32768 of the length  */
+#define SEQ_PARAM_COUNT           5U
+/**
+  * @}
+  */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Clock source of the transport
+  */
+typedef enum
+{
+  SEQ_CLOCK_INTERNAL = 0x00U,   /*!< Derived from the audio sample counter */
+  SEQ_CLOCK_MIDI     = 0x01U    /*!< Phase-locked to incoming MIDI clock   */
+} SEQ_ClockTypeDef;
+
+/**
+  * @brief  Parameter lock: overrides one track parameter for a single step
+  */
+typedef struct
+{
+  uint8_t  Param;               /*!< One of @ref SEQ_Param */
+  int16_t  Value;               /*!< Value in the units of the parameter */
+} SEQ_LockTypeDef;
+
+/**
+  * @brief  One step of one track
+  */
+typedef struct
+{
+  uint8_t  Active;              /*!< Non-zero when the step triggers        */
+  uint8_t  Velocity;            /*!< 1 .. 127                               */
+  uint8_t  NumLocks;            /*!< Number of valid entries in Locks       */
+  SEQ_LockTypeDef Locks[SEQ_MAX_LOCKS];
+} SEQ_StepTypeDef;
+
+/**
+  * @brief  Pattern: a grid of steps and the default parameters of each track
+  */
+typedef struct
+{
+  SEQ_StepTypeDef Steps[SEQ_MAX_TRACKS][SEQ_MAX_STEPS];
+  int16_t  Params[SEQ_MAX_TRACKS][SEQ_PARAM_COUNT];
+  uint8_t  Length;              /*!< Pattern length in steps, 1 .. SEQ_MAX_STEPS */
+} SEQ_PatternTypeDef;
+
+/**
+  * @brief  Trigger produced for the current block
+  */
+typedef struct
+{
+  uint32_t Offset;              /*!< Frame offset inside the block               */
+  uint8_t  Track;               /*!< Track index                                 */
+  uint8_t  Velocity;            /*!< Step velocity                               */
+  int16_t  Params[SEQ_PARAM_COUNT]; /*!< Track parameters with locks applied     */
+} SEQ_EventTypeDef;
+
+/**
+  * @brief  Sequencer handle structure
+  * @note   All times are sample positions from Origin in 32.32 fixed point.
+  *         Step n starts at Anchor + (n - AnchorStep) * StepLength (plus swing
+  *         on odd steps), so positions never accumulate rounding error.
+  *         SEQ_Process() moves Origin and the anchor forward every few hours
+  *         so that positions and step counts stay far from overflow.
+  */
+typedef struct
+{
+  const SEQ_PatternTypeDef *Pattern;
+  SEQ_ClockTypeDef Clock;
+  uint8_t  Running;
+  uint8_t  Swing;               /*!< 50 (straight) .. 75 percent                  */
+  uint32_t TempoX100;           /*!< Internal tempo in BPM * 100                  */
+  uint64_t Now;                 /*!< Sample index of the first frame of the block */
+  uint64_t Origin;              /*!< Sample index positions count from            */
+  uint64_t StepLength;          /*!< Samples per step, 32.32                      */
+  uint64_t Anchor;              /*!< Position of AnchorStep, 32.32                */
+  uint32_t AnchorStep;          /*!< Step index the timeline is anchored to      */
+  uint32_t NextStep;            /*!< Next step to be triggered                    */
+  uint64_t LastTick;            /*!< Sample index of the previous MIDI clock tick */
+  uint32_t TickCount;           /*!< MIDI clock ticks since start                 */
+} SEQ_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void     SEQ_Init(SEQ_HandleTypeDef *hseq, const SEQ_PatternTypeDef *pPattern);
+void     SEQ_SetTempo(SEQ_HandleTypeDef *hseq, uint32_t TempoX100);
+void     SEQ_SetSwing(SEQ_HandleTypeDef *hseq, uint8_t Swing);
+void     SEQ_SetClock(SEQ_HandleTypeDef *hseq, SEQ_ClockTypeDef Clock);
+void     SEQ_Start(SEQ_HandleTypeDef *hseq, uint32_t Offset);
+void     SEQ_Stop(SEQ_HandleTypeDef *hseq);
+void     SEQ_MidiClockTick(SEQ_HandleTypeDef *hseq, uint64_t Timestamp);
+uint32_t SEQ_Process(SEQ_HandleTypeDef *hseq, uint32_t Frames, SEQ_EventTypeDef *pEvents,
+                     uint32_t MaxEvents);
+uint64_t SEQ_StepTime(const SEQ_HandleTypeDef *hseq, uint32_t Step);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_SEQ_H */
@@ -0,0 +1,98 @@
+/**
+  ******************************************************************************
+  * @file    audio_spatial.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_spatial.c file (binaural HRTF spatializer).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_SPATIAL_H
+#define __AUDIO_SPATIAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_fir.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define SPATIAL_MAX_SOURCES       8U
+#define SPATIAL_MAX_TAPS          32U     /*!< Minimum-phase HRIR length            */
+#define SPATIAL_MAX_ITD           48U     /*!< Largest interaural delay in samples  */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  HRTF set, normally placed in flash.
+  * @note   Measurements lie on a regular grid: azimuth a = i * 360 / NumAzimuth
+  *         degrees clockwise from the front, elevation e = ElevationMin +
+  *         j * ElevationStep degrees. The minimum-phase responses are stored as
+  *         pFilters[((j * NumAzimuth) + i) * 2 + ear][tap] with ear 0 = left,
+  *         and the ITD removed from them is given in samples by pItd[j * NumAzimuth + i],
+  *         positive when the left ear hears the source later.
+  */
+typedef struct
+{
+  const float *pFilters;
+  const float *pItd;
+  uint16_t NumAzimuth;
+  uint16_t NumElevation;
+  uint16_t NumTaps;         /*!< <= SPATIAL_MAX_TAPS */
+  float    ElevationMin;
+  float    ElevationStep;
+} SPATIAL_HrtfSetTypeDef;
+
+/**
+  * @brief  One positioned mono source
+  */
+typedef struct
+{
+  uint8_t  Active;
+  uint8_t  Dirty;                                         /*!< Position changed      */
+  float    Azimuth;                                       /*!< Degrees, clockwise    */
+  float    Elevation;                                     /*!< Degrees, up positive  */
+  float    Gain;                                          /*!< Distance attenuation  */
+  float    Itd;                                           /*!< Current ITD, samples  */
+  float    ItdTarget;
+  uint8_t  Bank;                                          /*!< Coeffs in use         */
+  uint8_t  Fading;                                        /*!< Coeffs just swapped   */
+  float    Coeffs[2][2][SPATIAL_MAX_TAPS];                /*!< Interpolated HRIRs:
+                                                               bank, ear, tap      */
+  FIR_HandleTypeDef Fir[2];
+  float    FirState[2][FIR_STATE_SIZE(SPATIAL_MAX_TAPS, AUDIO_BLOCK_SIZE)];
+  float    Delay[SPATIAL_MAX_ITD + 3U + AUDIO_BLOCK_SIZE];  /*!< ITD delay line      */
+} SPATIAL_SourceTypeDef;
+
+/**
+  * @brief  Spatializer handle structure
+  */
+typedef struct
+{
+  const SPATIAL_HrtfSetTypeDef *pSet;
+  SPATIAL_SourceTypeDef Sources[SPATIAL_MAX_SOURCES];
+  float    EarIn[2][AUDIO_BLOCK_SIZE];   /*!< Delayed source signal per ear */
+} SPATIAL_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef SPATIAL_Init(SPATIAL_HandleTypeDef *hspat, const SPATIAL_HrtfSetTypeDef *pSet);
+void SPATIAL_SetSource(SPATIAL_HandleTypeDef *hspat, uint32_t Source, float Azimuth,
+                       float Elevation, float Distance);
+void SPATIAL_EnableSource(SPATIAL_HandleTypeDef *hspat, uint32_t Source, uint8_t Enable);
+void SPATIAL_Interpolate(const SPATIAL_HrtfSetTypeDef *pSet, float Azimuth, float Elevation,
+                         float *pLeft, float *pRight, float *pItd);
+void SPATIAL_Process(SPATIAL_HandleTypeDef *hspat, const float * const *ppIn,
+                     float *pLeft, float *pRight, uint32_t Frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_SPATIAL_H */
@@ -0,0 +1,122 @@
+/**
+  ******************************************************************************
+  * @file    audio_stream.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_stream.c file (SD sample streaming scheduler).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_STREAM_H
+#define __AUDIO_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+#include "audio_library.h"
+#include "audio_voice.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define STREAM_MAX_VOICES         16U
+#define STREAM_MAX_SAMPLES        64U
+#define STREAM_MAX_SECTORS        16U     /*!< Largest merged read, 8 KB        */
+#define STREAM_NO_DEADLINE        0xFFFFFFFFU
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Card access
+  * @note   Read starts a multi-block read of Count sectors and returns; the
+  *         driver calls STREAM_ReadComplete() when the data is in pDst, from
+  *         its interrupt or from Read itself. One read is in flight at most.
+  *         SlackUs is how long the neediest voice it serves can wait for it,
+  *         STREAM_NO_DEADLINE for a head preload. Expect, if set, is told
+  *         at each poll how soon any streaming voice will need the card, for
+  *         a scheduler sharing the card with writers.
+  */
+typedef struct
+{
+  AUDIO_StatusTypeDef (*Read)(void *Context, uint32_t Lba, uint32_t Count, uint8_t *pDst,
+                              uint32_t SlackUs);
+  void   (*Expect)(void *Context, uint32_t SlackUs);
+  void    *Context;
+} STREAM_ConfigTypeDef;
+
+/**
+  * @brief  One streamed sample: a mono 16-bit library entry with a RAM head
+  * @note   Source is what VOICE_Trigger() plays. Its head is published once
+  *         fully read: a voice triggered earlier streams from the card from
+  *         its start, late but without garbage.
+  */
+typedef struct
+{
+  VOICE_SourceTypeDef Source;
+  const LIBRARY_EntryTypeDef *pEntry;
+  int16_t *pHead;             /*!< RAM for the first HeadLength samples        */
+  uint32_t HeadLength;
+  uint32_t Loaded;            /*!< Head samples read so far                    */
+} STREAM_SampleTypeDef;
+
+/**
+  * @brief  Destination of part of a read
+  */
+typedef struct
+{
+  VOICE_HandleTypeDef *pVoice;      /*!< NULL for a head preload                */
+  STREAM_SampleTypeDef *pSample;
+  uint32_t Generation;              /*!< Trigger the data was read for          */
+  uint32_t Position;                /*!< Sample index of the first sample       */
+  uint32_t Offset;                  /*!< Its byte in Stage                      */
+  uint32_t Count;                   /*!< Samples                                */
+} STREAM_TargetTypeDef;
+
+/**
+  * @brief  Streaming scheduler handle structure
+  */
+typedef struct
+{
+  STREAM_ConfigTypeDef Config;
+  const LIBRARY_HandleTypeDef *hlib;
+  VOICE_HandleTypeDef *pVoices;
+  uint32_t NumVoices;
+  STREAM_SampleTypeDef *pSamples[STREAM_MAX_SAMPLES];
+  uint32_t NumSamples;
+  uint32_t Stage[(STREAM_MAX_SECTORS * LIBRARY_SECTOR_SIZE) / 4U];
+  STREAM_TargetTypeDef Targets[STREAM_MAX_VOICES + 1U];
+  uint32_t NumTargets;
+  uint32_t Lba;                     /*!< Read in flight                         */
+  uint32_t Sectors;
+  volatile uint8_t Busy;
+  volatile uint8_t Done;
+  volatile AUDIO_StatusTypeDef Result;
+  uint32_t Requests;
+  uint32_t Merged;                  /*!< Voices served by another voice's read  */
+  uint32_t SectorsRead;
+  uint32_t Errors;
+  uint32_t MinSlack;                /*!< Fewest frames a voice had left at issue */
+} STREAM_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef STREAM_Init(STREAM_HandleTypeDef *hstream, const STREAM_ConfigTypeDef *pConfig,
+                                const LIBRARY_HandleTypeDef *hlib, VOICE_HandleTypeDef *pVoices,
+                                uint32_t NumVoices);
+AUDIO_StatusTypeDef STREAM_AddSample(STREAM_HandleTypeDef *hstream, STREAM_SampleTypeDef *pSample,
+                                     uint32_t Id, int16_t *pHead, uint32_t HeadLength);
+void     STREAM_Poll(STREAM_HandleTypeDef *hstream);
+void     STREAM_ReadComplete(STREAM_HandleTypeDef *hstream, AUDIO_StatusTypeDef Status);
+uint8_t  STREAM_IsPreloaded(const STREAM_HandleTypeDef *hstream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_STREAM_H */
@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * @file    audio_sync.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_sync.c file (multi-board sample timeline sync).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_SYNC_H
+#define __AUDIO_SYNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define SYNC_DELAY_WINDOW         8U      /*!< Exchanges in the min-delay filter */
+#define SYNC_ONE                  (1ULL << 32)   /*!< One frame, Q32.32        */
+#define SYNC_BROADCAST            0xFFFFU
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Message types, in exchange order
+  */
+typedef enum
+{
+  SYNC_MSG_SYNC       = 0x01U,  /*!< Master to slave, stamped on transmit    */
+  SYNC_MSG_FOLLOW_UP  = 0x02U,  /*!< Master to slave, carries t1            */
+  SYNC_MSG_DELAY_REQ  = 0x03U,  /*!< Slave to master, stamped on transmit   */
+  SYNC_MSG_DELAY_RESP = 0x04U   /*!< Master to slave, carries t4            */
+} SYNC_MsgTypeDef;
+
+/**
+  * @brief  Message, 16 bytes on the wire (little endian, as laid out)
+  * @note   On CAN the type, sequence and node go in the identifier and Time
+  *         fills the 8-byte payload.
+  */
+typedef struct
+{
+  uint8_t  Type;              /*!< SYNC_MsgTypeDef                              */
+  uint8_t  Seq;               /*!< Exchange number, echoed by every reply       */
+  uint16_t Node;              /*!< Sender                                       */
+  uint16_t To;                /*!< Receiver, SYNC_BROADCAST from a master       */
+  uint16_t Reserved;
+  uint64_t Time;              /*!< Timeline position, Q32.32 frames             */
+} SYNC_MessageTypeDef;
+
+/**
+  * @brief  Sync tuning
+  * @note   Defaults from SYNC_Init when left 0: Kp 0.3, Ki 0.05, MaxPpm 200,
+  *         StepFrames 16, DelayTolerance 0.05 frames (1 us).
+  */
+typedef struct
+{
+  uint16_t Node;              /*!< This board                                   */
+  uint16_t Master;            /*!< Upstream board, Node itself on the master    */
+  uint32_t TickRate;          /*!< Capture timer clock, Hz                      */
+  float    IntervalSec;       /*!< Time between two exchanges                   */
+  float    Kp;                /*!< Servo gains, per exchange                    */
+  float    Ki;
+  float    MaxPpm;            /*!< Trim range, covers the crystal tolerance     */
+  float    StepFrames;        /*!< Offset fixed by a jump rather than a slew    */
+  float    DelayTolerance;    /*!< Exchanges slower than the fastest recent one
+                                   by more than this are not used, frames        */
+  /* Audio clock trim: fractional PLL, ASRC ratio or codec PLL */
+  void   (*SetTrim)(void *Context, float Ppm);
+  void    *Context;
+} SYNC_ConfigTypeDef;
+
+/**
+  * @brief  Sync handle structure
+  * @note   The board timeline is its audio frame count plus Step. The audio
+  *         interrupt stamps each block with the capture timer, so a message
+  *         captured by the timer at any instant is placed on the timeline to
+  *         a fraction of a frame. Stamp is written by the audio interrupt
+  *         only, under the StampSeq sequence counter; everything else runs in
+  *         the clock interrupt or the background.
+  */
+typedef struct
+{
+  SYNC_ConfigTypeDef Config;
+  volatile uint32_t StampSeq;       /*!< Odd while the audio stamp is written   */
+  volatile uint32_t StampTick;
+  volatile uint32_t StampFrames;
+  uint64_t FramesPerTick;           /*!< Q32.32                                 */
+  uint64_t Step;                    /*!< Timeline minus frame count, Q32.32     */
+  /* Slave exchange in progress */
+  uint8_t  Seq;
+  uint8_t  Have;                    /*!< Bit n set once t(n+1) is known         */
+  uint64_t T[4];
+  /* Servo */
+  float    DelayHistory[SYNC_DELAY_WINDOW];
+  uint32_t Exchanges;
+  uint64_t LastUpdate;              /*!< t2 of the last exchange used           */
+  float    Drift;                   /*!< Integral term, ppm                     */
+  /* Status */
+  float    Offset;                  /*!< Last accepted offset to the master,
+                                         frames, positive when ahead           */
+  float    Delay;                   /*!< Last path delay, frames                */
+  float    Ppm;                     /*!< Trim applied                           */
+  uint8_t  State;                   /*!< 0 unlocked, 1 stepped, 2 locked        */
+  uint32_t Steps;
+  uint32_t Rejected;
+} SYNC_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef SYNC_Init(SYNC_HandleTypeDef *hsync, const SYNC_ConfigTypeDef *pConfig);
+void     SYNC_AudioStamp(SYNC_HandleTypeDef *hsync, uint32_t Tick, uint32_t Frames);
+uint64_t SYNC_Timeline(const SYNC_HandleTypeDef *hsync, uint32_t Tick);
+void     SYNC_Begin(SYNC_HandleTypeDef *hsync, uint8_t Seq, SYNC_MessageTypeDef *pMsg);
+uint8_t  SYNC_Transmitted(SYNC_HandleTypeDef *hsync, const SYNC_MessageTypeDef *pMsg,
+                          uint32_t Tick, SYNC_MessageTypeDef *pNext);
+uint8_t  SYNC_Received(SYNC_HandleTypeDef *hsync, const SYNC_MessageTypeDef *pMsg,
+                       uint32_t Tick, SYNC_MessageTypeDef *pReply);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_SYNC_H */
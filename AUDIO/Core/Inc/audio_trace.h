@@ -0,0 +1,119 @@
+/**
+  ******************************************************************************
+  * @file    audio_trace.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_trace.c file (event trace ring).
+  *
+  *          The hooks compile to nothing unless AUDIO_TRACE is defined to 1
+  *          (project define), so they can stay in interrupt handlers and
+  *          audio modules for good.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_TRACE_H
+#define __AUDIO_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+#ifndef AUDIO_TRACE
+#define AUDIO_TRACE               0
+#endif
+
+#define TRACE_RING_SIZE           1024U   /*!< Records, power of two, 12 KB     */
+#define TRACE_MAGIC               0x31435254U   /*!< "TRC1", marks a RAM dump   */
+#define TRACE_ITM_PORT            1U      /*!< SWO stimulus port of the drain   */
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Event identifiers
+  * @note   Keep in sync with AUDIO/Tools/trace2chrome.py.
+  */
+typedef enum
+{
+  TRACE_EVT_ISR_ENTER   = 1U, /*!< Arg: exception number (16 + IRQn)           */
+  TRACE_EVT_ISR_EXIT    = 2U,
+  TRACE_EVT_PENDSV      = 3U, /*!< Arg: dispatched job                         */
+  TRACE_EVT_NODE_BEGIN  = 4U, /*!< Arg: node index                             */
+  TRACE_EVT_NODE_END    = 5U,
+  TRACE_EVT_DMA_HALF    = 6U, /*!< Arg: DMA stream, (controller << 8) | stream */
+  TRACE_EVT_DMA_CPLT    = 7U,
+  TRACE_EVT_USB         = 8U, /*!< Arg: endpoint or USB event                  */
+  TRACE_EVT_SD          = 9U, /*!< Arg: block count or SD event                */
+  TRACE_EVT_MARK        = 10U /*!< Arg: free                                   */
+} TRACE_EventTypeDef;
+
+/**
+  * @brief  One record, 12 bytes, also the wire format of the drain
+  */
+typedef struct
+{
+  volatile uint32_t Seq;      /*!< Sequence number, written last: commit mark  */
+  uint32_t Cycles;            /*!< DWT cycle counter                           */
+  uint16_t Event;
+  uint16_t Arg;
+} TRACE_RecordTypeDef;
+
+/**
+  * @brief  Trace ring
+  * @note   Any context may record; a slot is claimed with LDREX/STREX on Head,
+  *         so nested interrupts never block each other. The ring overwrites
+  *         its oldest records (flight recorder): after a fault, a RAM dump of
+  *         TraceRing still shows the last TRACE_RING_SIZE events.
+  */
+typedef struct
+{
+  uint32_t Magic;
+  uint32_t Size;
+  uint32_t CoreClock;         /*!< Hz, converts cycles to time                 */
+  volatile uint32_t Head;     /*!< Records claimed since init                  */
+  uint32_t Tail;              /*!< Next record the drain sends                 */
+  uint32_t Lost;              /*!< Records overwritten before being drained    */
+  TRACE_RecordTypeDef Records[TRACE_RING_SIZE];
+} TRACE_RingTypeDef;
+
+/**
+  * @brief  Byte sink of the drain (UART, SWO, file...)
+  */
+typedef void (*TRACE_WriteTypeDef)(void *Context, const uint8_t *pData, uint32_t Size);
+
+/* Exported variables --------------------------------------------------------*/
+extern TRACE_RingTypeDef TraceRing;
+
+/* Exported macro ------------------------------------------------------------*/
+#if (AUDIO_TRACE != 0)
+#define TRACE_EVENT(evt, arg)     TRACE_Record((evt), (uint32_t)(arg))
+#else
+#define TRACE_EVENT(evt, arg)     ((void)0)
+#endif
+
+#define TRACE_ISR_ENTER(irqn)     TRACE_EVENT(TRACE_EVT_ISR_ENTER, (int32_t)(irqn) + 16)
+#define TRACE_ISR_EXIT(irqn)      TRACE_EVENT(TRACE_EVT_ISR_EXIT, (int32_t)(irqn) + 16)
+#define TRACE_DMA_HALF(dma, stream) TRACE_EVENT(TRACE_EVT_DMA_HALF, ((dma) << 8) | (stream))
+#define TRACE_DMA_CPLT(dma, stream) TRACE_EVENT(TRACE_EVT_DMA_CPLT, ((dma) << 8) | (stream))
+
+/* Exported functions prototypes ---------------------------------------------*/
+void     TRACE_Init(uint32_t CoreClock);
+void     TRACE_SetCoreClock(uint32_t CoreClock);
+void     TRACE_Record(TRACE_EventTypeDef Event, uint32_t Arg);
+uint32_t TRACE_Drain(TRACE_WriteTypeDef Write, void *Context, uint32_t MaxRecords);
+void     TRACE_ItmWrite(void *Context, const uint8_t *pData, uint32_t Size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_TRACE_H */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    audio_vad.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_vad.c file (block-rate voice activity detector).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_VAD_H
+#define __AUDIO_VAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Voice activity detector handle structure
+  * @note   Energy detector with an adaptive noise floor: the floor follows
+  *         the block level down immediately and up only slowly, so it
+  *         settles on the quietest recent level. Speech is flagged above
+  *         floor + Margin, with a hangover covering short pauses.
+  */
+typedef struct
+{
+  float    NoiseFloorDb;      /*!< Tracked noise floor, dBFS                    */
+  float    MarginDb;          /*!< Level above the floor flagged as speech      */
+  float    RiseDbPerBlock;    /*!< Upward tracking speed of the floor           */
+  uint16_t Hangover;          /*!< Blocks speech stays flagged after it stops   */
+  uint16_t HangCount;
+  uint8_t  Active;            /*!< Last block above the threshold, no hangover  */
+  uint8_t  Speech;            /*!< Decision for the last block                  */
+} VAD_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void    VAD_Init(VAD_HandleTypeDef *hvad, float MarginDb, float HangoverMs);
+uint8_t VAD_Update(VAD_HandleTypeDef *hvad, float LevelDb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_VAD_H */
@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    audio_vocoder.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_vocoder.c file (channel vocoder).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_VOCODER_H
+#define __AUDIO_VOCODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_biquad.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define VOCODER_MIN_BANDS         4U
+#define VOCODER_MAX_BANDS         32U
+#define VOCODER_STAGES            2U      /*!< Band-pass sections per band (4th order) */
+
+/** @brief Estimated Cortex-M4 cost of one band per frame, in cycles:
+  *        2 x VOCODER_STAGES paired sections plus rectify and gain */
+#define VOCODER_CYCLES_PER_BAND   (VOCODER_STAGES * 14U + 6U)
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Vocoder handle structure
+  * @note   Modulator and carrier run through the same band-pass bank: the
+  *         coefficients are shared, only the states differ.
+  */
+typedef struct
+{
+  uint32_t NumBands;
+  BIQUAD_CoeffsTypeDef Coeffs[VOCODER_MAX_BANDS][VOCODER_STAGES];
+  BIQUAD_StateTypeDef  ModState[VOCODER_MAX_BANDS][VOCODER_STAGES];
+  BIQUAD_StateTypeDef  CarState[VOCODER_MAX_BANDS][VOCODER_STAGES];
+  float    Envelope[VOCODER_MAX_BANDS];     /*!< Control-rate band envelopes        */
+  float    Attack;                          /*!< Smoothing factor per control tick  */
+  float    Release;                         /*!< Smoothing factor per control tick  */
+  float    Gain;                            /*!< Output makeup gain                 */
+  float    ModBuf[AUDIO_BLOCK_SIZE];
+  float    CarBuf[AUDIO_BLOCK_SIZE];
+} VOCODER_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+AUDIO_StatusTypeDef VOCODER_Init(VOCODER_HandleTypeDef *hvoc, uint32_t NumBands,
+                                 float LowHz, float HighHz);
+void     VOCODER_SetTimes(VOCODER_HandleTypeDef *hvoc, float AttackMs, float ReleaseMs);
+uint32_t VOCODER_BandsForBudget(uint32_t CyclesPerFrame);
+void     VOCODER_Process(VOCODER_HandleTypeDef *hvoc, const float *pCarrier,
+                         const float *pModulator, float *pOut, uint32_t Frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_VOCODER_H */
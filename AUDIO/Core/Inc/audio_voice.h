@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    audio_voice.h
+  * @brief   This file contains all the function prototypes for
+  *          the audio_voice.c file (streamed sample playback voices).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __AUDIO_VOICE_H
+#define __AUDIO_VOICE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_def.h"
+
+/* Exported constants --------------------------------------------------------*/
+/** @brief Prefetch ring length in samples, must be a power of two. SD
+  *        streaming wants more than QSPI: the ring rides out card pauses.
+  *        4096 (8 KB a voice, 128 KB for 16) holds 42 ms at twice the
+  *        rate; 2048 starves on the 25 ms pauses of an A1 card, and 8192
+  *        for 16 voices would take all of the F412's RAM */
+#ifndef VOICE_PREFETCH_LEN
+#define VOICE_PREFETCH_LEN        4096U
+#endif
+/** @brief Granularity of one background refill request in samples */
+#define VOICE_PREFETCH_CHUNK      512U
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief  Sample source descriptor. Samples are mono signed 16-bit.
+  * @note   Sources that are memory-mapped (internal flash, QSPI in memory-mapped
+  *         mode) set Data and are read in place. Other sources (QSPI indirect
+  *         mode, SD) leave Data NULL and are streamed through the voice prefetch
+  *         ring by Read, which is only ever called from the background context.
+  *         A streamed source may keep its first HeadLength samples in memory:
+  *         they play in place while the ring fills from HeadLength on.
+  */
+typedef struct
+{
+  const int16_t *Data;      /*!< Memory-mapped sample data, or NULL for streamed sources             */
+  uint32_t (*Read)(void *Context, uint32_t Position, int16_t *pDst, uint32_t Count);
+                            /*!< Copies up to Count samples from Position, returns the number copied */
+  void     *Context;        /*!< Opaque pointer handed back to Read (file, flash address, ...)       */
+  uint32_t Length;          /*!< Sample length in samples                                            */
+  const int16_t *Head;      /*!< First HeadLength samples of a streamed source, or NULL              */
+  uint32_t HeadLength;      /*!< Samples in Head, 0 without                                          */
+} VOICE_SourceTypeDef;
+
+/**
+  * @brief  Per-trigger playback parameters
+  */
+typedef struct
+{
+  float    Level;           /*!< Linear gain                                     */
+  float    Pan;             /*!< -1.0 (left) .. +1.0 (right)                     */
+  float    Rate;            /*!< Playback rate, 1.0 is original pitch            */
+  float    Decay;           /*!< Per-sample amplitude multiplier, 1.0 disables   */
+  uint32_t Start;           /*!< First sample played                             */
+} VOICE_ParamsTypeDef;
+
+/**
+  * @brief  Voice handle structure
+  */
+typedef struct
+{
+  const VOICE_SourceTypeDef *Source;  /*!< Currently playing source, NULL when idle          */
+  int16_t  Ring[VOICE_PREFETCH_LEN];  /*!< Prefetch ring                                     */
+  volatile uint32_t Fetched;          /*!< Absolute index of the next sample to prefetch     */
+  volatile uint32_t Consumed;         /*!< Absolute index of the oldest sample still needed  */
+  uint64_t Phase;                     /*!< Absolute read position, 32.32 fixed point         */
+  uint64_t Increment;                 /*!< Phase increment per output frame, 32.32           */
+  float    GainL;                     /*!< Current left gain (includes decay)                */
+  float    GainR;                     /*!< Current right gain (includes decay)               */
+  float    Decay;                     /*!< Per-sample gain multiplier                        */
+  volatile uint32_t Generation;       /*!< Bumped on each trigger, invalidates stale refills */
+  uint32_t Underruns;                 /*!< Frames lost because the ring ran dry              */
+} VOICE_HandleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void     VOICE_Init(VOICE_HandleTypeDef *hvoice);
+void     VOICE_Trigger(VOICE_HandleTypeDef *hvoice, const VOICE_SourceTypeDef *pSource,
+                       const VOICE_ParamsTypeDef *pParams);
+void     VOICE_Stop(VOICE_HandleTypeDef *hvoice);
+void     VOICE_Render(VOICE_HandleTypeDef *hvoice, float *pLeft, float *pRight, uint32_t Frames);
+uint32_t VOICE_Service(VOICE_HandleTypeDef *hvoice);
+uint32_t VOICE_Need(const VOICE_HandleTypeDef *hvoice, uint32_t *pPosition, uint32_t *pGeneration);
+uint32_t VOICE_Fill(VOICE_HandleTypeDef *hvoice, uint32_t Generation, uint32_t Position,
+                    const int16_t *pSrc, uint32_t Count);
+uint8_t  VOICE_IsActive(const VOICE_HandleTypeDef *hvoice);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_VOICE_H */
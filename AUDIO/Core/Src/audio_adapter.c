@@ -0,0 +1,197 @@
+/**
+  ******************************************************************************
+  * @file    audio_adapter.c
+  * @brief   Block-size adapter between a producer and a consumer working on
+  *          different block sizes (1 ms USB packets, DMA blocks, FFT frames).
+  *
+  *          With g = gcd(InSize, OutSize):
+  *          - polled, a frame waits for the producer block that completes
+  *            its consumer block: OutSize - g frames later at most, rounded
+  *            up to whole producer blocks. The buffer never holds more than
+  *            InSize + OutSize - g frames;
+  *          - clocked at an arbitrary phase, the consumer can ask for a block
+  *            just before the producer delivers, so InSize + OutSize frames
+  *            of prefill are needed, and up to 2 (InSize + OutSize) - g
+  *            frames are held.
+  *          Both figures are the worst case over all phases and are what the
+  *          adapter reports as its latency.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_adapter.h"
+#include <string.h>
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t ADAPTER_Gcd(uint32_t a, uint32_t b);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Returns the smallest valid buffer size for a size pair.
+  * @param  Mode consumer scheduling
+  * @param  InSize producer block, frames
+  * @param  OutSize consumer block, frames
+  * @retval Buffer size in frames (multiply by the channel count for floats),
+  *         0 if a block size is 0
+  */
+uint32_t ADAPTER_GetBufferSize(ADAPTER_ModeTypeDef Mode, uint32_t InSize, uint32_t OutSize)
+{
+  uint32_t g;
+  uint32_t lcm;
+  uint32_t need;
+
+  if ((InSize == 0U) || (OutSize == 0U))
+  {
+    return 0U;
+  }
+
+  g = ADAPTER_Gcd(InSize, OutSize);
+  lcm = InSize / g * OutSize;
+  need = (Mode == ADAPTER_MODE_CLOCKED) ? 2U * (InSize + OutSize) - g : InSize + OutSize - g;
+  return (need + lcm - 1U) / lcm * lcm;
+}
+
+/**
+  * @brief  Initializes the adapter, prefilled with silence in clocked mode.
+  * @param  hadapter pointer to the adapter handle
+  * @param  pBuffer Size * Channels floats
+  * @param  Size buffer size in frames, see ADAPTER_GetBufferSize()
+  * @param  Channels interleaved samples per frame
+  * @param  InSize producer block, frames
+  * @param  OutSize consumer block, frames
+  * @param  Mode consumer scheduling
+  * @retval AUDIO_OK, or AUDIO_ERROR if Size is too small or not a multiple
+  *         of both block sizes
+  */
+AUDIO_StatusTypeDef ADAPTER_Init(ADAPTER_HandleTypeDef *hadapter, float *pBuffer, uint32_t Size,
+                                 uint32_t Channels, uint32_t InSize, uint32_t OutSize,
+                                 ADAPTER_ModeTypeDef Mode)
+{
+  uint32_t need = ADAPTER_GetBufferSize(Mode, InSize, OutSize);
+  uint32_t g;
+
+  if ((need == 0U) || (Channels == 0U) || (Size < need) || ((Size % InSize) != 0U)
+      || ((Size % OutSize) != 0U))
+  {
+    return AUDIO_ERROR;
+  }
+
+  g = ADAPTER_Gcd(InSize, OutSize);
+  memset(hadapter, 0, sizeof(*hadapter));
+  memset(pBuffer, 0, Size * Channels * sizeof(float));
+  hadapter->pBuffer  = pBuffer;
+  hadapter->Size     = Size;
+  hadapter->Channels = Channels;
+  hadapter->InSize   = InSize;
+  hadapter->OutSize  = OutSize;
+
+  if (Mode == ADAPTER_MODE_CLOCKED)
+  {
+    /* Reading from (In/g - 1) Out puts the write position InSize + OutSize
+       later on a multiple of InSize, so both sides stay block aligned */
+    hadapter->ReadPos  = (InSize / g - 1U) * OutSize;
+    hadapter->WritePos = (hadapter->ReadPos + InSize + OutSize) % Size;
+    hadapter->Written  = InSize + OutSize;
+    hadapter->Latency  = InSize + OutSize;
+  }
+  else
+  {
+    hadapter->Latency  = (OutSize - g + InSize - 1U) / InSize * InSize;
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Returns where the producer writes its next block.
+  * @note   Called from the producer context.
+  * @param  hadapter pointer to the adapter handle
+  * @retval InSize * Channels contiguous floats, or NULL on overrun
+  */
+float *ADAPTER_GetWriteSpan(ADAPTER_HandleTypeDef *hadapter)
+{
+  if (hadapter->Written - hadapter->Consumed + hadapter->InSize > hadapter->Size)
+  {
+    return NULL;
+  }
+  return &hadapter->pBuffer[hadapter->WritePos * hadapter->Channels];
+}
+
+/**
+  * @brief  Publishes the block written into the write span.
+  * @note   Called from the producer context.
+  * @param  hadapter pointer to the adapter handle
+  * @retval None
+  */
+void ADAPTER_CommitWrite(ADAPTER_HandleTypeDef *hadapter)
+{
+  uint32_t pos = hadapter->WritePos + hadapter->InSize;
+
+  hadapter->WritePos = (pos == hadapter->Size) ? 0U : pos;
+  hadapter->Written += hadapter->InSize;
+}
+
+/**
+  * @brief  Returns the next complete consumer block, in place.
+  * @note   Called from the consumer context.
+  * @param  hadapter pointer to the adapter handle
+  * @retval OutSize * Channels contiguous floats, or NULL if not complete yet
+  *         (in clocked mode, an underrun)
+  */
+const float *ADAPTER_GetReadSpan(ADAPTER_HandleTypeDef *hadapter)
+{
+  if (hadapter->Written - hadapter->Consumed < hadapter->OutSize)
+  {
+    return NULL;
+  }
+  return &hadapter->pBuffer[hadapter->ReadPos * hadapter->Channels];
+}
+
+/**
+  * @brief  Releases the block returned by ADAPTER_GetReadSpan().
+  * @note   Called from the consumer context.
+  * @param  hadapter pointer to the adapter handle
+  * @retval None
+  */
+void ADAPTER_CommitRead(ADAPTER_HandleTypeDef *hadapter)
+{
+  uint32_t pos = hadapter->ReadPos + hadapter->OutSize;
+
+  hadapter->ReadPos = (pos == hadapter->Size) ? 0U : pos;
+  hadapter->Consumed += hadapter->OutSize;
+}
+
+/**
+  * @brief  Returns the worst-case delay the adapter adds.
+  * @param  hadapter pointer to the adapter handle
+  * @retval Latency in frames
+  */
+uint32_t ADAPTER_GetLatency(const ADAPTER_HandleTypeDef *hadapter)
+{
+  return hadapter->Latency;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Greatest common divisor.
+  * @param  a first value
+  * @param  b second value
+  * @retval gcd(a, b)
+  */
+static uint32_t ADAPTER_Gcd(uint32_t a, uint32_t b)
+{
+  while (b != 0U)
+  {
+    uint32_t t = a % b;
+
+    a = b;
+    b = t;
+  }
+  return a;
+}
@@ -0,0 +1,175 @@
+/**
+  ******************************************************************************
+  * @file    audio_adpcm.c
+  * @brief   IMA ADPCM block codec (4 bits per sample).
+  *
+  *          Every block carries its own predictor state in a small header, so
+  *          blocks can be decoded and rewritten independently of each other.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_adpcm.h"
+
+/* Private define ------------------------------------------------------------*/
+#define ADPCM_INDEX_MAX           88
+/** Samples examined to choose the initial step size of a block */
+#define ADPCM_PROBE_SAMPLES       8U
+
+/* Private variables ---------------------------------------------------------*/
+static const int16_t ADPCM_StepTable[ADPCM_INDEX_MAX + 1] =
+{
+      7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+     19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+     50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+   2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+   5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t ADPCM_IndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+/* Private function prototypes -----------------------------------------------*/
+static inline int32_t ADPCM_Step(int32_t Predictor, int32_t *pIndex, uint8_t Code);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Encodes a block of samples.
+  * @param  pSrc input samples
+  * @param  pDst output buffer of ADPCM_BLOCK_SIZE(Samples) bytes
+  * @param  Samples number of samples, must be even
+  * @retval None
+  */
+void ADPCM_EncodeBlock(const int16_t *pSrc, uint8_t *pDst, uint32_t Samples)
+{
+  int32_t predictor = pSrc[0];
+  int32_t index = 0;
+  uint32_t delta = 0U;
+  uint32_t i;
+
+  /* Start with a step size matching the local slope to avoid a slow attack */
+  for (i = 1U; i < AUDIO_MIN(Samples, ADPCM_PROBE_SAMPLES); i++)
+  {
+    int32_t d = (int32_t)pSrc[i] - (int32_t)pSrc[i - 1U];
+    delta = AUDIO_MAX(delta, (uint32_t)((d < 0) ? -d : d));
+  }
+  while ((index < ADPCM_INDEX_MAX) && ((uint32_t)ADPCM_StepTable[index] < delta / 4U))
+  {
+    index++;
+  }
+
+  pDst[0] = (uint8_t)((uint16_t)predictor & 0xFFU);
+  pDst[1] = (uint8_t)((uint16_t)predictor >> 8);
+  pDst[2] = (uint8_t)index;
+  pDst[3] = 0U;
+  pDst += ADPCM_HEADER_SIZE;
+
+  for (i = 0U; i < Samples; i++)
+  {
+    int32_t step = ADPCM_StepTable[index];
+    int32_t diff = (int32_t)pSrc[i] - predictor;
+    uint8_t code = 0U;
+
+    if (diff < 0)
+    {
+      code = 8U;
+      diff = -diff;
+    }
+    if (diff >= step)
+    {
+      code |= 4U;
+      diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+      code |= 2U;
+      diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+      code |= 1U;
+    }
+
+    /* Track the decoder exactly so that errors do not accumulate */
+    predictor = ADPCM_Step(predictor, &index, code);
+
+    if ((i & 1U) == 0U)
+    {
+      pDst[i >> 1] = code;
+    }
+    else
+    {
+      pDst[i >> 1] |= (uint8_t)(code << 4);
+    }
+  }
+}
+
+/**
+  * @brief  Decodes a block of samples.
+  * @param  pSrc encoded block of ADPCM_BLOCK_SIZE(Samples) bytes
+  * @param  pDst output samples
+  * @param  Samples number of samples, must be even
+  * @retval None
+  */
+void ADPCM_DecodeBlock(const uint8_t *pSrc, int16_t *pDst, uint32_t Samples)
+{
+  int32_t predictor = (int16_t)((uint16_t)pSrc[0] | ((uint16_t)pSrc[1] << 8));
+  int32_t index = AUDIO_MIN(pSrc[2], ADPCM_INDEX_MAX);
+  uint32_t i;
+
+  pSrc += ADPCM_HEADER_SIZE;
+  for (i = 0U; i < Samples; i += 2U)
+  {
+    uint8_t byte = pSrc[i >> 1];
+
+    predictor = ADPCM_Step(predictor, &index, byte & 0x0FU);
+    pDst[i] = (int16_t)predictor;
+    predictor = ADPCM_Step(predictor, &index, byte >> 4);
+    pDst[i + 1U] = (int16_t)predictor;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Applies one 4-bit code to the predictor state.
+  * @param  Predictor current predicted sample
+  * @param  pIndex step index, updated
+  * @param  Code 4-bit ADPCM code
+  * @retval New predicted sample
+  */
+static inline int32_t ADPCM_Step(int32_t Predictor, int32_t *pIndex, uint8_t Code)
+{
+  int32_t step = ADPCM_StepTable[*pIndex];
+  int32_t diff = step >> 3;
+
+  if ((Code & 4U) != 0U)
+  {
+    diff += step;
+  }
+  if ((Code & 2U) != 0U)
+  {
+    diff += step >> 1;
+  }
+  if ((Code & 1U) != 0U)
+  {
+    diff += step >> 2;
+  }
+  Predictor += ((Code & 8U) != 0U) ? -diff : diff;
+  Predictor = AUDIO_CLAMP(Predictor, -32768, 32767);
+
+  *pIndex += ADPCM_IndexTable[Code & 7U];
+  *pIndex = AUDIO_CLAMP(*pIndex, 0, ADPCM_INDEX_MAX);
+  return Predictor;
+}
@@ -0,0 +1,192 @@
+/**
+  ******************************************************************************
+  * @file    audio_agc.c
+  * @brief   Speech automatic gain control for the microphone capture path.
+  *
+  *          Once per block the AGC measures the RMS and peak level, asks the
+  *          VAD whether the block is speech and, only then, updates the speech
+  *          level tracker. The wanted gain brings that level to the target,
+  *          is capped so the noise floor stays below the guard level, and is
+  *          slew limited. Levels are tracked at the microphone, i.e. with the
+  *          codec analog gain taken out, so moving the analog gain does not
+  *          disturb the trackers. The only transcendental math is one dB
+  *          conversion per block; samples get a linear gain ramp.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_agc.h"
+#include "audio_fastmath.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define AGC_BLOCK_MS              (1000.0f * (float)AUDIO_BLOCK_SIZE / (float)AUDIO_SAMPLE_RATE)
+#define AGC_VAD_MARGIN_DB         9.0f
+#define AGC_VAD_HANGOVER_MS       300.0f
+/** The VAD floor settles on the quietest block: the mean noise level of
+    AUDIO_BLOCK_SIZE-frame blocks sits this much above it */
+#define AGC_FLOOR_BIAS_DB         2.5f
+/** Keeps silent blocks away from log2(0) */
+#define AGC_POWER_FLOOR           1e-12f
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the AGC at unity gain.
+  * @note   With an analog gain callback, the codec is set to the analog gain
+  *         closest to 0 dB.
+  * @param  hagc pointer to the AGC handle
+  * @param  pConfig AGC tuning
+  * @retval AUDIO_OK, or AUDIO_ERROR if the codec gain could not be set
+  */
+AUDIO_StatusTypeDef AGC_Init(AGC_HandleTypeDef *hagc, const AGC_ConfigTypeDef *pConfig)
+{
+  float analog = 0.0f;
+
+  memset(hagc, 0, sizeof(*hagc));
+  hagc->Config = *pConfig;
+  VAD_Init(&hagc->Vad, AGC_VAD_MARGIN_DB, AGC_VAD_HANGOVER_MS);
+
+  hagc->AttackCoeff    = 1.0f - expf(-AGC_BLOCK_MS / pConfig->AttackMs);
+  hagc->DecayCoeff     = 1.0f - expf(-AGC_BLOCK_MS / pConfig->DecayMs);
+  hagc->SlewDbPerBlock = pConfig->SlewDbPerSec * AGC_BLOCK_MS / 1000.0f;
+  hagc->SpeechDb       = pConfig->TargetDb;
+  hagc->GainDb         = AUDIO_CLAMP(0.0f, pConfig->MinGainDb, pConfig->MaxGainDb);
+
+  if (pConfig->SetAnalogGain != NULL)
+  {
+    analog = AUDIO_CLAMP(0.0f, pConfig->AnalogMinDb, pConfig->AnalogMaxDb);
+    if (pConfig->SetAnalogGain(pConfig->Context, analog) != AUDIO_OK)
+    {
+      return AUDIO_ERROR;
+    }
+  }
+  hagc->AnalogDb = analog;
+  hagc->Gain     = FASTMATH_DbToGain(hagc->GainDb - analog);
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Measures a block, updates the gain and applies it.
+  * @note   Called from the audio context, with AUDIO_BLOCK_SIZE frames: the
+  *         tracker time constants are per block.
+  * @param  hagc pointer to the AGC handle
+  * @param  pIn input samples, as captured (codec analog gain included)
+  * @param  pOut output samples, may alias pIn
+  * @param  Frames number of frames
+  * @retval None
+  */
+void AGC_Process(AGC_HandleTypeDef *hagc, const float *pIn, float *pOut, uint32_t Frames)
+{
+  const AGC_ConfigTypeDef *cfg = &hagc->Config;
+  float analog = hagc->AnalogDb;
+  float power = 0.0f;
+  float peak = 0.0f;
+  float mic;
+  float wanted;
+  float delta;
+  float headroom;
+  float gain;
+  float step;
+  uint32_t i;
+
+  if (Frames == 0U)
+  {
+    return;
+  }
+
+  for (i = 0U; i < Frames; i++)
+  {
+    float x = pIn[i];
+
+    power += x * x;
+    peak = AUDIO_MAX(peak, fabsf(x));
+  }
+  mic = FASTMATH_PowerToDb(power / (float)Frames + AGC_POWER_FLOOR) - analog;
+
+  /* Only voiced blocks move the level estimate: pauses, hangover included,
+     hold the gain rather than pulling it up toward the noise */
+  (void)VAD_Update(&hagc->Vad, mic);
+  if (hagc->Vad.Active != 0U)
+  {
+    float coeff = (mic > hagc->SpeechDb) ? hagc->AttackCoeff : hagc->DecayCoeff;
+
+    hagc->SpeechDb += coeff * (mic - hagc->SpeechDb);
+  }
+
+  /* Noise guard: never lift the floor above NoiseGuardDb */
+  wanted = cfg->TargetDb - hagc->SpeechDb;
+  wanted = AUDIO_MIN(wanted, cfg->NoiseGuardDb - (hagc->Vad.NoiseFloorDb + AGC_FLOOR_BIAS_DB));
+  wanted = AUDIO_CLAMP(wanted, cfg->MinGainDb, cfg->MaxGainDb);
+
+  delta = AUDIO_CLAMP(wanted - hagc->GainDb, -hagc->SlewDbPerBlock, hagc->SlewDbPerBlock);
+  hagc->GainDb += delta;
+
+  /* Clip guard: a sudden loud onset drops the gain at once, not at the slew rate */
+  headroom = cfg->PeakDb - (FASTMATH_PowerToDb(peak * peak + AGC_POWER_FLOOR) - analog + hagc->GainDb);
+  gain = hagc->Gain;
+  hagc->Gain = FASTMATH_DbToGain(hagc->GainDb - analog);
+  if (headroom < 0.0f)
+  {
+    hagc->GainDb = AUDIO_MAX(hagc->GainDb + headroom, cfg->MinGainDb);
+    hagc->Gain = FASTMATH_DbToGain(hagc->GainDb - analog);
+    gain = hagc->Gain;
+  }
+
+  /* Linear ramp from the previous block gain to this one */
+  step = (hagc->Gain - gain) / (float)Frames;
+  for (i = 0U; i < Frames; i++)
+  {
+    gain += step;
+    pOut[i] = pIn[i] * gain;
+  }
+}
+
+/**
+  * @brief  Moves the codec analog gain toward the AGC gain.
+  * @note   Called from the background context, never from an interrupt. The
+  *         gain moves one codec step per call and only once the AGC gain is
+  *         more than a step away, so the analog stage carries as much of the
+  *         gain as it can (best noise figure) without chattering. The digital
+  *         gain compensates from the next block on.
+  * @param  hagc pointer to the AGC handle
+  * @retval None
+  */
+void AGC_Service(AGC_HandleTypeDef *hagc)
+{
+  const AGC_ConfigTypeDef *cfg = &hagc->Config;
+  float analog = hagc->AnalogDb;
+  float wanted;
+  float next;
+
+  if ((cfg->SetAnalogGain == NULL) || (cfg->AnalogStepDb <= 0.0f))
+  {
+    return;
+  }
+
+  wanted = AUDIO_CLAMP(hagc->GainDb, cfg->AnalogMinDb, cfg->AnalogMaxDb);
+  if (wanted > analog + cfg->AnalogStepDb)
+  {
+    next = analog + cfg->AnalogStepDb;
+  }
+  else if (wanted < analog - cfg->AnalogStepDb)
+  {
+    next = analog - cfg->AnalogStepDb;
+  }
+  else
+  {
+    return;
+  }
+
+  if (cfg->SetAnalogGain(cfg->Context, next) == AUDIO_OK)
+  {
+    hagc->AnalogDb = next;
+  }
+}
@@ -0,0 +1,363 @@
+/**
+  ******************************************************************************
+  * @file    audio_asset.c
+  * @brief   Compressed asset store in flash.
+  *
+  *          Assets are packed at build time by Tools/asset_pack.py into a
+  *          generated source file holding an ASSET_StoreTypeDef. Every chunk
+  *          decodes on its own, so an asset can be streamed chunk by chunk
+  *          into pool blocks, or loaded whole into an arena, without ever
+  *          holding the compressed and decoded copies of the full asset.
+  *
+  *          Two codecs: LZ4 blocks for generic data, and for 16-bit PCM a
+  *          first-order delta whose zigzag-mapped residuals are Rice coded
+  *          with one parameter per chunk (first byte of the chunk).
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_asset.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define ASSET_MIN_MATCH           4U
+/** Rice quotients from this value on are escaped to a raw 16-bit residual */
+#define ASSET_RICE_ESCAPE         16U
+#define ASSET_RICE_MAX_K          15U
+
+/* Private function prototypes -----------------------------------------------*/
+static inline void     ASSET_Copy(uint8_t *pDst, const uint8_t *pSrc, uint32_t Len);
+static inline uint32_t ASSET_ReadLength(const uint8_t **ppSrc, const uint8_t *pEnd, uint32_t Len);
+static inline void     ASSET_Refill(uint32_t *pAcc, int32_t *pAvail, const uint8_t **ppSrc, const uint8_t *pEnd);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Looks an asset up by name.
+  * @param  pStore pointer to the asset index
+  * @param  pName asset name
+  * @retval Pointer to the entry, or NULL if there is no such asset
+  */
+const ASSET_EntryTypeDef *ASSET_Find(const ASSET_StoreTypeDef *pStore, const char *pName)
+{
+  uint32_t lo = 0U;
+  uint32_t hi = pStore->NumEntries;
+
+  while (lo < hi)
+  {
+    uint32_t mid = (lo + hi) / 2U;
+    int32_t cmp = strcmp(pName, pStore->pEntries[mid].Name);
+
+    if (cmp == 0)
+    {
+      return &pStore->pEntries[mid];
+    }
+    if (cmp < 0)
+    {
+      hi = mid;
+    }
+    else
+    {
+      lo = mid + 1U;
+    }
+  }
+  return NULL;
+}
+
+/**
+  * @brief  Returns the decoded size of a chunk.
+  * @param  pEntry pointer to the asset entry
+  * @param  Chunk chunk index
+  * @retval Size in bytes, 0 past the end of the asset
+  */
+uint32_t ASSET_GetChunkSize(const ASSET_EntryTypeDef *pEntry, uint32_t Chunk)
+{
+  uint32_t start = Chunk * pEntry->ChunkSize;
+
+  if (Chunk >= pEntry->NumChunks)
+  {
+    return 0U;
+  }
+  return AUDIO_MIN(pEntry->ChunkSize, pEntry->Size - start);
+}
+
+/**
+  * @brief  Decodes one chunk.
+  * @param  pEntry pointer to the asset entry
+  * @param  Chunk chunk index
+  * @param  pDst destination of ASSET_GetChunkSize() bytes, halfword aligned
+  *         for ASSET_CODEC_RICE16 assets
+  * @retval Number of bytes decoded, 0 if the chunk is corrupt or out of range
+  */
+uint32_t ASSET_DecodeChunk(const ASSET_EntryTypeDef *pEntry, uint32_t Chunk, uint8_t *pDst)
+{
+  uint32_t size = ASSET_GetChunkSize(pEntry, Chunk);
+  const uint8_t *src;
+  uint32_t len;
+
+  if (size == 0U)
+  {
+    return 0U;
+  }
+  src = &pEntry->pData[pEntry->pChunks[Chunk]];
+  len = pEntry->pChunks[Chunk + 1U] - pEntry->pChunks[Chunk];
+
+  if (len == size)
+  {
+    memcpy(pDst, src, size);
+  }
+  else if (pEntry->Codec == (uint32_t)ASSET_CODEC_RICE16)
+  {
+    if (ASSET_Rice16Decode(src, len, (int16_t *)(void *)pDst, size / 2U) != (int32_t)(size / 2U))
+    {
+      return 0U;
+    }
+  }
+  else if (ASSET_Lz4Decode(src, len, pDst, size) != (int32_t)size)
+  {
+    return 0U;
+  }
+  return size;
+}
+
+/**
+  * @brief  Decodes a whole asset into contiguous memory, chunk by chunk.
+  * @param  pEntry pointer to the asset entry
+  * @param  pDst destination, halfword aligned for ASSET_CODEC_RICE16 assets
+  * @param  DstSize destination size, at least pEntry->Size
+  * @retval AUDIO_OK, or AUDIO_ERROR if the buffer is too small or data corrupt
+  */
+AUDIO_StatusTypeDef ASSET_Load(const ASSET_EntryTypeDef *pEntry, uint8_t *pDst, uint32_t DstSize)
+{
+  uint32_t i;
+
+  if (DstSize < pEntry->Size)
+  {
+    return AUDIO_ERROR;
+  }
+  for (i = 0U; i < pEntry->NumChunks; i++)
+  {
+    if (ASSET_DecodeChunk(pEntry, i, pDst) == 0U)
+    {
+      return AUDIO_ERROR;
+    }
+    pDst += pEntry->ChunkSize;
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Decodes an LZ4 block.
+  * @note   Every length and offset is checked, so corrupt input can never
+  *         write outside the destination.
+  * @param  pSrc compressed block
+  * @param  SrcLen compressed length
+  * @param  pDst destination buffer
+  * @param  DstLen destination size
+  * @retval Number of bytes decoded, or -1 if the block is malformed
+  */
+int32_t ASSET_Lz4Decode(const uint8_t *pSrc, uint32_t SrcLen, uint8_t *pDst, uint32_t DstLen)
+{
+  const uint8_t *ip = pSrc;
+  const uint8_t *iend = pSrc + SrcLen;
+  uint8_t *op = pDst;
+  uint8_t *oend = pDst + DstLen;
+
+  while (ip < iend)
+  {
+    uint32_t token = *ip++;
+    uint32_t len = ASSET_ReadLength(&ip, iend, token >> 4);
+    uint32_t offset;
+
+    /* Literals */
+    if ((len > (uint32_t)(iend - ip)) || (len > (uint32_t)(oend - op)))
+    {
+      return -1;
+    }
+    ASSET_Copy(op, ip, len);
+    op += len;
+    ip += len;
+    if (ip == iend)
+    {
+      break;                        /* The last sequence has no match */
+    }
+
+    /* Match */
+    if ((uint32_t)(iend - ip) < 2U)
+    {
+      return -1;
+    }
+    offset = (uint32_t)ip[0] | ((uint32_t)ip[1] << 8);
+    ip += 2;
+    len = ASSET_ReadLength(&ip, iend, token & 0x0FU) + ASSET_MIN_MATCH;
+    if ((offset == 0U) || (offset > (uint32_t)(op - pDst)) || (len > (uint32_t)(oend - op)))
+    {
+      return -1;
+    }
+
+    if (offset >= 4U)
+    {
+      /* Forward word copy: each word read was written at least a word ago */
+      ASSET_Copy(op, op - offset, len);
+      op += len;
+    }
+    else
+    {
+      const uint8_t *m = op - offset;
+
+      while (len-- > 0U)
+      {
+        *op++ = *m++;
+      }
+    }
+  }
+  return (int32_t)(op - pDst);
+}
+
+/**
+  * @brief  Decodes a delta + Rice coded block of 16-bit samples.
+  * @note   Each residual is a unary quotient (zeros ended by a one) and K
+  *         remainder bits; the quotient length comes from a single CLZ.
+  *         Quotients of 16 or more are sent as 16 zeros and the raw residual.
+  * @param  pSrc compressed block: K, then the bit stream, MSB first
+  * @param  SrcLen compressed length
+  * @param  pDst destination samples, halfword aligned
+  * @param  Samples number of samples to decode
+  * @retval Number of samples decoded, or -1 if the block is malformed
+  */
+int32_t ASSET_Rice16Decode(const uint8_t *pSrc, uint32_t SrcLen, int16_t *pDst, uint32_t Samples)
+{
+  const uint8_t *ip = pSrc + 1;
+  const uint8_t *iend = pSrc + SrcLen;
+  uint32_t k;
+  uint32_t acc = 0U;                /* Left aligned bit window                      */
+  int32_t avail = 0;                /* Valid bits in acc                            */
+  uint16_t prev = 0U;
+  uint32_t i;
+
+  if ((SrcLen == 0U) || (pSrc[0] > ASSET_RICE_MAX_K))
+  {
+    return -1;
+  }
+  k = pSrc[0];
+
+  for (i = 0U; i < Samples; i++)
+  {
+    uint32_t q;
+    uint32_t v;
+
+    ASSET_Refill(&acc, &avail, &ip, iend);
+    q = (acc == 0U) ? 32U : (uint32_t)__builtin_clz(acc);
+    q = AUDIO_MIN(q, ASSET_RICE_ESCAPE);
+    if (avail < (int32_t)(q + 1U))
+    {
+      return -1;
+    }
+
+    if (q == ASSET_RICE_ESCAPE)
+    {
+      /* Escape: the zeros alone, then the raw residual */
+      acc <<= ASSET_RICE_ESCAPE;
+      avail -= (int32_t)ASSET_RICE_ESCAPE;
+      ASSET_Refill(&acc, &avail, &ip, iend);
+      if (avail < 16)
+      {
+        return -1;
+      }
+      v = acc >> 16;
+      acc <<= 16;
+      avail -= 16;
+    }
+    else
+    {
+      acc <<= q + 1U;
+      avail -= (int32_t)(q + 1U);
+      v = q << k;
+      if (k != 0U)
+      {
+        ASSET_Refill(&acc, &avail, &ip, iend);
+        if (avail < (int32_t)k)
+        {
+          return -1;
+        }
+        v |= acc >> (32U - k);
+        acc <<= k;
+        avail -= (int32_t)k;
+      }
+    }
+
+    /* Zigzag back to a signed delta, wrapping like the encoder */
+    prev = (uint16_t)(prev + (uint16_t)((v >> 1) ^ (0U - (v & 1U))));
+    pDst[i] = (int16_t)prev;
+  }
+  return (int32_t)Samples;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Forward copy by words, then bytes. Never writes past Len.
+  * @note   Fixed-size memcpy() compiles to single unaligned LDR/STR on the M4.
+  */
+static inline void ASSET_Copy(uint8_t *pDst, const uint8_t *pSrc, uint32_t Len)
+{
+  while (Len >= 4U)
+  {
+    uint32_t w;
+
+    memcpy(&w, pSrc, 4U);
+    memcpy(pDst, &w, 4U);
+    pDst += 4;
+    pSrc += 4;
+    Len -= 4U;
+  }
+  while (Len-- > 0U)
+  {
+    *pDst++ = *pSrc++;
+  }
+}
+
+/**
+  * @brief  Completes a 4-bit length field with its extension bytes.
+  * @retval Length, or a value larger than any buffer if the input ends early
+  */
+static inline uint32_t ASSET_ReadLength(const uint8_t **ppSrc, const uint8_t *pEnd, uint32_t Len)
+{
+  const uint8_t *p = *ppSrc;
+  uint32_t b;
+
+  if (Len == 15U)
+  {
+    do
+    {
+      if (p >= pEnd)
+      {
+        return UINT32_MAX / 2U;
+      }
+      b = *p++;
+      Len += b;
+    } while (b == 255U);
+  }
+  *ppSrc = p;
+  return Len;
+}
+
+/**
+  * @brief  Tops the bit window up to at least 25 valid bits, while input lasts.
+  */
+static inline void ASSET_Refill(uint32_t *pAcc, int32_t *pAvail, const uint8_t **ppSrc, const uint8_t *pEnd)
+{
+  const uint8_t *p = *ppSrc;
+
+  while ((*pAvail <= 24) && (p < pEnd))
+  {
+    *pAcc |= (uint32_t)*p++ << (24 - *pAvail);
+    *pAvail += 8;
+  }
+  *ppSrc = p;
+}
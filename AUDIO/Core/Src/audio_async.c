@@ -0,0 +1,214 @@
+/**
+  ******************************************************************************
+  * @file    audio_async.c
+  * @brief   Background coroutines for multi-step I/O sequences.
+  *
+  *          Mounting the SD card, bringing up the codec or writing flash are
+  *          sequences of "start a transfer, wait for it, check, go on". Each
+  *          runs here as a stackless task: its body reads top to bottom and
+  *          returns to the run loop at every wait, so sequences overlap each
+  *          other and the audio interrupts without a stack per sequence.
+  *          Frames come from a fixed pool in the handle; nothing is allocated.
+  *
+  *          Interrupt handlers only post signals and push queue events; every
+  *          task runs in the background context, from ASYNC_Run. The module
+  *          takes the tick as an argument and touches no peripheral, so it
+  *          runs unchanged on a host with a simulated tick.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_async.h"
+#include <string.h>
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the run loop with all task slots free.
+  * @param  hasync pointer to the run loop handle
+  * @retval None
+  */
+void ASYNC_Init(ASYNC_HandleTypeDef *hasync)
+{
+  memset(hasync, 0, sizeof(*hasync));
+}
+
+/**
+  * @brief  Starts a task in a free slot.
+  * @note   Background context only. The task first runs on the next
+  *         ASYNC_Run call.
+  * @param  hasync pointer to the run loop handle
+  * @param  Func task body
+  * @param  pInit initial frame contents (the task arguments), or NULL
+  * @param  Size bytes of pInit, up to ASYNC_FRAME_SIZE; the rest is zeroed
+  * @param  pDone signal posted when the task finishes, or NULL
+  * @retval AUDIO_OK, AUDIO_BUSY if no slot is free, AUDIO_ERROR if the
+  *         frame is too large
+  */
+AUDIO_StatusTypeDef ASYNC_Spawn(ASYNC_HandleTypeDef *hasync, ASYNC_FuncTypeDef Func,
+                                const void *pInit, uint32_t Size, ASYNC_SignalTypeDef *pDone)
+{
+  uint32_t i;
+
+  if ((Func == NULL) || (Size > ASYNC_FRAME_SIZE))
+  {
+    return AUDIO_ERROR;
+  }
+
+  for (i = 0U; i < ASYNC_MAX_TASKS; i++)
+  {
+    ASYNC_TaskTypeDef *t = &hasync->Tasks[i];
+
+    if (t->Func == NULL)
+    {
+      memset(t, 0, sizeof(*t));
+      if (pInit != NULL)
+      {
+        memcpy(t->Frame, pInit, Size);
+      }
+      t->pDone = pDone;
+      t->Timeout = ASYNC_FOREVER;
+      t->Func = Func;
+      return AUDIO_OK;
+    }
+  }
+  return AUDIO_BUSY;
+}
+
+/**
+  * @brief  Resumes every task whose wait is over.
+  * @note   Call from the main loop. A task that yields or polls a condition
+  *         is resumed on every call, so the loop should not sleep while
+  *         ASYNC_Run keeps returning non-zero.
+  * @param  hasync pointer to the run loop handle
+  * @param  Now current tick in ms (HAL_GetTick on the target)
+  * @retval Number of tasks resumed
+  */
+uint32_t ASYNC_Run(ASYNC_HandleTypeDef *hasync, uint32_t Now)
+{
+  uint32_t resumed = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < ASYNC_MAX_TASKS; i++)
+  {
+    ASYNC_TaskTypeDef *t = &hasync->Tasks[i];
+    uint8_t expired;
+    uint8_t ready;
+
+    if (t->Func == NULL)
+    {
+      continue;
+    }
+
+    /* Unsigned difference: correct across the tick wrap */
+    expired = (uint8_t)((t->Timeout != ASYNC_FOREVER) && ((Now - t->Start) >= t->Timeout));
+    switch (t->Wait)
+    {
+      case ASYNC_WAIT_SIGNAL:
+        ready = (uint8_t)(t->pSignal->Posted != t->pSignal->Taken);
+        if (ready != 0U)
+        {
+          t->pSignal->Taken++;
+        }
+        break;
+
+      case ASYNC_WAIT_QUEUE:
+        ready = ASYNC_Pop(t->pQueue, &t->Event);
+        break;
+
+      case ASYNC_WAIT_TIME:
+        ready = expired;
+        expired = 0U;
+        break;
+
+      case ASYNC_WAIT_COND:
+        ready = (uint8_t)(expired == 0U);
+        break;
+
+      default:
+        ready = 1U;
+        break;
+    }
+    if ((ready == 0U) && (expired == 0U))
+    {
+      continue;
+    }
+
+    t->Result = (ready != 0U) ? AUDIO_OK : AUDIO_TIMEOUT;
+    t->Now = Now;
+    resumed++;
+    if (t->Func(t, t->Frame) == ASYNC_DONE)
+    {
+      t->Func = NULL;
+      if (t->pDone != NULL)
+      {
+        ASYNC_Post(t->pDone);
+      }
+    }
+  }
+  return resumed;
+}
+
+/**
+  * @brief  Records what a task waits for. Used by the ASYNC_ macros.
+  * @param  pTask pointer to the task
+  * @param  Wait ASYNC_WAIT_x
+  * @param  TimeoutMs wait limit, or ASYNC_FOREVER
+  * @retval None
+  */
+void ASYNC_Wait(ASYNC_TaskTypeDef *pTask, uint32_t Wait, uint32_t TimeoutMs)
+{
+  pTask->Wait = Wait;
+  pTask->Start = pTask->Now;
+  pTask->Timeout = TimeoutMs;
+}
+
+/**
+  * @brief  Adds an event to a queue.
+  * @param  pQueue pointer to the queue
+  * @param  Id event identifier
+  * @param  Value event value
+  * @retval 1 if queued, 0 if the queue was full
+  */
+uint8_t ASYNC_Push(ASYNC_QueueTypeDef *pQueue, uint32_t Id, int32_t Value)
+{
+  uint32_t head = pQueue->Head;
+
+  if ((head - pQueue->Tail) >= ASYNC_QUEUE_SIZE)
+  {
+    pQueue->Dropped++;
+    return 0U;
+  }
+  pQueue->Events[head & (ASYNC_QUEUE_SIZE - 1U)].Id = Id;
+  pQueue->Events[head & (ASYNC_QUEUE_SIZE - 1U)].Value = Value;
+  /* Publish the event before the index: Cortex-M4 keeps stores in order */
+  __asm volatile ("" ::: "memory");
+  pQueue->Head = head + 1U;
+  return 1U;
+}
+
+/**
+  * @brief  Takes the oldest event of a queue.
+  * @param  pQueue pointer to the queue
+  * @param  pEvent receives the event
+  * @retval 1 if an event was taken, 0 if the queue was empty
+  */
+uint8_t ASYNC_Pop(ASYNC_QueueTypeDef *pQueue, ASYNC_EventTypeDef *pEvent)
+{
+  uint32_t tail = pQueue->Tail;
+
+  if (tail == pQueue->Head)
+  {
+    return 0U;
+  }
+  *pEvent = pQueue->Events[tail & (ASYNC_QUEUE_SIZE - 1U)];
+  __asm volatile ("" ::: "memory");
+  pQueue->Tail = tail + 1U;
+  return 1U;
+}
@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file    audio_bench.c
+  * @brief   Kernel registry of the host benchmark runner.
+  *
+  *          Each entry times one DSP kernel on one audio block with fixed,
+  *          deterministic inputs, so the cycle count only moves when the code
+  *          (or the compiler) does. Add an entry for every kernel whose inner
+  *          loop matters; AUDIO/Tools/kernel_bench.py picks it up by name and
+  *          compares it against its baseline.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_bench.h"
+
+#if (AUDIO_KERNEL_BENCH != 0)
+#include "audio_adpcm.h"
+#include "audio_biquad.h"
+#include "audio_design.h"
+#include "audio_eq.h"
+#include "audio_fft.h"
+#include "audio_fir.h"
+#include "audio_g711.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BENCH_FIR_TAPS            64U
+#define BENCH_BIQUAD_STAGES       4U
+#define BENCH_FFT_SIZE            512U
+#define BENCH_ADPCM_SAMPLES       256U
+
+/* Private variables ---------------------------------------------------------*/
+/* Coefficients in flash, as the product builds keep them */
+static const float BenchFirCoeffs[BENCH_FIR_TAPS] =
+{
+  DESIGN_REPEAT_64(DESIGN_FIR_LOWPASS, BENCH_FIR_TAPS, AUDIO_SAMPLE_RATE, 8000)
+};
+
+/* Cascade centers, a log spread from 100 Hz to 16 kHz, all below Nyquist */
+static const float BenchBiquadFreqs[BENCH_BIQUAD_STAGES] = { 100.0f, 543.0f, 2947.0f, 16000.0f };
+
+static float BenchIn[BENCH_FFT_SIZE];
+static float BenchOut[BENCH_FFT_SIZE];
+static int16_t BenchPcm[BENCH_ADPCM_SAMPLES];
+static uint8_t BenchCode[ADPCM_BLOCK_SIZE(BENCH_ADPCM_SAMPLES)];
+
+static FIR_HandleTypeDef BenchFir;
+static float BenchFirState[FIR_STATE_SIZE(BENCH_FIR_TAPS, AUDIO_BLOCK_SIZE)];
+static BIQUAD_CascadeTypeDef BenchCascade;
+static BIQUAD_CoeffsTypeDef BenchBiquadCoeffs[BENCH_BIQUAD_STAGES];
+static BIQUAD_StateTypeDef BenchBiquadState[BENCH_BIQUAD_STAGES];
+static EQ_HandleTypeDef BenchEq;
+static EQ_BandTypeDef BenchBand;
+static FFT_HandleTypeDef BenchFft;
+
+/* Private function prototypes -----------------------------------------------*/
+static void BENCH_Noise(void);
+static void BENCH_FirSetup(void);
+static void BENCH_FirRun(void);
+static void BENCH_BiquadSetup(void);
+static void BENCH_BiquadRun(void);
+static void BENCH_EqSetup(void);
+static void BENCH_EqRun(void);
+static void BENCH_EqDesignRun(void);
+static void BENCH_FftSetup(void);
+static void BENCH_FftRun(void);
+static void BENCH_G711Run(void);
+static void BENCH_AdpcmRun(void);
+
+/* Exported variables --------------------------------------------------------*/
+/* Nothing on the target references the registry: the linker script keeps
+   its section */
+__attribute__((section(".bench_kernels")))
+const BENCH_KernelTypeDef BenchKernels[] =
+{
+  { "fir_64tap",        BENCH_FirSetup,    BENCH_FirRun,      AUDIO_BLOCK_SIZE    },
+  { "biquad_4stage",    BENCH_BiquadSetup, BENCH_BiquadRun,   AUDIO_BLOCK_SIZE    },
+  { "eq_10band",        BENCH_EqSetup,     BENCH_EqRun,       AUDIO_BLOCK_SIZE    },
+  { "eq_design_matched", BENCH_EqSetup,    BENCH_EqDesignRun, 1U                  },
+  { "fft_real_512",     BENCH_FftSetup,    BENCH_FftRun,      BENCH_FFT_SIZE      },
+  { "g711_ulaw_encode", BENCH_Noise,       BENCH_G711Run,     AUDIO_BLOCK_SIZE    },
+  { "adpcm_encode",     BENCH_Noise,       BENCH_AdpcmRun,    BENCH_ADPCM_SAMPLES },
+};
+
+__attribute__((section(".bench_kernels")))
+const uint32_t BenchKernelCount = sizeof(BenchKernels) / sizeof(BenchKernels[0]);
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Fills the inputs with the same white noise on every call.
+  * @retval None
+  */
+static void BENCH_Noise(void)
+{
+  uint32_t seed = 0x12345678U;
+  uint32_t i;
+
+  for (i = 0U; i < BENCH_FFT_SIZE; i++)
+  {
+    seed = seed * 1664525U + 1013904223U;
+    BenchIn[i] = (float)(int32_t)seed * (0.5f / 2147483648.0f);
+  }
+  for (i = 0U; i < BENCH_ADPCM_SAMPLES; i++)
+  {
+    BenchPcm[i] = (int16_t)(BenchIn[i] * 32767.0f);
+  }
+}
+
+/* Kernel wrappers: Setup is not timed, Run is */
+static void BENCH_FirSetup(void)
+{
+  BENCH_Noise();
+  FIR_Init(&BenchFir, BenchFirCoeffs, BenchFirState, BENCH_FIR_TAPS, AUDIO_BLOCK_SIZE);
+}
+
+static void BENCH_FirRun(void)
+{
+  FIR_Process(&BenchFir, BenchIn, BenchOut, AUDIO_BLOCK_SIZE);
+}
+
+static void BENCH_BiquadSetup(void)
+{
+  uint32_t i;
+
+  BENCH_Noise();
+  for (i = 0U; i < BENCH_BIQUAD_STAGES; i++)
+  {
+    BenchBand.Type   = EQ_PEAKING;
+    BenchBand.Freq   = BenchBiquadFreqs[i];
+    BenchBand.Q      = 1.0f;
+    BenchBand.GainDb = 6.0f;
+    EQ_Design(&BenchBand, EQ_DESIGN_RBJ, &BenchBiquadCoeffs[i]);
+  }
+  BIQUAD_CascadeInit(&BenchCascade, BenchBiquadCoeffs, BenchBiquadState, BENCH_BIQUAD_STAGES);
+}
+
+static void BENCH_BiquadRun(void)
+{
+  BIQUAD_CascadeProcess(&BenchCascade, BenchIn, BenchOut, AUDIO_BLOCK_SIZE);
+}
+
+static void BENCH_EqSetup(void)
+{
+  uint32_t i;
+
+  BENCH_Noise();
+  (void)EQ_Init(&BenchEq, EQ_DESIGN_MATCHED, EQ_MAX_BANDS);
+  for (i = 0U; i < EQ_MAX_BANDS; i++)
+  {
+    BenchBand.Type   = EQ_PEAKING;
+    BenchBand.Freq   = 31.25f * (float)(1U << i);
+    BenchBand.Q      = 1.4f;
+    BenchBand.GainDb = ((i & 1U) != 0U) ? 3.0f : -3.0f;
+    (void)EQ_SetBand(&BenchEq, i, &BenchBand);
+  }
+  /* Run the coefficient glide out: Run measures the steady state */
+  for (i = 0U; i <= EQ_RAMP_BLOCKS; i++)
+  {
+    EQ_Process(&BenchEq, BenchIn, BenchOut, AUDIO_BLOCK_SIZE);
+  }
+}
+
+static void BENCH_EqRun(void)
+{
+  EQ_Process(&BenchEq, BenchIn, BenchOut, AUDIO_BLOCK_SIZE);
+}
+
+static void BENCH_EqDesignRun(void)
+{
+  EQ_Design(&BenchBand, EQ_DESIGN_MATCHED, &BenchBiquadCoeffs[0]);
+}
+
+static void BENCH_FftSetup(void)
+{
+  BENCH_Noise();
+  (void)FFT_Init(&BenchFft, BENCH_FFT_SIZE);
+}
+
+static void BENCH_FftRun(void)
+{
+  uint32_t i;
+
+  /* The transform is in place: start from the same input every run */
+  for (i = 0U; i < BENCH_FFT_SIZE; i++)
+  {
+    BenchOut[i] = BenchIn[i];
+  }
+  FFT_Real(&BenchFft, BenchOut);
+}
+
+static void BENCH_G711Run(void)
+{
+  G711_Encode(G711_ULAW, BenchIn, BenchCode, AUDIO_BLOCK_SIZE);
+}
+
+static void BENCH_AdpcmRun(void)
+{
+  ADPCM_EncodeBlock(BenchPcm, BenchCode, BENCH_ADPCM_SAMPLES);
+}
+#endif /* AUDIO_KERNEL_BENCH */
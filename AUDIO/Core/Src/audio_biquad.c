@@ -0,0 +1,157 @@
+/**
+  ******************************************************************************
+  * @file    audio_biquad.c
+  * @brief   Second-order IIR sections in transposed direct form II.
+  *
+  *          Each section is run over the whole block before the next one, so
+  *          the coefficients and the two state words stay in FPU registers
+  *          for the inner loop.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_biquad.h"
+#include <string.h>
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes a cascade and clears its state.
+  * @param  hcascade pointer to the cascade handle
+  * @param  pCoeffs NumStages coefficient sets
+  * @param  pState NumStages states
+  * @param  NumStages number of sections
+  * @retval None
+  */
+void BIQUAD_CascadeInit(BIQUAD_CascadeTypeDef *hcascade, const BIQUAD_CoeffsTypeDef *pCoeffs,
+                        BIQUAD_StateTypeDef *pState, uint32_t NumStages)
+{
+  hcascade->pCoeffs   = pCoeffs;
+  hcascade->pState    = pState;
+  hcascade->NumStages = NumStages;
+  BIQUAD_CascadeReset(hcascade);
+}
+
+/**
+  * @brief  Clears the state of a cascade.
+  * @param  hcascade pointer to the cascade handle
+  * @retval None
+  */
+void BIQUAD_CascadeReset(BIQUAD_CascadeTypeDef *hcascade)
+{
+  memset(hcascade->pState, 0, hcascade->NumStages * sizeof(BIQUAD_StateTypeDef));
+}
+
+/**
+  * @brief  Filters a block through all sections of a cascade.
+  * @note   pIn and pOut may be the same buffer.
+  * @param  hcascade pointer to the cascade handle
+  * @param  pIn input samples
+  * @param  pOut output samples
+  * @param  Frames number of samples
+  * @retval None
+  */
+void BIQUAD_CascadeProcess(BIQUAD_CascadeTypeDef *hcascade, const float *pIn, float *pOut,
+                           uint32_t Frames)
+{
+  uint32_t i;
+
+  for (i = 0U; i < hcascade->NumStages; i++)
+  {
+    BIQUAD_Process(&hcascade->pCoeffs[i], &hcascade->pState[i], (i == 0U) ? pIn : pOut, pOut, Frames);
+  }
+}
+
+/**
+  * @brief  Filters a block through one section.
+  * @note   pIn and pOut may be the same buffer.
+  * @param  pCoeffs section coefficients
+  * @param  pState section state
+  * @param  pIn input samples
+  * @param  pOut output samples
+  * @param  Frames number of samples
+  * @retval None
+  */
+void BIQUAD_Process(const BIQUAD_CoeffsTypeDef *pCoeffs, BIQUAD_StateTypeDef *pState,
+                    const float *pIn, float *pOut, uint32_t Frames)
+{
+  const float b0 = pCoeffs->b0;
+  const float b1 = pCoeffs->b1;
+  const float b2 = pCoeffs->b2;
+  const float a1 = pCoeffs->a1;
+  const float a2 = pCoeffs->a2;
+  float s1 = pState->s1;
+  float s2 = pState->s2;
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    float x = pIn[i];
+    float y = b0 * x + s1;
+
+    s1 = b1 * x - a1 * y + s2;
+    s2 = b2 * x - a2 * y;
+    pOut[i] = y;
+  }
+
+  pState->s1 = s1;
+  pState->s2 = s2;
+}
+
+/**
+  * @brief  Filters two independent signals through two sections in one pass.
+  * @note   The Cortex-M4 FPU has no SIMD lanes, but it pipelines independent
+  *         multiply-accumulates. Interleaving two unrelated sections hides the
+  *         latency of each recursive chain and costs noticeably less than two
+  *         BIQUAD_Process() calls. Buffers may be shared between input and
+  *         output of the same lane, and both lanes may share coefficients.
+  * @param  pCoeffsA lane A coefficients
+  * @param  pStateA lane A state
+  * @param  pInA lane A input samples
+  * @param  pOutA lane A output samples
+  * @param  pCoeffsB lane B coefficients
+  * @param  pStateB lane B state
+  * @param  pInB lane B input samples
+  * @param  pOutB lane B output samples
+  * @param  Frames number of samples
+  * @retval None
+  */
+void BIQUAD_ProcessPair(const BIQUAD_CoeffsTypeDef *pCoeffsA, BIQUAD_StateTypeDef *pStateA,
+                        const float *pInA, float *pOutA,
+                        const BIQUAD_CoeffsTypeDef *pCoeffsB, BIQUAD_StateTypeDef *pStateB,
+                        const float *pInB, float *pOutB, uint32_t Frames)
+{
+  const BIQUAD_CoeffsTypeDef ca = *pCoeffsA;
+  const BIQUAD_CoeffsTypeDef cb = *pCoeffsB;
+  float a1 = pStateA->s1;
+  float a2 = pStateA->s2;
+  float b1 = pStateB->s1;
+  float b2 = pStateB->s2;
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    float xa = pInA[i];
+    float xb = pInB[i];
+    float ya = ca.b0 * xa + a1;
+    float yb = cb.b0 * xb + b1;
+
+    a1 = ca.b1 * xa - ca.a1 * ya + a2;
+    b1 = cb.b1 * xb - cb.a1 * yb + b2;
+    a2 = ca.b2 * xa - ca.a2 * ya;
+    b2 = cb.b2 * xb - cb.a2 * yb;
+    pOutA[i] = ya;
+    pOutB[i] = yb;
+  }
+
+  pStateA->s1 = a1;
+  pStateA->s2 = a2;
+  pStateB->s1 = b1;
+  pStateB->s2 = b2;
+}
@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file    audio_ctrl.c
+  * @brief   Control-rate node scheduler.
+  *
+  *          Modulation sources and detectors rarely need a new value per
+  *          sample. Here they run once every 1 to 32 blocks and the audio
+  *          path reads a linearly interpolated output, so a node costs one
+  *          update per period plus a multiply-add per sample it is rendered.
+  *          Nodes sharing a divider are given different block slots so the
+  *          control work is spread evenly instead of piling up every N blocks.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_ctrl.h"
+#include "audio_trace.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CTRL_BLOCK_SECONDS        ((float)AUDIO_BLOCK_SIZE / (float)AUDIO_SAMPLE_RATE)
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes an empty scheduler.
+  * @param  hctrl pointer to the scheduler handle
+  * @retval None
+  */
+void CTRL_Init(CTRL_HandleTypeDef *hctrl)
+{
+  memset(hctrl, 0, sizeof(*hctrl));
+}
+
+/**
+  * @brief  Adds a node and picks its block slot.
+  * @note   The slot is the one whose busiest block is the least loaded, which
+  *         keeps the worst-case control cost per block as flat as possible.
+  *         Add nodes from slowest to fastest for the best spread.
+  * @param  hctrl pointer to the scheduler handle
+  * @param  pNode node storage, owned by the caller
+  * @param  Tick update function
+  * @param  Context passed to Tick
+  * @param  Divider blocks per update: 1, 2, 4 ... CTRL_MAX_DIVIDER
+  * @param  Cost relative update cost (e.g. cycles)
+  * @param  Initial output until the first update
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef CTRL_AddNode(CTRL_HandleTypeDef *hctrl, CTRL_NodeTypeDef *pNode,
+                                 CTRL_TickTypeDef Tick, void *Context,
+                                 uint32_t Divider, uint32_t Cost, float Initial)
+{
+  uint32_t best = 0U;
+  uint32_t bestPeak = UINT32_MAX;
+  uint32_t p;
+  uint32_t b;
+
+  if ((hctrl->NumNodes >= CTRL_MAX_NODES) || (Tick == NULL) || (Divider == 0U)
+      || (Divider > CTRL_MAX_DIVIDER) || ((Divider & (Divider - 1U)) != 0U))
+  {
+    return AUDIO_ERROR;
+  }
+
+  for (p = 0U; p < Divider; p++)
+  {
+    uint32_t peak = 0U;
+
+    for (b = p; b < CTRL_MAX_DIVIDER; b += Divider)
+    {
+      peak = AUDIO_MAX(peak, hctrl->Load[b]);
+    }
+    if (peak < bestPeak)
+    {
+      bestPeak = peak;
+      best = p;
+    }
+  }
+  for (b = best; b < CTRL_MAX_DIVIDER; b += Divider)
+  {
+    hctrl->Load[b] += Cost;
+  }
+
+  memset(pNode, 0, sizeof(*pNode));
+  pNode->Tick    = Tick;
+  pNode->Context = Context;
+  pNode->Divider = (uint8_t)Divider;
+  pNode->Phase   = (uint8_t)best;
+  pNode->Cost    = (uint16_t)AUDIO_MIN(Cost, 0xFFFFU);
+  pNode->Target  = Initial;
+  pNode->Current = Initial;
+  hctrl->pNodes[hctrl->NumNodes++] = pNode;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Advances all nodes by one block and updates the nodes due.
+  * @note   Called from the audio context once per block, before the audio
+  *         path renders or reads any node.
+  * @param  hctrl pointer to the scheduler handle
+  * @retval None
+  */
+void CTRL_Process(CTRL_HandleTypeDef *hctrl)
+{
+  uint32_t slot = hctrl->Block;
+  uint32_t i;
+
+  for (i = 0U; i < hctrl->NumNodes; i++)
+  {
+    CTRL_NodeTypeDef *n = hctrl->pNodes[i];
+
+    /* The ramp moves on by the block the audio path rendered last time */
+    if (n->Remaining != 0U)
+    {
+      n->Current += n->Step * (float)AUDIO_BLOCK_SIZE;
+      if (--n->Remaining == 0U)
+      {
+        n->Current = n->Target;
+        n->Step = 0.0f;
+      }
+    }
+
+    if ((slot & (n->Divider - 1U)) == n->Phase)
+    {
+      TRACE_EVENT(TRACE_EVT_NODE_BEGIN, i);
+      n->Target = n->Tick(n->Context, (float)n->Divider * CTRL_BLOCK_SECONDS);
+      TRACE_EVENT(TRACE_EVT_NODE_END, i);
+      n->Step = (n->Target - n->Current) / ((float)n->Divider * (float)AUDIO_BLOCK_SIZE);
+      n->Remaining = n->Divider;
+    }
+  }
+
+  hctrl->Block = (slot + 1U) & (CTRL_MAX_DIVIDER - 1U);
+}
+
+/**
+  * @brief  Writes the audio-rate output of a node for the current block.
+  * @note   Does not modify the node, so several consumers can render it.
+  * @param  pNode pointer to the node
+  * @param  pOut output samples
+  * @param  Frames number of frames, AUDIO_BLOCK_SIZE
+  * @retval None
+  */
+void CTRL_Render(const CTRL_NodeTypeDef *pNode, float *pOut, uint32_t Frames)
+{
+  float value = pNode->Current;
+  float step = pNode->Step;
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    value += step;
+    pOut[i] = value;
+  }
+}
+
+/**
+  * @brief  Returns the scheduled control cost of the busiest block.
+  * @param  hctrl pointer to the scheduler handle
+  * @retval Sum of the node costs updated in the busiest block
+  */
+uint32_t CTRL_GetPeakLoad(const CTRL_HandleTypeDef *hctrl)
+{
+  uint32_t peak = 0U;
+  uint32_t b;
+
+  for (b = 0U; b < CTRL_MAX_DIVIDER; b++)
+  {
+    peak = AUDIO_MAX(peak, hctrl->Load[b]);
+  }
+  return peak;
+}
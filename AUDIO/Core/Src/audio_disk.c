@@ -0,0 +1,482 @@
+/**
+  ******************************************************************************
+  * @file    audio_disk.c
+  * @brief   SD card I/O scheduler: deadline order, coalescing, write throttle.
+  *
+  *          Streaming voices, the recorder, the preset loader and the index
+  *          builder share one SDIO bus, and a card serves one command at a
+  *          time. Each user describes its transfer in a request with a
+  *          deadline, and DISK_Poll() decides from the background context
+  *          what the card does next:
+  *           - reads and writes wait in two queues, earliest deadline first,
+  *             then requests without one in submission order; the earlier
+  *             deadline of the two queue heads goes next;
+  *           - requests touching the same sectors keep their submission
+  *             order when a write is involved, whatever their deadlines;
+  *           - queued requests for adjacent or overlapping sectors in the
+  *             same direction join the one picked, up to DISK_MAX_SECTORS,
+  *             as one multi-block command costs about as much as one block;
+  *           - a write is held while a read deadline, queued or announced
+  *             with DISK_Expect(), is closer than a write and a read take:
+  *             a card programming flash can stall for tens of milliseconds
+  *             and a voice running dry is heard, where a recorder buffer
+  *             has room to spare. A write with a deadline is held for half
+  *             of it at most, keeping the other half for such a stall;
+  *           - a write without a deadline waits MaxHoldUs at most: then
+  *             it goes whatever the reads and the other writes, one such
+  *             write per MaxHoldUs, so a preset save still lands while
+  *             voices stream. The write cost estimate decays with time, not
+  *             with writes, so one erase stall does not hold them for good.
+  *          A single request lands in its own buffer; coalesced ones go
+  *          through a bounce buffer, as does one not 4-byte aligned for DMA.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_disk.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define DISK_READ                 0U
+#define DISK_WRITE                1U
+#define DISK_COST_SHIFT           3U      /* Read cost memory of ~8 transfers   */
+#define DISK_COST_DECAY_US        16000U  /* Write cost loses 1/8 per period    */
+#define DISK_BEFORE(a, b)         ((int32_t)((a) - (b)) < 0)
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t  DISK_Precedes(const DISK_RequestTypeDef *pA, const DISK_RequestTypeDef *pB);
+static void     DISK_Insert(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest);
+static void     DISK_Remove(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest);
+static DISK_RequestTypeDef *DISK_Blocker(const DISK_HandleTypeDef *hdisk, const DISK_RequestTypeDef *pRequest);
+static void     DISK_Decay(DISK_HandleTypeDef *hdisk, uint32_t Now);
+static DISK_RequestTypeDef *DISK_Overdue(const DISK_HandleTypeDef *hdisk, uint32_t Now);
+static DISK_RequestTypeDef *DISK_Pick(DISK_HandleTypeDef *hdisk, uint32_t Now);
+static void     DISK_Coalesce(DISK_HandleTypeDef *hdisk);
+static void     DISK_Start(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest, uint32_t Now);
+static void     DISK_Finish(DISK_HandleTypeDef *hdisk, uint32_t Now);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the I/O scheduler with empty queues.
+  * @param  hdisk pointer to the scheduler handle
+  * @param  pConfig card driver and clock
+  * @retval AUDIO_OK, or AUDIO_ERROR on a bad configuration
+  */
+AUDIO_StatusTypeDef DISK_Init(DISK_HandleTypeDef *hdisk, const DISK_ConfigTypeDef *pConfig)
+{
+  if ((pConfig->Transfer == NULL) || (pConfig->Now == NULL))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hdisk, 0, sizeof(*hdisk));
+  hdisk->Config = *pConfig;
+  if (hdisk->Config.MarginUs == 0U)
+  {
+    hdisk->Config.MarginUs = DISK_DEFAULT_MARGIN_US;
+  }
+  if (hdisk->Config.MaxHoldUs == 0U)
+  {
+    hdisk->Config.MaxHoldUs = DISK_DEFAULT_MAX_HOLD_US;
+  }
+  hdisk->CostAt = hdisk->Config.Now(hdisk->Config.Context);
+  hdisk->ForcedAt = hdisk->CostAt - hdisk->Config.MaxHoldUs;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Queues a request.
+  * @note   Called from the background context. The request is started by a
+  *         later DISK_Poll(); its buffer and the request itself must stay
+  *         untouched until its Status leaves AUDIO_BUSY.
+  * @param  hdisk pointer to the scheduler handle
+  * @param  pRequest request with Lba, Count, pBuffer, Write, DeadlineUs, and
+  *         optionally Done and Context set
+  * @retval AUDIO_OK, or AUDIO_ERROR on an empty or oversized request
+  */
+AUDIO_StatusTypeDef DISK_Submit(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest)
+{
+  if ((pRequest->Count == 0U) || (pRequest->Count > DISK_MAX_SECTORS) || (pRequest->pBuffer == NULL))
+  {
+    return AUDIO_ERROR;
+  }
+
+  pRequest->Write  = (pRequest->Write != 0U) ? DISK_WRITE : DISK_READ;
+  pRequest->Status = AUDIO_BUSY;
+  pRequest->Seq    = hdisk->Seq++;
+  pRequest->Due    = hdisk->Config.Now(hdisk->Config.Context)
+                     + ((pRequest->DeadlineUs != DISK_NO_DEADLINE) ? pRequest->DeadlineUs : hdisk->Config.MaxHoldUs);
+  pRequest->Late   = 0U;
+  DISK_Insert(hdisk, pRequest);
+  hdisk->Stats[pRequest->Write].Requests++;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Announces a read deadline ahead of its request.
+  * @note   For a user that issues its reads late to make them large, like
+  *         the streaming scheduler: writes are held as if a read were due
+  *         SlackUs from now. Call again as the slack changes, with
+  *         DISK_NO_DEADLINE when no read is coming.
+  * @param  hdisk pointer to the scheduler handle
+  * @param  SlackUs time until the read must be done, in microseconds
+  * @retval None
+  */
+void DISK_Expect(DISK_HandleTypeDef *hdisk, uint32_t SlackUs)
+{
+  hdisk->Expecting = (SlackUs != DISK_NO_DEADLINE) ? 1U : 0U;
+  hdisk->Expect = hdisk->Config.Now(hdisk->Config.Context) + SlackUs;
+}
+
+/**
+  * @brief  Completes the transfer in flight and starts the next one.
+  * @note   Called repeatedly from the background context. Done callbacks
+  *         run from here, after the request Status is set.
+  * @param  hdisk pointer to the scheduler handle
+  * @retval None
+  */
+void DISK_Poll(DISK_HandleTypeDef *hdisk)
+{
+  DISK_RequestTypeDef *next;
+  uint32_t now = hdisk->Config.Now(hdisk->Config.Context);
+
+  if (hdisk->Busy != 0U)
+  {
+    if (hdisk->Done == 0U)
+    {
+      return;
+    }
+    DISK_Finish(hdisk, now);
+  }
+
+  next = DISK_Pick(hdisk, now);
+  if (next != NULL)
+  {
+    DISK_Start(hdisk, next, now);
+  }
+}
+
+/**
+  * @brief  Transfer completion.
+  * @note   Called from the card driver, in any context.
+  * @param  hdisk pointer to the scheduler handle
+  * @param  Status AUDIO_OK if all sectors were transferred
+  * @retval None
+  */
+void DISK_TransferComplete(DISK_HandleTypeDef *hdisk, AUDIO_StatusTypeDef Status)
+{
+  hdisk->Result = Status;
+  hdisk->Done = 1U;
+}
+
+/**
+  * @brief  Tells whether the card has nothing left to do.
+  * @param  hdisk pointer to the scheduler handle
+  * @retval 1 when no transfer is in flight or queued, 0 otherwise
+  */
+uint8_t DISK_IsIdle(const DISK_HandleTypeDef *hdisk)
+{
+  return ((hdisk->Busy == 0U) && (hdisk->pQueue[DISK_READ] == NULL) && (hdisk->pQueue[DISK_WRITE] == NULL))
+         ? 1U : 0U;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/* Queue order: deadlines first, earliest first, then submission order */
+static uint8_t DISK_Precedes(const DISK_RequestTypeDef *pA, const DISK_RequestTypeDef *pB)
+{
+  uint8_t timedA = (pA->DeadlineUs != DISK_NO_DEADLINE) ? 1U : 0U;
+  uint8_t timedB = (pB->DeadlineUs != DISK_NO_DEADLINE) ? 1U : 0U;
+
+  if (timedA != timedB)
+  {
+    return timedA;
+  }
+  if ((timedA != 0U) && (pA->Due != pB->Due))
+  {
+    return DISK_BEFORE(pA->Due, pB->Due) ? 1U : 0U;
+  }
+  return DISK_BEFORE(pA->Seq, pB->Seq) ? 1U : 0U;
+}
+
+static void DISK_Insert(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest)
+{
+  DISK_RequestTypeDef **link = &hdisk->pQueue[pRequest->Write];
+
+  while ((*link != NULL) && (DISK_Precedes(*link, pRequest) != 0U))
+  {
+    link = &(*link)->pNext;
+  }
+  pRequest->pNext = *link;
+  *link = pRequest;
+}
+
+static void DISK_Remove(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest)
+{
+  DISK_RequestTypeDef **link = &hdisk->pQueue[pRequest->Write];
+
+  while (*link != pRequest)
+  {
+    link = &(*link)->pNext;
+  }
+  *link = pRequest->pNext;
+  pRequest->pNext = NULL;
+}
+
+/* The oldest queued request the given one must not overtake: an earlier
+   write to any of its sectors, or an earlier read of them if it writes */
+static DISK_RequestTypeDef *DISK_Blocker(const DISK_HandleTypeDef *hdisk, const DISK_RequestTypeDef *pRequest)
+{
+  DISK_RequestTypeDef *oldest = NULL;
+  DISK_RequestTypeDef *r;
+  uint32_t q;
+
+  for (q = 0U; q < 2U; q++)
+  {
+    if ((q == DISK_READ) && (pRequest->Write == DISK_READ))
+    {
+      continue;
+    }
+    for (r = hdisk->pQueue[q]; r != NULL; r = r->pNext)
+    {
+      if (DISK_BEFORE(r->Seq, pRequest->Seq) && (r->Lba < (pRequest->Lba + pRequest->Count))
+          && (pRequest->Lba < (r->Lba + r->Count))
+          && ((oldest == NULL) || DISK_BEFORE(r->Seq, oldest->Seq)))
+      {
+        oldest = r;
+      }
+    }
+  }
+  return oldest;
+}
+
+/* Ages the write cost by 1/8 per period, from when it was last aged */
+static void DISK_Decay(DISK_HandleTypeDef *hdisk, uint32_t Now)
+{
+  while ((Now - hdisk->CostAt) >= DISK_COST_DECAY_US)
+  {
+    if ((hdisk->WriteCostUs >> DISK_COST_SHIFT) == 0U)
+    {
+      hdisk->CostAt = Now;
+      break;
+    }
+    hdisk->WriteCostUs -= hdisk->WriteCostUs >> DISK_COST_SHIFT;
+    hdisk->CostAt += DISK_COST_DECAY_US;
+  }
+}
+
+/* The oldest write without a deadline, once its hold is over and no
+   other went for as long */
+static DISK_RequestTypeDef *DISK_Overdue(const DISK_HandleTypeDef *hdisk, uint32_t Now)
+{
+  DISK_RequestTypeDef *r = hdisk->pQueue[DISK_WRITE];
+
+  while ((r != NULL) && (r->DeadlineUs != DISK_NO_DEADLINE))
+  {
+    r = r->pNext;
+  }
+  if ((r == NULL) || DISK_BEFORE(Now, r->Due) || ((Now - hdisk->ForcedAt) < hdisk->Config.MaxHoldUs))
+  {
+    return NULL;
+  }
+  return r;
+}
+
+/* Earliest deadline of the two queue heads, writes held for reads at risk */
+static DISK_RequestTypeDef *DISK_Pick(DISK_HandleTypeDef *hdisk, uint32_t Now)
+{
+  DISK_RequestTypeDef *read = hdisk->pQueue[DISK_READ];
+  DISK_RequestTypeDef *write = hdisk->pQueue[DISK_WRITE];
+  DISK_RequestTypeDef *pick;
+  DISK_RequestTypeDef *blocker;
+  uint32_t risk;
+  uint8_t pressed = 0U;
+  uint32_t due = 0U;
+
+  DISK_Decay(hdisk, Now);
+  risk = hdisk->WriteCostUs + hdisk->ReadCostUs + hdisk->Config.MarginUs;
+  if ((read != NULL) && (read->DeadlineUs != DISK_NO_DEADLINE))
+  {
+    pressed = 1U;
+    due = read->Due;
+  }
+  if ((hdisk->Expecting != 0U) && ((pressed == 0U) || DISK_BEFORE(hdisk->Expect, due)))
+  {
+    pressed = 1U;
+    due = hdisk->Expect;
+  }
+
+  if ((pick = DISK_Overdue(hdisk, Now)) != NULL)
+  {
+    /* Held long enough: it goes, reads or not */
+    hdisk->ForcedAt = Now;
+    hdisk->Forced++;
+  }
+  else if ((write != NULL) && ((read == NULL) || (DISK_Precedes(write, read) != 0U)))
+  {
+    pick = write;
+    /* Held for half its own deadline at most, the rest being for a stall */
+    if ((hdisk->Config.NoThrottle == 0U) && (pressed != 0U) && DISK_BEFORE(due, Now + risk)
+        && ((write->DeadlineUs == DISK_NO_DEADLINE)
+            || !DISK_BEFORE(write->Due, Now + AUDIO_MAX(hdisk->WriteCostUs + hdisk->Config.MarginUs,
+                                                          write->DeadlineUs / 2U))))
+    {
+      /* The write can wait, the read cannot: serve it, or keep the card free */
+      if (hdisk->Holding == 0U)
+      {
+        hdisk->Holding = 1U;
+        hdisk->Throttled++;
+      }
+      pick = read;
+    }
+  }
+  else
+  {
+    pick = read;
+  }
+
+  /* Never overtake an earlier request on the same sectors */
+  while ((pick != NULL) && ((blocker = DISK_Blocker(hdisk, pick)) != NULL))
+  {
+    pick = blocker;
+  }
+  return pick;
+}
+
+/* Grows the transfer in flight with queued requests next to it */
+static void DISK_Coalesce(DISK_HandleTypeDef *hdisk)
+{
+  DISK_RequestTypeDef *r;
+  DISK_RequestTypeDef *next;
+  uint8_t changed;
+
+  do
+  {
+    changed = 0U;
+    for (r = hdisk->pQueue[hdisk->Write]; (r != NULL) && (hdisk->NumFlight < DISK_MAX_MERGE); r = next)
+    {
+      uint32_t end = hdisk->Lba + hdisk->Count;
+      uint32_t lba = AUDIO_MIN(hdisk->Lba, r->Lba);
+      uint32_t count = AUDIO_MAX(end, r->Lba + r->Count) - lba;
+
+      next = r->pNext;
+      if (hdisk->Write == DISK_WRITE)
+      {
+        /* Writes only back to back: overlapping ones keep their order */
+        if (((r->Lba + r->Count) != hdisk->Lba) && (r->Lba != end))
+        {
+          continue;
+        }
+      }
+      else if ((r->Lba > end) || ((r->Lba + r->Count) < hdisk->Lba))
+      {
+        continue;
+      }
+      if ((count > DISK_MAX_SECTORS) || (DISK_Blocker(hdisk, r) != NULL))
+      {
+        continue;
+      }
+      DISK_Remove(hdisk, r);
+      hdisk->pFlight[hdisk->NumFlight++] = r;
+      hdisk->Lba = lba;
+      hdisk->Count = count;
+      changed = 1U;
+    }
+  } while ((changed != 0U) && (hdisk->NumFlight < DISK_MAX_MERGE));
+}
+
+static void DISK_Start(DISK_HandleTypeDef *hdisk, DISK_RequestTypeDef *pRequest, uint32_t Now)
+{
+  uint8_t *buffer = pRequest->pBuffer;
+  uint32_t i;
+
+  DISK_Remove(hdisk, pRequest);
+  if (pRequest->Write == DISK_WRITE)
+  {
+    hdisk->Holding = 0U;
+  }
+  hdisk->pFlight[0] = pRequest;
+  hdisk->NumFlight = 1U;
+  hdisk->Write = pRequest->Write;
+  hdisk->Lba = pRequest->Lba;
+  hdisk->Count = pRequest->Count;
+  DISK_Coalesce(hdisk);
+
+  hdisk->Bounced = ((hdisk->NumFlight > 1U) || (((uintptr_t)buffer & 3U) != 0U)) ? 1U : 0U;
+  if (hdisk->Bounced != 0U)
+  {
+    buffer = (uint8_t *)hdisk->Bounce;
+    for (i = 0U; (i < hdisk->NumFlight) && (hdisk->Write == DISK_WRITE); i++)
+    {
+      const DISK_RequestTypeDef *r = hdisk->pFlight[i];
+
+      memcpy(&buffer[(r->Lba - hdisk->Lba) * DISK_SECTOR_SIZE], r->pBuffer, r->Count * DISK_SECTOR_SIZE);
+    }
+  }
+
+  hdisk->Stats[hdisk->Write].Transfers++;
+  hdisk->Stats[hdisk->Write].Sectors += hdisk->Count;
+  hdisk->Started = Now;
+  hdisk->Done = 0U;
+  hdisk->Busy = 1U;
+  if (hdisk->Config.Transfer(hdisk->Config.Context, hdisk->Write, hdisk->Lba, hdisk->Count,
+                             buffer) != AUDIO_OK)
+  {
+    hdisk->Result = AUDIO_ERROR;
+    hdisk->Done = 1U;
+  }
+}
+
+/* Hands the transfer result to its requests and learns what it cost */
+static void DISK_Finish(DISK_HandleTypeDef *hdisk, uint32_t Now)
+{
+  DISK_StatsTypeDef *stats = &hdisk->Stats[hdisk->Write];
+  uint32_t *cost = (hdisk->Write == DISK_WRITE) ? &hdisk->WriteCostUs : &hdisk->ReadCostUs;
+  uint32_t elapsed = Now - hdisk->Started;
+  AUDIO_StatusTypeDef status = hdisk->Result;
+  uint32_t i;
+
+  hdisk->Busy = 0U;
+  if ((status == AUDIO_OK) && (hdisk->Write == DISK_WRITE))
+  {
+    /* Writes by their recent worst: a stall is what a held write avoids */
+    *cost = AUDIO_MAX(elapsed, *cost);
+  }
+  else if (status == AUDIO_OK)
+  {
+    *cost = *cost + (elapsed >> DISK_COST_SHIFT) - (*cost >> DISK_COST_SHIFT);
+  }
+  else
+  {
+    stats->Errors++;
+  }
+
+  for (i = 0U; i < hdisk->NumFlight; i++)
+  {
+    DISK_RequestTypeDef *r = hdisk->pFlight[i];
+
+    if ((status == AUDIO_OK) && (hdisk->Bounced != 0U) && (hdisk->Write == DISK_READ))
+    {
+      memcpy(r->pBuffer, (const uint8_t *)hdisk->Bounce + ((r->Lba - hdisk->Lba) * DISK_SECTOR_SIZE),
+             r->Count * DISK_SECTOR_SIZE);
+    }
+    if ((r->DeadlineUs != DISK_NO_DEADLINE) && DISK_BEFORE(r->Due, Now))
+    {
+      r->Late = Now - r->Due;
+      stats->Missed++;
+      stats->WorstLate = AUDIO_MAX(stats->WorstLate, r->Late);
+    }
+    r->Status = status;
+    if (r->Done != NULL)
+    {
+      r->Done(r->Context, r);
+    }
+  }
+  hdisk->NumFlight = 0U;
+}
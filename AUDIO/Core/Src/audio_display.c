@@ -0,0 +1,542 @@
+/**
+  ******************************************************************************
+  * @file    audio_display.c
+  * @brief   Tiled framebuffer with dirty tracking, level meters and scope.
+  *
+  *          Drawing is done in a 4-bit palette framebuffer and marks the
+  *          DISPLAY_TILE square tiles it touches. The flush (audio_lcd.c)
+  *          takes the dirty tiles back as few rectangles as possible and
+  *          expands only those rows to RGB565 on their way to the DMA, so a
+  *          meter that moved by a few rows costs a few tiles on the link
+  *          instead of a full frame.
+  *
+  *          The audio side only feeds: a meter keeps the block peak and a
+  *          scope copies a triggered, decimated capture. Everything else,
+  *          ballistics included, runs in the background at the frame rate.
+  *          No hardware access: the host renderer builds this file as is.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_display.h"
+#include "audio_fastmath.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define DISPLAY_RGB565(r, g, b)   ((uint16_t)((((r) & 0xF8U) << 8) | (((g) & 0xFCU) << 3) | ((b) >> 3)))
+#define DISPLAY_METER_FALL_DB     0.5f    /*!< Per frame, 15 dB/s at 30 fps     */
+#define DISPLAY_METER_HOLD        45U     /*!< Frames, 1.5 s at 30 fps          */
+#define DISPLAY_METER_YELLOW_DB   (-18.0f)
+#define DISPLAY_METER_RED_DB      (-6.0f)
+#define DISPLAY_SCOPE_AUTO        4U      /*!< Screens without a trigger        */
+
+/* Private variables ---------------------------------------------------------*/
+static const uint16_t DisplayPalette[16] =
+{
+  DISPLAY_RGB565(0U, 0U, 0U),       DISPLAY_RGB565(48U, 48U, 48U),
+  DISPLAY_RGB565(128U, 128U, 128U), DISPLAY_RGB565(255U, 255U, 255U),
+  DISPLAY_RGB565(0U, 232U, 64U),    DISPLAY_RGB565(0U, 56U, 16U),
+  DISPLAY_RGB565(255U, 216U, 0U),   DISPLAY_RGB565(64U, 54U, 0U),
+  DISPLAY_RGB565(255U, 32U, 32U),   DISPLAY_RGB565(64U, 8U, 8U),
+  DISPLAY_RGB565(0U, 216U, 255U),   DISPLAY_RGB565(32U, 64U, 255U),
+  0U, 0U, 0U, 0U
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void    DISPLAY_Plot(DISPLAY_HandleTypeDef *hdisp, uint32_t X, uint32_t Y, uint8_t Color);
+static uint8_t DISPLAY_MeterColor(const DISPLAY_MeterTypeDef *pMeter, uint32_t Row, uint32_t Bar);
+static void    DISPLAY_MeterRow(DISPLAY_HandleTypeDef *hdisp, const DISPLAY_MeterTypeDef *pMeter,
+                                uint32_t Row, uint8_t Color);
+static uint8_t DISPLAY_ScopeBackground(const DISPLAY_ScopeTypeDef *pScope, uint32_t Row);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Clears the framebuffer and marks all of it, with the default
+  *         palette.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  Background palette index of the clear color
+  * @retval None
+  */
+void DISPLAY_Init(DISPLAY_HandleTypeDef *hdisp, uint8_t Background)
+{
+  memcpy(hdisp->Palette, DisplayPalette, sizeof(hdisp->Palette));
+  memset(hdisp->Pixels, (int)((Background & 0x0FU) * 0x11U), sizeof(hdisp->Pixels));
+  DISPLAY_MarkAll(hdisp);
+}
+
+/**
+  * @brief  Fills a rectangle, clipped to the panel, and marks it.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  X left column
+  * @param  Y top row
+  * @param  W width
+  * @param  H height
+  * @param  Color palette index
+  * @retval None
+  */
+void DISPLAY_Fill(DISPLAY_HandleTypeDef *hdisp, uint32_t X, uint32_t Y, uint32_t W,
+                  uint32_t H, uint8_t Color)
+{
+  uint8_t both = (uint8_t)((Color & 0x0FU) * 0x11U);
+  uint32_t x1;
+  uint32_t y;
+
+  if ((X >= DISPLAY_WIDTH) || (Y >= DISPLAY_HEIGHT))
+  {
+    return;
+  }
+  W = AUDIO_MIN(W, DISPLAY_WIDTH - X);
+  H = AUDIO_MIN(H, DISPLAY_HEIGHT - Y);
+  x1 = X + W;
+
+  for (y = Y; y < (Y + H); y++)
+  {
+    uint8_t *row = &hdisp->Pixels[y * DISPLAY_STRIDE];
+    uint32_t x = X;
+
+    if ((x & 1U) != 0U)
+    {
+      row[x / 2U] = (uint8_t)((row[x / 2U] & 0x0FU) | (both & 0xF0U));
+      x++;
+    }
+    if (x1 > x)
+    {
+      memset(&row[x / 2U], both, (x1 - x) / 2U);
+      if ((x1 & 1U) != 0U)
+      {
+        row[x1 / 2U] = (uint8_t)((row[x1 / 2U] & 0xF0U) | (both & 0x0FU));
+      }
+    }
+  }
+  DISPLAY_Mark(hdisp, X, Y, W, H);
+}
+
+/**
+  * @brief  Marks a rectangle for the next flush, without drawing.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  X left column
+  * @param  Y top row
+  * @param  W width
+  * @param  H height
+  * @retval None
+  */
+void DISPLAY_Mark(DISPLAY_HandleTypeDef *hdisp, uint32_t X, uint32_t Y, uint32_t W, uint32_t H)
+{
+  uint32_t tx0;
+  uint32_t tx1;
+  uint32_t ty;
+  uint32_t bits;
+
+  if ((W == 0U) || (H == 0U) || (X >= DISPLAY_WIDTH) || (Y >= DISPLAY_HEIGHT))
+  {
+    return;
+  }
+  tx0 = X / DISPLAY_TILE;
+  tx1 = (AUDIO_MIN(X + W, DISPLAY_WIDTH) - 1U) / DISPLAY_TILE;
+  bits = ((tx1 - tx0) == 31U) ? 0xFFFFFFFFU : (((1U << (tx1 - tx0 + 1U)) - 1U) << tx0);
+  for (ty = Y / DISPLAY_TILE; ty <= ((AUDIO_MIN(Y + H, DISPLAY_HEIGHT) - 1U) / DISPLAY_TILE); ty++)
+  {
+    hdisp->Dirty[ty] |= bits;
+  }
+}
+
+/**
+  * @brief  Marks the whole panel, after it lost its content.
+  * @param  hdisp pointer to the framebuffer handle
+  * @retval None
+  */
+void DISPLAY_MarkAll(DISPLAY_HandleTypeDef *hdisp)
+{
+  DISPLAY_Mark(hdisp, 0U, 0U, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+}
+
+/**
+  * @brief  Takes the next dirty rectangle and clears its tiles.
+  * @note   The first run of dirty tiles of the topmost dirty row, grown down
+  *         over the rows where the same run is dirty too: a meter bar or a
+  *         scope comes out as one tall rectangle, one window command.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  pRect receives the rectangle, in pixels
+  * @retval 1 if a rectangle was taken, 0 when everything is clean
+  */
+uint8_t DISPLAY_NextRegion(DISPLAY_HandleTypeDef *hdisp, DISPLAY_RectTypeDef *pRect)
+{
+  uint32_t ty = 0U;
+  uint32_t ty1;
+  uint32_t tx0 = 0U;
+  uint32_t tx1;
+  uint32_t run;
+
+  while ((ty < DISPLAY_TILES_Y) && (hdisp->Dirty[ty] == 0U))
+  {
+    ty++;
+  }
+  if (ty == DISPLAY_TILES_Y)
+  {
+    return 0U;
+  }
+  while ((hdisp->Dirty[ty] & (1U << tx0)) == 0U)
+  {
+    tx0++;
+  }
+  tx1 = tx0;
+  while ((tx1 < DISPLAY_TILES_X) && ((hdisp->Dirty[ty] & (1U << tx1)) != 0U))
+  {
+    tx1++;
+  }
+  run = ((tx1 - tx0) == 32U) ? 0xFFFFFFFFU : (((1U << (tx1 - tx0)) - 1U) << tx0);
+  ty1 = ty;
+  while ((ty1 < DISPLAY_TILES_Y) && ((hdisp->Dirty[ty1] & run) == run))
+  {
+    hdisp->Dirty[ty1] &= ~run;
+    ty1++;
+  }
+
+  pRect->X = (uint16_t)(tx0 * DISPLAY_TILE);
+  pRect->Y = (uint16_t)(ty * DISPLAY_TILE);
+  pRect->W = (uint16_t)((tx1 - tx0) * DISPLAY_TILE);
+  pRect->H = (uint16_t)((ty1 - ty) * DISPLAY_TILE);
+  return 1U;
+}
+
+/**
+  * @brief  Expands rows of a rectangle to RGB565, in panel write order.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  pRect rectangle from DISPLAY_NextRegion()
+  * @param  Row first row, relative to the rectangle
+  * @param  Rows number of rows
+  * @param  pOut receives Rows * pRect->W pixels
+  * @retval None
+  */
+void DISPLAY_Pack(const DISPLAY_HandleTypeDef *hdisp, const DISPLAY_RectTypeDef *pRect,
+                  uint32_t Row, uint32_t Rows, uint16_t *pOut)
+{
+  uint32_t y;
+  uint32_t i;
+
+  for (y = pRect->Y + Row; y < (pRect->Y + Row + Rows); y++)
+  {
+    /* Rectangles are tile aligned, so X is even: whole bytes */
+    const uint8_t *src = &hdisp->Pixels[(y * DISPLAY_STRIDE) + (pRect->X / 2U)];
+
+    for (i = 0U; i < (pRect->W / 2U); i++)
+    {
+      *pOut++ = hdisp->Palette[src[i] & 0x0FU];
+      *pOut++ = hdisp->Palette[src[i] >> 4];
+    }
+  }
+}
+
+/**
+  * @brief  Sets up a meter and draws it empty.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  pMeter pointer to the meter
+  * @param  pArea meter rectangle, inside the panel
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef DISPLAY_MeterInit(DISPLAY_HandleTypeDef *hdisp, DISPLAY_MeterTypeDef *pMeter,
+                                      const DISPLAY_RectTypeDef *pArea)
+{
+  uint32_t r;
+
+  if (((pArea->X + pArea->W) > DISPLAY_WIDTH) || ((pArea->Y + pArea->H) > DISPLAY_HEIGHT)
+      || (pArea->W == 0U) || (pArea->H < 2U))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(pMeter, 0, sizeof(*pMeter));
+  pMeter->Area = *pArea;
+  pMeter->FallDb = DISPLAY_METER_FALL_DB;
+  pMeter->HoldFrames = DISPLAY_METER_HOLD;
+  pMeter->LevelDb = DISPLAY_METER_FLOOR_DB;
+  pMeter->HoldDb = DISPLAY_METER_FLOOR_DB;
+  for (r = 0U; r < pArea->H; r++)
+  {
+    DISPLAY_MeterRow(hdisp, pMeter, r, DISPLAY_MeterColor(pMeter, r, 0U));
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Feeds a block to a meter.
+  * @note   Called from the audio interrupt: a peak search, nothing else.
+  * @param  pMeter pointer to the meter
+  * @param  pSamples block
+  * @param  Size number of samples
+  * @retval None
+  */
+void DISPLAY_MeterFeed(DISPLAY_MeterTypeDef *pMeter, const float *pSamples, uint32_t Size)
+{
+  uint32_t side = pMeter->Side;
+  float peak = pMeter->Peak[side];
+  uint32_t i;
+
+  for (i = 0U; i < Size; i++)
+  {
+    float a = (pSamples[i] < 0.0f) ? -pSamples[i] : pSamples[i];
+
+    peak = AUDIO_MAX(peak, a);
+  }
+  pMeter->Peak[side] = peak;
+}
+
+/**
+  * @brief  Applies the ballistics to the peak fed since the last frame and
+  *         redraws the rows that changed.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  pMeter pointer to the meter
+  * @retval None
+  */
+void DISPLAY_MeterDraw(DISPLAY_HandleTypeDef *hdisp, DISPLAY_MeterTypeDef *pMeter)
+{
+  uint32_t side = pMeter->Side;
+  float h = (float)pMeter->Area.H;
+  float peak;
+  float db = DISPLAY_METER_FLOOR_DB;
+  uint32_t bar;
+  uint32_t mark = 0U;
+  uint32_t lo;
+  uint32_t hi;
+  uint32_t r;
+
+  /* Audio moves to the other slot; this one is ours until the next frame */
+  pMeter->Side = (uint8_t)(side ^ 1U);
+  peak = pMeter->Peak[side];
+  pMeter->Peak[side] = 0.0f;
+  if (peak > 0.0f)
+  {
+    db = AUDIO_MAX(FASTMATH_PowerToDb(peak * peak), DISPLAY_METER_FLOOR_DB);
+  }
+
+  pMeter->LevelDb = AUDIO_MAX(db, pMeter->LevelDb - pMeter->FallDb);
+  if (db >= pMeter->HoldDb)
+  {
+    pMeter->HoldDb = db;
+    pMeter->HoldCount = pMeter->HoldFrames;
+  }
+  else if (pMeter->HoldCount > 0U)
+  {
+    pMeter->HoldCount--;
+  }
+  else
+  {
+    pMeter->HoldDb = AUDIO_MAX(pMeter->HoldDb - pMeter->FallDb, DISPLAY_METER_FLOOR_DB);
+  }
+
+  bar = (uint32_t)((((pMeter->LevelDb / -DISPLAY_METER_FLOOR_DB) + 1.0f) * h) + 0.5f);
+  bar = AUDIO_MIN(bar, pMeter->Area.H);
+  if (pMeter->HoldDb > DISPLAY_METER_FLOOR_DB)
+  {
+    mark = (uint32_t)((((pMeter->HoldDb / -DISPLAY_METER_FLOOR_DB) + 1.0f) * h) + 0.5f);
+    mark = AUDIO_CLAMP(mark, 1U, (uint32_t)pMeter->Area.H);
+  }
+
+  /* Rows that changed lit state */
+  lo = AUDIO_MIN(bar, pMeter->Bar);
+  hi = AUDIO_MAX(bar, pMeter->Bar);
+  for (r = lo; r < hi; r++)
+  {
+    DISPLAY_MeterRow(hdisp, pMeter, r, DISPLAY_MeterColor(pMeter, r, bar));
+  }
+  if ((pMeter->Mark != 0U) && (pMeter->Mark != mark))
+  {
+    r = pMeter->Mark - 1U;
+    DISPLAY_MeterRow(hdisp, pMeter, r, DISPLAY_MeterColor(pMeter, r, bar));
+  }
+  if ((mark != 0U) && ((mark != pMeter->Mark) || (((mark - 1U) >= lo) && ((mark - 1U) < hi))))
+  {
+    DISPLAY_MeterRow(hdisp, pMeter, mark - 1U, DISPLAY_WHITE);
+  }
+  pMeter->Bar = (uint16_t)bar;
+  pMeter->Mark = (uint16_t)mark;
+}
+
+/**
+  * @brief  Sets up a scope and draws it empty.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  pScope pointer to the scope
+  * @param  pArea scope rectangle, inside the panel, at most
+  *         DISPLAY_SCOPE_POINTS wide and 256 high
+  * @param  Decimate samples per column, 1 or more
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef DISPLAY_ScopeInit(DISPLAY_HandleTypeDef *hdisp, DISPLAY_ScopeTypeDef *pScope,
+                                      const DISPLAY_RectTypeDef *pArea, uint32_t Decimate)
+{
+  uint32_t r;
+
+  if (((pArea->X + pArea->W) > DISPLAY_WIDTH) || ((pArea->Y + pArea->H) > DISPLAY_HEIGHT)
+      || (pArea->W < 2U) || (pArea->W > DISPLAY_SCOPE_POINTS) || (pArea->H < 3U)
+      || (pArea->H > 256U) || (Decimate == 0U))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(pScope, 0, sizeof(*pScope));
+  pScope->Area = *pArea;
+  pScope->Decimate = Decimate;
+  for (r = 0U; r < pArea->H; r++)
+  {
+    DISPLAY_Fill(hdisp, pArea->X, pArea->Y + r, pArea->W, 1U, DISPLAY_ScopeBackground(pScope, r));
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Feeds a block to a scope.
+  * @note   Called from the audio interrupt. Does nothing while a capture
+  *         waits to be drawn.
+  * @param  pScope pointer to the scope
+  * @param  pSamples block
+  * @param  Size number of samples
+  * @retval None
+  */
+void DISPLAY_ScopeFeed(DISPLAY_ScopeTypeDef *pScope, const float *pSamples, uint32_t Size)
+{
+  uint32_t autoLimit = DISPLAY_SCOPE_AUTO * pScope->Area.W * pScope->Decimate;
+  uint32_t i;
+
+  if (pScope->Ready != 0U)
+  {
+    return;
+  }
+  for (i = 0U; i < Size; i++)
+  {
+    float s = pSamples[i];
+
+    if (pScope->Armed == 0U)
+    {
+      pScope->Waited++;
+      if (((pScope->Last < 0.0f) && (s >= 0.0f)) || (pScope->Waited >= autoLimit))
+      {
+        pScope->Armed = 1U;
+        pScope->Count = 0U;
+        pScope->Skip = 0U;
+      }
+      pScope->Last = s;
+    }
+    if (pScope->Armed != 0U)
+    {
+      if (pScope->Skip == 0U)
+      {
+        pScope->Capture[pScope->Count++] = s;
+        pScope->Skip = pScope->Decimate;
+        if (pScope->Count == pScope->Area.W)
+        {
+          pScope->Armed = 0U;
+          pScope->Waited = 0U;
+          pScope->Last = s;
+          pScope->Ready = 1U;
+          return;
+        }
+      }
+      pScope->Skip--;
+    }
+  }
+}
+
+/**
+  * @brief  Replaces the drawn trace with the latest capture, if any.
+  * @note   Only the pixels of the old and new trace are written and marked.
+  * @param  hdisp pointer to the framebuffer handle
+  * @param  pScope pointer to the scope
+  * @retval None
+  */
+void DISPLAY_ScopeDraw(DISPLAY_HandleTypeDef *hdisp, DISPLAY_ScopeTypeDef *pScope)
+{
+  const DISPLAY_RectTypeDef *a = &pScope->Area;
+  float half = (float)(a->H - 1U) * 0.5f;
+  uint32_t prev = 0U;
+  uint32_t x;
+  uint32_t r;
+
+  if (pScope->Ready == 0U)
+  {
+    return;
+  }
+
+  for (x = 0U; x < a->W; x++)
+  {
+    float s = AUDIO_CLAMP(pScope->Capture[x], -1.0f, 1.0f);
+    uint32_t y = (uint32_t)((half * (1.0f - s)) + 0.5f);
+    uint32_t lo = (x == 0U) ? y : AUDIO_MIN(y, prev);
+    uint32_t hi = (x == 0U) ? y : AUDIO_MAX(y, prev);
+
+    if (pScope->Drawn != 0U)
+    {
+      for (r = pScope->Lo[x]; r <= pScope->Hi[x]; r++)
+      {
+        if ((r < lo) || (r > hi))
+        {
+          DISPLAY_Plot(hdisp, a->X + x, a->Y + r, DISPLAY_ScopeBackground(pScope, r));
+        }
+      }
+      DISPLAY_Mark(hdisp, a->X + x, a->Y + pScope->Lo[x], 1U, (pScope->Hi[x] - pScope->Lo[x]) + 1U);
+    }
+    for (r = lo; r <= hi; r++)
+    {
+      DISPLAY_Plot(hdisp, a->X + x, a->Y + r, DISPLAY_GREEN);
+    }
+    DISPLAY_Mark(hdisp, a->X + x, a->Y + lo, 1U, (hi - lo) + 1U);
+    pScope->Lo[x] = (uint8_t)lo;
+    pScope->Hi[x] = (uint8_t)hi;
+    prev = y;
+  }
+  pScope->Drawn = 1U;
+  /* Re-arm: the audio side may write Capture again from here */
+  pScope->Ready = 0U;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void DISPLAY_Plot(DISPLAY_HandleTypeDef *hdisp, uint32_t X, uint32_t Y, uint8_t Color)
+{
+  uint8_t *p = &hdisp->Pixels[(Y * DISPLAY_STRIDE) + (X / 2U)];
+
+  if ((X & 1U) != 0U)
+  {
+    *p = (uint8_t)((*p & 0x0FU) | (uint8_t)(Color << 4));
+  }
+  else
+  {
+    *p = (uint8_t)((*p & 0xF0U) | (Color & 0x0FU));
+  }
+}
+
+/* Segment color of a row counted from the bottom, lit below Bar */
+static uint8_t DISPLAY_MeterColor(const DISPLAY_MeterTypeDef *pMeter, uint32_t Row, uint32_t Bar)
+{
+  float db = DISPLAY_METER_FLOOR_DB
+             * (1.0f - (((float)Row + 0.5f) / (float)pMeter->Area.H));
+  uint8_t lit = (uint8_t)(Row < Bar);
+
+  if (db >= DISPLAY_METER_RED_DB)
+  {
+    return (lit != 0U) ? DISPLAY_RED : DISPLAY_DARK_RED;
+  }
+  if (db >= DISPLAY_METER_YELLOW_DB)
+  {
+    return (lit != 0U) ? DISPLAY_YELLOW : DISPLAY_DARK_YELLOW;
+  }
+  return (lit != 0U) ? DISPLAY_GREEN : DISPLAY_DARK_GREEN;
+}
+
+static void DISPLAY_MeterRow(DISPLAY_HandleTypeDef *hdisp, const DISPLAY_MeterTypeDef *pMeter,
+                             uint32_t Row, uint8_t Color)
+{
+  DISPLAY_Fill(hdisp, pMeter->Area.X, (pMeter->Area.Y + pMeter->Area.H) - 1U - Row,
+               pMeter->Area.W, 1U, Color);
+}
+
+/* Scope background row, rows from the top: black with a centre line */
+static uint8_t DISPLAY_ScopeBackground(const DISPLAY_ScopeTypeDef *pScope, uint32_t Row)
+{
+  return (Row == ((pScope->Area.H - 1U) / 2U)) ? DISPLAY_DARK_GREY : DISPLAY_BLACK;
+}
@@ -0,0 +1,170 @@
+/**
+  ******************************************************************************
+  * @file    audio_drum.c
+  * @brief   Drum machine engine: step sequencer driving sample voices.
+  *
+  *          A block is rendered in segments split at the trigger offsets
+  *          reported by the sequencer, so every hit starts on its exact frame
+  *          while the block size stays unchanged.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_drum.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define DRUM_Q15_SCALE            (1.0f / 32768.0f)
+
+/* Private function prototypes -----------------------------------------------*/
+static void DRUM_RenderVoices(DRUM_HandleTypeDef *hdrum, float *pLeft, float *pRight,
+                              uint32_t Frames);
+static void DRUM_Trigger(DRUM_HandleTypeDef *hdrum, const SEQ_EventTypeDef *pEvent);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the drum machine with all tracks at unity level.
+  * @param  hdrum pointer to the drum machine handle
+  * @param  pPattern pattern to play
+  * @retval None
+  */
+void DRUM_Init(DRUM_HandleTypeDef *hdrum, const SEQ_PatternTypeDef *pPattern)
+{
+  uint32_t i;
+
+  memset(hdrum->Samples, 0, sizeof(hdrum->Samples));
+  SEQ_Init(&hdrum->Seq, pPattern);
+  for (i = 0U; i < SEQ_MAX_TRACKS; i++)
+  {
+    VOICE_Init(&hdrum->Voices[i]);
+  }
+  hdrum->NextService = 0U;
+}
+
+/**
+  * @brief  Assigns a sample to a track.
+  * @param  hdrum pointer to the drum machine handle
+  * @param  Track track index
+  * @param  pSource sample source, or NULL to mute the track
+  * @retval None
+  */
+void DRUM_SetSample(DRUM_HandleTypeDef *hdrum, uint32_t Track, const VOICE_SourceTypeDef *pSource)
+{
+  if (Track < SEQ_MAX_TRACKS)
+  {
+    VOICE_Stop(&hdrum->Voices[Track]);
+    hdrum->Samples[Track] = pSource;
+  }
+}
+
+/**
+  * @brief  Renders one block of the drum machine into a stereo buffer.
+  * @note   Called from the audio context. The output buffers are overwritten.
+  * @param  hdrum pointer to the drum machine handle
+  * @param  pLeft left output buffer
+  * @param  pRight right output buffer
+  * @param  Frames block length in frames
+  * @retval None
+  */
+void DRUM_Process(DRUM_HandleTypeDef *hdrum, float *pLeft, float *pRight, uint32_t Frames)
+{
+  uint32_t count = SEQ_Process(&hdrum->Seq, Frames, hdrum->Events, SEQ_MAX_EVENTS);
+  uint32_t pos = 0U;
+  uint32_t i;
+
+  memset(pLeft, 0, Frames * sizeof(float));
+  memset(pRight, 0, Frames * sizeof(float));
+
+  for (i = 0U; i < count; i++)
+  {
+    const SEQ_EventTypeDef *ev = &hdrum->Events[i];
+
+    if (ev->Offset > pos)
+    {
+      DRUM_RenderVoices(hdrum, &pLeft[pos], &pRight[pos], ev->Offset - pos);
+      pos = ev->Offset;
+    }
+    DRUM_Trigger(hdrum, ev);
+  }
+  DRUM_RenderVoices(hdrum, &pLeft[pos], &pRight[pos], Frames - pos);
+}
+
+/**
+  * @brief  Tops up the prefetch ring of one streamed voice.
+  * @note   Called repeatedly from the background context.
+  * @param  hdrum pointer to the drum machine handle
+  * @retval None
+  */
+void DRUM_Service(DRUM_HandleTypeDef *hdrum)
+{
+  uint32_t i;
+
+  for (i = 0U; i < SEQ_MAX_TRACKS; i++)
+  {
+    uint32_t track = hdrum->NextService;
+
+    hdrum->NextService = (track + 1U) % SEQ_MAX_TRACKS;
+    if (VOICE_Service(&hdrum->Voices[track]) != 0U)
+    {
+      break;
+    }
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Mixes all voices over a segment.
+  * @param  hdrum pointer to the drum machine handle
+  * @param  pLeft left accumulation buffer
+  * @param  pRight right accumulation buffer
+  * @param  Frames segment length
+  * @retval None
+  */
+static void DRUM_RenderVoices(DRUM_HandleTypeDef *hdrum, float *pLeft, float *pRight,
+                              uint32_t Frames)
+{
+  uint32_t i;
+
+  for (i = 0U; i < SEQ_MAX_TRACKS; i++)
+  {
+    VOICE_Render(&hdrum->Voices[i], pLeft, pRight, Frames);
+  }
+}
+
+/**
+  * @brief  Converts a sequencer event into voice parameters and starts it.
+  * @note   The transcendental math runs once per hit, never per sample.
+  * @param  hdrum pointer to the drum machine handle
+  * @param  pEvent trigger with the locked parameters
+  * @retval None
+  */
+static void DRUM_Trigger(DRUM_HandleTypeDef *hdrum, const SEQ_EventTypeDef *pEvent)
+{
+  const VOICE_SourceTypeDef *src = hdrum->Samples[pEvent->Track];
+  const int16_t *p = pEvent->Params;
+  VOICE_ParamsTypeDef params;
+
+  if (src == NULL)
+  {
+    return;
+  }
+
+  params.Level = (float)p[SEQ_PARAM_LEVEL] * DRUM_Q15_SCALE * ((float)pEvent->Velocity / 127.0f);
+  params.Pan   = (float)p[SEQ_PARAM_PAN] * DRUM_Q15_SCALE;
+  params.Rate  = exp2f((float)p[SEQ_PARAM_PITCH] / 1200.0f);
+  params.Start = (uint32_t)(((uint64_t)(uint16_t)p[SEQ_PARAM_START] * src->Length) >> 15);
+  /* Decay to -60 dB over the requested time */
+  params.Decay = (p[SEQ_PARAM_DECAY] > 0)
+               ? expf(-6.9078f / ((float)p[SEQ_PARAM_DECAY] * (AUDIO_SAMPLE_RATE / 1000.0f)))
+               : 1.0f;
+
+  VOICE_Trigger(&hdrum->Voices[pEvent->Track], src, &params);
+}
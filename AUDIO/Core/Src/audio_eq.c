@@ -0,0 +1,417 @@
+/**
+  ******************************************************************************
+  * @file    audio_eq.c
+  * @brief   Live parametric equalizer with a fast coefficient designer.
+  *
+  *          Every band shape is first written as a second-order analog
+  *          prototype in s normalized to the band frequency. The RBJ design
+  *          maps it with the prewarped bilinear transform, which reduces to
+  *          one sine/cosine pair and one division. The matched design places
+  *          the poles by impulse invariance and solves the zeros so the
+  *          magnitude equals the analog one at DC, at the band frequency and
+  *          at Nyquist; it removes the bilinear cramping of high bands for
+  *          two exponentials, a sine and a few square roots more. All
+  *          transcendental math goes through audio_fastmath.h; the cost of
+  *          one matched design is tracked by the eq_design_matched entry of
+  *          audio_bench.c, and AUDIO/Tools/eq_check.c checks the accuracy
+  *          of both designs against the analog prototypes.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_eq.h"
+#include "audio_fastmath.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define EQ_PI                     3.14159265f
+#define EQ_MIN_FREQ               10.0f
+#define EQ_MAX_FREQ               (0.49f * (float)AUDIO_SAMPLE_RATE)
+#define EQ_MIN_Q                  0.1f
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief  H(s) = (N2 s^2 + N1 s + N0) / (D2 s^2 + D1 s + D0), s in units of
+  *         the band frequency
+  */
+typedef struct
+{
+  float N2;
+  float N1;
+  float N0;
+  float D2;
+  float D1;
+  float D0;
+} EQ_AnalogTypeDef;
+
+/* Private function prototypes -----------------------------------------------*/
+static void  EQ_Prototype(const EQ_BandTypeDef *pBand, EQ_AnalogTypeDef *pProto);
+static void  EQ_Bilinear(const EQ_AnalogTypeDef *pProto, float w0, BIQUAD_CoeffsTypeDef *pCoeffs);
+static void  EQ_Matched(const EQ_AnalogTypeDef *pProto, float w0, BIQUAD_CoeffsTypeDef *pCoeffs);
+static float EQ_OneMinusExp(float x);
+static float EQ_AnalogPower(const EQ_AnalogTypeDef *pProto, float x);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the equalizer with all bands flat.
+  * @param  heq pointer to the equalizer handle
+  * @param  Design analog to digital mapping used for every band
+  * @param  NumBands number of bands, up to EQ_MAX_BANDS
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef EQ_Init(EQ_HandleTypeDef *heq, EQ_DesignTypeDef Design, uint32_t NumBands)
+{
+  uint32_t i;
+
+  if (NumBands > EQ_MAX_BANDS)
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(heq, 0, sizeof(*heq));
+  heq->Design   = Design;
+  heq->NumBands = NumBands;
+  for (i = 0U; i < NumBands; i++)
+  {
+    heq->Bands[i].Type   = EQ_PEAKING;
+    heq->Bands[i].Freq   = 1000.0f;
+    heq->Bands[i].Q      = 1.0f;
+    heq->Bands[i].GainDb = 0.0f;
+    heq->Coeffs[i].b0    = 1.0f;
+    heq->Target[i].b0    = 1.0f;
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Changes the parameters of one band.
+  * @note   Called from the control context. A band edited again before the
+  *         audio side picked it up is simply designed once, with the latest
+  *         values.
+  * @param  heq pointer to the equalizer handle
+  * @param  Band band index
+  * @param  pBand new parameters
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef EQ_SetBand(EQ_HandleTypeDef *heq, uint32_t Band, const EQ_BandTypeDef *pBand)
+{
+  if (Band >= heq->NumBands)
+  {
+    return AUDIO_ERROR;
+  }
+
+  heq->Bands[Band] = *pBand;
+  /* A block preempting this read-modify-write can only leave a redundant bit */
+  heq->Pending |= 1UL << Band;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Redesigns the edited bands, advances the glides and filters a block.
+  * @note   Called from the audio context.
+  * @param  heq pointer to the equalizer handle
+  * @param  pIn input samples
+  * @param  pOut output samples, may alias pIn
+  * @param  Frames number of frames
+  * @retval None
+  */
+void EQ_Process(EQ_HandleTypeDef *heq, const float *pIn, float *pOut, uint32_t Frames)
+{
+  uint32_t pending = heq->Pending;
+  uint32_t i;
+
+  if (pending != 0U)
+  {
+    heq->Pending = 0U;
+    for (i = 0U; i < heq->NumBands; i++)
+    {
+      BIQUAD_CoeffsTypeDef *t = &heq->Target[i];
+      BIQUAD_CoeffsTypeDef *c = &heq->Coeffs[i];
+      BIQUAD_CoeffsTypeDef *s = &heq->Step[i];
+      const float k = 1.0f / (float)EQ_RAMP_BLOCKS;
+
+      if ((pending & (1UL << i)) == 0U)
+      {
+        continue;
+      }
+      EQ_Design(&heq->Bands[i], heq->Design, t);
+      s->b0 = (t->b0 - c->b0) * k;
+      s->b1 = (t->b1 - c->b1) * k;
+      s->b2 = (t->b2 - c->b2) * k;
+      s->a1 = (t->a1 - c->a1) * k;
+      s->a2 = (t->a2 - c->a2) * k;
+      heq->Ramp[i] = (uint8_t)EQ_RAMP_BLOCKS;
+    }
+  }
+
+  if (pOut != pIn)
+  {
+    memcpy(pOut, pIn, Frames * sizeof(float));
+  }
+  for (i = 0U; i < heq->NumBands; i++)
+  {
+    BIQUAD_CoeffsTypeDef *c = &heq->Coeffs[i];
+
+    if (heq->Ramp[i] != 0U)
+    {
+      if (--heq->Ramp[i] == 0U)
+      {
+        /* Land exactly on the design, whatever the rounding of the steps */
+        *c = heq->Target[i];
+      }
+      else
+      {
+        const BIQUAD_CoeffsTypeDef *s = &heq->Step[i];
+
+        c->b0 += s->b0;
+        c->b1 += s->b1;
+        c->b2 += s->b2;
+        c->a1 += s->a1;
+        c->a2 += s->a2;
+      }
+    }
+    BIQUAD_Process(c, &heq->State[i], pOut, pOut, Frames);
+  }
+}
+
+/**
+  * @brief  Designs the biquad of one band.
+  * @note   Safe in any context; frequency and Q are clamped to a usable range.
+  * @param  pBand band parameters
+  * @param  Design analog to digital mapping
+  * @param  pCoeffs receives the normalized coefficients
+  * @retval None
+  */
+void EQ_Design(const EQ_BandTypeDef *pBand, EQ_DesignTypeDef Design, BIQUAD_CoeffsTypeDef *pCoeffs)
+{
+  EQ_AnalogTypeDef proto;
+  float w0 = 2.0f * EQ_PI * AUDIO_CLAMP(pBand->Freq, EQ_MIN_FREQ, EQ_MAX_FREQ)
+             / (float)AUDIO_SAMPLE_RATE;
+
+  EQ_Prototype(pBand, &proto);
+  if (Design == EQ_DESIGN_MATCHED)
+  {
+    EQ_Matched(&proto, w0, pCoeffs);
+  }
+  else
+  {
+    EQ_Bilinear(&proto, w0, pCoeffs);
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Writes the analog prototype of a band (RBJ cookbook shapes).
+  * @param  pBand band parameters
+  * @param  pProto receives the prototype
+  * @retval None
+  */
+static void EQ_Prototype(const EQ_BandTypeDef *pBand, EQ_AnalogTypeDef *pProto)
+{
+  float q = AUDIO_MAX(pBand->Q, EQ_MIN_Q);
+  float A = FASTMATH_DbToGain(0.5f * pBand->GainDb);   /* sqrt of the linear gain */
+  float sa = FASTMATH_DbToGain(0.25f * pBand->GainDb);  /* sqrt(A) */
+
+  switch (pBand->Type)
+  {
+    case EQ_PEAKING:
+      pProto->N2 = 1.0f; pProto->N1 = A / q;       pProto->N0 = 1.0f;
+      pProto->D2 = 1.0f; pProto->D1 = 1.0f / (A * q); pProto->D0 = 1.0f;
+      break;
+
+    case EQ_LOWSHELF:
+      pProto->N2 = A;    pProto->N1 = A * sa / q;  pProto->N0 = A * A;
+      pProto->D2 = A;    pProto->D1 = sa / q;      pProto->D0 = 1.0f;
+      break;
+
+    case EQ_HIGHSHELF:
+      pProto->N2 = A * A; pProto->N1 = A * sa / q; pProto->N0 = A;
+      pProto->D2 = 1.0f;  pProto->D1 = sa / q;     pProto->D0 = A;
+      break;
+
+    case EQ_LOWPASS:
+      pProto->N2 = 0.0f; pProto->N1 = 0.0f;        pProto->N0 = 1.0f;
+      pProto->D2 = 1.0f; pProto->D1 = 1.0f / q;    pProto->D0 = 1.0f;
+      break;
+
+    case EQ_HIGHPASS:
+      pProto->N2 = 1.0f; pProto->N1 = 0.0f;        pProto->N0 = 0.0f;
+      pProto->D2 = 1.0f; pProto->D1 = 1.0f / q;    pProto->D0 = 1.0f;
+      break;
+
+    case EQ_BANDPASS:
+      pProto->N2 = 0.0f; pProto->N1 = 1.0f / q;    pProto->N0 = 0.0f;
+      pProto->D2 = 1.0f; pProto->D1 = 1.0f / q;    pProto->D0 = 1.0f;
+      break;
+
+    default: /* EQ_NOTCH */
+      pProto->N2 = 1.0f; pProto->N1 = 0.0f;        pProto->N0 = 1.0f;
+      pProto->D2 = 1.0f; pProto->D1 = 1.0f / q;    pProto->D0 = 1.0f;
+      break;
+  }
+}
+
+/**
+  * @brief  Bilinear transform prewarped at the band frequency.
+  * @note   s = (1/K)(1 - z^-1)/(1 + z^-1) with K = tan(w0/2) = sn/cs; both
+  *         polynomials are scaled by cs^2, which leaves one division.
+  * @param  pProto analog prototype
+  * @param  w0 band frequency, radians per sample
+  * @param  pCoeffs receives the normalized coefficients
+  * @retval None
+  */
+static void EQ_Bilinear(const EQ_AnalogTypeDef *pProto, float w0, BIQUAD_CoeffsTypeDef *pCoeffs)
+{
+  float sn;
+  float cs;
+  float cc;
+  float sc;
+  float ss;
+  float inv;
+
+  FASTMATH_SinCos(0.5f * w0, &sn, &cs);
+  cc = cs * cs;
+  sc = sn * cs;
+  ss = sn * sn;
+
+  inv = 1.0f / (pProto->D2 * cc + pProto->D1 * sc + pProto->D0 * ss);
+  pCoeffs->b0 = (pProto->N2 * cc + pProto->N1 * sc + pProto->N0 * ss) * inv;
+  pCoeffs->b1 = 2.0f * (pProto->N0 * ss - pProto->N2 * cc) * inv;
+  pCoeffs->b2 = (pProto->N2 * cc - pProto->N1 * sc + pProto->N0 * ss) * inv;
+  pCoeffs->a1 = 2.0f * (pProto->D0 * ss - pProto->D2 * cc) * inv;
+  pCoeffs->a2 = (pProto->D2 * cc - pProto->D1 * sc + pProto->D0 * ss) * inv;
+}
+
+/**
+  * @brief  Matched design: impulse-invariant poles, zeros solved on |H|^2.
+  * @note   With phi1 = sin^2(w/2) and phi0 = 1 - phi1, the squared magnitude
+  *         of b0 + b1 z^-1 + b2 z^-2 only depends on its values at DC (beta0)
+  *         and Nyquist (beta1) and on b0 b2. Matching DC, w0 and Nyquist to
+  *         the analog response then gives b0 and b2 as the roots of
+  *         t^2 - W t - B2/4, W = (beta0 + beta1)/2, with
+  *         W^2 + B2 = (Hw |A(w0)|^2 - (phi0 beta0 - phi1 beta1)^2) / (4 phi0 phi1).
+  *         When that is negative the three points cannot all be met; the
+  *         Nyquist match is dropped, as in Vicanek's high-pass.
+  *         Everything is written with the pole distances to z = 1 (sigma =
+  *         2 + a1, S0 = 1 + a1 + a2) so low bands keep their precision in
+  *         single precision instead of cancelling against a1 = -2, a2 = 1.
+  * @param  pProto analog prototype
+  * @param  w0 band frequency, radians per sample
+  * @param  pCoeffs receives the normalized coefficients
+  * @retval None
+  */
+static void EQ_Matched(const EQ_AnalogTypeDef *pProto, float w0, BIQUAD_CoeffsTypeDef *pCoeffs)
+{
+  float wp = sqrtf(pProto->D0 / pProto->D2);
+  float zeta = 0.5f * pProto->D1 / sqrtf(pProto->D0 * pProto->D2);
+  float theta = wp * w0;
+  float sigma;
+  float s0;
+  float a2;
+  float poles;
+  float phi0;
+  float phi1;
+  float beta0;
+  float beta1;
+  float target;
+  float m;
+  float w;
+  float d;
+  float sn;
+  float cs;
+
+  /* Poles, as sigma = (1 - p1) + (1 - p2) and S0 = (1 - p1)(1 - p2) */
+  if (zeta < 1.0f)
+  {
+    float u = EQ_OneMinusExp(zeta * theta);
+    float r = 1.0f - u;
+    float v;
+
+    FASTMATH_SinCos(0.5f * AUDIO_MIN(theta * sqrtf(1.0f - zeta * zeta), EQ_PI), &sn, &cs);
+    v = sn * sn;
+    sigma = 2.0f * (u + 2.0f * r * v);
+    s0 = u * u + 4.0f * r * v;
+  }
+  else
+  {
+    float root = sqrtf(zeta * zeta - 1.0f);
+    float e1 = EQ_OneMinusExp((zeta - root) * theta);
+    float e2 = EQ_OneMinusExp((zeta + root) * theta);
+
+    sigma = e1 + e2;
+    s0 = e1 * e2;
+  }
+  a2 = 1.0f - sigma + s0;
+
+  /* |A(w0)|^2 = S0^2 + phi1 (A1 - A0 - 16 a2) + 16 a2 phi1^2 */
+  FASTMATH_SinCos(0.5f * w0, &sn, &cs);
+  phi1 = sn * sn;
+  phi0 = cs * cs;
+  poles = s0 * s0 + phi1 * (4.0f * (sigma * sigma - (2.0f + sigma) * s0) + 16.0f * a2 * phi1);
+
+  /* Zeros: magnitude matched at DC, w0 and Nyquist */
+  target = EQ_AnalogPower(pProto, 1.0f) * poles;
+  beta0 = s0 * sqrtf(EQ_AnalogPower(pProto, 0.0f));
+  beta1 = (4.0f - 2.0f * sigma + s0) * sqrtf(EQ_AnalogPower(pProto, EQ_PI / w0));
+  m = phi0 * beta0 - phi1 * beta1;
+  d = target - m * m;
+  if ((d < 0.0f) || ((pProto->N0 == 0.0f) && (pProto->N1 == 0.0f)))
+  {
+    /* No real zeros reach the w0 level with that Nyquist gain (shelves and
+       peaks near Nyquist, notches), or a high-pass, which needs both zeros
+       at DC: match DC and w0 only, with b0 = b2 and the Nyquist value that
+       makes m^2 the target. Clamping d to 0 instead would keep the Nyquist
+       gain and put both zeros on the unit circle below w0, a notch */
+    beta1 = (phi0 * beta0 - sqrtf(target)) / phi1;
+    d = 0.0f;
+  }
+  w = 0.5f * (beta0 + beta1);
+  d = sqrtf(d / (4.0f * phi0 * phi1));
+
+  pCoeffs->b0 = 0.5f * (w + d);
+  pCoeffs->b1 = 0.5f * (beta0 - beta1);
+  pCoeffs->b2 = 0.5f * (w - d);
+  pCoeffs->a1 = sigma - 2.0f;
+  pCoeffs->a2 = a2;
+}
+
+/**
+  * @brief  1 - e^-x, accurate for small x as well.
+  * @param  x non-negative argument
+  * @retval 1 - e^-x
+  */
+static float EQ_OneMinusExp(float x)
+{
+  if (x < 0.25f)
+  {
+    /* Series, truncation below 2e-8 relative */
+    return x * (1.0f - x * 0.5f * (1.0f - x * (1.0f / 3.0f) * (1.0f - x * 0.25f
+                * (1.0f - x * 0.2f * (1.0f - x * (1.0f / 6.0f))))));
+  }
+  return 1.0f - FASTMATH_Exp(-x);
+}
+
+/**
+  * @brief  Analog power gain |H(jx)|^2.
+  * @param  pProto analog prototype
+  * @param  x frequency in units of the band frequency
+  * @retval Power gain
+  */
+static float EQ_AnalogPower(const EQ_AnalogTypeDef *pProto, float x)
+{
+  float x2 = x * x;
+  float nr = pProto->N0 - pProto->N2 * x2;
+  float ni = pProto->N1 * x;
+  float dr = pProto->D0 - pProto->D2 * x2;
+  float di = pProto->D1 * x;
+
+  return (nr * nr + ni * ni) / (dr * dr + di * di);
+}
@@ -0,0 +1,297 @@
+/**
+  ******************************************************************************
+  * @file    audio_fbs.c
+  * @brief   Adaptive acoustic feedback (howl) suppressor.
+  *
+  *          The audio path only runs the notch biquads and copies its output
+  *          into an analysis ring. FBS_Analyze(), called from the background
+  *          loop, looks at the spectrum of that output: a narrow peak standing
+  *          well above the average level for several consecutive frames is a
+  *          howl. It then gets a notch, or its existing notch is deepened.
+  *          Notches are held, then released slowly, and are freed once
+  *          shallow.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_fbs.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define FBS_PI                    3.14159265f
+#define FBS_FRAME_RATE            ((float)AUDIO_SAMPLE_RATE / (float)FBS_HOP)
+#define FBS_BIN_HZ                ((float)AUDIO_SAMPLE_RATE / (float)FBS_FFT_SIZE)
+/** Howls closer than this (in octaves) share one notch */
+#define FBS_MERGE_OCTAVES         (1.0f / 24.0f)
+/** A released notch shallower than this is freed */
+#define FBS_FREE_DB               (-0.5f)
+
+/* Private function prototypes -----------------------------------------------*/
+static void FBS_AddNotch(FBS_HandleTypeDef *hfbs, float Freq);
+static void FBS_Publish(FBS_HandleTypeDef *hfbs);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the suppressor with no notch engaged.
+  * @param  hfbs pointer to the suppressor handle
+  * @param  pConfig detector and release tuning
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef FBS_Init(FBS_HandleTypeDef *hfbs, const FBS_ConfigTypeDef *pConfig)
+{
+  uint32_t i;
+
+  memset(hfbs, 0, sizeof(*hfbs));
+  hfbs->Config = *pConfig;
+  if (FFT_Init(&hfbs->Fft, FBS_FFT_SIZE) != AUDIO_OK)
+  {
+    return AUDIO_ERROR;
+  }
+  for (i = 0U; i < FBS_FFT_SIZE; i++)
+  {
+    hfbs->Window[i] = 0.5f - 0.5f * cosf(2.0f * FBS_PI * (float)i / (float)FBS_FFT_SIZE);
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Runs the notch filters over a block and feeds the analysis ring.
+  * @note   Called from the audio context.
+  * @param  hfbs pointer to the suppressor handle
+  * @param  pIn input samples
+  * @param  pOut output samples, may alias pIn
+  * @param  Frames number of frames
+  * @retval None
+  */
+void FBS_Process(FBS_HandleTypeDef *hfbs, const float *pIn, float *pOut, uint32_t Frames)
+{
+  uint8_t bank = hfbs->ActiveBank;
+  uint32_t count = hfbs->BankCount[bank];
+  uint32_t pos = hfbs->Written;
+  uint32_t i;
+
+  if (pOut != pIn)
+  {
+    memcpy(pOut, pIn, Frames * sizeof(float));
+  }
+  for (i = 0U; i < count; i++)
+  {
+    BIQUAD_Process(&hfbs->Bank[bank][i], &hfbs->State[i], pOut, pOut, Frames);
+  }
+
+  for (i = 0U; i < Frames; i++)
+  {
+    hfbs->Ring[(pos + i) % FBS_RING_SIZE] = pOut[i];
+  }
+  hfbs->Written = pos + Frames;
+}
+
+/**
+  * @brief  Runs one detection frame if enough new audio is available.
+  * @note   Called from the background context, never from an interrupt.
+  * @param  hfbs pointer to the suppressor handle
+  * @retval Number of active notches, or 0 if no frame was analyzed
+  */
+uint32_t FBS_Analyze(FBS_HandleTypeDef *hfbs)
+{
+  const FBS_ConfigTypeDef *cfg = &hfbs->Config;
+  uint32_t written = hfbs->Written;
+  uint32_t kmin = AUDIO_MAX((uint32_t)(cfg->MinHz / FBS_BIN_HZ), 2U);
+  uint32_t kmax = AUDIO_MIN((uint32_t)(cfg->MaxHz / FBS_BIN_HZ), FBS_FFT_SIZE / 2U - 2U);
+  float *p = hfbs->Frame;
+  float mean = 0.0f;
+  float threshold;
+  float release;
+  uint8_t prev;
+  uint32_t active = 0U;
+  uint32_t i;
+  uint32_t k;
+
+  if ((written - hfbs->Analyzed < FBS_HOP) || (kmax <= kmin))
+  {
+    return 0U;
+  }
+  hfbs->Analyzed = written;
+
+  /* The ring holds twice the frame: the audio side cannot catch up with the copy */
+  for (i = 0U; i < FBS_FFT_SIZE; i++)
+  {
+    p[i] = hfbs->Ring[(written - FBS_FFT_SIZE + i) % FBS_RING_SIZE] * hfbs->Window[i];
+  }
+  FFT_Real(&hfbs->Fft, p);
+
+  /* Power spectrum in place: bin k only reads entries 2k and 2k+1 */
+  for (k = 1U; k < FBS_FFT_SIZE / 2U; k++)
+  {
+    p[k] = p[2U * k] * p[2U * k] + p[2U * k + 1U] * p[2U * k + 1U];
+  }
+  for (k = kmin; k <= kmax; k++)
+  {
+    mean += p[k];
+  }
+  mean /= (float)(kmax - kmin + 1U);
+  threshold = mean * powf(10.0f, cfg->PaprDb / 10.0f) + 1e-12f;
+
+  /* Persistence: a peak may drift by one bin between frames */
+  prev = hfbs->Persist[kmin - 1U];
+  for (k = kmin; k <= kmax; k++)
+  {
+    uint8_t cur = hfbs->Persist[k];
+
+    if ((p[k] > threshold) && (p[k] >= p[k - 1U]) && (p[k] > p[k + 1U]))
+    {
+      uint8_t best = AUDIO_MAX(AUDIO_MAX(prev, cur), hfbs->Persist[k + 1U]);
+
+      hfbs->Persist[k] = (uint8_t)AUDIO_MIN(best + 1U, 255U);
+      if (hfbs->Persist[k] >= cfg->Persistence)
+      {
+        /* Parabolic interpolation on the log spectrum for sub-bin accuracy */
+        float a = logf(p[k - 1U] + 1e-20f);
+        float b = logf(p[k] + 1e-20f);
+        float c = logf(p[k + 1U] + 1e-20f);
+        float den = a - 2.0f * b + c;
+        float delta = (den < 0.0f) ? 0.5f * (a - c) / den : 0.0f;
+
+        FBS_AddNotch(hfbs, ((float)k + delta) * FBS_BIN_HZ);
+        hfbs->Persist[k] = 0U;
+      }
+    }
+    else
+    {
+      hfbs->Persist[k] = 0U;
+    }
+    prev = cur;
+  }
+
+  /* Hold, then slow release */
+  release = cfg->ReleaseDbPerSec / FBS_FRAME_RATE;
+  for (i = 0U; i < FBS_MAX_NOTCHES; i++)
+  {
+    FBS_NotchTypeDef *n = &hfbs->Notches[i];
+
+    if (n->Active == 0U)
+    {
+      continue;
+    }
+    if (n->Hold > 0U)
+    {
+      n->Hold--;
+    }
+    else
+    {
+      n->DepthDb += release;
+      if (n->DepthDb > FBS_FREE_DB)
+      {
+        n->Active = 0U;
+        continue;
+      }
+    }
+    active++;
+  }
+
+  FBS_Publish(hfbs);
+  return active;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Deepens the notch covering a frequency, or engages a new one.
+  * @note   With every notch in use, the shallowest one is reassigned.
+  * @param  hfbs pointer to the suppressor handle
+  * @param  Freq howl frequency in Hz
+  * @retval None
+  */
+static void FBS_AddNotch(FBS_HandleTypeDef *hfbs, float Freq)
+{
+  FBS_NotchTypeDef *slot = NULL;
+  uint32_t i;
+
+  for (i = 0U; i < FBS_MAX_NOTCHES; i++)
+  {
+    FBS_NotchTypeDef *n = &hfbs->Notches[i];
+
+    if ((n->Active != 0U) && (fabsf(log2f(Freq / n->Freq)) < FBS_MERGE_OCTAVES))
+    {
+      n->DepthDb = AUDIO_MAX(n->DepthDb + FBS_STEP_DB, FBS_MAX_DEPTH_DB);
+      n->Freq    = 0.5f * (n->Freq + Freq);
+      n->Hold    = (uint32_t)(hfbs->Config.HoldSeconds * FBS_FRAME_RATE);
+      return;
+    }
+  }
+
+  for (i = 0U; i < FBS_MAX_NOTCHES; i++)
+  {
+    FBS_NotchTypeDef *n = &hfbs->Notches[i];
+
+    if (n->Active == 0U)
+    {
+      slot = n;
+      break;
+    }
+    if ((slot == NULL) || (n->DepthDb > slot->DepthDb))
+    {
+      slot = n;
+    }
+  }
+
+  slot->Active  = 1U;
+  slot->Freq    = Freq;
+  slot->DepthDb = FBS_STEP_DB;
+  slot->Hold    = (uint32_t)(hfbs->Config.HoldSeconds * FBS_FRAME_RATE);
+}
+
+/**
+  * @brief  Designs the active notches into the idle bank and switches the
+  *         audio path over to it.
+  * @param  hfbs pointer to the suppressor handle
+  * @retval None
+  */
+static void FBS_Publish(FBS_HandleTypeDef *hfbs)
+{
+  uint8_t bank = hfbs->ActiveBank ^ 1U;
+  uint32_t count = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < FBS_MAX_NOTCHES; i++)
+  {
+    const FBS_NotchTypeDef *n = &hfbs->Notches[i];
+    BIQUAD_CoeffsTypeDef *c = &hfbs->Bank[bank][i];
+
+    if (n->Active == 0U)
+    {
+      /* Keep the slot position so each notch keeps its filter state */
+      c->b0 = 1.0f;
+      c->b1 = 0.0f;
+      c->b2 = 0.0f;
+      c->a1 = 0.0f;
+      c->a2 = 0.0f;
+    }
+    else
+    {
+      /* RBJ peaking EQ with negative gain */
+      float A = powf(10.0f, n->DepthDb / 40.0f);
+      float w0 = 2.0f * FBS_PI * n->Freq / (float)AUDIO_SAMPLE_RATE;
+      float alpha = sinf(w0) / (2.0f * FBS_NOTCH_Q);
+      float cw = cosf(w0);
+      float a0 = 1.0f + alpha / A;
+
+      c->b0 = (1.0f + alpha * A) / a0;
+      c->b1 = -2.0f * cw / a0;
+      c->b2 = (1.0f - alpha * A) / a0;
+      c->a1 = -2.0f * cw / a0;
+      c->a2 = (1.0f - alpha / A) / a0;
+      count = i + 1U;
+    }
+  }
+
+  hfbs->BankCount[bank] = (uint8_t)count;
+  hfbs->ActiveBank = bank;
+}
@@ -0,0 +1,165 @@
+/**
+  ******************************************************************************
+  * @file    audio_fft.c
+  * @brief   Radix-2 FFT kernels.
+  *
+  *          A real transform of N points runs as a complex transform of N/2
+  *          points followed by a split pass, which halves the work. All tables
+  *          are built once by FFT_Init(); the transforms themselves use no
+  *          transcendental functions.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_fft.h"
+#include <math.h>
+
+/* Private define ------------------------------------------------------------*/
+#define FFT_PI                    3.14159265358979f
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Builds the tables for a transform length.
+  * @param  hfft pointer to the FFT handle
+  * @param  Size real transform length, power of two from 4 to FFT_MAX_SIZE
+  * @retval AUDIO_OK or AUDIO_ERROR on an unsupported length
+  */
+AUDIO_StatusTypeDef FFT_Init(FFT_HandleTypeDef *hfft, uint32_t Size)
+{
+  uint32_t half = Size / 2U;
+  uint32_t bits = 0U;
+  uint32_t k;
+
+  if ((Size < 4U) || (Size > FFT_MAX_SIZE) || ((Size & (Size - 1U)) != 0U))
+  {
+    return AUDIO_ERROR;
+  }
+  while ((1UL << bits) < half)
+  {
+    bits++;
+  }
+
+  hfft->Size = Size;
+  for (k = 0U; k < half; k++)
+  {
+    uint32_t r = 0U;
+    uint32_t b;
+
+    hfft->Twiddle[2U * k]      = cosf(2.0f * FFT_PI * (float)k / (float)Size);
+    hfft->Twiddle[2U * k + 1U] = sinf(2.0f * FFT_PI * (float)k / (float)Size);
+    for (b = 0U; b < bits; b++)
+    {
+      r |= ((k >> b) & 1U) << (bits - 1U - b);
+    }
+    hfft->BitRev[k] = (uint16_t)r;
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  In-place forward complex FFT of Size/2 points.
+  * @param  hfft pointer to the FFT handle
+  * @param  pData Size/2 interleaved complex values (re, im)
+  * @retval None
+  */
+void FFT_Complex(const FFT_HandleTypeDef *hfft, float *pData)
+{
+  const uint32_t n = hfft->Size / 2U;
+  uint32_t len;
+  uint32_t i;
+  uint32_t j;
+
+  for (i = 0U; i < n; i++)
+  {
+    uint32_t r = hfft->BitRev[i];
+
+    if (r > i)
+    {
+      float re = pData[2U * i];
+      float im = pData[2U * i + 1U];
+
+      pData[2U * i]      = pData[2U * r];
+      pData[2U * i + 1U] = pData[2U * r + 1U];
+      pData[2U * r]      = re;
+      pData[2U * r + 1U] = im;
+    }
+  }
+
+  for (len = 2U; len <= n; len <<= 1)
+  {
+    uint32_t half = len / 2U;
+    /* Twiddle table has Size/2 entries of W_Size: W_len^j = W_Size^(j * Size / len) */
+    uint32_t stride = hfft->Size / len;
+
+    for (j = 0U; j < half; j++)
+    {
+      float wr = hfft->Twiddle[2U * j * stride];
+      float wi = -hfft->Twiddle[2U * j * stride + 1U];
+
+      for (i = j; i < n; i += len)
+      {
+        float *a = &pData[2U * i];
+        float *b = &pData[2U * (i + half)];
+        float tr = wr * b[0] - wi * b[1];
+        float ti = wr * b[1] + wi * b[0];
+
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+/**
+  * @brief  In-place forward real FFT of Size points.
+  * @note   Output packing: pData[0] = X[0], pData[1] = X[N/2] (both real),
+  *         then pData[2k], pData[2k+1] = Re, Im of X[k] for 0 < k < N/2.
+  * @param  hfft pointer to the FFT handle
+  * @param  pData Size real samples, replaced by the packed spectrum
+  * @retval None
+  */
+void FFT_Real(const FFT_HandleTypeDef *hfft, float *pData)
+{
+  const uint32_t n = hfft->Size / 2U;
+  float dc;
+  float ny;
+  uint32_t k;
+
+  /* Even samples in the real parts, odd samples in the imaginary parts */
+  FFT_Complex(hfft, pData);
+
+  dc = pData[0] + pData[1];
+  ny = pData[0] - pData[1];
+
+  for (k = 1U; k <= n / 2U; k++)
+  {
+    float *zk = &pData[2U * k];
+    float *zn = &pData[2U * (n - k)];
+    float er = 0.5f * (zk[0] + zn[0]);
+    float ei = 0.5f * (zk[1] - zn[1]);
+    float or_ = 0.5f * (zk[1] + zn[1]);
+    float oi = -0.5f * (zk[0] - zn[0]);
+    float wr = hfft->Twiddle[2U * k];
+    float wi = -hfft->Twiddle[2U * k + 1U];
+    float tr = wr * or_ - wi * oi;
+    float ti = wr * oi + wi * or_;
+
+    /* X[k] = E + W^k O, X[n-k] = conj(E - W^k O) */
+    zk[0] = er + tr;
+    zk[1] = ei + ti;
+    zn[0] = er - tr;
+    zn[1] = -(ei - ti);
+  }
+
+  pData[0] = dc;
+  pData[1] = ny;
+}
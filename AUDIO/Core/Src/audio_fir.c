@@ -0,0 +1,228 @@
+/**
+  ******************************************************************************
+  * @file    audio_fir.c
+  * @brief   Block FIR filter engine.
+  *
+  *          The state holds the last NumTaps-1 inputs followed by the current
+  *          block, so the inner loop runs over a linear buffer without any
+  *          modulo. Four outputs are computed per pass: every coefficient and
+  *          input sample loaded is reused four times. Blocks longer than the
+  *          state are filtered MaxFrames at a time.
+  *
+  *          A response change can be crossfaded: for one block, every output
+  *          is computed with both the old and the new coefficients over the
+  *          same history and blended linearly, at twice the usual cost.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_fir.h"
+#include <string.h>
+
+/* Private function prototypes -----------------------------------------------*/
+static void FIR_Run(FIR_HandleTypeDef *hfir, const float *pFrom, const float *pIn, float *pOut,
+                    uint32_t Frames, uint8_t Accumulate);
+static void FIR_RunSlice(FIR_HandleTypeDef *hfir, const float *pFrom, const float *pIn,
+                         float *pOut, uint32_t Frames, float Fade, float Step, uint8_t Accumulate);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes a FIR filter and clears its history.
+  * @param  hfir pointer to the FIR handle
+  * @param  pCoeffs NumTaps coefficients
+  * @param  pState FIR_STATE_SIZE(NumTaps, MaxFrames) words
+  * @param  NumTaps filter length
+  * @param  MaxFrames frames filtered per pass, longer blocks are split
+  * @retval None
+  */
+void FIR_Init(FIR_HandleTypeDef *hfir, const float *pCoeffs, float *pState,
+              uint16_t NumTaps, uint16_t MaxFrames)
+{
+  hfir->pCoeffs   = pCoeffs;
+  hfir->pState    = pState;
+  hfir->NumTaps   = NumTaps;
+  hfir->MaxFrames = MaxFrames;
+  FIR_Reset(hfir);
+}
+
+/**
+  * @brief  Clears the filter history.
+  * @param  hfir pointer to the FIR handle
+  * @retval None
+  */
+void FIR_Reset(FIR_HandleTypeDef *hfir)
+{
+  memset(hfir->pState, 0, FIR_STATE_SIZE(hfir->NumTaps, hfir->MaxFrames) * sizeof(float));
+}
+
+/**
+  * @brief  Filters a block.
+  * @param  hfir pointer to the FIR handle
+  * @param  pIn input samples
+  * @param  pOut output samples, may alias pIn
+  * @param  Frames number of samples
+  * @retval None
+  */
+void FIR_Process(FIR_HandleTypeDef *hfir, const float *pIn, float *pOut, uint32_t Frames)
+{
+  FIR_Run(hfir, NULL, pIn, pOut, Frames, 0U);
+}
+
+/**
+  * @brief  Filters a block and adds the result to the output buffer.
+  * @param  hfir pointer to the FIR handle
+  * @param  pIn input samples
+  * @param  pOut accumulation buffer, must not alias pIn
+  * @param  Frames number of samples
+  * @retval None
+  */
+void FIR_ProcessAccumulate(FIR_HandleTypeDef *hfir, const float *pIn, float *pOut, uint32_t Frames)
+{
+  FIR_Run(hfir, NULL, pIn, pOut, Frames, 1U);
+}
+
+/**
+  * @brief  Filters a block while moving from an old response to the current
+  *         coefficients, and adds the result to the output buffer.
+  * @note   The outputs of both responses are crossfaded linearly over the
+  *         block, so a changed response does not click.
+  * @param  hfir pointer to the FIR handle
+  * @param  pFrom NumTaps coefficients in use before this block
+  * @param  pIn input samples
+  * @param  pOut accumulation buffer, must not alias pIn
+  * @param  Frames number of samples, the length of the crossfade
+  * @retval None
+  */
+void FIR_CrossfadeAccumulate(FIR_HandleTypeDef *hfir, const float *pFrom, const float *pIn,
+                             float *pOut, uint32_t Frames)
+{
+  FIR_Run(hfir, pFrom, pIn, pOut, Frames, 1U);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Splits a block into slices the state can hold.
+  * @param  hfir pointer to the FIR handle
+  * @param  pFrom coefficients to crossfade from, or NULL
+  * @param  pIn input samples
+  * @param  pOut output samples
+  * @param  Frames number of samples
+  * @param  Accumulate non-zero to add to pOut instead of overwriting it
+  * @retval None
+  */
+static void FIR_Run(FIR_HandleTypeDef *hfir, const float *pFrom, const float *pIn, float *pOut,
+                    uint32_t Frames, uint8_t Accumulate)
+{
+  float step = (Frames != 0U) ? 1.0f / (float)Frames : 0.0f;
+  uint32_t done = 0U;
+
+  while (done < Frames)
+  {
+    uint32_t n = AUDIO_MIN(Frames - done, (uint32_t)hfir->MaxFrames);
+
+    FIR_RunSlice(hfir, pFrom, &pIn[done], &pOut[done], n, ((float)done + 0.5f) * step, step,
+                 Accumulate);
+    done += n;
+  }
+}
+
+/**
+  * @brief  Common FIR kernel.
+  * @param  hfir pointer to the FIR handle
+  * @param  pFrom coefficients to crossfade from, or NULL
+  * @param  pIn input samples
+  * @param  pOut output samples
+  * @param  Frames number of samples, at most MaxFrames
+  * @param  Fade weight of the current coefficients at the first sample
+  * @param  Step increase of that weight per sample
+  * @param  Accumulate non-zero to add to pOut instead of overwriting it
+  * @retval None
+  */
+static void FIR_RunSlice(FIR_HandleTypeDef *hfir, const float *pFrom, const float *pIn,
+                         float *pOut, uint32_t Frames, float Fade, float Step, uint8_t Accumulate)
+{
+  const float *h = hfir->pCoeffs;
+  const uint32_t taps = hfir->NumTaps;
+  float *state = hfir->pState;
+  float *x = &state[taps - 1U];
+  uint32_t n = 0U;
+  uint32_t k;
+
+  memcpy(x, pIn, Frames * sizeof(float));
+
+  /* While crossfading, both responses run over the whole slice */
+  if (pFrom != NULL)
+  {
+    for (; n < Frames; n++)
+    {
+      const float *px = &state[n + taps - 1U];
+      float acc = 0.0f;
+      float old = 0.0f;
+
+      for (k = 0U; k < taps; k++)
+      {
+        acc += h[k] * *px;
+        old += pFrom[k] * *px--;
+      }
+      acc = old + (acc - old) * Fade;
+      pOut[n] = (Accumulate != 0U) ? (pOut[n] + acc) : acc;
+      Fade += Step;
+    }
+  }
+
+  /* y[n] = sum h[k] x[n-k]; with x[n] at state[n + taps - 1] */
+  for (; n + 4U <= Frames; n += 4U)
+  {
+    const float *px = &state[n + taps - 1U];
+    float acc0 = 0.0f;
+    float acc1 = 0.0f;
+    float acc2 = 0.0f;
+    float acc3 = 0.0f;
+
+    for (k = 0U; k < taps; k++)
+    {
+      float c = h[k];
+
+      acc0 += c * px[0];
+      acc1 += c * px[1];
+      acc2 += c * px[2];
+      acc3 += c * px[3];
+      px--;
+    }
+    if (Accumulate != 0U)
+    {
+      pOut[n] += acc0;
+      pOut[n + 1U] += acc1;
+      pOut[n + 2U] += acc2;
+      pOut[n + 3U] += acc3;
+    }
+    else
+    {
+      pOut[n] = acc0;
+      pOut[n + 1U] = acc1;
+      pOut[n + 2U] = acc2;
+      pOut[n + 3U] = acc3;
+    }
+  }
+  for (; n < Frames; n++)
+  {
+    const float *px = &state[n + taps - 1U];
+    float acc = 0.0f;
+
+    for (k = 0U; k < taps; k++)
+    {
+      acc += h[k] * *px--;
+    }
+    pOut[n] = (Accumulate != 0U) ? (pOut[n] + acc) : acc;
+  }
+
+  /* Keep the last taps-1 inputs as history for the next block */
+  memmove(state, &state[Frames], (taps - 1U) * sizeof(float));
+}
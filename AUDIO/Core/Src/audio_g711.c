@@ -0,0 +1,210 @@
+/**
+  ******************************************************************************
+  * @file    audio_g711.c
+  * @brief   G.711 mu-law / A-law codec.
+  *
+  *          Decoding is a single lookup in a 256-entry table per law.
+  *          Encoding finds the segment of the biased magnitude with a
+  *          256-entry leading-bit table and takes the four mantissa bits
+  *          below it. Negative samples are folded with a one's complement,
+  *          as in the ITU-T G.191 reference, so codes match it bit for bit.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_g711.h"
+
+/* Private define ------------------------------------------------------------*/
+#define G711_ULAW_BIAS            0x84
+#define G711_CLIP                 32635
+#define G711_SAMPLE_SCALE         (1.0f / 32768.0f)
+
+/* Private variables ---------------------------------------------------------*/
+static const int16_t G711_UlawTable[256] =
+{
+  -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+  -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+  -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+  -11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+   -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+   -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+   -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+   -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+   -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+   -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+    -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+    -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+    -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+    -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+    -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+     -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+   32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+   23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+   15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+   11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+    7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+    5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+    3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+    2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+    1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+    1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+     876,    844,    812,    780,    748,    716,    684,    652,
+     620,    588,    556,    524,    492,    460,    428,    396,
+     372,    356,    340,    324,    308,    292,    276,    260,
+     244,    228,    212,    196,    180,    164,    148,    132,
+     120,    112,    104,     96,     88,     80,     72,     64,
+      56,     48,     40,     32,     24,     16,      8,      0
+};
+
+static const int16_t G711_AlawTable[256] =
+{
+   -5504,  -5248,  -6016,  -5760,  -4480,  -4224,  -4992,  -4736,
+   -7552,  -7296,  -8064,  -7808,  -6528,  -6272,  -7040,  -6784,
+   -2752,  -2624,  -3008,  -2880,  -2240,  -2112,  -2496,  -2368,
+   -3776,  -3648,  -4032,  -3904,  -3264,  -3136,  -3520,  -3392,
+  -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+  -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+  -11008, -10496, -12032, -11520,  -8960,  -8448,  -9984,  -9472,
+  -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+    -344,   -328,   -376,   -360,   -280,   -264,   -312,   -296,
+    -472,   -456,   -504,   -488,   -408,   -392,   -440,   -424,
+     -88,    -72,   -120,   -104,    -24,     -8,    -56,    -40,
+    -216,   -200,   -248,   -232,   -152,   -136,   -184,   -168,
+   -1376,  -1312,  -1504,  -1440,  -1120,  -1056,  -1248,  -1184,
+   -1888,  -1824,  -2016,  -1952,  -1632,  -1568,  -1760,  -1696,
+    -688,   -656,   -752,   -720,   -560,   -528,   -624,   -592,
+    -944,   -912,  -1008,   -976,   -816,   -784,   -880,   -848,
+    5504,   5248,   6016,   5760,   4480,   4224,   4992,   4736,
+    7552,   7296,   8064,   7808,   6528,   6272,   7040,   6784,
+    2752,   2624,   3008,   2880,   2240,   2112,   2496,   2368,
+    3776,   3648,   4032,   3904,   3264,   3136,   3520,   3392,
+   22016,  20992,  24064,  23040,  17920,  16896,  19968,  18944,
+   30208,  29184,  32256,  31232,  26112,  25088,  28160,  27136,
+   11008,  10496,  12032,  11520,   8960,   8448,   9984,   9472,
+   15104,  14592,  16128,  15616,  13056,  12544,  14080,  13568,
+     344,    328,    376,    360,    280,    264,    312,    296,
+     472,    456,    504,    488,    408,    392,    440,    424,
+      88,     72,    120,    104,     24,      8,     56,     40,
+     216,    200,    248,    232,    152,    136,    184,    168,
+    1376,   1312,   1504,   1440,   1120,   1056,   1248,   1184,
+    1888,   1824,   2016,   1952,   1632,   1568,   1760,   1696,
+     688,    656,    752,    720,    560,    528,    624,    592,
+     944,    912,   1008,    976,    816,    784,    880,    848
+};
+
+static const uint8_t G711_SegmentTable[256] =
+{
+  0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3,
+  4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+  6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+  6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+  6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+  6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Encodes one sample.
+  * @param  Law companding law
+  * @param  Sample 16-bit linear sample
+  * @retval G.711 code word
+  */
+uint8_t G711_EncodeSample(G711_LawTypeDef Law, int16_t Sample)
+{
+  int32_t pcm = Sample;
+  uint8_t sign;
+  uint8_t seg;
+  uint8_t code;
+
+  if (Law == G711_ULAW)
+  {
+    sign = (pcm < 0) ? 0x80U : 0x00U;
+    pcm = (pcm < 0) ? ~pcm : pcm;
+    pcm = AUDIO_MIN(pcm, G711_CLIP) + G711_ULAW_BIAS;
+    seg = G711_SegmentTable[(pcm >> 7) & 0xFF];
+    code = (uint8_t)(sign | (seg << 4) | ((pcm >> (seg + 3U)) & 0x0F));
+    return (uint8_t)~code;
+  }
+
+  /* A-law: positive samples carry the sign bit, even bits are inverted */
+  sign = (pcm >= 0) ? 0x80U : 0x00U;
+  pcm = (pcm < 0) ? ~pcm : pcm;
+  pcm = AUDIO_MIN(pcm, G711_CLIP);
+  if (pcm >= 256)
+  {
+    seg = G711_SegmentTable[(pcm >> 7) & 0xFF];
+    code = (uint8_t)((seg << 4) | ((pcm >> (seg + 3U)) & 0x0F));
+  }
+  else
+  {
+    code = (uint8_t)(pcm >> 4);
+  }
+  return (uint8_t)(code ^ (sign ^ 0x55U));
+}
+
+/**
+  * @brief  Decodes one sample.
+  * @param  Law companding law
+  * @param  Code G.711 code word
+  * @retval 16-bit linear sample
+  */
+int16_t G711_DecodeSample(G711_LawTypeDef Law, uint8_t Code)
+{
+  return (Law == G711_ULAW) ? G711_UlawTable[Code] : G711_AlawTable[Code];
+}
+
+/**
+  * @brief  Encodes a block of 8 kHz float samples.
+  * @param  Law companding law
+  * @param  pIn input samples, full scale +/-1.0
+  * @param  pOut output code words, one byte per sample
+  * @param  Samples number of samples
+  * @retval None
+  */
+void G711_Encode(G711_LawTypeDef Law, const float *pIn, uint8_t *pOut, uint32_t Samples)
+{
+  uint32_t i;
+
+  for (i = 0U; i < Samples; i++)
+  {
+    int32_t s = (int32_t)(AUDIO_CLAMP(pIn[i], -1.0f, 1.0f) * 32767.0f);
+
+    pOut[i] = G711_EncodeSample(Law, (int16_t)s);
+  }
+}
+
+/**
+  * @brief  Decodes a block of code words to 8 kHz float samples.
+  * @param  Law companding law
+  * @param  pIn input code words
+  * @param  pOut output samples, full scale +/-1.0
+  * @param  Samples number of samples
+  * @retval None
+  */
+void G711_Decode(G711_LawTypeDef Law, const uint8_t *pIn, float *pOut, uint32_t Samples)
+{
+  const int16_t *table = (Law == G711_ULAW) ? G711_UlawTable : G711_AlawTable;
+  uint32_t i;
+
+  for (i = 0U; i < Samples; i++)
+  {
+    pOut[i] = (float)table[pIn[i]] * G711_SAMPLE_SCALE;
+  }
+}
@@ -0,0 +1,409 @@
+/**
+  ******************************************************************************
+  * @file    audio_g722.c
+  * @brief   G.722 wideband codec (7 kHz audio, 64/56/48 kbit/s).
+  *
+  *          The 24-tap QMF is split into its two 12-tap polyphase branches,
+  *          each run over the block by the FIR engine; band splitting and
+  *          merging is then a sum and a difference of the branch outputs.
+  *          The two sub-band ADPCM coders follow the integer arithmetic of
+  *          the ITU-T recommendation exactly. Only the float QMF may round a
+  *          sub-band sample differently from the fixed-point one, by one LSB.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_g722.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+/** Sub-band samples (15-bit) per unit of float QMF branch output */
+#define G722_ENCODE_SCALE         8192.0f
+#define G722_DECODE_SCALE         (1.0f / 16384.0f)
+
+/* Private variables ---------------------------------------------------------*/
+/** QMF branch responses: ITU-T coefficients / 4096, so each branch has unity DC gain */
+static const float G722_QmfCoeffs[G722_QMF_TAPS] =
+{
+     3.0f / 4096.0f,   -11.0f / 4096.0f,    12.0f / 4096.0f,    32.0f / 4096.0f,
+  -210.0f / 4096.0f,   951.0f / 4096.0f,  3876.0f / 4096.0f,  -805.0f / 4096.0f,
+   362.0f / 4096.0f,  -156.0f / 4096.0f,    53.0f / 4096.0f,   -11.0f / 4096.0f
+};
+
+static const float G722_QmfCoeffsRev[G722_QMF_TAPS] =
+{
+   -11.0f / 4096.0f,    53.0f / 4096.0f,  -156.0f / 4096.0f,   362.0f / 4096.0f,
+  -805.0f / 4096.0f,  3876.0f / 4096.0f,   951.0f / 4096.0f,  -210.0f / 4096.0f,
+    32.0f / 4096.0f,    12.0f / 4096.0f,   -11.0f / 4096.0f,     3.0f / 4096.0f
+};
+
+static const int16_t G722_Wl[8] = { -60, -30, 58, 172, 334, 538, 1198, 3042 };
+static const int16_t G722_Rl42[16] = { 0, 7, 6, 5, 4, 3, 2, 1, 7, 6, 5, 4, 3, 2, 1, 0 };
+static const int16_t G722_Wh[3] = { 0, -214, 798 };
+static const int16_t G722_Rh2[4] = { 2, 1, 2, 1 };
+static const int16_t G722_Qm2[4] = { -7408, -1616, 7408, 1616 };
+static const int16_t G722_Ihn[3] = { 0, 1, 0 };
+static const int16_t G722_Ihp[3] = { 0, 3, 2 };
+
+static const int16_t G722_Ilb[32] =
+{
+  2048, 2093, 2139, 2186, 2233, 2282, 2332, 2383,
+  2435, 2489, 2543, 2599, 2656, 2714, 2774, 2834,
+  2896, 2960, 3025, 3091, 3158, 3228, 3298, 3371,
+  3444, 3520, 3597, 3676, 3756, 3838, 3922, 4008
+};
+
+static const int16_t G722_Qm4[16] =
+{
+       0, -20456, -12896,  -8968,  -6288,  -4240,  -2584,  -1200,
+   20456,  12896,   8968,   6288,   4240,   2584,   1200,      0
+};
+
+static const int16_t G722_Qm5[32] =
+{
+    -280,   -280, -23352, -17560, -14120, -11664,  -9752,  -8184,
+   -6864,  -5712,  -4696,  -3784,  -2960,  -2208,  -1520,   -880,
+   23352,  17560,  14120,  11664,   9752,   8184,   6864,   5712,
+    4696,   3784,   2960,   2208,   1520,    880,    280,   -280
+};
+
+static const int16_t G722_Qm6[64] =
+{
+    -136,   -136,   -136,   -136, -24808, -21904, -19008, -16704,
+  -14984, -13512, -12280, -11192, -10232,  -9360,  -8576,  -7856,
+   -7192,  -6576,  -6000,  -5456,  -4944,  -4464,  -4008,  -3576,
+   -3168,  -2776,  -2400,  -2032,  -1688,  -1360,  -1040,   -728,
+   24808,  21904,  19008,  16704,  14984,  13512,  12280,  11192,
+   10232,   9360,   8576,   7856,   7192,   6576,   6000,   5456,
+    4944,   4464,   4008,   3576,   3168,   2776,   2400,   2032,
+    1688,   1360,   1040,    728,    432,    136,   -432,   -136
+};
+
+/** Low band quantizer decision levels */
+static const int16_t G722_Q6[32] =
+{
+     0,   35,   72,  110,  150,  190,  233,  276,
+   323,  370,  422,  473,  530,  587,  650,  714,
+   786,  858,  940, 1023, 1121, 1219, 1339, 1458,
+  1612, 1765, 1980, 2195, 2557, 2919,    0,    0
+};
+
+static const int16_t G722_Iln[32] =
+{
+   0, 63, 62, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19,
+  18, 17, 16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  0
+};
+
+static const int16_t G722_Ilp[32] =
+{
+   0, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48, 47,
+  46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32,  0
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static inline int32_t G722_Saturate(int32_t x);
+static inline int32_t G722_Round(float x);
+static void G722_Scale(G722_BandTypeDef *pBand, int32_t Weight, int32_t Limit, int32_t Shift);
+static void G722_Adapt(G722_BandTypeDef *pBand, int32_t d);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes an encoder or decoder.
+  * @param  hg722 pointer to the G.722 handle
+  * @param  Mode bit rate
+  * @retval None
+  */
+void G722_Init(G722_HandleTypeDef *hg722, G722_ModeTypeDef Mode)
+{
+  memset(hg722, 0, sizeof(*hg722));
+  hg722->Bits = (uint8_t)Mode;
+  hg722->Band[0].det = 32;
+  hg722->Band[1].det = 8;
+  FIR_Init(&hg722->Qmf[0], G722_QmfCoeffs, hg722->QmfState[0], G722_QMF_TAPS, G722_MAX_FRAMES / 2U);
+  FIR_Init(&hg722->Qmf[1], G722_QmfCoeffsRev, hg722->QmfState[1], G722_QMF_TAPS, G722_MAX_FRAMES / 2U);
+}
+
+/**
+  * @brief  Encodes a block of 16 kHz samples.
+  * @param  hg722 pointer to an encoder handle
+  * @param  pIn input samples, full scale +/-1.0
+  * @param  pOut output code words, one byte per input sample pair; in 56 and
+  *         48 kbit/s modes the unused top bits are zero
+  * @param  Frames number of input samples, must be even
+  * @retval None
+  */
+void G722_Encode(G722_HandleTypeDef *hg722, const float *pIn, uint8_t *pOut, uint32_t Frames)
+{
+  G722_BandTypeDef *lo = &hg722->Band[0];
+  G722_BandTypeDef *hi = &hg722->Band[1];
+  float *odd = hg722->Branch[0];
+  float *even = hg722->Branch[1];
+
+  while (Frames >= 2U)
+  {
+    uint32_t n = AUDIO_MIN(Frames, G722_MAX_FRAMES) / 2U;
+    uint32_t i;
+
+    /* Transmit QMF: each branch sees every other input sample */
+    for (i = 0U; i < n; i++)
+    {
+      even[i] = AUDIO_CLAMP(pIn[2U * i], -1.0f, 1.0f);
+      odd[i]  = AUDIO_CLAMP(pIn[2U * i + 1U], -1.0f, 1.0f);
+    }
+    FIR_Process(&hg722->Qmf[0], odd, odd, n);
+    FIR_Process(&hg722->Qmf[1], even, even, n);
+
+    for (i = 0U; i < n; i++)
+    {
+      int32_t xl = G722_Round(G722_ENCODE_SCALE * (odd[i] + even[i]));
+      int32_t xh = G722_Round(G722_ENCODE_SCALE * (odd[i] - even[i]));
+      int32_t el;
+      int32_t eh;
+      int32_t wd;
+      int32_t il;
+      int32_t ih;
+      int32_t k;
+
+      /* Low band: 6-bit quantizer, the predictor only sees the 4 MSBs */
+      el = G722_Saturate(xl - lo->s);
+      wd = (el >= 0) ? el : -(el + 1);
+      for (k = 1; k < 30; k++)
+      {
+        if (wd < ((G722_Q6[k] * lo->det) >> 12))
+        {
+          break;
+        }
+      }
+      il = (el < 0) ? G722_Iln[k] : G722_Ilp[k];
+      k = il >> 2;
+      wd = (lo->det * G722_Qm4[k]) >> 15;
+      G722_Scale(lo, G722_Wl[G722_Rl42[k]], 18432, 8);
+      G722_Adapt(lo, wd);
+
+      /* High band: 2-bit quantizer */
+      eh = G722_Saturate(xh - hi->s);
+      wd = (eh >= 0) ? eh : -(eh + 1);
+      k = (wd >= ((564 * hi->det) >> 12)) ? 2 : 1;
+      ih = (eh < 0) ? G722_Ihn[k] : G722_Ihp[k];
+      wd = (hi->det * G722_Qm2[ih]) >> 15;
+      G722_Scale(hi, G722_Wh[G722_Rh2[ih]], 22528, 10);
+      G722_Adapt(hi, wd);
+
+      pOut[i] = (uint8_t)(((ih << 6) | il) >> (8U - hg722->Bits));
+    }
+
+    pIn += 2U * n;
+    pOut += n;
+    Frames -= 2U * n;
+  }
+}
+
+/**
+  * @brief  Decodes code words to 16 kHz samples.
+  * @param  hg722 pointer to a decoder handle
+  * @param  pIn input code words
+  * @param  pOut output samples, two per code word, full scale +/-1.0
+  * @param  Codes number of code words
+  * @retval None
+  */
+void G722_Decode(G722_HandleTypeDef *hg722, const uint8_t *pIn, float *pOut, uint32_t Codes)
+{
+  G722_BandTypeDef *lo = &hg722->Band[0];
+  G722_BandTypeDef *hi = &hg722->Band[1];
+  float *diff = hg722->Branch[0];
+  float *sum = hg722->Branch[1];
+
+  while (Codes > 0U)
+  {
+    uint32_t n = AUDIO_MIN(Codes, G722_MAX_FRAMES / 2U);
+    uint32_t i;
+
+    for (i = 0U; i < n; i++)
+    {
+      int32_t code = pIn[i];
+      int32_t il;
+      int32_t ih;
+      int32_t wd;
+      int32_t rl;
+      int32_t rh;
+      int32_t dh;
+
+      /* Low band: reconstruct with every received bit, adapt on the 4 MSBs */
+      switch (hg722->Bits)
+      {
+        case G722_MODE_56K:
+          il = code & 0x1F;
+          ih = (code >> 5) & 0x03;
+          wd = G722_Qm5[il];
+          il >>= 1;
+          break;
+        case G722_MODE_48K:
+          il = code & 0x0F;
+          ih = (code >> 4) & 0x03;
+          wd = G722_Qm4[il];
+          break;
+        default:
+          il = code & 0x3F;
+          ih = (code >> 6) & 0x03;
+          wd = G722_Qm6[il];
+          il >>= 2;
+          break;
+      }
+      rl = lo->s + ((lo->det * wd) >> 15);
+      rl = AUDIO_CLAMP(rl, -16384, 16383);
+      wd = (lo->det * G722_Qm4[il]) >> 15;
+      G722_Scale(lo, G722_Wl[G722_Rl42[il]], 18432, 8);
+      G722_Adapt(lo, wd);
+
+      /* High band */
+      dh = (hi->det * G722_Qm2[ih]) >> 15;
+      rh = AUDIO_CLAMP(dh + hi->s, -16384, 16383);
+      G722_Scale(hi, G722_Wh[G722_Rh2[ih]], 22528, 10);
+      G722_Adapt(hi, dh);
+
+      sum[i]  = (float)(rl + rh);
+      diff[i] = (float)(rl - rh);
+    }
+
+    /* Receive QMF: the branches produce the even and odd output samples */
+    FIR_Process(&hg722->Qmf[0], diff, diff, n);
+    FIR_Process(&hg722->Qmf[1], sum, sum, n);
+    for (i = 0U; i < n; i++)
+    {
+      pOut[2U * i]      = diff[i] * G722_DECODE_SCALE;
+      pOut[2U * i + 1U] = sum[i] * G722_DECODE_SCALE;
+    }
+
+    pIn += n;
+    pOut += 2U * n;
+    Codes -= n;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Saturates to the 16-bit range.
+  */
+static inline int32_t G722_Saturate(int32_t x)
+{
+  return AUDIO_CLAMP(x, -32768, 32767);
+}
+
+/**
+  * @brief  Rounds a QMF output to the nearest sub-band sample.
+  */
+static inline int32_t G722_Round(float x)
+{
+  return G722_Saturate((int32_t)(x + ((x >= 0.0f) ? 0.5f : -0.5f)));
+}
+
+/**
+  * @brief  Updates the log scale factor and the linear scale factor of a band
+  *         (blocks LOGSCL/LOGSCH and SCALEL/SCALEH).
+  * @param  pBand pointer to the band state
+  * @param  Weight log scale increment for the received code
+  * @param  Limit upper bound of the log scale factor
+  * @param  Shift 8 for the low band, 10 for the high band
+  * @retval None
+  */
+static void G722_Scale(G722_BandTypeDef *pBand, int32_t Weight, int32_t Limit, int32_t Shift)
+{
+  int32_t nb = ((pBand->nb * 127) >> 7) + Weight;
+  int32_t e;
+  int32_t m;
+
+  nb = AUDIO_CLAMP(nb, 0, Limit);
+  pBand->nb = nb;
+
+  m = G722_Ilb[(nb >> 6) & 31];
+  e = Shift - (nb >> 11);
+  m = (e < 0) ? (m << -e) : (m >> e);
+  pBand->det = m << 2;
+}
+
+/**
+  * @brief  Reconstructs the band signal, adapts the pole-zero predictor and
+  *         computes the next estimate (block 4 of the recommendation).
+  * @param  pBand pointer to the band state
+  * @param  d quantized difference signal
+  * @retval None
+  */
+static void G722_Adapt(G722_BandTypeDef *pBand, int32_t d)
+{
+  int32_t sg0;
+  int32_t sg1;
+  int32_t sg2;
+  int32_t ap1;
+  int32_t ap2;
+  int32_t wd1;
+  int32_t wd2;
+  int32_t wd3;
+  int32_t sz;
+  int32_t i;
+
+  /* RECONS, PARREC */
+  pBand->r[0] = G722_Saturate(pBand->s + d);
+  pBand->p[0] = G722_Saturate(pBand->sz + d);
+
+  /* UPPOL2 */
+  sg0 = pBand->p[0] >> 15;
+  sg1 = pBand->p[1] >> 15;
+  sg2 = pBand->p[2] >> 15;
+  wd1 = G722_Saturate(pBand->a[1] << 2);
+  wd2 = (sg0 == sg1) ? -wd1 : wd1;
+  wd2 = AUDIO_MIN(wd2, 32767);
+  wd3 = (wd2 >> 7) + ((sg0 == sg2) ? 128 : -128);
+  wd3 += (pBand->a[2] * 32512) >> 15;
+  ap2 = AUDIO_CLAMP(wd3, -12288, 12288);
+
+  /* UPPOL1 */
+  wd1 = (sg0 == sg1) ? 192 : -192;
+  wd2 = (pBand->a[1] * 32640) >> 15;
+  ap1 = G722_Saturate(wd1 + wd2);
+  wd3 = G722_Saturate(15360 - ap2);
+  ap1 = AUDIO_CLAMP(ap1, -wd3, wd3);
+
+  /* UPZERO, DELAYA */
+  wd1 = (d == 0) ? 0 : 128;
+  sg0 = d >> 15;
+  for (i = 6; i > 0; i--)
+  {
+    wd2 = ((pBand->d[i] >> 15) == sg0) ? wd1 : -wd1;
+    wd3 = (pBand->b[i] * 32640) >> 15;
+    pBand->b[i] = G722_Saturate(wd2 + wd3);
+  }
+  for (i = 6; i > 0; i--)
+  {
+    pBand->d[i] = pBand->d[i - 1];
+  }
+  pBand->d[0] = d;
+  pBand->r[2] = pBand->r[1];
+  pBand->r[1] = pBand->r[0];
+  pBand->p[2] = pBand->p[1];
+  pBand->p[1] = pBand->p[0];
+  pBand->a[2] = ap2;
+  pBand->a[1] = ap1;
+
+  /* FILTEP */
+  wd1 = (pBand->a[1] * G722_Saturate(pBand->r[1] + pBand->r[1])) >> 15;
+  wd2 = (pBand->a[2] * G722_Saturate(pBand->r[2] + pBand->r[2])) >> 15;
+  pBand->sp = G722_Saturate(wd1 + wd2);
+
+  /* FILTEZ */
+  sz = 0;
+  for (i = 6; i > 0; i--)
+  {
+    sz += (pBand->b[i] * G722_Saturate(pBand->d[i] + pBand->d[i])) >> 15;
+  }
+  pBand->sz = G722_Saturate(sz);
+
+  /* PREDIC */
+  pBand->s = G722_Saturate(pBand->sp + pBand->sz);
+}
@@ -0,0 +1,411 @@
+/**
+  ******************************************************************************
+  * @file    audio_irq.c
+  * @brief   Interrupt priority map, FPU context policy and interrupt latency
+  *          benchmark.
+  *
+  *          The benchmark pends two spare interrupts through STIR and stamps
+  *          the trigger and the first instruction of each handler with the
+  *          DWT cycle counter:
+  *          - entry: thread mode to a handler, at each preemption level;
+  *          - preemption: a level 15 handler to a handler of each higher
+  *            level;
+  *          - tail-chaining: a handler pending another of the same level
+  *            just before it returns;
+  *          - FPU context: entry over code with an active FPU context, with
+  *            lazy and with full stacking, and the cost of the deferred push
+  *            on the first FPU instruction of a handler.
+  *          Each figure is the minimum and maximum of IRQ_BENCH_RUNS runs,
+  *          SysTick stopped. IRQ_WriteReport() prints them as one JSON object
+  *          that AUDIO/Tools/irqbench_check.py compares against a baseline.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_irq.h"
+#include "main.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define IRQ_FPSCR_FZ              (1UL << 24)   /*!< Flush denormals to zero    */
+#define IRQ_FPSCR_DN              (1UL << 25)   /*!< Default NaN                */
+
+#if (AUDIO_IRQ_BENCH != 0)
+#define IRQ_BENCH_A               CAN2_RX1_IRQn
+#define IRQ_BENCH_B               CAN2_SCE_IRQn
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum
+{
+  IRQ_BENCH_ENTRY     = 0U,   /* A stamps its entry                              */
+  IRQ_BENCH_PREEMPT   = 1U,   /* B triggers A and waits for it                   */
+  IRQ_BENCH_TAILCHAIN = 2U,   /* A pends B and stamps its exit, B its entry      */
+  IRQ_BENCH_LAZY      = 3U    /* A times its first FPU instruction               */
+} IRQ_BenchModeTypeDef;
+
+typedef struct
+{
+  volatile uint32_t Mode;
+  volatile uint32_t Start;
+  volatile uint32_t Stamp;
+  volatile uint32_t Done;
+} IRQ_BenchTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static IRQ_BenchTypeDef Bench;
+static volatile float BenchFloat = 1.0f;
+#endif /* AUDIO_IRQ_BENCH */
+
+/* Private function prototypes -----------------------------------------------*/
+#if (AUDIO_IRQ_BENCH != 0)
+static void     IRQ_StatInit(IRQ_StatTypeDef *pStat);
+static void     IRQ_StatAdd(IRQ_StatTypeDef *pStat, uint32_t Cycles, uint32_t Overhead);
+static uint32_t IRQ_Run(IRQ_BenchModeTypeDef Mode, IRQn_Type Trigger);
+static void     IRQ_Put(TRACE_WriteTypeDef Write, void *Context, const char *pText);
+static void     IRQ_PutUint(TRACE_WriteTypeDef Write, void *Context, uint32_t Value);
+static void     IRQ_PutStats(TRACE_WriteTypeDef Write, void *Context, const char *pName,
+                             const IRQ_StatTypeDef *pStat, uint32_t Count);
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Sets the FPU context policy.
+  * @note   Lazy stacking: an interrupt over FPU code reserves the 17 extra
+  *         words but only saves them if the handler executes an FPU
+  *         instruction, so integer handlers keep the 12-cycle entry.
+  *         Flush-to-zero and default NaN are set for the thread and, through
+  *         FPDSCR, for every handler: decaying filter and reverb states
+  *         otherwise end up in denormals, which the M4 FPU handles at full
+  *         speed but which are pure noise floor and slow the libm paths.
+  * @retval None
+  */
+void IRQ_ConfigureFpu(void)
+{
+  FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+  FPU->FPDSCR |= FPU_FPDSCR_FZ_Msk | FPU_FPDSCR_DN_Msk;
+  __set_FPSCR(__get_FPSCR() | IRQ_FPSCR_FZ | IRQ_FPSCR_DN);
+  __ISB();
+}
+
+/**
+  * @brief  Applies the priority map to the system handlers.
+  * @note   Peripheral drivers set their own lines from the IRQ_PRIO_xxx
+  *         constants when they enable them. HAL_Init() has already selected
+  *         NVIC_PRIORITYGROUP_4 (16 preemption levels, no subpriority).
+  * @retval None
+  */
+void IRQ_ConfigurePriorities(void)
+{
+  HAL_NVIC_SetPriority(SVCall_IRQn, IRQ_PRIO_SVCALL, 0U);
+  HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIO_PENDSV, 0U);
+  HAL_NVIC_SetPriority(SysTick_IRQn, IRQ_PRIO_TICK, 0U);
+}
+
+#if (AUDIO_IRQ_BENCH != 0)
+/**
+  * @brief  Runs the interrupt latency benchmark.
+  * @note   Called from thread mode with interrupts enabled, before the audio
+  *         path starts: it takes about IRQ_BENCH_RUNS * 50 interrupts and
+  *         leaves the FPU policy as IRQ_ConfigureFpu() sets it.
+  * @param  pReport filled with the results
+  * @retval None
+  */
+void IRQ_Benchmark(IRQ_ReportTypeDef *pReport)
+{
+  uint32_t tick = SysTick->CTRL & SysTick_CTRL_TICKINT_Msk;
+  uint32_t t0;
+  uint32_t t1;
+  uint32_t p;
+  uint32_t i;
+
+  memset(pReport, 0, sizeof(*pReport));
+  pReport->CoreClock = SystemCoreClock;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+  __set_BASEPRI(0U);
+
+  /* Cost of the stamp itself, removed from every figure */
+  pReport->Overhead = UINT32_MAX;
+  for (i = 0U; i < IRQ_BENCH_RUNS; i++)
+  {
+    t0 = DWT->CYCCNT;
+    t1 = DWT->CYCCNT;
+    pReport->Overhead = AUDIO_MIN(pReport->Overhead, t1 - t0);
+  }
+
+  HAL_NVIC_EnableIRQ(IRQ_BENCH_A);
+  HAL_NVIC_EnableIRQ(IRQ_BENCH_B);
+
+  /* Entry from thread mode, integer context */
+  for (p = 0U; p < IRQ_LEVELS; p++)
+  {
+    HAL_NVIC_SetPriority(IRQ_BENCH_A, p, 0U);
+    IRQ_StatInit(&pReport->Entry[p]);
+    for (i = 0U; i < IRQ_BENCH_RUNS; i++)
+    {
+      __set_CONTROL(__get_CONTROL() & ~CONTROL_FPCA_Msk);
+      __ISB();
+      IRQ_StatAdd(&pReport->Entry[p], IRQ_Run(IRQ_BENCH_ENTRY, IRQ_BENCH_A), pReport->Overhead);
+    }
+  }
+
+  /* Preemption of the lowest level */
+  HAL_NVIC_SetPriority(IRQ_BENCH_B, IRQ_LEVELS - 1U, 0U);
+  for (p = 0U; p < IRQ_LEVELS - 1U; p++)
+  {
+    HAL_NVIC_SetPriority(IRQ_BENCH_A, p, 0U);
+    IRQ_StatInit(&pReport->Preempt[p]);
+    for (i = 0U; i < IRQ_BENCH_RUNS; i++)
+    {
+      IRQ_StatAdd(&pReport->Preempt[p], IRQ_Run(IRQ_BENCH_PREEMPT, IRQ_BENCH_B), pReport->Overhead);
+    }
+  }
+
+  /* Tail-chaining between two handlers of the same level */
+  for (p = 0U; p < IRQ_LEVELS; p++)
+  {
+    HAL_NVIC_SetPriority(IRQ_BENCH_A, p, 0U);
+    HAL_NVIC_SetPriority(IRQ_BENCH_B, p, 0U);
+    IRQ_StatInit(&pReport->TailChain[p]);
+    for (i = 0U; i < IRQ_BENCH_RUNS; i++)
+    {
+      IRQ_StatAdd(&pReport->TailChain[p], IRQ_Run(IRQ_BENCH_TAILCHAIN, IRQ_BENCH_A), pReport->Overhead);
+    }
+  }
+
+  /* Entry over an active FPU context, lazy then full stacking */
+  HAL_NVIC_SetPriority(IRQ_BENCH_A, IRQ_PRIO_AUDIO, 0U);
+  IRQ_StatInit(&pReport->EntryFpLazy);
+  IRQ_StatInit(&pReport->EntryFpEager);
+  IRQ_StatInit(&pReport->LazyPush);
+  FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+  for (i = 0U; i < IRQ_BENCH_RUNS; i++)
+  {
+    BenchFloat *= 1.0f;
+    IRQ_StatAdd(&pReport->EntryFpLazy, IRQ_Run(IRQ_BENCH_ENTRY, IRQ_BENCH_A), pReport->Overhead);
+  }
+  FPU->FPCCR &= ~FPU_FPCCR_LSPEN_Msk;
+  for (i = 0U; i < IRQ_BENCH_RUNS; i++)
+  {
+    BenchFloat *= 1.0f;
+    IRQ_StatAdd(&pReport->EntryFpEager, IRQ_Run(IRQ_BENCH_ENTRY, IRQ_BENCH_A), pReport->Overhead);
+  }
+  FPU->FPCCR |= FPU_FPCCR_LSPEN_Msk;
+
+  /* Deferred push: the first FPU instruction in a handler, minus the same
+     instruction in thread mode */
+  for (i = 0U; i < IRQ_BENCH_RUNS; i++)
+  {
+    uint32_t ref;
+
+    BenchFloat *= 1.0f;
+    t0 = DWT->CYCCNT;
+    BenchFloat *= 1.0f;
+    ref = DWT->CYCCNT - t0;
+    t1 = IRQ_Run(IRQ_BENCH_LAZY, IRQ_BENCH_A);
+    IRQ_StatAdd(&pReport->LazyPush, (t1 > ref) ? t1 - ref : 0U, 0U);
+  }
+
+  HAL_NVIC_DisableIRQ(IRQ_BENCH_A);
+  HAL_NVIC_DisableIRQ(IRQ_BENCH_B);
+  SysTick->CTRL |= tick;
+  IRQ_ConfigureFpu();
+}
+
+/**
+  * @brief  Writes the report as one line of JSON.
+  * @param  pReport benchmark results
+  * @param  Write byte sink (TRACE_ItmWrite(), a UART...)
+  * @param  Context passed to Write
+  * @retval None
+  */
+void IRQ_WriteReport(const IRQ_ReportTypeDef *pReport, TRACE_WriteTypeDef Write, void *Context)
+{
+  IRQ_Put(Write, Context, "{\"target\":\"STM32F412\",\"core_hz\":");
+  IRQ_PutUint(Write, Context, pReport->CoreClock);
+  IRQ_Put(Write, Context, ",\"overhead\":");
+  IRQ_PutUint(Write, Context, pReport->Overhead);
+  IRQ_Put(Write, Context, ",\"runs\":");
+  IRQ_PutUint(Write, Context, IRQ_BENCH_RUNS);
+  IRQ_PutStats(Write, Context, "entry", pReport->Entry, IRQ_LEVELS);
+  IRQ_PutStats(Write, Context, "preempt", pReport->Preempt, IRQ_LEVELS - 1U);
+  IRQ_PutStats(Write, Context, "tail_chain", pReport->TailChain, IRQ_LEVELS);
+  IRQ_PutStats(Write, Context, "fp_entry_lazy", &pReport->EntryFpLazy, 1U);
+  IRQ_PutStats(Write, Context, "fp_entry_eager", &pReport->EntryFpEager, 1U);
+  IRQ_PutStats(Write, Context, "fp_lazy_push", &pReport->LazyPush, 1U);
+  IRQ_Put(Write, Context, "}\n");
+}
+
+/**
+  * @brief  Benchmark interrupt A.
+  * @retval None
+  */
+void CAN2_RX1_IRQHandler(void)
+{
+  uint32_t stamp = DWT->CYCCNT;
+
+  switch (Bench.Mode)
+  {
+    case IRQ_BENCH_TAILCHAIN:
+      NVIC->STIR = (uint32_t)IRQ_BENCH_B;
+      __DSB();
+      Bench.Start = DWT->CYCCNT;
+      break;
+
+    case IRQ_BENCH_LAZY:
+      stamp = DWT->CYCCNT;
+      BenchFloat *= 1.0f;
+      Bench.Stamp = DWT->CYCCNT - stamp;
+      Bench.Done = 1U;
+      break;
+
+    default:
+      Bench.Stamp = stamp;
+      Bench.Done = 1U;
+      break;
+  }
+}
+
+/**
+  * @brief  Benchmark interrupt B.
+  * @retval None
+  */
+void CAN2_SCE_IRQHandler(void)
+{
+  uint32_t stamp = DWT->CYCCNT;
+
+  if (Bench.Mode == IRQ_BENCH_PREEMPT)
+  {
+    Bench.Start = DWT->CYCCNT;
+    NVIC->STIR = (uint32_t)IRQ_BENCH_A;
+    while (Bench.Done == 0U)
+    {
+    }
+  }
+  else
+  {
+    Bench.Stamp = stamp;
+    Bench.Done = 1U;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Resets a measurement.
+  * @param  pStat measurement
+  * @retval None
+  */
+static void IRQ_StatInit(IRQ_StatTypeDef *pStat)
+{
+  pStat->Min = UINT32_MAX;
+  pStat->Max = 0U;
+}
+
+/**
+  * @brief  Adds one sample to a measurement.
+  * @param  pStat measurement
+  * @param  Cycles sample
+  * @param  Overhead stamp cost to remove
+  * @retval None
+  */
+static void IRQ_StatAdd(IRQ_StatTypeDef *pStat, uint32_t Cycles, uint32_t Overhead)
+{
+  Cycles = (Cycles > Overhead) ? Cycles - Overhead : 0U;
+  pStat->Min = AUDIO_MIN(pStat->Min, Cycles);
+  pStat->Max = AUDIO_MAX(pStat->Max, Cycles);
+}
+
+/**
+  * @brief  Triggers one benchmark interrupt and waits for the result.
+  * @param  Mode what the handlers do
+  * @param  Trigger interrupt pended from thread mode
+  * @retval Cycles between the two stamps
+  */
+static uint32_t IRQ_Run(IRQ_BenchModeTypeDef Mode, IRQn_Type Trigger)
+{
+  Bench.Mode = (uint32_t)Mode;
+  Bench.Done = 0U;
+
+  /* Restamped by the handler that triggers the measured one in the chained
+     modes */
+  Bench.Start = DWT->CYCCNT;
+  NVIC->STIR = (uint32_t)Trigger;
+  while (Bench.Done == 0U)
+  {
+  }
+  return (Mode == IRQ_BENCH_LAZY) ? Bench.Stamp : Bench.Stamp - Bench.Start;
+}
+
+/**
+  * @brief  Sends a string to the report sink.
+  * @param  Write byte sink
+  * @param  Context passed to Write
+  * @param  pText zero-terminated text
+  * @retval None
+  */
+static void IRQ_Put(TRACE_WriteTypeDef Write, void *Context, const char *pText)
+{
+  Write(Context, (const uint8_t *)pText, (uint32_t)strlen(pText));
+}
+
+/**
+  * @brief  Sends a number in decimal to the report sink.
+  * @param  Write byte sink
+  * @param  Context passed to Write
+  * @param  Value number
+  * @retval None
+  */
+static void IRQ_PutUint(TRACE_WriteTypeDef Write, void *Context, uint32_t Value)
+{
+  char text[11];
+  uint32_t i = sizeof(text);
+
+  do
+  {
+    text[--i] = (char)('0' + (Value % 10U));
+    Value /= 10U;
+  } while (Value != 0U);
+  Write(Context, (const uint8_t *)&text[i], sizeof(text) - i);
+}
+
+/**
+  * @brief  Sends one report field: a [min,max] pair, or an array of pairs
+  *         indexed by priority when Count is above 1.
+  * @param  Write byte sink
+  * @param  Context passed to Write
+  * @param  pName field name
+  * @param  pStat measurements
+  * @param  Count number of measurements
+  * @retval None
+  */
+static void IRQ_PutStats(TRACE_WriteTypeDef Write, void *Context, const char *pName,
+                         const IRQ_StatTypeDef *pStat, uint32_t Count)
+{
+  uint32_t i;
+
+  IRQ_Put(Write, Context, ",\"");
+  IRQ_Put(Write, Context, pName);
+  IRQ_Put(Write, Context, (Count > 1U) ? "\":[" : "\":");
+  for (i = 0U; i < Count; i++)
+  {
+    IRQ_Put(Write, Context, (i != 0U) ? ",[" : "[");
+    IRQ_PutUint(Write, Context, pStat[i].Min);
+    IRQ_Put(Write, Context, ",");
+    IRQ_PutUint(Write, Context, pStat[i].Max);
+    IRQ_Put(Write, Context, "]");
+  }
+  if (Count > 1U)
+  {
+    IRQ_Put(Write, Context, "]");
+  }
+}
+#endif /* AUDIO_IRQ_BENCH */
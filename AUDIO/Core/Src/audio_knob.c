@@ -0,0 +1,356 @@
+/**
+  ******************************************************************************
+  * @file    audio_knob.c
+  * @brief   DMA-scanned potentiometer surface.
+  *
+  *          TIM3 triggers an ADC1 scan of every knob KNOB_SCAN_RATE times a
+  *          second and DMA2 Stream 0 stores the results in a circular buffer,
+  *          so reading the knobs costs the CPU nothing until a half of the
+  *          buffer is full. Each half (KNOB_OVERSAMPLE scans, 1 ms) is then
+  *          averaged per knob, lightly smoothed, and compared with the value
+  *          last reported: only a move larger than the knob deadband pushes
+  *          an event to the parameter queue, so a resting knob is silent
+  *          however noisy its wiper. A knob turned from rest is reported
+  *          within two halves (2 ms) plus the smoothing lag.
+  *
+  *          A DMA error or ADC overrun stops the scan from the interrupt;
+  *          KNOB_Poll(), in the background loop, starts it again.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_knob.h"
+#include "audio_irq.h"
+#include "audio_trace.h"
+#include "main.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define KNOB_ADC_MAX              4095U   /*!< 12-bit conversions               */
+#define KNOB_SMP_84               4U      /*!< 84 ADC clocks, for 10 k pots     */
+#define KNOB_EXTSEL_TIM3_TRGO     8U
+#define KNOB_HALF_SIZE(n)         (KNOB_OVERSAMPLE * (n))
+
+/* Private variables ---------------------------------------------------------*/
+/* Surface served by the DMA interrupt */
+static KNOB_HandleTypeDef *KnobActive;
+
+/* Private function prototypes -----------------------------------------------*/
+static void KNOB_ConfigurePin(uint32_t Channel);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the filter state of a surface.
+  * @note   Every knob is reported once after the start, with its position.
+  * @param  hknob pointer to the surface handle
+  * @param  pConfig one entry per knob, in scan order
+  * @param  NumKnobs number of knobs, 1 to KNOB_MAX
+  * @param  pQueue parameter queue receiving (ParamId, value) events
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef KNOB_Init(KNOB_HandleTypeDef *hknob, const KNOB_ConfigTypeDef *pConfig,
+                              uint32_t NumKnobs, ASYNC_QueueTypeDef *pQueue)
+{
+  uint32_t k;
+
+  if ((NumKnobs == 0U) || (NumKnobs > KNOB_MAX) || (pQueue == NULL))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hknob, 0, sizeof(*hknob));
+  for (k = 0U; k < NumKnobs; k++)
+  {
+    if (pConfig[k].Channel > 15U)
+    {
+      return AUDIO_ERROR;
+    }
+    hknob->Knobs[k].Channel  = pConfig[k].Channel;
+    hknob->Knobs[k].ParamId  = pConfig[k].ParamId;
+    hknob->Knobs[k].Deadband = (pConfig[k].Deadband != 0U) ? pConfig[k].Deadband : KNOB_DEFAULT_DEADBAND;
+    hknob->Knobs[k].Pending  = 1U;
+  }
+  hknob->NumKnobs = NumKnobs;
+  hknob->SmoothShift = 1U;
+  hknob->pQueue = pQueue;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Configures the pins, ADC1, DMA2 Stream 0 and TIM3, and starts the
+  *         scan.
+  * @note   Call after KNOB_Init(), from the background context.
+  * @param  hknob pointer to the surface handle
+  * @retval None
+  */
+void KNOB_Start(KNOB_HandleTypeDef *hknob)
+{
+  uint32_t n = hknob->NumKnobs;
+  uint32_t timerClock = HAL_RCC_GetPCLK1Freq();
+  uint32_t k;
+
+  KNOB_Stop();
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+  __HAL_RCC_GPIOB_CLK_ENABLE();
+  __HAL_RCC_GPIOC_CLK_ENABLE();
+  __HAL_RCC_ADC1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+  __HAL_RCC_TIM3_CLK_ENABLE();
+
+  /* Regular sequence: knob k is conversion k of every scan */
+  ADC1->SMPR1 = 0U;
+  ADC1->SMPR2 = 0U;
+  ADC1->SQR1 = (n - 1U) << ADC_SQR1_L_Pos;
+  ADC1->SQR2 = 0U;
+  ADC1->SQR3 = 0U;
+  for (k = 0U; k < n; k++)
+  {
+    uint32_t ch = hknob->Knobs[k].Channel;
+
+    KNOB_ConfigurePin(ch);
+    if (ch < 10U)
+    {
+      ADC1->SMPR2 |= KNOB_SMP_84 << (3U * ch);
+    }
+    else
+    {
+      ADC1->SMPR1 |= KNOB_SMP_84 << (3U * (ch - 10U));
+    }
+    if (k < 6U)
+    {
+      ADC1->SQR3 |= ch << (5U * k);
+    }
+    else if (k < 12U)
+    {
+      ADC1->SQR2 |= ch << (5U * (k - 6U));
+    }
+    else
+    {
+      ADC1->SQR1 |= ch << (5U * (k - 12U));
+    }
+  }
+
+  /* 100 MHz PCLK2 / 4 = 25 MHz ADC clock: 96 clocks, 3.8 us per knob */
+  ADC1_COMMON->CCR = ADC_CCR_ADCPRE_0;
+  ADC1->CR1 = ADC_CR1_SCAN;
+  ADC1->CR2 = ADC_CR2_EXTEN_0 | (KNOB_EXTSEL_TIM3_TRGO << ADC_CR2_EXTSEL_Pos)
+              | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_ADON;
+
+  DMA2_Stream0->PAR  = (uint32_t)&ADC1->DR;
+  DMA2_Stream0->M0AR = (uint32_t)hknob->Scan;
+  DMA2_Stream0->NDTR = 2U * KNOB_HALF_SIZE(n);
+  DMA2_Stream0->FCR  = 0U;
+  DMA2_Stream0->CR   = DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC
+                       | DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+  DMA2->LIFCR = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0
+                | DMA_LIFCR_CFEIF0;
+  hknob->Restart = 0U;
+  KnobActive = hknob;
+  DMA2_Stream0->CR |= DMA_SxCR_EN;
+  HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, IRQ_PRIO_CAPTURE, 0U);
+  HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+
+  /* APB1 runs at HCLK / 2, so its timers are clocked at twice PCLK1 */
+  if ((RCC->CFGR & RCC_CFGR_PPRE1_2) != 0U)
+  {
+    timerClock *= 2U;
+  }
+  TIM3->PSC = 0U;
+  TIM3->ARR = (timerClock / KNOB_SCAN_RATE) - 1U;
+  TIM3->CR2 = TIM_CR2_MMS_1;
+  TIM3->EGR = TIM_EGR_UG;
+  TIM3->CR1 = TIM_CR1_CEN;
+}
+
+/**
+  * @brief  Stops the scan. No event is pushed afterwards.
+  * @retval None
+  */
+void KNOB_Stop(void)
+{
+  if (KnobActive == NULL)
+  {
+    return;
+  }
+  TIM3->CR1 = 0U;
+  HAL_NVIC_DisableIRQ(DMA2_Stream0_IRQn);
+  DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+  while ((DMA2_Stream0->CR & DMA_SxCR_EN) != 0U)
+  {
+  }
+  ADC1->CR2 = 0U;
+  ADC1->SR = 0U;
+  KnobActive = NULL;
+}
+
+/**
+  * @brief  Restarts a scan the DMA interrupt stopped on an error.
+  * @note   Call from the background loop. KNOB_Start() reconfigures shared
+  *         RCC and GPIO registers and waits on the stream, which the
+  *         interrupt must not do.
+  * @param  hknob pointer to the surface handle
+  * @retval None
+  */
+void KNOB_Poll(KNOB_HandleTypeDef *hknob)
+{
+  if (hknob->Restart != 0U)
+  {
+    KNOB_Start(hknob);
+  }
+}
+
+/**
+  * @brief  Filters one half of the scan buffer and reports the knobs that
+  *         moved.
+  * @note   Called from the DMA interrupt, the only producer of the queue.
+  *         Has no hardware access, so it can be driven with recorded scans.
+  * @param  hknob pointer to the surface handle
+  * @param  pScan KNOB_OVERSAMPLE scans of NumKnobs conversions
+  * @retval None
+  */
+void KNOB_Process(KNOB_HandleTypeDef *hknob, const uint16_t *pScan)
+{
+  uint32_t n = hknob->NumKnobs;
+  uint32_t k;
+  uint32_t s;
+
+  for (k = 0U; k < n; k++)
+  {
+    KNOB_StateTypeDef *knob = &hknob->Knobs[k];
+    uint32_t sum = 0U;
+    uint32_t target;
+    uint32_t value;
+    uint32_t diff;
+
+    for (s = 0U; s < KNOB_OVERSAMPLE; s++)
+    {
+      sum += pScan[(s * n) + k];
+    }
+    /* Average, scaled so that a full-scale conversion reads KNOB_FULL_SCALE */
+    target = ((sum * KNOB_FULL_SCALE) + ((KNOB_ADC_MAX * KNOB_OVERSAMPLE) / 2U))
+             / (KNOB_ADC_MAX * KNOB_OVERSAMPLE);
+    target <<= 8;
+    if (hknob->Primed == 0U)
+    {
+      knob->Smooth = target;
+    }
+    else
+    {
+      knob->Smooth = (uint32_t)((int32_t)knob->Smooth
+                                + (((int32_t)target - (int32_t)knob->Smooth) >> hknob->SmoothShift));
+    }
+    value = (knob->Smooth + 128U) >> 8;
+
+    /* Snap the ends, which the deadband would otherwise keep out of reach */
+    if (value < knob->Deadband)
+    {
+      value = 0U;
+    }
+    else if (value > (KNOB_FULL_SCALE - knob->Deadband))
+    {
+      value = KNOB_FULL_SCALE;
+    }
+    diff = (value > knob->Reported) ? (value - knob->Reported) : (knob->Reported - value);
+    if ((diff > knob->Deadband) || ((diff != 0U) && ((value == 0U) || (value == KNOB_FULL_SCALE)))
+        || (knob->Pending != 0U))
+    {
+      if (ASYNC_Push(hknob->pQueue, knob->ParamId, (int32_t)value) != 0U)
+      {
+        knob->Reported = (uint16_t)value;
+        knob->Pending = 0U;
+      }
+      else
+      {
+        /* Retried on the next half */
+        knob->Pending = 1U;
+        hknob->Overruns++;
+      }
+    }
+  }
+  hknob->Primed = 1U;
+}
+
+/**
+  * @brief  DMA2 Stream 0 interrupt: filters the half the DMA just filled.
+  * @note   The stream keeps running into the other half meanwhile, which
+  *         leaves 1 ms for this handler. Both flags set at once mean a half
+  *         was overwritten before it was read: it is skipped and counted.
+  *         An error stops the timer and the stream and leaves the restart
+  *         to KNOB_Poll(); flags until then, the stopped stream's own
+  *         completion included, are dropped.
+  * @retval None
+  */
+void KNOB_DmaIRQHandler(void)
+{
+  KNOB_HandleTypeDef *hknob = KnobActive;
+  uint32_t flags = DMA2->LISR;
+
+  DMA2->LIFCR = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0
+                | DMA_LIFCR_CFEIF0;
+  if ((hknob == NULL) || (hknob->Restart != 0U))
+  {
+    return;
+  }
+
+  if (((flags & DMA_LISR_TEIF0) != 0U) || ((ADC1->SR & ADC_SR_OVR) != 0U))
+  {
+    /* A missed ADC request misaligns the scans: restart from conversion 0 */
+    TIM3->CR1 = 0U;
+    DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+    hknob->Overruns++;
+    hknob->Restart = 1U;
+    return;
+  }
+  if ((flags & DMA_LISR_HTIF0) != 0U)
+  {
+    TRACE_DMA_HALF(2U, 0U);
+  }
+  if ((flags & DMA_LISR_TCIF0) != 0U)
+  {
+    TRACE_DMA_CPLT(2U, 0U);
+  }
+  if (((flags & DMA_LISR_HTIF0) != 0U) && ((flags & DMA_LISR_TCIF0) != 0U))
+  {
+    hknob->Overruns++;
+  }
+  else if ((flags & DMA_LISR_HTIF0) != 0U)
+  {
+    KNOB_Process(hknob, &hknob->Scan[0]);
+  }
+  else if ((flags & DMA_LISR_TCIF0) != 0U)
+  {
+    KNOB_Process(hknob, &hknob->Scan[KNOB_HALF_SIZE(hknob->NumKnobs)]);
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Puts the pin of an ADC1 input in analog mode.
+  * @param  Channel ADC1 input 0..15
+  * @retval None
+  */
+static void KNOB_ConfigurePin(uint32_t Channel)
+{
+  GPIO_TypeDef *port = GPIOC;
+  uint32_t pin = Channel - 10U;
+
+  if (Channel < 8U)
+  {
+    port = GPIOA;
+    pin = Channel;
+  }
+  else if (Channel < 10U)
+  {
+    port = GPIOB;
+    pin = Channel - 8U;
+  }
+  port->MODER |= 3U << (2U * pin);
+  port->PUPDR &= ~(3U << (2U * pin));
+}
@@ -0,0 +1,355 @@
+/**
+  ******************************************************************************
+  * @file    audio_lcd.c
+  * @brief   SPI panel link: dirty regions of the framebuffer out by DMA.
+  *
+  *          One background task owns the panel. Every frame period it lets
+  *          the application draw (meters, scope) into the framebuffer, then
+  *          sends each dirty rectangle: a column/row window command, then
+  *          the rows expanded to RGB565 in LCD_CHUNK_PIXELS pieces. While
+  *          DMA2 Stream 3 shifts one piece out of SPI1, the task expands the
+  *          next into the other buffer, so the CPU spends its time on the
+  *          palette lookup only, never waiting on the bus. A frame that
+  *          overruns its period starts the next one at once; nothing else
+  *          is skipped, so the panel always catches up with the framebuffer.
+  *
+  *          The task runs from ASYNC_Run in the main loop, under every audio
+  *          and control interrupt; the DMA interrupt only posts a signal.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_lcd.h"
+#include "audio_irq.h"
+#include "audio_trace.h"
+#include "main.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define LCD_RST_PIN               GPIO_PIN_12   /* Port D                       */
+#define LCD_DC_PIN                GPIO_PIN_13
+#define LCD_CS_PIN                GPIO_PIN_14
+#define LCD_DMA_TIMEOUT_MS        10U     /* A chunk takes well under 1 ms      */
+
+/* MIPI DCS commands */
+#define LCD_CMD_SWRESET           0x01U
+#define LCD_CMD_SLPOUT            0x11U
+#define LCD_CMD_INVON             0x21U
+#define LCD_CMD_DISPON            0x29U
+#define LCD_CMD_CASET             0x2AU
+#define LCD_CMD_RASET             0x2BU
+#define LCD_CMD_RAMWR             0x2CU
+#define LCD_CMD_MADCTL            0x36U
+#define LCD_CMD_COLMOD            0x3AU
+#define LCD_COLMOD_RGB565         0x55U
+
+#define LCD_DMA_CHSEL_3           (DMA_SxCR_CHSEL_0 | DMA_SxCR_CHSEL_1)
+#define LCD_DMA_FLAGS             (DMA_LIFCR_CTCIF3 | DMA_LIFCR_CHTIF3 | DMA_LIFCR_CTEIF3 \
+                                   | DMA_LIFCR_CDMEIF3 | DMA_LIFCR_CFEIF3)
+
+/* Private typedef -----------------------------------------------------------*/
+/* Task locals, kept across waits */
+typedef struct
+{
+  LCD_HandleTypeDef *hlcd;
+  uint32_t FrameStart;
+  DISPLAY_RectTypeDef Rect;
+  uint32_t Row;               /* Rows of Rect already handed to the DMA        */
+  uint32_t Rows;              /* Rows per chunk                                */
+  uint8_t  Cur;               /* Chunk the DMA sends                           */
+} LCD_FrameTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Link served by the DMA interrupt */
+static LCD_HandleTypeDef *LcdActive;
+
+/* Private function prototypes -----------------------------------------------*/
+static ASYNC_StateTypeDef LCD_Task(ASYNC_TaskTypeDef *pTask, void *pFrame);
+static void LCD_Command(uint8_t Cmd, const uint8_t *pData, uint32_t Size);
+static void LCD_Window(const DISPLAY_RectTypeDef *pRect);
+static void LCD_Transmit(const uint16_t *pPixels, uint32_t Count);
+static void LCD_SetWidth(uint32_t Bits);
+static void LCD_WaitIdle(void);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes a panel link.
+  * @param  hlcd pointer to the link handle
+  * @param  pConfig link configuration, see LCD_ConfigTypeDef
+  * @param  hdisp framebuffer sent to the panel
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef LCD_Init(LCD_HandleTypeDef *hlcd, const LCD_ConfigTypeDef *pConfig,
+                             DISPLAY_HandleTypeDef *hdisp)
+{
+  if ((hdisp == NULL) || (pConfig->Prescaler > 7U))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hlcd, 0, sizeof(*hlcd));
+  hlcd->Config = *pConfig;
+  if (hlcd->Config.FrameMs == 0U)
+  {
+    hlcd->Config.FrameMs = LCD_DEFAULT_FRAME_MS;
+  }
+  hlcd->hdisp = hdisp;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Configures the pins, SPI1 and DMA2 Stream 3, and spawns the panel
+  *         task, which resets and sets up the panel before the first frame.
+  * @note   Call once, from the background context.
+  * @param  hlcd pointer to the link handle
+  * @param  hasync run loop the panel task runs in
+  * @retval AUDIO_OK, or AUDIO_BUSY when the run loop has no free task
+  */
+AUDIO_StatusTypeDef LCD_Start(LCD_HandleTypeDef *hlcd, ASYNC_HandleTypeDef *hasync)
+{
+  GPIO_InitTypeDef gpio = {0};
+  LCD_FrameTypeDef init = {0};
+
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+  __HAL_RCC_GPIOD_CLK_ENABLE();
+  __HAL_RCC_SPI1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  gpio.Pin = GPIO_PIN_5 | GPIO_PIN_7;
+  gpio.Mode = GPIO_MODE_AF_PP;
+  gpio.Pull = GPIO_NOPULL;
+  gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+  gpio.Alternate = GPIO_AF5_SPI1;
+  HAL_GPIO_Init(GPIOA, &gpio);
+
+  /* Single device on the bus: chip select stays low */
+  GPIOD->BSRR = LCD_RST_PIN | ((uint32_t)LCD_CS_PIN << 16);
+  gpio.Pin = LCD_RST_PIN | LCD_DC_PIN | LCD_CS_PIN;
+  gpio.Mode = GPIO_MODE_OUTPUT_PP;
+  gpio.Alternate = 0U;
+  HAL_GPIO_Init(GPIOD, &gpio);
+
+  /* Transmit-only master, mode 0, 8-bit frames for commands */
+  SPI1->CR1 = 0U;
+  SPI1->CR1 = SPI_CR1_BIDIMODE | SPI_CR1_BIDIOE | SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_MSTR
+              | ((uint32_t)hlcd->Config.Prescaler << SPI_CR1_BR_Pos);
+  SPI1->CR2 = SPI_CR2_TXDMAEN;
+  SPI1->CR1 |= SPI_CR1_SPE;
+
+  DMA2_Stream3->CR = 0U;
+  DMA2_Stream3->PAR = (uint32_t)&SPI1->DR;
+  DMA2_Stream3->FCR = 0U;
+  DMA2->LIFCR = LCD_DMA_FLAGS;
+  LcdActive = hlcd;
+  HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, IRQ_PRIO_DISPLAY, 0U);
+  HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+
+  init.hlcd = hlcd;
+  return ASYNC_Spawn(hasync, LCD_Task, &init, sizeof(init), NULL);
+}
+
+/**
+  * @brief  DMA2 Stream 3 interrupt: a chunk went out, or failed.
+  * @retval None
+  */
+void LCD_DmaIRQHandler(void)
+{
+  LCD_HandleTypeDef *hlcd = LcdActive;
+  uint32_t flags = DMA2->LISR;
+
+  DMA2->LIFCR = LCD_DMA_FLAGS;
+  if (hlcd == NULL)
+  {
+    return;
+  }
+  if ((flags & DMA_LISR_TCIF3) != 0U)
+  {
+    TRACE_DMA_CPLT(2U, 3U);
+  }
+  if ((flags & DMA_LISR_TEIF3) != 0U)
+  {
+    hlcd->Errors++;
+  }
+  if ((flags & (DMA_LISR_TCIF3 | DMA_LISR_TEIF3)) != 0U)
+  {
+    ASYNC_Post(&hlcd->DmaDone);
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+static ASYNC_StateTypeDef LCD_Task(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  LCD_FrameTypeDef *f = (LCD_FrameTypeDef *)pFrame;
+  LCD_HandleTypeDef *hlcd = f->hlcd;
+  uint32_t elapsed;
+  uint32_t n;
+
+  ASYNC_BEGIN(pTask);
+
+  /* The controller needs 120 ms after a reset and after sleep out */
+  GPIOD->BSRR = (uint32_t)LCD_RST_PIN << 16;
+  ASYNC_SLEEP(pTask, 10U);
+  GPIOD->BSRR = LCD_RST_PIN;
+  ASYNC_SLEEP(pTask, 120U);
+  LCD_Command(LCD_CMD_SWRESET, NULL, 0U);
+  ASYNC_SLEEP(pTask, 120U);
+  LCD_Command(LCD_CMD_SLPOUT, NULL, 0U);
+  ASYNC_SLEEP(pTask, 120U);
+  {
+    uint8_t colmod = LCD_COLMOD_RGB565;
+
+    LCD_Command(LCD_CMD_COLMOD, &colmod, 1U);
+    LCD_Command(LCD_CMD_MADCTL, &hlcd->Config.Madctl, 1U);
+    if (hlcd->Config.Invert != 0U)
+    {
+      LCD_Command(LCD_CMD_INVON, NULL, 0U);
+    }
+    LCD_Command(LCD_CMD_DISPON, NULL, 0U);
+  }
+  /* Panel RAM content is undefined after reset */
+  DISPLAY_MarkAll(hlcd->hdisp);
+  f->FrameStart = pTask->Now;
+
+  for (;;)
+  {
+    if (hlcd->Config.Render != NULL)
+    {
+      hlcd->Config.Render(hlcd->Config.Context);
+    }
+
+    while (DISPLAY_NextRegion(hlcd->hdisp, &f->Rect) != 0U)
+    {
+      hlcd->Regions++;
+      hlcd->Pixels += (uint32_t)f->Rect.W * f->Rect.H;
+      LCD_Window(&f->Rect);
+      f->Rows = LCD_CHUNK_PIXELS / f->Rect.W;
+      f->Row = 0U;
+      f->Cur = 0U;
+      DISPLAY_Pack(hlcd->hdisp, &f->Rect, 0U, AUDIO_MIN(f->Rows, f->Rect.H), hlcd->Chunk[0]);
+
+      while (f->Row < f->Rect.H)
+      {
+        n = AUDIO_MIN(f->Rows, f->Rect.H - f->Row);
+        LCD_Transmit(hlcd->Chunk[f->Cur], n * f->Rect.W);
+        f->Row += n;
+        if (f->Row < f->Rect.H)
+        {
+          /* Overlaps the transfer just started */
+          DISPLAY_Pack(hlcd->hdisp, &f->Rect, f->Row, AUDIO_MIN(f->Rows, f->Rect.H - f->Row),
+                       hlcd->Chunk[f->Cur ^ 1U]);
+        }
+        ASYNC_AWAIT_SIGNAL(pTask, &hlcd->DmaDone, LCD_DMA_TIMEOUT_MS);
+        if (pTask->Result != AUDIO_OK)
+        {
+          /* Abort without an interrupt: disabling the stream sets TCIF, and
+             a late post would let the next chunk's wait return while it is
+             still going out. EN reads 0 once the stream has stopped */
+          hlcd->Errors++;
+          DMA2_Stream3->CR &= ~(DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_EN);
+          while ((DMA2_Stream3->CR & DMA_SxCR_EN) != 0U)
+          {
+          }
+          DMA2->LIFCR = LCD_DMA_FLAGS;
+          ASYNC_Clear(&hlcd->DmaDone);
+        }
+        f->Cur ^= 1U;
+      }
+      LCD_WaitIdle();
+      LCD_SetWidth(8U);
+    }
+    hlcd->Frames++;
+
+    /* Frame cap: periods count from the start of the previous frame */
+    elapsed = pTask->Now - f->FrameStart;
+    if (elapsed >= hlcd->Config.FrameMs)
+    {
+      hlcd->Late++;
+      f->FrameStart = pTask->Now;
+      ASYNC_YIELD(pTask);
+    }
+    else
+    {
+      f->FrameStart += hlcd->Config.FrameMs;
+      ASYNC_SLEEP(pTask, hlcd->Config.FrameMs - elapsed);
+    }
+  }
+
+  ASYNC_END(pTask);
+}
+
+/* Command and parameter bytes, polled: a few bytes per region */
+static void LCD_Command(uint8_t Cmd, const uint8_t *pData, uint32_t Size)
+{
+  uint32_t i;
+
+  GPIOD->BSRR = (uint32_t)LCD_DC_PIN << 16;
+  *(volatile uint8_t *)&SPI1->DR = Cmd;
+  LCD_WaitIdle();
+  GPIOD->BSRR = LCD_DC_PIN;
+  for (i = 0U; i < Size; i++)
+  {
+    while ((SPI1->SR & SPI_SR_TXE) == 0U)
+    {
+    }
+    *(volatile uint8_t *)&SPI1->DR = pData[i];
+  }
+  LCD_WaitIdle();
+}
+
+/* Sets the write window to a rectangle and leaves the link in pixel mode */
+static void LCD_Window(const DISPLAY_RectTypeDef *pRect)
+{
+  uint32_t x1 = (uint32_t)pRect->X + pRect->W - 1U;
+  uint32_t y1 = (uint32_t)pRect->Y + pRect->H - 1U;
+  uint8_t col[4] = { (uint8_t)(pRect->X >> 8), (uint8_t)pRect->X, (uint8_t)(x1 >> 8), (uint8_t)x1 };
+  uint8_t row[4] = { (uint8_t)(pRect->Y >> 8), (uint8_t)pRect->Y, (uint8_t)(y1 >> 8), (uint8_t)y1 };
+
+  LCD_Command(LCD_CMD_CASET, col, 4U);
+  LCD_Command(LCD_CMD_RASET, row, 4U);
+  LCD_Command(LCD_CMD_RAMWR, NULL, 0U);
+  /* 16-bit frames send RGB565 high byte first, as the panel expects */
+  LCD_SetWidth(16U);
+}
+
+static void LCD_Transmit(const uint16_t *pPixels, uint32_t Count)
+{
+  DMA2_Stream3->CR = 0U;
+  DMA2->LIFCR = LCD_DMA_FLAGS;
+  DMA2_Stream3->M0AR = (uint32_t)pPixels;
+  DMA2_Stream3->NDTR = Count;
+  DMA2_Stream3->CR = LCD_DMA_CHSEL_3 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC
+                     | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_EN;
+}
+
+/* The frame size may only change with the SPI disabled */
+static void LCD_SetWidth(uint32_t Bits)
+{
+  SPI1->CR1 &= ~SPI_CR1_SPE;
+  if (Bits == 16U)
+  {
+    SPI1->CR1 |= SPI_CR1_DFF;
+  }
+  else
+  {
+    SPI1->CR1 &= ~SPI_CR1_DFF;
+  }
+  SPI1->CR1 |= SPI_CR1_SPE;
+}
+
+/* The DMA completes when the last frame enters the shifter, not when it leaves */
+static void LCD_WaitIdle(void)
+{
+  while ((SPI1->SR & SPI_SR_TXE) == 0U)
+  {
+  }
+  while ((SPI1->SR & SPI_SR_BSY) != 0U)
+  {
+  }
+}
@@ -0,0 +1,840 @@
+/**
+  ******************************************************************************
+  * @file    audio_library.c
+  * @brief   SD sample library index: Id to cluster runs, format and loop.
+  *
+  *          Opening a sample through FAT means a directory walk and a FAT
+  *          chain walk, which across thousands of files takes seconds at
+  *          preset load. The index does both once: every WAV file of the
+  *          card is reduced to its Id, format, loop points and the runs of
+  *          contiguous clusters holding it. The index image is loaded into
+  *          RAM as is; a lookup is a binary search on Id and a read position
+  *          maps to a card sector through the runs, so streaming starts with
+  *          the first sector read.
+  *
+  *          The image is built by LIBRARY_Build() from raw sector reads, on
+  *          the first mount of a card the saved index does not describe, or
+  *          on a host from a card image (Tools/sample_index.c builds this
+  *          file unchanged). The volume serial tells another card, but files
+  *          copied onto the same card keep it: the index also holds a CRC of
+  *          every directory entry, which LIBRARY_Check() compares on mount
+  *          from the directory sectors alone. FAT16 and FAT32 are walked;
+  *          exFAT cards (over 32 GB as formatted by default) must be
+  *          reformatted.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_library.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define LIBRARY_RD16(p)           ((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8))
+#define LIBRARY_RD32(p)           (LIBRARY_RD16(p) | (LIBRARY_RD16((p) + 2) << 16))
+#define LIBRARY_DIR_ENTRY         32U
+#define LIBRARY_ATTR_VOLUME       0x08U
+#define LIBRARY_ATTR_DIR          0x10U
+#define LIBRARY_ATTR_LFN          0x0FU
+#define LIBRARY_MAX_CHUNKS        64U     /* RIFF chunks looked at per file     */
+#define LIBRARY_ACCESS_DATE       18U     /* Entry bytes left out of the CRC    */
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t LIBRARY_Crc32(uint32_t Crc, const uint8_t *pData, uint32_t Size);
+static AUDIO_StatusTypeDef LIBRARY_Scan(LIBRARY_BuilderTypeDef *pBuilder, uint32_t *pVolumeId);
+static AUDIO_StatusTypeDef LIBRARY_Mount(LIBRARY_BuilderTypeDef *pBuilder, uint32_t *pVolumeId);
+static AUDIO_StatusTypeDef LIBRARY_NextCluster(LIBRARY_BuilderTypeDef *pBuilder, uint32_t Cluster,
+                                               uint32_t *pNext);
+static AUDIO_StatusTypeDef LIBRARY_Walk(LIBRARY_BuilderTypeDef *pBuilder, uint32_t Cluster,
+                                        uint32_t Depth);
+static AUDIO_StatusTypeDef LIBRARY_AddFile(LIBRARY_BuilderTypeDef *pBuilder, uint32_t Cluster,
+                                           uint32_t Size);
+static AUDIO_StatusTypeDef LIBRARY_ReadFile(LIBRARY_BuilderTypeDef *pBuilder, const LIBRARY_RunTypeDef *pRuns,
+                                            uint32_t NumRuns, uint32_t Offset, uint8_t *pDst,
+                                            uint32_t Size);
+static uint32_t LIBRARY_RunLba(uint32_t DataLba, uint32_t ClusterSectors, const LIBRARY_RunTypeDef *pRuns,
+                               uint32_t NumRuns, uint32_t Offset, uint32_t *pLba);
+static int      LIBRARY_CompareEntries(const void *pA, const void *pB);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Checks an index image and points the handle into it.
+  * @param  hlib pointer to the library handle
+  * @param  pImage index image in RAM, 4-byte aligned, kept while in use
+  * @param  Size image size in bytes
+  * @retval AUDIO_OK, or AUDIO_ERROR if the image is damaged or of another
+  *         version (rebuild it)
+  */
+AUDIO_StatusTypeDef LIBRARY_Load(LIBRARY_HandleTypeDef *hlib, const void *pImage, uint32_t Size)
+{
+  const LIBRARY_HeaderTypeDef *hdr = (const LIBRARY_HeaderTypeDef *)pImage;
+  const uint8_t *body = (const uint8_t *)pImage + sizeof(LIBRARY_HeaderTypeDef);
+  uint32_t i;
+
+  memset(hlib, 0, sizeof(*hlib));
+  if ((Size < sizeof(*hdr)) || (hdr->Magic != LIBRARY_MAGIC) || (hdr->Version != LIBRARY_VERSION)
+      || (hdr->EntrySize != sizeof(LIBRARY_EntryTypeDef)) || (hdr->ClusterSectors == 0U)
+      || (hdr->NumRuns > (Size / sizeof(LIBRARY_RunTypeDef)))
+      || (hdr->NumEntries > (Size / sizeof(LIBRARY_EntryTypeDef)))
+      || (Size != (sizeof(*hdr) + (hdr->NumRuns * sizeof(LIBRARY_RunTypeDef))
+                   + (hdr->NumEntries * sizeof(LIBRARY_EntryTypeDef))))
+      || (LIBRARY_Crc32(0U, body, Size - sizeof(*hdr)) != hdr->Crc))
+  {
+    return AUDIO_ERROR;
+  }
+
+  hlib->pRuns = (const LIBRARY_RunTypeDef *)body;
+  hlib->pEntries = (const LIBRARY_EntryTypeDef *)&hlib->pRuns[hdr->NumRuns];
+  for (i = 0U; i < hdr->NumEntries; i++)
+  {
+    const LIBRARY_EntryTypeDef *e = &hlib->pEntries[i];
+
+    if (((e->FirstRun + e->NumRuns) > hdr->NumRuns) || ((i > 0U) && (e->Id <= e[-1].Id)))
+    {
+      hlib->pRuns = NULL;
+      hlib->pEntries = NULL;
+      return AUDIO_ERROR;
+    }
+  }
+  hlib->pHeader = hdr;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Finds a sample by Id.
+  * @param  hlib pointer to the library handle
+  * @param  Id sample Id
+  * @retval The entry, or NULL if the card has no such sample
+  */
+const LIBRARY_EntryTypeDef *LIBRARY_Find(const LIBRARY_HandleTypeDef *hlib, uint32_t Id)
+{
+  uint32_t lo = 0U;
+  uint32_t hi = (hlib->pHeader != NULL) ? hlib->pHeader->NumEntries : 0U;
+
+  while (lo < hi)
+  {
+    uint32_t mid = (lo + hi) / 2U;
+    uint32_t id = hlib->pEntries[mid].Id;
+
+    if (id == Id)
+    {
+      return &hlib->pEntries[mid];
+    }
+    if (Id < id)
+    {
+      hi = mid;
+    }
+    else
+    {
+      lo = mid + 1U;
+    }
+  }
+  return NULL;
+}
+
+/**
+  * @brief  Maps a file offset of a sample to a card sector.
+  * @param  hlib pointer to the library handle
+  * @param  pEntry entry from LIBRARY_Find()
+  * @param  Offset byte offset in the file (DataOffset for the first sample)
+  * @param  pLba receives the sector holding Offset
+  * @retval Bytes from Offset that are contiguous on the card, from the start
+  *         of that sector's byte: one multi-sector read covers them. 0 past
+  *         the end of the file.
+  */
+uint32_t LIBRARY_Locate(const LIBRARY_HandleTypeDef *hlib, const LIBRARY_EntryTypeDef *pEntry,
+                        uint32_t Offset, uint32_t *pLba)
+{
+  return LIBRARY_RunLba(hlib->pHeader->DataLba, hlib->pHeader->ClusterSectors,
+                        &hlib->pRuns[pEntry->FirstRun], pEntry->NumRuns, Offset, pLba);
+}
+
+/**
+  * @brief  Id of a sample file without a numeric prefix.
+  * @param  pPath path from the card root, '/' separated, any case
+  * @retval 32-bit FNV-1a of the lower-case path, with LIBRARY_HASH_ID set
+  */
+uint32_t LIBRARY_HashName(const char *pPath)
+{
+  uint32_t h = 2166136261U;
+
+  for (; *pPath != '\0'; pPath++)
+  {
+    uint8_t c = (uint8_t)*pPath;
+
+    if ((c >= (uint8_t)'A') && (c <= (uint8_t)'Z'))
+    {
+      c = (uint8_t)(c + ('a' - 'A'));
+    }
+    else if (c == (uint8_t)'\\')
+    {
+      c = (uint8_t)'/';
+    }
+    h = (h ^ c) * 16777619U;
+  }
+  return h | LIBRARY_HASH_ID;
+}
+
+/**
+  * @brief  Builds the index image of a card.
+  * @note   Blocking, one sector read at a time: run it in the background,
+  *         once per card, and save the image for the next mounts. Files
+  *         that are not 16/24-bit PCM or float WAV, or are damaged, are
+  *         counted in Skipped; a later file with an Id already taken is
+  *         dropped and counted in Duplicates. Names starting with '.' (the
+  *         AppleDouble "._" files of macOS among them) are not looked at.
+  * @param  pBuilder builder with Read and Context set
+  * @param  pOut receives the image, 4-byte aligned
+  * @param  OutSize size of pOut: 36 bytes, plus 32 per file and 8 per run
+  * @param  pSize receives the image size
+  * @retval AUDIO_OK, or AUDIO_ERROR on a read error, an unsupported volume
+  *         or a full pOut
+  */
+AUDIO_StatusTypeDef LIBRARY_Build(LIBRARY_BuilderTypeDef *pBuilder, uint8_t *pOut, uint32_t OutSize,
+                                  uint32_t *pSize)
+{
+  LIBRARY_HeaderTypeDef *hdr = (LIBRARY_HeaderTypeDef *)pOut;
+  LIBRARY_EntryTypeDef *entries;
+  uint32_t volumeId;
+  uint32_t runBytes;
+  uint32_t n;
+  uint32_t i;
+
+  pBuilder->Scanning = 0U;
+  pBuilder->pOut = pOut;
+  pBuilder->OutSize = OutSize & ~(uint32_t)(sizeof(LIBRARY_EntryTypeDef) - 1U);
+  if ((pBuilder->OutSize < sizeof(*hdr)) || (LIBRARY_Scan(pBuilder, &volumeId) != AUDIO_OK))
+  {
+    return AUDIO_ERROR;
+  }
+
+  /* Entries were stacked down from the end: move them after the runs */
+  runBytes = pBuilder->NumRuns * sizeof(LIBRARY_RunTypeDef);
+  entries = (LIBRARY_EntryTypeDef *)&pOut[sizeof(*hdr) + runBytes];
+  memmove(entries, &pOut[pBuilder->OutSize - (pBuilder->NumEntries * sizeof(LIBRARY_EntryTypeDef))],
+          pBuilder->NumEntries * sizeof(LIBRARY_EntryTypeDef));
+  qsort(entries, pBuilder->NumEntries, sizeof(LIBRARY_EntryTypeDef), LIBRARY_CompareEntries);
+  n = 0U;
+  for (i = 0U; i < pBuilder->NumEntries; i++)
+  {
+    if ((n > 0U) && (entries[i].Id == entries[n - 1U].Id))
+    {
+      pBuilder->Duplicates++;
+      continue;
+    }
+    entries[n++] = entries[i];
+  }
+
+  hdr->Magic = LIBRARY_MAGIC;
+  hdr->Version = LIBRARY_VERSION;
+  hdr->EntrySize = sizeof(LIBRARY_EntryTypeDef);
+  hdr->NumEntries = n;
+  hdr->NumRuns = pBuilder->NumRuns;
+  hdr->VolumeId = volumeId;
+  hdr->DirCrc = pBuilder->DirCrc;
+  hdr->DataLba = pBuilder->DataLba;
+  hdr->ClusterSectors = pBuilder->ClusterSectors;
+  *pSize = sizeof(*hdr) + runBytes + (n * sizeof(LIBRARY_EntryTypeDef));
+  hdr->Crc = LIBRARY_Crc32(0U, &pOut[sizeof(*hdr)], *pSize - sizeof(*hdr));
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Tells whether a saved index still describes the card.
+  * @note   Blocking like LIBRARY_Build(), but it walks the directories
+  *         alone, without opening a file: run it on mount before trusting
+  *         a saved index. Any file added, removed, renamed or resized
+  *         changes a directory entry; reading files does not, as the last
+  *         access date is left out.
+  * @param  pBuilder builder with Read and Context set
+  * @param  hlib the saved index, loaded
+  * @retval AUDIO_OK if the index is current, AUDIO_ERROR if it must be
+  *         rebuilt or the card cannot be read
+  */
+AUDIO_StatusTypeDef LIBRARY_Check(LIBRARY_BuilderTypeDef *pBuilder, const LIBRARY_HandleTypeDef *hlib)
+{
+  uint32_t volumeId;
+
+  pBuilder->Scanning = 1U;
+  if ((hlib->pHeader == NULL) || (LIBRARY_Scan(pBuilder, &volumeId) != AUDIO_OK)
+      || (volumeId != hlib->pHeader->VolumeId) || (pBuilder->DirCrc != hlib->pHeader->DirCrc)
+      || (pBuilder->DataLba != hlib->pHeader->DataLba)
+      || (pBuilder->ClusterSectors != hlib->pHeader->ClusterSectors))
+  {
+    return AUDIO_ERROR;
+  }
+  return AUDIO_OK;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/* CRC-32, continued from Crc (0 to start) */
+static uint32_t LIBRARY_Crc32(uint32_t Crc, const uint8_t *pData, uint32_t Size)
+{
+  uint32_t crc = ~Crc;
+  uint32_t i;
+  uint32_t k;
+
+  for (i = 0U; i < Size; i++)
+  {
+    crc ^= pData[i];
+    for (k = 0U; k < 8U; k++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+  }
+  return ~crc;
+}
+
+/* Mounts the volume and walks it from the root, for a build or a check */
+static AUDIO_StatusTypeDef LIBRARY_Scan(LIBRARY_BuilderTypeDef *pBuilder, uint32_t *pVolumeId)
+{
+  pBuilder->CachedFat = 0U;
+  pBuilder->Path[0] = '\0';
+  pBuilder->DirCrc = 0U;
+  pBuilder->Skipped = 0U;
+  pBuilder->Duplicates = 0U;
+  pBuilder->NumEntries = 0U;
+  pBuilder->NumRuns = 0U;
+  if ((LIBRARY_Mount(pBuilder, pVolumeId) != AUDIO_OK)
+      || (LIBRARY_Walk(pBuilder, pBuilder->RootCluster, 0U) != AUDIO_OK))
+  {
+    return AUDIO_ERROR;
+  }
+  return AUDIO_OK;
+}
+
+/* Finds the FAT volume (bare, or first FAT partition of an MBR) */
+static AUDIO_StatusTypeDef LIBRARY_Mount(LIBRARY_BuilderTypeDef *pBuilder, uint32_t *pVolumeId)
+{
+  uint8_t *s = pBuilder->Sector;
+  uint32_t reserved;
+  uint32_t fats;
+  uint32_t fatSectors;
+  uint32_t total;
+  uint32_t p;
+
+  pBuilder->VolumeLba = 0U;
+  if (pBuilder->Read(pBuilder->Context, 0U, s) != AUDIO_OK)
+  {
+    return AUDIO_ERROR;
+  }
+  if ((s[510] != 0x55U) || (s[511] != 0xAAU))
+  {
+    return AUDIO_ERROR;
+  }
+  if (!(((s[0] == 0xEBU) || (s[0] == 0xE9U)) && (LIBRARY_RD16(&s[11]) == LIBRARY_SECTOR_SIZE)))
+  {
+    for (p = 0U; p < 4U; p++)
+    {
+      uint8_t type = s[446U + (16U * p) + 4U];
+
+      if ((type == 0x04U) || (type == 0x06U) || (type == 0x0BU) || (type == 0x0CU) || (type == 0x0EU))
+      {
+        pBuilder->VolumeLba = LIBRARY_RD32(&s[446U + (16U * p) + 8U]);
+        break;
+      }
+    }
+    if ((p == 4U) || (pBuilder->Read(pBuilder->Context, pBuilder->VolumeLba, s) != AUDIO_OK)
+        || (LIBRARY_RD16(&s[11]) != LIBRARY_SECTOR_SIZE))
+    {
+      return AUDIO_ERROR;
+    }
+  }
+
+  pBuilder->ClusterSectors = s[13];
+  reserved = LIBRARY_RD16(&s[14]);
+  fats = s[16];
+  pBuilder->RootSectors = ((LIBRARY_RD16(&s[17]) * LIBRARY_DIR_ENTRY) + LIBRARY_SECTOR_SIZE - 1U)
+                          / LIBRARY_SECTOR_SIZE;
+  total = (LIBRARY_RD16(&s[19]) != 0U) ? LIBRARY_RD16(&s[19]) : LIBRARY_RD32(&s[32]);
+  fatSectors = (LIBRARY_RD16(&s[22]) != 0U) ? LIBRARY_RD16(&s[22]) : LIBRARY_RD32(&s[36]);
+  if ((pBuilder->ClusterSectors == 0U) || (fats == 0U)
+      || (total <= (reserved + (fats * fatSectors) + pBuilder->RootSectors)))
+  {
+    return AUDIO_ERROR;
+  }
+  pBuilder->FatLba = pBuilder->VolumeLba + reserved;
+  pBuilder->RootLba = pBuilder->FatLba + (fats * fatSectors);
+  pBuilder->DataLba = pBuilder->RootLba + pBuilder->RootSectors;
+  pBuilder->Clusters = (total - (reserved + (fats * fatSectors) + pBuilder->RootSectors))
+                       / pBuilder->ClusterSectors;
+  /* The cluster count alone decides the FAT type */
+  if (pBuilder->Clusters < 4085U)
+  {
+    return AUDIO_ERROR;
+  }
+  pBuilder->Fat32 = (uint8_t)(pBuilder->Clusters >= 65525U);
+  if (pBuilder->Fat32 != 0U)
+  {
+    pBuilder->RootLba = 0U;
+    pBuilder->RootCluster = LIBRARY_RD32(&s[44]);
+    *pVolumeId = LIBRARY_RD32(&s[67]);
+  }
+  else
+  {
+    pBuilder->RootCluster = 0U;
+    *pVolumeId = LIBRARY_RD32(&s[39]);
+  }
+  return AUDIO_OK;
+}
+
+/* Next cluster of a chain; *pNext is 0 at the end of the chain */
+static AUDIO_StatusTypeDef LIBRARY_NextCluster(LIBRARY_BuilderTypeDef *pBuilder, uint32_t Cluster,
+                                               uint32_t *pNext)
+{
+  uint32_t offset = Cluster * ((pBuilder->Fat32 != 0U) ? 4U : 2U);
+  uint32_t lba = pBuilder->FatLba + (offset / LIBRARY_SECTOR_SIZE);
+  const uint8_t *p = &pBuilder->FatCache[offset % LIBRARY_SECTOR_SIZE];
+  uint32_t next;
+
+  if (pBuilder->CachedFat != lba)
+  {
+    if (pBuilder->Read(pBuilder->Context, lba, pBuilder->FatCache) != AUDIO_OK)
+    {
+      return AUDIO_ERROR;
+    }
+    pBuilder->CachedFat = lba;
+  }
+  if (pBuilder->Fat32 != 0U)
+  {
+    next = LIBRARY_RD32(p) & 0x0FFFFFFFU;
+    next = (next >= 0x0FFFFFF8U) ? 0U : next;
+  }
+  else
+  {
+    next = LIBRARY_RD16(p);
+    next = (next >= 0xFFF8U) ? 0U : next;
+  }
+  if ((next != 0U) && ((next < 2U) || (next >= (pBuilder->Clusters + 2U))))
+  {
+    /* Free, bad or out of range: a damaged chain */
+    return AUDIO_ERROR;
+  }
+  *pNext = next;
+  return AUDIO_OK;
+}
+
+/* Indexes the WAV files of a directory and, recursively, of its children */
+static AUDIO_StatusTypeDef LIBRARY_Walk(LIBRARY_BuilderTypeDef *pBuilder, uint32_t Cluster,
+                                        uint32_t Depth)
+{
+  uint32_t pathLen = (uint32_t)strlen(pBuilder->Path);
+  uint32_t sector = 0U;
+  uint32_t lfnSum = 0x100U;
+  uint8_t reload;
+  uint32_t e;
+
+  pBuilder->Name[0] = '\0';
+  for (;;)
+  {
+    uint32_t lba;
+
+    /* Directory sector: the FAT16 root is a fixed area, the rest chains */
+    if (Cluster == 0U)
+    {
+      if (sector == pBuilder->RootSectors)
+      {
+        return AUDIO_OK;
+      }
+      lba = pBuilder->RootLba + sector;
+    }
+    else
+    {
+      if (sector == pBuilder->ClusterSectors)
+      {
+        if (LIBRARY_NextCluster(pBuilder, Cluster, &Cluster) != AUDIO_OK)
+        {
+          return AUDIO_ERROR;
+        }
+        if (Cluster == 0U)
+        {
+          return AUDIO_OK;
+        }
+        sector = 0U;
+      }
+      lba = pBuilder->DataLba + ((Cluster - 2U) * pBuilder->ClusterSectors) + sector;
+    }
+    sector++;
+    reload = 1U;
+
+    for (e = 0U; e < (LIBRARY_SECTOR_SIZE / LIBRARY_DIR_ENTRY); e++)
+    {
+      const uint8_t *d = &pBuilder->Sector[e * LIBRARY_DIR_ENTRY];
+      uint32_t attr;
+      uint32_t first;
+      uint32_t sum = 0U;
+      uint32_t len;
+      uint32_t i;
+
+      /* Files and subdirectories reuse Sector: read it again after them */
+      if (reload != 0U)
+      {
+        if (pBuilder->Read(pBuilder->Context, lba, pBuilder->Sector) != AUDIO_OK)
+        {
+          return AUDIO_ERROR;
+        }
+        reload = 0U;
+      }
+      attr = d[11];
+      if (d[0] == 0x00U)
+      {
+        return AUDIO_OK;
+      }
+      if ((attr & 0x3FU) == LIBRARY_ATTR_LFN)
+      {
+        pBuilder->DirCrc = LIBRARY_Crc32(pBuilder->DirCrc, d, LIBRARY_DIR_ENTRY);
+      }
+      else
+      {
+        pBuilder->DirCrc = LIBRARY_Crc32(pBuilder->DirCrc, d, LIBRARY_ACCESS_DATE);
+        pBuilder->DirCrc = LIBRARY_Crc32(pBuilder->DirCrc, &d[LIBRARY_ACCESS_DATE + 2U],
+                                         LIBRARY_DIR_ENTRY - (LIBRARY_ACCESS_DATE + 2U));
+      }
+      if (d[0] == 0xE5U)
+      {
+        lfnSum = 0x100U;
+        continue;
+      }
+      if ((attr & 0x3FU) == LIBRARY_ATTR_LFN)
+      {
+        /* Long name pieces come last piece first, 13 UCS-2 characters each */
+        static const uint8_t pos[13] = { 1U, 3U, 5U, 7U, 9U, 14U, 16U, 18U, 20U, 22U, 24U, 28U, 30U };
+        uint32_t at = ((d[0] & 0x1FU) - 1U) * 13U;
+
+        if ((d[0] & 0x40U) != 0U)
+        {
+          lfnSum = d[13];
+          memset(pBuilder->Name, 0, sizeof(pBuilder->Name));
+        }
+        for (i = 0U; (i < 13U) && ((at + i) < (LIBRARY_PATH_MAX - 1U)); i++)
+        {
+          uint32_t c = LIBRARY_RD16(&d[pos[i]]);
+
+          pBuilder->Name[at + i] = (c == 0xFFFFU) ? '\0' : ((c < 0x80U) ? (char)c : '_');
+        }
+        if ((at + 13U) >= LIBRARY_PATH_MAX)
+        {
+          lfnSum = 0x100U;
+        }
+        continue;
+      }
+      if ((attr & LIBRARY_ATTR_VOLUME) != 0U)
+      {
+        lfnSum = 0x100U;
+        continue;
+      }
+
+      /* A long name only belongs to the short entry it was checksummed for */
+      for (i = 0U; i < 11U; i++)
+      {
+        sum = (((sum & 1U) << 7) + (sum >> 1) + d[i]) & 0xFFU;
+      }
+      if (sum != lfnSum)
+      {
+        len = 0U;
+        for (i = 0U; (i < 8U) && (d[i] != (uint8_t)' '); i++)
+        {
+          pBuilder->Name[len++] = (char)d[i];
+        }
+        if (d[8] != (uint8_t)' ')
+        {
+          pBuilder->Name[len++] = '.';
+          for (i = 8U; (i < 11U) && (d[i] != (uint8_t)' '); i++)
+          {
+            pBuilder->Name[len++] = (char)d[i];
+          }
+        }
+        pBuilder->Name[len] = '\0';
+      }
+      lfnSum = 0x100U;
+      if (pBuilder->Name[0] == '.')
+      {
+        continue;
+      }
+      first = LIBRARY_RD16(&d[26]) | ((pBuilder->Fat32 != 0U) ? (LIBRARY_RD16(&d[20]) << 16) : 0U);
+      len = (uint32_t)strlen(pBuilder->Name);
+      if ((pathLen + len + 2U) > LIBRARY_PATH_MAX)
+      {
+        pBuilder->Skipped++;
+        continue;
+      }
+      memcpy(&pBuilder->Path[pathLen], pBuilder->Name, len + 1U);
+
+      if ((attr & LIBRARY_ATTR_DIR) != 0U)
+      {
+        if (((Depth + 1U) < LIBRARY_MAX_DEPTH) && (first >= 2U))
+        {
+          reload = 1U;
+          pBuilder->Path[pathLen + len] = '/';
+          pBuilder->Path[pathLen + len + 1U] = '\0';
+          if (LIBRARY_Walk(pBuilder, first, Depth + 1U) != AUDIO_OK)
+          {
+            return AUDIO_ERROR;
+          }
+        }
+      }
+      else if ((len > 4U) && ((pBuilder->Name[len - 4U] == '.'))
+               && ((pBuilder->Name[len - 3U] | 0x20) == 'w') && ((pBuilder->Name[len - 2U] | 0x20) == 'a')
+               && ((pBuilder->Name[len - 1U] | 0x20) == 'v') && (pBuilder->Scanning == 0U))
+      {
+        reload = 1U;
+        if (LIBRARY_AddFile(pBuilder, first, LIBRARY_RD32(&d[28])) != AUDIO_OK)
+        {
+          return AUDIO_ERROR;
+        }
+      }
+      pBuilder->Path[pathLen] = '\0';
+      pBuilder->Name[0] = '\0';
+    }
+  }
+}
+
+/* Indexes one WAV file. Only read errors and a full output fail the build */
+static AUDIO_StatusTypeDef LIBRARY_AddFile(LIBRARY_BuilderTypeDef *pBuilder, uint32_t Cluster,
+                                           uint32_t Size)
+{
+  uint32_t clusterBytes = pBuilder->ClusterSectors * LIBRARY_SECTOR_SIZE;
+  uint32_t left = (Size + clusterBytes - 1U) / clusterBytes;
+  LIBRARY_RunTypeDef *runs = (LIBRARY_RunTypeDef *)&pBuilder->pOut[sizeof(LIBRARY_HeaderTypeDef)];
+  uint32_t firstRun = pBuilder->NumRuns;
+  uint32_t numRuns = 0U;
+  uint32_t format = 0U;
+  uint32_t channels = 0U;
+  uint32_t rate = 0U;
+  uint32_t bytes = 0U;
+  uint32_t dataOffset = 0U;
+  uint32_t dataSize = 0U;
+  uint32_t loopStart = LIBRARY_NO_LOOP;
+  uint32_t loopEnd = 0U;
+  uint32_t offset = 12U;
+  uint32_t chunks;
+  uint8_t b[40];
+  LIBRARY_EntryTypeDef *e;
+  const char *p = pBuilder->Name;
+  uint32_t id = 0U;
+
+  if ((Cluster < 2U) || (left == 0U))
+  {
+    pBuilder->Skipped++;
+    return AUDIO_OK;
+  }
+
+  /* Cluster chain to runs, as far as the file size reaches */
+  while (left > 0U)
+  {
+    uint32_t next;
+
+    if ((numRuns > 0U) && (Cluster == (runs[pBuilder->NumRuns - 1U].Cluster
+                                       + runs[pBuilder->NumRuns - 1U].Count)))
+    {
+      runs[pBuilder->NumRuns - 1U].Count++;
+    }
+    else
+    {
+      if ((numRuns == 0xFFFFU) || ((sizeof(LIBRARY_HeaderTypeDef) + ((pBuilder->NumRuns + 1U)
+            * sizeof(LIBRARY_RunTypeDef))) > (pBuilder->OutSize - ((pBuilder->NumEntries + 1U)
+            * sizeof(LIBRARY_EntryTypeDef)))))
+      {
+        return AUDIO_ERROR;
+      }
+      runs[pBuilder->NumRuns].Cluster = Cluster;
+      runs[pBuilder->NumRuns].Count = 1U;
+      pBuilder->NumRuns++;
+      numRuns++;
+    }
+    left--;
+    if (left > 0U)
+    {
+      if (LIBRARY_NextCluster(pBuilder, Cluster, &next) != AUDIO_OK)
+      {
+        return AUDIO_ERROR;
+      }
+      if (next == 0U)
+      {
+        /* Chain shorter than the size: a damaged file */
+        pBuilder->NumRuns = firstRun;
+        pBuilder->Skipped++;
+        return AUDIO_OK;
+      }
+      Cluster = next;
+    }
+  }
+
+  /* RIFF chunks: fmt and data are needed, smpl may follow data */
+  if ((Size >= 12U) && (LIBRARY_ReadFile(pBuilder, &runs[firstRun], numRuns, 0U, b, 12U) != AUDIO_OK))
+  {
+    return AUDIO_ERROR;
+  }
+  if ((Size < 12U) || (memcmp(b, "RIFF", 4) != 0) || (memcmp(&b[8], "WAVE", 4) != 0))
+  {
+    offset = Size;
+  }
+  for (chunks = 0U; ((offset + 8U) <= Size) && (chunks < LIBRARY_MAX_CHUNKS); chunks++)
+  {
+    uint32_t size;
+
+    if (LIBRARY_ReadFile(pBuilder, &runs[firstRun], numRuns, offset, b, 8U) != AUDIO_OK)
+    {
+      return AUDIO_ERROR;
+    }
+    size = LIBRARY_RD32(&b[4]);
+    if ((memcmp(b, "fmt ", 4) == 0) && (size >= 16U) && ((offset + 8U + 16U) <= Size))
+    {
+      if (LIBRARY_ReadFile(pBuilder, &runs[firstRun], numRuns, offset + 8U, b,
+                           ((size >= 26U) && ((offset + 8U + 26U) <= Size)) ? 26U : 16U) != AUDIO_OK)
+      {
+        return AUDIO_ERROR;
+      }
+      format = LIBRARY_RD16(&b[0]);
+      channels = LIBRARY_RD16(&b[2]);
+      rate = LIBRARY_RD32(&b[4]);
+      bytes = LIBRARY_RD16(&b[14]) / 8U;
+      if ((format == 0xFFFEU) && (size >= 26U))
+      {
+        format = LIBRARY_RD16(&b[24]);
+      }
+    }
+    else if ((memcmp(b, "smpl", 4) == 0) && (size >= 60U) && ((offset + 8U + 60U) <= Size))
+    {
+      if (LIBRARY_ReadFile(pBuilder, &runs[firstRun], numRuns, offset + 8U + 28U, b, 32U) != AUDIO_OK)
+      {
+        return AUDIO_ERROR;
+      }
+      if (LIBRARY_RD32(&b[0]) > 0U)
+      {
+        loopStart = LIBRARY_RD32(&b[16]);
+        loopEnd = LIBRARY_RD32(&b[20]) + 1U;
+      }
+    }
+    else if (memcmp(b, "data", 4) == 0)
+    {
+      dataOffset = offset + 8U;
+      dataSize = AUDIO_MIN(size, Size - dataOffset);
+    }
+    offset += 8U + size + (size & 1U);
+    if (offset < (8U + size))
+    {
+      break;
+    }
+  }
+
+  e = (LIBRARY_EntryTypeDef *)&pBuilder->pOut[pBuilder->OutSize - ((pBuilder->NumEntries + 1U)
+                                                                   * sizeof(LIBRARY_EntryTypeDef))];
+  if ((format == 1U) && (bytes == 2U))
+  {
+    e->Format = LIBRARY_FORMAT_PCM16;
+  }
+  else if ((format == 1U) && (bytes == 3U))
+  {
+    e->Format = LIBRARY_FORMAT_PCM24;
+  }
+  else if ((format == 3U) && (bytes == 4U))
+  {
+    e->Format = LIBRARY_FORMAT_FLOAT32;
+  }
+  else
+  {
+    e->Format = 0U;
+  }
+  if ((e->Format == 0U) || (channels == 0U) || (channels > 255U) || (dataOffset == 0U))
+  {
+    pBuilder->NumRuns = firstRun;
+    pBuilder->Skipped++;
+    return AUDIO_OK;
+  }
+
+  /* Id: a decimal prefix of the name, or the hash of the path */
+  while ((*p >= '0') && (*p <= '9') && (id < (LIBRARY_HASH_ID / 10U)))
+  {
+    id = (id * 10U) + (uint32_t)(*p - '0');
+    p++;
+  }
+  if ((p == pBuilder->Name) || ((*p >= '0') && (*p <= '9')))
+  {
+    id = LIBRARY_HashName(pBuilder->Path);
+  }
+
+  e->Id = id;
+  e->FirstRun = firstRun;
+  e->NumRuns = (uint16_t)numRuns;
+  e->DataOffset = dataOffset;
+  e->Channels = (uint8_t)channels;
+  e->Rate = rate;
+  e->Frames = dataSize / (channels * bytes);
+  if ((loopStart < loopEnd) && (loopStart < e->Frames))
+  {
+    e->LoopStart = loopStart;
+    e->LoopEnd = AUDIO_MIN(loopEnd, e->Frames);
+  }
+  else
+  {
+    e->LoopStart = LIBRARY_NO_LOOP;
+    e->LoopEnd = 0U;
+  }
+  pBuilder->NumEntries++;
+  return AUDIO_OK;
+}
+
+/* Reads a few bytes of a file through its runs, crossing sectors */
+static AUDIO_StatusTypeDef LIBRARY_ReadFile(LIBRARY_BuilderTypeDef *pBuilder, const LIBRARY_RunTypeDef *pRuns,
+                                            uint32_t NumRuns, uint32_t Offset, uint8_t *pDst,
+                                            uint32_t Size)
+{
+  while (Size > 0U)
+  {
+    uint32_t at = Offset % LIBRARY_SECTOR_SIZE;
+    uint32_t n = AUDIO_MIN(Size, LIBRARY_SECTOR_SIZE - at);
+    uint32_t lba;
+
+    if ((LIBRARY_RunLba(pBuilder->DataLba, pBuilder->ClusterSectors, pRuns, NumRuns, Offset, &lba) == 0U)
+        || (pBuilder->Read(pBuilder->Context, lba, pBuilder->Sector) != AUDIO_OK))
+    {
+      return AUDIO_ERROR;
+    }
+    memcpy(pDst, &pBuilder->Sector[at], n);
+    pDst += n;
+    Offset += n;
+    Size -= n;
+  }
+  return AUDIO_OK;
+}
+
+static uint32_t LIBRARY_RunLba(uint32_t DataLba, uint32_t ClusterSectors, const LIBRARY_RunTypeDef *pRuns,
+                               uint32_t NumRuns, uint32_t Offset, uint32_t *pLba)
+{
+  uint32_t clusterBytes = ClusterSectors * LIBRARY_SECTOR_SIZE;
+  uint32_t cluster = Offset / clusterBytes;
+  uint32_t within = Offset % clusterBytes;
+  uint32_t r;
+
+  for (r = 0U; r < NumRuns; r++)
+  {
+    if (cluster < pRuns[r].Count)
+    {
+      *pLba = DataLba + ((pRuns[r].Cluster - 2U + cluster) * ClusterSectors) + (within / LIBRARY_SECTOR_SIZE);
+      return ((pRuns[r].Count - cluster) * clusterBytes) - within;
+    }
+    cluster -= pRuns[r].Count;
+  }
+  return 0U;
+}
+
+static int LIBRARY_CompareEntries(const void *pA, const void *pB)
+{
+  const LIBRARY_EntryTypeDef *a = (const LIBRARY_EntryTypeDef *)pA;
+  const LIBRARY_EntryTypeDef *b = (const LIBRARY_EntryTypeDef *)pB;
+
+  /* Equal Ids in walk order, so the first file found is the one kept */
+  if (a->Id != b->Id)
+  {
+    return (a->Id > b->Id) ? 1 : -1;
+  }
+  return (a->FirstRun > b->FirstRun) - (a->FirstRun < b->FirstRun);
+}
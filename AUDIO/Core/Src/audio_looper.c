@@ -0,0 +1,685 @@
+/**
+  ******************************************************************************
+  * @file    audio_looper.c
+  * @brief   Multi-track looper with overdub, replace, multiply and undo.
+  *
+  *          Loops are stored as fixed-size blocks, raw or IMA ADPCM, spread over
+  *          internal and optional external RAM. Each track keeps one decoded
+  *          block for reading and one for writing; a block is re-encoded only
+  *          when the write head leaves it.
+  *
+  *          Undo is copy-on-write: the first time a pass overwrites a block, the
+  *          encoded original is copied into a fixed scratch pool. Undoing copies
+  *          those blocks back. A pass touching more blocks than the pool holds
+  *          simply loses its undo.
+  *
+  *          Multiply reads the base of every later cycle from the undo copies
+  *          of the blocks its first cycle overdubbed, so each cycle gets the
+  *          base as it was before the pass. A base longer than the pool, or no
+  *          longer than a block, has no such copies: its first cycle is played
+  *          through untouched and the input is added from the second. While a
+  *          track multiplies from the copies, passes on the other tracks wait
+  *          for it to end.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_looper.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define LOOPER_NO_BLOCK           (-1)
+#define LOOPER_UNDO_BLOCK(b)      (-2 - (int32_t)(b))   /* ReadBlock tag of an undo copy */
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t *LOOPER_BlockAddr(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Block);
+static void     LOOPER_Decode(LOOPER_HandleTypeDef *hlooper, const uint8_t *pSrc, int16_t *pDst);
+static void     LOOPER_Load(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Block, int16_t *pDst);
+static void     LOOPER_Flush(LOOPER_HandleTypeDef *hlooper, uint32_t Track);
+static int16_t  LOOPER_Read(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Pos);
+static int16_t  LOOPER_ReadBase(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Pos);
+static void     LOOPER_Write(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Pos, int32_t Value);
+static uint8_t  LOOPER_BeginPass(LOOPER_HandleTypeDef *hlooper, uint32_t Track);
+static void     LOOPER_Undo(LOOPER_HandleTypeDef *hlooper, uint32_t Track);
+static void     LOOPER_Crossfade(LOOPER_HandleTypeDef *hlooper, uint32_t Track);
+static void     LOOPER_Execute(LOOPER_HandleTypeDef *hlooper, uint32_t Track, LOOPER_ActionTypeDef Action);
+static float    LOOPER_Tick(LOOPER_HandleTypeDef *hlooper, uint32_t Track, float In);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the looper and partitions its memory.
+  * @param  hlooper pointer to the looper handle
+  * @param  pConfig memory layout and format
+  * @retval AUDIO_OK, or AUDIO_ERROR if the configuration leaves no loop memory
+  */
+AUDIO_StatusTypeDef LOOPER_Init(LOOPER_HandleTypeDef *hlooper, const LOOPER_ConfigTypeDef *pConfig)
+{
+  uint32_t bytes = (pConfig->Format == LOOPER_FORMAT_ADPCM) ? LOOPER_ADPCM_BLOCK_BYTES
+                                                            : LOOPER_RAW_BLOCK_BYTES;
+  uint32_t scratch = pConfig->UndoBlocks * bytes;
+  uint32_t i;
+
+  if ((pConfig->NumTracks == 0U) || (pConfig->NumTracks > LOOPER_MAX_TRACKS) ||
+      (pConfig->UndoBlocks > LOOPER_MAX_UNDO_BLOCKS) || (scratch > pConfig->InternalSize))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hlooper, 0, sizeof(*hlooper));
+  hlooper->Config         = *pConfig;
+  hlooper->BlockBytes     = bytes;
+  hlooper->pScratch       = pConfig->pInternal;
+  hlooper->pTrackInternal = pConfig->pInternal + scratch;
+  hlooper->InternalBlocks = (pConfig->InternalSize - scratch) / bytes;
+  hlooper->BlocksPerTrack = LOOPER_GetMaxLength(pConfig) / LOOPER_BLOCK_FRAMES;
+  if (hlooper->BlocksPerTrack == 0U)
+  {
+    return AUDIO_ERROR;
+  }
+
+  for (i = 0U; i < LOOPER_MAX_TRACKS; i++)
+  {
+    hlooper->Tracks[i].State      = LOOPER_STATE_EMPTY;
+    hlooper->Tracks[i].Level      = 1.0f;
+    hlooper->Tracks[i].ReadBlock  = LOOPER_NO_BLOCK;
+    hlooper->Tracks[i].WriteBlock = LOOPER_NO_BLOCK;
+    hlooper->Tracks[i].TailCount  = LOOPER_XFADE_FRAMES;
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Returns the longest loop a configuration can hold.
+  * @note   Usable before LOOPER_Init() to size memory at build time.
+  * @param  pConfig memory layout and format
+  * @retval Maximum loop length per track in frames
+  */
+uint32_t LOOPER_GetMaxLength(const LOOPER_ConfigTypeDef *pConfig)
+{
+  uint32_t bytes = (pConfig->Format == LOOPER_FORMAT_ADPCM) ? LOOPER_ADPCM_BLOCK_BYTES
+                                                            : LOOPER_RAW_BLOCK_BYTES;
+  uint32_t scratch = pConfig->UndoBlocks * bytes;
+  uint32_t blocks;
+
+  if ((pConfig->NumTracks == 0U) || (scratch > pConfig->InternalSize))
+  {
+    return 0U;
+  }
+  blocks = (pConfig->InternalSize - scratch) / bytes;
+  if (pConfig->pExternal != NULL)
+  {
+    blocks += pConfig->ExternalSize / bytes;
+  }
+  return (blocks / pConfig->NumTracks) * LOOPER_BLOCK_FRAMES;
+}
+
+/**
+  * @brief  Sets the grid on which requested actions take effect.
+  * @param  hlooper pointer to the looper handle
+  * @param  Frames grid in frames (typically one beat or one bar), 0 for none
+  * @retval None
+  */
+void LOOPER_SetQuantum(LOOPER_HandleTypeDef *hlooper, uint32_t Frames)
+{
+  hlooper->Quantum = Frames;
+  hlooper->Frame   = 0U;
+}
+
+/**
+  * @brief  Requests an action on a track.
+  * @note   The action runs on the first frame of the next quantum, so
+  *         loop lengths are whole multiples of the quantum.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  Action action to execute
+  * @retval None
+  */
+void LOOPER_Request(LOOPER_HandleTypeDef *hlooper, uint32_t Track, LOOPER_ActionTypeDef Action)
+{
+  if (Track < hlooper->Config.NumTracks)
+  {
+    hlooper->Tracks[Track].Pending = Action;
+  }
+}
+
+/**
+  * @brief  Processes one block: records the input and mixes all tracks.
+  * @note   The input is not passed through; monitoring is up to the caller.
+  * @param  hlooper pointer to the looper handle
+  * @param  pIn mono input
+  * @param  pOut mono output, overwritten
+  * @param  Frames block length in frames
+  * @retval None
+  */
+void LOOPER_Process(LOOPER_HandleTypeDef *hlooper, const float *pIn, float *pOut, uint32_t Frames)
+{
+  uint32_t f;
+  uint32_t t;
+
+  for (f = 0U; f < Frames; f++)
+  {
+    float acc = 0.0f;
+
+    if (hlooper->Frame == 0U)
+    {
+      for (t = 0U; t < hlooper->Config.NumTracks; t++)
+      {
+        LOOPER_ActionTypeDef action = hlooper->Tracks[t].Pending;
+
+        if (action != LOOPER_ACTION_NONE)
+        {
+          hlooper->Tracks[t].Pending = LOOPER_ACTION_NONE;
+          LOOPER_Execute(hlooper, t, action);
+        }
+      }
+    }
+    if (++hlooper->Frame >= hlooper->Quantum)
+    {
+      hlooper->Frame = 0U;
+    }
+
+    for (t = 0U; t < hlooper->Config.NumTracks; t++)
+    {
+      acc += LOOPER_Tick(hlooper, t, pIn[f]);
+    }
+    pOut[f] = acc;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Returns the address of a storage block.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  Block block index within the track
+  * @retval Block address in internal or external RAM
+  */
+static uint8_t *LOOPER_BlockAddr(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Block)
+{
+  uint32_t global = Track * hlooper->BlocksPerTrack + Block;
+
+  if (global < hlooper->InternalBlocks)
+  {
+    return hlooper->pTrackInternal + global * hlooper->BlockBytes;
+  }
+  return hlooper->Config.pExternal + (global - hlooper->InternalBlocks) * hlooper->BlockBytes;
+}
+
+/**
+  * @brief  Decodes an encoded block.
+  * @param  hlooper pointer to the looper handle
+  * @param  pSrc storage block or undo copy
+  * @param  pDst LOOPER_BLOCK_FRAMES samples
+  * @retval None
+  */
+static void LOOPER_Decode(LOOPER_HandleTypeDef *hlooper, const uint8_t *pSrc, int16_t *pDst)
+{
+  if (hlooper->Config.Format == LOOPER_FORMAT_ADPCM)
+  {
+    ADPCM_DecodeBlock(pSrc, pDst, LOOPER_BLOCK_FRAMES);
+  }
+  else
+  {
+    memcpy(pDst, pSrc, LOOPER_RAW_BLOCK_BYTES);
+  }
+}
+
+/**
+  * @brief  Decodes a storage block.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  Block block index within the track
+  * @param  pDst LOOPER_BLOCK_FRAMES samples
+  * @retval None
+  */
+static void LOOPER_Load(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Block, int16_t *pDst)
+{
+  LOOPER_Decode(hlooper, LOOPER_BlockAddr(hlooper, Track, Block), pDst);
+}
+
+/**
+  * @brief  Writes the write cache back to storage, saving the original
+  *         block for undo the first time the current pass touches it.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @retval None
+  */
+static void LOOPER_Flush(LOOPER_HandleTypeDef *hlooper, uint32_t Track)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+  uint32_t block = (uint32_t)trk->WriteBlock;
+  uint8_t *dst;
+  uint32_t i;
+
+  if ((trk->WriteBlock == LOOPER_NO_BLOCK) || (trk->WriteDirty == 0U))
+  {
+    return;
+  }
+  dst = LOOPER_BlockAddr(hlooper, Track, block);
+
+  if ((hlooper->UndoValid != 0U) && (hlooper->UndoTrack == Track) &&
+      (block * LOOPER_BLOCK_FRAMES < hlooper->UndoLength))
+  {
+    for (i = 0U; (i < hlooper->UndoCount) && (hlooper->UndoMap[i] != block); i++)
+    {
+    }
+    if (i == hlooper->UndoCount)
+    {
+      if (i < hlooper->Config.UndoBlocks)
+      {
+        memcpy(hlooper->pScratch + i * hlooper->BlockBytes, dst, hlooper->BlockBytes);
+        hlooper->UndoMap[i] = (uint16_t)block;
+        hlooper->UndoCount++;
+      }
+      else
+      {
+        hlooper->UndoValid = 0U;
+      }
+    }
+  }
+
+  if (hlooper->Config.Format == LOOPER_FORMAT_ADPCM)
+  {
+    ADPCM_EncodeBlock(trk->WriteCache, dst, LOOPER_BLOCK_FRAMES);
+  }
+  else
+  {
+    memcpy(dst, trk->WriteCache, LOOPER_RAW_BLOCK_BYTES);
+  }
+  trk->WriteDirty = 0U;
+  if (trk->ReadBlock == trk->WriteBlock)
+  {
+    trk->ReadBlock = LOOPER_NO_BLOCK;
+  }
+}
+
+/**
+  * @brief  Reads one frame of a track.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  Pos frame position
+  * @retval Sample value
+  */
+static int16_t LOOPER_Read(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Pos)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+  int32_t block = (int32_t)(Pos / LOOPER_BLOCK_FRAMES);
+
+  /* The write cache always holds the newest data of its block */
+  if (block == trk->WriteBlock)
+  {
+    return trk->WriteCache[Pos % LOOPER_BLOCK_FRAMES];
+  }
+  if (block != trk->ReadBlock)
+  {
+    LOOPER_Load(hlooper, Track, (uint32_t)block, trk->ReadCache);
+    trk->ReadBlock = block;
+  }
+  return trk->ReadCache[Pos % LOOPER_BLOCK_FRAMES];
+}
+
+/**
+  * @brief  Reads one frame of a track as it was before the current pass.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  Pos frame position
+  * @retval Sample value, from the undo copy of its block if the pass has
+  *         written it, from the track otherwise
+  */
+static int16_t LOOPER_ReadBase(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Pos)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+  uint32_t block = Pos / LOOPER_BLOCK_FRAMES;
+  uint32_t i;
+
+  if (trk->ReadBlock != LOOPER_UNDO_BLOCK(block))
+  {
+    if ((hlooper->UndoValid == 0U) || (hlooper->UndoTrack != Track))
+    {
+      return LOOPER_Read(hlooper, Track, Pos);
+    }
+    for (i = 0U; (i < hlooper->UndoCount) && (hlooper->UndoMap[i] != block); i++)
+    {
+    }
+    if (i == hlooper->UndoCount)
+    {
+      return LOOPER_Read(hlooper, Track, Pos);
+    }
+    LOOPER_Decode(hlooper, hlooper->pScratch + i * hlooper->BlockBytes, trk->ReadCache);
+    trk->ReadBlock = LOOPER_UNDO_BLOCK(block);
+  }
+  return trk->ReadCache[Pos % LOOPER_BLOCK_FRAMES];
+}
+
+/**
+  * @brief  Writes one frame of a track with saturation.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  Pos frame position
+  * @param  Value sample value before saturation
+  * @retval None
+  */
+static void LOOPER_Write(LOOPER_HandleTypeDef *hlooper, uint32_t Track, uint32_t Pos, int32_t Value)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+  int32_t block = (int32_t)(Pos / LOOPER_BLOCK_FRAMES);
+
+  if (block != trk->WriteBlock)
+  {
+    LOOPER_Flush(hlooper, Track);
+    if ((uint32_t)block * LOOPER_BLOCK_FRAMES < trk->Length)
+    {
+      LOOPER_Load(hlooper, Track, (uint32_t)block, trk->WriteCache);
+    }
+    else
+    {
+      memset(trk->WriteCache, 0, sizeof(trk->WriteCache));
+    }
+    trk->WriteBlock = block;
+  }
+  trk->WriteCache[Pos % LOOPER_BLOCK_FRAMES] = (int16_t)AUDIO_CLAMP(Value, -32768, 32767);
+  trk->WriteDirty = 1U;
+}
+
+/**
+  * @brief  Opens a new undo level for a track, dropping the previous one.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @retval 1, or 0 if another track multiplies from the undo copies: the
+  *         pass cannot start until it ends
+  */
+static uint8_t LOOPER_BeginPass(LOOPER_HandleTypeDef *hlooper, uint32_t Track)
+{
+  const LOOPER_TrackTypeDef *owner = &hlooper->Tracks[hlooper->UndoTrack];
+
+  if ((hlooper->UndoValid != 0U) && (hlooper->UndoTrack != Track) &&
+      (owner->State == LOOPER_STATE_MULTIPLY) && (owner->BaseSaved != 0U))
+  {
+    return 0U;
+  }
+  LOOPER_Flush(hlooper, Track);
+  hlooper->UndoValid  = 1U;
+  hlooper->UndoTrack  = (uint8_t)Track;
+  hlooper->UndoLength = hlooper->Tracks[Track].Length;
+  hlooper->UndoCount  = 0U;
+  return 1U;
+}
+
+/**
+  * @brief  Reverts the last pass of a track.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @retval None
+  */
+static void LOOPER_Undo(LOOPER_HandleTypeDef *hlooper, uint32_t Track)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+  uint32_t i;
+
+  if ((hlooper->UndoValid == 0U) || (hlooper->UndoTrack != Track))
+  {
+    return;
+  }
+
+  /* Unflushed writes never reached storage: dropping the cache reverts them */
+  trk->WriteDirty = 0U;
+  trk->WriteBlock = LOOPER_NO_BLOCK;
+  trk->ReadBlock  = LOOPER_NO_BLOCK;
+  for (i = 0U; i < hlooper->UndoCount; i++)
+  {
+    memcpy(LOOPER_BlockAddr(hlooper, Track, hlooper->UndoMap[i]),
+           hlooper->pScratch + i * hlooper->BlockBytes, hlooper->BlockBytes);
+  }
+  hlooper->UndoValid = 0U;
+
+  trk->Length  = hlooper->UndoLength;
+  trk->Closing = 0U;
+  if (trk->Length == 0U)
+  {
+    trk->State = LOOPER_STATE_EMPTY;
+  }
+  else
+  {
+    trk->State = LOOPER_STATE_PLAYING;
+    trk->Position %= trk->Length;
+  }
+}
+
+/**
+  * @brief  Blends the input recorded past the loop end into the loop start.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @retval None
+  */
+static void LOOPER_Crossfade(LOOPER_HandleTypeDef *hlooper, uint32_t Track)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+  uint32_t i;
+
+  if (trk->Length < 2U * LOOPER_XFADE_FRAMES)
+  {
+    return;
+  }
+  for (i = 0U; i < LOOPER_XFADE_FRAMES; i++)
+  {
+    float in = ((float)i + 0.5f) * (1.0f / (float)LOOPER_XFADE_FRAMES);
+    float v = (float)LOOPER_Read(hlooper, Track, i) * in + (float)trk->Tail[i] * (1.0f - in);
+
+    LOOPER_Write(hlooper, Track, i, (int32_t)v);
+  }
+}
+
+/**
+  * @brief  Runs a requested action.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  Action action to execute
+  * @retval None
+  */
+static void LOOPER_Execute(LOOPER_HandleTypeDef *hlooper, uint32_t Track, LOOPER_ActionTypeDef Action)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+
+  switch (Action)
+  {
+    case LOOPER_ACTION_RECORD:
+      if ((trk->State == LOOPER_STATE_EMPTY) || (trk->State == LOOPER_STATE_STOPPED))
+      {
+        /* The pass keeps the stopped take's length: undo brings it back */
+        if (LOOPER_BeginPass(hlooper, Track) == 0U)
+        {
+          trk->Pending = Action;
+          break;
+        }
+        trk->Length    = 0U;
+        trk->Position  = 0U;
+        trk->TailCount = LOOPER_XFADE_FRAMES;
+        trk->State     = LOOPER_STATE_RECORDING;
+      }
+      else if (trk->State == LOOPER_STATE_RECORDING)
+      {
+        LOOPER_Flush(hlooper, Track);
+        trk->Position  = 0U;
+        trk->TailCount = 0U;
+        trk->State     = (trk->Length != 0U) ? LOOPER_STATE_PLAYING : LOOPER_STATE_EMPTY;
+      }
+      else if (trk->State == LOOPER_STATE_PLAYING)
+      {
+        LOOPER_Execute(hlooper, Track, LOOPER_ACTION_OVERDUB);
+      }
+      break;
+
+    case LOOPER_ACTION_OVERDUB:
+    case LOOPER_ACTION_REPLACE:
+    {
+      LOOPER_StateTypeDef mode = (Action == LOOPER_ACTION_OVERDUB) ? LOOPER_STATE_OVERDUB
+                                                                   : LOOPER_STATE_REPLACE;
+      if (trk->State == LOOPER_STATE_PLAYING)
+      {
+        if (LOOPER_BeginPass(hlooper, Track) == 0U)
+        {
+          trk->Pending = Action;
+          break;
+        }
+        trk->State = mode;
+      }
+      else if (trk->State == mode)
+      {
+        LOOPER_Flush(hlooper, Track);
+        trk->State = LOOPER_STATE_PLAYING;
+      }
+      break;
+    }
+
+    case LOOPER_ACTION_MULTIPLY:
+      if (trk->State == LOOPER_STATE_PLAYING)
+      {
+        if (LOOPER_BeginPass(hlooper, Track) == 0U)
+        {
+          trk->Pending = Action;
+          break;
+        }
+        trk->BaseLength = trk->Length;
+        /* A base within one block is still in the write cache at the second cycle */
+        trk->BaseSaved  = ((trk->Length > LOOPER_BLOCK_FRAMES) &&
+                           ((trk->Length + LOOPER_BLOCK_FRAMES - 1U) / LOOPER_BLOCK_FRAMES <=
+                            hlooper->Config.UndoBlocks)) ? 1U : 0U;
+        trk->Closing    = 0U;
+        trk->State      = LOOPER_STATE_MULTIPLY;
+      }
+      else if (trk->State == LOOPER_STATE_MULTIPLY)
+      {
+        /* Finish the current cycle so the length stays a multiple of the base */
+        trk->Closing = 1U;
+      }
+      break;
+
+    case LOOPER_ACTION_PLAY:
+      if (trk->Length != 0U)
+      {
+        LOOPER_Flush(hlooper, Track);
+        trk->Closing  = 0U;
+        trk->Position = 0U;
+        trk->State    = LOOPER_STATE_PLAYING;
+      }
+      break;
+
+    case LOOPER_ACTION_STOP:
+      if (trk->State != LOOPER_STATE_EMPTY)
+      {
+        LOOPER_Flush(hlooper, Track);
+        trk->Closing = 0U;
+        trk->State   = (trk->Length != 0U) ? LOOPER_STATE_STOPPED : LOOPER_STATE_EMPTY;
+      }
+      break;
+
+    case LOOPER_ACTION_UNDO:
+      LOOPER_Undo(hlooper, Track);
+      break;
+
+    case LOOPER_ACTION_CLEAR:
+      trk->WriteDirty = 0U;
+      trk->WriteBlock = LOOPER_NO_BLOCK;
+      trk->ReadBlock  = LOOPER_NO_BLOCK;
+      trk->Length     = 0U;
+      trk->Position   = 0U;
+      trk->Closing    = 0U;
+      trk->TailCount  = LOOPER_XFADE_FRAMES;
+      trk->State      = LOOPER_STATE_EMPTY;
+      if (hlooper->UndoTrack == Track)
+      {
+        hlooper->UndoValid = 0U;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+  * @brief  Advances one track by one frame.
+  * @param  hlooper pointer to the looper handle
+  * @param  Track track index
+  * @param  In input sample
+  * @retval Track output sample
+  */
+static float LOOPER_Tick(LOOPER_HandleTypeDef *hlooper, uint32_t Track, float In)
+{
+  LOOPER_TrackTypeDef *trk = &hlooper->Tracks[Track];
+  uint32_t max = hlooper->BlocksPerTrack * LOOPER_BLOCK_FRAMES;
+  int32_t in = (int32_t)(AUDIO_CLAMP(In, -1.0f, 1.0f) * 32767.0f);
+  int32_t s = 0;
+
+  switch (trk->State)
+  {
+    case LOOPER_STATE_RECORDING:
+      LOOPER_Write(hlooper, Track, trk->Length, in);
+      if (++trk->Length >= max)
+      {
+        LOOPER_Execute(hlooper, Track, LOOPER_ACTION_RECORD);
+      }
+      return 0.0f;
+
+    case LOOPER_STATE_PLAYING:
+      s = LOOPER_Read(hlooper, Track, trk->Position);
+      break;
+
+    case LOOPER_STATE_OVERDUB:
+      s = LOOPER_Read(hlooper, Track, trk->Position);
+      LOOPER_Write(hlooper, Track, trk->Position, s + in);
+      break;
+
+    case LOOPER_STATE_REPLACE:
+      LOOPER_Write(hlooper, Track, trk->Position, in);
+      break;
+
+    case LOOPER_STATE_MULTIPLY:
+      s = LOOPER_ReadBase(hlooper, Track, trk->Position % trk->BaseLength);
+      if ((trk->Position >= trk->BaseLength) || (trk->BaseSaved != 0U))
+      {
+        LOOPER_Write(hlooper, Track, trk->Position, (trk->Closing != 0U) ? s : s + in);
+      }
+      if (++trk->Position >= trk->Length)
+      {
+        if ((trk->Closing != 0U) || (trk->Length + trk->BaseLength > max))
+        {
+          LOOPER_Flush(hlooper, Track);
+          trk->Closing  = 0U;
+          trk->Position = 0U;
+          trk->State    = LOOPER_STATE_PLAYING;
+        }
+        else
+        {
+          trk->Length += trk->BaseLength;
+        }
+      }
+      return (float)s * (trk->Level / 32768.0f);
+
+    default:
+      return 0.0f;
+  }
+
+  /* Capture the input that follows the loop end for the loop point crossfade */
+  if (trk->TailCount < LOOPER_XFADE_FRAMES)
+  {
+    trk->Tail[trk->TailCount++] = (int16_t)in;
+    if (trk->TailCount == LOOPER_XFADE_FRAMES)
+    {
+      LOOPER_Crossfade(hlooper, Track);
+    }
+  }
+
+  if (++trk->Position >= trk->Length)
+  {
+    trk->Position = 0U;
+  }
+  return (float)s * (trk->Level / 32768.0f);
+}
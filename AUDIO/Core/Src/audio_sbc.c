@@ -0,0 +1,564 @@
+/**
+  ******************************************************************************
+  * @file    audio_sbc.c
+  * @brief   Bluetooth SBC (A2DP) encoder.
+  *
+  *          Follows the encoder of the A2DP specification: polyphase analysis
+  *          filter bank, scale factors, optional joint stereo per subband,
+  *          loudness or SNR bit allocation and the uniform quantizer. The
+  *          filter bank runs in single precision on the FPU; samples are
+  *          scaled to the 16-bit range so scale factors match the spec.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_sbc.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SBC_SYNCWORD              0x9CU
+#define SBC_PI                    3.14159265f
+#define SBC_PROTO4_TAPS           40U
+#define SBC_PROTO8_TAPS           80U
+#define SBC_PCM_SCALE             32768.0f
+#define SBC_CRC_INIT              0x0FU
+#define SBC_CRC_POLY              0x1DU
+
+/* Private variables ---------------------------------------------------------*/
+/** Analysis windows: prototype filter with the sign of every other
+    2 x Subbands section flipped, as tabulated in the specification */
+static const float SBC_Proto4[SBC_PROTO4_TAPS] =
+{
+    0.00000000e+00f,  5.36548976e-04f,  1.49188357e-03f,  2.73370904e-03f,
+    3.83720193e-03f,  3.89205149e-03f,  1.86581691e-03f, -3.06012286e-03f,
+    1.09137620e-02f,  2.04385087e-02f,  2.88757392e-02f,  3.21939290e-02f,
+    2.58767811e-02f,  6.13245186e-03f, -2.88217274e-02f, -7.76463494e-02f,
+    1.35593274e-01f,  1.94987841e-01f,  2.46636662e-01f,  2.81828203e-01f,
+    2.94315332e-01f,  2.81828203e-01f,  2.46636662e-01f,  1.94987841e-01f,
+   -1.35593274e-01f, -7.76463494e-02f, -2.88217274e-02f,  6.13245186e-03f,
+    2.58767811e-02f,  3.21939290e-02f,  2.88757392e-02f,  2.04385087e-02f,
+   -1.09137620e-02f, -3.06012286e-03f,  1.86581691e-03f,  3.89205149e-03f,
+    3.83720193e-03f,  2.73370904e-03f,  1.49188357e-03f,  5.36548976e-04f
+};
+
+static const float SBC_Proto8[SBC_PROTO8_TAPS] =
+{
+    0.00000000e+00f,  1.56575398e-04f,  3.43256425e-04f,  5.54620202e-04f,
+    8.23919506e-04f,  1.13992507e-03f,  1.47640169e-03f,  1.78371725e-03f,
+    2.01182542e-03f,  2.10371989e-03f,  1.99454554e-03f,  1.61656283e-03f,
+    9.02154502e-04f, -1.78805361e-04f, -1.64973098e-03f, -3.49717454e-03f,
+    5.65949473e-03f,  8.02941163e-03f,  1.04584443e-02f,  1.27472335e-02f,
+    1.46525263e-02f,  1.59045603e-02f,  1.62208471e-02f,  1.53184106e-02f,
+    1.29371806e-02f,  8.85757540e-03f,  2.92408442e-03f, -4.91578024e-03f,
+   -1.46404076e-02f, -2.61098752e-02f, -3.90751381e-02f, -5.31873032e-02f,
+    6.79989431e-02f,  8.29847578e-02f,  9.75753918e-02f,  1.11196689e-01f,
+    1.23264548e-01f,  1.33264415e-01f,  1.40753505e-01f,  1.45389847e-01f,
+    1.46955068e-01f,  1.45389847e-01f,  1.40753505e-01f,  1.33264415e-01f,
+    1.23264548e-01f,  1.11196689e-01f,  9.75753918e-02f,  8.29847578e-02f,
+   -6.79989431e-02f, -5.31873032e-02f, -3.90751381e-02f, -2.61098752e-02f,
+   -1.46404076e-02f, -4.91578024e-03f,  2.92408442e-03f,  8.85757540e-03f,
+    1.29371806e-02f,  1.53184106e-02f,  1.62208471e-02f,  1.59045603e-02f,
+    1.46525263e-02f,  1.27472335e-02f,  1.04584443e-02f,  8.02941163e-03f,
+   -5.65949473e-03f, -3.49717454e-03f, -1.64973098e-03f, -1.78805361e-04f,
+    9.02154502e-04f,  1.61656283e-03f,  1.99454554e-03f,  2.10371989e-03f,
+    2.01182542e-03f,  1.78371725e-03f,  1.47640169e-03f,  1.13992507e-03f,
+    8.23919506e-04f,  5.54620202e-04f,  3.43256425e-04f,  1.56575398e-04f
+};
+
+/** Loudness allocation offsets per sampling frequency */
+static const int8_t SBC_Offset4[4][4] =
+{
+  { -1, 0, 0, 0 }, { -2, 0, 0, 1 }, { -2, 0, 0, 1 }, { -2, 0, 0, 1 }
+};
+
+static const int8_t SBC_Offset8[4][8] =
+{
+  { -2, 0, 0, 0, 0, 0, 0, 1 }, { -3, 0, 0, 0, 0, 0, 1, 2 },
+  { -4, 0, 0, 0, 0, 0, 1, 2 }, { -4, 0, 0, 0, 0, 0, 1, 2 }
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void     SBC_Analyze(SBC_HandleTypeDef *hsbc, uint32_t Channel, const float *pIn, float *pOut);
+static uint8_t  SBC_ScaleFactor(float Peak);
+static void     SBC_JointStereo(SBC_HandleTypeDef *hsbc, uint8_t *pJoin);
+static void     SBC_Allocate(SBC_HandleTypeDef *hsbc, uint32_t First, uint32_t Channels);
+static void     SBC_PutBits(uint8_t *pOut, uint32_t *pPos, uint32_t Value, uint32_t Bits);
+static uint8_t  SBC_Crc(const uint8_t *pFrame, uint32_t Bits);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the encoder.
+  * @param  hsbc pointer to the SBC handle
+  * @param  pConfig stream parameters
+  * @retval AUDIO_OK, or AUDIO_ERROR for parameters SBC cannot code
+  */
+AUDIO_StatusTypeDef SBC_Init(SBC_HandleTypeDef *hsbc, const SBC_ConfigTypeDef *pConfig)
+{
+  uint32_t sb = pConfig->Subbands;
+  uint32_t blocks = pConfig->Blocks;
+  uint32_t channels = (pConfig->Mode == SBC_MODE_MONO) ? 1U : 2U;
+  uint32_t maxpool = 16U * sb * (((pConfig->Mode == SBC_MODE_STEREO) ||
+                                  (pConfig->Mode == SBC_MODE_JOINT_STEREO)) ? 2U : 1U);
+  uint32_t data;
+  uint32_t k;
+  uint32_t i;
+
+  if (((sb != 4U) && (sb != 8U)) || (blocks < 4U) || (blocks > SBC_MAX_BLOCKS) || ((blocks % 4U) != 0U) ||
+      (pConfig->Bitpool < 2U) || (pConfig->Bitpool > AUDIO_MIN(maxpool, SBC_MAX_BITPOOL)))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hsbc, 0, sizeof(*hsbc));
+  hsbc->Config   = *pConfig;
+  hsbc->Channels = (uint8_t)channels;
+  hsbc->Header   = (uint8_t)(((uint32_t)pConfig->Frequency << 6) | ((blocks / 4U - 1U) << 4) |
+                             ((uint32_t)pConfig->Mode << 2) | ((uint32_t)pConfig->Allocation << 1) |
+                             ((sb == 8U) ? 1U : 0U));
+
+  switch (pConfig->Mode)
+  {
+    case SBC_MODE_STEREO:
+      data = blocks * pConfig->Bitpool;
+      break;
+    case SBC_MODE_JOINT_STEREO:
+      data = sb + blocks * pConfig->Bitpool;
+      break;
+    default:
+      data = blocks * channels * pConfig->Bitpool;
+      break;
+  }
+  hsbc->FrameSize = (uint16_t)(4U + (4U * sb * channels) / 8U + (data + 7U) / 8U);
+
+  /* Cosine modulation: M[k][i] = cos((k + 0.5)(i - M/2) pi / M) */
+  for (k = 0U; k < sb; k++)
+  {
+    for (i = 0U; i < 2U * sb; i++)
+    {
+      hsbc->Matrix[k][i] = cosf(((float)k + 0.5f) * ((float)i - (float)sb / 2.0f) * SBC_PI / (float)sb);
+    }
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Returns the number of samples per channel coded in one frame.
+  * @param  hsbc pointer to the SBC handle
+  * @retval Blocks x Subbands
+  */
+uint32_t SBC_GetFrameSamples(const SBC_HandleTypeDef *hsbc)
+{
+  return (uint32_t)hsbc->Config.Blocks * hsbc->Config.Subbands;
+}
+
+/**
+  * @brief  Returns the length of every encoded frame.
+  * @param  hsbc pointer to the SBC handle
+  * @retval Frame length in bytes
+  */
+uint32_t SBC_GetFrameSize(const SBC_HandleTypeDef *hsbc)
+{
+  return hsbc->FrameSize;
+}
+
+/**
+  * @brief  Encodes one frame.
+  * @param  hsbc pointer to the SBC handle
+  * @param  pLeft SBC_GetFrameSamples() samples of the first channel, +/-1.0
+  * @param  pRight samples of the second channel, ignored in mono mode
+  * @param  pOut output buffer of SBC_GetFrameSize() bytes
+  * @retval Frame length in bytes
+  */
+uint32_t SBC_Encode(SBC_HandleTypeDef *hsbc, const float *pLeft, const float *pRight, uint8_t *pOut)
+{
+  const SBC_ConfigTypeDef *cfg = &hsbc->Config;
+  uint32_t sb = cfg->Subbands;
+  uint32_t ch;
+  uint32_t blk;
+  uint32_t k;
+  uint32_t pos;
+  uint8_t join = 0U;
+
+  /* Analysis and scale factors */
+  for (ch = 0U; ch < hsbc->Channels; ch++)
+  {
+    const float *in = (ch == 0U) ? pLeft : pRight;
+
+    for (blk = 0U; blk < cfg->Blocks; blk++)
+    {
+      SBC_Analyze(hsbc, ch, &in[blk * sb], hsbc->Samples[blk][ch]);
+    }
+    for (k = 0U; k < sb; k++)
+    {
+      float peak = 0.0f;
+
+      for (blk = 0U; blk < cfg->Blocks; blk++)
+      {
+        peak = AUDIO_MAX(peak, fabsf(hsbc->Samples[blk][ch][k]));
+      }
+      hsbc->ScaleFactor[ch][k] = SBC_ScaleFactor(peak);
+    }
+  }
+
+  if (cfg->Mode == SBC_MODE_JOINT_STEREO)
+  {
+    SBC_JointStereo(hsbc, &join);
+  }
+  if (cfg->Mode == SBC_MODE_DUAL_CHANNEL)
+  {
+    SBC_Allocate(hsbc, 0U, 1U);
+    SBC_Allocate(hsbc, 1U, 1U);
+  }
+  else
+  {
+    SBC_Allocate(hsbc, 0U, hsbc->Channels);
+  }
+
+  /* Header, joint flags and scale factors, protected by the CRC */
+  memset(pOut, 0, hsbc->FrameSize);
+  pOut[0] = SBC_SYNCWORD;
+  pOut[1] = hsbc->Header;
+  pOut[2] = cfg->Bitpool;
+  pos = 32U;
+  if (cfg->Mode == SBC_MODE_JOINT_STEREO)
+  {
+    SBC_PutBits(pOut, &pos, join, sb);
+  }
+  for (ch = 0U; ch < hsbc->Channels; ch++)
+  {
+    for (k = 0U; k < sb; k++)
+    {
+      SBC_PutBits(pOut, &pos, hsbc->ScaleFactor[ch][k], 4U);
+    }
+  }
+  pOut[3] = SBC_Crc(pOut, pos - 32U);
+
+  /* Quantized samples: (sample / 2^(sf+1) + 1) * levels / 2 */
+  for (blk = 0U; blk < cfg->Blocks; blk++)
+  {
+    for (ch = 0U; ch < hsbc->Channels; ch++)
+    {
+      for (k = 0U; k < sb; k++)
+      {
+        uint32_t bits = hsbc->Bits[ch][k];
+
+        if (bits != 0U)
+        {
+          float levels = (float)((1U << bits) - 1U);
+          float scale = levels / (float)(2U << hsbc->ScaleFactor[ch][k]);
+          int32_t q = (int32_t)((hsbc->Samples[blk][ch][k] * scale + levels) * 0.5f);
+
+          SBC_PutBits(pOut, &pos, (uint32_t)AUDIO_CLAMP(q, 0, (int32_t)levels), bits);
+        }
+      }
+    }
+  }
+  return hsbc->FrameSize;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Runs the analysis filter bank over one block of one channel.
+  * @note   The history is stored twice in a row, newest sample first, so the
+  *         window always reads a contiguous run of 10 x Subbands samples.
+  * @param  hsbc pointer to the SBC handle
+  * @param  Channel channel index
+  * @param  pIn Subbands new input samples, oldest first
+  * @param  pOut Subbands subband samples
+  * @retval None
+  */
+static void SBC_Analyze(SBC_HandleTypeDef *hsbc, uint32_t Channel, const float *pIn, float *pOut)
+{
+  uint32_t sb = hsbc->Config.Subbands;
+  uint32_t len = 10U * sb;
+  const float *c = (sb == 8U) ? SBC_Proto8 : SBC_Proto4;
+  float *hist = hsbc->History[Channel];
+  uint32_t pos = hsbc->Position[Channel];
+  float y[2U * SBC_MAX_SUBBANDS];
+  const float *x;
+  uint32_t i;
+  uint32_t j;
+
+  for (i = 0U; i < sb; i++)
+  {
+    pos = (pos == 0U) ? len - 1U : pos - 1U;
+    hist[pos] = pIn[i] * SBC_PCM_SCALE;
+    hist[pos + len] = hist[pos];
+  }
+  hsbc->Position[Channel] = (uint16_t)pos;
+  x = &hist[pos];
+
+  /* Windowing and partial sums: Y[i] = sum_j C[i + 2Mj] X[i + 2Mj] */
+  for (i = 0U; i < 2U * sb; i++)
+  {
+    float acc = 0.0f;
+
+    for (j = i; j < len; j += 2U * sb)
+    {
+      acc += c[j] * x[j];
+    }
+    y[i] = acc;
+  }
+
+  /* Matrixing */
+  for (i = 0U; i < sb; i++)
+  {
+    const float *m = hsbc->Matrix[i];
+    float acc = 0.0f;
+
+    for (j = 0U; j < 2U * sb; j++)
+    {
+      acc += m[j] * y[j];
+    }
+    pOut[i] = acc;
+  }
+}
+
+/**
+  * @brief  Returns the smallest scale factor sf with |sample| < 2^(sf+1).
+  * @param  Peak largest subband sample magnitude
+  * @retval Scale factor, 0 .. 15
+  */
+static uint8_t SBC_ScaleFactor(float Peak)
+{
+  uint8_t sf = 0U;
+
+  while ((sf < 15U) && (Peak >= (float)(2U << sf)))
+  {
+    sf++;
+  }
+  return sf;
+}
+
+/**
+  * @brief  Switches subbands to mid/side coding when that needs smaller
+  *         scale factors. The last subband is always coded left/right.
+  * @param  hsbc pointer to the SBC handle
+  * @param  pJoin joint flags, first subband in the most significant bit
+  * @retval None
+  */
+static void SBC_JointStereo(SBC_HandleTypeDef *hsbc, uint8_t *pJoin)
+{
+  uint32_t sb = hsbc->Config.Subbands;
+  uint32_t blocks = hsbc->Config.Blocks;
+  uint32_t blk;
+  uint32_t k;
+
+  *pJoin = 0U;
+  for (k = 0U; k + 1U < sb; k++)
+  {
+    float mid = 0.0f;
+    float side = 0.0f;
+    uint8_t sfm;
+    uint8_t sfs;
+
+    for (blk = 0U; blk < blocks; blk++)
+    {
+      float l = hsbc->Samples[blk][0][k];
+      float r = hsbc->Samples[blk][1][k];
+
+      mid  = AUDIO_MAX(mid, fabsf(0.5f * (l + r)));
+      side = AUDIO_MAX(side, fabsf(0.5f * (l - r)));
+    }
+    sfm = SBC_ScaleFactor(mid);
+    sfs = SBC_ScaleFactor(side);
+
+    if ((uint32_t)sfm + sfs < (uint32_t)hsbc->ScaleFactor[0][k] + hsbc->ScaleFactor[1][k])
+    {
+      *pJoin |= (uint8_t)(1U << (sb - 1U - k));
+      hsbc->ScaleFactor[0][k] = sfm;
+      hsbc->ScaleFactor[1][k] = sfs;
+      for (blk = 0U; blk < blocks; blk++)
+      {
+        float l = hsbc->Samples[blk][0][k];
+        float r = hsbc->Samples[blk][1][k];
+
+        hsbc->Samples[blk][0][k] = 0.5f * (l + r);
+        hsbc->Samples[blk][1][k] = 0.5f * (l - r);
+      }
+    }
+  }
+}
+
+/**
+  * @brief  Distributes the bitpool over the subbands of one or two channels.
+  * @param  hsbc pointer to the SBC handle
+  * @param  First first channel
+  * @param  Channels number of channels sharing the bitpool
+  * @retval None
+  */
+static void SBC_Allocate(SBC_HandleTypeDef *hsbc, uint32_t First, uint32_t Channels)
+{
+  const SBC_ConfigTypeDef *cfg = &hsbc->Config;
+  uint32_t sb = cfg->Subbands;
+  int32_t bitpool = cfg->Bitpool;
+  int32_t need[SBC_MAX_CHANNELS][SBC_MAX_SUBBANDS];
+  int32_t maxneed = 0;
+  int32_t bitcount = 0;
+  int32_t slicecount = 0;
+  int32_t slice;
+  uint32_t ch;
+  uint32_t k;
+
+  for (ch = 0U; ch < Channels; ch++)
+  {
+    const uint8_t *sf = hsbc->ScaleFactor[First + ch];
+
+    for (k = 0U; k < sb; k++)
+    {
+      if (cfg->Allocation == SBC_ALLOC_SNR)
+      {
+        need[ch][k] = sf[k];
+      }
+      else if (sf[k] == 0U)
+      {
+        need[ch][k] = -5;
+      }
+      else
+      {
+        int32_t loudness = (int32_t)sf[k] - ((sb == 8U) ? SBC_Offset8[cfg->Frequency][k]
+                                                         : SBC_Offset4[cfg->Frequency][k]);
+
+        need[ch][k] = (loudness > 0) ? loudness / 2 : loudness;
+      }
+      maxneed = AUDIO_MAX(maxneed, need[ch][k]);
+    }
+  }
+
+  /* Lower the slice until the next one would overflow the bitpool */
+  slice = maxneed + 1;
+  do
+  {
+    slice--;
+    bitcount += slicecount;
+    slicecount = 0;
+    for (ch = 0U; ch < Channels; ch++)
+    {
+      for (k = 0U; k < sb; k++)
+      {
+        if ((need[ch][k] > slice + 1) && (need[ch][k] < slice + 16))
+        {
+          slicecount++;
+        }
+        else if (need[ch][k] == slice + 1)
+        {
+          slicecount += 2;
+        }
+      }
+    }
+  } while (bitcount + slicecount < bitpool);
+
+  if (bitcount + slicecount == bitpool)
+  {
+    bitcount += slicecount;
+    slice--;
+  }
+
+  for (ch = 0U; ch < Channels; ch++)
+  {
+    uint8_t *bits = hsbc->Bits[First + ch];
+
+    for (k = 0U; k < sb; k++)
+    {
+      bits[k] = (need[ch][k] < slice + 2) ? 0U : (uint8_t)AUDIO_MIN(need[ch][k] - slice, 16);
+    }
+  }
+
+  /* Spend what is left, subband by subband, alternating channels */
+  ch = 0U;
+  k = 0U;
+  while ((bitcount < bitpool) && (k < sb))
+  {
+    uint8_t *bits = &hsbc->Bits[First + ch][k];
+
+    if ((*bits >= 2U) && (*bits < 16U))
+    {
+      (*bits)++;
+      bitcount++;
+    }
+    else if ((need[ch][k] == slice + 1) && (bitpool > bitcount + 1))
+    {
+      *bits = 2U;
+      bitcount += 2;
+    }
+    if (++ch == Channels)
+    {
+      ch = 0U;
+      k++;
+    }
+  }
+
+  ch = 0U;
+  k = 0U;
+  while ((bitcount < bitpool) && (k < sb))
+  {
+    uint8_t *bits = &hsbc->Bits[First + ch][k];
+
+    if (*bits < 16U)
+    {
+      (*bits)++;
+      bitcount++;
+    }
+    if (++ch == Channels)
+    {
+      ch = 0U;
+      k++;
+    }
+  }
+}
+
+/**
+  * @brief  Appends a field to the frame, most significant bit first.
+  * @param  pOut frame buffer, cleared beforehand
+  * @param  pPos bit position, updated
+  * @param  Value field value
+  * @param  Bits field width, at most 16
+  * @retval None
+  */
+static void SBC_PutBits(uint8_t *pOut, uint32_t *pPos, uint32_t Value, uint32_t Bits)
+{
+  uint32_t pos = *pPos;
+
+  while (Bits > 0U)
+  {
+    uint32_t room = 8U - (pos & 7U);
+    uint32_t n = AUDIO_MIN(room, Bits);
+
+    Bits -= n;
+    pOut[pos >> 3] |= (uint8_t)(((Value >> Bits) & ((1U << n) - 1U)) << (room - n));
+    pos += n;
+  }
+  *pPos = pos;
+}
+
+/**
+  * @brief  Computes the frame CRC-8 (x^8 + x^4 + x^3 + x^2 + 1).
+  * @note   Covers header bytes 1 and 2, then the given number of bits from
+  *         byte 4 on (joint flags and scale factors).
+  * @param  pFrame frame buffer
+  * @param  Bits number of bits following the CRC byte
+  * @retval CRC
+  */
+static uint8_t SBC_Crc(const uint8_t *pFrame, uint32_t Bits)
+{
+  uint8_t crc = SBC_CRC_INIT;
+  uint32_t total = 16U + Bits;
+  uint32_t i;
+
+  for (i = 0U; i < total; i++)
+  {
+    uint32_t byte = (i < 16U) ? (1U + (i >> 3)) : (4U + ((i - 16U) >> 3));
+    uint32_t bit = (pFrame[byte] >> (7U - (i & 7U))) & 1U;
+
+    crc = (uint8_t)((crc << 1) ^ ((((uint32_t)crc >> 7) ^ bit) != 0U ? SBC_CRC_POLY : 0U));
+  }
+  return crc;
+}
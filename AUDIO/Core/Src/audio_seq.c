@@ -0,0 +1,313 @@
+/**
+  ******************************************************************************
+  * @file    audio_seq.c
+  * @brief   Sample-accurate step sequencer.
+  *
+  *          The transport is clocked by the audio sample counter itself, which
+  *          is derived from the I2S clock and is therefore the highest
+  *          resolution and jitter-free time base available. Each block asks
+  *          SEQ_Process() for the triggers that fall inside it and receives
+  *          them with their exact frame offset, so timing does not depend on
+  *          the block size.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_seq.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SEQ_DEFAULT_TEMPO         12000U  /* 120.00 BPM */
+#define SEQ_TICKS_PER_STEP        (SEQ_MIDI_PPQN / SEQ_STEPS_PER_BEAT)
+#define SEQ_HALF                  0x80000000ULL
+#define SEQ_REBASE_AT             (1ULL << 30)  /* Samples from Origin, 6.2 h */
+#define SEQ_REBASE_BY             (1ULL << 29)
+
+/* Private function prototypes -----------------------------------------------*/
+static uint64_t SEQ_GridTime(const SEQ_HandleTypeDef *hseq, uint32_t Step);
+static void     SEQ_Reanchor(SEQ_HandleTypeDef *hseq, uint32_t Step, uint64_t Time);
+static void     SEQ_Rebase(SEQ_HandleTypeDef *hseq);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the sequencer, stopped, at the default tempo.
+  * @param  hseq pointer to the sequencer handle
+  * @param  pPattern pattern to play
+  * @retval None
+  */
+void SEQ_Init(SEQ_HandleTypeDef *hseq, const SEQ_PatternTypeDef *pPattern)
+{
+  memset(hseq, 0, sizeof(*hseq));
+  hseq->Pattern = pPattern;
+  hseq->Clock   = SEQ_CLOCK_INTERNAL;
+  hseq->Swing   = 50U;
+  SEQ_SetTempo(hseq, SEQ_DEFAULT_TEMPO);
+}
+
+/**
+  * @brief  Sets the internal tempo.
+  * @note   The change takes effect at the next step so that the step already
+  *         scheduled keeps its position.
+  * @param  hseq pointer to the sequencer handle
+  * @param  TempoX100 tempo in BPM * 100 (e.g. 12000 for 120 BPM)
+  * @retval None
+  */
+void SEQ_SetTempo(SEQ_HandleTypeDef *hseq, uint32_t TempoX100)
+{
+  if (TempoX100 == 0U)
+  {
+    return;
+  }
+  SEQ_Reanchor(hseq, hseq->NextStep, SEQ_GridTime(hseq, hseq->NextStep));
+  hseq->TempoX100 = TempoX100;
+  if (hseq->Clock == SEQ_CLOCK_INTERNAL)
+  {
+    hseq->StepLength = (((uint64_t)AUDIO_SAMPLE_RATE * 60U * 100U) << 32)
+                       / ((uint64_t)TempoX100 * SEQ_STEPS_PER_BEAT);
+  }
+}
+
+/**
+  * @brief  Sets the swing amount applied to odd steps.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Swing 50 (straight) .. 75 percent, 66 gives a triplet feel
+  * @retval None
+  */
+void SEQ_SetSwing(SEQ_HandleTypeDef *hseq, uint8_t Swing)
+{
+  hseq->Swing = AUDIO_CLAMP(Swing, 50U, 75U);
+}
+
+/**
+  * @brief  Selects the clock source of the transport.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Clock SEQ_CLOCK_INTERNAL or SEQ_CLOCK_MIDI
+  * @retval None
+  */
+void SEQ_SetClock(SEQ_HandleTypeDef *hseq, SEQ_ClockTypeDef Clock)
+{
+  hseq->Clock = Clock;
+  if (Clock == SEQ_CLOCK_INTERNAL)
+  {
+    SEQ_SetTempo(hseq, hseq->TempoX100);
+  }
+}
+
+/**
+  * @brief  Starts the transport from the first step.
+  * @note   With the MIDI clock the first step waits for the next tick,
+  *         as required after a MIDI Start message.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Offset frame offset of the first step inside the next block
+  * @retval None
+  */
+void SEQ_Start(SEQ_HandleTypeDef *hseq, uint32_t Offset)
+{
+  hseq->NextStep  = 0U;
+  hseq->TickCount = 0U;
+  SEQ_Reanchor(hseq, 0U, (hseq->Now - hseq->Origin + Offset) << 32);
+  hseq->Running = 1U;
+}
+
+/**
+  * @brief  Stops the transport.
+  * @param  hseq pointer to the sequencer handle
+  * @retval None
+  */
+void SEQ_Stop(SEQ_HandleTypeDef *hseq)
+{
+  hseq->Running = 0U;
+}
+
+/**
+  * @brief  Feeds one MIDI clock (0xF8) tick.
+  * @note   The tempo follows the filtered tick interval and the timeline is
+  *         pulled towards every step-aligned tick, which removes the UART
+  *         reception jitter while tracking the master within a few ticks.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Timestamp sample index at which the tick was received
+  * @retval None
+  */
+void SEQ_MidiClockTick(SEQ_HandleTypeDef *hseq, uint64_t Timestamp)
+{
+  uint32_t tick = hseq->TickCount++;
+  uint64_t actual = (Timestamp - hseq->Origin) << 32;
+
+  if ((hseq->Clock != SEQ_CLOCK_MIDI) || (hseq->Running == 0U))
+  {
+    hseq->TickCount = 0U;
+    return;
+  }
+
+  if (tick == 0U)
+  {
+    SEQ_Reanchor(hseq, 0U, actual);
+  }
+  else
+  {
+    uint64_t measured = ((Timestamp - hseq->LastTick) << 32) * SEQ_TICKS_PER_STEP;
+    int64_t  delta = (int64_t)(measured - hseq->StepLength);
+
+    /* First interval sets the tempo, later ones are smoothed */
+    hseq->StepLength = (tick == 1U) ? measured : (uint64_t)((int64_t)hseq->StepLength + delta / 8);
+
+    if ((tick % SEQ_TICKS_PER_STEP) == 0U)
+    {
+      uint32_t step = tick / SEQ_TICKS_PER_STEP;
+      uint64_t expected = SEQ_GridTime(hseq, step);
+      int64_t  error = (int64_t)(actual - expected);
+
+      SEQ_Reanchor(hseq, step, (uint64_t)((int64_t)expected + error / 4));
+    }
+  }
+  hseq->LastTick = Timestamp;
+}
+
+/**
+  * @brief  Collects the triggers that fall inside the next block and
+  *         advances the timeline by one block.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Frames block length in frames
+  * @param  pEvents array receiving the triggers, sorted by offset
+  * @param  MaxEvents capacity of pEvents
+  * @retval Number of triggers written to pEvents
+  */
+uint32_t SEQ_Process(SEQ_HandleTypeDef *hseq, uint32_t Frames, SEQ_EventTypeDef *pEvents,
+                     uint32_t MaxEvents)
+{
+  const SEQ_PatternTypeDef *pat = hseq->Pattern;
+  uint64_t now = hseq->Now - hseq->Origin;
+  uint64_t end = now + Frames;
+  uint32_t count = 0U;
+  uint32_t track;
+
+  while ((hseq->Running != 0U) && (pat != NULL) && (pat->Length != 0U))
+  {
+    uint64_t at;
+    uint32_t slot;
+    uint32_t needed = 0U;
+
+    if ((hseq->Clock == SEQ_CLOCK_MIDI) && (hseq->TickCount == 0U))
+    {
+      break;
+    }
+
+    at = (SEQ_StepTime(hseq, hseq->NextStep) + SEQ_HALF) >> 32;
+    if (at >= end)
+    {
+      break;
+    }
+
+    slot = hseq->NextStep % pat->Length;
+    for (track = 0U; track < SEQ_MAX_TRACKS; track++)
+    {
+      needed += (pat->Steps[track][slot].Active != 0U) ? 1U : 0U;
+    }
+    if (count + needed > MaxEvents)
+    {
+      /* Keep the step whole; it fires at the start of the next block */
+      break;
+    }
+
+    for (track = 0U; track < SEQ_MAX_TRACKS; track++)
+    {
+      const SEQ_StepTypeDef *step = &pat->Steps[track][slot];
+      SEQ_EventTypeDef *ev;
+      uint32_t i;
+
+      if (step->Active == 0U)
+      {
+        continue;
+      }
+      ev = &pEvents[count++];
+      ev->Offset   = (at > now) ? (uint32_t)(at - now) : 0U;
+      ev->Track    = (uint8_t)track;
+      ev->Velocity = step->Velocity;
+      memcpy(ev->Params, pat->Params[track], sizeof(ev->Params));
+      for (i = 0U; i < step->NumLocks; i++)
+      {
+        if (step->Locks[i].Param < SEQ_PARAM_COUNT)
+        {
+          ev->Params[step->Locks[i].Param] = step->Locks[i].Value;
+        }
+      }
+    }
+    hseq->NextStep++;
+  }
+
+  hseq->Now += Frames;
+  if (end >= SEQ_REBASE_AT)
+  {
+    SEQ_Rebase(hseq);
+  }
+  return count;
+}
+
+/**
+  * @brief  Returns the position of a step, swing included.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Step absolute step index since start
+  * @retval Sample position from Origin in 32.32 fixed point
+  */
+uint64_t SEQ_StepTime(const SEQ_HandleTypeDef *hseq, uint32_t Step)
+{
+  uint64_t t = SEQ_GridTime(hseq, Step);
+
+  if ((Step & 1U) != 0U)
+  {
+    /* Swing S% places the odd step at S% of the step pair */
+    t += (hseq->StepLength / 100U) * (2U * hseq->Swing - 100U);
+  }
+  return t;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Returns the straight-grid position of a step.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Step absolute step index since start
+  * @retval Sample position from Origin in 32.32 fixed point
+  */
+static uint64_t SEQ_GridTime(const SEQ_HandleTypeDef *hseq, uint32_t Step)
+{
+  int64_t steps = (int32_t)(Step - hseq->AnchorStep);
+
+  return (uint64_t)((int64_t)hseq->Anchor + steps * (int64_t)hseq->StepLength);
+}
+
+/**
+  * @brief  Anchors the timeline at a given step.
+  * @param  hseq pointer to the sequencer handle
+  * @param  Step step index
+  * @param  Time position of that step, 32.32
+  * @retval None
+  */
+static void SEQ_Reanchor(SEQ_HandleTypeDef *hseq, uint32_t Step, uint64_t Time)
+{
+  hseq->Anchor     = Time;
+  hseq->AnchorStep = Step;
+}
+
+/**
+  * @brief  Moves the origin of the positions forward.
+  * @note   The timeline is first anchored at the next step, which keeps every
+  *         future position exact and the step count from the anchor small.
+  *         While running, the next step is never more than a block in the
+  *         past, so it stays positive with the origin SEQ_REBASE_BY behind
+  *         it; stopped, SEQ_Start() anchors the timeline again anyway.
+  * @param  hseq pointer to the sequencer handle
+  * @retval None
+  */
+static void SEQ_Rebase(SEQ_HandleTypeDef *hseq)
+{
+  SEQ_Reanchor(hseq, hseq->NextStep, SEQ_GridTime(hseq, hseq->NextStep));
+  hseq->Origin += SEQ_REBASE_BY;
+  hseq->Anchor -= SEQ_REBASE_BY << 32;
+}
@@ -0,0 +1,312 @@
+/**
+  ******************************************************************************
+  * @file    audio_spatial.c
+  * @brief   Binaural HRTF spatializer for headphones.
+  *
+  *          Each source is delayed per ear by its interaural time difference,
+  *          applied as a linearly interpolated fractional delay, then filtered
+  *          by short minimum-phase HRIRs on the shared FIR engine. Because the
+  *          responses are minimum phase with the ITD removed, a bilinear blend
+  *          of the four nearest measurements is a valid response for positions
+  *          between them. The blend is only recomputed when a source moves,
+  *          into the other of two banks, and the FIR outputs of the old and
+  *          new blends are crossfaded over the next block so moves do not
+  *          click.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_spatial.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SPATIAL_HISTORY           (SPATIAL_MAX_ITD + 2U)
+
+/* Private function prototypes -----------------------------------------------*/
+static void SPATIAL_Delay(const float *pLine, float *pOut, float From, float To, float Gain,
+                          uint32_t Frames);
+static void SPATIAL_ProcessBlock(SPATIAL_HandleTypeDef *hspat, const float * const *ppIn,
+                                 uint32_t Offset, float *pLeft, float *pRight, uint32_t Frames);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the spatializer with all sources disabled.
+  * @param  hspat pointer to the spatializer handle
+  * @param  pSet HRTF set
+  * @retval AUDIO_OK or AUDIO_ERROR if the set exceeds the compiled limits
+  */
+AUDIO_StatusTypeDef SPATIAL_Init(SPATIAL_HandleTypeDef *hspat, const SPATIAL_HrtfSetTypeDef *pSet)
+{
+  uint32_t s;
+  uint32_t ear;
+
+  if ((pSet->NumTaps == 0U) || (pSet->NumTaps > SPATIAL_MAX_TAPS) ||
+      (pSet->NumAzimuth == 0U) || (pSet->NumElevation == 0U))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hspat, 0, sizeof(*hspat));
+  hspat->pSet = pSet;
+  for (s = 0U; s < SPATIAL_MAX_SOURCES; s++)
+  {
+    SPATIAL_SourceTypeDef *src = &hspat->Sources[s];
+
+    for (ear = 0U; ear < 2U; ear++)
+    {
+      FIR_Init(&src->Fir[ear], src->Coeffs[0][ear], src->FirState[ear], pSet->NumTaps,
+               AUDIO_BLOCK_SIZE);
+    }
+    src->Gain  = 1.0f;
+    src->Dirty = 1U;
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Moves a source.
+  * @note   Can be called every block for moving sources; the HRIR blend
+  *         is recomputed once, at the start of the next block.
+  * @param  hspat pointer to the spatializer handle
+  * @param  Source source index
+  * @param  Azimuth degrees clockwise from the front
+  * @param  Elevation degrees, positive up
+  * @param  Distance distance in meters, 1 m or less is unattenuated
+  * @retval None
+  */
+void SPATIAL_SetSource(SPATIAL_HandleTypeDef *hspat, uint32_t Source, float Azimuth,
+                       float Elevation, float Distance)
+{
+  SPATIAL_SourceTypeDef *src;
+
+  if (Source >= SPATIAL_MAX_SOURCES)
+  {
+    return;
+  }
+  src = &hspat->Sources[Source];
+  src->Azimuth   = Azimuth;
+  src->Elevation = Elevation;
+  src->Gain      = 1.0f / AUDIO_MAX(Distance, 1.0f);
+  src->Dirty     = 1U;
+}
+
+/**
+  * @brief  Enables or disables a source.
+  * @param  hspat pointer to the spatializer handle
+  * @param  Source source index
+  * @param  Enable 1 to render the source, 0 to skip it
+  * @retval None
+  */
+void SPATIAL_EnableSource(SPATIAL_HandleTypeDef *hspat, uint32_t Source, uint8_t Enable)
+{
+  SPATIAL_SourceTypeDef *src;
+
+  if (Source >= SPATIAL_MAX_SOURCES)
+  {
+    return;
+  }
+  src = &hspat->Sources[Source];
+  if ((Enable != 0U) && (src->Active == 0U))
+  {
+    /* Start on the current position: nothing to glide or fade from */
+    FIR_Reset(&src->Fir[0]);
+    FIR_Reset(&src->Fir[1]);
+    memset(src->Delay, 0, sizeof(src->Delay));
+    SPATIAL_Interpolate(hspat->pSet, src->Azimuth, src->Elevation, src->Coeffs[src->Bank][0],
+                        src->Coeffs[src->Bank][1], &src->ItdTarget);
+    src->Itd    = src->ItdTarget;
+    src->Dirty  = 0U;
+    src->Fading = 0U;
+  }
+  src->Active = Enable;
+}
+
+/**
+  * @brief  Computes the HRIR pair and ITD for an arbitrary direction by
+  *         bilinear interpolation of the four nearest measurements.
+  * @param  pSet HRTF set
+  * @param  Azimuth degrees clockwise from the front
+  * @param  Elevation degrees, clamped to the measured range
+  * @param  pLeft NumTaps left ear coefficients
+  * @param  pRight NumTaps right ear coefficients
+  * @param  pItd interaural delay in samples, positive when left is later
+  * @retval None
+  */
+void SPATIAL_Interpolate(const SPATIAL_HrtfSetTypeDef *pSet, float Azimuth, float Elevation,
+                         float *pLeft, float *pRight, float *pItd)
+{
+  const uint32_t taps = pSet->NumTaps;
+  float a = Azimuth * ((float)pSet->NumAzimuth / 360.0f);
+  float e = (pSet->NumElevation > 1U) ? (Elevation - pSet->ElevationMin) / pSet->ElevationStep : 0.0f;
+  uint32_t i0;
+  uint32_t i1;
+  uint32_t j0;
+  uint32_t j1;
+  uint32_t idx[4];
+  float w[4];
+  float fa;
+  float fe;
+  uint32_t k;
+  uint32_t t;
+
+  a -= (float)pSet->NumAzimuth * floorf(a / (float)pSet->NumAzimuth);
+  e = AUDIO_CLAMP(e, 0.0f, (float)(pSet->NumElevation - 1U));
+  i0 = (uint32_t)a % pSet->NumAzimuth;
+  i1 = (i0 + 1U) % pSet->NumAzimuth;
+  fa = a - floorf(a);
+  j0 = (uint32_t)e;
+  j1 = AUDIO_MIN(j0 + 1U, (uint32_t)pSet->NumElevation - 1U);
+  fe = e - (float)j0;
+
+  idx[0] = j0 * pSet->NumAzimuth + i0;
+  idx[1] = j0 * pSet->NumAzimuth + i1;
+  idx[2] = j1 * pSet->NumAzimuth + i0;
+  idx[3] = j1 * pSet->NumAzimuth + i1;
+  w[0] = (1.0f - fa) * (1.0f - fe);
+  w[1] = fa * (1.0f - fe);
+  w[2] = (1.0f - fa) * fe;
+  w[3] = fa * fe;
+
+  memset(pLeft, 0, taps * sizeof(float));
+  memset(pRight, 0, taps * sizeof(float));
+  *pItd = 0.0f;
+  for (k = 0U; k < 4U; k++)
+  {
+    const float *l = &pSet->pFilters[(idx[k] * 2U) * taps];
+    const float *r = l + taps;
+
+    for (t = 0U; t < taps; t++)
+    {
+      pLeft[t]  += w[k] * l[t];
+      pRight[t] += w[k] * r[t];
+    }
+    *pItd += w[k] * pSet->pItd[idx[k]];
+  }
+  *pItd = AUDIO_CLAMP(*pItd, -(float)SPATIAL_MAX_ITD, (float)SPATIAL_MAX_ITD);
+}
+
+/**
+  * @brief  Renders all active sources into a stereo buffer.
+  * @param  hspat pointer to the spatializer handle
+  * @param  ppIn SPATIAL_MAX_SOURCES mono inputs, NULL entries are skipped
+  * @param  pLeft left output, overwritten
+  * @param  pRight right output, overwritten
+  * @param  Frames number of frames
+  * @retval None
+  */
+void SPATIAL_Process(SPATIAL_HandleTypeDef *hspat, const float * const *ppIn,
+                     float *pLeft, float *pRight, uint32_t Frames)
+{
+  uint32_t offset = 0U;
+
+  while (offset < Frames)
+  {
+    uint32_t n = AUDIO_MIN(Frames - offset, AUDIO_BLOCK_SIZE);
+
+    SPATIAL_ProcessBlock(hspat, ppIn, offset, &pLeft[offset], &pRight[offset], n);
+    offset += n;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Renders at most AUDIO_BLOCK_SIZE frames.
+  * @param  hspat pointer to the spatializer handle
+  * @param  ppIn source inputs
+  * @param  Offset offset of this chunk in the source inputs
+  * @param  pLeft left output
+  * @param  pRight right output
+  * @param  Frames number of frames
+  * @retval None
+  */
+static void SPATIAL_ProcessBlock(SPATIAL_HandleTypeDef *hspat, const float * const *ppIn,
+                                 uint32_t Offset, float *pLeft, float *pRight, uint32_t Frames)
+{
+  uint32_t s;
+
+  memset(pLeft, 0, Frames * sizeof(float));
+  memset(pRight, 0, Frames * sizeof(float));
+
+  for (s = 0U; s < SPATIAL_MAX_SOURCES; s++)
+  {
+    SPATIAL_SourceTypeDef *src = &hspat->Sources[s];
+    float from;
+
+    if ((src->Active == 0U) || (ppIn[s] == NULL))
+    {
+      continue;
+    }
+    if (src->Dirty != 0U)
+    {
+      src->Dirty  = 0U;
+      src->Bank  ^= 1U;
+      src->Fading = 1U;
+      SPATIAL_Interpolate(hspat->pSet, src->Azimuth, src->Elevation,
+                          src->Coeffs[src->Bank][0], src->Coeffs[src->Bank][1], &src->ItdTarget);
+      src->Fir[0].pCoeffs = src->Coeffs[src->Bank][0];
+      src->Fir[1].pCoeffs = src->Coeffs[src->Bank][1];
+    }
+
+    memcpy(&src->Delay[SPATIAL_HISTORY], &ppIn[s][Offset], Frames * sizeof(float));
+
+    /* The delay glides to its target over one block, which avoids clicks */
+    from = src->Itd;
+    SPATIAL_Delay(src->Delay, hspat->EarIn[0], AUDIO_MAX(from, 0.0f),
+                  AUDIO_MAX(src->ItdTarget, 0.0f), src->Gain, Frames);
+    SPATIAL_Delay(src->Delay, hspat->EarIn[1], AUDIO_MAX(-from, 0.0f),
+                  AUDIO_MAX(-src->ItdTarget, 0.0f), src->Gain, Frames);
+    src->Itd = src->ItdTarget;
+    memmove(src->Delay, &src->Delay[Frames], SPATIAL_HISTORY * sizeof(float));
+
+    /* So does the HRIR pair, a block of both pairs crossfaded */
+    if (src->Fading != 0U)
+    {
+      src->Fading = 0U;
+      FIR_CrossfadeAccumulate(&src->Fir[0], src->Coeffs[src->Bank ^ 1U][0], hspat->EarIn[0],
+                              pLeft, Frames);
+      FIR_CrossfadeAccumulate(&src->Fir[1], src->Coeffs[src->Bank ^ 1U][1], hspat->EarIn[1],
+                              pRight, Frames);
+    }
+    else
+    {
+      FIR_ProcessAccumulate(&src->Fir[0], hspat->EarIn[0], pLeft, Frames);
+      FIR_ProcessAccumulate(&src->Fir[1], hspat->EarIn[1], pRight, Frames);
+    }
+  }
+}
+
+/**
+  * @brief  Reads a delay line with a linearly interpolated, ramping delay.
+  * @param  pLine delay line: SPATIAL_HISTORY past samples then the block
+  * @param  pOut output samples
+  * @param  From delay at the start of the block, in samples
+  * @param  To delay at the end of the block, in samples
+  * @param  Gain gain applied to the output
+  * @param  Frames number of frames
+  * @retval None
+  */
+static void SPATIAL_Delay(const float *pLine, float *pOut, float From, float To, float Gain,
+                          uint32_t Frames)
+{
+  float step = (To - From) / (float)Frames;
+  float d = From;
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    float pos = (float)(SPATIAL_HISTORY + i) - d;
+    uint32_t k = (uint32_t)pos;
+    float f = pos - (float)k;
+
+    pOut[i] = (pLine[k] + (pLine[k + 1U] - pLine[k]) * f) * Gain;
+    d += step;
+  }
+}
@@ -0,0 +1,426 @@
+/**
+  ******************************************************************************
+  * @file    audio_stream.c
+  * @brief   SD sample streaming: RAM heads and a deadline-ordered refill.
+  *
+  *          A card read takes a millisecond on a good day and a hundred
+  *          when the card is busy with its own housekeeping, so voices
+  *          cannot wait for the card at trigger time. Each streamed sample
+  *          keeps its first milliseconds in RAM: a triggered voice plays
+  *          them in place while its prefetch ring fills from the card.
+  *
+  *          One read is in flight at a time and STREAM_Poll() picks the
+  *          next one from the background context:
+  *           - the voice closest to running dry goes first (earliest
+  *             deadline), counting what is left of its head and its ring
+  *             at its playback rate;
+  *           - it asks for all its ring can take, as far as the sample is
+  *             contiguous on the card, in one multi-block read;
+  *           - other voices wanting sectors within or right after that
+  *             range ride along, so two voices on the same sample or on
+  *             samples stored back to back cost one command;
+  *           - with no voice in need, sample heads are read in.
+  *          Data lands in a staging buffer and is copied out per voice, as
+  *          WAV data does not start on a sector boundary. Each read carries
+  *          the slack of its neediest voice as a deadline, so an I/O
+  *          scheduler below can weigh it against other users of the card.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_stream.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define STREAM_NO_SLACK           0xFFFFFFFFU
+#define STREAM_STAGE_BYTES        (STREAM_MAX_SECTORS * LIBRARY_SECTOR_SIZE)
+#define STREAM_MIN_READ           (VOICE_PREFETCH_LEN / 2U)
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t STREAM_SourceRead(void *Context, uint32_t Position, int16_t *pDst, uint32_t Count);
+static STREAM_SampleTypeDef *STREAM_SampleOf(const VOICE_HandleTypeDef *hvoice);
+static uint32_t STREAM_Slack(const VOICE_HandleTypeDef *hvoice);
+static uint32_t STREAM_SlackUs(uint32_t Slack);
+static uint8_t  STREAM_Plan(STREAM_HandleTypeDef *hstream, const STREAM_TargetTypeDef *pTarget);
+static void     STREAM_Deliver(STREAM_HandleTypeDef *hstream);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the streaming scheduler.
+  * @param  hstream pointer to the stream handle
+  * @param  pConfig card access
+  * @param  hlib loaded sample library of the card
+  * @param  pVoices voices the scheduler refills; voices playing other sources
+  *         are left alone
+  * @param  NumVoices number of voices, up to STREAM_MAX_VOICES
+  * @retval AUDIO_OK, or AUDIO_ERROR on a bad configuration
+  */
+AUDIO_StatusTypeDef STREAM_Init(STREAM_HandleTypeDef *hstream, const STREAM_ConfigTypeDef *pConfig,
+                                const LIBRARY_HandleTypeDef *hlib, VOICE_HandleTypeDef *pVoices,
+                                uint32_t NumVoices)
+{
+  if ((pConfig->Read == NULL) || (hlib->pHeader == NULL) || (NumVoices > STREAM_MAX_VOICES))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hstream, 0, sizeof(*hstream));
+  hstream->Config = *pConfig;
+  hstream->hlib = hlib;
+  hstream->pVoices = pVoices;
+  hstream->NumVoices = NumVoices;
+  hstream->MinSlack = STREAM_NO_SLACK;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Opens a sample of the library for streaming.
+  * @note   The head is read in by STREAM_Poll() when no voice needs the
+  *         card; STREAM_IsPreloaded() tells when all heads are in. Size it
+  *         for the worst card latency expected: 20 to 50 ms covers most
+  *         cards, not the pauses of a nearly full one.
+  * @param  hstream pointer to the stream handle
+  * @param  pSample sample to set up, kept while the stream runs
+  * @param  Id library Id of the sample
+  * @param  pHead RAM for the head, NULL to stream from the first sample
+  * @param  HeadLength head length in samples
+  * @retval AUDIO_OK, or AUDIO_ERROR if the sample is not in the library, is
+  *         not mono 16-bit, or too many samples are open
+  */
+AUDIO_StatusTypeDef STREAM_AddSample(STREAM_HandleTypeDef *hstream, STREAM_SampleTypeDef *pSample,
+                                     uint32_t Id, int16_t *pHead, uint32_t HeadLength)
+{
+  const LIBRARY_EntryTypeDef *entry = LIBRARY_Find(hstream->hlib, Id);
+
+  if ((entry == NULL) || (entry->Format != LIBRARY_FORMAT_PCM16) || (entry->Channels != 1U)
+      || (hstream->NumSamples == STREAM_MAX_SAMPLES))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(pSample, 0, sizeof(*pSample));
+  pSample->pEntry = entry;
+  pSample->pHead = pHead;
+  pSample->HeadLength = (pHead != NULL) ? AUDIO_MIN(HeadLength, entry->Frames) : 0U;
+  pSample->Source.Read = STREAM_SourceRead;
+  pSample->Source.Context = pSample;
+  pSample->Source.Length = entry->Frames;
+  pSample->Source.Head = pHead;
+  hstream->pSamples[hstream->NumSamples++] = pSample;
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Completes the read in flight and starts the next one.
+  * @note   Called repeatedly from the background context.
+  * @param  hstream pointer to the stream handle
+  * @retval None
+  */
+void STREAM_Poll(STREAM_HandleTypeDef *hstream)
+{
+  STREAM_TargetTypeDef target;
+  uint32_t taken = 0U;
+  uint32_t best = hstream->NumVoices;
+  uint32_t bestSlack = STREAM_NO_SLACK;
+  uint32_t minSlack = STREAM_NO_SLACK;
+  uint8_t preload = 0U;
+  uint8_t changed;
+  uint32_t v;
+  uint32_t s;
+
+  if (hstream->Busy != 0U)
+  {
+    if (hstream->Done == 0U)
+    {
+      return;
+    }
+    STREAM_Deliver(hstream);
+    hstream->Busy = 0U;
+  }
+
+  /* Earliest deadline first, among voices with a chunk of room */
+  for (v = 0U; v < hstream->NumVoices; v++)
+  {
+    VOICE_HandleTypeDef *hvoice = &hstream->pVoices[v];
+    STREAM_SampleTypeDef *sample = STREAM_SampleOf(hvoice);
+    uint32_t position;
+    uint32_t generation;
+    uint32_t need;
+    uint32_t slack;
+
+    if (sample == NULL)
+    {
+      continue;
+    }
+    need = VOICE_Need(hvoice, &position, &generation);
+    slack = STREAM_Slack(hvoice);
+    if (position < sample->Source.Length)
+    {
+      minSlack = AUDIO_MIN(minSlack, slack);
+    }
+    if ((need == 0U) || ((need < STREAM_MIN_READ) && ((position + need) < sample->Source.Length)))
+    {
+      continue;
+    }
+    if (slack < bestSlack)
+    {
+      best = v;
+      bestSlack = slack;
+    }
+  }
+
+  if (hstream->Config.Expect != NULL)
+  {
+    hstream->Config.Expect(hstream->Config.Context, STREAM_SlackUs(minSlack));
+  }
+
+  hstream->NumTargets = 0U;
+  memset(&target, 0, sizeof(target));
+  if (best < hstream->NumVoices)
+  {
+    target.pVoice = &hstream->pVoices[best];
+    target.pSample = STREAM_SampleOf(target.pVoice);
+    target.Count = VOICE_Need(target.pVoice, &target.Position, &target.Generation);
+    (void)STREAM_Plan(hstream, &target);
+    taken = 1UL << best;
+    hstream->MinSlack = AUDIO_MIN(hstream->MinSlack, bestSlack);
+  }
+  else
+  {
+    for (s = 0U; (s < hstream->NumSamples) && (hstream->NumTargets == 0U); s++)
+    {
+      STREAM_SampleTypeDef *sample = hstream->pSamples[s];
+
+      if (sample->Loaded < sample->HeadLength)
+      {
+        target.pSample = sample;
+        target.Position = sample->Loaded;
+        target.Count = sample->HeadLength - sample->Loaded;
+        (void)STREAM_Plan(hstream, &target);
+        preload = 1U;
+      }
+    }
+  }
+  if (hstream->NumTargets == 0U)
+  {
+    return;
+  }
+
+  /* Ride along: whatever is wanted within or right after the range read */
+  do
+  {
+    changed = 0U;
+    for (v = 0U; v < hstream->NumVoices; v++)
+    {
+      if ((taken & (1UL << v)) != 0U)
+      {
+        continue;
+      }
+      target.pVoice = &hstream->pVoices[v];
+      target.pSample = STREAM_SampleOf(target.pVoice);
+      if (target.pSample == NULL)
+      {
+        continue;
+      }
+      target.Count = VOICE_Need(target.pVoice, &target.Position, &target.Generation);
+      if ((target.Count > 0U) && (STREAM_Plan(hstream, &target) != 0U))
+      {
+        taken |= 1UL << v;
+        hstream->Merged++;
+        changed = 1U;
+      }
+    }
+    for (s = 0U; (s < hstream->NumSamples) && (preload == 0U); s++)
+    {
+      STREAM_SampleTypeDef *sample = hstream->pSamples[s];
+
+      target.pVoice = NULL;
+      target.pSample = sample;
+      target.Position = sample->Loaded;
+      target.Count = sample->HeadLength - sample->Loaded;
+      if ((target.Count > 0U) && (STREAM_Plan(hstream, &target) != 0U))
+      {
+        preload = 1U;
+        changed = 1U;
+      }
+    }
+  } while (changed != 0U);
+
+  hstream->Requests++;
+  hstream->SectorsRead += hstream->Sectors;
+  hstream->Done = 0U;
+  hstream->Busy = 1U;
+  if (hstream->Config.Read(hstream->Config.Context, hstream->Lba, hstream->Sectors,
+                           (uint8_t *)hstream->Stage, STREAM_SlackUs(bestSlack)) != AUDIO_OK)
+  {
+    hstream->Errors++;
+    hstream->Busy = 0U;
+  }
+}
+
+/**
+  * @brief  Card read completion.
+  * @note   Called from the card driver, in any context.
+  * @param  hstream pointer to the stream handle
+  * @param  Status AUDIO_OK if the sectors were read
+  * @retval None
+  */
+void STREAM_ReadComplete(STREAM_HandleTypeDef *hstream, AUDIO_StatusTypeDef Status)
+{
+  hstream->Result = Status;
+  hstream->Done = 1U;
+}
+
+/**
+  * @brief  Tells whether all sample heads are in RAM.
+  * @param  hstream pointer to the stream handle
+  * @retval 1 when every head is loaded, 0 otherwise
+  */
+uint8_t STREAM_IsPreloaded(const STREAM_HandleTypeDef *hstream)
+{
+  uint32_t s;
+
+  for (s = 0U; s < hstream->NumSamples; s++)
+  {
+    if (hstream->pSamples[s]->Loaded < hstream->pSamples[s]->HeadLength)
+    {
+      return 0U;
+    }
+  }
+  return 1U;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/* VOICE_Service() on a streamed voice: the scheduler does the reading */
+static uint32_t STREAM_SourceRead(void *Context, uint32_t Position, int16_t *pDst, uint32_t Count)
+{
+  (void)Context;
+  (void)Position;
+  (void)pDst;
+  (void)Count;
+  return 0U;
+}
+
+static STREAM_SampleTypeDef *STREAM_SampleOf(const VOICE_HandleTypeDef *hvoice)
+{
+  const VOICE_SourceTypeDef *src = hvoice->Source;
+
+  if ((src == NULL) || (src->Read != STREAM_SourceRead))
+  {
+    return NULL;
+  }
+  return (STREAM_SampleTypeDef *)src->Context;
+}
+
+/* Output frames until the voice plays past what it has, head included */
+static uint32_t STREAM_Slack(const VOICE_HandleTypeDef *hvoice)
+{
+  uint32_t consumed = hvoice->Consumed;
+  uint64_t ahead = (uint64_t)(hvoice->Fetched - consumed) << 32;
+
+  if (hvoice->Increment == 0U)
+  {
+    return STREAM_NO_SLACK - 1U;
+  }
+  return (uint32_t)AUDIO_MIN(ahead / hvoice->Increment, (uint64_t)(STREAM_NO_SLACK - 1U));
+}
+
+/* Output frames to microseconds, STREAM_NO_SLACK meaning no deadline */
+static uint32_t STREAM_SlackUs(uint32_t Slack)
+{
+  if (Slack == STREAM_NO_SLACK)
+  {
+    return STREAM_NO_DEADLINE;
+  }
+  return (uint32_t)AUDIO_MIN(((uint64_t)Slack * 1000000U) / AUDIO_SAMPLE_RATE,
+                             (uint64_t)(STREAM_NO_DEADLINE - 1U));
+}
+
+/* Adds a target to the read being planned if its data lies within or right
+   after it, extending the read as far as the stage and the card run allow */
+static uint8_t STREAM_Plan(STREAM_HandleTypeDef *hstream, const STREAM_TargetTypeDef *pTarget)
+{
+  STREAM_TargetTypeDef *t = &hstream->Targets[hstream->NumTargets];
+  uint32_t byte = pTarget->pSample->pEntry->DataOffset + (pTarget->Position * sizeof(int16_t));
+  uint32_t within = byte % LIBRARY_SECTOR_SIZE;
+  uint32_t contiguous;
+  uint32_t offset;
+  uint32_t bytes;
+  uint32_t lba;
+
+  contiguous = LIBRARY_Locate(hstream->hlib, pTarget->pSample->pEntry, byte, &lba);
+  if (contiguous == 0U)
+  {
+    return 0U;
+  }
+  if (hstream->NumTargets == 0U)
+  {
+    hstream->Lba = lba;
+    hstream->Sectors = 0U;
+  }
+  else if ((lba < hstream->Lba) || (lba > (hstream->Lba + hstream->Sectors))
+           || (hstream->NumTargets > STREAM_MAX_VOICES))
+  {
+    return 0U;
+  }
+
+  offset = ((lba - hstream->Lba) * LIBRARY_SECTOR_SIZE) + within;
+  if (offset >= STREAM_STAGE_BYTES)
+  {
+    return 0U;
+  }
+  bytes = AUDIO_MIN(AUDIO_MIN(pTarget->Count * (uint32_t)sizeof(int16_t), contiguous),
+                    STREAM_STAGE_BYTES - offset) & ~1U;
+  if (bytes == 0U)
+  {
+    return 0U;
+  }
+
+  *t = *pTarget;
+  t->Offset = offset;
+  t->Count = bytes / sizeof(int16_t);
+  hstream->Sectors = AUDIO_MAX(hstream->Sectors,
+                               (offset + bytes + LIBRARY_SECTOR_SIZE - 1U) / LIBRARY_SECTOR_SIZE);
+  hstream->NumTargets++;
+  return 1U;
+}
+
+/* Hands the read data to the voices and heads it was planned for */
+static void STREAM_Deliver(STREAM_HandleTypeDef *hstream)
+{
+  uint32_t i;
+
+  if (hstream->Result != AUDIO_OK)
+  {
+    hstream->Errors++;
+    return;
+  }
+  for (i = 0U; i < hstream->NumTargets; i++)
+  {
+    const STREAM_TargetTypeDef *t = &hstream->Targets[i];
+    const int16_t *src = (const int16_t *)((const uint8_t *)hstream->Stage + t->Offset);
+    STREAM_SampleTypeDef *sample = t->pSample;
+
+    if (t->pVoice != NULL)
+    {
+      (void)VOICE_Fill(t->pVoice, t->Generation, t->Position, src, t->Count);
+    }
+    else if (t->Position == sample->Loaded)
+    {
+      memcpy(&sample->pHead[t->Position], src, t->Count * sizeof(int16_t));
+      sample->Loaded += t->Count;
+      if (sample->Loaded == sample->HeadLength)
+      {
+        /* Published in one store: voices now play the head in place */
+        sample->Source.HeadLength = sample->HeadLength;
+      }
+    }
+  }
+}
@@ -0,0 +1,346 @@
+/**
+  ******************************************************************************
+  * @file    audio_sync.c
+  * @brief   Multi-board sample timeline sync.
+  *
+  *          Chained boards each run their own crystal, so their frame counts
+  *          drift apart by tens of ppm. Every IntervalSec a board exchanges
+  *          four timestamps with its upstream board, in the manner of PTP:
+  *
+  *            master  t1 SYNC ------------> t2  slave
+  *                    FOLLOW_UP (t1) ---->
+  *                              <------- t3 DELAY_REQ
+  *                 t4 DELAY_RESP (t4) --->
+  *
+  *          Every timestamp is the capture timer value at the start of the
+  *          frame on the wire, taken by the timer hardware (input capture on
+  *          the RX / TX line, or the CAN frame timestamp), converted to the
+  *          sender's timeline. The slave derives its offset to the master
+  *          ((t2 - t1) - (t4 - t3)) / 2 and the path delay, keeps only the
+  *          exchanges close to the fastest recent one (queuing delays only
+  *          ever add), jumps its timeline once on a large offset, then holds
+  *          it with a PI servo on the audio clock trim. A board may be both
+  *          a slave upstream and a master downstream.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_sync.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SYNC_FRAMES(q)            ((float)(int64_t)(q) * (1.0f / 4294967296.0f))
+
+/* Slave servo states */
+#define SYNC_STATE_UNLOCKED       0U      /* Next accepted exchange jumps       */
+#define SYNC_STATE_STEPPED        1U      /* Next one measures the drift        */
+#define SYNC_STATE_LOCKED         2U
+
+/* Private function prototypes -----------------------------------------------*/
+static void SYNC_Update(SYNC_HandleTypeDef *hsync);
+static void SYNC_Reply(const SYNC_HandleTypeDef *hsync, SYNC_MsgTypeDef Type, uint8_t Seq,
+                       uint16_t To, uint64_t Time, SYNC_MessageTypeDef *pMsg);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes a board, unlocked, trim at 0 ppm.
+  * @param  hsync pointer to the sync handle
+  * @param  pConfig sync tuning, see SYNC_ConfigTypeDef for the defaults
+  * @retval AUDIO_OK or AUDIO_ERROR
+  */
+AUDIO_StatusTypeDef SYNC_Init(SYNC_HandleTypeDef *hsync, const SYNC_ConfigTypeDef *pConfig)
+{
+  if ((pConfig->TickRate == 0U) || (pConfig->IntervalSec <= 0.0f))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hsync, 0, sizeof(*hsync));
+  hsync->Config = *pConfig;
+  if (hsync->Config.Kp == 0.0f)
+  {
+    hsync->Config.Kp = 0.3f;
+  }
+  if (hsync->Config.Ki == 0.0f)
+  {
+    hsync->Config.Ki = 0.05f;
+  }
+  if (hsync->Config.MaxPpm == 0.0f)
+  {
+    hsync->Config.MaxPpm = 200.0f;
+  }
+  if (hsync->Config.StepFrames == 0.0f)
+  {
+    hsync->Config.StepFrames = 16.0f;
+  }
+  if (hsync->Config.DelayTolerance == 0.0f)
+  {
+    hsync->Config.DelayTolerance = 0.05f;
+  }
+  hsync->FramesPerTick = (((uint64_t)AUDIO_SAMPLE_RATE << 32) + (pConfig->TickRate / 2U))
+                         / pConfig->TickRate;
+  if (hsync->Config.SetTrim != NULL)
+  {
+    hsync->Config.SetTrim(hsync->Config.Context, 0.0f);
+  }
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Records where the audio stream is at a capture timer value.
+  * @note   Called from the audio interrupt, once per block, with the timer
+  *         read on entry.
+  * @param  hsync pointer to the sync handle
+  * @param  Tick capture timer value
+  * @param  Frames frames played (or captured) up to that instant
+  * @retval None
+  */
+void SYNC_AudioStamp(SYNC_HandleTypeDef *hsync, uint32_t Tick, uint32_t Frames)
+{
+  hsync->StampSeq++;
+  __asm volatile ("" ::: "memory");
+  hsync->StampTick = Tick;
+  hsync->StampFrames = Frames;
+  __asm volatile ("" ::: "memory");
+  hsync->StampSeq++;
+}
+
+/**
+  * @brief  Converts a capture timer value to the board timeline.
+  * @note   May be called at any priority below the audio interrupt. The
+  *         instant must lie within about 20 s of the last audio stamp.
+  * @param  hsync pointer to the sync handle
+  * @param  Tick capture timer value
+  * @retval Timeline position, Q32.32 frames
+  */
+uint64_t SYNC_Timeline(const SYNC_HandleTypeDef *hsync, uint32_t Tick)
+{
+  uint32_t seq;
+  uint32_t stampTick;
+  uint32_t frames;
+
+  /* The audio interrupt may rewrite the stamp meanwhile: read it again */
+  do
+  {
+    seq = hsync->StampSeq;
+    __asm volatile ("" ::: "memory");
+    stampTick = hsync->StampTick;
+    frames = hsync->StampFrames;
+    __asm volatile ("" ::: "memory");
+  } while (((seq & 1U) != 0U) || (seq != hsync->StampSeq));
+
+  /* A capture may precede the latest stamp: the tick difference is signed */
+  return ((uint64_t)frames << 32) + hsync->Step
+         + (uint64_t)((int64_t)(int32_t)(Tick - stampTick) * (int64_t)hsync->FramesPerTick);
+}
+
+/**
+  * @brief  Starts an exchange with the downstream boards (master side).
+  * @note   Call every IntervalSec and send the message. Report its transmit
+  *         capture to SYNC_Transmitted().
+  * @param  hsync pointer to the sync handle
+  * @param  Seq exchange number
+  * @param  pMsg receives the SYNC message
+  * @retval None
+  */
+void SYNC_Begin(SYNC_HandleTypeDef *hsync, uint8_t Seq, SYNC_MessageTypeDef *pMsg)
+{
+  SYNC_Reply(hsync, SYNC_MSG_SYNC, Seq, SYNC_BROADCAST, 0U, pMsg);
+}
+
+/**
+  * @brief  Handles the transmit capture of a message this board sent.
+  * @param  hsync pointer to the sync handle
+  * @param  pMsg message sent
+  * @param  Tick capture timer value at the start of the frame
+  * @param  pNext receives the message to send next, if any
+  * @retval 1 if pNext is to be sent, 0 otherwise
+  */
+uint8_t SYNC_Transmitted(SYNC_HandleTypeDef *hsync, const SYNC_MessageTypeDef *pMsg,
+                         uint32_t Tick, SYNC_MessageTypeDef *pNext)
+{
+  uint64_t time = SYNC_Timeline(hsync, Tick);
+
+  if (pMsg->Type == (uint8_t)SYNC_MSG_SYNC)
+  {
+    SYNC_Reply(hsync, SYNC_MSG_FOLLOW_UP, pMsg->Seq, SYNC_BROADCAST, time, pNext);
+    return 1U;
+  }
+  if ((pMsg->Type == (uint8_t)SYNC_MSG_DELAY_REQ) && (pMsg->Seq == hsync->Seq))
+  {
+    hsync->T[2] = time;
+    hsync->Have |= 4U;
+    /* The response may have overtaken this call */
+    if (hsync->Have == 0x0FU)
+    {
+      SYNC_Update(hsync);
+    }
+  }
+  return 0U;
+}
+
+/**
+  * @brief  Handles a received message.
+  * @param  hsync pointer to the sync handle
+  * @param  pMsg message received
+  * @param  Tick capture timer value at the start of the frame
+  * @param  pReply receives the answer, if any
+  * @retval 1 if pReply is to be sent, 0 otherwise
+  */
+uint8_t SYNC_Received(SYNC_HandleTypeDef *hsync, const SYNC_MessageTypeDef *pMsg,
+                      uint32_t Tick, SYNC_MessageTypeDef *pReply)
+{
+  const SYNC_ConfigTypeDef *cfg = &hsync->Config;
+  uint8_t fromMaster = (uint8_t)((pMsg->Node == cfg->Master) && (cfg->Master != cfg->Node));
+
+  switch (pMsg->Type)
+  {
+    case SYNC_MSG_SYNC:
+      if (fromMaster != 0U)
+      {
+        hsync->Seq = pMsg->Seq;
+        hsync->T[1] = SYNC_Timeline(hsync, Tick);
+        hsync->Have = 2U;
+      }
+      break;
+
+    case SYNC_MSG_FOLLOW_UP:
+      if ((fromMaster != 0U) && (pMsg->Seq == hsync->Seq) && (hsync->Have == 2U))
+      {
+        hsync->T[0] = pMsg->Time;
+        hsync->Have |= 1U;
+        SYNC_Reply(hsync, SYNC_MSG_DELAY_REQ, pMsg->Seq, cfg->Master, 0U, pReply);
+        return 1U;
+      }
+      break;
+
+    case SYNC_MSG_DELAY_REQ:
+      /* Master side: answer with the arrival time */
+      if (pMsg->To == cfg->Node)
+      {
+        SYNC_Reply(hsync, SYNC_MSG_DELAY_RESP, pMsg->Seq, pMsg->Node, SYNC_Timeline(hsync, Tick), pReply);
+        return 1U;
+      }
+      break;
+
+    case SYNC_MSG_DELAY_RESP:
+      if ((fromMaster != 0U) && (pMsg->To == cfg->Node) && (pMsg->Seq == hsync->Seq)
+          && ((hsync->Have & 0x03U) == 0x03U))
+      {
+        hsync->T[3] = pMsg->Time;
+        hsync->Have |= 8U;
+        if (hsync->Have == 0x0FU)
+        {
+          SYNC_Update(hsync);
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+  return 0U;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Runs the servo on a complete exchange.
+  * @param  hsync pointer to the sync handle
+  * @retval None
+  */
+static void SYNC_Update(SYNC_HandleTypeDef *hsync)
+{
+  const SYNC_ConfigTypeDef *cfg = &hsync->Config;
+  /* Sums in fixed point: a large offset must not cost delay precision */
+  int64_t ms = (int64_t)(hsync->T[1] - hsync->T[0]);
+  int64_t sm = (int64_t)(hsync->T[3] - hsync->T[2]);
+  int64_t offsetQ = (ms - sm) / 2;
+  float offset = SYNC_FRAMES(offsetQ);
+  float delay = SYNC_FRAMES((ms + sm) / 2);
+  float fastest = delay;
+  /* Trim that would cancel the offset over the time since the last update,
+     which spans more than one interval when exchanges were dropped */
+  float elapsed = SYNC_FRAMES(hsync->T[1] - hsync->LastUpdate);
+  float scale = 1.0e6f / AUDIO_MAX(elapsed, 1.0f);
+  float ppm;
+  uint32_t n;
+  uint32_t i;
+
+  hsync->Have = 0U;
+  if (delay < 0.0f)
+  {
+    /* Impossible path: the master timeline jumped during the exchange */
+    hsync->Rejected++;
+    return;
+  }
+  hsync->Delay = delay;
+
+  /* Min-delay filter: queuing and retries only ever lengthen the path */
+  n = AUDIO_MIN(hsync->Exchanges, SYNC_DELAY_WINDOW);
+  for (i = 0U; i < n; i++)
+  {
+    fastest = AUDIO_MIN(fastest, hsync->DelayHistory[i]);
+  }
+  hsync->DelayHistory[hsync->Exchanges % SYNC_DELAY_WINDOW] = delay;
+  hsync->Exchanges++;
+
+  if ((hsync->State != SYNC_STATE_UNLOCKED) && (delay > (fastest + cfg->DelayTolerance)))
+  {
+    hsync->Rejected++;
+    return;
+  }
+  if ((hsync->State == SYNC_STATE_UNLOCKED) || (fabsf(offset) > cfg->StepFrames))
+  {
+    /* Jump: the timeline is moved, the audio stream is not touched */
+    /* LastUpdate in the coordinates after the jump */
+    hsync->Offset = offset;
+    hsync->LastUpdate = hsync->T[1] - (uint64_t)offsetQ;
+    hsync->Step -= (uint64_t)offsetQ;
+    hsync->Steps++;
+    hsync->State = SYNC_STATE_STEPPED;
+    return;
+  }
+  hsync->Offset = offset;
+  hsync->LastUpdate = hsync->T[1];
+
+  if (hsync->State == SYNC_STATE_STEPPED)
+  {
+    /* Offset gathered since the jump: the rate error */
+    hsync->Drift = hsync->Ppm - (offset * scale);
+    hsync->State = SYNC_STATE_LOCKED;
+  }
+  else
+  {
+    hsync->Drift -= cfg->Ki * offset * scale;
+  }
+  hsync->Drift = AUDIO_CLAMP(hsync->Drift, -cfg->MaxPpm, cfg->MaxPpm);
+  ppm = hsync->Drift - (cfg->Kp * offset * scale);
+  hsync->Ppm = AUDIO_CLAMP(ppm, -cfg->MaxPpm, cfg->MaxPpm);
+  if (cfg->SetTrim != NULL)
+  {
+    cfg->SetTrim(cfg->Context, hsync->Ppm);
+  }
+}
+
+/**
+  * @brief  Fills a message from this board.
+  * @retval None
+  */
+static void SYNC_Reply(const SYNC_HandleTypeDef *hsync, SYNC_MsgTypeDef Type, uint8_t Seq,
+                       uint16_t To, uint64_t Time, SYNC_MessageTypeDef *pMsg)
+{
+  memset(pMsg, 0, sizeof(*pMsg));
+  pMsg->Type = (uint8_t)Type;
+  pMsg->Seq  = Seq;
+  pMsg->Node = hsync->Config.Node;
+  pMsg->To   = To;
+  pMsg->Time = Time;
+}
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * @file    audio_trace.c
+  * @brief   Lock-free event trace ring with cycle timestamps.
+  *
+  *          Recording costs a cycle counter read, an LDREX/STREX slot claim
+  *          and four stores, so it can sit in every interrupt handler. The
+  *          background drain sends committed records over any byte sink
+  *          (SWO through TRACE_ItmWrite(), a UART...); without a drain the
+  *          ring is a flight recorder to dump from RAM with the debugger.
+  *          AUDIO/Tools/trace2chrome.py turns either form into a Chrome /
+  *          Perfetto timeline.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_trace.h"
+#include "main.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define TRACE_MASK                (TRACE_RING_SIZE - 1U)
+
+/* Exported variables --------------------------------------------------------*/
+TRACE_RingTypeDef TraceRing;
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Clears the ring and starts the DWT cycle counter.
+  * @note   Call before the first hook can fire, ahead of HAL_Init() and
+  *         its SysTick.
+  * @param  CoreClock core clock in Hz, stored for the host converter
+  * @retval None
+  */
+void TRACE_Init(uint32_t CoreClock)
+{
+  memset(&TraceRing, 0, sizeof(TraceRing));
+  TraceRing.Size      = TRACE_RING_SIZE;
+  TraceRing.CoreClock = CoreClock;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0U;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* Last: a dump taken before this point is not mistaken for a trace */
+  TraceRing.Magic = TRACE_MAGIC;
+}
+
+/**
+  * @brief  Updates the core clock stored for the host converter.
+  * @note   For a clock change after TRACE_Init(); records taken before it
+  *         are scaled with the new clock too.
+  * @param  CoreClock core clock in Hz
+  * @retval None
+  */
+void TRACE_SetCoreClock(uint32_t CoreClock)
+{
+  TraceRing.CoreClock = CoreClock;
+}
+
+/**
+  * @brief  Records one event.
+  * @note   Callable from any context, interrupts included. Use the
+  *         TRACE_EVENT() family of macros so the call disappears from
+  *         builds without AUDIO_TRACE.
+  * @param  Event event identifier
+  * @param  Arg event argument, 16 bits kept
+  * @retval None
+  */
+void TRACE_Record(TRACE_EventTypeDef Event, uint32_t Arg)
+{
+  uint32_t cycles;
+  TRACE_RecordTypeDef *r;
+  uint32_t idx;
+
+  /* The timestamp is taken inside the claim: an interrupt between the two
+     clears the exclusive monitor, so the claim retries with a new one and
+     slot order stays time order */
+  do
+  {
+    idx = __LDREXW(&TraceRing.Head);
+    cycles = DWT->CYCCNT;
+  } while (__STREXW(idx + 1U, &TraceRing.Head) != 0U);
+
+  r = &TraceRing.Records[idx & TRACE_MASK];
+  r->Seq    = 0U;
+  r->Cycles = cycles;
+  r->Event  = (uint16_t)Event;
+  r->Arg    = (uint16_t)Arg;
+  __DMB();
+  r->Seq    = idx + 1U;
+}
+
+/**
+  * @brief  Sends committed records to a byte sink, oldest first.
+  * @note   Called from the background context, never from an interrupt.
+  *         Records are sent as they are stored (12 bytes, little endian);
+  *         the sequence numbers let the host spot gaps.
+  * @param  Write byte sink
+  * @param  Context passed to Write
+  * @param  MaxRecords most records sent by this call
+  * @retval Number of records sent
+  */
+uint32_t TRACE_Drain(TRACE_WriteTypeDef Write, void *Context, uint32_t MaxRecords)
+{
+  uint32_t sent = 0U;
+
+  while (sent < MaxRecords)
+  {
+    uint32_t head = TraceRing.Head;
+    uint32_t tail = TraceRing.Tail;
+    const TRACE_RecordTypeDef *r;
+    TRACE_RecordTypeDef copy;
+
+    if (head == tail)
+    {
+      break;
+    }
+    if (head - tail > TRACE_RING_SIZE)
+    {
+      /* The writers lapped the drain */
+      TraceRing.Lost += head - tail - TRACE_RING_SIZE;
+      tail = head - TRACE_RING_SIZE;
+    }
+
+    r = &TraceRing.Records[tail & TRACE_MASK];
+    copy.Seq    = r->Seq;
+    copy.Cycles = r->Cycles;
+    copy.Event  = r->Event;
+    copy.Arg    = r->Arg;
+    __DMB();
+    if (copy.Seq != tail + 1U)
+    {
+      if ((int32_t)(copy.Seq - (tail + 1U)) < 0)
+      {
+        /* Claimed but not committed yet: the writer is preempted */
+        break;
+      }
+      /* Overwritten while being read */
+      TraceRing.Lost++;
+    }
+    else if (r->Seq != copy.Seq)
+    {
+      TraceRing.Lost++;
+    }
+    else
+    {
+      Write(Context, (const uint8_t *)&copy, sizeof(copy));
+      sent++;
+    }
+    TraceRing.Tail = tail + 1U;
+  }
+  return sent;
+}
+
+/**
+  * @brief  Byte sink writing to the ITM stimulus port TRACE_ITM_PORT (SWO).
+  * @note   Does nothing while the debugger has not enabled the port.
+  * @param  Context unused
+  * @param  pData bytes to send
+  * @param  Size number of bytes
+  * @retval None
+  */
+void TRACE_ItmWrite(void *Context, const uint8_t *pData, uint32_t Size)
+{
+  uint32_t i;
+
+  (void)Context;
+  if (((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0U) || ((ITM->TER & (1UL << TRACE_ITM_PORT)) == 0U))
+  {
+    return;
+  }
+  for (i = 0U; i < Size; i++)
+  {
+    while (ITM->PORT[TRACE_ITM_PORT].u32 == 0U)
+    {
+    }
+    ITM->PORT[TRACE_ITM_PORT].u8 = pData[i];
+  }
+}
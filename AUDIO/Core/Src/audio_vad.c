@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file    audio_vad.c
+  * @brief   Block-rate voice activity detector.
+  *
+  *          Works on one level value per block, so the caller that already
+  *          measures the block energy (AGC, meters) gets a decision for free.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_vad.h"
+
+/* Private define ------------------------------------------------------------*/
+#define VAD_BLOCK_RATE            ((float)AUDIO_SAMPLE_RATE / (float)AUDIO_BLOCK_SIZE)
+/** Noise floor rise speed: slow enough that a sentence does not lift it */
+#define VAD_RISE_DB_PER_SEC       3.0f
+#define VAD_FLOOR_MIN_DB          (-96.0f)
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes the detector.
+  * @param  hvad pointer to the detector handle
+  * @param  MarginDb speech threshold above the noise floor (typically 9 dB)
+  * @param  HangoverMs time speech stays flagged after the level drops
+  * @retval None
+  */
+void VAD_Init(VAD_HandleTypeDef *hvad, float MarginDb, float HangoverMs)
+{
+  hvad->NoiseFloorDb   = -60.0f;
+  hvad->MarginDb       = MarginDb;
+  hvad->RiseDbPerBlock = VAD_RISE_DB_PER_SEC / VAD_BLOCK_RATE;
+  hvad->Hangover       = (uint16_t)(HangoverMs * VAD_BLOCK_RATE / 1000.0f);
+  hvad->HangCount      = 0U;
+  hvad->Active         = 0U;
+  hvad->Speech         = 0U;
+}
+
+/**
+  * @brief  Updates the detector with the level of one block.
+  * @param  hvad pointer to the detector handle
+  * @param  LevelDb block RMS level in dBFS
+  * @retval 1 if the block is speech, 0 otherwise
+  */
+uint8_t VAD_Update(VAD_HandleTypeDef *hvad, float LevelDb)
+{
+  LevelDb = AUDIO_MAX(LevelDb, VAD_FLOOR_MIN_DB);
+
+  if (LevelDb < hvad->NoiseFloorDb)
+  {
+    hvad->NoiseFloorDb = LevelDb;
+  }
+  else
+  {
+    hvad->NoiseFloorDb += hvad->RiseDbPerBlock;
+  }
+
+  hvad->Active = (LevelDb > hvad->NoiseFloorDb + hvad->MarginDb) ? 1U : 0U;
+  if (hvad->Active != 0U)
+  {
+    hvad->HangCount = hvad->Hangover;
+    hvad->Speech = 1U;
+  }
+  else if (hvad->HangCount > 0U)
+  {
+    hvad->HangCount--;
+  }
+  else
+  {
+    hvad->Speech = 0U;
+  }
+  return hvad->Speech;
+}
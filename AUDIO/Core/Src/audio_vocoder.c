@@ -0,0 +1,207 @@
+/**
+  ******************************************************************************
+  * @file    audio_vocoder.c
+  * @brief   Channel vocoder: the modulator (mic) band envelopes shape the
+  *          matching bands of the carrier (synth).
+  *
+  *          Per band, the modulator and carrier sections run together through
+  *          BIQUAD_ProcessPair() on shared coefficients. The envelope followers
+  *          run once per block (750 Hz at 64 frames): the audio-rate work is
+  *          only a rectify-and-sum, and the gain reaching the carrier is
+  *          linearly interpolated across the block.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_vocoder.h"
+#include <math.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define VOCODER_PI                3.14159265f
+#define VOCODER_LN2               0.69314718f
+#define VOCODER_CONTROL_RATE      ((float)AUDIO_SAMPLE_RATE / (float)AUDIO_BLOCK_SIZE)
+/** Mean |x| of a full-scale sine is 2/pi; normalize envelopes to peak level */
+#define VOCODER_RECTIFY_GAIN      (VOCODER_PI / 2.0f)
+
+/* Private function prototypes -----------------------------------------------*/
+static void VOCODER_ProcessBlock(VOCODER_HandleTypeDef *hvoc, const float *pCarrier,
+                                 const float *pModulator, float *pOut, uint32_t Frames);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Designs the band-pass bank and clears the vocoder state.
+  * @param  hvoc pointer to the vocoder handle
+  * @param  NumBands VOCODER_MIN_BANDS .. VOCODER_MAX_BANDS, see VOCODER_BandsForBudget()
+  * @param  LowHz center of the lowest band
+  * @param  HighHz center of the highest band, below Nyquist
+  * @retval AUDIO_OK or AUDIO_ERROR on invalid parameters
+  */
+AUDIO_StatusTypeDef VOCODER_Init(VOCODER_HandleTypeDef *hvoc, uint32_t NumBands,
+                                 float LowHz, float HighHz)
+{
+  float octaves;
+  uint32_t b;
+  uint32_t s;
+
+  if ((NumBands < VOCODER_MIN_BANDS) || (NumBands > VOCODER_MAX_BANDS) ||
+      (LowHz <= 0.0f) || (HighHz <= LowHz) || (HighHz >= 0.5f * (float)AUDIO_SAMPLE_RATE))
+  {
+    return AUDIO_ERROR;
+  }
+
+  memset(hvoc, 0, sizeof(*hvoc));
+  hvoc->NumBands = NumBands;
+
+  /* Log-spaced centers, each band one spacing wide so neighbours cross at
+     -3 dB. The width is set in the digital domain (w0 / sin(w0) undoes the
+     bilinear squeeze), or the upper bands come out narrow. */
+  octaves = log2f(HighHz / LowHz) / (float)(NumBands - 1U);
+  for (b = 0U; b < NumBands; b++)
+  {
+    float fc = LowHz * exp2f(octaves * (float)b);
+    float w0 = 2.0f * VOCODER_PI * fc / (float)AUDIO_SAMPLE_RATE;
+    float alpha = sinf(w0) * sinhf(0.5f * VOCODER_LN2 * octaves * w0 / sinf(w0));
+    float a0 = 1.0f + alpha;
+
+    for (s = 0U; s < VOCODER_STAGES; s++)
+    {
+      hvoc->Coeffs[b][s].b0 = alpha / a0;
+      hvoc->Coeffs[b][s].b1 = 0.0f;
+      hvoc->Coeffs[b][s].b2 = -alpha / a0;
+      hvoc->Coeffs[b][s].a1 = -2.0f * cosf(w0) / a0;
+      hvoc->Coeffs[b][s].a2 = (1.0f - alpha) / a0;
+    }
+  }
+
+  /* Bands overlap: scale the sum so a flat spectrum stays near unity */
+  hvoc->Gain = sqrtf(8.0f / (float)NumBands);
+  VOCODER_SetTimes(hvoc, 5.0f, 50.0f);
+  return AUDIO_OK;
+}
+
+/**
+  * @brief  Sets the envelope follower times.
+  * @param  hvoc pointer to the vocoder handle
+  * @param  AttackMs attack time constant in ms
+  * @param  ReleaseMs release time constant in ms
+  * @retval None
+  */
+void VOCODER_SetTimes(VOCODER_HandleTypeDef *hvoc, float AttackMs, float ReleaseMs)
+{
+  hvoc->Attack  = 1.0f - expf(-1000.0f / (AUDIO_MAX(AttackMs, 0.1f) * VOCODER_CONTROL_RATE));
+  hvoc->Release = 1.0f - expf(-1000.0f / (AUDIO_MAX(ReleaseMs, 0.1f) * VOCODER_CONTROL_RATE));
+}
+
+/**
+  * @brief  Returns the largest band count fitting a CPU budget.
+  * @param  CyclesPerFrame cycles available to the vocoder per frame
+  *         (e.g. 400 for 20% of a 100 MHz core at 48 kHz)
+  * @retval Band count, 0 if not even VOCODER_MIN_BANDS fit
+  */
+uint32_t VOCODER_BandsForBudget(uint32_t CyclesPerFrame)
+{
+  uint32_t bands = CyclesPerFrame / VOCODER_CYCLES_PER_BAND;
+
+  if (bands < VOCODER_MIN_BANDS)
+  {
+    return 0U;
+  }
+  return AUDIO_MIN(bands, VOCODER_MAX_BANDS);
+}
+
+/**
+  * @brief  Processes a block.
+  * @param  hvoc pointer to the vocoder handle
+  * @param  pCarrier carrier input (synth)
+  * @param  pModulator modulator input (mic)
+  * @param  pOut output, may alias pCarrier
+  * @param  Frames number of frames
+  * @retval None
+  */
+void VOCODER_Process(VOCODER_HandleTypeDef *hvoc, const float *pCarrier,
+                     const float *pModulator, float *pOut, uint32_t Frames)
+{
+  while (Frames > 0U)
+  {
+    uint32_t n = AUDIO_MIN(Frames, AUDIO_BLOCK_SIZE);
+
+    VOCODER_ProcessBlock(hvoc, pCarrier, pModulator, pOut, n);
+    pCarrier   += n;
+    pModulator += n;
+    pOut       += n;
+    Frames     -= n;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Processes at most AUDIO_BLOCK_SIZE frames, one control tick.
+  * @param  hvoc pointer to the vocoder handle
+  * @param  pCarrier carrier input
+  * @param  pModulator modulator input
+  * @param  pOut output
+  * @param  Frames number of frames
+  * @retval None
+  */
+static void VOCODER_ProcessBlock(VOCODER_HandleTypeDef *hvoc, const float *pCarrier,
+                                 const float *pModulator, float *pOut, uint32_t Frames)
+{
+  float mix[AUDIO_BLOCK_SIZE];
+  float inv = 1.0f / (float)Frames;
+  uint32_t b;
+  uint32_t s;
+  uint32_t i;
+
+  memset(mix, 0, Frames * sizeof(float));
+
+  for (b = 0U; b < hvoc->NumBands; b++)
+  {
+    const float *mod = pModulator;
+    const float *car = pCarrier;
+    float sum = 0.0f;
+    float level;
+    float env;
+    float gain;
+    float step;
+
+    for (s = 0U; s < VOCODER_STAGES; s++)
+    {
+      BIQUAD_ProcessPair(&hvoc->Coeffs[b][s], &hvoc->ModState[b][s], mod, hvoc->ModBuf,
+                         &hvoc->Coeffs[b][s], &hvoc->CarState[b][s], car, hvoc->CarBuf, Frames);
+      mod = hvoc->ModBuf;
+      car = hvoc->CarBuf;
+    }
+
+    for (i = 0U; i < Frames; i++)
+    {
+      sum += fabsf(hvoc->ModBuf[i]);
+    }
+
+    /* Control-rate envelope follower */
+    level = sum * inv * VOCODER_RECTIFY_GAIN;
+    env = hvoc->Envelope[b];
+    env += ((level > env) ? hvoc->Attack : hvoc->Release) * (level - env);
+
+    gain = hvoc->Envelope[b];
+    step = (env - gain) * inv;
+    hvoc->Envelope[b] = env;
+    for (i = 0U; i < Frames; i++)
+    {
+      gain += step;
+      mix[i] += hvoc->CarBuf[i] * gain;
+    }
+  }
+
+  for (i = 0U; i < Frames; i++)
+  {
+    pOut[i] = mix[i] * hvoc->Gain;
+  }
+}
@@ -0,0 +1,308 @@
+/**
+  ******************************************************************************
+  * @file    audio_voice.c
+  * @brief   Sample playback voice with a background-filled prefetch ring.
+  *
+  *          VOICE_Render() runs in the audio context and never touches slow
+  *          media: streamed samples are only consumed from the prefetch ring,
+  *          which VOICE_Service() tops up from the background context, or
+  *          which a scheduler serving many voices fills with VOICE_Fill().
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_voice.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define VOICE_RING_MASK           (VOICE_PREFETCH_LEN - 1U)
+#define VOICE_SAMPLE_SCALE        (1.0f / 32768.0f)
+
+/* Private function prototypes -----------------------------------------------*/
+static inline int16_t VOICE_Fetch(const VOICE_HandleTypeDef *hvoice, uint32_t Index);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initializes a voice in the idle state.
+  * @param  hvoice pointer to the voice handle
+  * @retval None
+  */
+void VOICE_Init(VOICE_HandleTypeDef *hvoice)
+{
+  memset(hvoice, 0, sizeof(*hvoice));
+}
+
+/**
+  * @brief  Starts playback of a source, cutting any sound already playing.
+  * @note   Called from the audio context. For streamed sources the ring is
+  *         empty until the next VOICE_Service() call, so time-critical sounds
+  *         should use memory-mapped sources, or a head in memory long enough
+  *         to cover the first refill.
+  * @param  hvoice pointer to the voice handle
+  * @param  pSource sample source to play
+  * @param  pParams playback parameters for this trigger
+  * @retval None
+  */
+void VOICE_Trigger(VOICE_HandleTypeDef *hvoice, const VOICE_SourceTypeDef *pSource,
+                   const VOICE_ParamsTypeDef *pParams)
+{
+  float pan = AUDIO_CLAMP(pParams->Pan, -1.0f, 1.0f);
+  uint32_t start = AUDIO_MIN(pParams->Start, pSource->Length);
+
+  hvoice->Generation++;
+  hvoice->Source    = pSource;
+  hvoice->Phase     = (uint64_t)start << 32;
+  hvoice->Increment = (uint64_t)(pParams->Rate * 4294967296.0f);
+  hvoice->Fetched   = start;
+  hvoice->Consumed  = start;
+  if ((pSource->Data == NULL) && (start < pSource->HeadLength))
+  {
+    /* The head plays in place: the ring starts where it ends */
+    hvoice->Fetched = AUDIO_MIN(pSource->HeadLength, pSource->Length);
+  }
+  /* Linear pan law: cheap, and the level lock compensates where it matters */
+  hvoice->GainL     = pParams->Level * (1.0f - pan) * 0.5f;
+  hvoice->GainR     = pParams->Level * (1.0f + pan) * 0.5f;
+  hvoice->Decay     = pParams->Decay;
+}
+
+/**
+  * @brief  Stops a voice immediately.
+  * @param  hvoice pointer to the voice handle
+  * @retval None
+  */
+void VOICE_Stop(VOICE_HandleTypeDef *hvoice)
+{
+  hvoice->Generation++;
+  hvoice->Source = NULL;
+}
+
+/**
+  * @brief  Mixes a voice into a stereo buffer.
+  * @param  hvoice pointer to the voice handle
+  * @param  pLeft left accumulation buffer
+  * @param  pRight right accumulation buffer
+  * @param  Frames number of frames to render
+  * @retval None
+  */
+void VOICE_Render(VOICE_HandleTypeDef *hvoice, float *pLeft, float *pRight, uint32_t Frames)
+{
+  const VOICE_SourceTypeDef *src = hvoice->Source;
+  uint64_t phase = hvoice->Phase;
+  float gainL = hvoice->GainL;
+  float gainR = hvoice->GainR;
+  uint32_t available;
+  uint32_t i;
+
+  if (src == NULL)
+  {
+    return;
+  }
+
+  /* Mapped sources are fully "fetched"; streamed ones stop at the ring level */
+  available = (src->Data != NULL) ? src->Length : hvoice->Fetched;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    uint32_t idx = (uint32_t)(phase >> 32);
+    float frac = (float)(uint32_t)phase * (1.0f / 4294967296.0f);
+    float s0;
+    float s1;
+    float s;
+
+    if (idx >= src->Length)
+    {
+      src = NULL;
+      break;
+    }
+    if ((idx + 1U < src->Length) && (idx + 1U >= available))
+    {
+      /* Ring ran dry: hold position so the sample resumes seamlessly */
+      hvoice->Underruns += Frames - i;
+      break;
+    }
+
+    s0 = (float)VOICE_Fetch(hvoice, idx);
+    s1 = (idx + 1U < src->Length) ? (float)VOICE_Fetch(hvoice, idx + 1U) : 0.0f;
+    s  = (s0 + (s1 - s0) * frac) * VOICE_SAMPLE_SCALE;
+
+    pLeft[i]  += s * gainL;
+    pRight[i] += s * gainR;
+    gainL *= hvoice->Decay;
+    gainR *= hvoice->Decay;
+    phase += hvoice->Increment;
+  }
+
+  hvoice->Phase    = phase;
+  hvoice->GainL    = gainL;
+  hvoice->GainR    = gainR;
+  hvoice->Consumed = (uint32_t)(phase >> 32);
+  if (src == NULL)
+  {
+    hvoice->Source = NULL;
+  }
+}
+
+/**
+  * @brief  Refills the prefetch ring of a streamed voice.
+  * @note   Called from the background context only. At most one chunk is
+  *         read per call so that several voices share the medium fairly.
+  * @param  hvoice pointer to the voice handle
+  * @retval Number of samples fetched
+  */
+uint32_t VOICE_Service(VOICE_HandleTypeDef *hvoice)
+{
+  const VOICE_SourceTypeDef *src = hvoice->Source;
+  uint32_t generation;
+  uint32_t fetched;
+  uint32_t count;
+  uint32_t offset;
+  uint32_t irq;
+
+  if ((src == NULL) || (src->Data != NULL))
+  {
+    return 0U;
+  }
+
+  count = AUDIO_MIN(VOICE_Need(hvoice, &fetched, &generation), VOICE_PREFETCH_CHUNK);
+  if ((count < VOICE_PREFETCH_CHUNK) && (fetched + count < src->Length))
+  {
+    return 0U;
+  }
+
+  /* Do not wrap inside one read: split at the end of the ring */
+  offset = fetched & VOICE_RING_MASK;
+  count  = AUDIO_MIN(count, VOICE_PREFETCH_LEN - offset);
+  count  = src->Read(src->Context, fetched, &hvoice->Ring[offset], count);
+
+  /* A trigger from the audio context during the read invalidates the data;
+     one landing between the check and the store would get the old level */
+  irq = AUDIO_EnterCritical();
+  if (generation == hvoice->Generation)
+  {
+    hvoice->Fetched = fetched + count;
+  }
+  AUDIO_ExitCritical(irq);
+  return count;
+}
+
+/**
+  * @brief  Tells how much a streamed voice can take into its prefetch ring.
+  * @note   For a scheduler refilling many voices from the background context
+  *         instead of VOICE_Service(): it reads the samples wherever it likes
+  *         and hands them over with VOICE_Fill().
+  * @param  hvoice pointer to the voice handle
+  * @param  pPosition receives the absolute index of the first sample wanted
+  * @param  pGeneration receives the trigger generation, for VOICE_Fill()
+  * @retval Number of samples wanted, 0 for an idle or memory-mapped voice
+  */
+uint32_t VOICE_Need(const VOICE_HandleTypeDef *hvoice, uint32_t *pPosition, uint32_t *pGeneration)
+{
+  uint32_t generation = hvoice->Generation;
+  const VOICE_SourceTypeDef *src = hvoice->Source;
+  uint32_t fetched;
+  uint32_t oldest;
+
+  *pGeneration = generation;
+  *pPosition = 0U;
+  if ((src == NULL) || (src->Data != NULL))
+  {
+    return 0U;
+  }
+
+  /* Samples still in the head do not occupy the ring */
+  fetched = hvoice->Fetched;
+  oldest = AUDIO_MAX(hvoice->Consumed, AUDIO_MIN(src->HeadLength, fetched));
+  *pPosition = fetched;
+  return AUDIO_MIN(VOICE_PREFETCH_LEN - (fetched - oldest), src->Length - fetched);
+}
+
+/**
+  * @brief  Stores samples read for a streamed voice into its prefetch ring.
+  * @note   Called from the background context. Samples before the ring's
+  *         next position are skipped, so a read covering several voices can
+  *         be handed to each from its start; data read for an earlier trigger
+  *         is dropped.
+  * @param  hvoice pointer to the voice handle
+  * @param  Generation trigger generation returned by VOICE_Need()
+  * @param  Position absolute index of pSrc[0]
+  * @param  pSrc samples read
+  * @param  Count number of samples in pSrc
+  * @retval Number of samples stored
+  */
+uint32_t VOICE_Fill(VOICE_HandleTypeDef *hvoice, uint32_t Generation, uint32_t Position,
+                    const int16_t *pSrc, uint32_t Count)
+{
+  uint32_t generation;
+  uint32_t fetched;
+  uint32_t count;
+  uint32_t offset;
+  uint32_t first;
+  uint32_t irq;
+
+  count = VOICE_Need(hvoice, &fetched, &generation);
+  if ((generation != Generation) || (count == 0U) || (Position > fetched) || ((Position + Count) <= fetched))
+  {
+    return 0U;
+  }
+  pSrc += fetched - Position;
+  count = AUDIO_MIN(count, Count - (fetched - Position));
+
+  offset = fetched & VOICE_RING_MASK;
+  first = AUDIO_MIN(count, VOICE_PREFETCH_LEN - offset);
+  memcpy(&hvoice->Ring[offset], pSrc, first * sizeof(int16_t));
+  memcpy(hvoice->Ring, &pSrc[first], (count - first) * sizeof(int16_t));
+
+  /* A trigger from the audio context during the copy invalidates the data;
+     one landing between the check and the store would get the old level */
+  irq = AUDIO_EnterCritical();
+  if (Generation != hvoice->Generation)
+  {
+    count = 0U;
+  }
+  else
+  {
+    hvoice->Fetched = fetched + count;
+  }
+  AUDIO_ExitCritical(irq);
+  return count;
+}
+
+/**
+  * @brief  Tells whether a voice is still sounding.
+  * @param  hvoice pointer to the voice handle
+  * @retval 1 if playing, 0 if idle
+  */
+uint8_t VOICE_IsActive(const VOICE_HandleTypeDef *hvoice)
+{
+  return (hvoice->Source != NULL) ? 1U : 0U;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Returns one sample either in place or from the prefetch ring.
+  * @param  hvoice pointer to the voice handle
+  * @param  Index absolute sample index
+  * @retval Sample value
+  */
+static inline int16_t VOICE_Fetch(const VOICE_HandleTypeDef *hvoice, uint32_t Index)
+{
+  const VOICE_SourceTypeDef *src = hvoice->Source;
+
+  if (src->Data != NULL)
+  {
+    return src->Data[Index];
+  }
+  if (Index < src->HeadLength)
+  {
+    return src->Head[Index];
+  }
+  return hvoice->Ring[Index & VOICE_RING_MASK];
+}
@@ -22,7 +22,9 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "audio_async.h"
+#include "audio_irq.h"
+#include "audio_trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -43,6 +45,12 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
+/* Background I/O sequences (SD mount, codec bring-up, flash writes) */
+static ASYNC_HandleTypeDef AsyncLoop;
+
+#if (AUDIO_IRQ_BENCH != 0)
+static IRQ_ReportTypeDef IrqReport;
+#endif
 
 /* USER CODE END PV */
 
@@ -65,7 +73,10 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+#if (AUDIO_TRACE != 0)
+  /* Before HAL_Init() starts SysTick, whose handler records */
+  TRACE_Init(SystemCoreClock);
+#endif
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -74,6 +85,8 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
+  IRQ_ConfigureFpu();
+  IRQ_ConfigurePriorities();
 
   /* USER CODE END Init */
 
@@ -81,13 +94,20 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+#if (AUDIO_TRACE != 0)
+  TRACE_SetCoreClock(SystemCoreClock);
+#endif
 
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   /* USER CODE BEGIN 2 */
-
+#if (AUDIO_IRQ_BENCH != 0)
+  IRQ_Benchmark(&IrqReport);
+  IRQ_WriteReport(&IrqReport, TRACE_ItmWrite, NULL);
+#endif
+  ASYNC_Init(&AsyncLoop);
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -97,6 +117,10 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    (void)ASYNC_Run(&AsyncLoop, HAL_GetTick());
+#if (AUDIO_TRACE != 0)
+    (void)TRACE_Drain(TRACE_ItmWrite, NULL, 32U);
+#endif
   }
   /* USER CODE END 3 */
 }
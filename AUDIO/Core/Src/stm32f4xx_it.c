@@ -22,6 +22,9 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "audio_knob.h"
+#include "audio_lcd.h"
+#include "audio_trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -144,10 +147,10 @@ void UsageFault_Handler(void)
 void SVC_Handler(void)
 {
   /* USER CODE BEGIN SVCall_IRQn 0 */
-
+  TRACE_ISR_ENTER(SVCall_IRQn);
   /* USER CODE END SVCall_IRQn 0 */
   /* USER CODE BEGIN SVCall_IRQn 1 */
-
+  TRACE_ISR_EXIT(SVCall_IRQn);
   /* USER CODE END SVCall_IRQn 1 */
 }
 
@@ -170,10 +173,10 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
-
+  TRACE_ISR_ENTER(PendSV_IRQn);
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
-
+  TRACE_ISR_EXIT(PendSV_IRQn);
   /* USER CODE END PendSV_IRQn 1 */
 }
 
@@ -183,11 +186,11 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  TRACE_ISR_ENTER(SysTick_IRQn);
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  TRACE_ISR_EXIT(SysTick_IRQn);
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -199,5 +202,24 @@ void SysTick_Handler(void)
 /******************************************************************************/
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (ADC1 knob scan).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  TRACE_ISR_ENTER(DMA2_Stream0_IRQn);
+  KNOB_DmaIRQHandler();
+  TRACE_ISR_EXIT(DMA2_Stream0_IRQn);
+}
+
+/**
+  * @brief This function handles DMA2 stream3 global interrupt (SPI1 display).
+  */
+void DMA2_Stream3_IRQHandler(void)
+{
+  TRACE_ISR_ENTER(DMA2_Stream3_IRQn);
+  LCD_DmaIRQHandler();
+  TRACE_ISR_EXIT(DMA2_Stream3_IRQn);
+}
 
 /* USER CODE END 1 */
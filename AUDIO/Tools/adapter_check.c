@@ -0,0 +1,315 @@
+/**
+  ******************************************************************************
+  * @file    adapter_check.c
+  * @brief   Host check of the audio_adapter.c block-size adapter.
+  *
+  *          For every pair of block sizes from the list, in both modes and
+  *          at every producer to consumer phase, runs a producer and a
+  *          consumer on a common sample clock for a few buffer periods. The
+  *          producer writes numbered stereo frames; when both are due at
+  *          the same time the consumer goes first, its worst case. Checked:
+  *            - every span lies inside the buffer;
+  *            - no overrun ever, and in clocked mode no underrun;
+  *            - the consumer gets the prefill silence (clocked) and then
+  *              every frame, in order, channels intact;
+  *            - the delay a frame sees never exceeds ADAPTER_GetLatency(),
+  *              and reaches it at some phase. Polled, the delay runs from
+  *              the producer block that delivers the frame to the one that
+  *              completes its consumer block. Clocked, it runs from the
+  *              frame's capture to its playout, less the producer block; as
+  *              phases are whole frames the worst seen is one frame short
+  *              of the bound, the limit of a consumer clocked just before a
+  *              delivery.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o adapter_check adapter_check.c \
+  *                ../Core/Src/audio_adapter.c
+  *
+  *          Usage:
+  *            adapter_check [-p periods] [size ...]
+  *
+  *          Defaults: 4 buffer periods, sizes 32 44 48 64 128 256 512. The
+  *          exit status is 1 at the first pair that fails.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_adapter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_MAX_SIZES           16U
+#define CHECK_MAX_FRAMES          65536U
+#define CHECK_CHANNELS            2U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  ADAPTER_HandleTypeDef Ad;
+  ADAPTER_ModeTypeDef Mode;
+  uint32_t In;
+  uint32_t Out;
+  uint32_t Size;
+  uint32_t Phase;
+  uint32_t Prefill;
+  uint64_t Produced;          /* Frames written                  */
+  uint64_t Taken;             /* Frames read, prefill included   */
+  int64_t  Worst;             /* Largest delay seen              */
+} CHECK_RunTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static float Buffer[CHECK_MAX_FRAMES * CHECK_CHANNELS];
+static uint64_t Delivered[CHECK_MAX_FRAMES];  /* Producer time of each frame, by frame mod size */
+
+/* Private functions ---------------------------------------------------------*/
+static const char *CHECK_Name(const CHECK_RunTypeDef *pRun)
+{
+  return (pRun->Mode == ADAPTER_MODE_CLOCKED) ? "clocked" : "polled";
+}
+
+/* Takes one block if complete; 1 if taken, 0 if not, -1 on a failure */
+static int CHECK_Consume(CHECK_RunTypeDef *pRun, uint64_t Now)
+{
+  const float *r = ADAPTER_GetReadSpan(&pRun->Ad);
+  uint32_t i;
+
+  if (r == NULL)
+  {
+    if (pRun->Mode == ADAPTER_MODE_CLOCKED)
+    {
+      printf("%u -> %u clocked, phase %u: underrun at %llu\n", pRun->In, pRun->Out, pRun->Phase,
+             (unsigned long long)Now);
+      return -1;
+    }
+    return 0;
+  }
+  if ((r < Buffer) || (r + pRun->Out * CHECK_CHANNELS > Buffer + pRun->Size * CHECK_CHANNELS))
+  {
+    printf("%u -> %u %s: read span outside the buffer\n", pRun->In, pRun->Out, CHECK_Name(pRun));
+    return -1;
+  }
+  for (i = 0U; i < pRun->Out; i++)
+  {
+    uint64_t f = pRun->Taken + i;
+
+    /* Frame n is written as n + 1 so the prefill silence stands out */
+    float want = (f < pRun->Prefill) ? 0.0f : (float)(f - pRun->Prefill + 1U);
+
+    if ((r[i * CHECK_CHANNELS] != want) || (r[i * CHECK_CHANNELS + 1U] != -want))
+    {
+      printf("%u -> %u %s, phase %u: frame %llu is %g/%g, expected %g\n", pRun->In, pRun->Out,
+             CHECK_Name(pRun), pRun->Phase, (unsigned long long)f, r[i * CHECK_CHANNELS],
+             r[i * CHECK_CHANNELS + 1U], want);
+      return -1;
+    }
+    if (f >= pRun->Prefill)
+    {
+      uint64_t k = f - pRun->Prefill;
+      int64_t delay = (int64_t)(Now - Delivered[k % CHECK_MAX_FRAMES]);
+
+      /* Clocked, the frame plays at Now + i and was captured at its offset
+         in the producer block, one block before the delivery */
+      if (pRun->Mode == ADAPTER_MODE_CLOCKED)
+      {
+        delay += (int64_t)i - (int64_t)(k % pRun->In);
+      }
+
+      pRun->Worst = AUDIO_MAX(pRun->Worst, delay);
+    }
+  }
+  ADAPTER_CommitRead(&pRun->Ad);
+  pRun->Taken += pRun->Out;
+  return 1;
+}
+
+/* Writes one block; 0, or -1 on a failure */
+static int CHECK_Produce(CHECK_RunTypeDef *pRun, uint64_t Now)
+{
+  float *w = ADAPTER_GetWriteSpan(&pRun->Ad);
+  uint32_t i;
+
+  if (w == NULL)
+  {
+    printf("%u -> %u %s, phase %u: overrun at %llu\n", pRun->In, pRun->Out, CHECK_Name(pRun),
+           pRun->Phase, (unsigned long long)Now);
+    return -1;
+  }
+  if ((w < Buffer) || (w + pRun->In * CHECK_CHANNELS > Buffer + pRun->Size * CHECK_CHANNELS))
+  {
+    printf("%u -> %u %s: write span outside the buffer\n", pRun->In, pRun->Out, CHECK_Name(pRun));
+    return -1;
+  }
+  for (i = 0U; i < pRun->In; i++)
+  {
+    uint64_t f = pRun->Produced + i;
+
+    w[i * CHECK_CHANNELS]      = (float)(f + 1U);
+    w[i * CHECK_CHANNELS + 1U] = -(float)(f + 1U);
+    Delivered[f % CHECK_MAX_FRAMES] = Now;
+  }
+  ADAPTER_CommitWrite(&pRun->Ad);
+  pRun->Produced += pRun->In;
+  return 0;
+}
+
+/* One run at one phase; the worst delay seen, or -1 on a failure */
+static int64_t CHECK_Run(ADAPTER_ModeTypeDef Mode, uint32_t In, uint32_t Out, uint32_t Phase,
+                         uint32_t Periods)
+{
+  CHECK_RunTypeDef run = { 0 };
+  uint64_t nextIn = In;       /* The producer delivers at In, 2 In, ...      */
+  uint64_t nextOut = Phase;   /* A clocked consumer runs at Phase + k Out    */
+  uint64_t end;
+  int taken;
+
+  run.Mode    = Mode;
+  run.In      = In;
+  run.Out     = Out;
+  run.Phase   = Phase;
+  run.Size    = ADAPTER_GetBufferSize(Mode, In, Out);
+  run.Prefill = (Mode == ADAPTER_MODE_CLOCKED) ? In + Out : 0U;
+  end = (uint64_t)Periods * run.Size + In + Out;
+  if (ADAPTER_Init(&run.Ad, Buffer, run.Size, CHECK_CHANNELS, In, Out, Mode) != AUDIO_OK)
+  {
+    printf("%u -> %u %s: init failed for size %u\n", In, Out, CHECK_Name(&run), run.Size);
+    return -1;
+  }
+
+  while (nextIn < end)
+  {
+    /* Clocked, the consumer goes first on a tie */
+    while ((Mode == ADAPTER_MODE_CLOCKED) && (nextOut <= nextIn))
+    {
+      if (CHECK_Consume(&run, nextOut) < 0)
+      {
+        return -1;
+      }
+      nextOut += Out;
+    }
+    if (CHECK_Produce(&run, nextIn) < 0)
+    {
+      return -1;
+    }
+
+    /* Polled, the consumer takes what completed, in the producer's context */
+    while (Mode == ADAPTER_MODE_POLL)
+    {
+      taken = CHECK_Consume(&run, nextIn);
+      if (taken < 0)
+      {
+        return -1;
+      }
+      if (taken == 0)
+      {
+        break;
+      }
+    }
+    nextIn += In;
+  }
+  return run.Worst;
+}
+
+/* All phases of one pair; the worst delay, or -1 on a failure */
+static int64_t CHECK_Pair(ADAPTER_ModeTypeDef Mode, uint32_t In, uint32_t Out, uint32_t Periods)
+{
+  ADAPTER_HandleTypeDef ad;
+  uint32_t size = ADAPTER_GetBufferSize(Mode, In, Out);
+  uint32_t phases = (Mode == ADAPTER_MODE_CLOCKED) ? In : 1U;
+  int64_t worst = 0;
+  uint32_t p;
+
+  if (size > CHECK_MAX_FRAMES)
+  {
+    printf("%u -> %u: buffer of %u frames too large for the check\n", In, Out, size);
+    return -1;
+  }
+  (void)ADAPTER_Init(&ad, Buffer, size, CHECK_CHANNELS, In, Out, Mode);
+
+  /* Clocked phases repeat every producer block */
+  for (p = 0U; p < phases; p++)
+  {
+    int64_t w = CHECK_Run(Mode, In, Out, p, Periods);
+
+    if (w < 0)
+    {
+      return -1;
+    }
+    worst = AUDIO_MAX(worst, w);
+  }
+  /* Clocked, whole-frame phases stop one frame short of the bound */
+  if (worst + ((Mode == ADAPTER_MODE_CLOCKED) ? 1 : 0) != (int64_t)ADAPTER_GetLatency(&ad))
+  {
+    printf("%u -> %u %s: worst delay %lld, reported %u\n", In, Out,
+           (Mode == ADAPTER_MODE_CLOCKED) ? "clocked" : "polled", (long long)worst,
+           ADAPTER_GetLatency(&ad));
+    return -1;
+  }
+  return worst;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  uint32_t sizes[CHECK_MAX_SIZES] = { 32U, 44U, 48U, 64U, 128U, 256U, 512U };
+  uint32_t count = 7U;
+  uint32_t periods = 4U;
+  uint32_t pairs = 0U;
+  uint32_t a;
+  uint32_t b;
+  uint32_t m;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "p:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'p': periods = (uint32_t)atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: adapter_check [-p periods] [size ...]\n");
+        return 2;
+    }
+  }
+  if (optind < argc)
+  {
+    for (count = 0U; (optind < argc) && (count < CHECK_MAX_SIZES); count++)
+    {
+      sizes[count] = (uint32_t)atoi(argv[optind++]);
+      if (sizes[count] == 0U)
+      {
+        fprintf(stderr, "adapter_check: bad block size\n");
+        return 2;
+      }
+    }
+  }
+  if (periods == 0U)
+  {
+    fprintf(stderr, "adapter_check: bad period count\n");
+    return 2;
+  }
+
+  for (m = 0U; m < 2U; m++)
+  {
+    for (a = 0U; a < count; a++)
+    {
+      for (b = 0U; b < count; b++)
+      {
+        if (CHECK_Pair((ADAPTER_ModeTypeDef)m, sizes[a], sizes[b], periods) < 0)
+        {
+          return 1;
+        }
+        pairs++;
+      }
+    }
+  }
+  printf("%u pairs in both modes, all phases: order, bounds and latency exact\n", pairs / 2U);
+  return 0;
+}
@@ -0,0 +1,285 @@
+/**
+  ******************************************************************************
+  * @file    agc_check.c
+  * @brief   Host check of the audio_fastmath.h approximations and of the
+  *          audio_agc.c speech AGC.
+  *
+  *          Fast math, against libm in double precision over dense grids:
+  *            - every function within the error its header states.
+  *          AGC, on synthetic talk: noise bursts of 1.2 s with 0.6 s pauses,
+  *          over a -70 dBFS noise floor, at a talker level that changes
+  *          every 8 s. The speech level of the last 4 s of each stretch:
+  *            - is within the target limit of TargetDb, or below it for a
+  *              talker so quiet the noise guard caps the gain;
+  *            - the pauses, on average, stay below NoiseGuardDb;
+  *            - no output sample exceeds PeakDb;
+  *            - the total gain never rises faster than the slew rate.
+  *          The same talk through a simulated codec PGA driven by
+  *          AGC_Service() once per block:
+  *            - the output speech level matches the digital-only run within
+  *              the target limit, and the PGA carries the gain to within a
+  *              step where its range allows.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o agc_check agc_check.c \
+  *                ../Core/Src/audio_agc.c ../Core/Src/audio_vad.c -lm
+  *
+  *          Usage:
+  *            agc_check [-t target limit dB]
+  *
+  *          Defaults: 1 dB. The exit status is 1 if a function or a level
+  *          is off.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_agc.h"
+#include "audio_fastmath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_BLOCK_RATE          (AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SIZE)
+#define CHECK_STRETCH_BLOCKS      (8U * CHECK_BLOCK_RATE)
+#define CHECK_TALK_BLOCKS         ((uint32_t)(1.2 * CHECK_BLOCK_RATE))
+#define CHECK_PAUSE_BLOCKS        ((uint32_t)(0.6 * CHECK_BLOCK_RATE))
+#define CHECK_FLOOR_DB            (-70.0)
+#define CHECK_SYLLABLE_DB         (-2.26) /* Talk power lost to the syllable swing */
+#define CHECK_GUARD_MARGIN_DB     3.0     /* The guard works from the quietest block */
+#define CHECK_PGA_STEP_DB         1.5f
+#define CHECK_PGA_MAX_DB          30.0f
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  double   Speech;            /* Output power over the measured talk blocks  */
+  uint32_t SpeechBlocks;
+  double   Pause;             /* Output power over the measured pause blocks */
+  uint32_t PauseBlocks;
+  double   Peak;              /* Highest output sample, dB                   */
+  double   Rise;              /* Fastest gain rise, dB per second            */
+  double   PgaOff;            /* Worst PGA distance from the total gain, dB  */
+} CHECK_StatsTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Past about -39 dBFS the noise guard caps the gain below the target */
+static const double TalkerDb[] = { -30.0, -38.0, -18.0, -52.0, -34.0 };
+static AGC_HandleTypeDef Agc;
+static float Pga;
+
+/* Private functions ---------------------------------------------------------*/
+static double CHECK_Uniform(void)
+{
+  return (double)rand() / ((double)RAND_MAX + 1.0);
+}
+
+/* Unit-power noise */
+static float CHECK_Noise(void)
+{
+  return (float)((CHECK_Uniform() * 2.0 - 1.0) * sqrt(3.0));
+}
+
+static int CHECK_FastMath(void)
+{
+  double log2err = 0.0;
+  double exp2err = 0.0;
+  double experr = 0.0;
+  double dberr = 0.0;
+  double scerr = 0.0;
+  double x;
+  float s;
+  float c;
+
+  for (x = 1e-6; x < 1e6; x *= 1.0001)
+  {
+    log2err = AUDIO_MAX(log2err, fabs(FASTMATH_Log2((float)x) - log2((float)x)));
+    dberr   = AUDIO_MAX(dberr, fabs(FASTMATH_PowerToDb((float)x) - 10.0 * log10((float)x)));
+  }
+  for (x = -100.0; x < 100.0; x += 0.0007)
+  {
+    exp2err = AUDIO_MAX(exp2err, fabs(FASTMATH_Exp2((float)x) / exp2((float)x) - 1.0));
+    experr  = AUDIO_MAX(experr, fabs(FASTMATH_Exp((float)(x * 0.8)) / exp((float)(x * 0.8)) - 1.0));
+    dberr   = AUDIO_MAX(dberr, fabs(20.0 * log10(FASTMATH_DbToGain((float)x)) - (float)x));
+    FASTMATH_SinCos((float)x, &s, &c);
+    scerr = AUDIO_MAX(scerr, AUDIO_MAX(fabs(s - sin((float)x)), fabs(c - cos((float)x))));
+  }
+  printf("fastmath: log2 %.1e (2e-5), exp2 %.1e (4e-6), exp %.1e (1e-5), dB %.1e (1e-4), "
+         "sincos %.1e (1e-7)\n", log2err, exp2err, experr, dberr, scerr);
+  return (log2err > 2e-5) || (exp2err > 4e-6) || (experr > 1e-5) || (dberr > 1e-4) ||
+         (scerr > 1e-7);
+}
+
+static AUDIO_StatusTypeDef CHECK_SetPga(void *Context, float GainDb)
+{
+  (void)Context;
+  Pga = GainDb;
+  return AUDIO_OK;
+}
+
+static void CHECK_Init(int Analog)
+{
+  AGC_ConfigTypeDef cfg;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.TargetDb     = -20.0f;
+  cfg.MinGainDb    = -20.0f;
+  cfg.MaxGainDb    = 40.0f;
+  cfg.AttackMs     = 200.0f;
+  cfg.DecayMs      = 1000.0f;
+  cfg.SlewDbPerSec = 10.0f;
+  cfg.NoiseGuardDb = -45.0f;
+  cfg.PeakDb       = -3.0f;
+  if (Analog)
+  {
+    cfg.SetAnalogGain = CHECK_SetPga;
+    cfg.AnalogMinDb   = 0.0f;
+    cfg.AnalogMaxDb   = CHECK_PGA_MAX_DB;
+    cfg.AnalogStepDb  = CHECK_PGA_STEP_DB;
+  }
+  Pga = 0.0f;
+  if (AGC_Init(&Agc, &cfg) != AUDIO_OK)
+  {
+    fprintf(stderr, "agc_check: AGC_Init failed\n");
+    exit(2);
+  }
+}
+
+/* Runs one talker stretch; the stats cover its second half */
+static void CHECK_Stretch(double TalkerDb, int Analog, unsigned Seed, CHECK_StatsTypeDef *pStats)
+{
+  float block[AUDIO_BLOCK_SIZE];
+  double talk = pow(10.0, TalkerDb / 20.0);
+  double floor = pow(10.0, CHECK_FLOOR_DB / 20.0);
+  double last = Agc.GainDb;
+  uint32_t b;
+  uint32_t i;
+
+  memset(pStats, 0, sizeof(*pStats));
+  pStats->Peak  = -HUGE_VAL;
+  srand(Seed);
+  for (b = 0U; b < CHECK_STRETCH_BLOCKS; b++)
+  {
+    uint32_t phase = b % (CHECK_TALK_BLOCKS + CHECK_PAUSE_BLOCKS);
+    int speaking = (phase < CHECK_TALK_BLOCKS);
+    /* Syllables: the talk level swings by 6 dB at 4 Hz */
+    double syllable = 0.75 + 0.25 * sin(2.0 * M_PI * 4.0 * (double)b / (double)CHECK_BLOCK_RATE);
+    double power = 0.0;
+
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      double x = floor * CHECK_Noise() + (speaking ? talk * syllable * CHECK_Noise() : 0.0);
+
+      /* The PGA ahead of the converter */
+      block[i] = (float)(x * pow(10.0, Pga / 20.0));
+    }
+    AGC_Process(&Agc, block, block, AUDIO_BLOCK_SIZE);
+    if (Analog)
+    {
+      AGC_Service(&Agc);
+    }
+
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      power += (double)block[i] * (double)block[i];
+      pStats->Peak = AUDIO_MAX(pStats->Peak, 20.0 * log10(fabs(block[i]) + 1e-20));
+    }
+    pStats->Rise = AUDIO_MAX(pStats->Rise, (Agc.GainDb - last) * (double)CHECK_BLOCK_RATE);
+    last = Agc.GainDb;
+
+    if (b >= CHECK_STRETCH_BLOCKS / 2U)
+    {
+      /* Whole talk blocks past the first syllable, and pauses past the hangover */
+      if (speaking && (phase >= CHECK_BLOCK_RATE / 4U))
+      {
+        pStats->Speech += power;
+        pStats->SpeechBlocks++;
+      }
+      else if (!speaking && (phase >= CHECK_TALK_BLOCKS + CHECK_BLOCK_RATE / 2U))
+      {
+        pStats->Pause += power;
+        pStats->PauseBlocks++;
+      }
+      pStats->PgaOff = AUDIO_MAX(pStats->PgaOff,
+                                 fabs(AUDIO_CLAMP(Agc.GainDb, 0.0f, CHECK_PGA_MAX_DB) - Pga));
+    }
+  }
+}
+
+static double CHECK_Db(double Power, uint32_t Blocks)
+{
+  return 10.0 * log10(Power / (double)(Blocks * AUDIO_BLOCK_SIZE) + 1e-20);
+}
+
+static int CHECK_Talk(double Limit)
+{
+  const AGC_ConfigTypeDef *cfg = &Agc.Config;
+  CHECK_StatsTypeDef st;
+  double digital[sizeof(TalkerDb) / sizeof(TalkerDb[0])];
+  double level;
+  double pause;
+  int guarded;
+  uint32_t t;
+  int failed = 0;
+
+  /* Digital only, the talker changing level every stretch */
+  CHECK_Init(0);
+  for (t = 0U; t < sizeof(TalkerDb) / sizeof(TalkerDb[0]); t++)
+  {
+    CHECK_Stretch(TalkerDb[t], 0, 1000U + t, &st);
+    digital[t] = CHECK_Db(st.Speech, st.SpeechBlocks);
+    pause = CHECK_Db(st.Pause, st.PauseBlocks);
+    printf("talker at %+.0f dBFS: speech %+.1f dBFS, pauses %+.1f, peak %+.1f, rise %.1f dB/s\n",
+           TalkerDb[t], digital[t], pause, st.Peak, st.Rise);
+    guarded = (cfg->TargetDb - TalkerDb[t] - CHECK_SYLLABLE_DB + CHECK_FLOOR_DB >
+               cfg->NoiseGuardDb - CHECK_GUARD_MARGIN_DB);
+    failed |= (guarded ? (digital[t] > cfg->TargetDb + Limit)
+                       : (fabs(digital[t] - cfg->TargetDb) > Limit)) ||
+              (pause > cfg->NoiseGuardDb) ||
+              (st.Peak > cfg->PeakDb + 0.01) || (st.Rise > cfg->SlewDbPerSec * 1.001);
+  }
+
+  /* The same talk through the PGA */
+  CHECK_Init(1);
+  for (t = 0U; t < sizeof(TalkerDb) / sizeof(TalkerDb[0]); t++)
+  {
+    CHECK_Stretch(TalkerDb[t], 1, 1000U + t, &st);
+    level = CHECK_Db(st.Speech, st.SpeechBlocks);
+    printf("  with the PGA: speech %+.1f dBFS, %+.2f dB off the digital run, "
+           "PGA off the gain by %.1f dB at most\n", level, level - digital[t], st.PgaOff);
+    failed |= (fabs(level - digital[t]) > Limit) || (st.PgaOff > CHECK_PGA_STEP_DB);
+  }
+  return failed;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  double limit = 1.0;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': limit = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: agc_check [-t dB]\n");
+        return 2;
+    }
+  }
+
+  failed |= CHECK_FastMath();
+  failed |= CHECK_Talk(limit);
+  return failed;
+}
@@ -0,0 +1,398 @@
+/**
+  ******************************************************************************
+  * @file    asset_check.c
+  * @brief   Host round-trip check of Tools/asset_pack.py and the audio_asset.c
+  *          decoders.
+  *
+  *          The check first writes a set of generated assets, which the
+  *          packer turns into a store; built again with that store, it
+  *          generates the same assets in memory and checks:
+  *            - ASSET_Find() finds every asset and no missing name;
+  *            - ASSET_Load() and ASSET_DecodeChunk(), chunk by chunk, give
+  *              back every byte, short last chunks included. The set covers
+  *              both codecs, raw chunks, LZ4 literal and match lengths past
+  *              the 255 extension, overlapping matches of offset 1 to 3,
+  *              and Rice residuals past the escape;
+  *            - every compressed chunk, truncated at each length or with
+  *              bytes changed at random, decodes to an error or a length
+  *              within the destination, and never writes past it.
+  *          It also prints the decode rate of the load, as a rough guide:
+  *          host figures say little about the M4.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o asset_check asset_check.c \
+  *                ../Core/Src/audio_asset.c -lm
+  *            ./asset_check -w /tmp/assets | xargs ./asset_pack.py -c 1024 \
+  *                -o /tmp/assets/store.c
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o asset_check asset_check.c \
+  *                /tmp/assets/store.c ../Core/Src/audio_asset.c -lm
+  *
+  *          Usage:
+  *            asset_check -w dir      writes the assets, prints the packer
+  *                                    arguments
+  *            asset_check [-n trials] checks the store built in
+  *
+  *          Defaults: 200 random corruptions per chunk. The exit status is 1
+  *          at the first byte that differs or the first corrupt chunk that
+  *          writes past its destination, 2 if no store was built in.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_asset.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_MAX_SIZE            (256U * 1024U)
+#define CHECK_GUARD               64U
+#define CHECK_GUARD_BYTE          0xA5U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  const char *Name;
+  const char *File;
+  uint32_t Rice16;
+  uint32_t (*Make)(uint8_t *pDst);  /* Fills pDst, returns the size */
+} CHECK_AssetTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Linked in the second build only */
+extern const ASSET_StoreTypeDef AssetStore __attribute__((weak));
+
+static uint8_t Want[CHECK_MAX_SIZE];
+static uint8_t Got[CHECK_MAX_SIZE + CHECK_GUARD] __attribute__((aligned(4)));
+static uint8_t Chunk[CHECK_MAX_SIZE];
+static uint32_t Seed;
+
+/* Private functions ---------------------------------------------------------*/
+/* Own generator, so both builds see the same assets whatever the libc */
+static uint32_t CHECK_Rand(void)
+{
+  Seed = Seed * 1664525U + 1013904223U;
+  return Seed >> 8;
+}
+
+static void CHECK_Put16(uint8_t *pDst, uint32_t i, int32_t x)
+{
+  pDst[2U * i]      = (uint8_t)x;
+  pDst[2U * i + 1U] = (uint8_t)((uint32_t)x >> 8);
+}
+
+/* 2 s of a dithered 440 Hz sine at -6 dBFS, not a whole number of chunks */
+static uint32_t CHECK_MakeSine(uint8_t *pDst)
+{
+  uint32_t n = 96000U + 77U;
+  uint32_t i;
+
+  for (i = 0U; i < n; i++)
+  {
+    double x = 16384.0 * sin(2.0 * M_PI * 440.0 * (double)i / 48000.0);
+
+    CHECK_Put16(pDst, i, (int32_t)lrint(x) + (int32_t)(CHECK_Rand() % 3U) - 1);
+  }
+  return 2U * n;
+}
+
+/* Quiet noise with full-scale steps: residuals past the Rice escape */
+static uint32_t CHECK_MakeSteps(uint8_t *pDst)
+{
+  uint32_t n = 20000U;
+  int32_t level = 0;
+  uint32_t i;
+
+  for (i = 0U; i < n; i++)
+  {
+    if (CHECK_Rand() % 50U == 0U)
+    {
+      level = (level > 0) ? -32768 : 32767;
+    }
+    CHECK_Put16(pDst, i, level + (int32_t)(CHECK_Rand() % 9U) - ((level > 0) ? 8 : 0));
+  }
+  return 2U * n;
+}
+
+/* Full-scale noise: no chunk shrinks, all stored raw */
+static uint32_t CHECK_MakeNoise16(uint8_t *pDst)
+{
+  uint32_t i;
+
+  for (i = 0U; i < 8192U; i++)
+  {
+    pDst[i] = (uint8_t)CHECK_Rand();
+  }
+  return 8192U;
+}
+
+/* A short single-cycle float wavetable, repeated: matches past the
+   255 extension in every chunk */
+static uint32_t CHECK_MakeTable(uint8_t *pDst)
+{
+  uint32_t n = 256U * 64U;
+  uint32_t i;
+
+  for (i = 0U; i < n; i++)
+  {
+    float x = (float)sin(2.0 * M_PI * (double)(i % 64U) / 64.0);
+
+    memcpy(&pDst[4U * i], &x, 4U);
+  }
+  return 4U * n;
+}
+
+/* Runs of period 1 to 3 between literal stretches of every length */
+static uint32_t CHECK_MakePatterns(uint8_t *pDst)
+{
+  uint32_t size = 0U;
+  uint32_t lit = 1U;
+
+  while (size < 40000U)
+  {
+    uint32_t period = 1U + CHECK_Rand() % 3U;
+    uint32_t run = 4U + CHECK_Rand() % 600U;
+    uint32_t i;
+
+    for (i = 0U; i < lit; i++)
+    {
+      pDst[size++] = (uint8_t)CHECK_Rand();
+    }
+    for (i = 0U; i < run; i++, size++)
+    {
+      pDst[size] = (i < period) ? (uint8_t)CHECK_Rand() : pDst[size - period];
+    }
+    lit = (lit * 7U + 3U) % 700U;
+  }
+  return size;
+}
+
+static uint32_t CHECK_MakeRandom(uint8_t *pDst)
+{
+  uint32_t i;
+
+  for (i = 0U; i < 5000U; i++)
+  {
+    pDst[i] = (uint8_t)CHECK_Rand();
+  }
+  return 5000U;
+}
+
+static uint32_t CHECK_MakeTiny(uint8_t *pDst)
+{
+  memcpy(pDst, "tiny", 5U);
+  return 5U;
+}
+
+static const CHECK_AssetTypeDef Assets[] =
+{
+  { "pcm/sine",      "sine.raw",     1U, CHECK_MakeSine     },
+  { "pcm/steps",     "steps.raw",    1U, CHECK_MakeSteps    },
+  { "pcm/noise",     "noise16.raw",  1U, CHECK_MakeNoise16  },
+  { "table/wave",    "wave.bin",     0U, CHECK_MakeTable    },
+  { "text/patterns", "patterns.bin", 0U, CHECK_MakePatterns },
+  { "bin/random",    "random.bin",   0U, CHECK_MakeRandom   },
+  { "tiny",          "tiny.bin",     0U, CHECK_MakeTiny     }
+};
+
+#define CHECK_NUM_ASSETS          (sizeof(Assets) / sizeof(Assets[0]))
+
+static uint32_t CHECK_Make(uint32_t Index)
+{
+  Seed = Index + 1U;
+  return Assets[Index].Make(Want);
+}
+
+static int CHECK_Write(const char *pDir)
+{
+  char path[1024];
+  uint32_t a;
+
+  for (a = 0U; a < CHECK_NUM_ASSETS; a++)
+  {
+    uint32_t size = CHECK_Make(a);
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", pDir, Assets[a].File);
+    f = fopen(path, "wb");
+    if ((f == NULL) || (fwrite(Want, 1U, size, f) != size) || (fclose(f) != 0))
+    {
+      fprintf(stderr, "asset_check: cannot write %s\n", path);
+      return 2;
+    }
+    printf("%s=%s%s\n", Assets[a].Name, path, (Assets[a].Rice16 != 0U) ? ",rice16" : "");
+  }
+  return 0;
+}
+
+static int CHECK_GuardIntact(uint32_t Size)
+{
+  uint32_t i;
+
+  for (i = 0U; i < CHECK_GUARD; i++)
+  {
+    if (Got[Size + i] != CHECK_GUARD_BYTE)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Decodes a corrupt chunk into a guarded buffer; 0 if it stays inside */
+static int CHECK_Corrupt(const ASSET_EntryTypeDef *pEntry, uint32_t Len, uint32_t Size)
+{
+  int32_t n;
+
+  memset(Got, CHECK_GUARD_BYTE, Size + CHECK_GUARD);
+  if (pEntry->Codec == (uint32_t)ASSET_CODEC_RICE16)
+  {
+    n = ASSET_Rice16Decode(Chunk, Len, (int16_t *)(void *)Got, Size / 2U);
+    n = (n < 0) ? n : 2 * n;
+  }
+  else
+  {
+    n = ASSET_Lz4Decode(Chunk, Len, Got, Size);
+  }
+  return ((n > (int32_t)Size) || !CHECK_GuardIntact(Size)) ? 1 : 0;
+}
+
+static int CHECK_Asset(uint32_t Index, uint32_t Trials, double *pBytes, double *pSeconds)
+{
+  const ASSET_EntryTypeDef *e = ASSET_Find(&AssetStore, Assets[Index].Name);
+  uint32_t size = CHECK_Make(Index);
+  uint32_t raw = 0U;
+  uint32_t c;
+  struct timespec t0;
+  struct timespec t1;
+
+  if ((e == NULL) || (e->Size != size) ||
+      (e->Codec != ((Assets[Index].Rice16 != 0U) ? (uint32_t)ASSET_CODEC_RICE16
+                                                  : (uint32_t)ASSET_CODEC_LZ4)))
+  {
+    printf("%s: missing, or not as written\n", Assets[Index].Name);
+    return 1;
+  }
+
+  /* Whole, timed */
+  memset(Got, 0, sizeof(Got));
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if ((ASSET_Load(e, Got, sizeof(Got)) != AUDIO_OK) || (memcmp(Got, Want, size) != 0))
+  {
+    printf("%s: ASSET_Load does not give the asset back\n", Assets[Index].Name);
+    return 1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  *pBytes   += (double)size;
+  *pSeconds += (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+
+  for (c = 0U; c < e->NumChunks; c++)
+  {
+    uint32_t chunk = ASSET_GetChunkSize(e, c);
+    uint32_t len = e->pChunks[c + 1U] - e->pChunks[c];
+    uint32_t t;
+
+    /* Chunk by chunk, into a guarded buffer */
+    memset(Got, CHECK_GUARD_BYTE, chunk + CHECK_GUARD);
+    if ((ASSET_DecodeChunk(e, c, Got) != chunk) ||
+        (memcmp(Got, &Want[c * e->ChunkSize], chunk) != 0) || !CHECK_GuardIntact(chunk))
+    {
+      printf("%s: chunk %u of %u differs\n", Assets[Index].Name, c, e->NumChunks);
+      return 1;
+    }
+    if (len == chunk)
+    {
+      raw++;
+      continue;
+    }
+
+    /* Truncated at every length, then changed bytes */
+    for (t = 0U; t < len; t++)
+    {
+      memcpy(Chunk, &e->pData[e->pChunks[c]], t);
+      if (CHECK_Corrupt(e, t, chunk) != 0)
+      {
+        printf("%s: chunk %u truncated to %u of %u bytes writes past its end\n",
+               Assets[Index].Name, c, t, len);
+        return 1;
+      }
+    }
+    for (t = 0U; t < Trials; t++)
+    {
+      uint32_t k;
+
+      memcpy(Chunk, &e->pData[e->pChunks[c]], len);
+      for (k = 1U + CHECK_Rand() % 4U; k > 0U; k--)
+      {
+        Chunk[CHECK_Rand() % len] = (uint8_t)CHECK_Rand();
+      }
+      if (CHECK_Corrupt(e, len, chunk) != 0)
+      {
+        printf("%s: corrupt chunk %u writes past its end\n", Assets[Index].Name, c);
+        return 1;
+      }
+    }
+  }
+  printf("%-14s %6u -> %6u bytes, %3u chunks (%u raw): round-trip exact, corrupt chunks "
+         "contained\n", Assets[Index].Name, size, e->pChunks[e->NumChunks], e->NumChunks, raw);
+  return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  const char *dir = NULL;
+  uint32_t trials = 200U;
+  double bytes = 0.0;
+  double seconds = 0.0;
+  int failed = 0;
+  uint32_t a;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "w:n:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'w': dir = optarg; break;
+      case 'n': trials = (uint32_t)atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: asset_check -w dir | asset_check [-n trials]\n");
+        return 2;
+    }
+  }
+  if (dir != NULL)
+  {
+    return CHECK_Write(dir);
+  }
+  if (&AssetStore == NULL)
+  {
+    fprintf(stderr, "asset_check: no store built in, see the build steps\n");
+    return 2;
+  }
+
+  if ((AssetStore.NumEntries != CHECK_NUM_ASSETS) || (ASSET_Find(&AssetStore, "pcm") != NULL) ||
+      (ASSET_Find(&AssetStore, "zzz") != NULL) || (ASSET_Find(&AssetStore, "") != NULL))
+  {
+    printf("index: wrong entry count, or a missing name found\n");
+    return 1;
+  }
+  for (a = 0U; (a < CHECK_NUM_ASSETS) && (failed == 0); a++)
+  {
+    failed |= CHECK_Asset(a, trials, &bytes, &seconds);
+  }
+  if (failed == 0)
+  {
+    printf("load: %.0f MB/s decoded on this host\n", bytes / AUDIO_MAX(seconds, 1e-9) / 1e6);
+  }
+  return failed;
+}
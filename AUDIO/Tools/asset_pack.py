@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""Packs binary assets into a compressed, flash-resident asset store.
+
+Each asset is cut into fixed-size chunks and every chunk is compressed on its
+own, so the firmware (audio_asset.c) can decode any chunk straight into a
+pool block or an arena. Generic data uses LZ4 blocks; 16-bit PCM can use
+delta + Rice coding instead, which suits audio far better than LZ4. Chunks
+that do not shrink are stored raw.
+
+Every chunk is decoded again and compared with the input before the output
+is written, so a store that builds is a store that round-trips.
+
+Usage:
+    asset_pack.py -o Core/Src/asset_store.c [-c 4096] [-s AssetStore] \\
+        name=path[,rice16] ...
+"""
+
+import argparse
+import struct
+import sys
+
+MIN_MATCH = 4
+MAX_OFFSET = 65535
+LAST_LITERALS = 5       # LZ4: the block ends with at least 5 literals
+MF_LIMIT = 12           # LZ4: no match starts in the last 12 bytes
+RICE_ESCAPE = 16        # quotients from here on are sent as a raw residual
+RICE_MAX_K = 15
+
+
+def _put_length(out, value):
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+
+
+def _put_sequence(out, literals, offset, match_len):
+    lit = len(literals)
+    ml = match_len - MIN_MATCH if offset else 0
+    out.append((min(lit, 15) << 4) | (min(ml, 15) if offset else 0))
+    if lit >= 15:
+        _put_length(out, lit - 15)
+    out += literals
+    if offset:
+        out += struct.pack('<H', offset)
+        if ml >= 15:
+            _put_length(out, ml - 15)
+
+
+def lz4_compress(src):
+    """Greedy LZ4 block compressor with a single-entry hash table."""
+    n = len(src)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    while i < n - MF_LIMIT:
+        key = src[i:i + MIN_MATCH]
+        cand = table.get(key, -1)
+        table[key] = i
+        if cand < 0 or i - cand > MAX_OFFSET:
+            i += 1
+            continue
+        length = MIN_MATCH
+        limit = n - LAST_LITERALS - i
+        while length < limit and src[cand + length] == src[i + length]:
+            length += 1
+        _put_sequence(out, src[anchor:i], i - cand, length)
+        i += length
+        anchor = i
+    _put_sequence(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+
+def lz4_decompress(src, size):
+    """Reference decoder, mirrors ASSET_Lz4Decode()."""
+    out = bytearray()
+    i = 0
+    while i < len(src):
+        token = src[i]
+        i += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = src[i]
+                i += 1
+                lit += b
+                if b != 255:
+                    break
+        out += src[i:i + lit]
+        i += lit
+        if i == len(src):
+            break
+        offset = src[i] | (src[i + 1] << 8)
+        i += 2
+        ml = token & 15
+        if ml == 15:
+            while True:
+                b = src[i]
+                i += 1
+                ml += b
+                if b != 255:
+                    break
+        ml += MIN_MATCH
+        for _ in range(ml):
+            out.append(out[-offset])
+    if len(out) != size:
+        raise ValueError('decoded %d bytes, expected %d' % (len(out), size))
+    return bytes(out)
+
+
+def _zigzag_residuals(chunk):
+    count = len(chunk) // 2
+    prev = 0
+    for x in struct.unpack('<%dh' % count, chunk):
+        d = ((x - prev + 32768) & 0xFFFF) - 32768
+        prev = x
+        yield 2 * d if d >= 0 else -2 * d - 1
+
+
+def _rice_bits(values, k):
+    return sum(min(v >> k, RICE_ESCAPE) + (1 + k if (v >> k) < RICE_ESCAPE else 16) for v in values)
+
+
+def rice16_compress(chunk):
+    """Delta + Rice coding of 16-bit samples, best parameter for the chunk."""
+    values = list(_zigzag_residuals(chunk))
+    k = min(range(RICE_MAX_K + 1), key=lambda kk: _rice_bits(values, kk))
+    acc = 0
+    nbits = 0
+    out = bytearray([k])
+    for v in values:
+        q = v >> k
+        if q >= RICE_ESCAPE:
+            code, width = v, RICE_ESCAPE + 16
+        else:
+            code, width = (1 << k) | (v & ((1 << k) - 1)), q + 1 + k
+        acc = (acc << width) | code
+        nbits += width
+        while nbits >= 8:
+            nbits -= 8
+            out.append((acc >> nbits) & 0xFF)
+        acc &= (1 << nbits) - 1
+    if nbits:
+        out.append((acc << (8 - nbits)) & 0xFF)
+    return bytes(out)
+
+
+def rice16_decompress(src, size):
+    """Reference decoder, mirrors ASSET_Rice16Decode()."""
+    k = src[0]
+    bits = ''.join('{:08b}'.format(b) for b in src[1:])
+    pos = 0
+    prev = 0
+    out = []
+    for _ in range(size // 2):
+        q = 0
+        while q < RICE_ESCAPE and bits[pos + q] == '0':
+            q += 1
+        if q == RICE_ESCAPE:
+            v = int(bits[pos + q:pos + q + 16], 2)
+            pos += q + 16
+        else:
+            pos += q + 1
+            v = (q << k) | (int(bits[pos:pos + k], 2) if k else 0)
+            pos += k
+        d = (v >> 1) ^ -(v & 1)
+        prev = ((prev + d + 32768) & 0xFFFF) - 32768
+        out.append(prev)
+    return struct.pack('<%dh' % len(out), *out)
+
+
+def pack_asset(data, chunk_size, rice):
+    compress, decompress = (rice16_compress, rice16_decompress) if rice else (lz4_compress, lz4_decompress)
+    blob = bytearray()
+    offsets = [0]
+    for start in range(0, len(data), chunk_size):
+        raw = data[start:start + chunk_size]
+        packed = compress(raw)
+        if len(packed) >= len(raw):
+            packed = raw
+
+        check = packed if len(packed) == len(raw) else decompress(packed, len(raw))
+        if check != raw:
+            raise RuntimeError('chunk at %d does not round-trip' % start)
+
+        blob += packed
+        offsets.append(len(blob))
+    return bytes(blob), offsets
+
+
+def c_identifier(name):
+    return ''.join(ch if ch.isalnum() else '_' for ch in name)
+
+
+def write_store(path, symbol, chunk_size, assets):
+    lines = [
+        '/* Generated by Tools/asset_pack.py, do not edit. */',
+        '#include "audio_asset.h"',
+        '',
+    ]
+    entries = []
+    for name, data, rice in sorted(assets, key=lambda a: a[0].encode()):
+        ident = c_identifier(name)
+        blob, offsets = pack_asset(data, chunk_size, rice)
+        lines.append('static const uint8_t Asset_%s_Data[%d] __attribute__((aligned(4))) =' % (ident, max(len(blob), 1)))
+        lines.append('{')
+        for k in range(0, len(blob), 16):
+            lines.append('  ' + ', '.join('0x%02X' % b for b in blob[k:k + 16]) + ',')
+        lines.append('};')
+        lines.append('')
+        lines.append('static const uint32_t Asset_%s_Chunks[%d] =' % (ident, len(offsets)))
+        lines.append('{')
+        for k in range(0, len(offsets), 8):
+            lines.append('  ' + ', '.join('%dU' % o for o in offsets[k:k + 8]) + ',')
+        lines.append('};')
+        lines.append('')
+        entries.append('  { "%s", Asset_%s_Data, Asset_%s_Chunks, %dU, %dU, %dU, %s },' % (
+            name, ident, ident, len(data), chunk_size, len(offsets) - 1,
+            'ASSET_CODEC_RICE16' if rice else 'ASSET_CODEC_LZ4'))
+        sys.stderr.write('%-24s %8d -> %8d bytes (%5.1f%%)\n' % (
+            name, len(data), len(blob), 100.0 * len(blob) / max(len(data), 1)))
+
+    lines.append('static const ASSET_EntryTypeDef %sEntries[%d] =' % (symbol, len(entries)))
+    lines.append('{')
+    lines += entries
+    lines.append('};')
+    lines.append('')
+    lines.append('const ASSET_StoreTypeDef %s = { %sEntries, %dU };' % (symbol, symbol, len(entries)))
+    with open(path, 'w', newline='\n') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('-o', '--output', required=True, help='generated C source')
+    parser.add_argument('-c', '--chunk', type=int, default=4096, help='chunk size in bytes (even)')
+    parser.add_argument('-s', '--symbol', default='AssetStore', help='name of the store object')
+    parser.add_argument('assets', nargs='+', help='name=path[,rice16]')
+    args = parser.parse_args()
+
+    if args.chunk < 16 or args.chunk % 2:
+        parser.error('chunk size must be even and at least 16')
+
+    assets = []
+    for spec in args.assets:
+        name, _, rest = spec.partition('=')
+        path, _, flags = rest.partition(',')
+        if not name or not path or flags not in ('', 'rice16'):
+            parser.error('bad asset spec: %s' % spec)
+        with open(path, 'rb') as f:
+            data = f.read()
+        if flags == 'rice16' and len(data) % 2:
+            parser.error('%s: rice16 assets must hold whole 16-bit samples' % name)
+        assets.append((name, data, flags == 'rice16'))
+
+    write_store(args.output, args.symbol, args.chunk, assets)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,456 @@
+/**
+  ******************************************************************************
+  * @file    async_check.c
+  * @brief   Host check of the audio_async.c run loop against a simulated HAL.
+  *
+  *          The simulated HAL has a 1 ms tick, DMA streams that complete a
+  *          set number of ticks after they start and post their signal from
+  *          the "interrupt" run before the loop at each tick, and a card
+  *          that reports ready after its power-up time. Checked:
+  *            - sleeps resume on the exact tick, across the tick wrap, and
+  *              a yield on the next run;
+  *            - a card mount (status poll, then block reads, each awaiting
+  *              its DMA) and a codec bring-up (sleeps) run side by side:
+  *              each ends on the tick it would alone, and the frame keeps
+  *              the locals across every wait;
+  *            - a transfer that overruns its wait times out on the exact
+  *              tick; with the source stopped, its late post dropped by
+  *              ASYNC_Clear(), the next wait ends with its own transfer;
+  *            - a queue burst past its size keeps the events in order and
+  *              counts the dropped ones, and an empty queue times out;
+  *            - the frame pool: an oversized frame is refused, a full pool
+  *              is busy, and a parent awaits every child's done signal.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o async_check async_check.c \
+  *                ../Core/Src/audio_async.c
+  *
+  *          Usage:
+  *            async_check [-t start tick]
+  *
+  *          Defaults: the tick starts 16 ms before it wraps. The exit status
+  *          is 1 if a wait ends on the wrong tick or with the wrong result.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_async.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_MAX_TICKS           10000U
+#define CHECK_MAX_LOG             64U
+#define CHECK_CARD_READY_MS       37U
+#define CHECK_BLOCKS              8U
+#define CHECK_BLOCK_MS            3U
+#define CHECK_DMA_TIMEOUT_MS      10U
+#define CHECK_BURST               (ASYNC_QUEUE_SIZE + 8U)
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+  * @brief  Simulated DMA stream
+  */
+typedef struct
+{
+  uint32_t Armed;
+  uint32_t Due;                       /* Completion tick                   */
+  uint32_t LatePost;                  /* Abort races a completion          */
+  ASYNC_SignalTypeDef Done;
+} CHECK_DmaTypeDef;
+
+/**
+  * @brief  Wait outcomes a task logs, checked against what they must be
+  */
+typedef struct
+{
+  uint32_t Tick[CHECK_MAX_LOG];
+  AUDIO_StatusTypeDef Result[CHECK_MAX_LOG];
+  uint32_t Count;
+} CHECK_LogTypeDef;
+
+typedef struct
+{
+  uint32_t Block;
+  uint32_t Sum;                       /* Kept across the waits             */
+} CHECK_MountFrameTypeDef;
+
+typedef struct
+{
+  uint32_t Sleep;
+  uint32_t Children;
+} CHECK_ChildFrameTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static ASYNC_HandleTypeDef Loop;
+static uint32_t Tick;
+static uint32_t CardReadyAt;
+static CHECK_DmaTypeDef Dma;
+static ASYNC_QueueTypeDef Queue;
+static ASYNC_SignalTypeDef ChildDone;
+static uint32_t BurstAt;
+static CHECK_LogTypeDef Logs[2];
+static AUDIO_StatusTypeDef SpawnResult[2];
+static uint32_t MountSum;
+
+/* Private functions ---------------------------------------------------------*/
+static void CHECK_Log(uint32_t Which, const ASYNC_TaskTypeDef *pTask)
+{
+  CHECK_LogTypeDef *log = &Logs[Which];
+
+  if (log->Count < CHECK_MAX_LOG)
+  {
+    log->Tick[log->Count]   = pTask->Now;
+    log->Result[log->Count] = pTask->Result;
+    log->Count++;
+  }
+}
+
+/* Simulated HAL ------------------------------------------------------------*/
+static void CHECK_DmaStart(uint32_t Ms)
+{
+  Dma.Armed = 1U;
+  Dma.Due = Tick + Ms;
+}
+
+/* Stops the stream; a completion that raced the abort still posts */
+static void CHECK_DmaAbort(void)
+{
+  Dma.Armed = 0U;
+  if (Dma.LatePost != 0U)
+  {
+    ASYNC_Post(&Dma.Done);
+  }
+}
+
+static void CHECK_Interrupts(void)
+{
+  if ((Dma.Armed != 0U) && ((int32_t)(Tick - Dma.Due) >= 0))
+  {
+    Dma.Armed = 0U;
+    ASYNC_Post(&Dma.Done);
+  }
+  if (Tick == BurstAt)
+  {
+    uint32_t i;
+
+    for (i = 0U; i < CHECK_BURST; i++)
+    {
+      (void)ASYNC_Push(&Queue, i, -(int32_t)i);
+    }
+  }
+}
+
+static uint8_t CHECK_CardReady(void)
+{
+  return (uint8_t)((int32_t)(Tick - CardReadyAt) >= 0);
+}
+
+static void CHECK_Reset(uint32_t Start)
+{
+  ASYNC_Init(&Loop);
+  memset(&Dma, 0, sizeof(Dma));
+  memset(&Queue, 0, sizeof(Queue));
+  memset(&ChildDone, 0, sizeof(ChildDone));
+  memset(Logs, 0, sizeof(Logs));
+  Tick = Start;
+  BurstAt = Start - 1U;
+}
+
+/* Runs the loop tick by tick until no task is left; the ticks taken */
+static uint32_t CHECK_RunAll(void)
+{
+  uint32_t start = Tick;
+  uint32_t i;
+  uint32_t busy;
+
+  do
+  {
+    Tick++;
+    CHECK_Interrupts();
+    (void)ASYNC_Run(&Loop, Tick);
+    busy = 0U;
+    for (i = 0U; i < ASYNC_MAX_TASKS; i++)
+    {
+      busy |= (Loop.Tasks[i].Func != NULL);
+    }
+  } while ((busy != 0U) && (Tick - start < CHECK_MAX_TICKS));
+  return Tick - start;
+}
+
+/* Checks one logged wait; prints the first one off */
+static int CHECK_Expect(uint32_t Which, uint32_t Index, uint32_t Tick0, const char *pWhat,
+                        AUDIO_StatusTypeDef Result)
+{
+  const CHECK_LogTypeDef *log = &Logs[Which];
+
+  if (Index >= log->Count)
+  {
+    printf("%s: never ended\n", pWhat);
+    return 1;
+  }
+  if ((log->Tick[Index] != Tick0) || (log->Result[Index] != Result))
+  {
+    printf("%s: ended %+d ms off with status %d, expected status %d\n", pWhat,
+           (int32_t)(log->Tick[Index] - Tick0), (int)log->Result[Index], (int)Result);
+    return 1;
+  }
+  return 0;
+}
+
+/* Tasks --------------------------------------------------------------------*/
+static ASYNC_StateTypeDef CHECK_SleepTask(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  (void)pFrame;
+  ASYNC_BEGIN(pTask);
+  CHECK_Log(0U, pTask);
+  ASYNC_SLEEP(pTask, 1U);
+  CHECK_Log(0U, pTask);
+  ASYNC_SLEEP(pTask, 5U);
+  CHECK_Log(0U, pTask);
+  ASYNC_SLEEP(pTask, 100U);
+  CHECK_Log(0U, pTask);
+  ASYNC_YIELD(pTask);
+  CHECK_Log(0U, pTask);
+  ASYNC_END(pTask);
+}
+
+static ASYNC_StateTypeDef CHECK_MountTask(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  CHECK_MountFrameTypeDef *f = (CHECK_MountFrameTypeDef *)pFrame;
+
+  ASYNC_BEGIN(pTask);
+  ASYNC_AWAIT_COND(pTask, CHECK_CardReady(), 100U);
+  CHECK_Log(0U, pTask);
+  for (f->Block = 0U; f->Block < CHECK_BLOCKS; f->Block++)
+  {
+    CHECK_DmaStart(CHECK_BLOCK_MS);
+    ASYNC_AWAIT_SIGNAL(pTask, &Dma.Done, CHECK_DMA_TIMEOUT_MS);
+    CHECK_Log(0U, pTask);
+    f->Sum += f->Block + 1U;
+  }
+  MountSum = f->Sum;
+  ASYNC_END(pTask);
+}
+
+static ASYNC_StateTypeDef CHECK_CodecTask(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  (void)pFrame;
+  ASYNC_BEGIN(pTask);
+  ASYNC_SLEEP(pTask, 10U);
+  ASYNC_SLEEP(pTask, 120U);
+  ASYNC_SLEEP(pTask, 120U);
+  CHECK_Log(1U, pTask);
+  ASYNC_END(pTask);
+}
+
+static ASYNC_StateTypeDef CHECK_AbortTask(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  (void)pFrame;
+  ASYNC_BEGIN(pTask);
+  CHECK_Log(0U, pTask);
+  CHECK_DmaStart(CHECK_DMA_TIMEOUT_MS + 5U);
+  ASYNC_AWAIT_SIGNAL(pTask, &Dma.Done, CHECK_DMA_TIMEOUT_MS);
+  CHECK_Log(0U, pTask);
+  if (pTask->Result != AUDIO_OK)
+  {
+    CHECK_DmaAbort();
+    ASYNC_Clear(&Dma.Done);
+  }
+  CHECK_DmaStart(CHECK_BLOCK_MS);
+  ASYNC_AWAIT_SIGNAL(pTask, &Dma.Done, CHECK_DMA_TIMEOUT_MS);
+  CHECK_Log(0U, pTask);
+  ASYNC_END(pTask);
+}
+
+static ASYNC_StateTypeDef CHECK_QueueTask(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  uint32_t *pNext = (uint32_t *)pFrame;
+
+  ASYNC_BEGIN(pTask);
+  for (*pNext = 0U; *pNext < ASYNC_QUEUE_SIZE; (*pNext)++)
+  {
+    ASYNC_AWAIT_EVENT(pTask, &Queue, 5U);
+    if ((pTask->Result != AUDIO_OK) || (pTask->Event.Id != *pNext) ||
+        (pTask->Event.Value != -(int32_t)*pNext))
+    {
+      CHECK_Log(0U, pTask);
+      return ASYNC_DONE;
+    }
+  }
+  CHECK_Log(0U, pTask);
+  ASYNC_AWAIT_EVENT(pTask, &Queue, 5U);
+  CHECK_Log(0U, pTask);
+  ASYNC_END(pTask);
+}
+
+static ASYNC_StateTypeDef CHECK_ChildTask(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  CHECK_ChildFrameTypeDef *f = (CHECK_ChildFrameTypeDef *)pFrame;
+
+  ASYNC_BEGIN(pTask);
+  ASYNC_SLEEP(pTask, f->Sleep);
+  ASYNC_END(pTask);
+}
+
+static ASYNC_StateTypeDef CHECK_ParentTask(ASYNC_TaskTypeDef *pTask, void *pFrame)
+{
+  CHECK_ChildFrameTypeDef *f = (CHECK_ChildFrameTypeDef *)pFrame;
+  CHECK_ChildFrameTypeDef child;
+
+  ASYNC_BEGIN(pTask);
+  CHECK_Log(0U, pTask);
+  memset(&child, 0, sizeof(child));
+  for (f->Children = 0U; f->Children < ASYNC_MAX_TASKS - 1U; f->Children++)
+  {
+    child.Sleep = 10U * (f->Children + 1U);
+    if (ASYNC_Spawn(&Loop, CHECK_ChildTask, &child, sizeof(child), &ChildDone) != AUDIO_OK)
+    {
+      return ASYNC_DONE;
+    }
+  }
+  SpawnResult[0] = ASYNC_Spawn(&Loop, CHECK_ChildTask, &child, sizeof(child), &ChildDone);
+  SpawnResult[1] = ASYNC_Spawn(&Loop, CHECK_ChildTask, NULL, ASYNC_FRAME_SIZE + 1U, NULL);
+  while (f->Children > 0U)
+  {
+    ASYNC_AWAIT_SIGNAL(pTask, &ChildDone, ASYNC_FOREVER);
+    CHECK_Log(0U, pTask);
+    f->Children--;
+  }
+  ASYNC_END(pTask);
+}
+
+/* Scenarios ----------------------------------------------------------------*/
+static int CHECK_Sleep(uint32_t Start)
+{
+  int failed = 0;
+  uint32_t t0;
+
+  CHECK_Reset(Start);
+  (void)ASYNC_Spawn(&Loop, CHECK_SleepTask, NULL, 0U, NULL);
+  (void)CHECK_RunAll();
+  t0 = Logs[0].Tick[0];
+  failed |= CHECK_Expect(0U, 1U, t0 + 1U, "sleep 1 ms", AUDIO_OK);
+  failed |= CHECK_Expect(0U, 2U, t0 + 6U, "sleep 5 ms", AUDIO_OK);
+  failed |= CHECK_Expect(0U, 3U, t0 + 106U, "sleep 100 ms", AUDIO_OK);
+  failed |= CHECK_Expect(0U, 4U, t0 + 107U, "yield", AUDIO_OK);
+  printf("sleep: 1, 5 and 100 ms and a yield from tick 0x%08X, across the wrap: %s\n", t0,
+         failed ? "off" : "exact");
+  return failed;
+}
+
+static int CHECK_Overlap(uint32_t Start)
+{
+  uint32_t t0 = Start + 1U;
+  uint32_t ready = t0 + CHECK_CARD_READY_MS;
+  uint32_t ticks;
+  int failed = 0;
+  uint32_t b;
+
+  CHECK_Reset(Start);
+  CardReadyAt = ready;
+  MountSum = 0U;
+  (void)ASYNC_Spawn(&Loop, CHECK_MountTask, NULL, 0U, NULL);
+  (void)ASYNC_Spawn(&Loop, CHECK_CodecTask, NULL, 0U, NULL);
+  ticks = CHECK_RunAll();
+  failed |= CHECK_Expect(0U, 0U, ready, "card ready", AUDIO_OK);
+  for (b = 0U; b < CHECK_BLOCKS; b++)
+  {
+    failed |= CHECK_Expect(0U, 1U + b, ready + (b + 1U) * CHECK_BLOCK_MS, "block read", AUDIO_OK);
+  }
+  failed |= CHECK_Expect(1U, 0U, t0 + 250U, "codec bring-up", AUDIO_OK);
+  failed |= (MountSum != CHECK_BLOCKS * (CHECK_BLOCKS + 1U) / 2U);
+  printf("overlap: mount done after %u ms, codec after 250 ms, both in %u ms: %s\n",
+         CHECK_CARD_READY_MS + CHECK_BLOCKS * CHECK_BLOCK_MS, ticks, failed ? "off" : "exact");
+  return failed;
+}
+
+static int CHECK_Abort(uint32_t Start)
+{
+  int failed = 0;
+  uint32_t t0;
+
+  CHECK_Reset(Start);
+  Dma.LatePost = 1U;
+  (void)ASYNC_Spawn(&Loop, CHECK_AbortTask, NULL, 0U, NULL);
+  (void)CHECK_RunAll();
+  t0 = Logs[0].Tick[0];
+  failed |= CHECK_Expect(0U, 1U, t0 + CHECK_DMA_TIMEOUT_MS, "overrun transfer", AUDIO_TIMEOUT);
+  failed |= CHECK_Expect(0U, 2U, t0 + CHECK_DMA_TIMEOUT_MS + CHECK_BLOCK_MS, "next transfer",
+                         AUDIO_OK);
+  printf("abort: timeout on time, late post dropped, next transfer waited for: %s\n",
+         failed ? "off" : "exact");
+  return failed;
+}
+
+static int CHECK_Queue(uint32_t Start)
+{
+  int failed = 0;
+
+  CHECK_Reset(Start);
+  BurstAt = Start + 2U;
+  (void)ASYNC_Spawn(&Loop, CHECK_QueueTask, NULL, 0U, NULL);
+  (void)CHECK_RunAll();
+  failed |= CHECK_Expect(0U, 0U, BurstAt + ASYNC_QUEUE_SIZE - 1U, "queue burst", AUDIO_OK);
+  failed |= CHECK_Expect(0U, 1U, BurstAt + ASYNC_QUEUE_SIZE + 4U, "empty queue", AUDIO_TIMEOUT);
+  failed |= (Queue.Dropped != CHECK_BURST - ASYNC_QUEUE_SIZE);
+  printf("queue: burst of %u, %u taken in order, %u dropped, empty wait timed out: %s\n",
+         CHECK_BURST, ASYNC_QUEUE_SIZE, Queue.Dropped, failed ? "off" : "exact");
+  return failed;
+}
+
+static int CHECK_Pool(uint32_t Start)
+{
+  int failed = 0;
+  uint32_t t0;
+  uint32_t c;
+
+  CHECK_Reset(Start);
+  (void)ASYNC_Spawn(&Loop, CHECK_ParentTask, NULL, 0U, NULL);
+  (void)CHECK_RunAll();
+  t0 = Logs[0].Tick[0];
+  /* A child ending on a tick posts after the parent's turn: seen one later */
+  for (c = 0U; c < ASYNC_MAX_TASKS - 1U; c++)
+  {
+    failed |= CHECK_Expect(0U, 1U + c, t0 + 10U * (c + 1U) + 1U, "child done", AUDIO_OK);
+  }
+  failed |= (SpawnResult[0] != AUDIO_BUSY) || (SpawnResult[1] != AUDIO_ERROR);
+  printf("pool: %u children awaited, full pool busy, oversized frame refused: %s\n",
+         ASYNC_MAX_TASKS - 1U, failed ? "off" : "exact");
+  return failed;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  uint32_t start = 0xFFFFFFF0U;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': start = (uint32_t)strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: async_check [-t start tick]\n");
+        return 2;
+    }
+  }
+
+  failed |= CHECK_Sleep(start);
+  failed |= CHECK_Overlap(start);
+  failed |= CHECK_Abort(start);
+  failed |= CHECK_Queue(start);
+  failed |= CHECK_Pool(start);
+  return failed;
+}
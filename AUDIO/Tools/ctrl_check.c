@@ -0,0 +1,270 @@
+/**
+  ******************************************************************************
+  * @file    ctrl_check.c
+  * @brief   Host check of the audio_ctrl.c scheduler.
+  *
+  *          Runs one node per divider (1 to CTRL_MAX_DIVIDER), each returning
+  *          random values, plus a node reading another, and renders every
+  *          node every block. Checked against a double reference:
+  *            - each node updates exactly once every Divider blocks, on its
+  *              phase, and gets Dt = Divider blocks in seconds;
+  *            - the rendered output is the straight line from the previous
+  *              value to the one returned, reached on the last sample of
+  *              block b + Divider - 1, with no step between blocks;
+  *            - CTRL_GetValue() is the output before the block's first
+  *              sample;
+  *            - a node added after another reads its value of this block.
+  *          And for the slot spreading:
+  *            - up to Divider equal nodes of one divider never share a slot;
+  *            - a mixed set, added slowest first, peaks at most one node
+  *              cost above the average load rounded up.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o ctrl_check ctrl_check.c \
+  *                ../Core/Src/audio_ctrl.c -lm
+  *
+  *          Usage:
+  *            ctrl_check [-b blocks] [-s seed]
+  *
+  *          Defaults: 10000 blocks, seed 1. The exit status is 1 at the first
+  *          update, sample or load that is off.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_ctrl.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_DIVIDERS            6U      /* 1, 2, 4 ... CTRL_MAX_DIVIDER */
+#define CHECK_TOLERANCE           1e-4
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Divider;
+  uint32_t Ticks;
+  float    Dt;                /* Dt passed on the last update              */
+  float    Value;             /* Returned on the last update               */
+  double   From;              /* Reference ramp: start value               */
+  double   To;                /*                 end value                 */
+  uint32_t Start;             /*                 first sample              */
+  const CTRL_NodeTypeDef *pSource;  /* Node read by this one, or NULL      */
+  float    Seen;              /* Source value read on the last update      */
+} CHECK_ContextTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static CTRL_HandleTypeDef Ctrl;
+static CTRL_NodeTypeDef Nodes[CTRL_MAX_NODES];
+static CHECK_ContextTypeDef Contexts[CTRL_MAX_NODES];
+static uint32_t Block;
+
+/* Private functions ---------------------------------------------------------*/
+static float CHECK_Tick(void *Context, float Dt)
+{
+  CHECK_ContextTypeDef *c = Context;
+
+  c->Ticks++;
+  c->Dt = Dt;
+  if (c->pSource != NULL)
+  {
+    c->Seen  = c->pSource->Target;
+    c->Value = c->Seen * 0.5f;
+  }
+  else
+  {
+    c->Value = (float)(rand() % 2001 - 1000) / 100.0f;
+  }
+  return c->Value;
+}
+
+static float CHECK_Flat(void *Context, float Dt)
+{
+  (void)Context;
+  (void)Dt;
+  return 0.0f;
+}
+
+static int CHECK_Timeline(uint32_t Blocks)
+{
+  float out[AUDIO_BLOCK_SIZE];
+  float last[CHECK_DIVIDERS + 1U];
+  uint32_t count = CHECK_DIVIDERS + 1U;
+  uint32_t i;
+  uint32_t n;
+  uint32_t s;
+
+  CTRL_Init(&Ctrl);
+  memset(Contexts, 0, sizeof(Contexts));
+  for (i = 0U; i < count; i++)
+  {
+    CHECK_ContextTypeDef *c = &Contexts[i];
+
+    /* The last node halves the fastest one, updated earlier in the same block */
+    c->Divider = (i < CHECK_DIVIDERS) ? (1U << i) : CTRL_MAX_DIVIDER;
+    c->pSource = (i < CHECK_DIVIDERS) ? NULL : &Nodes[0];
+    c->From    = 0.25;
+    c->To      = 0.25;
+    (void)CTRL_AddNode(&Ctrl, &Nodes[i], CHECK_Tick, c, c->Divider, 1U, 0.25f);
+    last[i] = 0.25f;
+  }
+
+  for (Block = 0U; Block < Blocks; Block++)
+  {
+    uint32_t ticks[CHECK_DIVIDERS + 1U];
+
+    for (i = 0U; i < count; i++)
+    {
+      ticks[i] = Contexts[i].Ticks;
+    }
+    CTRL_Process(&Ctrl);
+
+    for (i = 0U; i < count; i++)
+    {
+      CHECK_ContextTypeDef *c = &Contexts[i];
+      const CTRL_NodeTypeDef *node = &Nodes[i];
+      uint32_t due = ((Block & (c->Divider - 1U)) == node->Phase) ? 1U : 0U;
+
+      if (c->Ticks - ticks[i] != due)
+      {
+        printf("divider %u: %u updates at block %u, expected %u\n", c->Divider,
+               c->Ticks - ticks[i], Block, due);
+        return 1;
+      }
+      if (due != 0U)
+      {
+        if (fabsf(c->Dt - (float)c->Divider * AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE) > 1e-7f)
+        {
+          printf("divider %u: Dt %g\n", c->Divider, c->Dt);
+          return 1;
+        }
+        if ((c->pSource != NULL) && (c->Seen != Contexts[0].Value))
+        {
+          printf("chained node read %g at block %u, its source returned %g\n", c->Seen, Block,
+                 Contexts[0].Value);
+          return 1;
+        }
+        /* The previous ramp has ended by now: the new one starts from its end */
+        c->From  = c->To;
+        c->To    = c->Value;
+        c->Start = Block * AUDIO_BLOCK_SIZE;
+      }
+
+      if (fabs(CTRL_GetValue(node) - last[i]) > CHECK_TOLERANCE)
+      {
+        printf("divider %u: value %g at block %u, last sample %g\n", c->Divider,
+               CTRL_GetValue(node), Block, last[i]);
+        return 1;
+      }
+      CTRL_Render(node, out, AUDIO_BLOCK_SIZE);
+      for (n = 0U; n < AUDIO_BLOCK_SIZE; n++)
+      {
+        double want;
+
+        s = Block * AUDIO_BLOCK_SIZE + n;
+        want = c->To;
+        if (s - c->Start < c->Divider * AUDIO_BLOCK_SIZE)
+        {
+          want = c->From + (c->To - c->From) * (double)(s - c->Start + 1U) /
+                 (double)(c->Divider * AUDIO_BLOCK_SIZE);
+        }
+        if (fabs(out[n] - want) > CHECK_TOLERANCE * AUDIO_MAX(1.0, fabs(want)))
+        {
+          printf("divider %u: sample %u of block %u is %g, expected %g\n", c->Divider, n,
+                 Block, out[n], want);
+          return 1;
+        }
+      }
+      last[i] = out[AUDIO_BLOCK_SIZE - 1U];
+    }
+  }
+  return 0;
+}
+
+static int CHECK_Spread(void)
+{
+  static const struct { uint32_t Divider; uint32_t Count; uint32_t Cost; } mix[] =
+  {
+    { 32U, 9U, 40U }, { 16U, 5U, 25U }, { 8U, 6U, 10U }, { 4U, 3U, 6U }, { 1U, 2U, 3U }
+  };
+  double average = 0.0;
+  uint32_t worst = 0U;
+  uint32_t bound;
+  uint32_t d;
+  uint32_t i;
+  uint32_t k;
+
+  /* Equal nodes of one divider: one per slot */
+  for (d = 1U; d <= CTRL_MAX_DIVIDER; d <<= 1)
+  {
+    CTRL_Init(&Ctrl);
+    for (i = 0U; i < d; i++)
+    {
+      (void)CTRL_AddNode(&Ctrl, &Nodes[i], CHECK_Flat, NULL, d, 7U, 0.0f);
+    }
+    if (CTRL_GetPeakLoad(&Ctrl) != 7U)
+    {
+      printf("%u nodes of divider %u: peak load %u, expected 7\n", d, d, CTRL_GetPeakLoad(&Ctrl));
+      return 1;
+    }
+  }
+
+  /* A mixed set, slowest first */
+  CTRL_Init(&Ctrl);
+  i = 0U;
+  for (k = 0U; k < sizeof(mix) / sizeof(mix[0]); k++)
+  {
+    for (d = 0U; d < mix[k].Count; d++)
+    {
+      (void)CTRL_AddNode(&Ctrl, &Nodes[i++], CHECK_Flat, NULL, mix[k].Divider, mix[k].Cost, 0.0f);
+    }
+    average += (double)(mix[k].Count * mix[k].Cost) / (double)mix[k].Divider;
+    worst = AUDIO_MAX(worst, mix[k].Cost);
+  }
+  bound = (uint32_t)ceil(average) + worst;
+  printf("mixed set: %u nodes, average load %.2f, peak %u, bound %u\n", i, average,
+         CTRL_GetPeakLoad(&Ctrl), bound);
+  return CTRL_GetPeakLoad(&Ctrl) > bound;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  uint32_t blocks = 10000U;
+  uint32_t seed = 1U;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'b': blocks = (uint32_t)atoi(optarg); break;
+      case 's': seed = (uint32_t)atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: ctrl_check [-b blocks] [-s seed]\n");
+        return 2;
+    }
+  }
+
+  srand(seed);
+  failed |= CHECK_Timeline(blocks);
+  if (!failed)
+  {
+    printf("%u blocks, dividers 1 to %u and a chained node: updates and ramps exact\n", blocks,
+           CTRL_MAX_DIVIDER);
+  }
+  failed |= CHECK_Spread();
+  return failed;
+}
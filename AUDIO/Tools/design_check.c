@@ -0,0 +1,509 @@
+/**
+  ******************************************************************************
+  * @file    design_check.c
+  * @brief   Host check of the audio_design.h compile-time designers against
+  *          a double precision reference designer.
+  *
+  *          Every table below is a file-scope const initializer, so building
+  *          the check also proves the macros are constant expressions.
+  *          Checked:
+  *            - the RBJ tuples, at several rates, frequencies, Q and gains,
+  *              against the cookbook formulas evaluated with libm;
+  *            - the Butterworth cascades of order 1 to 8, low and high-pass,
+  *              against the closed-form magnitude of the bilinear
+  *              Butterworth filter, 1 / (1 + (tan(w/2) / tan(w0/2))^2n);
+  *            - the Linkwitz-Riley crossovers of order 2, 4 and 8: each side
+  *              is the squared Butterworth of half the order, and the two
+  *              sides sum to an all-pass (order 2 with the high-pass
+  *              inverted);
+  *            - the windowed-sinc low-pass against a double Blackman-sinc
+  *              design, float taps to the float rounding, Q15 taps
+  *              exactly and Q31 taps within a rounding tie;
+  *            - the half-band: zero taps exactly zero, center exactly 0.5,
+  *              symmetric, unity gain at DC and exactly half at fs/4;
+  *            - the float and Q31 biquad emitters, the Q15 and Q31
+  *              conversions at their rounding and saturation edges, and the
+  *              repeat macros at every length.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o design_check design_check.c -lm
+  *
+  *          Usage:
+  *            design_check [-t tolerance]
+  *
+  *          Defaults: 1e-12 relative error on the RBJ tuples; cascade
+  *          responses are held to 1e-8. The exit status is 1 if any value
+  *          is off.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_biquad.h"
+#include "audio_design.h"
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_FS                  48000
+#define CHECK_FC                  1000
+#define CHECK_POINTS              512U
+#define CHECK_FIR_TAPS            63
+#define CHECK_FIR_FC              4000
+#define CHECK_HB_TAPS             31
+#define CHECK_RESPONSE_TOLERANCE  1e-8    /* Stop bands are ill-conditioned */
+
+/* Tuple of a design macro as six doubles */
+#define CHECK_TUPLE(t)            { DESIGN_EXPAND t }
+
+/* Sections 0 to 3 of a cascade; the check only uses the filter's own */
+#define CHECK_CASCADE(m, n)                                                                   \
+  { CHECK_TUPLE(m(CHECK_FS, CHECK_FC, n, 0)), CHECK_TUPLE(m(CHECK_FS, CHECK_FC, n, 1)),       \
+    CHECK_TUPLE(m(CHECK_FS, CHECK_FC, n, 2)), CHECK_TUPLE(m(CHECK_FS, CHECK_FC, n, 3)) }
+#define CHECK_ORDERS(m)                                                                       \
+  { CHECK_CASCADE(m, 1), CHECK_CASCADE(m, 2), CHECK_CASCADE(m, 3), CHECK_CASCADE(m, 4),       \
+    CHECK_CASCADE(m, 5), CHECK_CASCADE(m, 6), CHECK_CASCADE(m, 7), CHECK_CASCADE(m, 8) }
+
+#define CHECK_INDEX(n, b)         ((n) + (b))
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum
+{
+  CHECK_LOWPASS = 0,
+  CHECK_HIGHPASS,
+  CHECK_BANDPASS,
+  CHECK_NOTCH,
+  CHECK_ALLPASS,
+  CHECK_PEAKING,
+  CHECK_LOWSHELF,
+  CHECK_HIGHSHELF
+} CHECK_RbjTypeDef;
+
+typedef struct
+{
+  CHECK_RbjTypeDef Type;
+  double Fs;
+  double F0;
+  double Q;
+  double Db;
+} CHECK_RbjParamsTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static const char *const RbjNames[] =
+{
+  "low-pass", "high-pass", "band-pass", "notch", "all-pass", "peaking", "low shelf", "high shelf"
+};
+
+/* Each design at the parameters of the matching Params entry */
+static const CHECK_RbjParamsTypeDef Params[] =
+{
+  { CHECK_LOWPASS,   48000.0, 1000.0,  0.707,  0.0 },
+  { CHECK_LOWPASS,   44100.0, 18000.0, 4.0,    0.0 },
+  { CHECK_HIGHPASS,  48000.0, 80.0,    0.5,    0.0 },
+  { CHECK_HIGHPASS,  96000.0, 20.0,    0.707,  0.0 },
+  { CHECK_BANDPASS,  48000.0, 2500.0,  10.0,   0.0 },
+  { CHECK_NOTCH,     48000.0, 50.0,    30.0,   0.0 },
+  { CHECK_ALLPASS,   48000.0, 700.0,   0.3,    0.0 },
+  { CHECK_PEAKING,   48000.0, 250.0,   1.0,   -3.0 },
+  { CHECK_PEAKING,   44100.0, 12000.0, 8.0,   15.0 },
+  { CHECK_LOWSHELF,  48000.0, 120.0,   0.707, -12.0 },
+  { CHECK_LOWSHELF,  48000.0, 3000.0,  2.0,    6.0 },
+  { CHECK_HIGHSHELF, 48000.0, 8000.0,  0.707,  2.0 },
+  { CHECK_HIGHSHELF, 44100.0, 500.0,   0.5,  -20.0 }
+};
+
+static const double Rbj[][6] =
+{
+  CHECK_TUPLE(DESIGN_RBJ_LOWPASS(48000, 1000, 0.707)),
+  CHECK_TUPLE(DESIGN_RBJ_LOWPASS(44100, 18000, 4.0)),
+  CHECK_TUPLE(DESIGN_RBJ_HIGHPASS(48000, 80, 0.5)),
+  CHECK_TUPLE(DESIGN_RBJ_HIGHPASS(96000, 20, 0.707)),
+  CHECK_TUPLE(DESIGN_RBJ_BANDPASS(48000, 2500, 10.0)),
+  CHECK_TUPLE(DESIGN_RBJ_NOTCH(48000, 50, 30.0)),
+  CHECK_TUPLE(DESIGN_RBJ_ALLPASS(48000, 700, 0.3)),
+  CHECK_TUPLE(DESIGN_RBJ_PEAKING(48000, 250, 1.0, -3.0)),
+  CHECK_TUPLE(DESIGN_RBJ_PEAKING(44100, 12000, 8.0, 15.0)),
+  CHECK_TUPLE(DESIGN_RBJ_LOWSHELF(48000, 120, 0.707, -12.0)),
+  CHECK_TUPLE(DESIGN_RBJ_LOWSHELF(48000, 3000, 2.0, 6.0)),
+  CHECK_TUPLE(DESIGN_RBJ_HIGHSHELF(48000, 8000, 0.707, 2.0)),
+  CHECK_TUPLE(DESIGN_RBJ_HIGHSHELF(44100, 500, 0.5, -20.0))
+};
+
+/* The emitters, on the first peaking and high shelf entries */
+static const BIQUAD_CoeffsTypeDef Emitted[2] =
+{
+  DESIGN_BIQUAD(DESIGN_RBJ_PEAKING(48000, 250, 1.0, -3.0)),
+  DESIGN_BIQUAD(DESIGN_RBJ_HIGHSHELF(48000, 8000, 0.707, 2.0))
+};
+static const int32_t EmittedQ31[2][5] =
+{
+  { DESIGN_BIQUAD_Q31(DESIGN_RBJ_PEAKING(48000, 250, 1.0, -3.0), 1) },
+  { DESIGN_BIQUAD_Q31(DESIGN_RBJ_HIGHSHELF(48000, 8000, 0.707, 2.0), 1) }
+};
+
+static const double ButterLp[8][4][6] = CHECK_ORDERS(DESIGN_BUTTERWORTH_LOWPASS);
+static const double ButterHp[8][4][6] = CHECK_ORDERS(DESIGN_BUTTERWORTH_HIGHPASS);
+static const double LinkwitzLp[3][4][6] =
+{
+  CHECK_CASCADE(DESIGN_LINKWITZ_LOWPASS, 2), CHECK_CASCADE(DESIGN_LINKWITZ_LOWPASS, 4),
+  CHECK_CASCADE(DESIGN_LINKWITZ_LOWPASS, 8)
+};
+static const double LinkwitzHp[3][4][6] =
+{
+  CHECK_CASCADE(DESIGN_LINKWITZ_HIGHPASS, 2), CHECK_CASCADE(DESIGN_LINKWITZ_HIGHPASS, 4),
+  CHECK_CASCADE(DESIGN_LINKWITZ_HIGHPASS, 8)
+};
+static const int LinkwitzOrders[3] = { 2, 4, 8 };
+static const int LinkwitzSections[3] =
+{
+  DESIGN_LINKWITZ_SECTIONS(2), DESIGN_LINKWITZ_SECTIONS(4), DESIGN_LINKWITZ_SECTIONS(8)
+};
+
+static const float Lowpass[CHECK_FIR_TAPS] =
+  { DESIGN_REPEAT_63(DESIGN_FIR_LOWPASS, CHECK_FIR_TAPS, CHECK_FS, CHECK_FIR_FC) };
+static const int16_t LowpassQ15[CHECK_FIR_TAPS] =
+  { DESIGN_REPEAT_63(DESIGN_AS_Q15, DESIGN_FIR_LOWPASS, CHECK_FIR_TAPS, CHECK_FS, CHECK_FIR_FC) };
+static const int32_t LowpassQ31[CHECK_FIR_TAPS] =
+  { DESIGN_REPEAT_63(DESIGN_AS_Q31, DESIGN_FIR_LOWPASS, CHECK_FIR_TAPS, CHECK_FS, CHECK_FIR_FC) };
+static const float Halfband[CHECK_HB_TAPS] = { DESIGN_REPEAT_31(DESIGN_FIR_HALFBAND, CHECK_HB_TAPS) };
+
+/* Conversions at their edges, with the values they must give */
+static const int16_t Q15[] =
+{
+  DESIGN_Q15(1.0), DESIGN_Q15(32767.0 / 32768.0), DESIGN_Q15(-1.0), DESIGN_Q15(-3.0),
+  DESIGN_Q15(0.5), DESIGN_Q15(0.5 / 32768.0), DESIGN_Q15(-0.5 / 32768.0), DESIGN_Q15(-1.5 / 32768.0),
+  DESIGN_Q15(0.49 / 32768.0)
+};
+static const int16_t Q15Want[] = { 32767, 32767, -32768, -32768, 16384, 1, 0, -1, 0 };
+static const int32_t Q31[] =
+{
+  DESIGN_Q31(1.0), DESIGN_Q31(2.0), DESIGN_Q31(-1.0), DESIGN_Q31(-1.0000001), DESIGN_Q31(0.25),
+  DESIGN_Q31(0.5 / 2147483648.0), DESIGN_Q31(-1.5 / 2147483648.0)
+};
+static const int32_t Q31Want[] = { 2147483647, 2147483647, -2147483647 - 1, -2147483647 - 1,
+                                   536870912, 1, -1 };
+
+static const int Rep7[7]     = { DESIGN_REPEAT_7(CHECK_INDEX, 0) };
+static const int Rep8[8]     = { DESIGN_REPEAT_8(CHECK_INDEX, 0) };
+static const int Rep15[15]   = { DESIGN_REPEAT_15(CHECK_INDEX, 0) };
+static const int Rep16[16]   = { DESIGN_REPEAT_16(CHECK_INDEX, 0) };
+static const int Rep31[31]   = { DESIGN_REPEAT_31(CHECK_INDEX, 0) };
+static const int Rep32[32]   = { DESIGN_REPEAT_32(CHECK_INDEX, 0) };
+static const int Rep63[63]   = { DESIGN_REPEAT_63(CHECK_INDEX, 0) };
+static const int Rep64[64]   = { DESIGN_REPEAT_64(CHECK_INDEX, 0) };
+static const int Rep127[127] = { DESIGN_REPEAT_127(CHECK_INDEX, 0) };
+static const int Rep128[128] = { DESIGN_REPEAT_128(CHECK_INDEX, 0) };
+
+/* Private functions ---------------------------------------------------------*/
+/* The cookbook, as written in it */
+static void CHECK_Cookbook(const CHECK_RbjParamsTypeDef *pP, double *pT)
+{
+  double A = pow(10.0, pP->Db / 40.0);
+  double w0 = 2.0 * M_PI * pP->F0 / pP->Fs;
+  double cw = cos(w0);
+  double alpha = sin(w0) / (2.0 * pP->Q);
+  double sa = 2.0 * sqrt(A) * alpha;
+
+  switch (pP->Type)
+  {
+    case CHECK_LOWPASS:
+      pT[0] = (1.0 - cw) / 2.0; pT[1] = 1.0 - cw; pT[2] = (1.0 - cw) / 2.0;
+      pT[3] = 1.0 + alpha; pT[4] = -2.0 * cw; pT[5] = 1.0 - alpha;
+      break;
+    case CHECK_HIGHPASS:
+      pT[0] = (1.0 + cw) / 2.0; pT[1] = -(1.0 + cw); pT[2] = (1.0 + cw) / 2.0;
+      pT[3] = 1.0 + alpha; pT[4] = -2.0 * cw; pT[5] = 1.0 - alpha;
+      break;
+    case CHECK_BANDPASS:
+      pT[0] = alpha; pT[1] = 0.0; pT[2] = -alpha;
+      pT[3] = 1.0 + alpha; pT[4] = -2.0 * cw; pT[5] = 1.0 - alpha;
+      break;
+    case CHECK_NOTCH:
+      pT[0] = 1.0; pT[1] = -2.0 * cw; pT[2] = 1.0;
+      pT[3] = 1.0 + alpha; pT[4] = -2.0 * cw; pT[5] = 1.0 - alpha;
+      break;
+    case CHECK_ALLPASS:
+      pT[0] = 1.0 - alpha; pT[1] = -2.0 * cw; pT[2] = 1.0 + alpha;
+      pT[3] = 1.0 + alpha; pT[4] = -2.0 * cw; pT[5] = 1.0 - alpha;
+      break;
+    case CHECK_PEAKING:
+      pT[0] = 1.0 + alpha * A; pT[1] = -2.0 * cw; pT[2] = 1.0 - alpha * A;
+      pT[3] = 1.0 + alpha / A; pT[4] = -2.0 * cw; pT[5] = 1.0 - alpha / A;
+      break;
+    case CHECK_LOWSHELF:
+      pT[0] = A * ((A + 1.0) - (A - 1.0) * cw + sa);
+      pT[1] = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw);
+      pT[2] = A * ((A + 1.0) - (A - 1.0) * cw - sa);
+      pT[3] = (A + 1.0) + (A - 1.0) * cw + sa;
+      pT[4] = -2.0 * ((A - 1.0) + (A + 1.0) * cw);
+      pT[5] = (A + 1.0) + (A - 1.0) * cw - sa;
+      break;
+    default:
+      pT[0] = A * ((A + 1.0) + (A - 1.0) * cw + sa);
+      pT[1] = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw);
+      pT[2] = A * ((A + 1.0) + (A - 1.0) * cw - sa);
+      pT[3] = (A + 1.0) - (A - 1.0) * cw + sa;
+      pT[4] = 2.0 * ((A - 1.0) - (A + 1.0) * cw);
+      pT[5] = (A + 1.0) - (A - 1.0) * cw - sa;
+      break;
+  }
+}
+
+/* Relative error of a tuple, normalized by a0 on both sides */
+static double CHECK_TupleError(const double *pGot, const double *pWant)
+{
+  double err = 0.0;
+  uint32_t i;
+
+  for (i = 0U; i < 6U; i++)
+  {
+    double g = pGot[i] / pGot[3];
+    double w = pWant[i] / pWant[3];
+
+    err = AUDIO_MAX(err, fabs(g - w) / AUDIO_MAX(fabs(w), 1.0));
+  }
+  return err;
+}
+
+static double complex CHECK_Response(const double *pT, double W)
+{
+  double complex z1 = cexp(-I * W);
+  double complex z2 = z1 * z1;
+
+  return (pT[0] + pT[1] * z1 + pT[2] * z2) / (pT[3] + pT[4] * z1 + pT[5] * z2);
+}
+
+static double complex CHECK_Cascade(const double (*pT)[6], int Sections, double W)
+{
+  double complex h = 1.0;
+  int k;
+
+  for (k = 0; k < Sections; k++)
+  {
+    h *= CHECK_Response(pT[k], W);
+  }
+  return h;
+}
+
+/* Frequency of point i, 10 Hz to 0.99 Nyquist, log spaced */
+static double CHECK_W(uint32_t i)
+{
+  double f = 10.0 * pow(0.99 * CHECK_FS / 2.0 / 10.0, (double)i / (double)(CHECK_POINTS - 1U));
+
+  return 2.0 * M_PI * f / CHECK_FS;
+}
+
+static int CHECK_Rbj(double Tolerance)
+{
+  int failed = 0;
+  uint32_t i;
+
+  for (i = 0U; i < sizeof(Params) / sizeof(Params[0]); i++)
+  {
+    double want[6];
+    double err;
+
+    CHECK_Cookbook(&Params[i], want);
+    err = CHECK_TupleError(Rbj[i], want);
+    if (err > Tolerance)
+    {
+      printf("rbj %s, %.0f Hz at %.0f Hz: off by %.2e\n", RbjNames[Params[i].Type], Params[i].F0,
+             Params[i].Fs, err);
+      failed = 1;
+    }
+  }
+  printf("rbj: %u designs against the cookbook, limit %.0e\n",
+         (uint32_t)(sizeof(Params) / sizeof(Params[0])), Tolerance);
+  return failed;
+}
+
+static int CHECK_Emitters(void)
+{
+  const uint32_t rows[2] = { 7U, 11U };    /* Params entries of Emitted */
+  int failed = 0;
+  uint32_t r;
+  uint32_t i;
+
+  for (r = 0U; r < 2U; r++)
+  {
+    const float *got = &Emitted[r].b0;
+    const uint32_t from[5] = { 0U, 1U, 2U, 4U, 5U };
+    double want[6];
+
+    CHECK_Cookbook(&Params[rows[r]], want);
+    for (i = 0U; i < 5U; i++)
+    {
+      double c = want[from[i]] / want[3];
+      double q = floor(c / 2.0 * 2147483648.0 + 0.5);
+
+      /* One float rounding; Q31 at half scale, exact but for a tie */
+      failed |= (fabs((double)got[i] - c) > ldexp(fabs(c), -24));
+      failed |= (fabs((double)EmittedQ31[r][i] - q) > 1.0);
+    }
+  }
+  for (i = 0U; i < sizeof(Q15) / sizeof(Q15[0]); i++)
+  {
+    failed |= (Q15[i] != Q15Want[i]);
+  }
+  for (i = 0U; i < sizeof(Q31) / sizeof(Q31[0]); i++)
+  {
+    failed |= (Q31[i] != Q31Want[i]);
+  }
+  printf("emitters: float and Q31 biquads, Q15 and Q31 edges %s\n", failed ? "off" : "exact");
+  return failed;
+}
+
+static int CHECK_Butterworth(void)
+{
+  double t0 = tan(M_PI * CHECK_FC / CHECK_FS);
+  double worst = 0.0;
+  int n;
+  uint32_t i;
+
+  for (n = 1; n <= 8; n++)
+  {
+    for (i = 0U; i < CHECK_POINTS; i++)
+    {
+      double w = CHECK_W(i);
+      double r = pow(tan(w / 2.0) / t0, 2.0 * n);
+      double lp = cabs(CHECK_Cascade(ButterLp[n - 1], DESIGN_BUTTERWORTH_SECTIONS(n), w));
+      double hp = cabs(CHECK_Cascade(ButterHp[n - 1], DESIGN_BUTTERWORTH_SECTIONS(n), w));
+
+      worst = AUDIO_MAX(worst, fabs(lp * lp * (1.0 + r) - 1.0));
+      worst = AUDIO_MAX(worst, fabs(hp * hp * (1.0 + 1.0 / r) - 1.0));
+    }
+  }
+  printf("butterworth: orders 1 to 8, worst power error %.2e against the closed form, "
+         "limit %.0e\n", worst, CHECK_RESPONSE_TOLERANCE);
+  return worst > CHECK_RESPONSE_TOLERANCE;
+}
+
+static int CHECK_Linkwitz(void)
+{
+  double t0 = tan(M_PI * CHECK_FC / CHECK_FS);
+  double worst = 0.0;
+  uint32_t o;
+  uint32_t i;
+
+  for (o = 0U; o < 3U; o++)
+  {
+    int n = LinkwitzOrders[o];
+    double sign = (n == 2) ? -1.0 : 1.0;
+
+    for (i = 0U; i < CHECK_POINTS; i++)
+    {
+      double w = CHECK_W(i);
+      double r = pow(tan(w / 2.0) / t0, (double)n);
+      double complex lp = CHECK_Cascade(LinkwitzLp[o], LinkwitzSections[o], w);
+      double complex hp = CHECK_Cascade(LinkwitzHp[o], LinkwitzSections[o], w);
+
+      worst = AUDIO_MAX(worst, fabs(cabs(lp) * (1.0 + r) - 1.0));
+      worst = AUDIO_MAX(worst, fabs(cabs(hp) * (1.0 + 1.0 / r) - 1.0));
+      worst = AUDIO_MAX(worst, fabs(cabs(lp + sign * hp) - 1.0));
+    }
+  }
+  printf("linkwitz-riley: orders 2, 4 and 8, worst error %.2e in magnitude and all-pass sum, "
+         "limit %.0e\n", worst, CHECK_RESPONSE_TOLERANCE);
+  return worst > CHECK_RESPONSE_TOLERANCE;
+}
+
+static int CHECK_Fir(void)
+{
+  double hb1 = 0.0;
+  double hb4 = 0.0;
+  int failed = 0;
+  int fc = (CHECK_HB_TAPS - 1) / 2;
+  int n;
+
+  for (n = 0; n < CHECK_FIR_TAPS; n++)
+  {
+    double m = (double)n - (CHECK_FIR_TAPS - 1) / 2.0;
+    double x = 2.0 * CHECK_FIR_FC / CHECK_FS * m;
+    double win = 0.42 - 0.5 * cos(2.0 * M_PI * n / (CHECK_FIR_TAPS - 1)) +
+                 0.08 * cos(4.0 * M_PI * n / (CHECK_FIR_TAPS - 1));
+    double h = 2.0 * CHECK_FIR_FC / CHECK_FS * ((x == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x)) * win;
+    double q15 = AUDIO_CLAMP(floor(h * 32768.0 + 0.5), -32768.0, 32767.0);
+    double q31 = AUDIO_CLAMP(floor(h * 2147483648.0 + 0.5), -2147483648.0, 2147483647.0);
+
+    failed |= (fabs((double)Lowpass[n] - h) > ldexp(fabs(h), -24));
+    failed |= (LowpassQ15[n] != (int16_t)q15) || (fabs((double)LowpassQ31[n] - q31) > 1.0);
+  }
+  printf("fir low-pass: %d taps against a double windowed sinc %s\n", CHECK_FIR_TAPS,
+         failed ? "off" : "to the float rounding, Q15 exact, Q31 within a tie");
+
+  for (n = 0; n < CHECK_HB_TAPS; n++)
+  {
+    int m = n - fc;
+
+    failed |= (Halfband[n] != Halfband[CHECK_HB_TAPS - 1 - n]);
+    failed |= (m == 0) ? (Halfband[n] != 0.5f) : ((m % 2 == 0) && (Halfband[n] != 0.0f));
+    hb1 += Halfband[n];
+    hb4 += Halfband[n] * cos(M_PI / 2.0 * m);
+  }
+  printf("fir half-band: %d taps, DC gain %.6f, gain at fs/4 %.9f\n", CHECK_HB_TAPS, hb1, hb4);
+  failed |= (fabs(hb1 - 1.0) > 1e-3) || (fabs(hb4 - 0.5) > 1e-9);
+  return failed;
+}
+
+static int CHECK_Repeat(void)
+{
+  const struct { const int *pTable; int Length; } tables[] =
+  {
+    { Rep7, 7 }, { Rep8, 8 }, { Rep15, 15 }, { Rep16, 16 }, { Rep31, 31 }, { Rep32, 32 },
+    { Rep63, 63 }, { Rep64, 64 }, { Rep127, 127 }, { Rep128, 128 }
+  };
+  int failed = 0;
+  uint32_t t;
+  int n;
+
+  for (t = 0U; t < sizeof(tables) / sizeof(tables[0]); t++)
+  {
+    for (n = 0; n < tables[t].Length; n++)
+    {
+      failed |= (tables[t].pTable[n] != n);
+    }
+  }
+  printf("repeat: lengths 7 to 128 %s\n", failed ? "out of order" : "in order");
+  return failed;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  double tolerance = 1e-12;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': tolerance = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: design_check [-t tolerance]\n");
+        return 2;
+    }
+  }
+  if (tolerance <= 0.0)
+  {
+    fprintf(stderr, "design_check: bad tolerance\n");
+    return 2;
+  }
+
+  failed |= CHECK_Rbj(tolerance);
+  failed |= CHECK_Emitters();
+  failed |= CHECK_Butterworth();
+  failed |= CHECK_Linkwitz();
+  failed |= CHECK_Fir();
+  failed |= CHECK_Repeat();
+  return failed;
+}
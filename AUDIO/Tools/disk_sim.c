@@ -0,0 +1,804 @@
+/**
+  ******************************************************************************
+  * @file    disk_sim.c
+  * @brief   Host simulation of the SD I/O scheduler (audio_disk.c) shared by
+  *          all card users, over a card image.
+  *
+  *          The image is loaded into memory, with a recording area appended
+  *          past its end; the file itself is never written. The card answers
+  *          each transfer after a latency drawn from a model of a real card:
+  *          reads as in stream_sim, writes with a longer program time and
+  *          occasional stalls while the card erases. Four users share it
+  *          through one scheduler:
+  *           - index: the library index is built through the scheduler at
+  *             start, one sector at a time, and rebuilt during playback
+  *             with -i, as from a task of its own, and must come out equal;
+  *           - streaming voices (audio_stream.c) play the mono 16-bit
+  *             samples of the image, checked sample for sample against it,
+  *             their reads due by the slack of the neediest voice;
+  *           - the recorder writes a stereo 16-bit take in chunks from a
+  *             ring of slots, each due before the ring wraps round to it,
+  *             and the take is checked at the end (-V also reads each chunk
+  *             back right after its write, which must not overtake it);
+  *           - the preset loader reads bursts of single sectors, checked
+  *             against the image, for the scheduler to coalesce, and saves
+  *             a preset now and then: one write without a deadline, which
+  *             must land within the scheduler's longest hold (-M) whatever
+  *             the voices do, and is checked at the end.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o disk_sim disk_sim.c \
+  *                ../Core/Src/audio_disk.c ../Core/Src/audio_stream.c \
+  *                ../Core/Src/audio_voice.c ../Core/Src/audio_library.c -lm
+  *
+  *          Usage:
+  *            disk_sim [-t seconds] [-v voices] [-H head ms] [-n mean note ms]
+  *                     [-l median read ms] [-j latency spread]
+  *                     [-p pause probability] [-s longest pause ms]
+  *                     [-b MB/s] [-W median write ms] [-E stall probability]
+  *                     [-e longest stall ms] [-C chunk sectors] [-K slots]
+  *                     [-P mean preset interval s] [-L preset KB]
+  *                     [-D preset deadline ms] [-S mean save interval s]
+  *                     [-M longest write hold ms] [-i rebuild at s] [-V] [-T]
+  *                     [-w limit ms] [-u limit %] [-r seed] card.img
+  *
+  *          Preset reads are due within -D, 0 for no deadline. -T turns
+  *          the write throttle off, to see what it buys: with the defaults,
+  *          voices then starve about one and a half to twice as long,
+  *          mostly behind writes caught in an erase stall. The exit status is 1 if any user got
+  *          wrong data, a save took longer than its hold and two writes,
+  *          or a voice starved longer than -w (75 ms) or for more than -u
+  *          (0.9%) of voice time. Erase stalls of up to 60 ms are more than
+  *          a 4096-sample ring holds at twice the rate, so voices do starve
+  *          with the default card, about 0.3-0.7% of the time; a 2048 ring
+  *          starves twice that.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_disk.h"
+#include "audio_stream.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_DT                    50e-6     /* Background loop period        */
+#define SIM_COMMAND               100e-6    /* Command round trip            */
+#define SIM_INDEX_BYTES           (1024U * 1024U)
+#define SIM_MAX_SLOTS             32U
+#define SIM_MAX_PRESET            256U      /* Sectors in a preset burst     */
+#define SIM_FRAME_BYTES           4U        /* Recorder: stereo 16-bit       */
+#define SIM_SAVE_SECTORS          16U       /* A saved preset, 8 KB          */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  STREAM_SampleTypeDef Stream;
+  int16_t *pHead;
+} SIM_SampleTypeDef;
+
+typedef struct
+{
+  SIM_SampleTypeDef *pSample;
+  double   NextNote;
+  uint32_t Starving;          /* Frames held in the current starvation       */
+} SIM_VoiceTypeDef;
+
+typedef struct
+{
+  DISK_RequestTypeDef Write;
+  DISK_RequestTypeDef Check;
+  uint32_t Chunk;
+  uint8_t *pData;
+  uint8_t *pBack;
+} SIM_SlotTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t *Card;
+static uint32_t CardSectors;
+static uint32_t ImageSectors;
+static DISK_HandleTypeDef Disk;
+static LIBRARY_BuilderTypeDef Builder;
+static LIBRARY_HandleTypeDef Library;
+static uint32_t *Index;
+static uint32_t IndexSize;
+static STREAM_HandleTypeDef Stream;
+static DISK_RequestTypeDef StreamRequest;
+static SIM_SampleTypeDef Samples[STREAM_MAX_SAMPLES];
+static uint32_t NumSamples;
+static VOICE_HandleTypeDef Voices[STREAM_MAX_VOICES];
+static SIM_VoiceTypeDef VoiceState[STREAM_MAX_VOICES];
+static uint32_t NumVoices = 16U;
+static uint8_t Streaming;
+static uint8_t Playing;
+
+/* Card model */
+static double Now;
+static double MedianSec = 0.35e-3;
+static double Spread = 0.5;
+static double PauseProb = 0.002;
+static double PauseSec = 25e-3;
+static double BytesPerSec = 10e6;
+static double WriteSec = 1.5e-3;
+static double StallProb = 0.02;
+static double StallSec = 60e-3;
+static double CompleteAt = -1.0;
+static double BusySec;
+static uint8_t NoThrottle;
+
+/* Audio */
+static const double Rates[] = { 1.0, 1.0, 1.0, 0.5, 1.5, 2.0 };
+static double NoteSec = 0.3;
+static double NextBlock;
+static uint32_t Notes;
+static uint32_t Mismatches;
+static uint32_t Episodes;
+static uint32_t Worst;
+static uint64_t Starved;
+static uint64_t Sounding;
+
+/* Recorder */
+static SIM_SlotTypeDef Slots[SIM_MAX_SLOTS];
+static uint32_t NumSlots = 8U;
+static uint32_t ChunkSectors = 8U;
+static uint32_t RecLba;
+static uint32_t RecChunks;
+static uint64_t RecBytes;
+static uint8_t *Lost;
+static uint32_t Overruns;
+static uint8_t CheckWrites;
+static uint32_t CheckErrors;
+
+/* Preset loader */
+static DISK_RequestTypeDef PresetRequests[SIM_MAX_PRESET];
+static uint8_t *PresetData;
+static uint32_t PresetSectors = 128U;
+static uint32_t PresetPending;
+static double PresetMeanSec = 2.0;
+static double PresetDeadlineMs = 500.0;
+static double NextPreset;
+static double PresetStart;
+static uint32_t Presets;
+static uint32_t PresetErrors;
+static double PresetTotalSec;
+static double PresetWorstSec;
+
+/* Preset saver */
+static DISK_RequestTypeDef SaveRequest;
+static uint8_t *SaveData;
+static uint32_t SaveLba;
+static double SaveMeanSec = 1.0;
+static double NextSave;
+static double SaveStart;
+static uint32_t Saves;
+static uint32_t SaveErrors;
+static double SaveWorstSec;
+static double MaxHoldMs;
+
+/* Private functions ---------------------------------------------------------*/
+static double SIM_Uniform(void)
+{
+  return ((double)rand() + 0.5) / ((double)RAND_MAX + 1.0);
+}
+
+static double SIM_Gauss(void)
+{
+  return sqrt(-2.0 * log(SIM_Uniform())) * cos(6.283185307179586 * SIM_Uniform());
+}
+
+/* Byte i of the recorded take */
+static uint8_t SIM_RecValue(uint64_t Index)
+{
+  uint32_t x = (uint32_t)Index * 2654435761U;
+
+  return (uint8_t)((x >> 24) ^ (uint32_t)(Index >> 32));
+}
+
+/* Sample i of a library entry, as stored in the image */
+static int16_t SIM_Expected(const LIBRARY_EntryTypeDef *pEntry, uint32_t Index)
+{
+  uint8_t b[2];
+  uint32_t k;
+
+  for (k = 0U; k < 2U; k++)
+  {
+    uint32_t byte = pEntry->DataOffset + (Index * 2U) + k;
+    uint32_t lba;
+
+    (void)LIBRARY_Locate(&Library, pEntry, byte, &lba);
+    b[k] = Card[((size_t)lba * DISK_SECTOR_SIZE) + (byte % DISK_SECTOR_SIZE)];
+  }
+  return (int16_t)((uint16_t)b[0] | ((uint16_t)b[1] << 8));
+}
+
+static uint32_t SIM_Now(void *Context)
+{
+  (void)Context;
+  return (uint32_t)(uint64_t)(Now * 1e6);
+}
+
+static AUDIO_StatusTypeDef SIM_Transfer(void *Context, uint8_t Write, uint32_t Lba, uint32_t Count,
+                                        uint8_t *pBuffer)
+{
+  double latency;
+  uint8_t *at = &Card[(size_t)Lba * DISK_SECTOR_SIZE];
+
+  (void)Context;
+  if (((Lba + Count) > CardSectors) || (CompleteAt >= 0.0) || (((uintptr_t)pBuffer & 3U) != 0U))
+  {
+    return AUDIO_ERROR;
+  }
+  if (Write != 0U)
+  {
+    latency = WriteSec * exp(Spread * SIM_Gauss());
+    if (SIM_Uniform() < StallProb)
+    {
+      latency += StallSec * (0.25 + 0.75 * SIM_Uniform());
+    }
+    memcpy(at, pBuffer, (size_t)Count * DISK_SECTOR_SIZE);
+  }
+  else
+  {
+    latency = MedianSec * exp(Spread * SIM_Gauss());
+    if (SIM_Uniform() < PauseProb)
+    {
+      latency += PauseSec * (0.25 + 0.75 * SIM_Uniform());
+    }
+    memcpy(pBuffer, at, (size_t)Count * DISK_SECTOR_SIZE);
+  }
+  latency += SIM_COMMAND + (Count * DISK_SECTOR_SIZE) / BytesPerSec;
+  CompleteAt = Now + latency;
+  BusySec += latency;
+  return AUDIO_OK;
+}
+
+static void SIM_StreamDone(void *Context, DISK_RequestTypeDef *pRequest)
+{
+  (void)Context;
+  STREAM_ReadComplete(&Stream, pRequest->Status);
+}
+
+static AUDIO_StatusTypeDef SIM_StreamRead(void *Context, uint32_t Lba, uint32_t Count, uint8_t *pDst,
+                                          uint32_t SlackUs)
+{
+  (void)Context;
+  StreamRequest.Lba = Lba;
+  StreamRequest.Count = Count;
+  StreamRequest.pBuffer = pDst;
+  StreamRequest.Write = 0U;
+  StreamRequest.DeadlineUs = SlackUs;
+  StreamRequest.Done = SIM_StreamDone;
+  return DISK_Submit(&Disk, &StreamRequest);
+}
+
+static void SIM_StreamExpect(void *Context, uint32_t SlackUs)
+{
+  (void)Context;
+  DISK_Expect(&Disk, SlackUs);
+}
+
+static void SIM_CheckDone(void *Context, DISK_RequestTypeDef *pRequest)
+{
+  SIM_SlotTypeDef *slot = (SIM_SlotTypeDef *)Context;
+
+  if ((pRequest->Status != AUDIO_OK) || (memcmp(slot->pBack, slot->pData, pRequest->Count * DISK_SECTOR_SIZE) != 0))
+  {
+    CheckErrors++;
+  }
+}
+
+static void SIM_PresetDone(void *Context, DISK_RequestTypeDef *pRequest)
+{
+  (void)Context;
+  if ((pRequest->Status != AUDIO_OK)
+      || (memcmp(pRequest->pBuffer, &Card[(size_t)pRequest->Lba * DISK_SECTOR_SIZE], DISK_SECTOR_SIZE) != 0))
+  {
+    PresetErrors++;
+  }
+  if (--PresetPending == 0U)
+  {
+    double took = Now - PresetStart;
+
+    PresetTotalSec += took;
+    PresetWorstSec = AUDIO_MAX(PresetWorstSec, took);
+  }
+}
+
+static void SIM_SaveDone(void *Context, DISK_RequestTypeDef *pRequest)
+{
+  (void)Context;
+  if (pRequest->Status != AUDIO_OK)
+  {
+    SaveErrors++;
+  }
+  SaveWorstSec = AUDIO_MAX(SaveWorstSec, Now - SaveStart);
+}
+
+/* Audio interrupt: notes, each voice rendered and checked alone, recorder */
+static void SIM_Audio(void)
+{
+  static float left[AUDIO_BLOCK_SIZE];
+  static float right[AUDIO_BLOCK_SIZE];
+  uint32_t chunkBytes = ChunkSectors * DISK_SECTOR_SIZE;
+  uint32_t v;
+  uint32_t i;
+
+  for (v = 0U; v < NumVoices; v++)
+  {
+    VOICE_HandleTypeDef *hvoice = &Voices[v];
+    SIM_VoiceTypeDef *state = &VoiceState[v];
+    const LIBRARY_EntryTypeDef *entry;
+    uint64_t phase;
+    uint32_t underruns;
+    uint32_t rendered;
+
+    if (Now >= state->NextNote)
+    {
+      VOICE_ParamsTypeDef params;
+      double pick = SIM_Uniform() * SIM_Uniform();
+
+      state->pSample = &Samples[(uint32_t)(pick * NumSamples)];
+      memset(&params, 0, sizeof(params));
+      params.Level = 2.0f;
+      params.Rate = (float)Rates[rand() % (int)(sizeof(Rates) / sizeof(Rates[0]))];
+      params.Decay = 1.0f;
+      VOICE_Trigger(hvoice, &state->pSample->Stream.Source, &params);
+      state->NextNote = Now - NoteSec * log(SIM_Uniform());
+      Notes++;
+    }
+    if (VOICE_IsActive(hvoice) == 0U)
+    {
+      continue;
+    }
+
+    memset(left, 0, sizeof(left));
+    memset(right, 0, sizeof(right));
+    entry = state->pSample->Stream.pEntry;
+    phase = hvoice->Phase;
+    underruns = hvoice->Underruns;
+    VOICE_Render(hvoice, left, right, AUDIO_BLOCK_SIZE);
+    rendered = (uint32_t)((hvoice->Phase - phase) / hvoice->Increment);
+    for (i = 0U; i < rendered; i++)
+    {
+      uint32_t idx = (uint32_t)(phase >> 32);
+      float frac = (float)(uint32_t)phase * (1.0f / 4294967296.0f);
+      float s0 = (float)SIM_Expected(entry, idx);
+      float s1 = ((idx + 1U) < entry->Frames) ? (float)SIM_Expected(entry, idx + 1U) : 0.0f;
+      float expect = (s0 + (s1 - s0) * frac) * (1.0f / 32768.0f);
+
+      if (fabsf(left[i] - expect) > 1e-6f)
+      {
+        Mismatches++;
+      }
+      phase += hvoice->Increment;
+    }
+    Sounding += AUDIO_BLOCK_SIZE;
+
+    /* A starvation lasts from the first frame held to the resume */
+    if (hvoice->Underruns != underruns)
+    {
+      state->Starving += hvoice->Underruns - underruns;
+      Starved += hvoice->Underruns - underruns;
+    }
+    else if (state->Starving > 0U)
+    {
+      Episodes++;
+      Worst = AUDIO_MAX(Worst, state->Starving);
+      state->Starving = 0U;
+    }
+  }
+
+  /* Recorder: a chunk goes out as it fills; a slot still busy is an overrun */
+  for (i = 0U; i < (AUDIO_BLOCK_SIZE * SIM_FRAME_BYTES); i++)
+  {
+    uint32_t chunk = (uint32_t)(RecBytes / chunkBytes);
+    uint32_t at = (uint32_t)(RecBytes % chunkBytes);
+    SIM_SlotTypeDef *slot = &Slots[chunk % NumSlots];
+
+    if ((RecLba + ((chunk + 1U) * ChunkSectors)) > CardSectors)
+    {
+      break;
+    }
+    if (at == 0U)
+    {
+      RecChunks = chunk + 1U;
+      if ((slot->Write.Status == AUDIO_BUSY) || (slot->Check.Status == AUDIO_BUSY))
+      {
+        Lost[chunk] = 1U;
+        Overruns++;
+      }
+      slot->Chunk = chunk;
+    }
+    if (Lost[chunk] == 0U)
+    {
+      slot->pData[at] = SIM_RecValue(RecBytes);
+      if (at == (chunkBytes - 1U))
+      {
+        slot->Write.Lba = RecLba + (chunk * ChunkSectors);
+        slot->Write.Count = ChunkSectors;
+        slot->Write.pBuffer = slot->pData;
+        slot->Write.Write = 1U;
+        slot->Write.DeadlineUs = (uint32_t)(((NumSlots - 1U) * (double)chunkBytes * 1e6)
+                                            / (SIM_FRAME_BYTES * AUDIO_SAMPLE_RATE));
+        (void)DISK_Submit(&Disk, &slot->Write);
+        if (CheckWrites != 0U)
+        {
+          slot->Check = slot->Write;
+          slot->Check.pBuffer = slot->pBack;
+          slot->Check.Write = 0U;
+          slot->Check.DeadlineUs = DISK_NO_DEADLINE;
+          slot->Check.Done = SIM_CheckDone;
+          slot->Check.Context = slot;
+          (void)DISK_Submit(&Disk, &slot->Check);
+        }
+      }
+    }
+    RecBytes++;
+  }
+}
+
+/* Preset loader: a burst of single sectors from a random place of the image */
+static void SIM_Preset(void)
+{
+  uint32_t lba = (uint32_t)(SIM_Uniform() * (ImageSectors - PresetSectors));
+  uint32_t i;
+
+  PresetStart = Now;
+  PresetPending = PresetSectors;
+  Presets++;
+  for (i = 0U; i < PresetSectors; i++)
+  {
+    DISK_RequestTypeDef *r = &PresetRequests[i];
+
+    memset(r, 0, sizeof(*r));
+    r->Lba = lba + i;
+    r->Count = 1U;
+    r->pBuffer = &PresetData[i * DISK_SECTOR_SIZE];
+    r->DeadlineUs = (PresetDeadlineMs > 0.0) ? (uint32_t)(PresetDeadlineMs * 1e3) : DISK_NO_DEADLINE;
+    r->Done = SIM_PresetDone;
+    (void)DISK_Submit(&Disk, r);
+  }
+}
+
+/* Preset saver: one write without a deadline, its bytes numbered by save */
+static void SIM_Save(void)
+{
+  uint32_t i;
+
+  Saves++;
+  for (i = 0U; i < (SIM_SAVE_SECTORS * DISK_SECTOR_SIZE); i++)
+  {
+    SaveData[i] = SIM_RecValue(((uint64_t)Saves << 32) + i);
+  }
+  memset(&SaveRequest, 0, sizeof(SaveRequest));
+  SaveRequest.Lba = SaveLba;
+  SaveRequest.Count = SIM_SAVE_SECTORS;
+  SaveRequest.pBuffer = SaveData;
+  SaveRequest.Write = 1U;
+  SaveRequest.DeadlineUs = DISK_NO_DEADLINE;
+  SaveRequest.Done = SIM_SaveDone;
+  SaveStart = Now;
+  (void)DISK_Submit(&Disk, &SaveRequest);
+}
+
+/* One pass of the background loop, with the audio interrupt when due */
+static void SIM_Tick(void)
+{
+  Now += SIM_DT;
+  if ((Playing != 0U) && (Now >= NextBlock))
+  {
+    SIM_Audio();
+    NextBlock += (double)AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE;
+    if ((PresetPending == 0U) && (Now >= NextPreset))
+    {
+      SIM_Preset();
+      NextPreset = Now - PresetMeanSec * log(SIM_Uniform());
+    }
+    if ((SaveRequest.Status != AUDIO_BUSY) && (Now >= NextSave))
+    {
+      SIM_Save();
+      NextSave = Now - SaveMeanSec * log(SIM_Uniform());
+    }
+  }
+  if ((CompleteAt >= 0.0) && (Now >= CompleteAt))
+  {
+    CompleteAt = -1.0;
+    DISK_TransferComplete(&Disk, AUDIO_OK);
+  }
+  if (Streaming != 0U)
+  {
+    STREAM_Poll(&Stream);
+  }
+  DISK_Poll(&Disk);
+}
+
+/* The index builder's sector read: blocking, while the rest runs on */
+static AUDIO_StatusTypeDef SIM_IndexRead(void *Context, uint32_t Lba, uint8_t *pDst)
+{
+  static DISK_RequestTypeDef request;
+  static uint32_t sector[DISK_SECTOR_SIZE / 4U];
+
+  (void)Context;
+  memset(&request, 0, sizeof(request));
+  request.Lba = Lba;
+  request.Count = 1U;
+  request.pBuffer = (uint8_t *)sector;
+  request.DeadlineUs = DISK_NO_DEADLINE;
+  if (DISK_Submit(&Disk, &request) != AUDIO_OK)
+  {
+    return AUDIO_ERROR;
+  }
+  while (request.Status == AUDIO_BUSY)
+  {
+    SIM_Tick();
+  }
+  memcpy(pDst, sector, DISK_SECTOR_SIZE);
+  return request.Status;
+}
+
+static uint32_t SIM_BuildIndex(uint32_t *pImage, uint32_t *pReads)
+{
+  uint32_t before = Disk.Stats[0].Requests;
+  uint32_t size;
+
+  memset(&Builder, 0, sizeof(Builder));
+  Builder.Read = SIM_IndexRead;
+  if (LIBRARY_Build(&Builder, (uint8_t *)pImage, SIM_INDEX_BYTES, &size) != AUDIO_OK)
+  {
+    return 0U;
+  }
+  *pReads = Disk.Stats[0].Requests - before;
+  return size;
+}
+
+int main(int argc, char **argv)
+{
+  double seconds = 30.0;
+  double headMs = 30.0;
+  double rebuildSec = -1.0;
+  double limitMs = 75.0;
+  double limitShare = 0.9;
+  double start;
+  uint32_t *rebuilt = NULL;
+  uint32_t rebuiltSize = 0U;
+  uint32_t indexReads = 0U;
+  uint32_t recErrors = 0U;
+  uint32_t lost = 0U;
+  uint32_t bytes;
+  uint32_t s;
+  uint32_t v;
+  FILE *f;
+  int opt;
+
+  srand(1U);
+  while ((opt = getopt(argc, argv, "t:v:H:n:l:j:p:s:b:W:E:e:C:K:P:L:D:S:M:i:VTw:u:r:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': seconds = atof(optarg); break;
+      case 'v': NumVoices = (uint32_t)AUDIO_CLAMP(atoi(optarg), 0, (int)STREAM_MAX_VOICES); break;
+      case 'H': headMs = atof(optarg); break;
+      case 'n': NoteSec = atof(optarg) * 1e-3; break;
+      case 'l': MedianSec = atof(optarg) * 1e-3; break;
+      case 'j': Spread = atof(optarg); break;
+      case 'p': PauseProb = atof(optarg); break;
+      case 's': PauseSec = atof(optarg) * 1e-3; break;
+      case 'b': BytesPerSec = atof(optarg) * 1e6; break;
+      case 'W': WriteSec = atof(optarg) * 1e-3; break;
+      case 'E': StallProb = atof(optarg); break;
+      case 'e': StallSec = atof(optarg) * 1e-3; break;
+      case 'C': ChunkSectors = (uint32_t)AUDIO_CLAMP(atoi(optarg), 1, (int)DISK_MAX_SECTORS); break;
+      case 'K': NumSlots = (uint32_t)AUDIO_CLAMP(atoi(optarg), 2, (int)SIM_MAX_SLOTS); break;
+      case 'P': PresetMeanSec = atof(optarg); break;
+      case 'L': PresetSectors = (uint32_t)AUDIO_CLAMP(atoi(optarg) * 2, 0, (int)SIM_MAX_PRESET); break;
+      case 'D': PresetDeadlineMs = atof(optarg); break;
+      case 'S': SaveMeanSec = atof(optarg); break;
+      case 'M': MaxHoldMs = atof(optarg); break;
+      case 'i': rebuildSec = atof(optarg); break;
+      case 'V': CheckWrites = 1U; break;
+      case 'T': NoThrottle = 1U; break;
+      case 'w': limitMs = atof(optarg); break;
+      case 'u': limitShare = atof(optarg); break;
+      case 'r': srand((unsigned)atoi(optarg)); break;
+      default: return 2;
+    }
+  }
+  if (optind != (argc - 1))
+  {
+    fprintf(stderr, "usage: disk_sim [options] card.img\n");
+    return 2;
+  }
+
+  /* The image, then room for the take past its end, then the saved preset */
+  f = fopen(argv[optind], "rb");
+  if ((f == NULL) || (fseek(f, 0, SEEK_END) != 0) || (ftell(f) < (long)(DISK_SECTOR_SIZE * SIM_MAX_PRESET)))
+  {
+    fprintf(stderr, "%s: cannot open, or too small\n", argv[optind]);
+    return 2;
+  }
+  ImageSectors = (uint32_t)(ftell(f) / DISK_SECTOR_SIZE);
+  RecLba = (ImageSectors + 63U) & ~63U;
+  SaveLba = RecLba + (uint32_t)(((seconds + 1.0) * SIM_FRAME_BYTES * AUDIO_SAMPLE_RATE) / DISK_SECTOR_SIZE);
+  CardSectors = SaveLba + SIM_SAVE_SECTORS;
+  Card = calloc(CardSectors, DISK_SECTOR_SIZE);
+  Lost = calloc(CardSectors / ChunkSectors, 1U);
+  Index = malloc(SIM_INDEX_BYTES);
+  PresetData = malloc(SIM_MAX_PRESET * DISK_SECTOR_SIZE);
+  SaveData = malloc(SIM_SAVE_SECTORS * DISK_SECTOR_SIZE);
+  rewind(f);
+  if ((Card == NULL) || (Lost == NULL) || (Index == NULL) || (PresetData == NULL) || (SaveData == NULL)
+      || (fread(Card, DISK_SECTOR_SIZE, ImageSectors, f) != ImageSectors))
+  {
+    fprintf(stderr, "%s: cannot read\n", argv[optind]);
+    return 2;
+  }
+  fclose(f);
+  for (s = 0U; s < NumSlots; s++)
+  {
+    Slots[s].pData = malloc(ChunkSectors * DISK_SECTOR_SIZE);
+    Slots[s].pBack = malloc(ChunkSectors * DISK_SECTOR_SIZE);
+    Slots[s].Write.Status = AUDIO_OK;
+    Slots[s].Check.Status = AUDIO_OK;
+  }
+
+  {
+    DISK_ConfigTypeDef cfg = { SIM_Transfer, SIM_Now, NULL, 0U, (uint32_t)(MaxHoldMs * 1e3), NoThrottle };
+    STREAM_ConfigTypeDef scfg = { SIM_StreamRead, SIM_StreamExpect, NULL };
+
+    IndexSize = (DISK_Init(&Disk, &cfg) == AUDIO_OK) ? SIM_BuildIndex(Index, &indexReads) : 0U;
+    if ((IndexSize == 0U) || (LIBRARY_Load(&Library, Index, IndexSize) != AUDIO_OK)
+        || (STREAM_Init(&Stream, &scfg, &Library, Voices, NumVoices) != AUDIO_OK))
+    {
+      fprintf(stderr, "%s: no sample library on the image\n", argv[optind]);
+      return 2;
+    }
+  }
+  printf("card: %.1f MB image, index of %u samples built in %.0f ms from %u sector reads\n",
+         (double)ImageSectors * DISK_SECTOR_SIZE / 1e6, Library.pHeader->NumEntries, Now * 1e3, indexReads);
+
+  /* Every mono 16-bit sample streams */
+  for (s = 0U; (s < Library.pHeader->NumEntries) && (NumSamples < STREAM_MAX_SAMPLES); s++)
+  {
+    const LIBRARY_EntryTypeDef *e = &Library.pEntries[s];
+    uint32_t head = (uint32_t)(headMs * 1e-3 * AUDIO_SAMPLE_RATE);
+    SIM_SampleTypeDef *sample = &Samples[NumSamples];
+
+    if ((e->Format != LIBRARY_FORMAT_PCM16) || (e->Channels != 1U) || (e->Frames < 2U))
+    {
+      continue;
+    }
+    sample->pHead = (head > 0U) ? malloc(head * sizeof(int16_t)) : NULL;
+    if (STREAM_AddSample(&Stream, &sample->Stream, e->Id, sample->pHead, head) == AUDIO_OK)
+    {
+      NumSamples++;
+    }
+  }
+  if (NumSamples == 0U)
+  {
+    fprintf(stderr, "%s: no mono 16-bit samples to stream\n", argv[optind]);
+    return 2;
+  }
+  Streaming = 1U;
+  while (STREAM_IsPreloaded(&Stream) == 0U)
+  {
+    SIM_Tick();
+  }
+  for (v = 0U; v < NumVoices; v++)
+  {
+    VOICE_Init(&Voices[v]);
+    VoiceState[v].NextNote = Now - NoteSec * log(SIM_Uniform());
+  }
+  NextBlock = Now;
+  Playing = 1U;
+  NextPreset = (PresetSectors > 0U) ? Now - PresetMeanSec * log(SIM_Uniform()) : HUGE_VAL;
+  NextSave = (SaveMeanSec > 0.0) ? Now - SaveMeanSec * log(SIM_Uniform()) : HUGE_VAL;
+  SaveRequest.Status = AUDIO_OK;
+
+  start = Now;
+  while ((Now - start) < seconds)
+  {
+    if ((rebuildSec >= 0.0) && ((Now - start) >= rebuildSec) && (rebuilt == NULL))
+    {
+      rebuilt = malloc(SIM_INDEX_BYTES);
+      rebuiltSize = SIM_BuildIndex(rebuilt, &indexReads);
+      if ((rebuiltSize != IndexSize) || (memcmp(rebuilt, Index, IndexSize) != 0))
+      {
+        printf("index rebuilt during playback differs\n");
+        Mismatches++;
+      }
+      continue;
+    }
+    SIM_Tick();
+  }
+  Playing = 0U;
+  while (DISK_IsIdle(&Disk) == 0U)
+  {
+    SIM_Tick();
+  }
+  for (v = 0U; v < NumVoices; v++)
+  {
+    if (VoiceState[v].Starving > 0U)
+    {
+      Episodes++;
+      Worst = AUDIO_MAX(Worst, VoiceState[v].Starving);
+    }
+  }
+
+  /* The take, chunk by chunk, as it lies on the card */
+  bytes = ChunkSectors * DISK_SECTOR_SIZE;
+  for (s = 0U; s < RecChunks; s++)
+  {
+    const uint8_t *at = &Card[((size_t)RecLba + ((size_t)s * ChunkSectors)) * DISK_SECTOR_SIZE];
+    uint32_t i;
+
+    if ((Lost[s] != 0U) || (((uint64_t)(s + 1U) * bytes) > RecBytes))
+    {
+      lost += Lost[s];
+      continue;
+    }
+    for (i = 0U; i < bytes; i++)
+    {
+      if (at[i] != SIM_RecValue(((uint64_t)s * bytes) + i))
+      {
+        recErrors++;
+        break;
+      }
+    }
+  }
+
+  printf("%u voices over %u samples, %.0f s: %u notes, voices sounding %.1f%% of the time\n", NumVoices,
+         NumSamples, seconds, Notes,
+         100.0 * (double)Sounding / ((double)AUDIO_MAX(NumVoices, 1U) * seconds * AUDIO_SAMPLE_RATE));
+  printf("starvation: %u episodes, %.4f%% of voice time, worst %.2f ms\n", Episodes,
+         100.0 * (double)Starved / (double)AUDIO_MAX(Sounding, 1U), Worst * 1e3 / AUDIO_SAMPLE_RATE);
+  printf("recorder: %u chunks of %u sectors in %u slots, %u lost to overruns\n", RecChunks, ChunkSectors,
+         NumSlots, lost);
+  if ((Saves > 0U) && (memcmp(&Card[(size_t)SaveLba * DISK_SECTOR_SIZE], SaveData,
+                              SIM_SAVE_SECTORS * DISK_SECTOR_SIZE) != 0))
+  {
+    SaveErrors++;
+  }
+
+  printf("presets: %u bursts of %u sectors, %.1f ms on average, worst %.1f ms\n", Presets, PresetSectors,
+         (Presets > 0U) ? PresetTotalSec * 1e3 / Presets : 0.0, PresetWorstSec * 1e3);
+  printf("reads: %u requests in %u transfers, %.1f sectors each; %u late, worst by %.2f ms\n",
+         Disk.Stats[0].Requests, Disk.Stats[0].Transfers,
+         (double)Disk.Stats[0].Sectors / AUDIO_MAX(Disk.Stats[0].Transfers, 1U), Disk.Stats[0].Missed,
+         Disk.Stats[0].WorstLate * 1e-3);
+  printf("writes: %u requests in %u transfers, %.1f sectors each; %u late, worst by %.2f ms\n",
+         Disk.Stats[1].Requests, Disk.Stats[1].Transfers,
+         (double)Disk.Stats[1].Sectors / AUDIO_MAX(Disk.Stats[1].Transfers, 1U), Disk.Stats[1].Missed,
+         Disk.Stats[1].WorstLate * 1e-3);
+  printf("saves: %u of %u sectors without a deadline, worst %.1f ms\n", Saves, SIM_SAVE_SECTORS,
+         SaveWorstSec * 1e3);
+  printf("writes held for reads %u times%s, %u let through after %.0f ms; card busy %.0f%%\n",
+         Disk.Throttled, (Disk.Config.NoThrottle != 0U) ? " (throttle off)" : "", Disk.Forced,
+         Disk.Config.MaxHoldUs * 1e-3, 100.0 * BusySec / Now);
+
+  if ((Mismatches != 0U) || (recErrors != 0U) || (PresetErrors != 0U) || (CheckErrors != 0U)
+      || (SaveErrors != 0U) || (Disk.Stats[0].Errors != 0U) || (Disk.Stats[1].Errors != 0U))
+  {
+    printf("wrong data: %u frames played, %u chunks recorded, %u preset sectors, %u read-backs, "
+           "%u saves, %u transfer errors\n", Mismatches, recErrors, PresetErrors, CheckErrors, SaveErrors,
+           Disk.Stats[0].Errors + Disk.Stats[1].Errors);
+    return 1;
+  }
+  /* A save waits out the hold, the write in flight and its own write */
+  if (SaveWorstSec > ((Disk.Config.MaxHoldUs * 1e-6) + (2.0 * (StallSec + (WriteSec * 4.0)))))
+  {
+    printf("a save waited longer than the hold and two writes\n");
+    return 1;
+  }
+  return (((Worst * 1e3 / AUDIO_SAMPLE_RATE) > limitMs)
+          || ((100.0 * (double)Starved / (double)AUDIO_MAX(Sounding, 1U)) > limitShare)) ? 1 : 0;
+}
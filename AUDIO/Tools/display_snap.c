@@ -0,0 +1,325 @@
+/**
+  ******************************************************************************
+  * @file    display_snap.c
+  * @brief   Host render of the meter and scope display to PNG snapshots.
+  *
+  *          Runs audio_display.c unchanged: a deterministic test signal is
+  *          fed block by block as the audio interrupt would, the meters and
+  *          scope are drawn once per frame as the panel task would, and the
+  *          dirty rectangles are flushed through DISPLAY_Pack() into a
+  *          simulated panel. After every flush the panel is compared with a
+  *          full expansion of the framebuffer, so a region the dirty
+  *          tracking missed fails the run. Snapshots are of the panel, as
+  *          the LCD would show it.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o display_snap display_snap.c \
+  *                ../Core/Src/audio_display.c -lm
+  *
+  *          Usage:
+  *            display_snap [-t seconds] [-e every n frames] [-o outdir]
+  *
+  *          Writes outdir/frame_NNNN.png every n frames (default: the last
+  *          frame only) and prints the pixels sent per frame against a full
+  *          redraw. The PNG encoding is stored (uncompressed) and byte-exact
+  *          from run to run, so snapshots compare with cmp against goldens.
+  *          The exit status is 1 if the panel ever differs from the
+  *          framebuffer.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_display.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SNAP_FRAME_MS             33U
+#define SNAP_CHUNK_PIXELS         1024U   /* As LCD_CHUNK_PIXELS                */
+#define SNAP_PI                   3.14159265358979f
+
+/* Private variables ---------------------------------------------------------*/
+static DISPLAY_HandleTypeDef Display;
+static DISPLAY_MeterTypeDef MeterL;
+static DISPLAY_MeterTypeDef MeterR;
+static DISPLAY_ScopeTypeDef Scope;
+static uint16_t Panel[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+static uint32_t CrcTable[256];
+
+/* Private functions ---------------------------------------------------------*/
+/* Test program: 440 Hz bursts on the left, a -60 to 0 dB ramp on the right */
+static void SNAP_Signal(uint32_t Index, uint32_t Total, float *pLeft, float *pRight)
+{
+  float t = (float)Index / (float)AUDIO_SAMPLE_RATE;
+  float burst = fmodf(t, 0.5f);
+  float ramp = -60.0f + (60.0f * (float)Index / (float)Total);
+
+  *pLeft = 0.9f * expf(-burst * 3.0f) * sinf(2.0f * SNAP_PI * 440.0f * t);
+  *pRight = powf(10.0f, ramp / 20.0f) * sinf(2.0f * SNAP_PI * 110.0f * t);
+}
+
+/* Sends the dirty rectangles to the panel, in LCD_CHUNK_PIXELS pieces */
+static uint32_t SNAP_Flush(uint32_t *pRegions)
+{
+  static uint16_t chunk[SNAP_CHUNK_PIXELS];
+  DISPLAY_RectTypeDef rect;
+  uint32_t pixels = 0U;
+
+  *pRegions = 0U;
+  while (DISPLAY_NextRegion(&Display, &rect) != 0U)
+  {
+    uint32_t rows = SNAP_CHUNK_PIXELS / rect.W;
+    uint32_t row;
+
+    (*pRegions)++;
+    pixels += (uint32_t)rect.W * rect.H;
+    for (row = 0U; row < rect.H; row += rows)
+    {
+      uint32_t n = AUDIO_MIN(rows, rect.H - row);
+      uint32_t r;
+
+      DISPLAY_Pack(&Display, &rect, row, n, chunk);
+      for (r = 0U; r < n; r++)
+      {
+        memcpy(&Panel[((rect.Y + row + r) * DISPLAY_WIDTH) + rect.X], &chunk[r * rect.W],
+               rect.W * sizeof(uint16_t));
+      }
+    }
+  }
+  return pixels;
+}
+
+/* Returns the number of panel pixels that differ from the framebuffer */
+static uint32_t SNAP_Verify(void)
+{
+  static uint16_t full[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+  DISPLAY_RectTypeDef all = { 0U, 0U, DISPLAY_WIDTH, DISPLAY_HEIGHT };
+  uint32_t bad = 0U;
+  uint32_t i;
+
+  DISPLAY_Pack(&Display, &all, 0U, DISPLAY_HEIGHT, full);
+  for (i = 0U; i < (DISPLAY_WIDTH * DISPLAY_HEIGHT); i++)
+  {
+    bad += (uint32_t)(full[i] != Panel[i]);
+  }
+  return bad;
+}
+
+static uint32_t SNAP_Crc(uint32_t Crc, const uint8_t *pData, size_t Size)
+{
+  size_t i;
+
+  for (i = 0U; i < Size; i++)
+  {
+    Crc = CrcTable[(Crc ^ pData[i]) & 0xFFU] ^ (Crc >> 8);
+  }
+  return Crc;
+}
+
+static void SNAP_Put32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static void SNAP_Chunk(FILE *f, const char *pType, const uint8_t *pData, uint32_t Size)
+{
+  uint8_t b[4];
+  uint32_t crc;
+
+  SNAP_Put32(b, Size);
+  fwrite(b, 1, 4, f);
+  fwrite(pType, 1, 4, f);
+  fwrite(pData, 1, Size, f);
+  crc = SNAP_Crc(0xFFFFFFFFU, (const uint8_t *)pType, 4U);
+  crc = SNAP_Crc(crc, pData, Size) ^ 0xFFFFFFFFU;
+  SNAP_Put32(b, crc);
+  fwrite(b, 1, 4, f);
+}
+
+/* RGB 8-bit PNG of the panel, zlib stream of stored blocks, one row each */
+static int SNAP_WritePng(const char *pPath)
+{
+  uint32_t rowBytes = 1U + (3U * DISPLAY_WIDTH);
+  uint32_t size = 2U + (DISPLAY_HEIGHT * (5U + rowBytes)) + 4U;
+  uint8_t *z = malloc(size);
+  uint8_t ihdr[13] = { 0 };
+  uint32_t s1 = 1U;
+  uint32_t s2 = 0U;
+  uint32_t y;
+  uint8_t *p;
+  FILE *f;
+
+  if (z == NULL)
+  {
+    return -1;
+  }
+  p = z;
+  *p++ = 0x78U;
+  *p++ = 0x01U;
+  for (y = 0U; y < DISPLAY_HEIGHT; y++)
+  {
+    uint8_t *row;
+    uint32_t x;
+
+    *p++ = (uint8_t)((y + 1U) == DISPLAY_HEIGHT);
+    *p++ = (uint8_t)rowBytes;
+    *p++ = (uint8_t)(rowBytes >> 8);
+    *p++ = (uint8_t)~rowBytes;
+    *p++ = (uint8_t)(~rowBytes >> 8);
+    row = p;
+    *p++ = 0U;
+    for (x = 0U; x < DISPLAY_WIDTH; x++)
+    {
+      uint16_t c = Panel[(y * DISPLAY_WIDTH) + x];
+
+      *p++ = (uint8_t)(((c >> 11) & 0x1FU) * 255U / 31U);
+      *p++ = (uint8_t)(((c >> 5) & 0x3FU) * 255U / 63U);
+      *p++ = (uint8_t)((c & 0x1FU) * 255U / 31U);
+    }
+    for (x = 0U; x < rowBytes; x++)
+    {
+      s1 = (s1 + row[x]) % 65521U;
+      s2 = (s2 + s1) % 65521U;
+    }
+  }
+  SNAP_Put32(p, (s2 << 16) | s1);
+
+  f = fopen(pPath, "wb");
+  if (f == NULL)
+  {
+    free(z);
+    return -1;
+  }
+  fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
+  SNAP_Put32(&ihdr[0], DISPLAY_WIDTH);
+  SNAP_Put32(&ihdr[4], DISPLAY_HEIGHT);
+  ihdr[8] = 8U;
+  ihdr[9] = 2U;
+  SNAP_Chunk(f, "IHDR", ihdr, sizeof(ihdr));
+  SNAP_Chunk(f, "IDAT", z, size);
+  SNAP_Chunk(f, "IEND", NULL, 0U);
+  free(z);
+  return (fclose(f) == 0) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+  const DISPLAY_RectTypeDef areaL = { 8U, 8U, 24U, 224U };
+  const DISPLAY_RectTypeDef areaR = { 40U, 8U, 24U, 224U };
+  const DISPLAY_RectTypeDef areaScope = { 80U, 8U, 232U, 224U };
+  const char *outdir = ".";
+  uint32_t frameSamples = AUDIO_SAMPLE_RATE * SNAP_FRAME_MS / 1000U;
+  uint32_t total;
+  uint32_t frames;
+  uint32_t every = 0U;
+  uint32_t sample = 0U;
+  uint32_t sent = 0U;
+  uint32_t failures = 0U;
+  uint32_t frame;
+  float seconds = 3.0f;
+  int opt;
+  uint32_t i;
+
+  while ((opt = getopt(argc, argv, "t:e:o:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': seconds = (float)atof(optarg); break;
+      case 'e': every = (uint32_t)atoi(optarg); break;
+      case 'o': outdir = optarg; break;
+      default: return 2;
+    }
+  }
+  for (i = 0U; i < 256U; i++)
+  {
+    uint32_t c = i;
+    uint32_t k;
+
+    for (k = 0U; k < 8U; k++)
+    {
+      c = ((c & 1U) != 0U) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+    }
+    CrcTable[i] = c;
+  }
+
+  DISPLAY_Init(&Display, DISPLAY_BLACK);
+  if ((DISPLAY_MeterInit(&Display, &MeterL, &areaL) != AUDIO_OK)
+      || (DISPLAY_MeterInit(&Display, &MeterR, &areaR) != AUDIO_OK)
+      || (DISPLAY_ScopeInit(&Display, &Scope, &areaScope, 2U) != AUDIO_OK))
+  {
+    fprintf(stderr, "bad layout\n");
+    return 2;
+  }
+  /* Panel content is undefined until the first full flush */
+  memset(Panel, 0xA5, sizeof(Panel));
+  frames = (uint32_t)(seconds * 1000.0f / (float)SNAP_FRAME_MS);
+  total = frames * frameSamples;
+
+  for (frame = 0U; frame < frames; frame++)
+  {
+    uint32_t regions;
+    uint32_t pixels;
+    uint32_t bad;
+
+    /* Audio interrupts of one frame period */
+    while (sample < ((frame + 1U) * frameSamples))
+    {
+      float left[AUDIO_BLOCK_SIZE];
+      float right[AUDIO_BLOCK_SIZE];
+
+      for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+      {
+        SNAP_Signal(sample + i, total, &left[i], &right[i]);
+      }
+      DISPLAY_MeterFeed(&MeterL, left, AUDIO_BLOCK_SIZE);
+      DISPLAY_MeterFeed(&MeterR, right, AUDIO_BLOCK_SIZE);
+      DISPLAY_ScopeFeed(&Scope, left, AUDIO_BLOCK_SIZE);
+      sample += AUDIO_BLOCK_SIZE;
+    }
+
+    /* Panel task */
+    DISPLAY_MeterDraw(&Display, &MeterL);
+    DISPLAY_MeterDraw(&Display, &MeterR);
+    DISPLAY_ScopeDraw(&Display, &Scope);
+    pixels = SNAP_Flush(&regions);
+    bad = SNAP_Verify();
+    sent += pixels;
+    if (bad != 0U)
+    {
+      failures++;
+      fprintf(stderr, "frame %u: %u pixels differ from the framebuffer\n", frame, bad);
+    }
+    printf("frame %4u: %2u regions %6u pixels (%5.1f %% of a full frame)\n", frame, regions,
+           pixels, 100.0 * pixels / (DISPLAY_WIDTH * DISPLAY_HEIGHT));
+
+    if (((every != 0U) && ((frame % every) == 0U)) || ((frame + 1U) == frames))
+    {
+      char path[512];
+
+      snprintf(path, sizeof(path), "%s/frame_%04u.png", outdir, frame);
+      if (SNAP_WritePng(path) != 0)
+      {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return 2;
+      }
+    }
+  }
+
+  printf("%u frames, %.1f %% of full redraws sent, %u mismatched frames\n", frames,
+         (frames != 0U) ? (100.0 * sent / ((double)frames * DISPLAY_WIDTH * DISPLAY_HEIGHT)) : 0.0,
+         failures);
+  return (failures == 0U) ? 0 : 1;
+}
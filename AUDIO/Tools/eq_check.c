@@ -0,0 +1,268 @@
+/**
+  ******************************************************************************
+  * @file    eq_check.c
+  * @brief   Host accuracy check of the audio_eq.c designers.
+  *
+  *          Designs every band shape over a grid of frequencies (100 Hz to
+  *          the 0.49 fs clamp), Q and gains with EQ_Design() and compares
+  *          the magnitude response of the float coefficients with that of
+  *          the analog prototype, computed in double precision. Both sides
+  *          are floored at -40 dB so stop bands only count down to it.
+  *
+  *          Checked for both designs:
+  *            - every section is stable;
+  *            - the response is exact at DC and at the band frequency (the
+  *              notch bottom aside), which both mappings guarantee.
+  *          Checked for the matched design, at 256 log-spaced frequencies
+  *          from 10 Hz to 0.95 Nyquist:
+  *            - the whole response, for bands up to the envelope frequency
+  *              and Q (10 kHz and 1 by default). Three matched points cannot
+  *              follow the sharp dip and peak of high-Q shelves, nor any
+  *              shape whose features lie past Nyquist: -v shows those too.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o eq_check eq_check.c \
+  *                ../Core/Src/audio_eq.c ../Core/Src/audio_biquad.c -lm
+  *
+  *          Usage:
+  *            eq_check [-e exact limit dB] [-m matched limit dB]
+  *                     [-f envelope Hz] [-q envelope Q] [-v]
+  *
+  *          The exit status is 1 if a section is unstable or an error is
+  *          over its limit (0.1 dB at DC and the band frequency, 3 dB over
+  *          the whole response by default). -v prints the worst full
+  *          response error of the matched design per shape, Q and band
+  *          frequency.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_eq.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_POINTS              256U
+#define CHECK_TYPES               7U
+#define CHECK_FREQS               (sizeof(Freqs) / sizeof(Freqs[0]))
+#define CHECK_QS                  (sizeof(Qs) / sizeof(Qs[0]))
+#define CHECK_GAINS               (sizeof(Gains) / sizeof(Gains[0]))
+#define CHECK_DEPTH               -40.0
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  double   Error;             /* dB */
+  double   At;                /* Hz */
+  EQ_BandTypeDef Band;
+} CHECK_WorstTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static const char *const TypeNames[CHECK_TYPES] =
+{
+  "peaking", "lowshelf", "highshelf", "lowpass", "highpass", "bandpass", "notch"
+};
+static const char *const DesignNames[2] = { "rbj", "matched" };
+static const float Freqs[] =
+{
+  100.0f, 300.0f, 1000.0f, 3000.0f, 6000.0f, 10000.0f, 12000.0f, 14000.0f,
+  16000.0f, 18000.0f, 20000.0f, 22000.0f, 23520.0f
+};
+static const float Qs[] = { 0.3f, 0.707f, 2.0f, 8.0f };
+static const float Gains[] = { -12.0f, -6.0f, 3.0f, 12.0f };
+
+/* Private functions ---------------------------------------------------------*/
+/* Analog prototype response in dB, the RBJ cookbook shapes in double */
+static double CHECK_AnalogDb(const EQ_BandTypeDef *pBand, double Hz)
+{
+  double q = pBand->Q;
+  double A = pow(10.0, pBand->GainDb / 40.0);
+  double sa = sqrt(A);
+  double x = Hz / pBand->Freq;
+  double n2 = 0.0, n1 = 0.0, n0 = 0.0, d2 = 1.0, d1 = 1.0 / q, d0 = 1.0;
+  double nr;
+  double dr;
+
+  switch (pBand->Type)
+  {
+    case EQ_PEAKING:   n2 = 1.0; n1 = A / q; n0 = 1.0; d1 = 1.0 / (A * q); break;
+    case EQ_LOWSHELF:  n2 = A; n1 = A * sa / q; n0 = A * A; d2 = A; d1 = sa / q; break;
+    case EQ_HIGHSHELF: n2 = A * A; n1 = A * sa / q; n0 = A; d1 = sa / q; d0 = A; break;
+    case EQ_LOWPASS:   n0 = 1.0; break;
+    case EQ_HIGHPASS:  n2 = 1.0; break;
+    case EQ_BANDPASS:  n1 = 1.0 / q; break;
+    default:           n2 = 1.0; n0 = 1.0; break;
+  }
+  nr = n0 - n2 * x * x;
+  dr = d0 - d2 * x * x;
+  return 10.0 * log10((nr * nr + n1 * n1 * x * x + 1e-300) / (dr * dr + d1 * d1 * x * x));
+}
+
+static double CHECK_DigitalDb(const BIQUAD_CoeffsTypeDef *pC, double Hz)
+{
+  double w = 2.0 * M_PI * Hz / (double)AUDIO_SAMPLE_RATE;
+  double c1 = cos(w), s1 = sin(w), c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+  double nr = pC->b0 + pC->b1 * c1 + pC->b2 * c2;
+  double ni = pC->b1 * s1 + pC->b2 * s2;
+  double dr = 1.0 + pC->a1 * c1 + pC->a2 * c2;
+  double di = pC->a1 * s1 + pC->a2 * s2;
+
+  return 10.0 * log10((nr * nr + ni * ni + 1e-300) / (dr * dr + di * di));
+}
+
+static void CHECK_Error(CHECK_WorstTypeDef *pWorst, const EQ_BandTypeDef *pBand,
+                        const BIQUAD_CoeffsTypeDef *pC, double Hz)
+{
+  double a = AUDIO_MAX(CHECK_AnalogDb(pBand, Hz), CHECK_DEPTH);
+  double d = AUDIO_MAX(CHECK_DigitalDb(pC, Hz), CHECK_DEPTH);
+
+  if (fabs(a - d) > pWorst->Error)
+  {
+    pWorst->Error = fabs(a - d);
+    pWorst->At    = Hz;
+    pWorst->Band  = *pBand;
+  }
+}
+
+static int CHECK_Stable(const BIQUAD_CoeffsTypeDef *pC)
+{
+  return (fabs(pC->a2) < 1.0) && (fabs(pC->a1) < 1.0 + pC->a2);
+}
+
+static int CHECK_Report(const char *pWhat, const CHECK_WorstTypeDef *pW, double Limit)
+{
+  printf("%-26s %7.3f dB, limit %.3f dB", pWhat, pW->Error, Limit);
+  if (pW->Error > 0.0)
+  {
+    printf(" (%s %.0f Hz, Q %.3g, %+.0f dB, at %.1f Hz)", TypeNames[pW->Band.Type],
+           pW->Band.Freq, pW->Band.Q, pW->Band.GainDb, pW->At);
+  }
+  printf("\n");
+  return pW->Error > Limit;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  static CHECK_WorstTypeDef table[CHECK_TYPES][CHECK_QS][CHECK_FREQS];
+  const double nyquist = 0.5 * (double)AUDIO_SAMPLE_RATE;
+  double exactLimit = 0.1;
+  double matchedLimit = 3.0;
+  double envFreq = 10000.0;
+  double envQ = 1.0;
+  CHECK_WorstTypeDef exact[2] = { { 0 } };
+  CHECK_WorstTypeDef envelope = { 0 };
+  uint32_t unstable = 0U;
+  uint32_t cases = 0U;
+  int verbose = 0;
+  int failed = 0;
+  int opt;
+  uint32_t t, f, q, g, i, d;
+
+  while ((opt = getopt(argc, argv, "e:m:f:q:v")) != -1)
+  {
+    switch (opt)
+    {
+      case 'e': exactLimit = atof(optarg); break;
+      case 'm': matchedLimit = atof(optarg); break;
+      case 'f': envFreq = atof(optarg); break;
+      case 'q': envQ = atof(optarg); break;
+      case 'v': verbose = 1; break;
+      default:
+        fprintf(stderr, "usage: eq_check [-e dB] [-m dB] [-f Hz] [-q Q] [-v]\n");
+        return 2;
+    }
+  }
+
+  for (t = 0U; t < CHECK_TYPES; t++)
+  {
+    uint32_t gains = (t <= (uint32_t)EQ_HIGHSHELF) ? CHECK_GAINS : 1U;
+
+    for (f = 0U; f < CHECK_FREQS; f++)
+    {
+      for (q = 0U; q < CHECK_QS; q++)
+      {
+        for (g = 0U; g < gains; g++)
+        {
+          EQ_BandTypeDef band;
+
+          band.Type   = (EQ_TypeDef)t;
+          band.Freq   = AUDIO_MIN(Freqs[f], 0.49f * (float)AUDIO_SAMPLE_RATE);
+          band.Q      = Qs[q];
+          band.GainDb = (gains > 1U) ? Gains[g] : 0.0f;
+
+          for (d = 0U; d < 2U; d++)
+          {
+            BIQUAD_CoeffsTypeDef c;
+
+            EQ_Design(&band, (EQ_DesignTypeDef)d, &c);
+            cases++;
+            if (!CHECK_Stable(&c))
+            {
+              printf("UNSTABLE %s %s %.0f Hz Q %.3g %+.0f dB: a1 %g a2 %g\n", DesignNames[d],
+                     TypeNames[t], band.Freq, band.Q, band.GainDb, c.a1, c.a2);
+              unstable++;
+              continue;
+            }
+            CHECK_Error(&exact[d], &band, &c, 1e-3);
+            if (band.Type != EQ_NOTCH)
+            {
+              CHECK_Error(&exact[d], &band, &c, band.Freq);
+            }
+            if (d != (uint32_t)EQ_DESIGN_MATCHED)
+            {
+              continue;
+            }
+            for (i = 0U; i < CHECK_POINTS; i++)
+            {
+              CHECK_Error(&table[t][q][f], &band, &c,
+                          10.0 * pow(0.95 * nyquist / 10.0, (double)i / (CHECK_POINTS - 1U)));
+            }
+            if ((band.Freq <= envFreq) && (band.Q <= envQ) &&
+                (table[t][q][f].Error > envelope.Error))
+            {
+              envelope = table[t][q][f];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (verbose)
+  {
+    printf("matched, worst full response error (dB) by band frequency\n%-9s %5s", "", "Q");
+    for (f = 0U; f < CHECK_FREQS; f++)
+    {
+      printf(" %6.0f", AUDIO_MIN(Freqs[f], 0.49f * (float)AUDIO_SAMPLE_RATE));
+    }
+    printf("\n");
+    for (t = 0U; t < CHECK_TYPES; t++)
+    {
+      for (q = 0U; q < CHECK_QS; q++)
+      {
+        printf("%-9s %5.3g", TypeNames[t], Qs[q]);
+        for (f = 0U; f < CHECK_FREQS; f++)
+        {
+          printf(" %6.2f", table[t][q][f].Error);
+        }
+        printf("\n");
+      }
+    }
+  }
+
+  failed |= CHECK_Report("rbj at DC and band", &exact[EQ_DESIGN_RBJ], exactLimit);
+  failed |= CHECK_Report("matched at DC and band", &exact[EQ_DESIGN_MATCHED], exactLimit);
+  failed |= CHECK_Report("matched within envelope", &envelope, matchedLimit);
+  printf("%u designs, %u unstable\n", cases, unstable);
+  return (failed || (unstable != 0U)) ? 1 : 0;
+}
@@ -0,0 +1,304 @@
+/**
+  ******************************************************************************
+  * @file    fbs_check.c
+  * @brief   Host check of the audio_fft.c kernels and of the audio_fbs.c
+  *          feedback suppressor in a simulated howl loop.
+  *
+  *          FFT, against a direct DFT in double precision over random input:
+  *            - FFT_Real() at every length from 4 to FFT_MAX_SIZE.
+  *          Suppressor, the background analysis run once per block:
+  *            - white noise alone engages no notch;
+  *            - closing a loop from the output back to the input, through a
+  *              delay and a resonance with gain above unity, howls without
+  *              the suppressor; with it, notches land on the resonance and
+  *              the output level settles within 3 dB of the noise;
+  *            - once the loop is opened again, every notch is freed after
+  *              its hold and release.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o fbs_check fbs_check.c \
+  *                ../Core/Src/audio_fft.c ../Core/Src/audio_fbs.c \
+  *                ../Core/Src/audio_biquad.c -lm
+  *
+  *          Usage:
+  *            fbs_check [-f resonance Hz] [-g loop gain dB] [-d delay frames]
+  *
+  *          Defaults: 2 kHz, +3 dB, 240 frames (5 ms). The exit status is 1
+  *          if an FFT bin is off by more than 1e-4 of the peak, or a
+  *          suppressor check fails.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_fbs.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_TOLERANCE           1e-4
+#define CHECK_NOISE               0.03    /* -30 dBFS white noise at the input */
+#define CHECK_MAX_DELAY           4096U
+#define CHECK_RESONANCE_Q         5.0
+#define CHECK_SETTLED_DB          3.0     /* Output level over the noise, settled */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  BIQUAD_CoeffsTypeDef Coeffs;        /* Resonance of the acoustic path    */
+  BIQUAD_StateTypeDef  State;
+  float    Gain;                      /* Loop gain at the resonance        */
+  uint32_t Delay;                     /* Frames from output back to input */
+  float    Line[CHECK_MAX_DELAY];     /* Past outputs                      */
+  uint32_t Pos;
+} CHECK_LoopTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static FFT_HandleTypeDef Fft;
+static FBS_HandleTypeDef Fbs;
+static CHECK_LoopTypeDef Loop;
+static float Data[FFT_MAX_SIZE];
+
+/* Private functions ---------------------------------------------------------*/
+static float CHECK_Noise(void)
+{
+  return (float)(rand() % 20001 - 10000) / 10000.0f * (float)(CHECK_NOISE * sqrt(3.0));
+}
+
+static double CHECK_Fft(void)
+{
+  static double ref[FFT_MAX_SIZE];
+  double worst = 0.0;
+  uint32_t size;
+  uint32_t i;
+  uint32_t k;
+
+  for (size = 4U; size <= FFT_MAX_SIZE; size *= 2U)
+  {
+    double peak = 0.0;
+    double err = 0.0;
+
+    (void)FFT_Init(&Fft, size);
+    for (i = 0U; i < size; i++)
+    {
+      Data[i] = (float)(rand() % 20001 - 10000) / 10000.0f;
+      ref[i]  = Data[i];
+    }
+    FFT_Real(&Fft, Data);
+
+    /* Packed: X[0] and X[N/2] first, then re, im of X[1] .. X[N/2 - 1] */
+    for (k = 0U; k <= size / 2U; k++)
+    {
+      double re = 0.0;
+      double im = 0.0;
+      double gre;
+      double gim;
+
+      for (i = 0U; i < size; i++)
+      {
+        re += ref[i] * cos(2.0 * M_PI * (double)(k * i) / (double)size);
+        im -= ref[i] * sin(2.0 * M_PI * (double)(k * i) / (double)size);
+      }
+      gre = (k == 0U) ? Data[0] : (k == size / 2U) ? Data[1] : Data[2U * k];
+      gim = ((k == 0U) || (k == size / 2U)) ? 0.0 : Data[2U * k + 1U];
+      err  = AUDIO_MAX(err, hypot(gre - re, gim - im));
+      peak = AUDIO_MAX(peak, hypot(re, im));
+    }
+    worst = AUDIO_MAX(worst, err / peak);
+  }
+  return worst;
+}
+
+static void CHECK_Init(void)
+{
+  FBS_ConfigTypeDef cfg;
+
+  cfg.PaprDb          = 15.0f;
+  cfg.Persistence     = 3U;
+  cfg.HoldSeconds     = 2.0f;
+  cfg.ReleaseDbPerSec = 3.0f;
+  cfg.MinHz           = 100.0f;
+  cfg.MaxHz           = 10000.0f;
+  if (FBS_Init(&Fbs, &cfg) != AUDIO_OK)
+  {
+    fprintf(stderr, "fbs_check: FBS_Init failed\n");
+    exit(2);
+  }
+}
+
+/* RBJ band-pass with 0 dB peak, scaled by the loop gain */
+static void CHECK_SetLoop(double Hz, double GainDb, uint32_t Delay)
+{
+  double w0 = 2.0 * M_PI * Hz / (double)AUDIO_SAMPLE_RATE;
+  double alpha = sin(w0) / (2.0 * CHECK_RESONANCE_Q);
+  double a0 = 1.0 + alpha;
+
+  memset(&Loop, 0, sizeof(Loop));
+  Loop.Coeffs.b0 = (float)(alpha / a0);
+  Loop.Coeffs.b1 = 0.0f;
+  Loop.Coeffs.b2 = (float)(-alpha / a0);
+  Loop.Coeffs.a1 = (float)(-2.0 * cos(w0) / a0);
+  Loop.Coeffs.a2 = (float)((1.0 - alpha) / a0);
+  Loop.Gain  = (float)pow(10.0, GainDb / 20.0);
+  Loop.Delay = Delay;
+}
+
+/* Runs Seconds of noise through the loop, the suppressor on or bypassed;
+   the output level over the last second, in dB over the noise */
+static double CHECK_Run(double Seconds, int Suppress)
+{
+  float block[AUDIO_BLOCK_SIZE];
+  float back[AUDIO_BLOCK_SIZE];
+  uint32_t blocks = (uint32_t)(Seconds * AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SIZE);
+  uint32_t tail = AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SIZE;
+  double power = 0.0;
+  uint32_t b;
+  uint32_t i;
+
+  for (b = 0U; b < blocks; b++)
+  {
+    /* The delay is at least a block: the path only needs past outputs */
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      back[i] = Loop.Line[(Loop.Pos + i + CHECK_MAX_DELAY - Loop.Delay) % CHECK_MAX_DELAY];
+    }
+    BIQUAD_Process(&Loop.Coeffs, &Loop.State, back, back, AUDIO_BLOCK_SIZE);
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      block[i] = CHECK_Noise() + Loop.Gain * back[i];
+    }
+
+    if (Suppress)
+    {
+      FBS_Process(&Fbs, block, block, AUDIO_BLOCK_SIZE);
+      (void)FBS_Analyze(&Fbs);
+    }
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      /* The converter clips */
+      block[i] = AUDIO_CLAMP(block[i], -1.0f, 1.0f);
+      Loop.Line[(Loop.Pos + i) % CHECK_MAX_DELAY] = block[i];
+      if (b + tail >= blocks)
+      {
+        power += (double)block[i] * (double)block[i];
+      }
+    }
+    Loop.Pos = (Loop.Pos + AUDIO_BLOCK_SIZE) % CHECK_MAX_DELAY;
+  }
+  return 10.0 * log10(AUDIO_MAX(power, 1e-24) / (double)(tail * AUDIO_BLOCK_SIZE)) -
+         20.0 * log10(CHECK_NOISE);
+}
+
+static uint32_t CHECK_Active(double *pLow, double *pHigh)
+{
+  uint32_t count = 0U;
+  uint32_t i;
+
+  *pLow  = HUGE_VAL;
+  *pHigh = 0.0;
+  for (i = 0U; i < FBS_MAX_NOTCHES; i++)
+  {
+    if (Fbs.Notches[i].Active != 0U)
+    {
+      *pLow  = AUDIO_MIN(*pLow, Fbs.Notches[i].Freq);
+      *pHigh = AUDIO_MAX(*pHigh, Fbs.Notches[i].Freq);
+      count++;
+    }
+  }
+  return count;
+}
+
+static int CHECK_Suppressor(double Hz, double GainDb, uint32_t Delay)
+{
+  double open;
+  double howl;
+  double settled;
+  double low;
+  double high;
+  double band = exp2(1.0 / CHECK_RESONANCE_Q);
+  uint32_t count;
+  int failed = 0;
+
+  /* Noise alone */
+  CHECK_Init();
+  CHECK_SetLoop(Hz, -120.0, Delay);
+  open = CHECK_Run(10.0, 1);
+  count = CHECK_Active(&low, &high);
+  printf("noise alone: %u notches, level %+.1f dB over the noise\n", count, open);
+  failed |= (count != 0U);
+
+  /* The loop howls unchecked */
+  CHECK_SetLoop(Hz, GainDb, Delay);
+  howl = CHECK_Run(2.0, 0);
+  printf("loop at %+.1f dB, %u frames, no suppressor: level %+.1f dB over the noise\n", GainDb,
+         Delay, howl);
+  if (howl < 2.0 * CHECK_SETTLED_DB)
+  {
+    fprintf(stderr, "fbs_check: the loop does not howl, nothing to check\n");
+    exit(2);
+  }
+
+  /* Suppressed: notches within the resonance's band, output back near the noise */
+  CHECK_SetLoop(Hz, GainDb, Delay);
+  settled = CHECK_Run(10.0, 1);
+  count = CHECK_Active(&low, &high);
+  printf("with the suppressor: %u notches from %.0f to %.0f Hz, level %+.1f dB over the noise, "
+         "limit %+.1f\n", count, low, high, settled, CHECK_SETTLED_DB);
+  failed |= (count == 0U) || (low < Hz / band) || (high > Hz * band) ||
+            (settled > CHECK_SETTLED_DB);
+
+  /* Opened again: all freed after hold and release */
+  CHECK_SetLoop(Hz, -120.0, Delay);
+  (void)CHECK_Run((double)Fbs.Config.HoldSeconds - FBS_MAX_DEPTH_DB / Fbs.Config.ReleaseDbPerSec +
+                  1.0, 1);
+  count = CHECK_Active(&low, &high);
+  printf("loop opened: %u notches left after hold and release\n", count);
+  failed |= (count != 0U);
+  return failed;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  double hz = 2000.0;
+  double gain = 3.0;
+  uint32_t delay = 240U;
+  double fft;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "f:g:d:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'f': hz = atof(optarg); break;
+      case 'g': gain = atof(optarg); break;
+      case 'd': delay = (uint32_t)atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: fbs_check [-f Hz] [-g dB] [-d frames]\n");
+        return 2;
+    }
+  }
+  if ((hz < 200.0) || (hz > 8000.0) || (delay < AUDIO_BLOCK_SIZE) || (delay > CHECK_MAX_DELAY))
+  {
+    fprintf(stderr, "fbs_check: bad resonance or delay\n");
+    return 2;
+  }
+
+  srand(1U);
+  fft = CHECK_Fft();
+  printf("fft: worst bin error %.2e of the peak, lengths 4 to %u, limit %.0e\n", fft,
+         FFT_MAX_SIZE, CHECK_TOLERANCE);
+  failed |= (fft > CHECK_TOLERANCE);
+  failed |= CHECK_Suppressor(hz, gain, delay);
+  return failed;
+}
@@ -0,0 +1,346 @@
+/**
+  ******************************************************************************
+  * @file    g7xx_check.c
+  * @brief   Host check of the audio_g711.c and audio_g722.c codecs.
+  *
+  *          G.711, both laws, against the ITU-T G.191 reference routines
+  *          written out below:
+  *            - every 16-bit input encodes to the reference code word;
+  *            - every code word decodes to the reference sample;
+  *            - a float sine round-trips at the SNR limit or better.
+  *          G.722, encoder and decoder in tandem:
+  *            - a sine in the low band and one in the high band round-trip,
+  *              aligned on the codec delay measured with noise, at each
+  *              mode's SNR limit or better. The high band has 2 bits in
+  *              every mode, so its limit is lower and the same for all;
+  *            - encoding and decoding in calls of uneven length, and longer
+  *              than G722_MAX_FRAMES, gives the same codes and samples as a
+  *              single call.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o g7xx_check g7xx_check.c \
+  *                ../Core/Src/audio_g711.c ../Core/Src/audio_g722.c \
+  *                ../Core/Src/audio_fir.c -lm
+  *
+  *          Usage:
+  *            g7xx_check [-l level dBFS]
+  *
+  *          Defaults: sines at -10 dBFS. The exit status is 1 at the first
+  *          code word, sample or SNR that is off.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_g711.h"
+#include "audio_g722.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_FRAMES              16000U  /* 1 s at 16 kHz */
+#define CHECK_MAX_LAG             64U
+#define CHECK_G711_SNR_DB         33.0
+
+/* Private variables ---------------------------------------------------------*/
+static const char *const LawNames[2] = { "mu-law", "A-law" };
+static const struct { G722_ModeTypeDef Mode; const char *Name; double LowSnr; double HighSnr; }
+  Modes[] =
+{
+  { G722_MODE_64K, "64k", 40.0, 20.0 },
+  { G722_MODE_56K, "56k", 35.0, 20.0 },
+  { G722_MODE_48K, "48k", 29.0, 20.0 }
+};
+static G722_HandleTypeDef Encoder;
+static G722_HandleTypeDef Decoder;
+static float In[CHECK_FRAMES];
+static float Out[CHECK_FRAMES];
+static float Split[CHECK_FRAMES];
+static uint8_t Codes[CHECK_FRAMES];
+static uint8_t SplitCodes[CHECK_FRAMES];
+
+/* Private functions ---------------------------------------------------------*/
+/* G.191 ulaw_compress() */
+static uint8_t CHECK_UlawCompress(int16_t x)
+{
+  int32_t absno = (x < 0) ? ((~x) >> 2) + 33 : (x >> 2) + 33;
+  int32_t segno = 1;
+  int32_t i;
+  int32_t low;
+  int32_t y;
+
+  absno = AUDIO_MIN(absno, 0x1FFF);
+  for (i = absno >> 6; i != 0; i >>= 1)
+  {
+    segno++;
+  }
+  low = 0xF - ((absno >> segno) & 0xF);
+  y = ((0x8 - segno) << 4) | low;
+  return (uint8_t)((x >= 0) ? (y | 0x80) : y);
+}
+
+/* G.191 ulaw_expand() */
+static int16_t CHECK_UlawExpand(uint8_t Code)
+{
+  int32_t sign = (Code < 0x80) ? -1 : 1;
+  int32_t mantissa = ~Code;
+  int32_t exponent = (mantissa >> 4) & 0x7;
+  int32_t step = 4 << (exponent + 1);
+
+  mantissa &= 0xF;
+  return (int16_t)(sign * ((0x80 << exponent) + step * mantissa + step / 2 - 4 * 33));
+}
+
+/* G.191 alaw_compress() */
+static uint8_t CHECK_AlawCompress(int16_t x)
+{
+  int32_t ix = (x < 0) ? ((~x) >> 4) : (x >> 4);
+  int32_t iexp;
+
+  if (ix > 15)
+  {
+    iexp = 1;
+    while (ix > 16 + 15)
+    {
+      ix >>= 1;
+      iexp++;
+    }
+    ix -= 16;
+    ix += iexp << 4;
+  }
+  if (x >= 0)
+  {
+    ix |= 0x80;
+  }
+  return (uint8_t)(ix ^ 0x55);
+}
+
+/* G.191 alaw_expand() */
+static int16_t CHECK_AlawExpand(uint8_t Code)
+{
+  int32_t ix = (Code ^ 0x55) & 0x7F;
+  int32_t iexp = ix >> 4;
+  int32_t mant = ix & 0xF;
+
+  if (iexp > 0)
+  {
+    mant += 16;
+  }
+  mant = (mant << 4) + 8;
+  if (iexp > 1)
+  {
+    mant <<= iexp - 1;
+  }
+  return (int16_t)((Code > 127) ? mant : -mant);
+}
+
+/* SNR in dB of Got against Want delayed by Lag, over the second half */
+static double CHECK_Snr(const float *pWant, const float *pGot, uint32_t Frames, uint32_t Lag)
+{
+  double signal = 0.0;
+  double noise = 0.0;
+  uint32_t i;
+
+  for (i = Frames / 2U; i < Frames; i++)
+  {
+    double e = (double)pGot[i] - (double)pWant[i - Lag];
+
+    signal += (double)pWant[i - Lag] * (double)pWant[i - Lag];
+    noise  += e * e;
+  }
+  return 10.0 * log10(signal / AUDIO_MAX(noise, 1e-30));
+}
+
+static void CHECK_Sine(double Hz, double Rate, double Level, uint32_t Frames)
+{
+  double a = pow(10.0, Level / 20.0);
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    In[i] = (float)(a * sin(2.0 * M_PI * Hz * (double)i / Rate));
+  }
+}
+
+static int CHECK_G711(double Level)
+{
+  int failed = 0;
+  uint32_t law;
+  int32_t x;
+  uint32_t c;
+
+  for (law = 0U; law < 2U; law++)
+  {
+    G711_LawTypeDef l = (law == 0U) ? G711_ULAW : G711_ALAW;
+    uint32_t codes = 0U;
+    uint32_t samples = 0U;
+    double snr;
+
+    for (x = -32768; x <= 32767; x++)
+    {
+      uint8_t want = (l == G711_ULAW) ? CHECK_UlawCompress((int16_t)x)
+                                       : CHECK_AlawCompress((int16_t)x);
+
+      if (G711_EncodeSample(l, (int16_t)x) != want)
+      {
+        if (codes++ == 0U)
+        {
+          printf("%s: %d encodes to 0x%02X, expected 0x%02X\n", LawNames[law], x,
+                 G711_EncodeSample(l, (int16_t)x), want);
+        }
+      }
+    }
+    for (c = 0U; c < 256U; c++)
+    {
+      int16_t want = (l == G711_ULAW) ? CHECK_UlawExpand((uint8_t)c) : CHECK_AlawExpand((uint8_t)c);
+
+      if (G711_DecodeSample(l, (uint8_t)c) != want)
+      {
+        if (samples++ == 0U)
+        {
+          printf("%s: 0x%02X decodes to %d, expected %d\n", LawNames[law], c,
+                 G711_DecodeSample(l, (uint8_t)c), want);
+        }
+      }
+    }
+
+    CHECK_Sine(1020.0, (double)G711_SAMPLE_RATE, Level, G711_SAMPLE_RATE);
+    G711_Encode(l, In, Codes, G711_SAMPLE_RATE);
+    G711_Decode(l, Codes, Out, G711_SAMPLE_RATE);
+    snr = CHECK_Snr(In, Out, G711_SAMPLE_RATE, 0U);
+    printf("%s: %u of 65536 inputs and %u of 256 codes off the G.191 reference, "
+           "1020 Hz SNR %.1f dB, limit %.1f\n", LawNames[law], codes, samples, snr,
+           CHECK_G711_SNR_DB);
+    failed |= (codes != 0U) || (samples != 0U) || (snr < CHECK_G711_SNR_DB);
+  }
+  return failed;
+}
+
+/* Runs the tandem over In */
+static void CHECK_G722Tandem(G722_ModeTypeDef Mode)
+{
+  G722_Init(&Encoder, Mode);
+  G722_Init(&Decoder, Mode);
+  G722_Encode(&Encoder, In, Codes, CHECK_FRAMES);
+  G722_Decode(&Decoder, Codes, Out, CHECK_FRAMES / 2U);
+}
+
+/* Codec delay: the best lag for white noise, which a sine cannot pin down */
+static uint32_t CHECK_G722Delay(double Level)
+{
+  double a = pow(10.0, Level / 20.0) * sqrt(3.0);
+  double best = -HUGE_VAL;
+  uint32_t delay = 0U;
+  uint32_t lag;
+  uint32_t i;
+
+  srand(1U);
+  for (i = 0U; i < CHECK_FRAMES; i++)
+  {
+    In[i] = (float)(a * ((double)rand() / (double)RAND_MAX * 2.0 - 1.0));
+  }
+  CHECK_G722Tandem(G722_MODE_64K);
+  for (lag = 0U; lag < CHECK_MAX_LAG; lag++)
+  {
+    double snr = CHECK_Snr(In, Out, CHECK_FRAMES, lag);
+
+    if (snr > best)
+    {
+      best = snr;
+      delay = lag;
+    }
+  }
+  return delay;
+}
+
+/* Codes and samples of uneven calls against one call */
+static int CHECK_G722Split(G722_ModeTypeDef Mode)
+{
+  static const uint32_t calls[] = { 2U, 14U, 320U, 666U, 1000U };
+  uint32_t c;
+  uint32_t done;
+
+  for (c = 0U; c < sizeof(calls) / sizeof(calls[0]); c++)
+  {
+    G722_Init(&Encoder, Mode);
+    G722_Init(&Decoder, Mode);
+    for (done = 0U; done < CHECK_FRAMES; done += calls[c])
+    {
+      uint32_t n = AUDIO_MIN(calls[c], CHECK_FRAMES - done);
+
+      G722_Encode(&Encoder, &In[done], &SplitCodes[done / 2U], n);
+      G722_Decode(&Decoder, &SplitCodes[done / 2U], &Split[done], n / 2U);
+    }
+    if ((memcmp(SplitCodes, Codes, CHECK_FRAMES / 2U) != 0) ||
+        (memcmp(Split, Out, sizeof(Split)) != 0))
+    {
+      printf("g722: calls of %u frames differ from a single call\n", calls[c]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int CHECK_G722(double Level)
+{
+  uint32_t delay = CHECK_G722Delay(Level);
+  int failed = 0;
+  uint32_t m;
+
+  for (m = 0U; m < sizeof(Modes) / sizeof(Modes[0]); m++)
+  {
+    double high;
+    double low;
+
+    CHECK_Sine(5500.0, (double)G722_SAMPLE_RATE, Level, CHECK_FRAMES);
+    CHECK_G722Tandem(Modes[m].Mode);
+    high = CHECK_Snr(In, Out, CHECK_FRAMES, delay);
+    CHECK_Sine(1020.0, (double)G722_SAMPLE_RATE, Level, CHECK_FRAMES);
+    CHECK_G722Tandem(Modes[m].Mode);
+    low = CHECK_Snr(In, Out, CHECK_FRAMES, delay);
+    printf("g722 %s: delay %u frames, 1020 Hz SNR %.1f dB (limit %.1f), 5500 Hz %.1f dB "
+           "(limit %.1f)\n", Modes[m].Name, delay, low, Modes[m].LowSnr, high, Modes[m].HighSnr);
+    failed |= (low < Modes[m].LowSnr) || (high < Modes[m].HighSnr);
+
+    /* In and Out still hold the 1020 Hz run */
+    failed |= CHECK_G722Split(Modes[m].Mode);
+  }
+  return failed;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  double level = -10.0;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'l': level = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: g7xx_check [-l dBFS]\n");
+        return 2;
+    }
+  }
+  if ((level > 0.0) || (level < -40.0))
+  {
+    fprintf(stderr, "g7xx_check: level out of -40 .. 0 dBFS\n");
+    return 2;
+  }
+
+  failed |= CHECK_G711(level);
+  failed |= CHECK_G722(level);
+  return failed;
+}
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""Renders a set of cases on the host and compares them with golden WAVs.
+
+A manifest lists the cases: an input WAV rendered through a preset, the
+golden output it must reproduce, and how closely:
+
+    {
+      "render": "render_host --preset {preset} {input} -o {output} --report {report}",
+      "cases": [
+        {"name": "eq_pink", "preset": "presets/eq10.txt", "input": "in/pink.wav",
+         "golden": "golden/eq_pink.wav", "match": "exact"},
+        {"name": "fft_vocoder", "preset": "presets/vocoder.txt", "input": "in/voice.wav",
+         "golden": "golden/fft_vocoder.wav", "match": {"max_abs": 2e-6, "snr_db": 110}}
+      ]
+    }
+
+Paths are relative to the manifest, and {base} in the render command is
+the manifest's directory. "exact" compares the sample bytes; the
+bounded criteria take the worst sample error (full scale = 1.0) and the
+error-to-signal ratio. Use "exact" for integer and reordered-but-identical
+code, and a bound where an optimization may legitimately change float
+rounding (FMA contraction, a different FFT factorization...).
+
+The render command may write a JSON report with a "cycles" figure (and
+"nodes" with per-node cycles), or "ns" as render_host.c does; it is stored
+next to the golden file on --update and compared on later runs, so a kernel
+that got slower is flagged along with one that drifted numerically. Host
+times are noisy: give --cpu-tolerance some room when comparing "ns".
+
+golden/manifest.json holds the cases kept with the sources: the EQ in
+both designs, the AGC, a MIDI-driven sampler and a plain gain, rendered
+from short generated inputs by render_host, built next to this script.
+After a change that is meant to alter the output, re-render them with
+--update and commit the new goldens with it; the host timings --update
+writes beside them are left out of the repository.
+
+The exit status is 1 if any case fails.
+
+Usage:
+    golden_check.py manifest.json [-k name ...] [-j 4] [--update] \\
+        [--cpu-tolerance 5] [-o results.json]
+
+    From AUDIO/Tools, with render_host built as its header shows:
+    ./golden_check.py golden/manifest.json
+"""
+
+import argparse
+import array
+import concurrent.futures
+import json
+import math
+import os
+import shlex
+import struct
+import subprocess
+import sys
+import tempfile
+
+
+def read_wav(path):
+    """Returns (rate, channels, raw sample bytes, samples as floats)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'RIFF' or data[8:12] != b'WAVE':
+        raise ValueError('%s: not a WAV file' % path)
+    fmt = None
+    raw = None
+    off = 12
+    while off + 8 <= len(data):
+        tag, size = struct.unpack_from('<4sI', data, off)
+        body = data[off + 8:off + 8 + size]
+        if tag == b'fmt ':
+            fmt = struct.unpack_from('<HHIIHH', body)
+            if fmt[0] == 0xFFFE and len(body) >= 26:
+                fmt = (struct.unpack_from('<H', body, 24)[0],) + fmt[1:]
+        elif tag == b'data':
+            raw = body
+        off += 8 + size + (size & 1)
+    if fmt is None or raw is None:
+        raise ValueError('%s: missing fmt or data chunk' % path)
+
+    code, channels, rate, _, _, bits = fmt
+    if code == 3 and bits == 32:
+        samples = array.array('f', raw)
+    elif code == 1 and bits == 16:
+        samples = [s / 32768.0 for s in array.array('h', raw)]
+    elif code == 1 and bits == 24:
+        samples = [(int.from_bytes(raw[i:i + 3], 'little', signed=True)) / 8388608.0
+                   for i in range(0, len(raw) - 2, 3)]
+    elif code == 1 and bits == 32:
+        samples = [s / 2147483648.0 for s in array.array('i', raw)]
+    else:
+        raise ValueError('%s: unsupported format %d / %d bits' % (path, code, bits))
+    return rate, channels, raw, samples
+
+
+def compare(out_path, golden_path, match):
+    """Returns (passed, details)."""
+    rate, channels, raw, out = read_wav(out_path)
+    g_rate, g_channels, g_raw, golden = read_wav(golden_path)
+    if (rate, channels, len(out)) != (g_rate, g_channels, len(golden)):
+        return False, {'error': 'shape %d Hz x %d x %d, golden %d Hz x %d x %d' % (
+            rate, channels, len(out), g_rate, g_channels, len(golden))}
+
+    worst = 0.0
+    worst_at = 0
+    err_power = 0.0
+    sig_power = 0.0
+    for i, (a, b) in enumerate(zip(out, golden)):
+        d = abs(a - b)
+        if d > worst:
+            worst, worst_at = d, i
+        err_power += d * d
+        sig_power += b * b
+    # A silent golden has no signal to compare with: any error is infinitely bad
+    if not err_power:
+        snr = float('inf')
+    elif not sig_power:
+        snr = float('-inf')
+    else:
+        snr = 10.0 * math.log10(sig_power / err_power)
+    details = {'max_abs': worst, 'first_worst_frame': worst_at // max(channels, 1),
+               'snr_db': snr if math.isfinite(snr) else str(snr), 'bit_exact': raw == g_raw}
+
+    if match == 'exact':
+        return raw == g_raw, details
+    passed = True
+    if 'max_abs' in match and worst > match['max_abs']:
+        passed = False
+    if 'snr_db' in match and snr < match['snr_db']:
+        passed = False
+    return passed, details
+
+
+def render(template, case, base, output, report):
+    fields = {
+        'preset': os.path.join(base, case['preset']) if case.get('preset') else '',
+        'input': os.path.join(base, case['input']),
+        'output': output,
+        'report': report,
+        'base': base,
+    }
+    args = [a.format(**fields) for a in shlex.split(template)]
+    proc = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if proc.returncode != 0:
+        raise RuntimeError('render failed (%d): %s' % (proc.returncode, proc.stdout.decode(errors='replace')[-400:]))
+    if os.path.exists(report) and os.path.getsize(report):
+        with open(report) as f:
+            return json.load(f)
+    return None
+
+
+def run_case(case, manifest, base, tmp, update, cpu_tolerance):
+    name = case['name']
+    golden = os.path.join(base, case['golden'])
+    cpu_path = os.path.splitext(golden)[0] + '.cpu.json'
+    output = os.path.join(tmp, name + '.wav')
+    report = os.path.join(tmp, name + '.report.json')
+    result = {'name': name}
+    try:
+        cpu = render(case.get('render', manifest['render']), case, base, output, report)
+        if update:
+            os.makedirs(os.path.dirname(golden) or '.', exist_ok=True)
+            os.replace(output, golden)
+            if cpu is not None:
+                with open(cpu_path, 'w') as f:
+                    json.dump(cpu, f, indent=1)
+            result['status'] = 'updated'
+            return result
+
+        passed, details = compare(output, golden, case.get('match', 'exact'))
+        result.update(details)
+        result['status'] = 'pass' if passed else 'FAIL'
+        key = 'cycles' if cpu is not None and 'cycles' in cpu else 'ns'
+        if cpu is not None and key in cpu:
+            result['cycles'] = cpu[key]
+            if os.path.exists(cpu_path):
+                with open(cpu_path) as f:
+                    base_cycles = json.load(f).get(key)
+                if base_cycles:
+                    result['cycles_delta_pct'] = 100.0 * (cpu[key] - base_cycles) / base_cycles
+                    if cpu_tolerance is not None and result['cycles_delta_pct'] > cpu_tolerance:
+                        result['status'] = 'SLOWER'
+    except (OSError, ValueError, RuntimeError) as exc:
+        result['status'] = 'ERROR'
+        result['error'] = str(exc)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('manifest', help='case list (JSON)')
+    parser.add_argument('-k', '--case', action='append', help='run only this case (repeatable)')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count() or 1, help='parallel renders')
+    parser.add_argument('--update', action='store_true', help='replace the golden files with the new renders')
+    parser.add_argument('--cpu-tolerance', type=float, help='fail a case whose cycles grew by more (percent)')
+    parser.add_argument('-o', '--output', help='results (JSON)')
+    args = parser.parse_args()
+
+    with open(args.manifest) as f:
+        manifest = json.load(f)
+    base = os.path.dirname(os.path.abspath(args.manifest))
+    cases = [c for c in manifest['cases'] if not args.case or c['name'] in args.case]
+    if not cases:
+        sys.exit('no cases to run')
+
+    with tempfile.TemporaryDirectory() as tmp:
+        with concurrent.futures.ThreadPoolExecutor(max_workers=max(args.jobs, 1)) as pool:
+            results = list(pool.map(lambda c: run_case(c, manifest, base, tmp, args.update, args.cpu_tolerance),
+                                    cases))
+
+    failed = 0
+    for r in results:
+        line = '%-24s %-7s' % (r['name'], r['status'])
+        if 'max_abs' in r:
+            line += ' max %.3g  snr %s dB' % (r['max_abs'], r['snr_db'] if isinstance(r['snr_db'], str)
+                                               else '%.1f' % r['snr_db'])
+        if 'cycles_delta_pct' in r:
+            line += '  cycles %+.1f%%' % r['cycles_delta_pct']
+        if 'error' in r:
+            line += '  ' + r['error']
+        print(line)
+        failed += r['status'] not in ('pass', 'updated')
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(results, f, indent=1)
+    print('%d cases, %d failed' % (len(results), failed))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Checks an interrupt latency report against a baseline.
+
+The firmware built with AUDIO_IRQ_BENCH=1 prints one JSON object at boot
+(IRQ_WriteReport() in audio_irq.c, ITM port 1). The capture may hold other
+output around it; the first line starting with '{' is taken. Every figure is
+a [min, max] pair in core cycles. Minimums are deterministic and are compared
+against the baseline with a small tolerance; maximums only get a warning,
+since a debugger poll or a flash prefetch miss can stretch a single run.
+
+The exit status is 1 when a minimum regressed, so the check can gate a
+hardware-in-the-loop job.
+
+Usage:
+    irqbench_check.py capture.txt [-b baseline.json] [-t 2] [--update]
+"""
+
+import argparse
+import json
+import sys
+
+FIELDS = ('entry', 'preempt', 'tail_chain', 'fp_entry_lazy', 'fp_entry_eager', 'fp_lazy_push')
+
+
+def load_report(path):
+    with open(path, 'rb') as f:
+        for line in f.read().decode('ascii', 'replace').splitlines():
+            line = line.strip('\x00 \r')
+            if line.startswith('{'):
+                return json.loads(line)
+    sys.exit('%s: no report found' % path)
+
+
+def flatten(report):
+    """Yields (name, [min, max]) for every figure of a report."""
+    for field in FIELDS:
+        value = report.get(field)
+        if value is None:
+            continue
+        if value and isinstance(value[0], list):
+            for level, pair in enumerate(value):
+                yield '%s[%d]' % (field, level), pair
+        else:
+            yield field, value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('capture', help='SWO / UART capture holding the report')
+    parser.add_argument('-b', '--baseline', help='baseline report (JSON)')
+    parser.add_argument('-t', '--tolerance', type=int, default=2, help='cycles allowed above the baseline minimum')
+    parser.add_argument('--update', action='store_true', help='write the report as the new baseline')
+    args = parser.parse_args()
+
+    report = load_report(args.capture)
+    mhz = report.get('core_hz', 100000000) / 1e6
+    print('%-20s %6s %6s %9s' % ('figure', 'min', 'max', 'min ns'))
+    for name, (lo, hi) in flatten(report):
+        print('%-20s %6d %6d %9.1f' % (name, lo, hi, lo * 1000.0 / mhz))
+
+    if args.update:
+        if not args.baseline:
+            parser.error('--update needs --baseline')
+        with open(args.baseline, 'w') as f:
+            json.dump(report, f, indent=1)
+        return
+    if not args.baseline:
+        return
+
+    with open(args.baseline) as f:
+        base_report = json.load(f)
+    baseline = dict(flatten(base_report))
+    failed = 0
+    for name, (lo, hi) in flatten(report):
+        if name not in baseline:
+            continue
+        base_lo, base_hi = baseline[name]
+        if lo > base_lo + args.tolerance:
+            print('REGRESSION %s: min %d cycles, baseline %d' % (name, lo, base_lo))
+            failed += 1
+        elif hi > 2 * max(base_hi, 1):
+            print('warning %s: max %d cycles, baseline %d' % (name, hi, base_hi))
+    if report.get('core_hz') != base_report.get('core_hz'):
+        print('warning: core clock differs from the baseline')
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
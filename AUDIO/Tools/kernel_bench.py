@@ -0,0 +1,434 @@
+#!/usr/bin/env python3
+"""Runs the firmware DSP kernels in an emulator under a Cortex-M4 cycle model.
+
+The firmware must be built with AUDIO_KERNEL_BENCH=1: audio_bench.c then
+links a registry (BenchKernels) of Setup/Run pairs into the ELF. This tool
+loads the ELF segments at their run addresses (so .data is initialized and
+.bss zeroed as if the startup code had run), enables the FPU, and for each
+kernel calls Setup, then Run twice: a cold run, and a warm run as the audio
+loop would see it. The warm run is the reported figure.
+
+Cycles are counted per executed instruction, following the Cortex-M4 TRM
+timings: single-cycle ALU and MAC, pipelined neighbouring loads and stores,
+1+N multiple transfers, 2-12 cycle divisions from the operand widths,
+3-cycle FPU multiply-accumulates, 14-cycle VDIV/VSQRT and a pipeline refill
+on every taken branch. Flash is modelled with its wait states behind the
+ART accelerator: 128-bit lines, a 64-line instruction cache, an 8-line data
+cache and a prefetch that hides the wait states of sequential code that
+spends long enough on each line. The result is an estimate to be checked
+once against the DWT counter on the board; what matters is that it is
+deterministic, so any change in an inner loop shows up.
+
+The report is JSON, one entry per kernel with the cycle count, cycles per
+frame, flash stalls, instruction mix and hottest functions. Against a
+baseline, a kernel that got slower than the tolerance fails the run (exit
+status 1).
+
+Needs the unicorn and capstone packages (pip install unicorn capstone).
+
+Usage:
+    kernel_bench.py Debug/AUDIO.elf -o bench.json [-b baseline.json] \\
+        [-t 1.0] [--update] [--ws 3] [--no-art] [-k fir_64tap ...]
+"""
+
+import argparse
+import bisect
+import collections
+import json
+import struct
+import sys
+
+try:
+    from unicorn import (Uc, UcError, UC_ARCH_ARM, UC_MODE_THUMB, UC_MODE_MCLASS,
+                         UC_HOOK_CODE, UC_HOOK_MEM_READ)
+    from unicorn import arm_const as uc_arm
+    from capstone import Cs, CS_ARCH_ARM, CS_MODE_THUMB, CS_MODE_MCLASS
+    from capstone import arm_const as cs_arm
+except ImportError as exc:
+    sys.exit('kernel_bench.py needs unicorn and capstone: %s' % exc)
+
+FLASH_BASE = 0x08000000
+FLASH_SIZE = 0x00100000         # STM32F412ZG: 1 MB
+RAM_BASE = 0x20000000
+RAM_SIZE = 0x00040000           # 256 KB
+PERIPH = ((0x40000000, 0x00080000), (0x50000000, 0x00080000), (0xE0000000, 0x00100000))
+RETURN = FLASH_BASE + FLASH_SIZE - 4    # 'b .' the kernels return to
+PROBE = FLASH_BASE + FLASH_SIZE - 12    # FPU probe: vmov s0, r0 then 'b .'
+KERNEL = struct.Struct('<IIII')         # BENCH_KernelTypeDef
+MAX_INSNS = 50000000
+
+ART_LINE = 16                   # bytes per flash line
+ART_ICACHE_LINES = 64
+ART_DCACHE_LINES = 8
+
+LOADS = {'ldr', 'ldrb', 'ldrh', 'ldrsb', 'ldrsh', 'ldrt', 'ldrbt', 'ldrht', 'ldrsbt',
+         'ldrsht', 'ldrex', 'ldrexb', 'ldrexh', 'vldr'}
+STORES = {'str', 'strb', 'strh', 'strt', 'strbt', 'strht', 'strex', 'strexb', 'strexh', 'vstr'}
+MULTI_BASE = {'ldm', 'ldmdb', 'ldmia', 'stm', 'stmdb', 'stmia', 'vldmia', 'vldmdb', 'vstmia', 'vstmdb'}
+MULTI_LIST = {'push', 'pop', 'vpush', 'vpop'}
+FPU_MAC = {'vmla', 'vmls', 'vnmla', 'vnmls', 'vfma', 'vfms', 'vfnma', 'vfnms'}
+FPU_DIV = {'vdiv', 'vsqrt'}
+MUL_PREFIXES = ('mul', 'smul', 'smla', 'smls', 'smus', 'smua', 'smmu', 'smml', 'smma', 'umul', 'umla', 'umaa')
+
+
+def read_elf(path):
+    """Returns (loadable segments, symbols, function ranges)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+        sys.exit('%s: not a 32-bit little-endian ELF' % path)
+    (_, machine, _, _, phoff, shoff, _, _, phentsize, phnum,
+     shentsize, shnum, _) = struct.unpack_from('<HHIIIIIHHHHHH', data, 16)
+    if machine != 40:
+        sys.exit('%s: not an ARM ELF' % path)
+
+    segments = []
+    for i in range(phnum):
+        p_type, offset, vaddr, _, filesz, memsz, _, _ = struct.unpack_from('<8I', data, phoff + i * phentsize)
+        if p_type == 1 and memsz:
+            segments.append((vaddr, data[offset:offset + filesz], memsz))
+
+    symbols = {}
+    funcs = []
+    sections = [struct.unpack_from('<10I', data, shoff + i * shentsize) for i in range(shnum)]
+    for sh in sections:
+        if sh[1] != 2:          # SHT_SYMTAB
+            continue
+        strtab = sections[sh[6]][4]
+        for off in range(sh[4], sh[4] + sh[5], 16):
+            name_off, value, size, info, _, _ = struct.unpack_from('<IIIBBH', data, off)
+            end = data.index(b'\0', strtab + name_off)
+            name = data[strtab + name_off:end].decode('ascii', 'replace')
+            if not name:
+                continue
+            symbols[name] = (value, size)
+            if info & 0xF == 2 and size:        # STT_FUNC
+                funcs.append(((value & ~1), (value & ~1) + size, name))
+    funcs.sort()
+    return segments, symbols, funcs
+
+
+def read_cstring(uc, address):
+    out = bytearray()
+    while len(out) < 64:
+        byte = uc.mem_read(address + len(out), 1)
+        if byte == b'\0':
+            break
+        out += byte
+    return out.decode('ascii', 'replace')
+
+
+class Art(object):
+    """Flash wait states behind the STM32F4 ART accelerator."""
+
+    def __init__(self, ws, enabled):
+        self.ws = ws
+        self.enabled = enabled
+        self.reset()
+
+    def reset(self):
+        self.icache = collections.OrderedDict()
+        self.dcache = collections.OrderedDict()
+        self.line = None
+        self.line_start = 0
+
+    @staticmethod
+    def in_flash(address):
+        return FLASH_BASE <= address < FLASH_BASE + FLASH_SIZE
+
+    @staticmethod
+    def _touch(cache, line, size):
+        if line in cache:
+            cache.move_to_end(line)
+            return True
+        cache[line] = True
+        if len(cache) > size:
+            cache.popitem(last=False)
+        return False
+
+    def fetch(self, address, now):
+        """Stall cycles to fetch the line holding address."""
+        if not self.in_flash(address):
+            self.line = None
+            return 0
+        line = address // ART_LINE
+        if line == self.line:
+            return 0
+        prev, start = self.line, self.line_start
+        self.line, self.line_start = line, now
+        if not self.enabled:
+            return self.ws
+        if self._touch(self.icache, line, ART_ICACHE_LINES):
+            return 0
+        if prev is not None and line == prev + 1:
+            # Prefetched while the previous line was executing
+            return max(0, self.ws + 1 - (now - start))
+        return self.ws
+
+    def read(self, address):
+        """Stall cycles of a data read (literal pools, const tables)."""
+        if not self.in_flash(address):
+            return 0
+        if self.enabled and self._touch(self.dcache, address // ART_LINE, ART_DCACHE_LINES):
+            return 0
+        return self.ws
+
+
+class CycleModel(object):
+    """Cortex-M4 instruction timings, applied from a code hook."""
+
+    def __init__(self, uc, funcs, art):
+        self.uc = uc
+        self.md = Cs(CS_ARCH_ARM, CS_MODE_THUMB | CS_MODE_MCLASS)
+        self.md.detail = True
+        self.funcs = funcs
+        self.starts = [f[0] for f in funcs]
+        self.art = art
+        self.decoded = {}
+        self.reset()
+
+    def reset(self):
+        self.cycles = 0
+        self.insns = 0
+        self.stalls = 0
+        self.mix = collections.Counter()
+        self.hot = collections.Counter()
+        self.next_pc = None
+        self.prev_memory = False
+
+    def _func(self, address):
+        i = bisect.bisect_right(self.starts, address) - 1
+        if i >= 0 and address < self.funcs[i][1]:
+            return self.funcs[i][2]
+        return '0x%08x' % address
+
+    def _uc_reg(self, cs_reg):
+        return getattr(uc_arm, 'UC_ARM_REG_' + self.md.reg_name(cs_reg).upper())
+
+    def _decode(self, address, size):
+        code = bytes(self.uc.mem_read(address, size))
+        insn = next(self.md.disasm(code, address), None)
+        name = insn.insn_name() if insn else '?'
+        regs = [op.reg for op in insn.operands if op.type == cs_arm.ARM_OP_REG] if insn else []
+        words = sum(2 if self.md.reg_name(r).startswith('d') else 1 for r in regs)
+        div = None
+        memory = False
+
+        if name.startswith('it') and set(name[2:]) <= set('te'):
+            kind, cost = 'other', 0             # folded
+        elif name in ('ldrd', 'strd'):
+            kind, cost = ('load' if name == 'ldrd' else 'store'), 3
+        elif name in LOADS or name in STORES:
+            kind, cost, memory = ('load' if name in LOADS else 'store'), 2, True
+        elif name in MULTI_BASE:
+            kind, cost = ('load' if 'ld' in name else 'store'), 1 + max(words - 1, 1)
+        elif name in MULTI_LIST:
+            kind, cost = ('load' if name.endswith('pop') else 'store'), 1 + max(words, 1)
+        elif name in ('sdiv', 'udiv'):
+            kind, cost = 'div', 2
+            div = (name == 'sdiv', self._uc_reg(regs[-2]), self._uc_reg(regs[-1]))
+        elif name in ('mla', 'mls'):
+            kind, cost = 'mul', 2
+        elif name.startswith(MUL_PREFIXES):
+            kind, cost = 'mul', 1
+        elif name in FPU_MAC:
+            kind, cost = 'fpu_mac', 3
+        elif name in FPU_DIV:
+            kind, cost = 'fpu_div', 14
+        elif name.startswith('v'):
+            kind, cost = 'fpu', 1
+        elif name in ('b', 'bl', 'bx', 'blx', 'cbz', 'cbnz', 'tbb', 'tbh'):
+            kind, cost = 'branch', 1
+        else:
+            kind, cost = 'alu', 1
+        entry = (kind, cost, memory, div, self._func(address))
+        self.decoded[address] = entry
+        return entry
+
+    @staticmethod
+    def _div_cycles(signed, dividend, divisor):
+        if signed:
+            dividend = abs(dividend - (1 << 32) if dividend & 0x80000000 else dividend)
+            divisor = abs(divisor - (1 << 32) if divisor & 0x80000000 else divisor)
+        if divisor == 0 or dividend < divisor:
+            return 2
+        # Early termination: about four quotient bits per cycle
+        return min(12, 2 + (dividend.bit_length() - divisor.bit_length() + 4) // 4)
+
+    def on_code(self, uc, address, size, _):
+        entry = self.decoded.get(address) or self._decode(address, size)
+        kind, cost, memory, div, func = entry
+
+        stall = self.art.fetch(address, self.cycles)
+        if (address + size - 1) // ART_LINE != address // ART_LINE:
+            stall += self.art.fetch(address + size - 1, self.cycles)
+        if self.next_pc is not None and address != self.next_pc:
+            # Taken branch: pipeline refill, one more for an unaligned 32-bit target
+            cost += 2 if (size == 4 and address & 2) else 1
+            self.mix['branch_taken'] += 1
+        if memory and self.prev_memory:
+            cost -= 1           # pipelined with the previous load / store
+        if div is not None:
+            cost = self._div_cycles(div[0], uc.reg_read(div[1]), uc.reg_read(div[2]))
+
+        self.cycles += cost + stall
+        self.stalls += stall
+        self.insns += 1
+        self.mix[kind] += 1
+        self.hot[func] += cost + stall
+        self.next_pc = address + size
+        self.prev_memory = memory
+
+    def on_read(self, uc, access, address, size, value, _):
+        stall = self.art.read(address)
+        self.cycles += stall
+        self.stalls += stall
+
+
+def make_emulator(segments):
+    uc = Uc(UC_ARCH_ARM, UC_MODE_THUMB | UC_MODE_MCLASS)
+    model = getattr(uc_arm, 'UC_CPU_ARM_CORTEX_M4', None)
+    if model is not None and hasattr(uc, 'ctl_set_cpu_model'):
+        uc.ctl_set_cpu_model(model)
+    uc.mem_map(FLASH_BASE, FLASH_SIZE)
+    uc.mem_map(RAM_BASE, RAM_SIZE)
+    for base, size in PERIPH:
+        try:
+            uc.mem_map(base, size)
+        except UcError:
+            pass                # already modelled by this Unicorn build
+    for vaddr, data, memsz in segments:
+        if data:
+            uc.mem_write(vaddr, data)
+
+    # CP10/CP11 full access, as SystemInit() does through SCB->CPACR
+    for reg in ('UC_ARM_REG_CPACR', 'UC_ARM_REG_C1_C0_2'):
+        if hasattr(uc_arm, reg):
+            try:
+                uc.reg_write(getattr(uc_arm, reg), uc.reg_read(getattr(uc_arm, reg)) | (0xF << 20))
+            except UcError:
+                pass
+    if hasattr(uc_arm, 'UC_ARM_REG_FPEXC'):
+        try:
+            uc.reg_write(uc_arm.UC_ARM_REG_FPEXC, 0x40000000)
+        except UcError:
+            pass
+    uc.mem_write(RETURN, b'\xfe\xe7')
+    uc.mem_write(PROBE, b'\x00\xee\x10\x0a\xfe\xe7')
+    try:
+        uc.emu_start(PROBE | 1, PROBE + 4, count=4)
+    except UcError as exc:
+        sys.exit('the FPU is not usable in this Unicorn build (%s); use unicorn >= 2.0.1' % exc)
+    return uc
+
+
+def call(uc, function, stack, budget=MAX_INSNS):
+    uc.reg_write(uc_arm.UC_ARM_REG_SP, stack)
+    uc.reg_write(uc_arm.UC_ARM_REG_LR, RETURN | 1)
+    uc.emu_start(function | 1, RETURN, count=budget)
+    pc = uc.reg_read(uc_arm.UC_ARM_REG_PC) & ~1
+    if pc != RETURN:
+        raise RuntimeError('did not return within %d instructions (pc 0x%08x)' % (budget, pc))
+
+
+def run_kernels(path, ws, art_enabled, only):
+    segments, symbols, funcs = read_elf(path)
+    if 'BenchKernels' not in symbols:
+        sys.exit('%s: no BenchKernels, build with AUDIO_KERNEL_BENCH=1' % path)
+    uc = make_emulator(segments)
+    stack = symbols.get('_estack', (RAM_BASE + RAM_SIZE, 0))[0] & ~7
+    table, size = symbols['BenchKernels']
+    count = struct.unpack('<I', uc.mem_read(symbols['BenchKernelCount'][0], 4))[0] \
+        if 'BenchKernelCount' in symbols else size // KERNEL.size
+
+    art = Art(ws, art_enabled)
+    model = CycleModel(uc, funcs, art)
+    results = collections.OrderedDict()
+    for i in range(count):
+        name_ptr, setup, run, frames = KERNEL.unpack(uc.mem_read(table + i * KERNEL.size, KERNEL.size))
+        name = read_cstring(uc, name_ptr)
+        if only and name not in only:
+            continue
+        try:
+            call(uc, setup, stack)
+            hooks = [uc.hook_add(UC_HOOK_CODE, model.on_code),
+                     uc.hook_add(UC_HOOK_MEM_READ, model.on_read)]
+            try:
+                art.reset()
+                model.reset()
+                call(uc, run, stack)
+                cold = model.cycles
+                model.reset()
+                call(uc, run, stack)
+            finally:
+                for hook in hooks:
+                    uc.hook_del(hook)
+        except (UcError, RuntimeError) as exc:
+            results[name] = {'error': str(exc)}
+            continue
+        results[name] = collections.OrderedDict([
+            ('frames', frames),
+            ('instructions', model.insns),
+            ('cycles', model.cycles),
+            ('cold_cycles', cold),
+            ('cycles_per_frame', round(model.cycles / float(max(frames, 1)), 2)),
+            ('flash_stall_cycles', model.stalls),
+            ('mix', dict(model.mix)),
+            ('hot', model.hot.most_common(5)),
+        ])
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('elf', help='firmware built with AUDIO_KERNEL_BENCH=1')
+    parser.add_argument('-o', '--output', help='JSON report')
+    parser.add_argument('-b', '--baseline', help='baseline report (JSON)')
+    parser.add_argument('-t', '--tolerance', type=float, default=1.0, help='percent allowed above the baseline')
+    parser.add_argument('--update', action='store_true', help='write the report as the new baseline')
+    parser.add_argument('--ws', type=int, default=3, help='flash wait states (3 at 100 MHz)')
+    parser.add_argument('--no-art', action='store_true', help='model flash with the ART accelerator off')
+    parser.add_argument('-k', '--kernel', action='append', help='run only this kernel (repeatable)')
+    args = parser.parse_args()
+
+    kernels = run_kernels(args.elf, args.ws, not args.no_art, set(args.kernel or ()))
+    report = collections.OrderedDict([('elf', args.elf), ('ws', args.ws), ('art', not args.no_art),
+                                      ('kernels', kernels)])
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent=1)
+
+    print('%-20s %8s %10s %10s %10s' % ('kernel', 'insns', 'cycles', 'cyc/frame', 'stalls'))
+    for name, k in kernels.items():
+        if 'error' in k:
+            print('%-20s error: %s' % (name, k['error']))
+        else:
+            print('%-20s %8d %10d %10.2f %10d' % (name, k['instructions'], k['cycles'],
+                                                  k['cycles_per_frame'], k['flash_stall_cycles']))
+
+    if args.update:
+        if not args.baseline:
+            parser.error('--update needs --baseline')
+        with open(args.baseline, 'w') as f:
+            json.dump(report, f, indent=1)
+        return
+    failed = sum(1 for k in kernels.values() if 'error' in k)
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if (baseline.get('ws'), baseline.get('art')) != (args.ws, not args.no_art):
+            print('warning: the baseline was taken with another flash model')
+        for name, k in kernels.items():
+            base = baseline.get('kernels', {}).get(name)
+            if 'error' in k or not base or 'cycles' not in base:
+                continue
+            limit = base['cycles'] * (1.0 + args.tolerance / 100.0)
+            if k['cycles'] > limit:
+                print('REGRESSION %s: %d cycles, baseline %d (+%.1f%%)' % (
+                    name, k['cycles'], base['cycles'], 100.0 * (k['cycles'] - base['cycles']) / base['cycles']))
+                failed += 1
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
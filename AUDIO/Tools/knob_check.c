@@ -0,0 +1,405 @@
+/**
+  ******************************************************************************
+  * @file    knob_check.c
+  * @brief   Host check of the audio_knob.c scan filter.
+  *
+  *          Feeds KNOB_Process() simulated scan halves, as the DMA interrupt
+  *          would: every knob is a wiper level plus uniform noise, quantized
+  *          to 12-bit codes, sampled at KNOB_SCAN_RATE. The parameter queue
+  *          is drained after each half. Checked, on every knob at once:
+  *            - the first report of a knob held at each of the 4096 codes is
+  *              the code scaled to KNOB_FULL_SCALE, ends snapped;
+  *            - a noisy knob at rest reports once, then never again;
+  *            - a step is first reported within two halves (2 ms) of the
+  *              scan it happens on, at every position within a half, and
+  *              the reports settle within the deadband of the new level in
+  *              a few more;
+  *            - a noisy sweep across the range reports a monotonic sequence
+  *              that starts and ends exactly on the ends;
+  *            - with the queue full nothing is lost: every knob is counted
+  *              as an overrun and reported on the next half.
+  *
+  *          Build (from AUDIO/Tools; audio_knob.c includes the HAL headers,
+  *          the few HAL calls of KNOB_Start are stubbed below and never run):
+  *            gcc -O2 -std=gnu11 -DSTM32F412Zx -DUSE_HAL_DRIVER -I../Core/Inc \
+  *                -I../Drivers/STM32F4xx_HAL_Driver/Inc \
+  *                -I../Drivers/CMSIS/Device/ST/STM32F4xx/Include \
+  *                -I../Drivers/CMSIS/Include -Wno-pointer-to-int-cast \
+  *                -Wno-int-to-pointer-cast -o knob_check knob_check.c \
+  *                ../Core/Src/audio_knob.c ../Core/Src/audio_async.c -lm
+  *
+  *          Usage:
+  *            knob_check [-k knobs] [-n noise codes]
+  *
+  *          Defaults: 12 knobs, noise of +/-12 codes (about the deadband).
+  *          The exit status is 1 at the first check that fails.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_knob.h"
+#include "main.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_ADC_MAX             4095.0
+#define CHECK_PARAM_BASE          100U
+#define CHECK_MAX_EVENTS          2048U
+#define CHECK_REST_HALVES         10000U  /* 10 s */
+#define CHECK_STEP_HALVES         50U
+#define CHECK_STEP_EVENTS         10U     /* Reports a step may take to settle */
+#define CHECK_SWEEP_HALVES        1000U
+
+/* Private typedef -----------------------------------------------------------*/
+/* Wiper level of a knob at a scan, in ADC codes, before noise */
+typedef double (*CHECK_SignalTypeDef)(uint32_t Knob, uint64_t Scan);
+
+typedef struct
+{
+  uint32_t Half[CHECK_MAX_EVENTS];    /* Half that pushed the report       */
+  uint16_t Value[CHECK_MAX_EVENTS];
+  uint32_t Count;
+} CHECK_EventsTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static KNOB_HandleTypeDef Surface;
+static ASYNC_QueueTypeDef Queue;
+static CHECK_EventsTypeDef Events[KNOB_MAX];
+static uint16_t Buffer[KNOB_OVERSAMPLE * KNOB_MAX];
+static uint32_t NumKnobs = 12U;
+static double Noise = 12.0;
+static uint64_t ScanCount;
+static uint32_t HalfCount;
+static double Level[2][KNOB_MAX];     /* Before and after a step, codes    */
+static uint64_t StepScan;
+
+/* Private functions ---------------------------------------------------------*/
+/* Simulated HAL: KNOB_Start and KNOB_Stop are never called */
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+  return 50000000U;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  (void)IRQn;
+  (void)PreemptPriority;
+  (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+static void CHECK_Init(void)
+{
+  KNOB_ConfigTypeDef cfg[KNOB_MAX];
+  uint32_t k;
+
+  memset(cfg, 0, sizeof(cfg));
+  for (k = 0U; k < NumKnobs; k++)
+  {
+    cfg[k].Channel = (uint8_t)k;
+    cfg[k].ParamId = (uint16_t)(CHECK_PARAM_BASE + k);
+  }
+  memset(&Queue, 0, sizeof(Queue));
+  memset(Events, 0, sizeof(Events));
+  if (KNOB_Init(&Surface, cfg, NumKnobs, &Queue) != AUDIO_OK)
+  {
+    fprintf(stderr, "knob_check: KNOB_Init failed\n");
+    exit(2);
+  }
+  ScanCount = 0U;
+  HalfCount = 0U;
+}
+
+static void CHECK_Drain(void)
+{
+  ASYNC_EventTypeDef e;
+
+  while (ASYNC_Pop(&Queue, &e) != 0U)
+  {
+    CHECK_EventsTypeDef *ev = &Events[e.Id - CHECK_PARAM_BASE];
+
+    if (ev->Count < CHECK_MAX_EVENTS)
+    {
+      ev->Half[ev->Count]  = HalfCount;
+      ev->Value[ev->Count] = (uint16_t)e.Value;
+      ev->Count++;
+    }
+  }
+}
+
+/* One DMA half: KNOB_OVERSAMPLE scans of every knob, then the queue drained */
+static void CHECK_Half(CHECK_SignalTypeDef Signal, double NoiseCodes, uint32_t Drain)
+{
+  uint32_t s;
+  uint32_t k;
+
+  for (s = 0U; s < KNOB_OVERSAMPLE; s++, ScanCount++)
+  {
+    for (k = 0U; k < NumKnobs; k++)
+    {
+      double x = Signal(k, ScanCount) + NoiseCodes * ((double)rand() / RAND_MAX * 2.0 - 1.0);
+
+      Buffer[s * NumKnobs + k] = (uint16_t)lrint(AUDIO_CLAMP(x, 0.0, CHECK_ADC_MAX));
+    }
+  }
+  KNOB_Process(&Surface, Buffer);
+  if (Drain != 0U)
+  {
+    CHECK_Drain();
+  }
+  HalfCount++;
+}
+
+/* Reported value for a steady code, as the filter scales and snaps it */
+static uint32_t CHECK_Expected(double Code)
+{
+  uint32_t v = (uint32_t)lrint(Code * KNOB_FULL_SCALE / CHECK_ADC_MAX);
+
+  if (v < KNOB_DEFAULT_DEADBAND)
+  {
+    return 0U;
+  }
+  if (v > KNOB_FULL_SCALE - KNOB_DEFAULT_DEADBAND)
+  {
+    return KNOB_FULL_SCALE;
+  }
+  return v;
+}
+
+static double CHECK_Steady(uint32_t Knob, uint64_t Scan)
+{
+  (void)Scan;
+  return Level[0][Knob];
+}
+
+static double CHECK_Step(uint32_t Knob, uint64_t Scan)
+{
+  return Level[(Scan >= StepScan) ? 1 : 0][Knob];
+}
+
+/* Even knobs sweep up, odd ones down, a little past both ends */
+static double CHECK_Sweep(uint32_t Knob, uint64_t Scan)
+{
+  double x = -100.0 + (CHECK_ADC_MAX + 200.0) * (double)Scan /
+             (double)(CHECK_SWEEP_HALVES * KNOB_OVERSAMPLE);
+
+  x = AUDIO_CLAMP(x, -100.0, CHECK_ADC_MAX + 100.0);
+  return ((Knob % 2U) == 0U) ? x : CHECK_ADC_MAX - x;
+}
+
+static int CHECK_Codes(void)
+{
+  uint32_t off = 0U;
+  uint32_t c;
+  uint32_t k;
+
+  for (c = 0U; c <= (uint32_t)CHECK_ADC_MAX; c++)
+  {
+    CHECK_Init();
+    for (k = 0U; k < NumKnobs; k++)
+    {
+      Level[0][k] = (double)c;
+    }
+    CHECK_Half(CHECK_Steady, 0.0, 1U);
+    for (k = 0U; k < NumKnobs; k++)
+    {
+      if ((Events[k].Count != 1U) || (Events[k].Value[0] != CHECK_Expected((double)c)))
+      {
+        if (off == 0U)
+        {
+          printf("codes: knob %u at code %u reports %u, expected %u\n", k, c,
+                 (Events[k].Count != 0U) ? Events[k].Value[0] : 0U, CHECK_Expected((double)c));
+        }
+        off++;
+        break;
+      }
+    }
+  }
+  printf("codes: %u of 4096 codes on %u knobs reported off\n", off, NumKnobs);
+  return off != 0U;
+}
+
+static int CHECK_Rest(void)
+{
+  uint32_t extra = 0U;
+  uint32_t k;
+
+  CHECK_Init();
+  for (k = 0U; k < NumKnobs; k++)
+  {
+    Level[0][k] = 200.0 + 330.0 * (double)k;
+  }
+  while (HalfCount < CHECK_REST_HALVES)
+  {
+    CHECK_Half(CHECK_Steady, Noise, 1U);
+  }
+  for (k = 0U; k < NumKnobs; k++)
+  {
+    extra += Events[k].Count - 1U;
+  }
+  printf("rest: %u reports past the first over %u s, noise +/-%.0f codes\n", extra,
+         CHECK_REST_HALVES / 1000U, Noise);
+  return extra != 0U;
+}
+
+static int CHECK_Steps(void)
+{
+  uint32_t worst = 0U;
+  uint32_t most = 0U;
+  int failed = 0;
+  uint32_t o;
+  uint32_t k;
+
+  for (o = 0U; o < KNOB_OVERSAMPLE; o++)
+  {
+    CHECK_Init();
+    for (k = 0U; k < NumKnobs; k++)
+    {
+      double low = 300.0 + 150.0 * (double)k;
+
+      Level[(k % 2U) == 0U ? 0 : 1][k] = low;
+      Level[(k % 2U) == 0U ? 1 : 0][k] = low + 1500.0;
+    }
+    StepScan = (uint64_t)CHECK_STEP_HALVES * KNOB_OVERSAMPLE + o;
+    while (HalfCount < 2U * CHECK_STEP_HALVES)
+    {
+      CHECK_Half(CHECK_Step, Noise, 1U);
+    }
+
+    for (k = 0U; k < NumKnobs; k++)
+    {
+      const CHECK_EventsTypeDef *ev = &Events[k];
+      uint32_t want = CHECK_Expected(Level[1][k]);
+      uint32_t last = ev->Value[ev->Count - 1U];
+      uint32_t latency;
+
+      /* The first report is the start, the second the step */
+      if ((ev->Count < 2U) || (ev->Half[1] < CHECK_STEP_HALVES))
+      {
+        printf("step: knob %u at offset %u not reported, or reported early\n", k, o);
+        return 1;
+      }
+      /* Scans from the step to the end of the half that reported it */
+      latency = (uint32_t)((uint64_t)(ev->Half[1] + 1U) * KNOB_OVERSAMPLE - StepScan);
+      worst = AUDIO_MAX(worst, latency);
+      most = AUDIO_MAX(most, ev->Count - 1U);
+      failed |= (abs((int32_t)last - (int32_t)want) > (int32_t)KNOB_DEFAULT_DEADBAND) ||
+                (ev->Count - 1U > CHECK_STEP_EVENTS);
+    }
+  }
+  printf("step: first report %.3f ms after the step at worst (limit 2), settled within the "
+         "deadband in %u reports at most (limit %u)\n",
+         (double)worst * 1000.0 / KNOB_SCAN_RATE, most, CHECK_STEP_EVENTS);
+  failed |= (worst > 2U * KNOB_OVERSAMPLE);
+  return failed;
+}
+
+static int CHECK_Sweeps(void)
+{
+  uint32_t fewest = CHECK_MAX_EVENTS;
+  int failed = 0;
+  uint32_t k;
+  uint32_t i;
+
+  CHECK_Init();
+  while (HalfCount < CHECK_SWEEP_HALVES + 20U)
+  {
+    CHECK_Half(CHECK_Sweep, Noise, 1U);
+  }
+  for (k = 0U; k < NumKnobs; k++)
+  {
+    const CHECK_EventsTypeDef *ev = &Events[k];
+    uint32_t up = ((k % 2U) == 0U);
+
+    for (i = 1U; i < ev->Count; i++)
+    {
+      failed |= up ? (ev->Value[i] <= ev->Value[i - 1U]) : (ev->Value[i] >= ev->Value[i - 1U]);
+    }
+    failed |= (ev->Value[0] != (up ? 0U : KNOB_FULL_SCALE));
+    failed |= (ev->Value[ev->Count - 1U] != (up ? KNOB_FULL_SCALE : 0U));
+    fewest = AUDIO_MIN(fewest, ev->Count);
+  }
+  printf("sweep: %u reports or more per knob over %u ms, %s\n", fewest, CHECK_SWEEP_HALVES,
+         failed ? "not monotonic or short of the ends" : "monotonic, end to end");
+  return failed;
+}
+
+static int CHECK_Full(void)
+{
+  int failed = 0;
+  uint32_t k;
+
+  CHECK_Init();
+  for (k = 0U; k < NumKnobs; k++)
+  {
+    Level[0][k] = 1000.0 + 200.0 * (double)k;
+  }
+  while (ASYNC_Push(&Queue, 0xFFFFU, 0) != 0U)
+  {
+  }
+  CHECK_Half(CHECK_Steady, 0.0, 0U);
+  failed |= (Surface.Overruns != NumKnobs);
+  while (ASYNC_Pop(&Queue, &(ASYNC_EventTypeDef){ 0 }) != 0U)
+  {
+  }
+  CHECK_Half(CHECK_Steady, 0.0, 1U);
+  for (k = 0U; k < NumKnobs; k++)
+  {
+    failed |= (Events[k].Count != 1U) || (Events[k].Value[0] != CHECK_Expected(Level[0][k]));
+  }
+  printf("full queue: %u overruns counted, every knob reported on the next half: %s\n",
+         Surface.Overruns, failed ? "no" : "yes");
+  return failed;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "k:n:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'k': NumKnobs = (uint32_t)atoi(optarg); break;
+      case 'n': Noise = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: knob_check [-k knobs] [-n noise codes]\n");
+        return 2;
+    }
+  }
+  if ((NumKnobs == 0U) || (NumKnobs > KNOB_MAX) || (Noise < 0.0))
+  {
+    fprintf(stderr, "knob_check: bad knob count or noise\n");
+    return 2;
+  }
+
+  srand(1U);
+  failed |= CHECK_Codes();
+  failed |= CHECK_Rest();
+  failed |= CHECK_Steps();
+  failed |= CHECK_Sweeps();
+  failed |= CHECK_Full();
+  return failed;
+}
@@ -0,0 +1,258 @@
+/**
+  ******************************************************************************
+  * @file    looper_check.c
+  * @brief   Host check of the audio_looper.c passes and undo.
+  *
+  *          Drives one looper in 16-bit storage with immediate actions and
+  *          reads loops back by playing them, input silent:
+  *            - undo after recording over a stopped take brings the take
+  *              back, length included;
+  *            - multiply with the base held by the undo pool: every cycle
+  *              is the base before the pass plus that cycle's input, up to
+  *              the second request, which closes the cycle on the base;
+  *            - multiply with a pool too small for the base: the first
+  *              cycle is the base, the later ones base plus their input;
+  *            - an overdub requested on another track while one multiplies
+  *              from the undo copies waits for the multiply to end, then
+  *              starts.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o looper_check looper_check.c \
+  *                ../Core/Src/audio_looper.c ../Core/Src/audio_adpcm.c
+  *
+  *          Usage:
+  *            looper_check [-l base frames] [-c cycles]
+  *
+  *          Defaults: a 1000-frame base (not a whole number of blocks),
+  *          3 cycles. The exit status is 1 at the first sample or state
+  *          that differs.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_looper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_MEMORY              (1024U * 1024U)
+#define CHECK_MAX_FRAMES          65536U
+
+/* Private variables ---------------------------------------------------------*/
+static LOOPER_HandleTypeDef Looper;
+static uint8_t Memory[CHECK_MEMORY];
+static float In[CHECK_MAX_FRAMES];
+static float Out[CHECK_MAX_FRAMES];
+static int16_t Take[CHECK_MAX_FRAMES];
+static int16_t Base[CHECK_MAX_FRAMES];
+static int16_t Loop[CHECK_MAX_FRAMES];
+
+/* Private functions ---------------------------------------------------------*/
+static void CHECK_Init(uint32_t Tracks, uint32_t UndoBlocks)
+{
+  LOOPER_ConfigTypeDef cfg;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.NumTracks    = (uint8_t)Tracks;
+  cfg.Format       = LOOPER_FORMAT_RAW16;
+  cfg.pInternal    = Memory;
+  cfg.InternalSize = CHECK_MEMORY;
+  cfg.UndoBlocks   = UndoBlocks;
+  if (LOOPER_Init(&Looper, &cfg) != AUDIO_OK)
+  {
+    fprintf(stderr, "looper_check: LOOPER_Init failed\n");
+    exit(2);
+  }
+  LOOPER_SetQuantum(&Looper, 0U);
+}
+
+/* Input sample that the looper stores as exactly Value */
+static float CHECK_Sample(int32_t Value)
+{
+  return ((float)Value + ((Value < 0) ? -0.5f : 0.5f)) / 32767.0f;
+}
+
+/* Runs Frames of input, Action requested on the first one */
+static void CHECK_Run(uint32_t Track, LOOPER_ActionTypeDef Action, const float *pIn, uint32_t Frames)
+{
+  static const float silence[CHECK_MAX_FRAMES];
+
+  if (Action != LOOPER_ACTION_NONE)
+  {
+    LOOPER_Request(&Looper, Track, Action);
+  }
+  LOOPER_Process(&Looper, (pIn != NULL) ? pIn : silence, Out, Frames);
+}
+
+/* Plays a track from its start and stores Frames of it */
+static void CHECK_Play(uint32_t Track, uint32_t Frames, int16_t *pLoop)
+{
+  uint32_t i;
+
+  CHECK_Run(Track, LOOPER_ACTION_PLAY, NULL, Frames);
+  for (i = 0U; i < Frames; i++)
+  {
+    pLoop[i] = (int16_t)(Out[i] * 32768.0f);
+  }
+}
+
+/* Records a loop of Length frames of a ramp, closes it and lets the loop point crossfade run */
+static void CHECK_Record(uint32_t Track, uint32_t Length, int32_t Step)
+{
+  uint32_t i;
+
+  for (i = 0U; i < Length; i++)
+  {
+    In[i] = CHECK_Sample((int32_t)((i * (uint32_t)Step) % 20000U) - 10000);
+  }
+  CHECK_Run(Track, LOOPER_ACTION_RECORD, In, Length);
+  CHECK_Run(Track, LOOPER_ACTION_RECORD, NULL, Length);
+}
+
+static int CHECK_Compare(const char *pWhat, const int16_t *pGot, const int16_t *pWant, uint32_t Frames)
+{
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    if (pGot[i] != pWant[i])
+    {
+      printf("%s: frame %u is %d, expected %d\n", pWhat, i, pGot[i], pWant[i]);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int CHECK_Undo(uint32_t Length)
+{
+  CHECK_Init(1U, LOOPER_MAX_UNDO_BLOCKS);
+  CHECK_Record(0U, Length, 7);
+  CHECK_Play(0U, Length, Take);
+  CHECK_Run(0U, LOOPER_ACTION_STOP, NULL, 1U);
+
+  CHECK_Record(0U, Length / 2U + 300U, 13);
+  CHECK_Run(0U, LOOPER_ACTION_STOP, NULL, 1U);
+  CHECK_Run(0U, LOOPER_ACTION_UNDO, NULL, 1U);
+  if ((Looper.Tracks[0].State != LOOPER_STATE_PLAYING) || (Looper.Tracks[0].Length != Length))
+  {
+    printf("undo of a re-record: state %u, length %u, expected %u, %u\n",
+           Looper.Tracks[0].State, Looper.Tracks[0].Length, LOOPER_STATE_PLAYING, Length);
+    return 1;
+  }
+  CHECK_Play(0U, Length, Loop);
+  return CHECK_Compare("undo of a re-record", Loop, Take, Length);
+}
+
+static int CHECK_Multiply(uint32_t Length, uint32_t Cycles, uint32_t UndoBlocks)
+{
+  const uint32_t total = Length * Cycles;
+  char what[64];
+  uint32_t i;
+
+  CHECK_Init(1U, UndoBlocks);
+  CHECK_Record(0U, Length, 7);
+  CHECK_Play(0U, Length, Base);
+
+  /* Request on the loop start, close during the last cycle */
+  for (i = 0U; i < total; i++)
+  {
+    In[i] = CHECK_Sample((int32_t)(i % 997U) * 11 - 5000);
+  }
+  CHECK_Run(0U, LOOPER_ACTION_MULTIPLY, In, total - Length / 2U);
+  CHECK_Run(0U, LOOPER_ACTION_MULTIPLY, In + total - Length / 2U, Length / 2U);
+  if ((Looper.Tracks[0].State != LOOPER_STATE_PLAYING) || (Looper.Tracks[0].Length != total))
+  {
+    printf("multiply: state %u, length %u, expected %u, %u\n", Looper.Tracks[0].State,
+           Looper.Tracks[0].Length, LOOPER_STATE_PLAYING, total);
+    return 1;
+  }
+
+  for (i = 0U; i < total; i++)
+  {
+    int32_t in = (int32_t)(In[i] * 32767.0f);
+    int32_t skip = ((Looper.Tracks[0].BaseSaved == 0U) && (i < Length)) ||
+                   (i >= total - Length / 2U);
+
+    Take[i] = (int16_t)AUDIO_CLAMP(Base[i % Length] + (skip ? 0 : in), -32768, 32767);
+  }
+  CHECK_Play(0U, total, Loop);
+  snprintf(what, sizeof(what), "multiply, %u-block pool", UndoBlocks);
+  return CHECK_Compare(what, Loop, Take, total);
+}
+
+static int CHECK_Wait(uint32_t Length)
+{
+  CHECK_Init(2U, LOOPER_MAX_UNDO_BLOCKS);
+  CHECK_Record(0U, Length, 7);
+  CHECK_Record(1U, Length, 5);
+  CHECK_Run(0U, LOOPER_ACTION_PLAY, NULL, 1U);
+  CHECK_Run(1U, LOOPER_ACTION_PLAY, NULL, 1U);
+
+  CHECK_Run(0U, LOOPER_ACTION_MULTIPLY, NULL, Length);
+  CHECK_Run(1U, LOOPER_ACTION_OVERDUB, NULL, Length / 2U);
+  if (Looper.Tracks[0].BaseSaved == 0U)
+  {
+    return 0;
+  }
+  if (Looper.Tracks[1].State != LOOPER_STATE_PLAYING)
+  {
+    printf("overdub during a multiply: started at once\n");
+    return 1;
+  }
+  CHECK_Run(0U, LOOPER_ACTION_MULTIPLY, NULL, Length * 2U);
+  if ((Looper.Tracks[0].State != LOOPER_STATE_PLAYING) ||
+      (Looper.Tracks[1].State != LOOPER_STATE_OVERDUB))
+  {
+    printf("overdub during a multiply: states %u, %u after it, expected %u, %u\n",
+           Looper.Tracks[0].State, Looper.Tracks[1].State, LOOPER_STATE_PLAYING,
+           LOOPER_STATE_OVERDUB);
+    return 1;
+  }
+  return 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  uint32_t length = 1000U;
+  uint32_t cycles = 3U;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:c:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'l': length = (uint32_t)atoi(optarg); break;
+      case 'c': cycles = (uint32_t)atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: looper_check [-l frames] [-c cycles]\n");
+        return 2;
+    }
+  }
+  if ((length < 2U * LOOPER_XFADE_FRAMES) || (cycles < 2U) || (length * cycles > CHECK_MAX_FRAMES))
+  {
+    fprintf(stderr, "looper_check: bad length or cycles\n");
+    return 2;
+  }
+
+  failed |= CHECK_Undo(length);
+  failed |= CHECK_Multiply(length, cycles, LOOPER_MAX_UNDO_BLOCKS);
+  failed |= CHECK_Multiply(length, cycles, 1U);
+  failed |= CHECK_Wait(length);
+  if (!failed)
+  {
+    printf("%u-frame base, %u cycles: undo, multiply and waiting passes exact\n", length, cycles);
+  }
+  return failed;
+}
@@ -0,0 +1,1002 @@
+/**
+  ******************************************************************************
+  * @file    render_host.c
+  * @brief   Offline render of a preset on a Linux host, faster than real time.
+  *
+  *          The firmware DSP modules have no HAL dependency, so they build
+  *          unchanged for the host; this file supplies what the board would:
+  *          the block loop, the input (a WAV) and the MIDI events the control
+  *          side would deliver. Several input files render in parallel, one
+  *          thread each, every thread with its own graph instance.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o render_host render_host.c \
+  *                ../Core/Src/audio_agc.c ../Core/Src/audio_vad.c \
+  *                ../Core/Src/audio_eq.c ../Core/Src/audio_biquad.c \
+  *                ../Core/Src/audio_voice.c -lm -lpthread
+  *
+  *          Usage:
+  *            render_host -p preset.txt [-m song.mid] [-j threads]
+  *                        (-o out.wav | -d outdir) [-r report.json] in.wav ...
+  *
+  *          Preset file, one node per line in processing order, '#' comments,
+  *          paths relative to the preset:
+  *            midi song.mid                 MIDI file driving the samplers
+  *            sampler piano.wav [root 60] [voices 8] [level 1] [decay 1]
+  *            eq rbj|matched                then up to 10 band lines:
+  *            band peaking|lowshelf|highshelf|lowpass|highpass|bandpass|notch
+  *                 <freq> <q> [gain dB]
+  *            agc [target -20] [min -10] [max 30]
+  *            gain <dB>
+  *
+  *          The render prints, and writes as JSON with -r, the real-time
+  *          factor and each node's CPU time, also as a share of the real-time
+  *          budget of the host (not of the STM32: use kernel_bench.py for
+  *          target cycles). The JSON "ns" figure is what golden_check.py
+  *          tracks between runs.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_agc.h"
+#include "audio_eq.h"
+#include "audio_voice.h"
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Private define ------------------------------------------------------------*/
+#define RENDER_MAX_NODES          16U
+#define RENDER_MAX_VOICES         32U
+#define RENDER_MAX_FILES          256U
+#define RENDER_PATH_LEN           512U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum
+{
+  NODE_SAMPLER = 0U,
+  NODE_EQ,
+  NODE_AGC,
+  NODE_GAIN
+} RENDER_KindTypeDef;
+
+/* Node configuration, shared read-only by all the render threads */
+typedef struct
+{
+  RENDER_KindTypeDef Kind;
+  char     Name[24];
+  EQ_DesignTypeDef Design;
+  uint32_t NumBands;
+  EQ_BandTypeDef Bands[EQ_MAX_BANDS];
+  AGC_ConfigTypeDef Agc;
+  float    Gain;
+  VOICE_SourceTypeDef Source;
+  int32_t  Root;
+  uint32_t Voices;
+  float    Level;
+  float    Decay;
+} RENDER_NodeTypeDef;
+
+typedef struct
+{
+  uint32_t Frame;
+  uint8_t  On;
+  uint8_t  Note;
+  uint8_t  Velocity;
+} RENDER_EventTypeDef;
+
+typedef struct
+{
+  RENDER_NodeTypeDef Nodes[RENDER_MAX_NODES];
+  uint32_t NumNodes;
+  RENDER_EventTypeDef *pEvents;
+  uint32_t NumEvents;
+} RENDER_PresetTypeDef;
+
+/* Per-thread node state */
+typedef struct
+{
+  EQ_HandleTypeDef  Eq[2];
+  AGC_HandleTypeDef Agc[2];
+  VOICE_HandleTypeDef *pVoices;
+  uint8_t  VoiceNote[RENDER_MAX_VOICES];
+  uint32_t NextVoice;
+  uint32_t NextEvent;
+} RENDER_StateTypeDef;
+
+typedef struct
+{
+  const char *pInput;
+  char     Output[RENDER_PATH_LEN];
+  uint32_t Frames;
+  uint64_t WallNs;
+  uint64_t NodeNs[RENDER_MAX_NODES];
+  int      Error;
+} RENDER_JobTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static RENDER_PresetTypeDef Preset;
+static RENDER_JobTypeDef Jobs[RENDER_MAX_FILES];
+static uint32_t NumJobs;
+static uint32_t NextJob;
+static pthread_mutex_t JobLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint64_t RENDER_Now(clockid_t Clock);
+static float   *RENDER_ReadWav(const char *pPath, uint32_t *pFrames, uint32_t *pChannels);
+static int      RENDER_WriteWav(const char *pPath, const float *pData, uint32_t Frames);
+static int      RENDER_ReadMidi(const char *pPath);
+static int      RENDER_ReadPreset(const char *pPath);
+static void     RENDER_Trigger(const RENDER_NodeTypeDef *pNode, RENDER_StateTypeDef *pState,
+                               const RENDER_EventTypeDef *pEvent);
+static void     RENDER_Node(const RENDER_NodeTypeDef *pNode, RENDER_StateTypeDef *pState,
+                            float *pLeft, float *pRight, uint32_t Frame);
+static int      RENDER_File(RENDER_JobTypeDef *pJob);
+static void    *RENDER_Worker(void *pArg);
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  static const struct option options[] =
+  {
+    { "preset", required_argument, NULL, 'p' }, { "midi", required_argument, NULL, 'm' },
+    { "jobs", required_argument, NULL, 'j' },   { "output", required_argument, NULL, 'o' },
+    { "dir", required_argument, NULL, 'd' },    { "report", required_argument, NULL, 'r' },
+    { NULL, 0, NULL, 0 }
+  };
+  const char *preset = NULL;
+  const char *midi = NULL;
+  const char *output = NULL;
+  const char *dir = NULL;
+  const char *report = NULL;
+  uint32_t threads = 1U;
+  pthread_t tid[64];
+  double audioSec = 0.0;
+  double wallSec;
+  uint64_t start;
+  uint64_t nodeNs[RENDER_MAX_NODES] = { 0 };
+  uint64_t totalNs = 0U;
+  uint32_t failed = 0U;
+  FILE *f = NULL;
+  uint32_t i;
+  uint32_t n;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "p:m:j:o:d:r:", options, NULL)) != -1)
+  {
+    switch (opt)
+    {
+      case 'p': preset = optarg; break;
+      case 'm': midi = optarg; break;
+      case 'j': threads = (uint32_t)AUDIO_CLAMP(atoi(optarg), 1, 64); break;
+      case 'o': output = optarg; break;
+      case 'd': dir = optarg; break;
+      case 'r': report = optarg; break;
+      default: return 2;
+    }
+  }
+  NumJobs = (uint32_t)(argc - optind);
+  if ((preset == NULL) || (NumJobs == 0U) || (NumJobs > RENDER_MAX_FILES)
+      || ((output == NULL) == (dir == NULL)) || ((output != NULL) && (NumJobs != 1U)))
+  {
+    fprintf(stderr, "usage: render_host -p preset [-m midi] [-j threads] (-o out.wav | -d dir) "
+                    "[-r report.json] in.wav ...\n");
+    return 2;
+  }
+  if ((RENDER_ReadPreset(preset) != 0) || ((midi != NULL) && (RENDER_ReadMidi(midi) != 0)))
+  {
+    return 1;
+  }
+
+  for (i = 0U; i < NumJobs; i++)
+  {
+    const char *in = argv[optind + (int)i];
+    const char *base = strrchr(in, '/');
+
+    Jobs[i].pInput = in;
+    if (output != NULL)
+    {
+      snprintf(Jobs[i].Output, RENDER_PATH_LEN, "%s", output);
+    }
+    else
+    {
+      snprintf(Jobs[i].Output, RENDER_PATH_LEN, "%s/%s", dir, (base != NULL) ? base + 1 : in);
+    }
+  }
+
+  start = RENDER_Now(CLOCK_MONOTONIC);
+  threads = AUDIO_MIN(threads, NumJobs);
+  for (i = 0U; i < threads; i++)
+  {
+    pthread_create(&tid[i], NULL, RENDER_Worker, NULL);
+  }
+  for (i = 0U; i < threads; i++)
+  {
+    pthread_join(tid[i], NULL);
+  }
+  wallSec = (double)(RENDER_Now(CLOCK_MONOTONIC) - start) * 1e-9;
+
+  for (i = 0U; i < NumJobs; i++)
+  {
+    RENDER_JobTypeDef *job = &Jobs[i];
+    double sec = (double)job->Frames / (double)AUDIO_SAMPLE_RATE;
+
+    if (job->Error != 0)
+    {
+      failed++;
+      continue;
+    }
+    audioSec += sec;
+    printf("%s: %.2f s of audio, %.1fx real time\n", job->Output, sec,
+           sec / ((double)job->WallNs * 1e-9 + 1e-12));
+    for (n = 0U; n < Preset.NumNodes; n++)
+    {
+      nodeNs[n] += job->NodeNs[n];
+      totalNs += job->NodeNs[n];
+    }
+  }
+
+  printf("%-12s %12s %10s\n", "node", "cpu ms", "% budget");
+  for (n = 0U; n < Preset.NumNodes; n++)
+  {
+    printf("%-12s %12.3f %10.3f\n", Preset.Nodes[n].Name, (double)nodeNs[n] * 1e-6,
+           100.0 * (double)nodeNs[n] * 1e-9 / (audioSec + 1e-12));
+  }
+  printf("%u files, %.2f s of audio in %.3f s: %.1fx real time on %u threads\n",
+         NumJobs - failed, audioSec, wallSec, audioSec / (wallSec + 1e-12), threads);
+
+  if (report != NULL)
+  {
+    f = fopen(report, "w");
+  }
+  if (f != NULL)
+  {
+    fprintf(f, "{\"ns\": %llu, \"audio_seconds\": %.6f, \"wall_seconds\": %.6f, "
+               "\"realtime_factor\": %.3f, \"nodes\": [",
+            (unsigned long long)totalNs, audioSec, wallSec, audioSec / (wallSec + 1e-12));
+    for (n = 0U; n < Preset.NumNodes; n++)
+    {
+      fprintf(f, "%s{\"name\": \"%s\", \"ns\": %llu, \"budget_percent\": %.4f}", (n != 0U) ? ", " : "",
+              Preset.Nodes[n].Name, (unsigned long long)nodeNs[n],
+              100.0 * (double)nodeNs[n] * 1e-9 / (audioSec + 1e-12));
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+  }
+  return (failed != 0U) ? 1 : 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Reads a clock in nanoseconds.
+  * @param  Clock CLOCK_MONOTONIC for wall time, CLOCK_THREAD_CPUTIME_ID for cost
+  * @retval Nanoseconds
+  */
+static uint64_t RENDER_Now(clockid_t Clock)
+{
+  struct timespec ts;
+
+  clock_gettime(Clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * @brief  Reads a 16-bit PCM or 32-bit float WAV.
+  * @param  pPath file name
+  * @param  pFrames set to the number of frames
+  * @param  pChannels set to the number of interleaved channels
+  * @retval Samples as floats (malloc'ed), NULL on error
+  */
+static float *RENDER_ReadWav(const char *pPath, uint32_t *pFrames, uint32_t *pChannels)
+{
+  FILE *f = fopen(pPath, "rb");
+  uint8_t hdr[12];
+  uint16_t format = 0U;
+  uint16_t bits = 0U;
+  uint32_t rate = 0U;
+  float *out = NULL;
+
+  *pChannels = 0U;
+  if ((f == NULL) || (fread(hdr, 1, 12, f) != 12U) || (memcmp(hdr, "RIFF", 4) != 0)
+      || (memcmp(&hdr[8], "WAVE", 4) != 0))
+  {
+    fprintf(stderr, "%s: not a WAV file\n", pPath);
+    if (f != NULL)
+    {
+      fclose(f);
+    }
+    return NULL;
+  }
+
+  while (fread(hdr, 1, 8, f) == 8U)
+  {
+    uint32_t size = (uint32_t)hdr[4] | ((uint32_t)hdr[5] << 8) | ((uint32_t)hdr[6] << 16)
+                    | ((uint32_t)hdr[7] << 24);
+
+    if (memcmp(hdr, "fmt ", 4) == 0)
+    {
+      uint8_t fmt[40] = { 0 };
+
+      if (fread(fmt, 1, AUDIO_MIN(size, sizeof(fmt)), f) != AUDIO_MIN(size, sizeof(fmt)))
+      {
+        break;
+      }
+      fseek(f, (long)(size - AUDIO_MIN(size, sizeof(fmt)) + (size & 1U)), SEEK_CUR);
+      format = (uint16_t)(fmt[0] | (fmt[1] << 8));
+      *pChannels = (uint32_t)(fmt[2] | (fmt[3] << 8));
+      rate = (uint32_t)fmt[4] | ((uint32_t)fmt[5] << 8) | ((uint32_t)fmt[6] << 16);
+      bits = (uint16_t)(fmt[14] | (fmt[15] << 8));
+      if ((format == 0xFFFEU) && (size >= 26U))
+      {
+        format = (uint16_t)(fmt[24] | (fmt[25] << 8));
+      }
+    }
+    else if ((memcmp(hdr, "data", 4) == 0) && (*pChannels != 0U))
+    {
+      uint32_t bytes = bits / 8U;
+      uint32_t count;
+      uint8_t *raw;
+      uint32_t i;
+
+      if ((rate != AUDIO_SAMPLE_RATE) || !(((format == 1U) && (bits == 16U)) || ((format == 3U) && (bits == 32U))))
+      {
+        fprintf(stderr, "%s: needs %u Hz, 16-bit PCM or 32-bit float\n", pPath, AUDIO_SAMPLE_RATE);
+        break;
+      }
+      count = size / bytes;
+      raw = malloc(size);
+      out = malloc(((size_t)count + 1U) * sizeof(float));
+      if ((raw == NULL) || (out == NULL) || (fread(raw, 1, size, f) != size))
+      {
+        free(out);
+        out = NULL;
+        free(raw);
+        break;
+      }
+      for (i = 0U; i < count; i++)
+      {
+        if (format == 3U)
+        {
+          memcpy(&out[i], &raw[i * 4U], sizeof(float));
+        }
+        else
+        {
+          out[i] = (float)(int16_t)(raw[i * 2U] | (raw[i * 2U + 1U] << 8)) * (1.0f / 32768.0f);
+        }
+      }
+      free(raw);
+      *pFrames = count / *pChannels;
+      break;
+    }
+    else
+    {
+      fseek(f, (long)(size + (size & 1U)), SEEK_CUR);
+    }
+  }
+  fclose(f);
+  if (out == NULL)
+  {
+    fprintf(stderr, "%s: no usable audio\n", pPath);
+  }
+  return out;
+}
+
+/**
+  * @brief  Writes a stereo 32-bit float WAV.
+  * @param  pPath file name
+  * @param  pData interleaved stereo samples
+  * @param  Frames number of frames
+  * @retval 0, or -1 on error
+  */
+static int RENDER_WriteWav(const char *pPath, const float *pData, uint32_t Frames)
+{
+  uint32_t bytes = Frames * 2U * (uint32_t)sizeof(float);
+  uint32_t hdr[11] =
+  {
+    0x46464952U, 36U + bytes, 0x45564157U, 0x20746D66U, 16U,
+    0x00020003U, AUDIO_SAMPLE_RATE, AUDIO_SAMPLE_RATE * 8U, 0x00200008U,
+    0x61746164U, bytes
+  };
+  FILE *f = fopen(pPath, "wb");
+  int ok;
+
+  if (f == NULL)
+  {
+    fprintf(stderr, "%s: cannot write\n", pPath);
+    return -1;
+  }
+  ok = (fwrite(hdr, sizeof(hdr), 1, f) == 1U) && (fwrite(pData, 1, bytes, f) == bytes);
+  return ((fclose(f) == 0) && ok) ? 0 : -1;
+}
+
+/**
+  * @brief  Reads the variable-length quantity of a MIDI file.
+  * @param  pp read position, advanced
+  * @param  pEnd end of the track
+  * @retval Value
+  */
+static uint32_t RENDER_Vlq(const uint8_t **pp, const uint8_t *pEnd)
+{
+  uint32_t v = 0U;
+
+  while (*pp < pEnd)
+  {
+    uint8_t b = *(*pp)++;
+
+    v = (v << 7) | (b & 0x7FU);
+    if ((b & 0x80U) == 0U)
+    {
+      break;
+    }
+  }
+  return v;
+}
+
+static int RENDER_CompareEvents(const void *a, const void *b)
+{
+  const RENDER_EventTypeDef *x = a;
+  const RENDER_EventTypeDef *y = b;
+
+  /* Frame, then note-offs first so a repeated note retriggers */
+  if (x->Frame != y->Frame)
+  {
+    return (x->Frame < y->Frame) ? -1 : 1;
+  }
+  return (int)x->On - (int)y->On;
+}
+
+/**
+  * @brief  Reads the notes of a standard MIDI file (format 0 or 1) as frames.
+  * @note   All tracks and channels are merged; tempo changes are honoured
+  *         wherever they appear.
+  * @param  pPath file name
+  * @retval 0, or -1 on error
+  */
+static int RENDER_ReadMidi(const char *pPath)
+{
+  typedef struct { uint32_t Tick; uint32_t Tempo; } TempoTypeDef;
+  TempoTypeDef tempo[256];
+  uint32_t numTempo = 1U;
+  uint8_t *data;
+  const uint8_t *p;
+  const uint8_t *end;
+  uint32_t division;
+  uint32_t pass;
+  long size;
+  FILE *f = fopen(pPath, "rb");
+
+  if ((f == NULL) || (fseek(f, 0, SEEK_END) != 0) || ((size = ftell(f)) < 14))
+  {
+    fprintf(stderr, "%s: cannot read\n", pPath);
+    if (f != NULL)
+    {
+      fclose(f);
+    }
+    return -1;
+  }
+  data = malloc((size_t)size);
+  rewind(f);
+  if ((data == NULL) || (fread(data, 1, (size_t)size, f) != (size_t)size) || (memcmp(data, "MThd", 4) != 0)
+      || ((data[12] & 0x80U) != 0U))
+  {
+    fprintf(stderr, "%s: not a MIDI file with a tick division\n", pPath);
+    fclose(f);
+    free(data);
+    return -1;
+  }
+  fclose(f);
+  division = ((uint32_t)data[12] << 8) | data[13];
+  tempo[0].Tick = 0U;
+  tempo[0].Tempo = 500000U;
+
+  /* Pass 0 collects the tempo map, pass 1 the notes */
+  for (pass = 0U; pass < 2U; pass++)
+  {
+    p = data + 8 + (((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) | ((uint32_t)data[6] << 8) | data[7]);
+    end = data + size;
+    while (p + 8 <= end)
+    {
+      uint32_t len = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | p[7];
+      const uint8_t *t = p + 8;
+      const uint8_t *tEnd = (p + 8 + len <= end) ? p + 8 + len : end;
+      uint32_t tick = 0U;
+      uint8_t status = 0U;
+
+      if (memcmp(p, "MTrk", 4) != 0)
+      {
+        p = tEnd;
+        continue;
+      }
+      while (t < tEnd)
+      {
+        uint8_t type;
+
+        tick += RENDER_Vlq(&t, tEnd);
+        if ((t < tEnd) && ((*t & 0x80U) != 0U))
+        {
+          status = *t++;
+        }
+        type = status & 0xF0U;
+        if (status == 0xFFU)
+        {
+          uint8_t meta = (t < tEnd) ? *t++ : 0U;
+          uint32_t mlen = RENDER_Vlq(&t, tEnd);
+
+          if ((pass == 0U) && (meta == 0x51U) && (mlen == 3U) && (numTempo < 256U))
+          {
+            tempo[numTempo].Tick = tick;
+            tempo[numTempo].Tempo = ((uint32_t)t[0] << 16) | ((uint32_t)t[1] << 8) | t[2];
+            numTempo++;
+          }
+          t += mlen;
+          status = 0U;
+        }
+        else if ((status == 0xF0U) || (status == 0xF7U))
+        {
+          t += RENDER_Vlq(&t, tEnd);
+          status = 0U;
+        }
+        else if ((type == 0x80U) || (type == 0x90U))
+        {
+          if ((pass == 1U) && (t + 1 < tEnd))
+          {
+            RENDER_EventTypeDef *e;
+            double sec = 0.0;
+            uint32_t k;
+
+            Preset.pEvents = realloc(Preset.pEvents, (Preset.NumEvents + 1U) * sizeof(*e));
+            e = &Preset.pEvents[Preset.NumEvents++];
+            for (k = 0U; k < numTempo; k++)
+            {
+              uint32_t from = tempo[k].Tick;
+              uint32_t to = ((k + 1U < numTempo) && (tempo[k + 1U].Tick < tick)) ? tempo[k + 1U].Tick : tick;
+
+              if (from >= tick)
+              {
+                break;
+              }
+              sec += (double)(to - from) * (double)tempo[k].Tempo * 1e-6 / (double)division;
+            }
+            e->Frame = (uint32_t)(sec * (double)AUDIO_SAMPLE_RATE + 0.5);
+            e->Note = t[0] & 0x7FU;
+            e->Velocity = t[1] & 0x7FU;
+            e->On = (uint8_t)((type == 0x90U) && (e->Velocity != 0U));
+          }
+          t += 2;
+        }
+        else
+        {
+          t += ((type == 0xC0U) || (type == 0xD0U)) ? 1 : 2;
+        }
+      }
+      p = tEnd;
+    }
+    if (pass == 0U)
+    {
+      /* Stable order of the tempo map by tick */
+      uint32_t a;
+      uint32_t b;
+
+      for (a = 1U; a < numTempo; a++)
+      {
+        for (b = a; (b > 1U) && (tempo[b - 1U].Tick > tempo[b].Tick); b--)
+        {
+          TempoTypeDef swap = tempo[b];
+
+          tempo[b] = tempo[b - 1U];
+          tempo[b - 1U] = swap;
+        }
+      }
+    }
+  }
+  free(data);
+  qsort(Preset.pEvents, Preset.NumEvents, sizeof(RENDER_EventTypeDef), RENDER_CompareEvents);
+  return 0;
+}
+
+/**
+  * @brief  Reads a preset file.
+  * @param  pPath file name
+  * @retval 0, or -1 on error
+  */
+static int RENDER_ReadPreset(const char *pPath)
+{
+  static const char * const types[] =
+  {
+    "peaking", "lowshelf", "highshelf", "lowpass", "highpass", "bandpass", "notch"
+  };
+  char dir[RENDER_PATH_LEN];
+  char line[RENDER_PATH_LEN];
+  char path[2U * RENDER_PATH_LEN];
+  const char *slash = strrchr(pPath, '/');
+  RENDER_NodeTypeDef *eq = NULL;
+  uint32_t lineNo = 0U;
+  int ok;
+  FILE *f = fopen(pPath, "r");
+
+  if (f == NULL)
+  {
+    fprintf(stderr, "%s: cannot read\n", pPath);
+    return -1;
+  }
+  snprintf(dir, sizeof(dir), "%.*s", (slash != NULL) ? (int)(slash - pPath) : 1, (slash != NULL) ? pPath : ".");
+
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    char *word[16];
+    uint32_t words = 0U;
+    char *tok = strtok(line, " \t\r\n");
+    RENDER_NodeTypeDef *node;
+    uint32_t k;
+
+    lineNo++;
+    while ((tok != NULL) && (tok[0] != '#') && (words < 16U))
+    {
+      word[words++] = tok;
+      tok = strtok(NULL, " \t\r\n");
+    }
+    if (words == 0U)
+    {
+      continue;
+    }
+
+    if ((strcmp(word[0], "midi") == 0) && (words == 2U))
+    {
+      snprintf(path, sizeof(path), "%s/%s", dir, word[1]);
+      if (RENDER_ReadMidi(path) != 0)
+      {
+        break;
+      }
+      continue;
+    }
+    if ((strcmp(word[0], "band") == 0) && (eq != NULL) && (words >= 4U) && (eq->NumBands < EQ_MAX_BANDS))
+    {
+      EQ_BandTypeDef *band = &eq->Bands[eq->NumBands];
+
+      for (k = 0U; (k < 7U) && (strcmp(word[1], types[k]) != 0); k++)
+      {
+      }
+      if (k == 7U)
+      {
+        fprintf(stderr, "%s:%u: unknown band type %s\n", pPath, lineNo, word[1]);
+        break;
+      }
+      band->Type   = (EQ_TypeDef)k;
+      band->Freq   = strtof(word[2], NULL);
+      band->Q      = strtof(word[3], NULL);
+      band->GainDb = (words > 4U) ? strtof(word[4], NULL) : 0.0f;
+      eq->NumBands++;
+      continue;
+    }
+    if (Preset.NumNodes == RENDER_MAX_NODES)
+    {
+      fprintf(stderr, "%s:%u: too many nodes\n", pPath, lineNo);
+      break;
+    }
+
+    node = &Preset.Nodes[Preset.NumNodes];
+    memset(node, 0, sizeof(*node));
+    snprintf(node->Name, sizeof(node->Name), "%u.%s", Preset.NumNodes, word[0]);
+    if ((strcmp(word[0], "eq") == 0) && (words == 2U))
+    {
+      node->Kind = NODE_EQ;
+      node->Design = (strcmp(word[1], "matched") == 0) ? EQ_DESIGN_MATCHED : EQ_DESIGN_RBJ;
+      eq = node;
+    }
+    else if (strcmp(word[0], "agc") == 0)
+    {
+      node->Kind = NODE_AGC;
+      node->Agc.TargetDb     = -20.0f;
+      node->Agc.MinGainDb    = -10.0f;
+      node->Agc.MaxGainDb    = 30.0f;
+      node->Agc.AttackMs     = 50.0f;
+      node->Agc.DecayMs      = 500.0f;
+      node->Agc.SlewDbPerSec = 20.0f;
+      node->Agc.NoiseGuardDb = -50.0f;
+      node->Agc.PeakDb       = -1.0f;
+      for (k = 1U; k + 1U < words; k += 2U)
+      {
+        float v = strtof(word[k + 1U], NULL);
+
+        if (strcmp(word[k], "target") == 0)   { node->Agc.TargetDb = v; }
+        else if (strcmp(word[k], "min") == 0) { node->Agc.MinGainDb = v; }
+        else if (strcmp(word[k], "max") == 0) { node->Agc.MaxGainDb = v; }
+      }
+    }
+    else if ((strcmp(word[0], "gain") == 0) && (words == 2U))
+    {
+      node->Kind = NODE_GAIN;
+      node->Gain = powf(10.0f, strtof(word[1], NULL) / 20.0f);
+    }
+    else if ((strcmp(word[0], "sampler") == 0) && (words >= 2U))
+    {
+      uint32_t frames = 0U;
+      uint32_t channels = 0U;
+      float *pcm;
+      int16_t *data;
+      uint32_t i;
+
+      node->Kind   = NODE_SAMPLER;
+      node->Root   = 60;
+      node->Voices = 8U;
+      node->Level  = 1.0f;
+      node->Decay  = 1.0f;
+      for (k = 2U; k + 1U < words; k += 2U)
+      {
+        if (strcmp(word[k], "root") == 0)        { node->Root = atoi(word[k + 1U]); }
+        else if (strcmp(word[k], "voices") == 0) { node->Voices = (uint32_t)AUDIO_CLAMP(atoi(word[k + 1U]), 1, (int)RENDER_MAX_VOICES); }
+        else if (strcmp(word[k], "level") == 0)  { node->Level = strtof(word[k + 1U], NULL); }
+        else if (strcmp(word[k], "decay") == 0)  { node->Decay = strtof(word[k + 1U], NULL); }
+      }
+      snprintf(path, sizeof(path), "%s/%s", dir, word[1]);
+      pcm = RENDER_ReadWav(path, &frames, &channels);
+      data = (pcm != NULL) ? malloc(frames * sizeof(int16_t)) : NULL;
+      if (data == NULL)
+      {
+        free(pcm);
+        break;
+      }
+      /* Voices play mono 16-bit, as from flash on the board */
+      for (i = 0U; i < frames; i++)
+      {
+        data[i] = (int16_t)lrintf(AUDIO_CLAMP(pcm[i * channels] * 32767.0f, -32768.0f, 32767.0f));
+      }
+      free(pcm);
+      node->Source.Data   = data;
+      node->Source.Length = frames;
+    }
+    else
+    {
+      fprintf(stderr, "%s:%u: cannot parse '%s'\n", pPath, lineNo, word[0]);
+      break;
+    }
+    Preset.NumNodes++;
+  }
+
+  ok = feof(f);
+  fclose(f);
+  return (ok != 0) ? 0 : -1;
+}
+
+/**
+  * @brief  Starts or stops the sampler voice of a MIDI note.
+  * @param  pNode sampler configuration
+  * @param  pState sampler state
+  * @param  pEvent note event
+  * @retval None
+  */
+static void RENDER_Trigger(const RENDER_NodeTypeDef *pNode, RENDER_StateTypeDef *pState,
+                           const RENDER_EventTypeDef *pEvent)
+{
+  uint32_t v;
+
+  if (pEvent->On == 0U)
+  {
+    for (v = 0U; v < pNode->Voices; v++)
+    {
+      if ((pState->VoiceNote[v] == pEvent->Note + 1U) && (pNode->Decay >= 1.0f))
+      {
+        /* One-shot samples with a decay ring out; plain ones stop */
+        VOICE_Stop(&pState->pVoices[v]);
+        pState->VoiceNote[v] = 0U;
+      }
+    }
+  }
+  else
+  {
+    VOICE_ParamsTypeDef params;
+
+    v = pState->NextVoice;
+    pState->NextVoice = (v + 1U) % pNode->Voices;
+    params.Level = pNode->Level * (float)pEvent->Velocity / 127.0f;
+    params.Pan   = 0.0f;
+    params.Rate  = powf(2.0f, (float)((int32_t)pEvent->Note - pNode->Root) / 12.0f);
+    params.Decay = pNode->Decay;
+    params.Start = 0U;
+    VOICE_Trigger(&pState->pVoices[v], &pNode->Source, &params);
+    pState->VoiceNote[v] = pEvent->Note + 1U;
+  }
+}
+
+/**
+  * @brief  Runs one node on one block, in place.
+  * @param  pNode node configuration
+  * @param  pState node state
+  * @param  pLeft left block
+  * @param  pRight right block
+  * @param  Frame position of the block in the file
+  * @retval None
+  */
+static void RENDER_Node(const RENDER_NodeTypeDef *pNode, RENDER_StateTypeDef *pState,
+                        float *pLeft, float *pRight, uint32_t Frame)
+{
+  uint32_t i;
+
+  switch (pNode->Kind)
+  {
+    case NODE_SAMPLER:
+    {
+      uint32_t done = 0U;
+
+      while (done < AUDIO_BLOCK_SIZE)
+      {
+        uint32_t upto = AUDIO_BLOCK_SIZE;
+        uint32_t v;
+
+        /* Split the block at the next note so triggers are sample accurate */
+        while ((pState->NextEvent < Preset.NumEvents) && (Preset.pEvents[pState->NextEvent].Frame <= Frame + done))
+        {
+          RENDER_Trigger(pNode, pState, &Preset.pEvents[pState->NextEvent]);
+          pState->NextEvent++;
+        }
+        if ((pState->NextEvent < Preset.NumEvents) && (Preset.pEvents[pState->NextEvent].Frame < Frame + AUDIO_BLOCK_SIZE))
+        {
+          upto = Preset.pEvents[pState->NextEvent].Frame - Frame;
+        }
+        for (v = 0U; v < pNode->Voices; v++)
+        {
+          VOICE_Render(&pState->pVoices[v], &pLeft[done], &pRight[done], upto - done);
+        }
+        done = upto;
+      }
+      break;
+    }
+
+    case NODE_EQ:
+      EQ_Process(&pState->Eq[0], pLeft, pLeft, AUDIO_BLOCK_SIZE);
+      EQ_Process(&pState->Eq[1], pRight, pRight, AUDIO_BLOCK_SIZE);
+      break;
+
+    case NODE_AGC:
+      AGC_Process(&pState->Agc[0], pLeft, pLeft, AUDIO_BLOCK_SIZE);
+      AGC_Process(&pState->Agc[1], pRight, pRight, AUDIO_BLOCK_SIZE);
+      AGC_Service(&pState->Agc[0]);
+      AGC_Service(&pState->Agc[1]);
+      break;
+
+    default:
+      for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+      {
+        pLeft[i]  *= pNode->Gain;
+        pRight[i] *= pNode->Gain;
+      }
+      break;
+  }
+}
+
+/**
+  * @brief  Renders one input file through a fresh graph instance.
+  * @param  pJob file to render
+  * @retval 0, or -1 on error
+  */
+static int RENDER_File(RENDER_JobTypeDef *pJob)
+{
+  RENDER_StateTypeDef *state = calloc(RENDER_MAX_NODES, sizeof(RENDER_StateTypeDef));
+  uint32_t channels = 0U;
+  float *in = RENDER_ReadWav(pJob->pInput, &pJob->Frames, &channels);
+  float *out = (in != NULL) ? malloc((size_t)pJob->Frames * 2U * sizeof(float)) : NULL;
+  float left[AUDIO_BLOCK_SIZE];
+  float right[AUDIO_BLOCK_SIZE];
+  uint64_t start;
+  uint32_t frame;
+  uint32_t n;
+  uint32_t i;
+  int status = -1;
+
+  if ((state == NULL) || (out == NULL))
+  {
+    goto done;
+  }
+  for (n = 0U; n < Preset.NumNodes; n++)
+  {
+    const RENDER_NodeTypeDef *node = &Preset.Nodes[n];
+
+    if (node->Kind == NODE_EQ)
+    {
+      for (i = 0U; i < 2U; i++)
+      {
+        uint32_t b;
+
+        (void)EQ_Init(&state[n].Eq[i], node->Design, node->NumBands);
+        for (b = 0U; b < node->NumBands; b++)
+        {
+          (void)EQ_SetBand(&state[n].Eq[i], b, &node->Bands[b]);
+        }
+      }
+    }
+    else if (node->Kind == NODE_AGC)
+    {
+      (void)AGC_Init(&state[n].Agc[0], &node->Agc);
+      (void)AGC_Init(&state[n].Agc[1], &node->Agc);
+    }
+    else if (node->Kind == NODE_SAMPLER)
+    {
+      state[n].pVoices = calloc(node->Voices, sizeof(VOICE_HandleTypeDef));
+      if (state[n].pVoices == NULL)
+      {
+        goto done;
+      }
+      for (i = 0U; i < node->Voices; i++)
+      {
+        VOICE_Init(&state[n].pVoices[i]);
+      }
+    }
+  }
+
+  start = RENDER_Now(CLOCK_MONOTONIC);
+  for (frame = 0U; frame < pJob->Frames; frame += AUDIO_BLOCK_SIZE)
+  {
+    uint32_t count = AUDIO_MIN(AUDIO_BLOCK_SIZE, pJob->Frames - frame);
+
+    /* The last block is padded: the modules always see full blocks */
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      const float *s = &in[(size_t)(frame + AUDIO_MIN(i, count - 1U)) * channels];
+
+      left[i]  = (i < count) ? s[0] : 0.0f;
+      right[i] = (i < count) ? s[(channels > 1U) ? 1U : 0U] : 0.0f;
+    }
+    for (n = 0U; n < Preset.NumNodes; n++)
+    {
+      uint64_t t0 = RENDER_Now(CLOCK_THREAD_CPUTIME_ID);
+
+      RENDER_Node(&Preset.Nodes[n], &state[n], left, right, frame);
+      pJob->NodeNs[n] += RENDER_Now(CLOCK_THREAD_CPUTIME_ID) - t0;
+    }
+    for (i = 0U; i < count; i++)
+    {
+      out[(size_t)(frame + i) * 2U]      = left[i];
+      out[(size_t)(frame + i) * 2U + 1U] = right[i];
+    }
+  }
+  pJob->WallNs = RENDER_Now(CLOCK_MONOTONIC) - start;
+  status = RENDER_WriteWav(pJob->Output, out, pJob->Frames);
+
+done:
+  if (state != NULL)
+  {
+    for (n = 0U; n < RENDER_MAX_NODES; n++)
+    {
+      free(state[n].pVoices);
+    }
+  }
+  free(state);
+  free(out);
+  free(in);
+  return status;
+}
+
+/**
+  * @brief  Render thread: takes files until none is left.
+  * @param  pArg unused
+  * @retval NULL
+  */
+static void *RENDER_Worker(void *pArg)
+{
+  (void)pArg;
+  for (;;)
+  {
+    uint32_t job;
+
+    pthread_mutex_lock(&JobLock);
+    job = NextJob++;
+    pthread_mutex_unlock(&JobLock);
+    if (job >= NumJobs)
+    {
+      break;
+    }
+    Jobs[job].Error = RENDER_File(&Jobs[job]);
+  }
+  return NULL;
+}
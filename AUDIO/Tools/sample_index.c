@@ -0,0 +1,193 @@
+/**
+  ******************************************************************************
+  * @file    sample_index.c
+  * @brief   Host build of the SD sample library index from a card image.
+  *
+  *          Runs audio_library.c unchanged over a raw image of the card (dd
+  *          of the whole device, or of the FAT partition alone), so the
+  *          index written here is the one the firmware builds on first
+  *          mount. The image is loaded back and every entry is checked: it
+  *          must be found by Id, and its first sector must map through the
+  *          runs to the RIFF header of the file. With -c, a saved index is
+  *          checked against the card instead, as the firmware does on mount.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o sample_index sample_index.c \
+  *                ../Core/Src/audio_library.c
+  *
+  *          Usage:
+  *            sample_index [-o index.bin] [-c index.bin] [-l] [-n path] card.img
+  *
+  *          -o writes the index, to be copied to the card next to the
+  *          samples; -c tells whether a saved index still describes the
+  *          card; -l lists the entries; -n prints the Id a preset uses for
+  *          a sample file without a numeric prefix. The exit status is 1 if
+  *          files were skipped or dropped as duplicates, or the index given
+  *          with -c is stale, 2 on errors.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_library.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define INDEX_MAX_BYTES           (16U * 1024U * 1024U)
+
+/* Private variables ---------------------------------------------------------*/
+static LIBRARY_BuilderTypeDef Builder;
+static uint32_t Reads;
+
+/* Private functions ---------------------------------------------------------*/
+static AUDIO_StatusTypeDef INDEX_Read(void *Context, uint32_t Lba, uint8_t *pDst)
+{
+  int fd = *(int *)Context;
+
+  Reads++;
+  return (pread(fd, pDst, LIBRARY_SECTOR_SIZE, (off_t)Lba * LIBRARY_SECTOR_SIZE) == LIBRARY_SECTOR_SIZE)
+         ? AUDIO_OK : AUDIO_ERROR;
+}
+
+static const char *INDEX_FormatName(uint32_t Format)
+{
+  switch (Format)
+  {
+    case LIBRARY_FORMAT_PCM16:   return "pcm16";
+    case LIBRARY_FORMAT_PCM24:   return "pcm24";
+    case LIBRARY_FORMAT_FLOAT32: return "float";
+    default:                     return "?";
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char *outPath = NULL;
+  const char *checkPath = NULL;
+  int list = 0;
+  LIBRARY_HandleTypeDef lib;
+  uint32_t *image;
+  uint32_t size;
+  uint32_t fragmented = 0U;
+  uint32_t bad = 0U;
+  uint32_t i;
+  int fd;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "o:c:ln:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'o': outPath = optarg; break;
+      case 'c': checkPath = optarg; break;
+      case 'l': list = 1; break;
+      case 'n': printf("%s: %u\n", optarg, LIBRARY_HashName(optarg)); return 0;
+      default: return 2;
+    }
+  }
+  if (optind != (argc - 1))
+  {
+    fprintf(stderr, "usage: sample_index [-o index.bin] [-c index.bin] [-l] [-n path] card.img\n");
+    return 2;
+  }
+  fd = open(argv[optind], O_RDONLY);
+  image = malloc(INDEX_MAX_BYTES);
+  if ((fd < 0) || (image == NULL))
+  {
+    fprintf(stderr, "%s: cannot open\n", argv[optind]);
+    return 2;
+  }
+
+  Builder.Read = INDEX_Read;
+  Builder.Context = &fd;
+  if (checkPath != NULL)
+  {
+    FILE *f = fopen(checkPath, "rb");
+
+    size = (f != NULL) ? (uint32_t)fread(image, 1, INDEX_MAX_BYTES, f) : 0U;
+    if ((f == NULL) || (LIBRARY_Load(&lib, image, size) != AUDIO_OK))
+    {
+      fprintf(stderr, "%s: cannot read, damaged or of another version\n", checkPath);
+      return 2;
+    }
+    fclose(f);
+    if (LIBRARY_Check(&Builder, &lib) != AUDIO_OK)
+    {
+      printf("%s: stale, rebuild it (%u sector reads)\n", checkPath, Reads);
+      return 1;
+    }
+    printf("%s: current (%u sector reads)\n", checkPath, Reads);
+    return 0;
+  }
+  if (LIBRARY_Build(&Builder, (uint8_t *)image, INDEX_MAX_BYTES, &size) != AUDIO_OK)
+  {
+    fprintf(stderr, "%s: not a FAT16/FAT32 volume, damaged, or over %u index bytes\n", argv[optind],
+            INDEX_MAX_BYTES);
+    return 2;
+  }
+  if (LIBRARY_Load(&lib, image, size) != AUDIO_OK)
+  {
+    fprintf(stderr, "index does not load back\n");
+    return 2;
+  }
+
+  for (i = 0U; i < lib.pHeader->NumEntries; i++)
+  {
+    const LIBRARY_EntryTypeDef *e = &lib.pEntries[i];
+    uint8_t sector[LIBRARY_SECTOR_SIZE];
+    uint32_t lba;
+
+    fragmented += (e->NumRuns > 1U) ? 1U : 0U;
+    if ((LIBRARY_Find(&lib, e->Id) != e) || (LIBRARY_Locate(&lib, e, 0U, &lba) == 0U)
+        || (INDEX_Read(&fd, lba, sector) != AUDIO_OK) || (memcmp(sector, "RIFF", 4) != 0))
+    {
+      fprintf(stderr, "entry %u (Id %u): lookup or run mapping is wrong\n", i, e->Id);
+      bad++;
+    }
+    if (list != 0)
+    {
+      printf("%10u  %-5s %u ch %6u Hz %9u frames  runs %3u", e->Id, INDEX_FormatName(e->Format),
+             e->Channels, e->Rate, e->Frames, e->NumRuns);
+      if (e->LoopStart != LIBRARY_NO_LOOP)
+      {
+        printf("  loop %u-%u", e->LoopStart, e->LoopEnd);
+      }
+      printf("\n");
+    }
+  }
+
+  printf("volume %08X: %u samples, %u runs (%u files fragmented), index %u bytes, %u sector reads\n",
+         lib.pHeader->VolumeId, lib.pHeader->NumEntries, lib.pHeader->NumRuns, fragmented, size, Reads);
+  if ((Builder.Skipped != 0U) || (Builder.Duplicates != 0U))
+  {
+    printf("%u WAV files skipped, %u dropped for a duplicate Id\n", Builder.Skipped, Builder.Duplicates);
+  }
+
+  if (outPath != NULL)
+  {
+    FILE *f = fopen(outPath, "wb");
+
+    if ((f == NULL) || (fwrite(image, 1, size, f) != size) || (fclose(f) != 0))
+    {
+      fprintf(stderr, "%s: cannot write\n", outPath);
+      return 2;
+    }
+  }
+  close(fd);
+  free(image);
+  if (bad != 0U)
+  {
+    return 2;
+  }
+  return ((Builder.Skipped != 0U) || (Builder.Duplicates != 0U)) ? 1 : 0;
+}
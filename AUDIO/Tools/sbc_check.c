@@ -0,0 +1,811 @@
+/**
+  ******************************************************************************
+  * @file    sbc_check.c
+  * @brief   Host round-trip check of the audio_sbc.c encoder.
+  *
+  *          Every frame is read back by the decoder of the A2DP
+  *          specification written out below, independent of the encoder:
+  *            - the header carries the configuration and the frame length
+  *              is the one the specification gives for it;
+  *            - the CRC matches, computed bytewise from a table;
+  *            - the bit allocation, redone from the scale factors, is the
+  *              encoder's, uses the whole bitpool and fits the frame, with
+  *              zero padding, at every bitpool of every mode;
+  *            - the synthesis filter bank gives back the input, delayed by
+  *              10 x Subbands - Subbands + 1 samples, at the SNR limit or
+  *              better for every mode, allocation, block count, subband
+  *              count and sampling frequency, at the high-quality and the
+  *              largest bitpool;
+  *            - joint stereo codes correlated channels mid/side;
+  *            - SBC_Init refuses parameters SBC cannot code.
+  *
+  *          This is not a bit-exact comparison with a reference encoder.
+  *          The specification fixes the bitstream and the decoder, not the
+  *          encoder's arithmetic, so libsbc's fixed-point analysis and this
+  *          encoder's float analysis legitimately round scale factors and
+  *          samples differently.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o sbc_check sbc_check.c \
+  *                ../Core/Src/audio_sbc.c -lm
+  *
+  *          Usage:
+  *            sbc_check [-l level dBFS] [-v]
+  *
+  *          Defaults: program at -6 dBFS peak. -v prints every
+  *          configuration, not only the failing ones and the worst per mode.
+  *          The exit status is 1 at the first frame or SNR that is off.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_sbc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_SAMPLES             24576U  /* Multiple of every frame length */
+#define CHECK_SWEEP_SAMPLES       4608U
+#define CHECK_MAX_LAG             128U
+#define CHECK_HQ_SNR_DB           36.0    /* High-quality bitpool            */
+#define CHECK_MAX_SNR_DB          58.0    /* Largest bitpool                 */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Channels;
+  uint32_t Subbands;
+  uint32_t Blocks;
+  uint32_t Bitpool;
+  uint32_t Joined;            /* Subbands coded mid/side, over all frames */
+  float    V[SBC_MAX_CHANNELS][20U * SBC_MAX_SUBBANDS];
+} CHECK_DecoderTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static const char *const ModeNames[4] = { "mono", "dual", "stereo", "joint" };
+static const char *const AllocNames[2] = { "loudness", "snr" };
+static const uint32_t Rates[4] = { 16000U, 32000U, 44100U, 48000U };
+
+/* Loudness offsets of the specification, per sampling frequency */
+static const int32_t Offset4[4][4] =
+{
+  { -1, 0, 0, 0 }, { -2, 0, 0, 1 }, { -2, 0, 0, 1 }, { -2, 0, 0, 1 }
+};
+static const int32_t Offset8[4][8] =
+{
+  { -2, 0, 0, 0, 0, 0, 0, 1 }, { -3, 0, 0, 0, 0, 0, 1, 2 },
+  { -4, 0, 0, 0, 0, 0, 1, 2 }, { -4, 0, 0, 0, 0, 0, 1, 2 }
+};
+
+/* Windows of the specification, Proto_4_40 and Proto_8_80 */
+static const double Proto4[40] =
+{
+  0.00000000E+00,  5.36548976E-04,  1.49188357E-03,  2.73370904E-03,
+  3.83720193E-03,  3.89205149E-03,  1.86581691E-03, -3.06012286E-03,
+  1.09137620E-02,  2.04385087E-02,  2.88757392E-02,  3.21939290E-02,
+  2.58767811E-02,  6.13245186E-03, -2.88217274E-02, -7.76463494E-02,
+  1.35593274E-01,  1.94987841E-01,  2.46636662E-01,  2.81828203E-01,
+  2.94315332E-01,  2.81828203E-01,  2.46636662E-01,  1.94987841E-01,
+ -1.35593274E-01, -7.76463494E-02, -2.88217274E-02,  6.13245186E-03,
+  2.58767811E-02,  3.21939290E-02,  2.88757392E-02,  2.04385087E-02,
+ -1.09137620E-02, -3.06012286E-03,  1.86581691E-03,  3.89205149E-03,
+  3.83720193E-03,  2.73370904E-03,  1.49188357E-03,  5.36548976E-04
+};
+static const double Proto8[80] =
+{
+  0.00000000E+00,  1.56575398E-04,  3.43256425E-04,  5.54620202E-04,
+  8.23919506E-04,  1.13992507E-03,  1.47640169E-03,  1.78371725E-03,
+  2.01182542E-03,  2.10371989E-03,  1.99454554E-03,  1.61656283E-03,
+  9.02154502E-04, -1.78805361E-04, -1.64973098E-03, -3.49717454E-03,
+  5.65949473E-03,  8.02941163E-03,  1.04584443E-02,  1.27472335E-02,
+  1.46525263E-02,  1.59045603E-02,  1.62208471E-02,  1.53184106E-02,
+  1.29371806E-02,  8.85757540E-03,  2.92408442E-03, -4.91578024E-03,
+ -1.46404076E-02, -2.61098752E-02, -3.90751381E-02, -5.31873032E-02,
+  6.79989431E-02,  8.29847578E-02,  9.75753918E-02,  1.11196689E-01,
+  1.23264548E-01,  1.33264415E-01,  1.40753505E-01,  1.45389847E-01,
+  1.46955068E-01,  1.45389847E-01,  1.40753505E-01,  1.33264415E-01,
+  1.23264548E-01,  1.11196689E-01,  9.75753918E-02,  8.29847578E-02,
+ -6.79989431E-02, -5.31873032E-02, -3.90751381E-02, -2.61098752E-02,
+ -1.46404076E-02, -4.91578024E-03,  2.92408442E-03,  8.85757540E-03,
+  1.29371806E-02,  1.53184106E-02,  1.62208471E-02,  1.59045603E-02,
+  1.46525263E-02,  1.27472335E-02,  1.04584443E-02,  8.02941163E-03,
+ -5.65949473E-03, -3.49717454E-03, -1.64973098E-03, -1.78805361E-04,
+  9.02154502E-04,  1.61656283E-03,  1.99454554E-03,  2.10371989E-03,
+  2.01182542E-03,  1.78371725E-03,  1.47640169E-03,  1.13992507E-03,
+  8.23919506E-04,  5.54620202E-04,  3.43256425E-04,  1.56575398E-04
+};
+
+static SBC_HandleTypeDef Encoder;
+static CHECK_DecoderTypeDef Decoder;
+static uint8_t CrcTable[256];
+static float In[SBC_MAX_CHANNELS][CHECK_SAMPLES];
+static float Out[SBC_MAX_CHANNELS][CHECK_SAMPLES];
+static uint8_t Frame[SBC_MAX_FRAME_SIZE];
+static int Verbose;
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t CHECK_GetBits(const uint8_t *pFrame, uint32_t *pPos, uint32_t Bits)
+{
+  uint32_t value = 0U;
+
+  while (Bits-- > 0U)
+  {
+    value = (value << 1) | ((pFrame[*pPos >> 3] >> (7U - (*pPos & 7U))) & 1U);
+    (*pPos)++;
+  }
+  return value;
+}
+
+/* CRC-8, x^8 + x^4 + x^3 + x^2 + 1, most significant bit first */
+static void CHECK_CrcInit(void)
+{
+  uint32_t i;
+  uint32_t b;
+
+  for (i = 0U; i < 256U; i++)
+  {
+    uint32_t crc = i;
+
+    for (b = 0U; b < 8U; b++)
+    {
+      crc = ((crc & 0x80U) != 0U) ? ((crc << 1) ^ 0x1DU) : (crc << 1);
+    }
+    CrcTable[i] = (uint8_t)crc;
+  }
+}
+
+/* Bytes 1 and 2, then Bits bits from byte 4 on */
+static uint8_t CHECK_Crc(const uint8_t *pFrame, uint32_t Bits)
+{
+  uint32_t crc = CrcTable[0x0FU ^ pFrame[1]];
+  uint32_t i;
+
+  crc = CrcTable[crc ^ pFrame[2]];
+  for (i = 0U; i < Bits / 8U; i++)
+  {
+    crc = CrcTable[crc ^ pFrame[4U + i]];
+  }
+  for (i = 0U; i < Bits % 8U; i++)
+  {
+    uint32_t bit = (pFrame[4U + Bits / 8U] >> (7U - i)) & 1U;
+
+    crc = ((((crc >> 7) ^ bit) & 1U) != 0U) ? (((crc << 1) ^ 0x1DU) & 0xFFU) : ((crc << 1) & 0xFFU);
+  }
+  return (uint8_t)crc;
+}
+
+
+/* Bit allocation of the specification for Channels channels sharing the bitpool */
+static void CHECK_Allocate(const SBC_ConfigTypeDef *pCfg, const uint8_t pSf[][SBC_MAX_SUBBANDS],
+                           uint32_t Channels, uint8_t pBits[][SBC_MAX_SUBBANDS])
+{
+  int32_t nrof = (int32_t)pCfg->Subbands;
+  int32_t bitpool = (int32_t)pCfg->Bitpool;
+  int32_t bitneed[2][8];
+  int32_t max_bitneed = 0;
+  int32_t bitcount = 0;
+  int32_t slicecount = 0;
+  int32_t bitslice;
+  int32_t ch;
+  int32_t sb;
+
+  for (ch = 0; ch < (int32_t)Channels; ch++)
+  {
+    for (sb = 0; sb < nrof; sb++)
+    {
+      if (pCfg->Allocation == SBC_ALLOC_SNR)
+      {
+        bitneed[ch][sb] = pSf[ch][sb];
+      }
+      else if (pSf[ch][sb] == 0U)
+      {
+        bitneed[ch][sb] = -5;
+      }
+      else
+      {
+        int32_t loudness = pSf[ch][sb] - ((nrof == 4) ? Offset4[pCfg->Frequency][sb]
+                                                       : Offset8[pCfg->Frequency][sb]);
+
+        bitneed[ch][sb] = (loudness > 0) ? loudness / 2 : loudness;
+      }
+      if (bitneed[ch][sb] > max_bitneed)
+      {
+        max_bitneed = bitneed[ch][sb];
+      }
+    }
+  }
+
+  bitslice = max_bitneed + 1;
+  do
+  {
+    bitslice--;
+    bitcount += slicecount;
+    slicecount = 0;
+    for (ch = 0; ch < (int32_t)Channels; ch++)
+    {
+      for (sb = 0; sb < nrof; sb++)
+      {
+        if ((bitneed[ch][sb] > bitslice + 1) && (bitneed[ch][sb] < bitslice + 16))
+        {
+          slicecount++;
+        }
+        else if (bitneed[ch][sb] == bitslice + 1)
+        {
+          slicecount += 2;
+        }
+      }
+    }
+  } while (bitcount + slicecount < bitpool);
+  if (bitcount + slicecount == bitpool)
+  {
+    bitcount += slicecount;
+    bitslice--;
+  }
+
+  for (ch = 0; ch < (int32_t)Channels; ch++)
+  {
+    for (sb = 0; sb < nrof; sb++)
+    {
+      if (bitneed[ch][sb] < bitslice + 2)
+      {
+        pBits[ch][sb] = 0U;
+      }
+      else
+      {
+        pBits[ch][sb] = (uint8_t)((bitneed[ch][sb] - bitslice < 16) ? bitneed[ch][sb] - bitslice : 16);
+      }
+    }
+  }
+
+  ch = 0;
+  sb = 0;
+  while ((bitcount < bitpool) && (sb < nrof))
+  {
+    if ((pBits[ch][sb] >= 2U) && (pBits[ch][sb] < 16U))
+    {
+      pBits[ch][sb]++;
+      bitcount++;
+    }
+    else if ((bitneed[ch][sb] == bitslice + 1) && (bitpool > bitcount + 1))
+    {
+      pBits[ch][sb] = 2U;
+      bitcount += 2;
+    }
+    if ((Channels == 1U) || (ch == 1))
+    {
+      ch = 0;
+      sb++;
+    }
+    else
+    {
+      ch = 1;
+    }
+  }
+
+  ch = 0;
+  sb = 0;
+  while ((bitcount < bitpool) && (sb < nrof))
+  {
+    if (pBits[ch][sb] < 16U)
+    {
+      pBits[ch][sb]++;
+      bitcount++;
+    }
+    if ((Channels == 1U) || (ch == 1))
+    {
+      ch = 0;
+      sb++;
+    }
+    else
+    {
+      ch = 1;
+    }
+  }
+}
+
+/* Frame length the specification gives for the configuration */
+static uint32_t CHECK_FrameLength(const SBC_ConfigTypeDef *pCfg)
+{
+  uint32_t nrof_channels = (pCfg->Mode == SBC_MODE_MONO) ? 1U : 2U;
+  uint32_t join = (pCfg->Mode == SBC_MODE_JOINT_STEREO) ? 1U : 0U;
+  uint32_t data;
+
+  if ((pCfg->Mode == SBC_MODE_MONO) || (pCfg->Mode == SBC_MODE_DUAL_CHANNEL))
+  {
+    data = pCfg->Blocks * nrof_channels * pCfg->Bitpool;
+  }
+  else
+  {
+    data = join * pCfg->Subbands + pCfg->Blocks * pCfg->Bitpool;
+  }
+  return 4U + (4U * pCfg->Subbands * nrof_channels) / 8U + (data + 7U) / 8U;
+}
+
+/* Synthesis filter bank of the specification over one block of one channel */
+static void CHECK_Synthesize(uint32_t Channel, const double *pSb, float *pOut)
+{
+  uint32_t m = Decoder.Subbands;
+  const double *d = (m == 8U) ? Proto8 : Proto4;
+  float *v = Decoder.V[Channel];
+  double u[10U * SBC_MAX_SUBBANDS];
+  uint32_t i;
+  uint32_t j;
+  uint32_t k;
+
+  memmove(&v[2U * m], v, 18U * m * sizeof(v[0]));
+  for (k = 0U; k < 2U * m; k++)
+  {
+    double acc = 0.0;
+
+    for (i = 0U; i < m; i++)
+    {
+      acc += cos(((double)i + 0.5) * ((double)k + (double)m / 2.0) * M_PI / (double)m) * pSb[i];
+    }
+    v[k] = (float)acc;
+  }
+  for (i = 0U; i < 5U; i++)
+  {
+    for (j = 0U; j < m; j++)
+    {
+      u[i * 2U * m + j]     = v[i * 4U * m + j];
+      u[i * 2U * m + m + j] = v[i * 4U * m + 3U * m + j];
+    }
+  }
+  for (j = 0U; j < m; j++)
+  {
+    double x = 0.0;
+
+    for (i = 0U; i < 10U; i++)
+    {
+      x += u[j + m * i] * d[j + m * i] * -(double)m;   /* D[i] = -M x C[i] */
+    }
+    pOut[j] = (float)(x / 32768.0);
+  }
+}
+
+/* Reads one frame back; NULL, or what is wrong with it */
+static const char *CHECK_Decode(const SBC_ConfigTypeDef *pCfg, uint32_t Size, float *pLeft, float *pRight)
+{
+  uint32_t channels = (pCfg->Mode == SBC_MODE_MONO) ? 1U : 2U;
+  uint32_t m = pCfg->Subbands;
+  uint8_t sf[SBC_MAX_CHANNELS][SBC_MAX_SUBBANDS];
+  uint8_t bits[SBC_MAX_CHANNELS][SBC_MAX_SUBBANDS];
+  double sb[SBC_MAX_CHANNELS][SBC_MAX_SUBBANDS];
+  uint32_t join = 0U;
+  uint32_t total;
+  uint32_t pos = 32U;
+  uint32_t ch;
+  uint32_t blk;
+  uint32_t k;
+
+  if ((Size != CHECK_FrameLength(pCfg)) || (Frame[0] != 0x9CU))
+  {
+    return "frame length or syncword";
+  }
+  if (((uint32_t)(Frame[1] >> 6) != (uint32_t)pCfg->Frequency) ||
+      (((Frame[1] >> 4) & 3U) * 4U + 4U != pCfg->Blocks) ||
+      ((uint32_t)((Frame[1] >> 2) & 3U) != (uint32_t)pCfg->Mode) ||
+      ((uint32_t)((Frame[1] >> 1) & 1U) != (uint32_t)pCfg->Allocation) ||
+      ((((Frame[1] & 1U) != 0U) ? 8U : 4U) != m) || (Frame[2] != pCfg->Bitpool))
+  {
+    return "header";
+  }
+
+  if (pCfg->Mode == SBC_MODE_JOINT_STEREO)
+  {
+    join = CHECK_GetBits(Frame, &pos, m);
+    if ((join & 1U) != 0U)
+    {
+      return "last subband joined";
+    }
+  }
+  for (ch = 0U; ch < channels; ch++)
+  {
+    for (k = 0U; k < m; k++)
+    {
+      sf[ch][k] = (uint8_t)CHECK_GetBits(Frame, &pos, 4U);
+    }
+  }
+  if (Frame[3] != CHECK_Crc(Frame, pos - 32U))
+  {
+    return "CRC";
+  }
+
+  if (pCfg->Mode == SBC_MODE_DUAL_CHANNEL)
+  {
+    CHECK_Allocate(pCfg, &sf[0], 1U, &bits[0]);
+    CHECK_Allocate(pCfg, &sf[1], 1U, &bits[1]);
+  }
+  else
+  {
+    CHECK_Allocate(pCfg, sf, channels, bits);
+  }
+  for (ch = 0U; ch < channels; ch++)
+  {
+    uint32_t used = 0U;
+    uint32_t full = 1U;
+
+    for (k = 0U; k < m; k++)
+    {
+      used += bits[ch][k];
+      full &= (bits[ch][k] == 16U) ? 1U : 0U;
+    }
+    if ((pCfg->Mode == SBC_MODE_STEREO) || (pCfg->Mode == SBC_MODE_JOINT_STEREO))
+    {
+      if (ch == 0U)
+      {
+        continue;
+      }
+      for (k = 0U; k < m; k++)
+      {
+        used += bits[0][k];
+        full &= (bits[0][k] == 16U) ? 1U : 0U;
+      }
+    }
+    if ((used > pCfg->Bitpool) || ((used < pCfg->Bitpool) && (full == 0U)))
+    {
+      return "bit allocation leaves bitpool unused";
+    }
+    if (memcmp(bits[ch], Encoder.Bits[ch], m) != 0)
+    {
+      return "bit allocation differs from the encoder's";
+    }
+  }
+
+  for (blk = 0U; blk < pCfg->Blocks; blk++)
+  {
+    for (ch = 0U; ch < channels; ch++)
+    {
+      for (k = 0U; k < m; k++)
+      {
+        double levels = (double)((1U << bits[ch][k]) - 1U);
+
+        sb[ch][k] = 0.0;
+        if (bits[ch][k] != 0U)
+        {
+          double q = (double)CHECK_GetBits(Frame, &pos, bits[ch][k]);
+
+          sb[ch][k] = (double)(2U << sf[ch][k]) * ((q * 2.0 + 1.0) / levels - 1.0);
+        }
+      }
+    }
+    for (k = 0U; k < m; k++)
+    {
+      if ((join & (1U << (m - 1U - k))) != 0U)
+      {
+        double mid = sb[0][k];
+
+        sb[0][k] = mid + sb[1][k];
+        sb[1][k] = mid - sb[1][k];
+        Decoder.Joined += (blk == 0U) ? 1U : 0U;
+      }
+    }
+    CHECK_Synthesize(0U, sb[0], &pLeft[blk * m]);
+    if (channels == 2U)
+    {
+      CHECK_Synthesize(1U, sb[1], &pRight[blk * m]);
+    }
+  }
+
+  total = pos;
+  if (total > Size * 8U)
+  {
+    return "samples overrun the frame";
+  }
+  while (pos < Size * 8U)
+  {
+    if (CHECK_GetBits(Frame, &pos, 1U) != 0U)
+    {
+      return "padding not zero";
+    }
+  }
+  return NULL;
+}
+
+/* SNR in dB of Got against Want delayed by Lag, over the second half */
+static double CHECK_Snr(const float *pWant, const float *pGot, uint32_t Lag)
+{
+  double signal = 0.0;
+  double noise = 0.0;
+  uint32_t i;
+
+  for (i = CHECK_SAMPLES / 2U; i < CHECK_SAMPLES; i++)
+  {
+    double e = (double)pGot[i] - (double)pWant[i - Lag];
+
+    signal += (double)pWant[i - Lag] * (double)pWant[i - Lag];
+    noise  += e * e;
+  }
+  return 10.0 * log10(signal / AUDIO_MAX(noise, 1e-30));
+}
+
+/* Encodes and decodes Samples of In into Out; NULL, or what is wrong with a frame */
+static const char *CHECK_RoundTrip(const SBC_ConfigTypeDef *pCfg, uint32_t Samples)
+{
+  uint32_t n;
+
+  if (SBC_Init(&Encoder, pCfg) != AUDIO_OK)
+  {
+    return "SBC_Init refuses the configuration";
+  }
+  memset(&Decoder, 0, sizeof(Decoder));
+  Decoder.Subbands = pCfg->Subbands;
+  memset(Out, 0, sizeof(Out));
+  for (n = 0U; n < Samples; n += SBC_GetFrameSamples(&Encoder))
+  {
+    uint32_t size = SBC_Encode(&Encoder, &In[0][n], &In[1][n], Frame);
+    const char *error;
+
+    if (size != SBC_GetFrameSize(&Encoder))
+    {
+      return "SBC_Encode and SBC_GetFrameSize disagree";
+    }
+    error = CHECK_Decode(pCfg, size, &Out[0][n], &Out[1][n]);
+    if (error != NULL)
+    {
+      return error;
+    }
+  }
+  return NULL;
+}
+
+/* Program: three partials per channel, the right one mostly the left */
+static void CHECK_Program(double Level, double Rate)
+{
+  double a = pow(10.0, Level / 20.0);
+  uint32_t i;
+
+  for (i = 0U; i < CHECK_SAMPLES; i++)
+  {
+    double t = (double)i / Rate;
+    double l = 0.5 * sin(2.0 * M_PI * 0.0113 * Rate * t) + 0.3 * sin(2.0 * M_PI * 0.0731 * Rate * t) +
+               0.2 * sin(2.0 * M_PI * 0.2287 * Rate * t);
+
+    In[0][i] = (float)(a * l);
+    In[1][i] = (float)(a * (0.7 * l + 0.3 * sin(2.0 * M_PI * 0.0417 * Rate * t)));
+  }
+}
+
+/* Filter bank delay: the best lag for white noise at the largest bitpool */
+static int CHECK_Delay(double Level)
+{
+  double a = pow(10.0, Level / 20.0) * sqrt(3.0);
+  int failed = 0;
+  uint32_t m;
+  uint32_t i;
+
+  srand(1U);
+  for (i = 0U; i < CHECK_SAMPLES; i++)
+  {
+    In[0][i] = (float)(a * ((double)rand() / (double)RAND_MAX * 2.0 - 1.0));
+  }
+  for (m = 4U; m <= 8U; m += 4U)
+  {
+    SBC_ConfigTypeDef cfg = { SBC_FREQ_48000, SBC_MODE_MONO, SBC_ALLOC_SNR, 16U, (uint8_t)m,
+                              (uint8_t)(16U * m) };
+    const char *error = CHECK_RoundTrip(&cfg, CHECK_SAMPLES);
+    double best = -HUGE_VAL;
+    uint32_t delay = 0U;
+    uint32_t lag;
+
+    if (error != NULL)
+    {
+      printf("delay, %u subbands: %s\n", m, error);
+      return 1;
+    }
+    for (lag = 0U; lag < CHECK_MAX_LAG; lag++)
+    {
+      double snr = CHECK_Snr(In[0], Out[0], lag);
+
+      if (snr > best)
+      {
+        best = snr;
+        delay = lag;
+      }
+    }
+    printf("%u subbands: delay %u samples (expected %u), noise SNR %.1f dB\n", m, delay,
+           9U * m + 1U, best);
+    failed |= (delay != 9U * m + 1U);
+  }
+  return failed;
+}
+
+/* Every mode, allocation, block count, subband count and frequency */
+static int CHECK_Modes(double Level)
+{
+  int failed = 0;
+  uint32_t mode;
+
+  for (mode = 0U; mode < 4U; mode++)
+  {
+    uint32_t channels = (mode == (uint32_t)SBC_MODE_MONO) ? 1U : 2U;
+    double worst[2] = { HUGE_VAL, HUGE_VAL };
+    uint32_t joined = 0U;
+    uint32_t runs = 0U;
+    uint32_t freq;
+    uint32_t alloc;
+    uint32_t m;
+    uint32_t blocks;
+    uint32_t p;
+
+    for (freq = 0U; freq < 4U; freq++)
+    {
+      CHECK_Program(Level, (double)Rates[freq]);
+      for (alloc = 0U; alloc < 2U; alloc++)
+      {
+        for (m = 4U; m <= 8U; m += 4U)
+        {
+          for (blocks = 4U; blocks <= 16U; blocks += 4U)
+          {
+            uint32_t maxpool = 16U * m * ((mode >= (uint32_t)SBC_MODE_STEREO) ? 2U : 1U);
+            uint32_t pools[2] = { (mode >= (uint32_t)SBC_MODE_STEREO) ? 53U : 31U,
+                                  AUDIO_MIN(maxpool, SBC_MAX_BITPOOL) };
+
+            for (p = 0U; p < 2U; p++)
+            {
+              SBC_ConfigTypeDef cfg = { (SBC_FrequencyTypeDef)freq, (SBC_ModeTypeDef)mode,
+                                        (SBC_AllocationTypeDef)alloc, (uint8_t)blocks, (uint8_t)m,
+                                        (uint8_t)pools[p] };
+              double limit = (p == 0U) ? CHECK_HQ_SNR_DB : CHECK_MAX_SNR_DB;
+              const char *error = CHECK_RoundTrip(&cfg, CHECK_SAMPLES);
+              double snr = HUGE_VAL;
+              uint32_t ch;
+
+              for (ch = 0U; (error == NULL) && (ch < channels); ch++)
+              {
+                snr = AUDIO_MIN(snr, CHECK_Snr(In[ch], Out[ch], 9U * m + 1U));
+              }
+              if (error != NULL)
+              {
+                printf("%s %s %u Hz, %u subbands, %u blocks, bitpool %u: %s\n", ModeNames[mode],
+                       AllocNames[alloc], Rates[freq], m, blocks, pools[p], error);
+              }
+              else if ((snr < limit) || (Verbose != 0))
+              {
+                printf("%s %s %u Hz, %u subbands, %u blocks, bitpool %u: SNR %.1f dB, limit %.1f\n",
+                       ModeNames[mode], AllocNames[alloc], Rates[freq], m, blocks, pools[p], snr, limit);
+              }
+              failed |= (error != NULL) || (snr < limit);
+              worst[p] = AUDIO_MIN(worst[p], snr);
+              joined += Decoder.Joined;
+              runs++;
+            }
+          }
+        }
+      }
+    }
+    printf("%s: %u configurations, worst SNR %.1f dB at the high-quality bitpool (limit %.1f), "
+           "%.1f dB at the largest (limit %.1f)", ModeNames[mode], runs, worst[0], CHECK_HQ_SNR_DB,
+           worst[1], CHECK_MAX_SNR_DB);
+    if (mode == (uint32_t)SBC_MODE_JOINT_STEREO)
+    {
+      printf(", %u subbands coded mid/side", joined);
+      failed |= (joined == 0U);
+    }
+    printf("\n");
+  }
+  return failed;
+}
+
+/* Every bitpool, on noise whose level steps every frame, so the allocation
+   meets all its corner cases */
+static int CHECK_Bitpools(void)
+{
+  uint32_t runs = 0U;
+  uint32_t bad = 0U;
+  uint32_t mode;
+  uint32_t alloc;
+  uint32_t m;
+  uint32_t pool;
+  uint32_t i;
+
+  srand(2U);
+  for (i = 0U; i < CHECK_SWEEP_SAMPLES; i++)
+  {
+    double a = pow(10.0, -(double)((i / 128U) % 9U) * 6.0 / 20.0);
+
+    In[0][i] = (float)(a * ((double)rand() / (double)RAND_MAX * 2.0 - 1.0));
+    In[1][i] = (float)(a * ((double)rand() / (double)RAND_MAX * 2.0 - 1.0) * 0.5 + In[0][i] * 0.5);
+  }
+  for (mode = 0U; mode < 4U; mode++)
+  {
+    for (alloc = 0U; alloc < 2U; alloc++)
+    {
+      for (m = 4U; m <= 8U; m += 4U)
+      {
+        uint32_t maxpool = 16U * m * ((mode >= (uint32_t)SBC_MODE_STEREO) ? 2U : 1U);
+
+        for (pool = 2U; pool <= AUDIO_MIN(maxpool, SBC_MAX_BITPOOL); pool++)
+        {
+          SBC_ConfigTypeDef cfg = { SBC_FREQ_44100, (SBC_ModeTypeDef)mode, (SBC_AllocationTypeDef)alloc,
+                                    8U, (uint8_t)m, (uint8_t)pool };
+          const char *error = CHECK_RoundTrip(&cfg, CHECK_SWEEP_SAMPLES);
+
+          if (error != NULL)
+          {
+            if (bad++ == 0U)
+            {
+              printf("%s %s, %u subbands, bitpool %u: %s\n", ModeNames[mode], AllocNames[alloc], m,
+                     pool, error);
+            }
+          }
+          runs++;
+        }
+      }
+    }
+  }
+  printf("bitpool sweep: %u of %u configurations with a bad frame\n", bad, runs);
+  return (bad != 0U);
+}
+
+/* Parameters SBC cannot code */
+static int CHECK_Refused(void)
+{
+  static const SBC_ConfigTypeDef bad[] =
+  {
+    { SBC_FREQ_48000, SBC_MODE_MONO,         SBC_ALLOC_SNR,      16U, 6U,   32U },
+    { SBC_FREQ_48000, SBC_MODE_MONO,         SBC_ALLOC_SNR,       6U, 8U,   32U },
+    { SBC_FREQ_48000, SBC_MODE_MONO,         SBC_ALLOC_SNR,      20U, 8U,   32U },
+    { SBC_FREQ_48000, SBC_MODE_MONO,         SBC_ALLOC_SNR,      16U, 8U,    1U },
+    { SBC_FREQ_48000, SBC_MODE_MONO,         SBC_ALLOC_SNR,      16U, 8U,  129U },
+    { SBC_FREQ_48000, SBC_MODE_DUAL_CHANNEL, SBC_ALLOC_LOUDNESS, 16U, 4U,   65U },
+    { SBC_FREQ_48000, SBC_MODE_JOINT_STEREO, SBC_ALLOC_LOUDNESS, 16U, 8U,  251U }
+  };
+  uint32_t accepted = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < sizeof(bad) / sizeof(bad[0]); i++)
+  {
+    if (SBC_Init(&Encoder, &bad[i]) != AUDIO_ERROR)
+    {
+      printf("SBC_Init accepts %u subbands, %u blocks, bitpool %u in %s\n", bad[i].Subbands,
+             bad[i].Blocks, bad[i].Bitpool, ModeNames[bad[i].Mode]);
+      accepted++;
+    }
+  }
+  printf("SBC_Init: %u of %u invalid configurations accepted\n", accepted,
+         (uint32_t)(sizeof(bad) / sizeof(bad[0])));
+  return (accepted != 0U);
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  double level = -6.0;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:v")) != -1)
+  {
+    switch (opt)
+    {
+      case 'l': level = atof(optarg); break;
+      case 'v': Verbose = 1; break;
+      default:
+        fprintf(stderr, "usage: sbc_check [-l dBFS] [-v]\n");
+        return 2;
+    }
+  }
+  if ((level > 0.0) || (level < -40.0))
+  {
+    fprintf(stderr, "sbc_check: level out of -40 .. 0 dBFS\n");
+    return 2;
+  }
+
+  CHECK_CrcInit();
+  failed |= CHECK_Delay(level);
+  failed |= CHECK_Modes(level);
+  failed |= CHECK_Bitpools();
+  failed |= CHECK_Refused();
+  return failed;
+}
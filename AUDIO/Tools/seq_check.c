@@ -0,0 +1,144 @@
+/**
+  ******************************************************************************
+  * @file    seq_check.c
+  * @brief   Host long-run check of the audio_seq.c timeline.
+  *
+  *          Runs the sequencer block by block on its internal clock for a
+  *          number of hours of audio, every step of a one-step pattern
+  *          active, and checks each trigger against the position computed
+  *          from the start with 128-bit integers: start + n * StepLength,
+  *          plus swing on odd steps, rounded to the nearest frame. Every
+  *          step must fire exactly once, in the block holding its position
+  *          and at its exact offset, however long the transport has run.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o seq_check seq_check.c \
+  *                ../Core/Src/audio_seq.c
+  *
+  *          Usage:
+  *            seq_check [-t hours] [-b block frames] [-T tempo x100]
+  *                      [-s swing] [-o start offset]
+  *
+  *          Defaults: 30 hours (past the 24.8 h at which 2^32 samples wrap
+  *          at 48 kHz), 64-frame blocks, 127.00 BPM, swing 58. The exit
+  *          status is 1 at the first step that is missed, repeated or off.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_seq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private variables ---------------------------------------------------------*/
+static SEQ_HandleTypeDef Seq;
+static SEQ_PatternTypeDef Pattern;
+
+/* Private functions ---------------------------------------------------------*/
+/* Frame at which step n must fire, from the step length the sequencer uses */
+static uint64_t CHECK_Expected(uint64_t Start, uint64_t StepLength, uint32_t Swing, uint64_t Step)
+{
+  unsigned __int128 t = ((unsigned __int128)Start << 32) + (unsigned __int128)Step * StepLength;
+
+  if ((Step & 1U) != 0U)
+  {
+    t += (StepLength / 100U) * (2U * Swing - 100U);
+  }
+  return (uint64_t)((t + 0x80000000U) >> 32);
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  SEQ_EventTypeDef events[SEQ_MAX_EVENTS];
+  double hours = 30.0;
+  uint32_t block = AUDIO_BLOCK_SIZE;
+  uint32_t tempo = 12700U;
+  uint32_t swing = 58U;
+  uint32_t offset = 17U;
+  uint64_t frames;
+  uint64_t start;
+  uint64_t step = 0U;
+  uint64_t now = 0U;
+  uint64_t worst = 0U;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "t:b:T:s:o:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': hours = atof(optarg); break;
+      case 'b': block = (uint32_t)atoi(optarg); break;
+      case 'T': tempo = (uint32_t)atoi(optarg); break;
+      case 's': swing = (uint32_t)atoi(optarg); break;
+      case 'o': offset = (uint32_t)atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: seq_check [-t hours] [-b frames] [-T tempo x100] [-s swing]"
+                " [-o offset]\n");
+        return 2;
+    }
+  }
+  if ((block == 0U) || (offset >= block) || (swing < 50U) || (swing > 75U) || (tempo == 0U))
+  {
+    fprintf(stderr, "seq_check: bad block, offset, swing or tempo\n");
+    return 2;
+  }
+
+  memset(&Pattern, 0, sizeof(Pattern));
+  Pattern.Length = 1U;
+  Pattern.Steps[0][0].Active   = 1U;
+  Pattern.Steps[0][0].Velocity = 100U;
+  SEQ_Init(&Seq, &Pattern);
+  SEQ_SetTempo(&Seq, tempo);
+  SEQ_SetSwing(&Seq, (uint8_t)swing);
+
+  /* A block in, so the start is not at sample 0 */
+  (void)SEQ_Process(&Seq, block, events, SEQ_MAX_EVENTS);
+  now = block;
+  start = now + offset;
+  SEQ_Start(&Seq, offset);
+
+  frames = (uint64_t)(hours * 3600.0 * (double)AUDIO_SAMPLE_RATE);
+  while (now < frames)
+  {
+    uint32_t n = SEQ_Process(&Seq, block, events, SEQ_MAX_EVENTS);
+    uint64_t next = CHECK_Expected(start, Seq.StepLength, swing, step);
+    uint32_t i;
+
+    for (i = 0U; i < n; i++)
+    {
+      uint64_t at = now + events[i].Offset;
+
+      if ((at != next) || (events[i].Offset >= block))
+      {
+        printf("step %llu at frame %llu (%.3f h), expected %llu\n", (unsigned long long)step,
+               (unsigned long long)at, (double)at / (3600.0 * AUDIO_SAMPLE_RATE),
+               (unsigned long long)next);
+        return 1;
+      }
+      step++;
+      next = CHECK_Expected(start, Seq.StepLength, swing, step);
+    }
+    now += block;
+    if (next < now)
+    {
+      printf("step %llu missed: due at frame %llu (%.3f h)\n", (unsigned long long)step,
+             (unsigned long long)next, (double)next / (3600.0 * AUDIO_SAMPLE_RATE));
+      return 1;
+    }
+    worst = AUDIO_MAX(worst, (uint64_t)n);
+  }
+
+  printf("%.1f h, %llu steps, at most %llu per block, all exact\n", hours,
+         (unsigned long long)step, (unsigned long long)worst);
+  return 0;
+}
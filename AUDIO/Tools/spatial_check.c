@@ -0,0 +1,255 @@
+/**
+  ******************************************************************************
+  * @file    spatial_check.c
+  * @brief   Host check of the audio_fir.c engine and of moving sources in
+  *          audio_spatial.c.
+  *
+  *          FIR engine, against a direct convolution in double precision:
+  *            - blocks several times longer than MaxFrames, in calls of
+  *              varying length, in place and accumulated;
+  *            - FIR_CrossfadeAccumulate() over a block longer than MaxFrames
+  *              equals the old and new responses blended linearly.
+  *          Spatializer, with a synthetic HRTF set whose neighbouring
+  *          responses differ as much as they can (delta taps far apart):
+  *            - a sine from a source jumping to a new direction every block
+  *              must not step: the largest sample to sample change of each
+  *              ear, over the ear's peak, may exceed that of a steady sine,
+  *              2 sin(pi f / fs), by the limit ratio at most. The ITD glide
+  *              shifts the pitch, so some excess is expected.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o spatial_check spatial_check.c \
+  *                ../Core/Src/audio_fir.c ../Core/Src/audio_spatial.c -lm
+  *
+  *          Usage:
+  *            spatial_check [-f sine Hz] [-r degrees per block] [-l limit ratio]
+  *
+  *          Defaults: 200 Hz, 37 degrees per block, ratio 2. The exit status
+  *          is 1 if a FIR output is off by more than 1e-5 or a moving source
+  *          steps.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_spatial.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_TAPS                31U
+#define CHECK_SLICE               16U     /* MaxFrames of the FIR under test */
+#define CHECK_FRAMES              1000U
+#define CHECK_AZIMUTHS            12U
+#define CHECK_SECONDS             1U
+#define CHECK_TOLERANCE           1e-5
+
+/* Private variables ---------------------------------------------------------*/
+static float Coeffs[2][CHECK_TAPS];
+static float State[FIR_STATE_SIZE(CHECK_TAPS, CHECK_SLICE)];
+static float In[CHECK_FRAMES];
+static float Out[CHECK_FRAMES];
+static float Filters[CHECK_AZIMUTHS * 2U][SPATIAL_MAX_TAPS];
+static float Itd[CHECK_AZIMUTHS];
+static SPATIAL_HandleTypeDef Spatial;
+
+/* Private functions ---------------------------------------------------------*/
+/* Output n of h over In, inputs before the start being zero */
+static double CHECK_Convolve(const float *h, uint32_t n)
+{
+  double acc = 0.0;
+  uint32_t k;
+
+  for (k = 0U; (k < CHECK_TAPS) && (k <= n); k++)
+  {
+    acc += (double)h[k] * (double)In[n - k];
+  }
+  return acc;
+}
+
+static double CHECK_Fir(void)
+{
+  static const uint32_t calls[] = { 1000U, 1U, 15U, 16U, 17U, 333U, 618U };
+  FIR_HandleTypeDef fir;
+  double worst = 0.0;
+  uint32_t c;
+  uint32_t i;
+
+  for (i = 0U; i < CHECK_TAPS; i++)
+  {
+    Coeffs[0][i] = (float)(rand() % 2001 - 1000) / 4000.0f;
+    Coeffs[1][i] = (float)(rand() % 2001 - 1000) / 4000.0f;
+  }
+  for (i = 0U; i < CHECK_FRAMES; i++)
+  {
+    In[i] = (float)(rand() % 2001 - 1000) / 1000.0f;
+  }
+
+  /* Whole blocks and uneven calls, in place: every call restarts the signal */
+  for (c = 0U; c < sizeof(calls) / sizeof(calls[0]); c++)
+  {
+    uint32_t done = 0U;
+
+    FIR_Init(&fir, Coeffs[0], State, CHECK_TAPS, CHECK_SLICE);
+    memcpy(Out, In, sizeof(Out));
+    while (done < CHECK_FRAMES)
+    {
+      uint32_t n = AUDIO_MIN(calls[c], CHECK_FRAMES - done);
+
+      FIR_Process(&fir, &Out[done], &Out[done], n);
+      done += n;
+    }
+    for (i = 0U; i < CHECK_FRAMES; i++)
+    {
+      worst = AUDIO_MAX(worst, fabs(Out[i] - CHECK_Convolve(Coeffs[0], i)));
+    }
+  }
+
+  /* Accumulated crossfade from response 0 to 1 over the whole block */
+  FIR_Init(&fir, Coeffs[1], State, CHECK_TAPS, CHECK_SLICE);
+  for (i = 0U; i < CHECK_FRAMES; i++)
+  {
+    Out[i] = 1.0f;
+  }
+  FIR_CrossfadeAccumulate(&fir, Coeffs[0], In, Out, CHECK_FRAMES);
+  for (i = 0U; i < CHECK_FRAMES; i++)
+  {
+    double w = ((double)i + 0.5) / (double)CHECK_FRAMES;
+    double want = 1.0 + (1.0 - w) * CHECK_Convolve(Coeffs[0], i) + w * CHECK_Convolve(Coeffs[1], i);
+
+    worst = AUDIO_MAX(worst, fabs(Out[i] - want));
+  }
+  return worst;
+}
+
+/* Neighbours put their single tap far apart so a hard switch steps */
+static void CHECK_MakeSet(SPATIAL_HrtfSetTypeDef *pSet)
+{
+  uint32_t i;
+
+  memset(Filters, 0, sizeof(Filters));
+  for (i = 0U; i < CHECK_AZIMUTHS; i++)
+  {
+    Filters[i * 2U][(i % 2U) * 15U]            = 0.9f - 0.05f * (float)i;
+    Filters[i * 2U + 1U][((i + 1U) % 2U) * 15U] = 0.4f + 0.05f * (float)i;
+    Itd[i] = 20.0f * sinf(2.0f * (float)M_PI * (float)i / (float)CHECK_AZIMUTHS);
+  }
+  pSet->pFilters      = &Filters[0][0];
+  pSet->pItd          = Itd;
+  pSet->NumAzimuth    = CHECK_AZIMUTHS;
+  pSet->NumElevation  = 1U;
+  pSet->NumTaps       = SPATIAL_MAX_TAPS;
+  pSet->ElevationMin  = 0.0f;
+  pSet->ElevationStep = 0.0f;
+}
+
+/* Largest sample to sample change per ear over the ear's peak, the source
+   turning Step degrees per block */
+static void CHECK_Render(const SPATIAL_HrtfSetTypeDef *pSet, double Hz, float Step, double *pWorst)
+{
+  double peak[2] = { 0.0, 0.0 };
+  const float *inputs[SPATIAL_MAX_SOURCES] = { NULL };
+  float mono[AUDIO_BLOCK_SIZE];
+  float left[AUDIO_BLOCK_SIZE];
+  float right[AUDIO_BLOCK_SIZE];
+  float last[2] = { 0.0f, 0.0f };
+  uint32_t blocks = CHECK_SECONDS * AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SIZE;
+  uint32_t b;
+  uint32_t i;
+
+  (void)SPATIAL_Init(&Spatial, pSet);
+  SPATIAL_SetSource(&Spatial, 0U, 0.0f, 0.0f, 1.0f);
+  SPATIAL_EnableSource(&Spatial, 0U, 1U);
+  inputs[0] = mono;
+  pWorst[0] = 0.0;
+  pWorst[1] = 0.0;
+
+  for (b = 0U; b < blocks; b++)
+  {
+    if (b != 0U)
+    {
+      SPATIAL_SetSource(&Spatial, 0U, Step * (float)b, 0.0f, 1.0f);
+    }
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      mono[i] = 0.5f * (float)sin(2.0 * M_PI * Hz * (double)(b * AUDIO_BLOCK_SIZE + i) /
+                                  (double)AUDIO_SAMPLE_RATE);
+    }
+    SPATIAL_Process(&Spatial, inputs, left, right, AUDIO_BLOCK_SIZE);
+
+    /* Skip the onset through the HRIR and ITD */
+    for (i = 0U; i < AUDIO_BLOCK_SIZE; i++)
+    {
+      if (b >= 2U)
+      {
+        pWorst[0] = AUDIO_MAX(pWorst[0], fabs(left[i] - last[0]));
+        pWorst[1] = AUDIO_MAX(pWorst[1], fabs(right[i] - last[1]));
+        peak[0]   = AUDIO_MAX(peak[0], fabs(left[i]));
+        peak[1]   = AUDIO_MAX(peak[1], fabs(right[i]));
+      }
+      last[0] = left[i];
+      last[1] = right[i];
+    }
+  }
+  pWorst[0] /= peak[0];
+  pWorst[1] /= peak[1];
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  SPATIAL_HrtfSetTypeDef set;
+  double hz = 200.0;
+  double step = 37.0;
+  double limit = 2.0;
+  double steady;
+  double moving[2];
+  double fir;
+  int failed = 0;
+  int opt;
+  uint32_t ear;
+
+  while ((opt = getopt(argc, argv, "f:r:l:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'f': hz = atof(optarg); break;
+      case 'r': step = atof(optarg); break;
+      case 'l': limit = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: spatial_check [-f Hz] [-r degrees] [-l ratio]\n");
+        return 2;
+    }
+  }
+  if ((hz <= 0.0) || (hz >= 0.5 * AUDIO_SAMPLE_RATE))
+  {
+    fprintf(stderr, "spatial_check: bad sine frequency\n");
+    return 2;
+  }
+
+  srand(1U);
+  fir = CHECK_Fir();
+  printf("fir: worst error %.2e over split and crossfaded blocks, limit %.0e\n", fir,
+         CHECK_TOLERANCE);
+  failed |= (fir > CHECK_TOLERANCE);
+
+  CHECK_MakeSet(&set);
+  CHECK_Render(&set, hz, (float)step, moving);
+  steady = 2.0 * sin(M_PI * hz / (double)AUDIO_SAMPLE_RATE);
+  for (ear = 0U; ear < 2U; ear++)
+  {
+    printf("%s ear: largest step %.4f of the peak, steady sine %.4f, ratio %.2f, limit %.2f\n",
+           (ear == 0U) ? "left" : "right", moving[ear], steady, moving[ear] / steady, limit);
+    failed |= (moving[ear] > limit * steady);
+  }
+  return failed;
+}
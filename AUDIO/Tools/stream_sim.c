@@ -0,0 +1,548 @@
+/**
+  ******************************************************************************
+  * @file    stream_sim.c
+  * @brief   Host simulation of SD sample streaming with audio_stream.c.
+  *
+  *          A synthetic card holds the samples, laid out cluster by cluster
+  *          with some fragmentation, with a library index built to match.
+  *          The card answers each read after a latency drawn from a model
+  *          of a real card: a log-normal access time, occasional pauses of
+  *          a busy card, and the transfer time of the sectors. Voices play
+  *          random samples at random rates as notes come in; every voice is
+  *          rendered on its own and checked sample for sample against the
+  *          source, and the frames it held for want of data are counted.
+  *          The audio interrupt also lands inside the critical sections of
+  *          the voices (-x): it retriggers the voice whose ring level was
+  *          just stored, as a trigger arriving between the check and the
+  *          store would, and is delivered when the section ends.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -DAUDIO_HOST_IRQ -I../Core/Inc -o stream_sim stream_sim.c \
+  *                ../Core/Src/audio_stream.c ../Core/Src/audio_voice.c \
+  *                ../Core/Src/audio_library.c -lm
+  *
+  *          Usage:
+  *            stream_sim [-t seconds] [-v voices] [-S samples] [-H head ms]
+  *                       [-n mean note ms] [-c slice probability]
+  *                       [-l median latency ms] [-j latency spread]
+  *                       [-p pause probability] [-s longest pause ms]
+  *                       [-b MB/s] [-f fragmentation] [-x retrigger probability]
+  *                       [-w limit ms] [-u limit %] [-r seed]
+  *
+  *          The card defaults to an A1-class card: 0.35 ms median access,
+  *          and one read in 500 caught in a pause of up to 25 ms. Slices
+  *          (-c) start mid-sample, past the head, and wait for the card by
+  *          construction. The report ends with the worst starvation of a
+  *          voice, from its first frame held to the frame it resumed. The
+  *          prefetch ring is the defence against pauses: build with
+  *          -DVOICE_PREFETCH_LEN=2048U or 8192U to see what it buys.
+  *          The exit status is 1 if a voice ever played a wrong sample,
+  *          starved longer than -w (20 ms) or for more than -u (0.03%) of
+  *          voice time. The default ring stays within both on any seed;
+  *          a 2048 ring starves three times that share.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_stream.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_DATA_LBA              8192U
+#define SIM_CLUSTER_SECTORS       64U       /* 32 KB, as SDHC cards come     */
+#define SIM_WAV_HEADER            44U
+#define SIM_DT                    50e-6     /* Background loop period        */
+#define SIM_COMMAND               100e-6    /* CMD18 + CMD12 round trip      */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  STREAM_SampleTypeDef Stream;
+  int16_t *pHead;
+  uint32_t Id;
+} SIM_SampleTypeDef;
+
+typedef struct
+{
+  SIM_SampleTypeDef *pSample;
+  double   NextNote;
+  uint32_t Starving;          /* Frames held in the current starvation       */
+} SIM_VoiceTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t *Card;
+static uint32_t CardSectors;
+static uint32_t *Index;
+static LIBRARY_HandleTypeDef Library;
+static SIM_SampleTypeDef Samples[STREAM_MAX_SAMPLES];
+static uint32_t NumSamples = 48U;
+static VOICE_HandleTypeDef Voices[STREAM_MAX_VOICES];
+static SIM_VoiceTypeDef VoiceState[STREAM_MAX_VOICES];
+static uint32_t NumVoices = 16U;
+static STREAM_HandleTypeDef Stream;
+
+/* Card model */
+static double Now;
+static double MedianSec = 0.35e-3;
+static double Spread = 0.5;
+static double PauseProb = 0.002;
+static double PauseSec = 25e-3;
+static double BytesPerSec = 10e6;
+static double CompleteAt = -1.0;
+static double BusySec;
+static double *Latencies;
+static uint32_t NumLatencies;
+static uint32_t MaxLatencies;
+
+/* Audio interrupt injected into the critical sections */
+static double RetriggerProb = 0.01;
+static uint32_t Retriggers;
+static uint8_t Armed;
+static uint32_t Levels[STREAM_MAX_VOICES];
+static double SliceProb;
+
+/* Private functions ---------------------------------------------------------*/
+static double SIM_Uniform(void)
+{
+  return ((double)rand() + 0.5) / ((double)RAND_MAX + 1.0);
+}
+
+static double SIM_Gauss(void)
+{
+  return sqrt(-2.0 * log(SIM_Uniform())) * cos(6.283185307179586 * SIM_Uniform());
+}
+
+/* Sample value i of sample Id, as written on the card */
+static int16_t SIM_Value(uint32_t Id, uint32_t Index)
+{
+  uint32_t x = (Id * 2654435761U) ^ (Index * 40503U);
+
+  x ^= x >> 15;
+  x *= 2246822519U;
+  return (int16_t)(x >> 16);
+}
+
+static int SIM_CompareDouble(const void *pA, const void *pB)
+{
+  double a = *(const double *)pA;
+  double b = *(const double *)pB;
+
+  return (a > b) - (a < b);
+}
+
+static uint32_t SIM_Crc32(const uint8_t *pData, uint32_t Size)
+{
+  uint32_t crc = 0xFFFFFFFFU;
+  uint32_t i;
+  uint32_t k;
+
+  for (i = 0U; i < Size; i++)
+  {
+    crc ^= pData[i];
+    for (k = 0U; k < 8U; k++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+  }
+  return ~crc;
+}
+
+/* Writes the samples as WAV files over clusters and builds their index */
+static uint32_t SIM_MakeCard(double Fragmentation)
+{
+  uint32_t clusterBytes = SIM_CLUSTER_SECTORS * LIBRARY_SECTOR_SIZE;
+  uint32_t frames[STREAM_MAX_SAMPLES];
+  uint32_t clusters = 0U;
+  uint32_t cluster = 2U;
+  uint32_t numRuns = 0U;
+  LIBRARY_HeaderTypeDef *hdr;
+  LIBRARY_RunTypeDef *runs;
+  LIBRARY_EntryTypeDef *entries;
+  uint32_t size;
+  uint32_t s;
+
+  for (s = 0U; s < NumSamples; s++)
+  {
+    frames[s] = (uint32_t)((0.5 + 5.5 * SIM_Uniform()) * AUDIO_SAMPLE_RATE);
+    clusters += ((SIM_WAV_HEADER + (frames[s] * 2U)) / clusterBytes) + 1U;
+  }
+  /* Room for the gaps fragmentation leaves */
+  CardSectors = SIM_DATA_LBA + (clusters * 4U * SIM_CLUSTER_SECTORS);
+  Card = calloc(CardSectors, LIBRARY_SECTOR_SIZE);
+  size = sizeof(LIBRARY_HeaderTypeDef) + (clusters * sizeof(LIBRARY_RunTypeDef))
+         + (NumSamples * sizeof(LIBRARY_EntryTypeDef));
+  Index = calloc(size / 4U, 4U);
+  if ((Card == NULL) || (Index == NULL))
+  {
+    return 0U;
+  }
+  hdr = (LIBRARY_HeaderTypeDef *)Index;
+  runs = (LIBRARY_RunTypeDef *)&hdr[1];
+
+  for (s = 0U; s < NumSamples; s++)
+  {
+    uint32_t bytes = SIM_WAV_HEADER + (frames[s] * 2U);
+    uint32_t firstRun = numRuns;
+    uint32_t b;
+
+    Samples[s].Id = 100U + s;
+    for (b = 0U; b < bytes; b += clusterBytes)
+    {
+      uint8_t *dst;
+      uint32_t i;
+
+      if ((b > 0U) && (SIM_Uniform() < Fragmentation))
+      {
+        cluster += 1U + (uint32_t)(SIM_Uniform() * 8.0);
+      }
+      if ((numRuns > firstRun) && (cluster == (runs[numRuns - 1U].Cluster + runs[numRuns - 1U].Count)))
+      {
+        runs[numRuns - 1U].Count++;
+      }
+      else
+      {
+        runs[numRuns].Cluster = cluster;
+        runs[numRuns].Count = 1U;
+        numRuns++;
+      }
+      dst = &Card[(SIM_DATA_LBA + ((cluster - 2U) * SIM_CLUSTER_SECTORS)) * (size_t)LIBRARY_SECTOR_SIZE];
+      for (i = 0U; (i < clusterBytes) && ((b + i) < bytes); i += 2U)
+      {
+        uint32_t at = b + i;
+
+        if (at < SIM_WAV_HEADER)
+        {
+          dst[i] = (uint8_t)"RIFF....WAVEfmt "[at % 16U];
+          dst[i + 1U] = (uint8_t)"RIFF....WAVEfmt "[(at + 1U) % 16U];
+        }
+        else
+        {
+          int16_t v = SIM_Value(Samples[s].Id, (at - SIM_WAV_HEADER) / 2U);
+
+          memcpy(&dst[i], &v, sizeof(v));
+        }
+      }
+      cluster++;
+    }
+    entries = (LIBRARY_EntryTypeDef *)&runs[clusters];
+    entries[s].Id = Samples[s].Id;
+    entries[s].FirstRun = firstRun;
+    entries[s].NumRuns = (uint16_t)(numRuns - firstRun);
+    entries[s].DataOffset = SIM_WAV_HEADER;
+    entries[s].Frames = frames[s];
+    entries[s].LoopStart = LIBRARY_NO_LOOP;
+    entries[s].Channels = 1U;
+    entries[s].Format = LIBRARY_FORMAT_PCM16;
+    entries[s].Rate = AUDIO_SAMPLE_RATE;
+  }
+
+  /* Entries right after the runs actually used */
+  memmove(&runs[numRuns], &runs[clusters], NumSamples * sizeof(LIBRARY_EntryTypeDef));
+  size = sizeof(*hdr) + (numRuns * sizeof(LIBRARY_RunTypeDef)) + (NumSamples * sizeof(LIBRARY_EntryTypeDef));
+  hdr->Magic = LIBRARY_MAGIC;
+  hdr->Version = LIBRARY_VERSION;
+  hdr->EntrySize = sizeof(LIBRARY_EntryTypeDef);
+  hdr->NumEntries = NumSamples;
+  hdr->NumRuns = numRuns;
+  hdr->VolumeId = 0x5EED5EEDU;
+  hdr->DataLba = SIM_DATA_LBA;
+  hdr->ClusterSectors = SIM_CLUSTER_SECTORS;
+  hdr->Crc = SIM_Crc32((const uint8_t *)&hdr[1], size - sizeof(*hdr));
+  return size;
+}
+
+static AUDIO_StatusTypeDef SIM_Read(void *Context, uint32_t Lba, uint32_t Count, uint8_t *pDst,
+                                    uint32_t SlackUs)
+{
+  double latency = MedianSec * exp(Spread * SIM_Gauss());
+
+  (void)Context;
+  (void)SlackUs;
+  if (((Lba + Count) > CardSectors) || (CompleteAt >= 0.0))
+  {
+    return AUDIO_ERROR;
+  }
+  if (SIM_Uniform() < PauseProb)
+  {
+    latency += PauseSec * (0.25 + 0.75 * SIM_Uniform());
+  }
+  latency += SIM_COMMAND + (Count * LIBRARY_SECTOR_SIZE) / BytesPerSec;
+  memcpy(pDst, &Card[(size_t)Lba * LIBRARY_SECTOR_SIZE], (size_t)Count * LIBRARY_SECTOR_SIZE);
+  CompleteAt = Now + latency;
+  BusySec += latency;
+  if (NumLatencies == MaxLatencies)
+  {
+    MaxLatencies = (MaxLatencies * 2U) + 1024U;
+    Latencies = realloc(Latencies, MaxLatencies * sizeof(double));
+  }
+  Latencies[NumLatencies++] = latency;
+  return AUDIO_OK;
+}
+
+/* A new note on voice v, from the audio interrupt; returns 1 for a slice */
+static uint32_t SIM_Note(uint32_t v)
+{
+  static const double rates[] = { 1.0, 1.0, 1.0, 0.5, 1.5, 2.0 };
+  SIM_VoiceTypeDef *state = &VoiceState[v];
+  VOICE_ParamsTypeDef params;
+  double pick = SIM_Uniform() * SIM_Uniform();
+  uint32_t slice = 0U;
+
+  /* Popular samples come back often, on several voices at once */
+  state->pSample = &Samples[(uint32_t)(pick * NumSamples)];
+  memset(&params, 0, sizeof(params));
+  params.Level = 2.0f;
+  params.Rate = (float)rates[rand() % (int)(sizeof(rates) / sizeof(rates[0]))];
+  params.Decay = 1.0f;
+  if (SIM_Uniform() < SliceProb)
+  {
+    params.Start = (uint32_t)(SIM_Uniform() * state->pSample->Stream.Source.Length);
+    slice = 1U;
+  }
+  VOICE_Trigger(&Voices[v], &state->pSample->Stream.Source, &params);
+  return slice;
+}
+
+/* The audio interrupt arrives inside the section when armed; masked, it is
+   taken at the exit, and retriggers the voice whose level was stored */
+uint32_t AUDIO_EnterCritical(void)
+{
+  uint32_t v;
+
+  Armed = (SIM_Uniform() < RetriggerProb) ? 1U : 0U;
+  for (v = 0U; (Armed != 0U) && (v < NumVoices); v++)
+  {
+    Levels[v] = Voices[v].Fetched;
+  }
+  return 0U;
+}
+
+void AUDIO_ExitCritical(uint32_t State)
+{
+  uint32_t v;
+
+  (void)State;
+  for (v = 0U; (Armed != 0U) && (v < NumVoices); v++)
+  {
+    if ((Voices[v].Source != NULL) && (Voices[v].Fetched != Levels[v]))
+    {
+      (void)SIM_Note(v);
+      Retriggers++;
+    }
+  }
+  Armed = 0U;
+}
+
+/* The background loop for Seconds of simulated time */
+static void SIM_Background(double Seconds)
+{
+  double end = Now + Seconds;
+
+  while (Now < end)
+  {
+    Now += SIM_DT;
+    if ((CompleteAt >= 0.0) && (Now >= CompleteAt))
+    {
+      CompleteAt = -1.0;
+      STREAM_ReadComplete(&Stream, AUDIO_OK);
+    }
+    STREAM_Poll(&Stream);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  static float left[AUDIO_BLOCK_SIZE];
+  static float right[AUDIO_BLOCK_SIZE];
+  double seconds = 60.0;
+  double headMs = 30.0;
+  double noteMs = 300.0;
+  double fragmentation = 0.1;
+  double limitMs = 20.0;
+  double limitShare = 0.03;
+  double preloadSec;
+  double start;
+  uint32_t headBytes = 0U;
+  uint32_t notes = 0U;
+  uint32_t slices = 0U;
+  uint32_t mismatches = 0U;
+  uint32_t episodes = 0U;
+  uint32_t worst = 0U;
+  uint64_t starved = 0U;
+  uint64_t playing = 0U;
+  uint32_t indexSize;
+  uint32_t s;
+  uint32_t v;
+  int opt;
+
+  srand(1U);
+  while ((opt = getopt(argc, argv, "t:v:S:H:n:c:l:j:p:s:b:f:x:w:u:r:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': seconds = atof(optarg); break;
+      case 'v': NumVoices = (uint32_t)AUDIO_CLAMP(atoi(optarg), 1, (int)STREAM_MAX_VOICES); break;
+      case 'S': NumSamples = (uint32_t)AUDIO_CLAMP(atoi(optarg), 1, (int)STREAM_MAX_SAMPLES); break;
+      case 'H': headMs = atof(optarg); break;
+      case 'n': noteMs = atof(optarg); break;
+      case 'c': SliceProb = atof(optarg); break;
+      case 'l': MedianSec = atof(optarg) * 1e-3; break;
+      case 'j': Spread = atof(optarg); break;
+      case 'p': PauseProb = atof(optarg); break;
+      case 's': PauseSec = atof(optarg) * 1e-3; break;
+      case 'b': BytesPerSec = atof(optarg) * 1e6; break;
+      case 'f': fragmentation = atof(optarg); break;
+      case 'x': RetriggerProb = atof(optarg); break;
+      case 'w': limitMs = atof(optarg); break;
+      case 'u': limitShare = atof(optarg); break;
+      case 'r': srand((unsigned)atoi(optarg)); break;
+      default: return 2;
+    }
+  }
+
+  indexSize = SIM_MakeCard(fragmentation);
+  if ((indexSize == 0U) || (LIBRARY_Load(&Library, Index, indexSize) != AUDIO_OK))
+  {
+    fprintf(stderr, "card setup failed\n");
+    return 2;
+  }
+  {
+    STREAM_ConfigTypeDef cfg = { SIM_Read, NULL, NULL };
+
+    if (STREAM_Init(&Stream, &cfg, &Library, Voices, NumVoices) != AUDIO_OK)
+    {
+      return 2;
+    }
+  }
+  for (s = 0U; s < NumSamples; s++)
+  {
+    uint32_t head = (uint32_t)(headMs * 1e-3 * AUDIO_SAMPLE_RATE);
+
+    Samples[s].pHead = (head > 0U) ? malloc(head * sizeof(int16_t)) : NULL;
+    if (STREAM_AddSample(&Stream, &Samples[s].Stream, Samples[s].Id, Samples[s].pHead, head) != AUDIO_OK)
+    {
+      fprintf(stderr, "sample %u does not open\n", Samples[s].Id);
+      return 2;
+    }
+    headBytes += Samples[s].Stream.HeadLength * (uint32_t)sizeof(int16_t);
+  }
+  for (v = 0U; v < NumVoices; v++)
+  {
+    VOICE_Init(&Voices[v]);
+    VoiceState[v].NextNote = -noteMs * 1e-3 * log(SIM_Uniform());
+  }
+
+  while (STREAM_IsPreloaded(&Stream) == 0U)
+  {
+    SIM_Background(1e-3);
+  }
+  preloadSec = Now;
+  printf("card: %u samples, %.1f MB, %u runs; heads %.0f ms, %u KB of RAM, preloaded in %.0f ms\n",
+         NumSamples, (double)(CardSectors - SIM_DATA_LBA) * LIBRARY_SECTOR_SIZE / 4e6,
+         Library.pHeader->NumRuns, headMs, headBytes / 1024U, preloadSec * 1e3);
+
+  start = Now;
+  while ((Now - start) < seconds)
+  {
+    double t = Now - start;
+
+    /* Audio interrupt: notes, then each voice rendered and checked alone */
+    for (v = 0U; v < NumVoices; v++)
+    {
+      VOICE_HandleTypeDef *hvoice = &Voices[v];
+      SIM_VoiceTypeDef *state = &VoiceState[v];
+      uint64_t phase;
+      uint32_t underruns;
+      uint32_t rendered;
+      uint32_t i;
+
+      if (t >= state->NextNote)
+      {
+        slices += SIM_Note(v);
+        state->NextNote = t - noteMs * 1e-3 * log(SIM_Uniform());
+        notes++;
+      }
+      if (VOICE_IsActive(hvoice) == 0U)
+      {
+        continue;
+      }
+
+      memset(left, 0, sizeof(left));
+      memset(right, 0, sizeof(right));
+      phase = hvoice->Phase;
+      underruns = hvoice->Underruns;
+      VOICE_Render(hvoice, left, right, AUDIO_BLOCK_SIZE);
+      rendered = (uint32_t)((hvoice->Phase - phase) / hvoice->Increment);
+      for (i = 0U; i < rendered; i++)
+      {
+        uint32_t idx = (uint32_t)(phase >> 32);
+        float frac = (float)(uint32_t)phase * (1.0f / 4294967296.0f);
+        uint32_t length = state->pSample->Stream.Source.Length;
+        float s0 = (float)SIM_Value(state->pSample->Id, idx);
+        float s1 = ((idx + 1U) < length) ? (float)SIM_Value(state->pSample->Id, idx + 1U) : 0.0f;
+        float expect = (s0 + (s1 - s0) * frac) * (1.0f / 32768.0f);
+
+        if (fabsf(left[i] - expect) > 1e-6f)
+        {
+          mismatches++;
+        }
+        phase += hvoice->Increment;
+      }
+      playing += AUDIO_BLOCK_SIZE;
+
+      /* A starvation lasts from the first frame held to the resume */
+      if (hvoice->Underruns != underruns)
+      {
+        state->Starving += hvoice->Underruns - underruns;
+        starved += hvoice->Underruns - underruns;
+      }
+      else if (state->Starving > 0U)
+      {
+        episodes++;
+        worst = AUDIO_MAX(worst, state->Starving);
+        state->Starving = 0U;
+      }
+    }
+
+    SIM_Background((double)AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE);
+  }
+  for (v = 0U; v < NumVoices; v++)
+  {
+    if (VoiceState[v].Starving > 0U)
+    {
+      episodes++;
+      worst = AUDIO_MAX(worst, VoiceState[v].Starving);
+    }
+  }
+
+  qsort(Latencies, NumLatencies, sizeof(double), SIM_CompareDouble);
+  printf("%u voices, %.0f s: %u notes (%u slices, %u retriggers in a refill), voices sounding %.1f%% of the time\n",
+         NumVoices, seconds, notes, slices, Retriggers,
+         100.0 * (double)playing / ((double)NumVoices * seconds * AUDIO_SAMPLE_RATE));
+  printf("reads: %u, %.1f sectors each, %u voices served by another's read; card busy %.0f%%\n",
+         Stream.Requests, (double)Stream.SectorsRead / Stream.Requests, Stream.Merged,
+         100.0 * BusySec / Now);
+  printf("latency: median %.2f ms, 99%% %.2f ms, 99.9%% %.2f ms, max %.2f ms\n",
+         Latencies[NumLatencies / 2U] * 1e3, Latencies[(NumLatencies * 99U) / 100U] * 1e3,
+         Latencies[(NumLatencies * 999U) / 1000U] * 1e3, Latencies[NumLatencies - 1U] * 1e3);
+  printf("least slack at issue: %.2f ms\n", Stream.MinSlack * 1e3 / AUDIO_SAMPLE_RATE);
+  printf("starvation: %u episodes, %.4f%% of voice time, worst %.2f ms\n", episodes,
+         100.0 * (double)starved / (double)AUDIO_MAX(playing, 1U), worst * 1e3 / AUDIO_SAMPLE_RATE);
+  if (mismatches != 0U)
+  {
+    printf("%u frames played wrong samples\n", mismatches);
+  }
+  return ((mismatches != 0U) || ((worst * 1e3 / AUDIO_SAMPLE_RATE) > limitMs) ||
+          ((100.0 * (double)starved / (double)AUDIO_MAX(playing, 1U)) > limitShare)) ? 1 : 0;
+}
@@ -0,0 +1,298 @@
+/**
+  ******************************************************************************
+  * @file    sync_sim.c
+  * @brief   Host simulation of a chain of boards running audio_sync.c.
+  *
+  *          Board 0 is the master, board n syncs to board n - 1. Every board
+  *          has its own crystal error, which scales both its capture timer
+  *          and its audio clock, and the audio clock follows the trim the
+  *          servo asks for. Messages cross each link with a fixed delay,
+  *          timestamp jitter and occasional queuing delays. Each second the
+  *          simulation prints the worst timeline error of every board to
+  *          board 0 over that second, in frames, and the trim in ppm.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o sync_sim sync_sim.c \
+  *                ../Core/Src/audio_sync.c -lm
+  *
+  *          Usage:
+  *            sync_sim [-n boards] [-t seconds] [-i interval ms] [-j jitter ns]
+  *                     [-q queuing probability] [-p crystal ppm] [-l limit]
+  *                     [-s settle seconds] [-r seed]
+  *
+  *          The exit status is 1 if any board is further than the limit
+  *          (2 frames by default) from board 0 after the settle time.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_sync.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_MAX_BOARDS            16U
+#define SIM_MAX_FLIGHT            256U
+#define SIM_TICK_RATE             100000000.0
+#define SIM_DT                    (1.0 / 16000.0)
+#define SIM_WIRE_DELAY            20e-6     /* 16-byte frame at a few Mbit/s   */
+#define SIM_TURNAROUND            50e-6     /* Receive to reply, firmware      */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  SYNC_HandleTypeDef Sync;
+  double   CrystalPpm;
+  double   TrimPpm;
+  double   Ticks;             /* Capture timer, continuous                   */
+  double   Frames;            /* Audio frames, continuous                    */
+  double   NextSync;          /* Master side: next exchange, true time       */
+  uint8_t  Seq;
+  double   WorstError;
+} SIM_BoardTypeDef;
+
+/* A message on a link: sent at Send, captured at both ends */
+typedef struct
+{
+  double   Send;
+  double   Arrive;
+  uint32_t From;
+  uint32_t To;
+  uint8_t  TxReported;
+  SYNC_MessageTypeDef Msg;
+} SIM_FlightTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static SIM_BoardTypeDef Boards[SIM_MAX_BOARDS];
+static SIM_FlightTypeDef Flight[SIM_MAX_FLIGHT];
+static uint32_t NumBoards = 4U;
+static double JitterSec = 100e-9;
+static double QueueProb = 0.1;
+
+/* Private functions ---------------------------------------------------------*/
+static double SIM_Uniform(void)
+{
+  return ((double)rand() + 0.5) / ((double)RAND_MAX + 1.0);
+}
+
+static double SIM_Gauss(void)
+{
+  return sqrt(-2.0 * log(SIM_Uniform())) * cos(6.283185307179586 * SIM_Uniform());
+}
+
+static void SIM_SetTrim(void *Context, float Ppm)
+{
+  ((SIM_BoardTypeDef *)Context)->TrimPpm = Ppm;
+}
+
+/* Timer value a board captures at an instant that lies Ago seconds back */
+static uint32_t SIM_Capture(const SIM_BoardTypeDef *pBoard, double Ago)
+{
+  double ticks = pBoard->Ticks - (Ago - (JitterSec * SIM_Gauss())) * SIM_TICK_RATE
+                                 * (1.0 + pBoard->CrystalPpm * 1e-6);
+
+  return (uint32_t)(uint64_t)llround(ticks);
+}
+
+static void SIM_Send(double Now, uint32_t From, uint32_t To, const SYNC_MessageTypeDef *pMsg)
+{
+  uint32_t i;
+
+  for (i = 0U; i < SIM_MAX_FLIGHT; i++)
+  {
+    if (Flight[i].Send == 0.0)
+    {
+      Flight[i].Send = Now + SIM_TURNAROUND;
+      Flight[i].Arrive = Flight[i].Send + SIM_WIRE_DELAY;
+      if (SIM_Uniform() < QueueProb)
+      {
+        /* Bus busy, retries: only ever later */
+        Flight[i].Arrive += -300e-6 * log(SIM_Uniform());
+      }
+      Flight[i].From = From;
+      Flight[i].To = To;
+      Flight[i].TxReported = 0U;
+      Flight[i].Msg = *pMsg;
+      return;
+    }
+  }
+}
+
+/* Delivers transmit captures and arrivals due by Now */
+static void SIM_Deliver(double Now)
+{
+  SYNC_MessageTypeDef next;
+  uint32_t i;
+
+  for (i = 0U; i < SIM_MAX_FLIGHT; i++)
+  {
+    SIM_FlightTypeDef *f = &Flight[i];
+
+    if (f->Send == 0.0)
+    {
+      continue;
+    }
+    if ((f->TxReported == 0U) && (f->Send <= Now))
+    {
+      f->TxReported = 1U;
+      if (SYNC_Transmitted(&Boards[f->From].Sync, &f->Msg, SIM_Capture(&Boards[f->From], Now - f->Send),
+                           &next) != 0U)
+      {
+        SIM_Send(Now, f->From, f->To, &next);
+      }
+    }
+    if ((f->TxReported != 0U) && (f->Arrive <= Now))
+    {
+      f->Send = 0.0;
+      if (SYNC_Received(&Boards[f->To].Sync, &f->Msg, SIM_Capture(&Boards[f->To], Now - f->Arrive),
+                        &next) != 0U)
+      {
+        SIM_Send(Now, f->To, f->From, &next);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  double seconds = 60.0;
+  double interval = 0.125;
+  double crystal = 50.0;
+  double limit = 2.0;
+  double settle = 20.0;
+  double now = 0.0;
+  double worstSettled = 0.0;
+  uint32_t second = 0U;
+  uint32_t b;
+  int opt;
+
+  srand(1U);
+  while ((opt = getopt(argc, argv, "n:t:i:j:q:p:l:s:r:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': NumBoards = (uint32_t)AUDIO_CLAMP(atoi(optarg), 2, (int)SIM_MAX_BOARDS); break;
+      case 't': seconds = atof(optarg); break;
+      case 'i': interval = atof(optarg) * 1e-3; break;
+      case 'j': JitterSec = atof(optarg) * 1e-9; break;
+      case 'q': QueueProb = atof(optarg); break;
+      case 'p': crystal = atof(optarg); break;
+      case 'l': limit = atof(optarg); break;
+      case 's': settle = atof(optarg); break;
+      case 'r': srand((unsigned)atoi(optarg)); break;
+      default: return 2;
+    }
+  }
+
+  for (b = 0U; b < NumBoards; b++)
+  {
+    SIM_BoardTypeDef *board = &Boards[b];
+    SYNC_ConfigTypeDef cfg;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.Node = (uint16_t)b;
+    cfg.Master = (uint16_t)((b == 0U) ? 0U : b - 1U);
+    cfg.TickRate = (uint32_t)SIM_TICK_RATE;
+    cfg.IntervalSec = (float)interval;
+    cfg.SetTrim = SIM_SetTrim;
+    cfg.Context = board;
+    (void)SYNC_Init(&board->Sync, &cfg);
+    board->CrystalPpm = crystal * (2.0 * SIM_Uniform() - 1.0);
+    /* Boards power up at different times */
+    board->Frames = floor(SIM_Uniform() * 1e7);
+    board->Ticks = SIM_Uniform() * 4e9;
+    board->NextSync = interval * SIM_Uniform();
+  }
+
+  printf("crystals (ppm):");
+  for (b = 0U; b < NumBoards; b++)
+  {
+    printf(" %+.1f", Boards[b].CrystalPpm);
+  }
+  printf("\n%6s", "second");
+  for (b = 1U; b < NumBoards; b++)
+  {
+    printf("  err%-2u frames  trim ppm", b);
+  }
+  printf("\n");
+
+  while (now < seconds)
+  {
+    now += SIM_DT;
+    for (b = 0U; b < NumBoards; b++)
+    {
+      SIM_BoardTypeDef *board = &Boards[b];
+      double rate = 1.0 + board->CrystalPpm * 1e-6;
+      double frames = board->Frames + SIM_DT * (double)AUDIO_SAMPLE_RATE * rate * (1.0 + board->TrimPpm * 1e-6);
+      double block = floor(frames / AUDIO_BLOCK_SIZE) * AUDIO_BLOCK_SIZE;
+
+      board->Ticks += SIM_DT * SIM_TICK_RATE * rate;
+      if (block > board->Frames)
+      {
+        /* The audio interrupt of the block that just ended */
+        double ago = (frames - block) / (frames - board->Frames) * SIM_DT;
+
+        SYNC_AudioStamp(&board->Sync, SIM_Capture(board, ago), (uint32_t)(uint64_t)block);
+      }
+      board->Frames = frames;
+
+      if ((b + 1U < NumBoards) && (now >= board->NextSync))
+      {
+        SYNC_MessageTypeDef msg;
+
+        board->NextSync += interval;
+        SYNC_Begin(&board->Sync, board->Seq++, &msg);
+        SIM_Send(now - SIM_TURNAROUND, b, b + 1U, &msg);
+      }
+    }
+    SIM_Deliver(now);
+
+    /* Timeline error to board 0, taken at the same instant */
+    {
+      double ref = (double)SYNC_Timeline(&Boards[0].Sync, SIM_Capture(&Boards[0], 0.0)) / 4294967296.0;
+
+      for (b = 1U; b < NumBoards; b++)
+      {
+        double t = (double)SYNC_Timeline(&Boards[b].Sync, SIM_Capture(&Boards[b], 0.0)) / 4294967296.0;
+        double err = t - ref;
+
+        err -= 4294967296.0 * floor((err / 4294967296.0) + 0.5);
+        Boards[b].WorstError = fmax(Boards[b].WorstError, fabs(err));
+      }
+    }
+
+    if (now >= (double)(second + 1U))
+    {
+      second++;
+      printf("%6u", second);
+      for (b = 1U; b < NumBoards; b++)
+      {
+        printf("  %12.3f %9.2f", Boards[b].WorstError, Boards[b].TrimPpm);
+        if (now > settle)
+        {
+          worstSettled = fmax(worstSettled, Boards[b].WorstError);
+        }
+        Boards[b].WorstError = 0.0;
+      }
+      printf("\n");
+    }
+  }
+
+  printf("worst error after %.0f s: %.3f frames (limit %.1f)", settle, worstSettled, limit);
+  for (b = 1U; b < NumBoards; b++)
+  {
+    printf(", board %u: %u steps %u rejected", b, Boards[b].Sync.Steps, Boards[b].Sync.Rejected);
+  }
+  printf("\n");
+  return (worstSettled <= limit) ? 0 : 1;
+}
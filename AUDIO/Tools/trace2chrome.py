@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Converts an audio_trace capture into Chrome trace JSON for Perfetto.
+
+Two inputs are understood:
+- a drain capture: the records TRACE_Drain() sent, back to back (the
+  payload of ITM stimulus port 1 as saved by the SWO viewer, or a UART
+  log);
+- a RAM dump of TraceRing, e.g. from gdb:
+      dump binary value trace.bin TraceRing
+  recognized by its "TRC1" magic. It also carries the core clock.
+
+Everything runs on one CPU track, so preemption shows up as nesting. DMA,
+USB, SD and marker events are instants on the same track. With --summary,
+per-handler durations and period jitter are printed as well, which is the
+quickest way to spot a handler running late or too long.
+
+Open the output in https://ui.perfetto.dev or chrome://tracing.
+
+Usage:
+    trace2chrome.py trace.bin -o trace.json [--mhz 100] [--summary]
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x31435254
+RECORD = struct.Struct('<IIHH')
+HEADER = struct.Struct('<IIIIII')
+
+# Keep in sync with TRACE_EventTypeDef in audio_trace.h
+ISR_ENTER, ISR_EXIT, PENDSV, NODE_BEGIN, NODE_END, DMA_HALF, DMA_CPLT, USB, SD, MARK = range(1, 11)
+
+# Exception numbers of the STM32F412 (16 + IRQn)
+EXCEPTIONS = {
+    2: 'NMI', 3: 'HardFault', 4: 'MemManage', 5: 'BusFault', 6: 'UsageFault',
+    11: 'SVCall', 12: 'DebugMon', 14: 'PendSV', 15: 'SysTick',
+    22: 'EXTI0', 23: 'EXTI1', 24: 'EXTI2', 25: 'EXTI3', 26: 'EXTI4',
+    34: 'ADC', 39: 'EXTI9_5', 44: 'TIM2', 45: 'TIM3', 46: 'TIM4',
+    51: 'SPI1', 52: 'SPI2', 53: 'USART1', 54: 'USART2', 56: 'EXTI15_10',
+    65: 'SDIO', 67: 'SPI3', 83: 'OTG_FS', 111: 'FMPI2C1_EV',
+}
+for _s in range(7):
+    EXCEPTIONS[27 + _s] = 'DMA1_Stream%d' % _s
+EXCEPTIONS[63] = 'DMA1_Stream7'
+for _s in range(5):
+    EXCEPTIONS[72 + _s] = 'DMA2_Stream%d' % _s
+for _s in range(3):
+    EXCEPTIONS[84 + _s] = 'DMA2_Stream%d' % (5 + _s)
+
+
+def exception_name(number):
+    return EXCEPTIONS.get(number, 'IRQ%d' % (number - 16))
+
+
+def parse(data):
+    """Returns (records sorted by sequence, core clock or None)."""
+    if len(data) >= HEADER.size and struct.unpack_from('<I', data)[0] == MAGIC:
+        _, size, clock, head, _, _ = HEADER.unpack_from(data)
+        records = []
+        for i in range(size):
+            off = HEADER.size + i * RECORD.size
+            if off + RECORD.size > len(data):
+                break
+            rec = RECORD.unpack_from(data, off)
+            # Committed and within the last lap only
+            if rec[0] != 0 and 0 <= (head - rec[0]) % (1 << 32) < size:
+                records.append(rec)
+        records.sort(key=lambda r: (r[0] - head - 1) % (1 << 32))
+        return records, clock or None
+    usable = len(data) - len(data) % RECORD.size
+    return [RECORD.unpack_from(data, off) for off in range(0, usable, RECORD.size)], None
+
+
+def convert(records, mhz):
+    events = []
+    stack = []
+    stats = {}
+    cycles = None
+    last_raw = 0
+    last_seq = None
+    for seq, raw, event, arg in records:
+        if last_seq is not None and seq != (last_seq + 1) % (1 << 32):
+            gap = (seq - last_seq - 1) % (1 << 32)
+            events.append({'name': 'lost %d records' % gap, 'ph': 'i', 's': 'g',
+                           'ts': cycles / mhz if cycles is not None else 0, 'pid': 1, 'tid': 1})
+        last_seq = seq
+        # Unwrap the 32-bit counter; TRACE_Record keeps slot order in time order
+        if cycles is None:
+            cycles = 0
+        else:
+            delta = (raw - last_raw) % (1 << 32)
+            cycles += delta - (1 << 32) if delta >= (1 << 31) else delta
+        last_raw = raw
+        ts = cycles / mhz
+
+        if event in (ISR_ENTER, NODE_BEGIN):
+            name = exception_name(arg) if event == ISR_ENTER else 'node %d' % arg
+            stack.append((name, ts))
+            events.append({'name': name, 'ph': 'B', 'ts': ts, 'pid': 1, 'tid': 1,
+                           'cat': 'isr' if event == ISR_ENTER else 'node'})
+        elif event in (ISR_EXIT, NODE_END):
+            name = exception_name(arg) if event == ISR_EXIT else 'node %d' % arg
+            # A capture starting inside a handler has exits without entries
+            if stack and stack[-1][0] == name:
+                _, start = stack.pop()
+                events.append({'name': name, 'ph': 'E', 'ts': ts, 'pid': 1, 'tid': 1})
+                stats.setdefault(name, []).append((start, ts - start))
+        else:
+            names = {PENDSV: 'PendSV job %d', DMA_HALF: 'DMA half 0x%03x',
+                     DMA_CPLT: 'DMA complete 0x%03x', USB: 'USB 0x%04x', SD: 'SD 0x%04x',
+                     MARK: 'mark %d'}
+            name = names.get(event, 'event %d/%%d' % event) % arg
+            events.append({'name': name, 'ph': 'i', 's': 't', 'ts': ts, 'pid': 1, 'tid': 1})
+
+    events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 1, 'args': {'name': 'CPU'}})
+    return {'traceEvents': events, 'displayTimeUnit': 'ns'}, stats
+
+
+def summary(stats, out):
+    out.write('%-16s %7s %9s %9s %9s %11s\n' % ('handler', 'count', 'min us', 'avg us', 'max us', 'jitter us'))
+    for name in sorted(stats):
+        runs = stats[name]
+        durations = [d for _, d in runs]
+        periods = [b[0] - a[0] for a, b in zip(runs, runs[1:])]
+        jitter = (max(periods) - min(periods)) if periods else 0.0
+        out.write('%-16s %7d %9.2f %9.2f %9.2f %11.2f\n' % (
+            name, len(runs), min(durations), sum(durations) / len(durations), max(durations), jitter))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('input', help='drain capture or TraceRing RAM dump')
+    parser.add_argument('-o', '--output', required=True, help='Chrome trace JSON')
+    parser.add_argument('--mhz', type=float, help='core clock in MHz (default: from the dump, else 100)')
+    parser.add_argument('--summary', action='store_true', help='print per-handler timing statistics')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        records, clock = parse(f.read())
+    if not records:
+        sys.exit('%s: no trace records' % args.input)
+    mhz = args.mhz or (clock / 1e6 if clock else 100.0)
+
+    trace, stats = convert(records, mhz)
+    with open(args.output, 'w') as f:
+        json.dump(trace, f)
+    print('%s: %d records, %.3f ms at %g MHz' % (
+        args.output, len(records), (trace['traceEvents'][-2]['ts'] if len(trace['traceEvents']) > 1 else 0) / 1000.0, mhz))
+    if args.summary:
+        summary(stats, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
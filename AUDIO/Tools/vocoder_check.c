@@ -0,0 +1,362 @@
+/**
+  ******************************************************************************
+  * @file    vocoder_check.c
+  * @brief   Host check of the audio_biquad.c sections and of the
+  *          audio_vocoder.c band-pass bank.
+  *
+  *          Sections, against a direct form I recursion in double precision,
+  *          over random stable sections and random input:
+  *            - BIQUAD_Process() and BIQUAD_CascadeProcess();
+  *            - BIQUAD_ProcessPair() on two lanes with different sections,
+  *              in calls of uneven length.
+  *          Bank, a sine through both sections of each band measured after
+  *          it settles:
+  *            - the gain at the band center is 0 dB;
+  *            - the gain at the geometric midpoint between two centers, where
+  *              neighbours cross, is that of the coefficients evaluated in
+  *              double precision, and -6 dB (-3 dB per section) within the
+  *              crossing limit.
+  *          Vocoder, carrier and modulator sines on band centers:
+  *            - a carrier on the modulator's band comes through at least the
+  *              selectivity limit above one two bands and an octave away;
+  *            - the output dies away once the modulator goes silent.
+  *
+  *          Build (from AUDIO/Tools):
+  *            gcc -O2 -std=gnu11 -I../Core/Inc -o vocoder_check vocoder_check.c \
+  *                ../Core/Src/audio_biquad.c ../Core/Src/audio_vocoder.c -lm
+  *
+  *          Usage:
+  *            vocoder_check [-b bands] [-c crossing limit dB]
+  *                          [-s selectivity limit dB]
+  *
+  *          Defaults: 16 bands from 100 Hz to 8 kHz, crossing within 0.5 dB,
+  *          selectivity 25 dB. The exit status is 1 if a section output is
+  *          off by more than 1e-5 of its peak, a band gain by more than
+  *          0.05 dB from its double reference, or a limit is missed.
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "audio_vocoder.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CHECK_FRAMES              24000U  /* 500 ms */
+#define CHECK_SECTIONS            4U
+#define CHECK_LOW_HZ              100.0f
+#define CHECK_HIGH_HZ             8000.0f
+#define CHECK_TOLERANCE           1e-5
+#define CHECK_GAIN_TOLERANCE      0.05    /* dB */
+
+/* Private variables ---------------------------------------------------------*/
+static VOCODER_HandleTypeDef Vocoder;
+static float In[2][CHECK_FRAMES];
+static float Out[2][CHECK_FRAMES];
+static float Carrier[CHECK_FRAMES];
+static float Modulator[CHECK_FRAMES];
+
+/* Private functions ---------------------------------------------------------*/
+static double CHECK_Random(void)
+{
+  return (double)(rand() % 20001 - 10000) / 10000.0;
+}
+
+/* A stable section: poles and zeros at random radii below 1 */
+static void CHECK_RandomSection(BIQUAD_CoeffsTypeDef *pCoeffs)
+{
+  double rp = 0.5 + 0.49 * fabs(CHECK_Random());
+  double rz = fabs(CHECK_Random());
+  double wp = M_PI * fabs(CHECK_Random());
+  double wz = M_PI * fabs(CHECK_Random());
+
+  pCoeffs->b0 = 0.5f;
+  pCoeffs->b1 = (float)(-rz * cos(wz));
+  pCoeffs->b2 = (float)(0.5 * rz * rz);
+  pCoeffs->a1 = (float)(-2.0 * rp * cos(wp));
+  pCoeffs->a2 = (float)(rp * rp);
+}
+
+/* Direct form I over Frames of pIn through Stages sections, in double */
+static void CHECK_Reference(const BIQUAD_CoeffsTypeDef *pCoeffs, uint32_t Stages, const float *pIn,
+                            double *pOut, uint32_t Frames)
+{
+  uint32_t s;
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    pOut[i] = pIn[i];
+  }
+  for (s = 0U; s < Stages; s++)
+  {
+    const BIQUAD_CoeffsTypeDef *c = &pCoeffs[s];
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+    for (i = 0U; i < Frames; i++)
+    {
+      double x = pOut[i];
+      double y = c->b0 * x + c->b1 * x1 + c->b2 * x2 - c->a1 * y1 - c->a2 * y2;
+
+      x2 = x1;
+      x1 = x;
+      y2 = y1;
+      y1 = y;
+      pOut[i] = y;
+    }
+  }
+}
+
+/* Worst error relative to the peak of the reference */
+static double CHECK_Worst(const float *pGot, const double *pWant, uint32_t Frames)
+{
+  double worst = 0.0;
+  double peak = 1e-12;
+  uint32_t i;
+
+  for (i = 0U; i < Frames; i++)
+  {
+    worst = AUDIO_MAX(worst, fabs(pGot[i] - pWant[i]));
+    peak  = AUDIO_MAX(peak, fabs(pWant[i]));
+  }
+  return worst / peak;
+}
+
+static double CHECK_Sections(void)
+{
+  static const uint32_t calls[] = { 1U, 7U, 64U, 333U };
+  static double want[2][CHECK_FRAMES];
+  BIQUAD_CoeffsTypeDef coeffs[2][CHECK_SECTIONS];
+  BIQUAD_StateTypeDef state[2][CHECK_SECTIONS];
+  BIQUAD_CascadeTypeDef cascade;
+  double worst = 0.0;
+  uint32_t lane;
+  uint32_t c;
+  uint32_t i;
+
+  for (lane = 0U; lane < 2U; lane++)
+  {
+    for (i = 0U; i < CHECK_SECTIONS; i++)
+    {
+      CHECK_RandomSection(&coeffs[lane][i]);
+    }
+    for (i = 0U; i < CHECK_FRAMES; i++)
+    {
+      In[lane][i] = (float)CHECK_Random();
+    }
+    CHECK_Reference(coeffs[lane], CHECK_SECTIONS, In[lane], want[lane], CHECK_FRAMES);
+  }
+
+  /* Cascade in place, one call */
+  BIQUAD_CascadeInit(&cascade, coeffs[0], state[0], CHECK_SECTIONS);
+  memcpy(Out[0], In[0], sizeof(Out[0]));
+  BIQUAD_CascadeProcess(&cascade, Out[0], Out[0], CHECK_FRAMES);
+  worst = AUDIO_MAX(worst, CHECK_Worst(Out[0], want[0], CHECK_FRAMES));
+
+  /* Paired lanes, section by section, in uneven calls */
+  for (c = 0U; c < sizeof(calls) / sizeof(calls[0]); c++)
+  {
+    uint32_t done = 0U;
+
+    memset(state, 0, sizeof(state));
+    memcpy(Out, In, sizeof(Out));
+    while (done < CHECK_FRAMES)
+    {
+      uint32_t n = AUDIO_MIN(calls[c], CHECK_FRAMES - done);
+
+      for (i = 0U; i < CHECK_SECTIONS; i++)
+      {
+        BIQUAD_ProcessPair(&coeffs[0][i], &state[0][i], &Out[0][done], &Out[0][done],
+                           &coeffs[1][i], &state[1][i], &Out[1][done], &Out[1][done], n);
+      }
+      done += n;
+    }
+    for (lane = 0U; lane < 2U; lane++)
+    {
+      worst = AUDIO_MAX(worst, CHECK_Worst(Out[lane], want[lane], CHECK_FRAMES));
+    }
+  }
+  return worst;
+}
+
+/* Gain in dB of the coefficients at Hz, in double */
+static double CHECK_Response(const BIQUAD_CoeffsTypeDef *pCoeffs, uint32_t Stages, double Hz)
+{
+  double w = 2.0 * M_PI * Hz / (double)AUDIO_SAMPLE_RATE;
+  double db = 0.0;
+  uint32_t s;
+
+  for (s = 0U; s < Stages; s++)
+  {
+    const BIQUAD_CoeffsTypeDef *c = &pCoeffs[s];
+    double nr = c->b0 + c->b1 * cos(w) + c->b2 * cos(2.0 * w);
+    double ni = -c->b1 * sin(w) - c->b2 * sin(2.0 * w);
+    double dr = 1.0 + c->a1 * cos(w) + c->a2 * cos(2.0 * w);
+    double di = -c->a1 * sin(w) - c->a2 * sin(2.0 * w);
+
+    db += 10.0 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+  }
+  return db;
+}
+
+/* Level in dB of pBuf over its last half, as the peak of a sine of that power */
+static double CHECK_Level(const float *pBuf, uint32_t Frames)
+{
+  double power = 0.0;
+  uint32_t i;
+
+  for (i = Frames / 2U; i < Frames; i++)
+  {
+    power += (double)pBuf[i] * (double)pBuf[i];
+  }
+  return 10.0 * log10(AUDIO_MAX(4.0 * power / (double)Frames, 1e-24));
+}
+
+static void CHECK_Sine(float *pBuf, double Hz, double Amplitude)
+{
+  uint32_t i;
+
+  for (i = 0U; i < CHECK_FRAMES; i++)
+  {
+    pBuf[i] = (float)(Amplitude * sin(2.0 * M_PI * Hz * (double)i / (double)AUDIO_SAMPLE_RATE));
+  }
+}
+
+/* Measured gain in dB of band b at Hz, a sine through a fresh cascade */
+static double CHECK_BandGain(uint32_t Band, double Hz)
+{
+  BIQUAD_StateTypeDef state[VOCODER_STAGES];
+  BIQUAD_CascadeTypeDef cascade;
+
+  CHECK_Sine(Out[0], Hz, 1.0);
+  BIQUAD_CascadeInit(&cascade, Vocoder.Coeffs[Band], state, VOCODER_STAGES);
+  BIQUAD_CascadeProcess(&cascade, Out[0], Out[0], CHECK_FRAMES);
+  return CHECK_Level(Out[0], CHECK_FRAMES);
+}
+
+static int CHECK_Bank(uint32_t Bands, double Crossing)
+{
+  double octaves = log2((double)CHECK_HIGH_HZ / (double)CHECK_LOW_HZ) / (double)(Bands - 1U);
+  double center = 0.0;
+  double model = 0.0;
+  double cross = 0.0;
+  uint32_t b;
+
+  for (b = 0U; b < Bands; b++)
+  {
+    double fc = (double)CHECK_LOW_HZ * exp2(octaves * (double)b);
+    double fx = fc * exp2(0.5 * octaves);
+    double g;
+
+    /* 0 dB at the center: a peak within the measurement ripple */
+    g = CHECK_BandGain(b, fc);
+    center = AUDIO_MAX(center, fabs(g));
+    if (b + 1U < Bands)
+    {
+      g = CHECK_BandGain(b, fx);
+      model = AUDIO_MAX(model, fabs(g - CHECK_Response(Vocoder.Coeffs[b], VOCODER_STAGES, fx)));
+      cross = AUDIO_MAX(cross, fabs(g + 6.0));
+    }
+  }
+  printf("bank: %u bands, center off by %.3f dB, crossing off its coefficients by %.3f dB "
+         "and -6 dB by %.2f dB, limit %.2f\n", Bands, center, model, cross, Crossing);
+  return (center > CHECK_GAIN_TOLERANCE) || (model > CHECK_GAIN_TOLERANCE) || (cross > Crossing);
+}
+
+/* Output peak in dB, carrier on band Car and modulator on band Mod */
+static double CHECK_Vocode(uint32_t Bands, uint32_t Car, uint32_t Mod)
+{
+  double octaves = log2((double)CHECK_HIGH_HZ / (double)CHECK_LOW_HZ) / (double)(Bands - 1U);
+
+  (void)VOCODER_Init(&Vocoder, Bands, CHECK_LOW_HZ, CHECK_HIGH_HZ);
+  CHECK_Sine(Carrier, (double)CHECK_LOW_HZ * exp2(octaves * (double)Car), 0.5);
+  CHECK_Sine(Modulator, (double)CHECK_LOW_HZ * exp2(octaves * (double)Mod), 0.5);
+  VOCODER_Process(&Vocoder, Carrier, Modulator, Out[0], CHECK_FRAMES);
+  return CHECK_Level(Out[0], CHECK_FRAMES);
+}
+
+static int CHECK_Selectivity(uint32_t Bands, double Limit)
+{
+  double octaves = log2((double)CHECK_HIGH_HZ / (double)CHECK_LOW_HZ) / (double)(Bands - 1U);
+  uint32_t away = AUDIO_MAX(2U, (uint32_t)ceil(1.0 / octaves - 1e-9));
+  double margin = HUGE_VAL;
+  double tail;
+  uint32_t car;
+  uint32_t mod;
+
+  /* The nearest carriers two bands and an octave off, on either side */
+  for (mod = 0U; mod < Bands; mod++)
+  {
+    double on = CHECK_Vocode(Bands, mod, mod);
+
+    if (mod >= away)
+    {
+      margin = AUDIO_MIN(margin, on - CHECK_Vocode(Bands, mod - away, mod));
+    }
+    if (mod + away < Bands)
+    {
+      margin = AUDIO_MIN(margin, on - CHECK_Vocode(Bands, mod + away, mod));
+    }
+  }
+
+  /* Silent modulator: 1 s of release leaves nothing */
+  (void)CHECK_Vocode(Bands, Bands / 2U, Bands / 2U);
+  memset(Modulator, 0, sizeof(Modulator));
+  for (car = 0U; car < AUDIO_SAMPLE_RATE / CHECK_FRAMES; car++)
+  {
+    VOCODER_Process(&Vocoder, Carrier, Modulator, Out[0], CHECK_FRAMES);
+  }
+  tail = CHECK_Level(Out[0], CHECK_FRAMES);
+
+  printf("vocoder: on-band over 2 bands and an octave away by %.1f dB at least, limit %.1f; "
+         "%.0f dB after 1 s of silence\n", margin, Limit, tail);
+  return (margin < Limit) || (tail > -90.0);
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  uint32_t bands = 16U;
+  double crossing = 0.5;
+  double selectivity = 25.0;
+  double sections;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:c:s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'b': bands = (uint32_t)atoi(optarg); break;
+      case 'c': crossing = atof(optarg); break;
+      case 's': selectivity = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: vocoder_check [-b bands] [-c dB] [-s dB]\n");
+        return 2;
+    }
+  }
+  if (VOCODER_Init(&Vocoder, bands, CHECK_LOW_HZ, CHECK_HIGH_HZ) != AUDIO_OK)
+  {
+    fprintf(stderr, "vocoder_check: bad band count\n");
+    return 2;
+  }
+
+  srand(1U);
+  sections = CHECK_Sections();
+  printf("sections: worst error %.2e over cascades and paired lanes, limit %.0e\n", sections,
+         CHECK_TOLERANCE);
+  failed |= (sections > CHECK_TOLERANCE);
+  failed |= CHECK_Bank(bands, crossing);
+  failed |= CHECK_Selectivity(bands, selectivity);
+  return failed;
+}